@@ -15,6 +15,14 @@
 
 #define QUEUE_CAPACITY 30
 
+// Build with -D KANGAROO_PACKET_SERIAL to drive Kangaroos in packet serial
+// mode (binary, CRC-checked) instead of simplified serial text; the
+// Kangaroo must be set to packet serial in DEScribe. Each Kangaroo event
+// is encoded once when its script loads.
+#ifndef KANGAROO_ADDRESS
+#define KANGAROO_ADDRESS 128
+#endif
+
 typedef struct
 {
     int domeLimit;
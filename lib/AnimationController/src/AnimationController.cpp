@@ -11,6 +11,18 @@ static const char *TAG = "AnimationController";
 
 AnimationController AnimationCtrl;
 
+/// @brief In packet serial mode, encodes a Kangaroo event's packet so
+/// dispatch sends it without formatting anything.
+static void encodeKangarooPacket(AnimationCommand &event)
+{
+#ifdef KANGAROO_PACKET_SERIAL
+    if (event.commandType == MODULE_TYPE::KANGAROO && !event.EncodeKangarooPacket(KANGAROO_ADDRESS))
+    {
+        ESP_LOGW(TAG, "Kangaroo command not encodable, sending as text: %s", event.commandTemplate.c_str());
+    }
+#endif
+}
+
 AnimationController::AnimationController()
 {
     this->animationMutex = xSemaphoreCreateMutex();
@@ -88,6 +100,7 @@ bool AnimationController::queueCommand(std::string command)
     }
 
     AnimationCommand cmd = AnimationCommand(command);
+    encodeKangarooPacket(cmd);
     this->scriptEvents.push_back(cmd);
     this->scriptLoaded.store(true);
     this->delayTillNextEvent.store(0);
@@ -124,9 +137,9 @@ void AnimationController::loadNextScript()
     ESP_LOGI(TAG, "Loading script %s", scriptId.c_str());
 
     std::string path = "scripts/" + scriptId;
-    std::string script = AstrOs_Storage.readFile(path);
+    std::string script;
 
-    if (script == "error")
+    if (!AstrOs_Storage.readFile(path, script).ok)
     {
         ESP_LOGI(TAG, "Script not loaded");
         this->scriptLoaded.store(false);
@@ -148,6 +161,10 @@ void AnimationController::loadNextScript()
     }
 
     this->scriptEvents = AstrOsAnimationEngine::parseAnimationScript(script);
+    for (auto &event : this->scriptEvents)
+    {
+        encodeKangarooPacket(event);
+    }
 
     ESP_LOGI(TAG, "Loaded: %s", script.c_str());
     ESP_LOGI(TAG, "Events loaded: %zu", this->scriptEvents.size());
@@ -1,4 +1,5 @@
 #include "AstrOsDisplay.hpp"
+#include <AstrOsPooledQueue.hpp>
 #include <AstrOsUtility.h>
 #include <esp_log.h>
 #include <string.h>
@@ -46,14 +47,14 @@ void AstrOsDisplayService::displayUpdate(std::string line1, std::string line2, s
     auto strValue = cmd.toString();
     queue_msg_t i2cMsg;
     i2cMsg.message_id = 1;
-    i2cMsg.data = (uint8_t *)malloc(strValue.length() + 1);
+    AstrOsBlockPool::Buffer payload(strValue.length() + 1);
+    i2cMsg.data = payload.data();
     memcpy(i2cMsg.data, strValue.c_str(), strValue.length());
     i2cMsg.data[strValue.length()] = '\0';
 
-    if (xQueueSend(AstrOsDisplayService::i2cQqueue, &i2cMsg, pdMS_TO_TICKS(100)) == pdFALSE)
+    if (!sendPooled(AstrOsDisplayService::i2cQqueue, i2cMsg, payload, pdMS_TO_TICKS(100)))
     {
         ESP_LOGE(TAG, "Failed to send display command to hardware queue");
-        free(i2cMsg.data);
     }
 }
 
@@ -66,14 +67,14 @@ void AstrOsDisplayService::displayClear()
     auto strValue = cmd.toString();
     queue_msg_t i2cMsg;
     i2cMsg.message_id = 1;
-    i2cMsg.data = (uint8_t *)malloc(strValue.length() + 1);
+    AstrOsBlockPool::Buffer payload(strValue.length() + 1);
+    i2cMsg.data = payload.data();
     memcpy(i2cMsg.data, strValue.c_str(), strValue.length());
     i2cMsg.data[strValue.length()] = '\0';
 
-    if (xQueueSend(AstrOsDisplayService::i2cQqueue, &i2cMsg, pdMS_TO_TICKS(100)) == pdFALSE)
+    if (!sendPooled(AstrOsDisplayService::i2cQqueue, i2cMsg, payload, pdMS_TO_TICKS(100)))
     {
         ESP_LOGE(TAG, "Failed to send display clear command to hardware queue");
-        free(i2cMsg.data);
     }
 }
 
@@ -1,6 +1,7 @@
 #include <AstrOsEspNowProtocol.hpp>
 #include <AstrOsEspNowService.hpp>
 #include <AstrOsMessaging.hpp>
+#include <AstrOsPooledQueue.hpp>
 #include <AstrOsUtility.h>
 #include <AstrOsUtility_ESP.h>
 #include <OtaForwarderQueueMessage.h>
@@ -564,6 +565,7 @@ bool AstrOsEspNow::routeOtaAckNakToForwarder(const uint8_t *src, const astros_pa
         m.kind = OTA_FWD_BEGIN_ACK;
         memcpy(m.begin_ack.srcMac, src, ESP_NOW_ETH_ALEN);
         m.begin_ack.xferId = rec.xferId;
+        m.begin_ack.resumeSeq = rec.resumeSeq;
         break;
     }
     case AstrOsPacketType::OTA_BEGIN_NAK:
@@ -710,6 +712,9 @@ bool AstrOsEspNow::routeOtaToWriter(const uint8_t *src, const astros_packet_t &p
         m.begin.totalChunks = rec.totalChunks;
         memcpy(m.begin.sha256Expected, rec.sha256Expected, sizeof(m.begin.sha256Expected));
         m.begin.flags = rec.flags;
+        m.begin.merkleDataSize = rec.merkleDataSize;
+        m.begin.merkleBlockLog2 = rec.merkleBlockLog2;
+        memcpy(m.begin.merkleRoot, rec.merkleRoot, sizeof(m.begin.merkleRoot));
         break;
     }
     case AstrOsPacketType::OTA_DATA:
@@ -801,7 +806,7 @@ void AstrOsEspNow::sendRegistrationRequest()
         cmd.cmd = SERVICE_COMMAND::ESPNOW_DISCOVERY_MODE_OFF;
         cmd.data = nullptr;
 
-        if (xQueueSend(this->serviceQueue, &cmd, 100) != pdTRUE)
+        if (!sendStamped(this->serviceQueue, cmd, 100))
         {
             ESP_LOGE(TAG, "Send service queue fail");
         }
@@ -960,7 +965,7 @@ bool AstrOsEspNow::sendRegistrationAck()
     cmd.cmd = SERVICE_COMMAND::ESPNOW_DISCOVERY_MODE_OFF;
     cmd.data = nullptr;
 
-    if (xQueueSend(this->serviceQueue, &cmd, 100) != pdTRUE)
+    if (!sendStamped(this->serviceQueue, cmd, 100))
     {
         ESP_LOGE(TAG, "Send service queue fail");
     }
@@ -1346,42 +1351,18 @@ void AstrOsEspNow::sendEspNowMessage(AstrOsPacketType type, std::string peer, st
 void AstrOsEspNow::sendToInterfaceQueue(AstrOsInterfaceResponseType responseType, std::string msgId,
                                         std::string peerMac, std::string peerName, std::string message)
 {
-    auto msgIdSize = msgId.size() + 1;
-    auto peerMacSize = peerMac.size() + 1;
-    auto peerNameSize = peerName.size() + 1;
-    auto messageSize = message.size() + 1;
+    AstrOsBlockPool::Buffer fields[4];
 
     astros_interface_response_t response;
     response.type = responseType;
-    response.originationMsgId = msgIdSize == 1 ? nullptr : (char *)malloc(msgIdSize);
-    response.peerMac = peerMacSize == 1 ? nullptr : (char *)malloc(peerMacSize);
-    response.peerName = peerNameSize == 1 ? nullptr : (char *)malloc(peerNameSize);
-    response.message = messageSize == 1 ? nullptr : (char *)malloc(messageSize);
+    response.originationMsgId = pooledString(fields[0], msgId);
+    response.peerMac = pooledString(fields[1], peerMac);
+    response.peerName = pooledString(fields[2], peerName);
+    response.message = pooledString(fields[3], message);
 
-    if (msgIdSize > 1)
-    {
-        memcpy(response.originationMsgId, msgId.c_str(), msgIdSize);
-    }
-    if (peerMacSize > 1)
-    {
-        memcpy(response.peerMac, peerMac.c_str(), peerMacSize);
-    }
-    if (peerNameSize > 1)
-    {
-        memcpy(response.peerName, peerName.c_str(), peerNameSize);
-    }
-    if (messageSize > 1)
-    {
-        memcpy(response.message, message.c_str(), messageSize);
-    }
-
-    if (xQueueSend(this->interfaceQueue, &response, pdTICKS_TO_MS(250)) == pdFALSE)
+    if (!sendPooled(this->interfaceQueue, response, fields, pdTICKS_TO_MS(250)))
     {
         ESP_LOGE(TAG, "Failed to send message to interface handler queue");
-        free(response.originationMsgId);
-        free(response.peerMac);
-        free(response.peerName);
-        free(response.message);
     }
 }
 
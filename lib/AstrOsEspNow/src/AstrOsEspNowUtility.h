@@ -41,6 +41,8 @@ extern "C"
         esp_now_send_status_t status;
         uint8_t *data;
         int data_len;
+        // low 32 bits of esp_timer_get_time() at send, see sendStamped()
+        uint32_t enqueuedUs;
     } queue_espnow_msg_t;
 
 #ifdef __cplusplus
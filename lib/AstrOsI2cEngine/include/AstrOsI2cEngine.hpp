@@ -0,0 +1,80 @@
+#pragma once
+
+// needed for QueueHandle_t, must be in this order
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <driver/i2c.h>
+#include <esp_err.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <AstrOsI2cBatch.hpp>
+
+// Runs on the engine task once the transaction a job went out in is done;
+// `err` is the bus result (ESP_ERR_TIMEOUT for a device that held the bus
+// too long, ESP_FAIL for a NACK).
+typedef void (*I2cDoneFn)(void *ctx, esp_err_t err);
+// A Call job: runs on the engine task, with the bus to itself.
+typedef void (*I2cCallFn)(void *ctx);
+
+// Owns the I2C bus. Callers submit writes and return at once; the engine
+// task groups them per device (AstrOsI2cBatch), merges contiguous register
+// writes into bursts, and completes each job through its callback. A slow
+// or absent device now costs the engine task its timeout instead of
+// holding i2cQueueTask (and the GPIO commands behind it) for up to 1 s, and
+// the light boards and the OLED take turns instead of queueing behind each
+// other.
+//
+//   void i2cEngineTask(void *arg)
+//   {
+//       I2cBus.run();
+//   }
+//
+// The bus clock is the one I2cMaster::Init sets (I2C_FREQ_HZ).
+class I2cEngine
+{
+public:
+    // Creates the submission queue; run() may start after this.
+    esp_err_t Init(i2c_port_t port);
+
+    // `size` bytes to `addr` as given. Copies `data`; false if the job
+    // could not be queued (`done` is then not called).
+    bool Write(uint8_t addr, const uint8_t *data, size_t size, I2cDoneFn done = nullptr, void *ctx = nullptr);
+    // `size` bytes starting at register `reg`. Only for devices that
+    // auto-increment their register pointer, as contiguous writes are
+    // merged into one burst.
+    bool WriteRegisters(uint8_t addr, uint8_t reg, const uint8_t *data, size_t size, I2cDoneFn done = nullptr,
+                        void *ctx = nullptr);
+    // Runs `fn` on the engine task in `addr`'s turn, for drivers that build
+    // their own transactions.
+    bool Call(uint8_t addr, I2cCallFn fn, void *ctx);
+
+    [[noreturn]] void run();
+
+private:
+    struct Job
+    {
+        uint8_t addr;
+        AstrOsI2cBatch::Kind kind;
+        uint8_t reg;
+        uint8_t len;
+        I2cDoneFn done;
+        I2cCallFn call;
+        void *ctx;
+        uint8_t data[]; // len bytes
+    };
+
+    bool submit(Job *job);
+    static AstrOsI2cBatch::Write batchWrite(Job *job);
+    void execute(const AstrOsI2cBatch::Transaction &t);
+
+    i2c_port_t port_ = I2C_NUM_0;
+    QueueHandle_t queue_ = nullptr;
+    AstrOsI2cBatch::WriteBatcher batcher_;
+    // Taken off the queue while the batcher was full.
+    Job *held_ = nullptr;
+};
+
+extern I2cEngine I2cBus;
@@ -0,0 +1,189 @@
+#include <AstrOsI2cEngine.hpp>
+
+#include <esp_log.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "I2cEngine";
+
+// Jobs waiting for the engine task.
+static const int QUEUE_LENGTH = 32;
+// Longest a submitter waits for room in the queue.
+static const int SUBMIT_TIMEOUT_MS = 10;
+// Per transaction. The longest, a 255-byte raw write, is about 23 ms at
+// 100 kHz.
+static const int TRANSACTION_TIMEOUT_MS = 50;
+
+I2cEngine I2cBus;
+
+esp_err_t I2cEngine::Init(i2c_port_t port)
+{
+    this->port_ = port;
+    this->queue_ = xQueueCreate(QUEUE_LENGTH, sizeof(Job *));
+    if (this->queue_ == NULL)
+    {
+        ESP_LOGE(TAG, "Failed to create the I2C job queue");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+bool I2cEngine::Write(uint8_t addr, const uint8_t *data, size_t size, I2cDoneFn done, void *ctx)
+{
+    if (size == 0 || size > UINT8_MAX)
+    {
+        ESP_LOGE(TAG, "Write to 0x%02x: %u bytes unsupported", addr, (unsigned int)size);
+        return false;
+    }
+
+    Job *job = (Job *)malloc(sizeof(Job) + size);
+    if (job == NULL)
+    {
+        ESP_LOGE(TAG, "Malloc I2C job fail");
+        return false;
+    }
+    *job = Job{addr, AstrOsI2cBatch::Kind::Raw, 0, (uint8_t)size, done, nullptr, ctx};
+    memcpy(job->data, data, size);
+
+    return this->submit(job);
+}
+
+bool I2cEngine::WriteRegisters(uint8_t addr, uint8_t reg, const uint8_t *data, size_t size, I2cDoneFn done,
+                               void *ctx)
+{
+    if (size == 0 || size > AstrOsI2cBatch::kMaxBurst)
+    {
+        ESP_LOGE(TAG, "Register write to 0x%02x: %u bytes unsupported", addr, (unsigned int)size);
+        return false;
+    }
+
+    Job *job = (Job *)malloc(sizeof(Job) + size);
+    if (job == NULL)
+    {
+        ESP_LOGE(TAG, "Malloc I2C job fail");
+        return false;
+    }
+    *job = Job{addr, AstrOsI2cBatch::Kind::Register, reg, (uint8_t)size, done, nullptr, ctx};
+    memcpy(job->data, data, size);
+
+    return this->submit(job);
+}
+
+bool I2cEngine::Call(uint8_t addr, I2cCallFn fn, void *ctx)
+{
+    Job *job = (Job *)malloc(sizeof(Job));
+    if (job == NULL)
+    {
+        ESP_LOGE(TAG, "Malloc I2C job fail");
+        return false;
+    }
+    *job = Job{addr, AstrOsI2cBatch::Kind::Call, 0, 0, nullptr, fn, ctx};
+
+    return this->submit(job);
+}
+
+bool I2cEngine::submit(Job *job)
+{
+    if (this->queue_ == NULL || xQueueSend(this->queue_, &job, pdMS_TO_TICKS(SUBMIT_TIMEOUT_MS)) != pdTRUE)
+    {
+        ESP_LOGW(TAG, "I2C job queue full, dropping job for 0x%02x", job->addr);
+        free(job);
+        return false;
+    }
+    return true;
+}
+
+AstrOsI2cBatch::Write I2cEngine::batchWrite(Job *job)
+{
+    return AstrOsI2cBatch::Write{job->addr, job->kind, job->reg, job->len, job};
+}
+
+void I2cEngine::run()
+{
+    Job *job = nullptr;
+    AstrOsI2cBatch::Transaction t;
+
+    while (true)
+    {
+        if (this->held_ != nullptr && this->batcher_.push(batchWrite(this->held_)))
+        {
+            this->held_ = nullptr;
+        }
+
+        // Take everything queued since the last transaction, so new writes
+        // merge with and take turns alongside the backlog. Block only when
+        // there is nothing left to do.
+        while (this->held_ == nullptr)
+        {
+            const TickType_t wait = this->batcher_.pending() == 0 ? portMAX_DELAY : 0;
+            if (xQueueReceive(this->queue_, &job, wait) != pdTRUE)
+            {
+                break;
+            }
+            if (!this->batcher_.push(batchWrite(job)))
+            {
+                this->held_ = job;
+            }
+        }
+
+        if (this->batcher_.next(t))
+        {
+            this->execute(t);
+        }
+    }
+}
+
+void I2cEngine::execute(const AstrOsI2cBatch::Transaction &t)
+{
+    Job *first = (Job *)t.tags[0];
+
+    if (t.kind == AstrOsI2cBatch::Kind::Call)
+    {
+        first->call(first->ctx);
+        free(first);
+        return;
+    }
+
+    // address, register, burst; or address and the raw bytes
+    uint8_t buf[2 + UINT8_MAX];
+    size_t size = 0;
+    buf[size++] = (t.addr << 1) | I2C_MASTER_WRITE;
+    if (t.kind == AstrOsI2cBatch::Kind::Register)
+    {
+        buf[size++] = t.reg;
+    }
+    for (size_t i = 0; i < t.count; i++)
+    {
+        const Job *job = (const Job *)t.tags[i];
+        memcpy(buf + size, job->data, job->len);
+        size += job->len;
+    }
+
+    // start, one write, stop
+    uint8_t link[I2C_LINK_RECOMMENDED_SIZE(1)];
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof(link));
+    i2c_master_start(cmd);
+    i2c_master_write(cmd, buf, size, true);
+    i2c_master_stop(cmd);
+    const esp_err_t err = i2c_master_cmd_begin(this->port_, cmd, pdMS_TO_TICKS(TRANSACTION_TIMEOUT_MS));
+    i2c_cmd_link_delete_static(cmd);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Write to 0x%02x failed: %s", t.addr, esp_err_to_name(err));
+    }
+    else if (t.count > 1)
+    {
+        ESP_LOGD(TAG, "%d writes to 0x%02x in one %d-byte burst", (int)t.count, t.addr, (int)t.len);
+    }
+
+    for (size_t i = 0; i < t.count; i++)
+    {
+        Job *job = (Job *)t.tags[i];
+        if (job->done != nullptr)
+        {
+            job->done(job->ctx, err);
+        }
+        free(job);
+    }
+}
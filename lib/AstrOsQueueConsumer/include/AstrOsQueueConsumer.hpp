@@ -0,0 +1,119 @@
+#pragma once
+
+// needed for QueueHandle_t, must be in this order
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <AstrOsQueueMetrics.hpp>
+
+// Handles one received item. `item` is the storage passed to bind(), which
+// now holds a copy of the message; the handler owns any pointers in it.
+typedef void (*QueueItemFn)(void *ctx, void *item);
+
+// The receive side of a FreeRTOS queue task. Instead of polling with
+// xQueueReceive(..., 0) and sleeping 10 ms, the task blocks until a message
+// arrives and then handles everything already queued before blocking again,
+// so a burst is handled in one wake and an idle task costs nothing.
+//
+//   static QueueConsumer gpioConsumer("gpio", &handleGpioMsg);
+//
+//   void gpioQueueTask(void *arg)
+//   {
+//       queue_msg_t msg;
+//       gpioConsumer.bind((QueueHandle_t)arg, &msg);
+//       gpioConsumer.run();
+//   }
+//
+// Consumers are meant to be file-scope statics so the maintenance timer
+// can log their metrics; construction touches no FreeRTOS state.
+class QueueConsumer
+{
+public:
+    QueueConsumer(const char *name, QueueItemFn fn, void *ctx = nullptr);
+
+    // `item` must be at least the queue's item size and outlive the consumer
+    // (a local in the never-returning task function is the usual choice).
+    // `enqueuedUs` points at the send stamp inside it (see sendStamped());
+    // the typed overload finds it from the message's enqueuedUs field.
+    void bind(QueueHandle_t queue, void *item, const uint32_t *enqueuedUs);
+    template <typename T>
+    void bind(QueueHandle_t queue, T *item)
+    {
+        bind(queue, item, &item->enqueuedUs);
+    }
+
+    // Blocks up to `timeout` for a message, then handles it and everything
+    // queued behind it. Returns the number handled (0 on timeout).
+    uint32_t waitAndDrain(TickType_t timeout);
+    // Loops waitAndDrain(portMAX_DELAY), checking the stack high-water
+    // mark after every wake.
+    [[noreturn]] void run();
+
+    const char *name() const
+    {
+        return name_;
+    }
+    QueueHandle_t queue() const
+    {
+        return queue_;
+    }
+    AstrOsQueueMetrics::ConsumerMetrics &metrics()
+    {
+        return metrics_;
+    }
+    // Debug level, one line per consumer that handled anything since the
+    // last call; resets the counters.
+    void logMetrics();
+
+private:
+    friend class QueueSetConsumer;
+
+    // Handles the item already in item_.
+    void handle();
+
+    const char *name_;
+    QueueItemFn fn_;
+    void *ctx_;
+    QueueHandle_t queue_ = nullptr;
+    void *item_ = nullptr;
+    const uint32_t *enqueuedUs_ = nullptr;
+    AstrOsQueueMetrics::ConsumerMetrics metrics_;
+};
+
+// One task blocking on several consumers' queues through a FreeRTOS queue
+// set. Every queued message puts its queue's handle in the set, so taking
+// exactly one item per selected handle keeps the two in step and handles
+// messages across all members in arrival order. Each member keeps its own
+// handler and metrics.
+class QueueSetConsumer
+{
+public:
+    explicit QueueSetConsumer(const char *name);
+
+    // Call once, after bind() on every member and before anything can be
+    // sent to them: FreeRTOS only adds empty queues to a set. `members` is
+    // copied; the consumers themselves must outlive this object.
+    bool init(QueueConsumer *const *members, size_t count);
+
+    uint32_t waitAndDrain(TickType_t timeout);
+    [[noreturn]] void run();
+
+    const char *name() const
+    {
+        return name_;
+    }
+
+private:
+    static constexpr size_t kMaxMembers = 4;
+
+    // Position in members_, or count_ if `handle` is not a member's queue.
+    size_t indexOf(QueueSetMemberHandle_t handle) const;
+
+    const char *name_;
+    QueueSetHandle_t set_ = nullptr;
+    QueueConsumer *members_[kMaxMembers] = {};
+    size_t count_ = 0;
+};
@@ -0,0 +1,187 @@
+#include "AstrOsQueueConsumer.hpp"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <inttypes.h>
+
+static const char *TAG = "QueueConsumer";
+
+namespace
+{
+    void checkStack(const char *name)
+    {
+        UBaseType_t hwm = uxTaskGetStackHighWaterMark(NULL);
+        if (hwm < 500)
+        {
+            ESP_LOGW(TAG, "%s consumer Stack HWM: %u", name, (unsigned int)hwm);
+        }
+    }
+} // namespace
+
+#pragma region QueueConsumer
+
+QueueConsumer::QueueConsumer(const char *name, QueueItemFn fn, void *ctx) : name_(name), fn_(fn), ctx_(ctx) {}
+
+void QueueConsumer::bind(QueueHandle_t queue, void *item, const uint32_t *enqueuedUs)
+{
+    queue_ = queue;
+    item_ = item;
+    enqueuedUs_ = enqueuedUs;
+}
+
+uint32_t QueueConsumer::waitAndDrain(TickType_t timeout)
+{
+    if (xQueueReceive(queue_, item_, timeout) != pdTRUE)
+    {
+        return 0;
+    }
+
+    uint32_t handled = 0;
+    do
+    {
+        handle();
+        handled++;
+    } while (xQueueReceive(queue_, item_, 0) == pdTRUE);
+
+    metrics_.onWake(handled);
+    return handled;
+}
+
+void QueueConsumer::run()
+{
+    while (1)
+    {
+        waitAndDrain(portMAX_DELAY);
+        checkStack(name_);
+    }
+}
+
+void QueueConsumer::logMetrics()
+{
+    const AstrOsQueueMetrics::Snapshot s = metrics_.take();
+    if (s.messages == 0)
+    {
+        return;
+    }
+    ESP_LOGD(TAG,
+             "queue %-9s n=%" PRIu32 " wakes=%" PRIu32 " batch<=%" PRIu32 " depth<=%" PRIu32 " wait avg=%" PRIu32
+             "us max=%" PRIu32 "us service avg=%" PRIu32 "us max=%" PRIu32 "us",
+             name_, s.messages, s.wakes, s.maxBatch, s.maxDepth, s.avgWaitUs(), s.maxWaitUs, s.avgServiceUs(),
+             s.maxServiceUs);
+}
+
+void QueueConsumer::handle()
+{
+    // The item just received counts towards the depth it was waiting in.
+    const uint32_t depth = static_cast<uint32_t>(uxQueueMessagesWaiting(queue_)) + 1;
+
+    // Read the stamp before the handler runs; it may reuse the item. Both
+    // ends are the low 32 bits of the timer, so the difference survives
+    // the wrap.
+    const int64_t start = esp_timer_get_time();
+    const uint32_t waitUs = static_cast<uint32_t>(start) - *enqueuedUs_;
+    fn_(ctx_, item_);
+    const int64_t end = esp_timer_get_time();
+
+    metrics_.onMessage(depth, waitUs, static_cast<uint32_t>(end - start));
+}
+
+#pragma endregion QueueConsumer
+#pragma region QueueSetConsumer
+
+QueueSetConsumer::QueueSetConsumer(const char *name) : name_(name) {}
+
+bool QueueSetConsumer::init(QueueConsumer *const *members, size_t count)
+{
+    if (set_ != nullptr || count == 0 || count > kMaxMembers)
+    {
+        ESP_LOGE(TAG, "%s: invalid queue set (%u members)", name_, (unsigned int)count);
+        return false;
+    }
+
+    // The set holds one handle per queued item, so it must be as long as
+    // its members combined.
+    UBaseType_t length = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (members[i] == nullptr || members[i]->queue_ == nullptr)
+        {
+            ESP_LOGE(TAG, "%s: member %u is not bound", name_, (unsigned int)i);
+            return false;
+        }
+        length += uxQueueMessagesWaiting(members[i]->queue_) + uxQueueSpacesAvailable(members[i]->queue_);
+    }
+
+    set_ = xQueueCreateSet(length);
+    if (set_ == nullptr)
+    {
+        ESP_LOGE(TAG, "%s: failed to create queue set", name_);
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (xQueueAddToSet(members[i]->queue_, set_) != pdPASS)
+        {
+            // Only fails when the queue already holds items.
+            ESP_LOGE(TAG, "%s: failed to add %s to queue set", name_, members[i]->name());
+            return false;
+        }
+        members_[i] = members[i];
+    }
+    count_ = count;
+    return true;
+}
+
+uint32_t QueueSetConsumer::waitAndDrain(TickType_t timeout)
+{
+    QueueSetMemberHandle_t ready = xQueueSelectFromSet(set_, timeout);
+    if (ready == nullptr)
+    {
+        return 0;
+    }
+
+    uint32_t batch[kMaxMembers] = {};
+    uint32_t handled = 0;
+    do
+    {
+        const size_t i = indexOf(ready);
+        if (i < count_ && xQueueReceive(members_[i]->queue_, members_[i]->item_, 0) == pdTRUE)
+        {
+            members_[i]->handle();
+            batch[i]++;
+            handled++;
+        }
+        ready = xQueueSelectFromSet(set_, 0);
+    } while (ready != nullptr);
+
+    for (size_t i = 0; i < count_; i++)
+    {
+        members_[i]->metrics_.onWake(batch[i]);
+    }
+    return handled;
+}
+
+void QueueSetConsumer::run()
+{
+    while (1)
+    {
+        waitAndDrain(portMAX_DELAY);
+        checkStack(name_);
+    }
+}
+
+size_t QueueSetConsumer::indexOf(QueueSetMemberHandle_t handle) const
+{
+    for (size_t i = 0; i < count_; i++)
+    {
+        if (members_[i]->queue_ == handle)
+        {
+            return i;
+        }
+    }
+    return count_;
+}
+
+#pragma endregion QueueSetConsumer
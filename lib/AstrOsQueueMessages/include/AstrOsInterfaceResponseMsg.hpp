@@ -1,6 +1,7 @@
 #ifndef ASTROSSERVERRESPONSEMSG_H
 #define ASTROSSERVERRESPONSEMSG_H
 
+#include <stdint.h>
 #include <string>
 
 enum class AstrOsInterfaceResponseType
@@ -48,6 +49,8 @@ typedef struct
     char *peerMac;
     char *peerName;
     char *message;
+    // low 32 bits of esp_timer_get_time() at send, see sendStamped()
+    uint32_t enqueuedUs;
 } astros_interface_response_t;
 
 #endif
\ No newline at end of file
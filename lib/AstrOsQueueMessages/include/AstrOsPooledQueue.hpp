@@ -0,0 +1,75 @@
+#ifndef ASTROSPOOLEDQUEUE_HPP
+#define ASTROSPOOLEDQUEUE_HPP
+
+#include <AstrOsBlockPool.hpp>
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+#include <esp_timer.h>
+// needed for QueueHandle_t, must be in this order
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+// Stamps `msg.enqueuedUs` with the send time and queues it. Every message a
+// QueueConsumer receives goes through here (or sendPooled below), which is
+// what lets the consumer report how long it waited in the queue.
+template <typename T>
+inline bool sendStamped(QueueHandle_t queue, T &msg, TickType_t ticksToWait)
+{
+    msg.enqueuedUs = static_cast<uint32_t>(esp_timer_get_time());
+    return xQueueSend(queue, &msg, ticksToWait) == pdTRUE;
+}
+
+// Sends `msg`, whose data points into `payload`, and hands the block to the
+// consumer only if the send went through; the consumer then releases it
+// with QueuePool.release(). On failure `payload` still owns the block and
+// returns it to the pool when it goes out of scope. Every pooled payload
+// changes hands here, so no caller releases one itself.
+template <typename T>
+inline bool sendPooled(QueueHandle_t queue, T &msg, AstrOsBlockPool::Buffer &payload, TickType_t ticksToWait)
+{
+    if (!sendStamped(queue, msg, ticksToWait))
+    {
+        return false;
+    }
+    payload.release();
+    return true;
+}
+
+// Several payloads in one message (astros_interface_response_t's strings):
+// all of them change hands, or none do.
+template <typename T, size_t N>
+inline bool sendPooled(QueueHandle_t queue, T &msg, AstrOsBlockPool::Buffer (&payloads)[N], TickType_t ticksToWait)
+{
+    if (!sendStamped(queue, msg, ticksToWait))
+    {
+        return false;
+    }
+    for (AstrOsBlockPool::Buffer &payload : payloads)
+    {
+        payload.release();
+    }
+    return true;
+}
+
+// Copies `value` and its terminator into a block held by `payload`.
+// nullptr for an empty string, which is how the queue messages carry
+// "none", or if no memory was left.
+inline char *pooledString(AstrOsBlockPool::Buffer &payload, const std::string &value)
+{
+    if (value.empty())
+    {
+        return nullptr;
+    }
+    payload = AstrOsBlockPool::Buffer(value.size() + 1);
+    if (!payload)
+    {
+        return nullptr;
+    }
+    memcpy(payload.data(), value.c_str(), value.size() + 1);
+    return reinterpret_cast<char *>(payload.data());
+}
+
+#endif
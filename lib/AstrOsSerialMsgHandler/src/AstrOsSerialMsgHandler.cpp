@@ -1,6 +1,7 @@
 
 #include <AstrOsInterfaceResponseMsg.hpp>
 #include <AstrOsMessaging.hpp>
+#include <AstrOsPooledQueue.hpp>
 #include <AstrOsSerialMsgHandler.hpp>
 #include <AstrOsSerialProtocol.hpp>
 #include <AstrOsUtility.h>
@@ -111,42 +112,18 @@ void AstrOsSerialMsgHandler::handleMessage(std::string message)
 void AstrOsSerialMsgHandler::sendToInterfaceQueue(AstrOsInterfaceResponseType responseType, std::string msgId,
                                                   std::string peerMac, std::string peerName, std::string message)
 {
-    auto msgIdSize = msgId.size() + 1;
-    auto peerMacSize = peerMac.size() + 1;
-    auto peerNameSize = peerName.size() + 1;
-    auto messageSize = message.size() + 1;
+    AstrOsBlockPool::Buffer fields[4];
 
     astros_interface_response_t response;
     response.type = responseType;
-    response.originationMsgId = msgIdSize == 1 ? nullptr : (char *)malloc(msgIdSize);
-    response.peerMac = peerMacSize == 1 ? nullptr : (char *)malloc(peerMacSize);
-    response.peerName = peerNameSize == 1 ? nullptr : (char *)malloc(peerNameSize);
-    response.message = messageSize == 1 ? nullptr : (char *)malloc(messageSize);
+    response.originationMsgId = pooledString(fields[0], msgId);
+    response.peerMac = pooledString(fields[1], peerMac);
+    response.peerName = pooledString(fields[2], peerName);
+    response.message = pooledString(fields[3], message);
 
-    if (msgIdSize > 1)
-    {
-        memcpy(response.originationMsgId, msgId.c_str(), msgIdSize);
-    }
-    if (peerMacSize > 1)
-    {
-        memcpy(response.peerMac, peerMac.c_str(), peerMacSize);
-    }
-    if (peerNameSize > 1)
-    {
-        memcpy(response.peerName, peerName.c_str(), peerNameSize);
-    }
-    if (messageSize > 1)
-    {
-        memcpy(response.message, message.c_str(), messageSize);
-    }
-
-    if (xQueueSend(this->handlerQueue, &response, pdTICKS_TO_MS(250)) == pdFALSE)
+    if (!sendPooled(this->handlerQueue, response, fields, pdTICKS_TO_MS(250)))
     {
         ESP_LOGE(TAG, "Failed to send message to interface handler queue, type: %d", static_cast<int>(responseType));
-        free(response.originationMsgId);
-        free(response.peerMac);
-        free(response.peerName);
-        free(response.message);
     }
 }
 
@@ -160,15 +137,15 @@ void AstrOsSerialMsgHandler::sendRegistraionAck(std::string msgId, std::vector<a
 
     serialMsg.baudrate = 115200;
     serialMsg.message_id = 1;
-    serialMsg.data = (uint8_t *)malloc(response.size() + 1);
+    AstrOsBlockPool::Buffer payload(response.size() + 1);
+    serialMsg.data = payload.data();
     memcpy(serialMsg.data, response.c_str(), response.size());
     serialMsg.data[response.size()] = '\n';
     serialMsg.dataSize = response.size() + 1;
 
-    if (xQueueSend(serialQueue, &serialMsg, pdMS_TO_TICKS(500)) != pdTRUE)
+    if (!sendPooled(serialQueue, serialMsg, payload, pdMS_TO_TICKS(500)))
     {
         ESP_LOGW(TAG, "Send serial queue fail");
-        free(serialMsg.data);
     }
 }
 
@@ -193,15 +170,15 @@ bool AstrOsSerialMsgHandler::sendPollAckNak(std::string mac, std::string name, s
 
     serialMsg.baudrate = 115200;
     serialMsg.message_id = 1;
-    serialMsg.data = (uint8_t *)malloc(response.size() + 1);
+    AstrOsBlockPool::Buffer payload(response.size() + 1);
+    serialMsg.data = payload.data();
     memcpy(serialMsg.data, response.c_str(), response.size());
     serialMsg.data[response.size()] = '\n';
     serialMsg.dataSize = response.size() + 1;
 
-    if (xQueueSend(serialQueue, &serialMsg, pdMS_TO_TICKS(500)) != pdTRUE)
+    if (!sendPooled(serialQueue, serialMsg, payload, pdMS_TO_TICKS(500)))
     {
         ESP_LOGW(TAG, "Send serial queue fail");
-        free(serialMsg.data);
         return false;
     }
     return true;
@@ -218,15 +195,15 @@ void AstrOsSerialMsgHandler::sendBasicAckNakResponse(AstrOsSerialMessageType typ
 
     serialMsg.baudrate = 115200;
     serialMsg.message_id = 1;
-    serialMsg.data = (uint8_t *)malloc(response.size() + 1);
+    AstrOsBlockPool::Buffer block(response.size() + 1);
+    serialMsg.data = block.data();
     memcpy(serialMsg.data, response.c_str(), response.size());
     serialMsg.data[response.size()] = '\n';
     serialMsg.dataSize = response.size() + 1;
 
-    if (xQueueSend(serialQueue, &serialMsg, pdMS_TO_TICKS(500)) != pdTRUE)
+    if (!sendPooled(serialQueue, serialMsg, block, pdMS_TO_TICKS(500)))
     {
         ESP_LOGW(TAG, "Send serial queue fail");
-        free(serialMsg.data);
     }
 }
 
@@ -246,15 +223,15 @@ void AstrOsSerialMsgHandler::sendFwTransferBeginAck(std::string msgId, std::stri
     queue_serial_msg_t serialMsg;
     serialMsg.baudrate = 115200;
     serialMsg.message_id = 1;
-    serialMsg.data = (uint8_t *)malloc(response.size() + 1);
+    AstrOsBlockPool::Buffer payload(response.size() + 1);
+    serialMsg.data = payload.data();
     memcpy(serialMsg.data, response.c_str(), response.size());
     serialMsg.data[response.size()] = '\n';
     serialMsg.dataSize = response.size() + 1;
 
-    if (xQueueSend(serialQueue, &serialMsg, pdMS_TO_TICKS(500)) != pdTRUE)
+    if (!sendPooled(serialQueue, serialMsg, payload, pdMS_TO_TICKS(500)))
     {
         ESP_LOGW(TAG, "Send serial queue fail (FW_TRANSFER_BEGIN_ACK)");
-        free(serialMsg.data);
     }
 }
 
@@ -273,15 +250,15 @@ void AstrOsSerialMsgHandler::sendFwChunkAck(std::string transferId, uint32_t hig
     queue_serial_msg_t serialMsg;
     serialMsg.baudrate = 115200;
     serialMsg.message_id = 1;
-    serialMsg.data = (uint8_t *)malloc(response.size() + 1);
+    AstrOsBlockPool::Buffer payload(response.size() + 1);
+    serialMsg.data = payload.data();
     memcpy(serialMsg.data, response.c_str(), response.size());
     serialMsg.data[response.size()] = '\n';
     serialMsg.dataSize = response.size() + 1;
 
-    if (xQueueSend(serialQueue, &serialMsg, pdMS_TO_TICKS(500)) != pdTRUE)
+    if (!sendPooled(serialQueue, serialMsg, payload, pdMS_TO_TICKS(500)))
     {
         ESP_LOGW(TAG, "Send serial queue fail (FW_CHUNK_ACK)");
-        free(serialMsg.data);
     }
 }
 
@@ -307,15 +284,15 @@ void AstrOsSerialMsgHandler::sendFwChunkNak(std::string transferId, uint32_t las
     queue_serial_msg_t serialMsg;
     serialMsg.baudrate = 115200;
     serialMsg.message_id = 1;
-    serialMsg.data = (uint8_t *)malloc(response.size() + 1);
+    AstrOsBlockPool::Buffer payload(response.size() + 1);
+    serialMsg.data = payload.data();
     memcpy(serialMsg.data, response.c_str(), response.size());
     serialMsg.data[response.size()] = '\n';
     serialMsg.dataSize = response.size() + 1;
 
-    if (xQueueSend(serialQueue, &serialMsg, pdMS_TO_TICKS(500)) != pdTRUE)
+    if (!sendPooled(serialQueue, serialMsg, payload, pdMS_TO_TICKS(500)))
     {
         ESP_LOGW(TAG, "Send serial queue fail (FW_CHUNK_NAK)");
-        free(serialMsg.data);
     }
 }
 
@@ -334,15 +311,15 @@ void AstrOsSerialMsgHandler::sendFwTransferEndAck(std::string msgId, std::string
     queue_serial_msg_t serialMsg;
     serialMsg.baudrate = 115200;
     serialMsg.message_id = 1;
-    serialMsg.data = (uint8_t *)malloc(response.size() + 1);
+    AstrOsBlockPool::Buffer payload(response.size() + 1);
+    serialMsg.data = payload.data();
     memcpy(serialMsg.data, response.c_str(), response.size());
     serialMsg.data[response.size()] = '\n';
     serialMsg.dataSize = response.size() + 1;
 
-    if (xQueueSend(serialQueue, &serialMsg, pdMS_TO_TICKS(500)) != pdTRUE)
+    if (!sendPooled(serialQueue, serialMsg, payload, pdMS_TO_TICKS(500)))
     {
         ESP_LOGW(TAG, "Send serial queue fail (FW_TRANSFER_END_ACK)");
-        free(serialMsg.data);
     }
 }
 
@@ -364,15 +341,15 @@ void AstrOsSerialMsgHandler::sendFwDeployDone(std::string msgId, std::string tra
     queue_serial_msg_t serialMsg;
     serialMsg.baudrate = 115200;
     serialMsg.message_id = 1;
-    serialMsg.data = (uint8_t *)malloc(response.size() + 1);
+    AstrOsBlockPool::Buffer payload(response.size() + 1);
+    serialMsg.data = payload.data();
     memcpy(serialMsg.data, response.c_str(), response.size());
     serialMsg.data[response.size()] = '\n';
     serialMsg.dataSize = response.size() + 1;
 
-    if (xQueueSend(serialQueue, &serialMsg, pdMS_TO_TICKS(500)) != pdTRUE)
+    if (!sendPooled(serialQueue, serialMsg, payload, pdMS_TO_TICKS(500)))
     {
         ESP_LOGW(TAG, "Send serial queue fail (FW_DEPLOY_DONE)");
-        free(serialMsg.data);
     }
 }
 
@@ -394,7 +371,8 @@ void AstrOsSerialMsgHandler::sendFwProgress(std::string transferId, std::string
     queue_serial_msg_t serialMsg;
     serialMsg.baudrate = 115200;
     serialMsg.message_id = 1;
-    serialMsg.data = (uint8_t *)malloc(response.size() + 1);
+    AstrOsBlockPool::Buffer payload(response.size() + 1);
+    serialMsg.data = payload.data();
     memcpy(serialMsg.data, response.c_str(), response.size());
     serialMsg.data[response.size()] = '\n';
     serialMsg.dataSize = response.size() + 1;
@@ -406,10 +384,9 @@ void AstrOsSerialMsgHandler::sendFwProgress(std::string transferId, std::string
     // when the serial queue backs up (serialCh1Queue length is 10, drained every
     // 10 ms by the Pi consumer). Other sendFw* methods keep their 500 ms timeout
     // because they carry contract messages.
-    if (xQueueSend(serialQueue, &serialMsg, 0) != pdTRUE)
+    if (!sendPooled(serialQueue, serialMsg, payload, 0))
     {
         ESP_LOGD(TAG, "FW_PROGRESS: serial queue full; dropping (best-effort heartbeat)");
-        free(serialMsg.data);
     }
 }
 
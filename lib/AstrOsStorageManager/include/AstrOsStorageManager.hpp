@@ -2,33 +2,184 @@
 #define ASTROSSTORAGEMANAGER_HPP
 
 #include <cstdint>
+#include <cstdio>
 #include <esp_err.h>
 #include <esp_log.h>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
 
+// needed for QueueHandle_t, must be in this order
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <AstrOsConfigCache.hpp>
 #include <AstrOsUtility.h>
+#include <AstrOsWriteBehind.hpp>
 #include <espnow_peer.h>
 
+#ifdef USE_SCRIPT_ARCHIVE
+#ifdef USE_SPIFFS
+#error "USE_SCRIPT_ARCHIVE needs the SD card backend (ftruncate / fsync on FATFS)"
+#endif
+#include <AstrOsScriptArchive.hpp>
+#endif
+
 class AstrOsStorageManager
 {
+public:
+    // File operations timed by the public wrappers, whichever backend serves them.
+    enum class StorageOp : uint8_t
+    {
+        SAVE = 0,
+        DELETE = 1,
+        EXISTS = 2,
+        READ = 3,
+        LIST = 4,
+        COUNT = 5
+    };
+
+    struct OpStats
+    {
+        uint32_t count = 0;
+        uint64_t totalUs = 0;
+        uint32_t maxUs = 0;
+    };
+
+    enum class ReadStatus : uint8_t
+    {
+        OK = 0,
+        INVALID_PATH = 1, // rejected by AstrOsPathUtils::isPathSafe
+        NOT_FOUND = 2,
+        NOT_MOUNTED = 3,
+        TOO_LARGE = 4, // bigger than the caller's buffer; bytes = the size needed
+        NO_MEM = 5,    // no heap block large enough for the whole file
+        IO_ERROR = 6   // open / stat / short read
+    };
+
+    struct [[nodiscard]] ReadResult
+    {
+        bool ok = false;
+        ReadStatus status = ReadStatus::IO_ERROR;
+        size_t bytes = 0;
+
+        static ReadResult success(size_t bytes)
+        {
+            return {true, ReadStatus::OK, bytes};
+        }
+        static ReadResult failed(ReadStatus s, size_t bytes = 0)
+        {
+            return {false, s, bytes};
+        }
+    };
+
+    // Sees every byte of a readFileBlocks() file once, in order.
+    using BlockFn = void (*)(void *ctx, const uint8_t *data, size_t len);
+
+    // One FATFS sector (CONFIG_FATFS_SECTOR_4096): with the stream
+    // unbuffered, every block read is whole sectors straight into the
+    // caller's memory.
+    static constexpr size_t kReadBlockSize = 4096;
+
+    static const char *readStatusName(ReadStatus s);
+
 private:
+    // SPIFFS has no directory tree: every stat / fopen walks the object
+    // index, so a few recent answers are kept. Keyed by full path; save and
+    // delete write through, so the cache never contradicts our own writes.
+    static constexpr size_t kStatCacheSize = 8;
+    struct StatCacheEntry
+    {
+        std::string path;
+        bool exists = false;
+        uint32_t lastUse = 0; // 0 = empty slot
+    };
+
+    // Guards the SPIFFS caches, the script archive, the config cache,
+    // writeQueue_ and opStats_.
+    mutable std::mutex mutex_;
+    // Serializes whole-file writes. storageWriterTask holds it for each
+    // queued save; saveFile, deleteFile and formatSdCard take it so they
+    // land after the save in flight and supersede any queued for their
+    // path. Taken before mutex_, never while holding it.
+    std::mutex writeMutex_;
+    AstrOsWriteBehind::WriteQueue writeQueue_;
+    // Wake-ups for storageWriterTask, one per newly queued path.
+    QueueHandle_t writeJobQueue_ = nullptr;
+    static constexpr size_t kWriteWakeQueueLength = 8;
+    OpStats opStats_[static_cast<size_t>(StorageOp::COUNT)];
+    bool spiffsMounted_ = false;
+    StatCacheEntry statCache_[kStatCacheSize];
+    uint32_t statCacheClock_ = 0;
+    // Last file read, left open and rewound on the next read of the same
+    // path — scripts are re-read every time they are queued.
+    std::string readHandlePath_;
+    FILE *readHandle_ = nullptr;
+    // Decoded CONFIG_CACHE_FILE, read on first use by the module config
+    // loaders. Loaded but null: no usable blob, so they parse the text
+    // files. saveModuleConfigs bumps configCacheGen_ so a read that raced
+    // it can't install the blob it replaced.
+    std::shared_ptr<const AstrOsConfigCache::Snapshot> configCache_;
+    bool configCacheLoaded_ = false;
+    uint32_t configCacheGen_ = 0;
+
     bool saveMaestroServos(std::vector<std::string> config);
     bool saveMaestroModules(std::vector<std::string> config);
     bool saveGpioConfig(std::string config);
+    std::shared_ptr<const AstrOsConfigCache::Snapshot> configCache();
+    std::shared_ptr<const AstrOsConfigCache::Snapshot> readConfigCacheFile();
+    void storeConfigCache(AstrOsConfigCache::Snapshot snapshot);
+    // Forgets the in-memory copy; `removeFile` also deletes the blob.
+    void dropConfigCache(bool removeFile);
     esp_err_t mountSdCard();
     std::string setFilePath(std::string filename);
+    // saveFile minus the write-behind bookkeeping; caller holds writeMutex_.
+    bool saveFileNow(const std::string &filename, const std::string &data);
     bool saveFileSd(std::string filename, std::string data);
     bool deleteFileSd(std::string filename);
     bool fileExistsSd(std::string filename);
-    std::string readFileSd(std::string filename);
+    // Where a whole-file read lands: `text` when set, else buf / cap.
+    struct ReadSink
+    {
+        std::string *text;
+        uint8_t *buf;
+        size_t cap;
+    };
+    static ReadResult readOpenFile(FILE *f, const ReadSink &sink);
+    static ReadResult readQueued(const std::string &data, const ReadSink &sink);
+    ReadResult readFileTimed(const std::string &filename, const ReadSink &sink);
+    ReadResult readFileSd(const std::string &filename, const ReadSink &sink);
     std::vector<std::string> listFilesSd(std::string folder);
     bool saveFileSpiffs(std::string filename, std::string data);
     bool deleteFileSpiffs(std::string filename);
     bool fileExistsSpiffs(std::string filename);
-    std::string readFileSpiffs(std::string filename);
+    ReadResult readFileSpiffs(const std::string &filename, const ReadSink &sink);
     std::vector<std::string> listFilesSpiffs(std::string folder);
+    esp_err_t mountSpiffs();
+    // Called with mutex_ held.
+    const StatCacheEntry *statCacheFind(const std::string &path);
+    void statCacheStore(const std::string &path, bool exists);
+    void statCacheForget(const std::string &path);
+    void closeReadHandle();
+    // Takes mutex_.
+    void recordOp(StorageOp op, int64_t startUs);
+#ifdef USE_SCRIPT_ARCHIVE
+    // scripts/<id> lives here instead of one FAT file per script. Loose
+    // files from before the archive are moved in when it opens; one that
+    // couldn't be is still read from scripts/.
+    AstrOsScriptArchive::Archive scriptArchive_;
+    void openScriptArchive();
+    // nullopt: not the archive's to answer (not scripts/<id>, archive not
+    // open, or — for reads and exists — a script it doesn't hold), so the
+    // caller goes on to the loose file. Take mutex_.
+    std::optional<bool> saveArchivedScript(const std::string &filename, const std::string &data);
+    std::optional<bool> deleteArchivedScript(const std::string &filename);
+    std::optional<bool> archivedScriptExists(const std::string &filename);
+    std::optional<ReadResult> readArchivedScript(const std::string &filename, const ReadSink &sink);
+    std::vector<std::string> listArchivedScripts();
+#endif
 
 public:
     AstrOsStorageManager();
@@ -45,7 +196,8 @@ public:
     bool saveModuleConfigs(std::string msg);
 
     std::vector<maestro_config> loadMaestroConfigs();
-    bool loadMaestroServos(int idx, servo_channel *servos, int arraySize);
+    // servos[i] is channel i, up to the highest channel configured.
+    bool loadMaestroServos(int idx, std::vector<servo_channel> &servos);
 
     std::vector<bool> loadGpioConfigs();
 
@@ -53,11 +205,42 @@ public:
     bool saveEspNowPeerConfigs(espnow_peer_t *config, int arraySize);
     int loadEspNowPeerConfigs(espnow_peer_t *config);
 
+    // Written to <file>.tmp, synced, then renamed over the old file.
     bool saveFile(std::string filename, std::string data);
     bool deleteFile(std::string filename);
     bool fileExists(std::string filename);
 
-    std::string readFile(std::string filename);
+    // Write-behind saves (see AstrOsWriteBehind). initWriteBehind creates
+    // the queue storageWriterTask drains; without it saveFileAsync declines.
+    bool initWriteBehind();
+    QueueHandle_t getWriteJobQueue() const
+    {
+        return writeJobQueue_;
+    }
+    // Queues a saveFile and returns at once; `done` runs on
+    // storageWriterTask when the file is durable, or when a later
+    // saveFile / deleteFile of the same file supersedes it (with that
+    // call's result). Reads see the queued content meanwhile. false: not
+    // queued (queue full, bad path, no writer) — call saveFile instead.
+    bool saveFileAsync(const std::string &filename, const std::string &data, AstrOsWriteBehind::DoneFn done,
+                       void *ctx, const std::string &token);
+    // storageWriterTask entry point: writes everything queued.
+    void processWriteJobs();
+    // Waits up to timeoutMs for queued saves to land; any still queued are
+    // dropped and answered with ok = false.
+    void flushWrites(uint32_t timeoutMs);
+    AstrOsWriteBehind::Stats writeBehindStats() const;
+
+    // Whole file in one pass: a single fstat sizes the destination, then
+    // one unbuffered fread fills it. Text: stops at the first NUL (files
+    // saved by older firmware end in one). Replaces `out` only on success.
+    ReadResult readFile(const std::string &filename, std::string &out);
+    // Binary, into caller memory; TOO_LARGE (nothing read) when it won't fit.
+    ReadResult readFile(const std::string &filename, uint8_t *buf, size_t cap);
+    // Streams an absolute VFS path (e.g. the OTA staging image, which sits
+    // outside the file namespace above) through fn in kReadBlockSize blocks
+    // from one heap buffer. bytes = bytes delivered, also on IO_ERROR.
+    ReadResult readFileBlocks(const char *path, BlockFn fn, void *ctx);
 
     std::vector<std::string> listFiles(std::string folder);
 
@@ -66,10 +249,20 @@ public:
     // nullopt distinguishes a probe failure (card unmounted, FATFS error)
     // from a legitimate 0-bytes-free reading.
     std::optional<uint64_t> freeSpaceSdBytes();
+
+    // Per-operation latency since boot (or the last reset).
+    OpStats opStats(StorageOp op) const;
+    void resetOpStats();
+    void logOpStats() const;
 #ifndef USE_SPIFFS
     // OTA-only: hard-codes /sdcard/firmware. Absent from SPIFFS builds so
     // callers fail to link rather than silently writing to the wrong volume.
     bool ensureSdFirmwareDir();
+    // Creates (or truncates) `path` and reserves `size` bytes for it as one
+    // contiguous cluster run, so sequential writes never walk or extend the
+    // FAT chain. False when FATFS can't find a run that long (fragmented
+    // card); the caller falls back to an ordinary growing file.
+    bool preallocateSdFile(const char *path, uint32_t size);
 #endif
 };
 
@@ -6,12 +6,22 @@
 #include <espnow_peer.h>
 
 #include <errno.h>
+#include <esp_heap_caps.h>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
 #include <nvs_flash.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
-
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <map>
+#include <memory>
+#include <new>
 #include <string>
 #include <vector>
 
@@ -43,6 +53,9 @@
 #define MAESTRO_MODULES_FILE "maestro/modules.cfg"
 #define CFIG_SUFFIX ".cfg"
 
+// Binary image of the three above; see AstrOsConfigCache.
+#define CONFIG_CACHE_FILE "modules.bin"
+
 static const char *TAG = "StorageManager";
 
 static sdmmc_card_t *card;
@@ -51,6 +64,76 @@ AstrOsStorageManager AstrOs_Storage;
 
 namespace
 {
+    constexpr const char *kReplaceSuffix = ".tmp";
+    // Queued saves that haven't landed after this long are dropped (and
+    // NAKed) ahead of a format.
+    constexpr uint32_t kFlushTimeoutMs = 5000;
+
+    bool endsWith(const std::string &s, const char *suffix)
+    {
+        const size_t n = strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    }
+
+    // Whole-file replace a power cut can't leave half-written: the content
+    // goes to <path>.tmp and is synced before the old file is unlinked and
+    // the temp renamed into place (neither FATFS nor SPIFFS renames onto an
+    // existing name). A crash before the unlink leaves the old file; in the
+    // gap after it, only the complete .tmp — see recoverReplacement().
+    bool replaceFile(const std::string &path, const char *data, size_t len)
+    {
+        const std::string tmp = path + kReplaceSuffix;
+
+        FILE *f = fopen(tmp.c_str(), "wb");
+        if (f == NULL)
+        {
+            ESP_LOGE(TAG, "Failed to create file : %s", tmp.c_str());
+            return false;
+        }
+        bool ok = fwrite(data, 1, len, f) == len && fflush(f) == 0 && fsync(fileno(f)) == 0;
+        ok = (fclose(f) == 0) && ok;
+        if (!ok || (unlink(path.c_str()) != 0 && errno != ENOENT))
+        {
+            ESP_LOGE(TAG, "Failed to write %s: errno=%d (%s)", tmp.c_str(), errno, strerror(errno));
+            unlink(tmp.c_str());
+            return false;
+        }
+        if (rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            // The old file is gone; keep the new one for recovery.
+            ESP_LOGE(TAG, "Failed to rename %s: errno=%d (%s)", tmp.c_str(), errno, strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    // Finishes a replaceFile() cut short between unlink and rename. SD card
+    // only: FATFS records a file's length only when it is synced, and
+    // replaceFile syncs once, after the last byte, so a .tmp with any
+    // length is complete. SPIFFS makes no such promise.
+    bool recoverReplacement(const std::string &path)
+    {
+        const std::string tmp = path + kReplaceSuffix;
+        struct stat st;
+        if (stat(tmp.c_str(), &st) != 0 || st.st_size == 0 || rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            errno = ENOENT;
+            return false;
+        }
+        ESP_LOGW(TAG, "Recovered %s from an interrupted save", path.c_str());
+        return true;
+    }
+
+    // readFileBlocks sink for the config cache; no blob is longer than
+    // kMaxEncodedSize, so a damaged file can't run the heap out.
+    void appendConfigBlock(void *ctx, const uint8_t *data, size_t len)
+    {
+        auto &blob = *static_cast<std::vector<uint8_t> *>(ctx);
+        const size_t cap = AstrOsConfigCache::kMaxEncodedSize + 1;
+        const size_t room = cap - std::min(blob.size(), cap);
+        blob.insert(blob.end(), data, data + std::min(len, room));
+    }
+
     // Boundary helper: delegates to the pure check and emits the
     // QA-documented ESP_LOGW line when the path is rejected. Keeps log
     // output bit-compatible with the pre-extraction implementation.
@@ -64,12 +147,237 @@ namespace
         }
         return true;
     }
+
+#ifdef USE_SCRIPT_ARCHIVE
+    // AstrOsScriptArchive::FileOps over stdio on the card. The data file
+    // stays open, so a script lookup is one fseek + fread with no FAT
+    // directory walk. Its appends are fsync'd: after a power cut the
+    // archive trusts the length in the directory entry, which FATFS only
+    // updates on sync. The compaction copy keeps a second handle for its
+    // run of appends and is synced when closed ahead of the rename.
+    // Only used under AstrOsStorageManager::mutex_.
+    struct ArchiveFiles
+    {
+        FILE *data = nullptr;
+        FILE *other = nullptr;
+        std::string otherName;
+
+        static std::string path(const char *name)
+        {
+            return std::string(MOUNT_POINT) + "/" + name;
+        }
+        static bool isData(const char *name)
+        {
+            return strcmp(name, AstrOsScriptArchive::kDataFile) == 0;
+        }
+        static ArchiveFiles &self(void *ctx)
+        {
+            return *static_cast<ArchiveFiles *>(ctx);
+        }
+
+        FILE *dataHandle()
+        {
+            if (data == nullptr)
+            {
+                const std::string p = path(AstrOsScriptArchive::kDataFile);
+                data = fopen(p.c_str(), "r+b");
+                if (data == nullptr && errno == ENOENT)
+                {
+                    data = fopen(p.c_str(), "w+b");
+                }
+            }
+            return data;
+        }
+
+        // Closes whatever handle has `name` open.
+        void release(const char *name)
+        {
+            if (isData(name) && data != nullptr)
+            {
+                fclose(data);
+                data = nullptr;
+            }
+            if (other != nullptr && otherName == name)
+            {
+                fclose(other);
+                other = nullptr;
+                otherName.clear();
+            }
+        }
+
+        void releaseAll()
+        {
+            release(AstrOsScriptArchive::kDataFile);
+            if (other != nullptr)
+            {
+                release(otherName.c_str());
+            }
+        }
+
+        static bool size(void *ctx, const char *name, uint32_t &out)
+        {
+            self(ctx).release(name);
+            struct stat st;
+            if (stat(path(name).c_str(), &st) != 0)
+            {
+                return false;
+            }
+            out = static_cast<uint32_t>(st.st_size);
+            return true;
+        }
+
+        static bool read(void *ctx, const char *name, uint32_t offset, uint8_t *out, size_t len)
+        {
+            const bool cached = isData(name);
+            if (!cached)
+            {
+                self(ctx).release(name);
+            }
+            FILE *f = cached ? self(ctx).dataHandle() : fopen(path(name).c_str(), "rb");
+            if (f == nullptr)
+            {
+                return false;
+            }
+            const bool ok = fseek(f, offset, SEEK_SET) == 0 && fread(out, 1, len, f) == len;
+            if (!cached)
+            {
+                fclose(f);
+            }
+            return ok;
+        }
+
+        static bool append(void *ctx, const char *name, const uint8_t *bytes, size_t len)
+        {
+            ArchiveFiles &files = self(ctx);
+            if (isData(name))
+            {
+                FILE *f = files.dataHandle();
+                return f != nullptr && fseek(f, 0, SEEK_END) == 0 && fwrite(bytes, 1, len, f) == len &&
+                       fflush(f) == 0 && fsync(fileno(f)) == 0;
+            }
+            if (files.other == nullptr || files.otherName != name)
+            {
+                if (files.other != nullptr)
+                {
+                    files.release(files.otherName.c_str());
+                }
+                files.other = fopen(path(name).c_str(), "ab");
+                if (files.other == nullptr)
+                {
+                    return false;
+                }
+                files.otherName = name;
+            }
+            return fwrite(bytes, 1, len, files.other) == len;
+        }
+
+        static bool truncate(void *ctx, const char *name, uint32_t len)
+        {
+            if (isData(name))
+            {
+                FILE *f = self(ctx).dataHandle();
+                return f != nullptr && fflush(f) == 0 && ftruncate(fileno(f), len) == 0 && fsync(fileno(f)) == 0;
+            }
+            self(ctx).release(name);
+            return ::truncate(path(name).c_str(), len) == 0;
+        }
+
+        static bool write(void *ctx, const char *name, const uint8_t *bytes, size_t len)
+        {
+            self(ctx).release(name);
+            FILE *f = fopen(path(name).c_str(), "wb");
+            if (f == nullptr)
+            {
+                return false;
+            }
+            bool ok = fwrite(bytes, 1, len, f) == len && fflush(f) == 0 && fsync(fileno(f)) == 0;
+            ok = (fclose(f) == 0) && ok;
+            return ok;
+        }
+
+        static bool rename(void *ctx, const char *from, const char *to)
+        {
+            self(ctx).release(from);
+            self(ctx).release(to);
+            // FATFS won't rename over an existing file.
+            const std::string target = path(to);
+            if (unlink(target.c_str()) != 0 && errno != ENOENT)
+            {
+                return false;
+            }
+            return ::rename(path(from).c_str(), target.c_str()) == 0;
+        }
+
+        static bool remove(void *ctx, const char *name)
+        {
+            self(ctx).release(name);
+            return unlink(path(name).c_str()) == 0 || errno == ENOENT;
+        }
+    };
+
+    ArchiveFiles archiveFiles;
+
+    AstrOsScriptArchive::FileOps archiveOps()
+    {
+        return AstrOsScriptArchive::FileOps{&ArchiveFiles::size,   &ArchiveFiles::read,   &ArchiveFiles::append,
+                                            &ArchiveFiles::truncate, &ArchiveFiles::write, &ArchiveFiles::rename,
+                                            &ArchiveFiles::remove, &archiveFiles};
+    }
+
+    constexpr const char *kScriptsPrefix = "scripts/";
+
+    // scripts/<id>, one level deep, with an id the archive accepts.
+    bool archiveScriptId(const std::string &filename, std::string &id)
+    {
+        const size_t n = strlen(kScriptsPrefix);
+        if (filename.compare(0, n, kScriptsPrefix) != 0)
+        {
+            return false;
+        }
+        id = filename.substr(n);
+        return AstrOsScriptArchive::Archive::validId(id);
+    }
+
+    AstrOsStorageManager::ReadStatus toReadStatus(AstrOsScriptArchive::Status s)
+    {
+        using AstrOsScriptArchive::Status;
+        using ReadStatus = AstrOsStorageManager::ReadStatus;
+        switch (s)
+        {
+        case Status::OK:
+            return ReadStatus::OK;
+        case Status::NOT_OPEN:
+            return ReadStatus::NOT_MOUNTED;
+        case Status::NOT_FOUND:
+            return ReadStatus::NOT_FOUND;
+        case Status::INVALID_ID:
+            return ReadStatus::INVALID_PATH;
+        case Status::TOO_LARGE:
+            return ReadStatus::TOO_LARGE;
+        case Status::IO_ERROR:
+        case Status::CORRUPT:
+            break;
+        }
+        return ReadStatus::IO_ERROR;
+    }
+#endif
 } // namespace
 
 AstrOsStorageManager::AstrOsStorageManager() {}
 AstrOsStorageManager::~AstrOsStorageManager()
 {
-
+#ifdef USE_SPIFFS
+    closeReadHandle();
+    if (spiffsMounted_)
+    {
+        esp_vfs_spiffs_unregister(NULL);
+        ESP_LOGI(TAG, "SPIFFS unmounted");
+    }
+#else
+#ifdef USE_SCRIPT_ARCHIVE
+    scriptArchive_.close();
+    archiveFiles.releaseAll();
+#endif
     const char mountPoint[] = MOUNT_POINT;
 
     // All done, unmount partition and disable SPI peripheral
@@ -80,6 +388,7 @@ AstrOsStorageManager::~AstrOsStorageManager()
     sdmmc_host_t host = SDSPI_HOST_DEFAULT();
     spi_host_device_t device = static_cast<spi_host_device_t>(host.slot);
     spi_bus_free(device);
+#endif
 }
 
 esp_err_t AstrOsStorageManager::Init()
@@ -104,9 +413,22 @@ esp_err_t AstrOsStorageManager::Init()
         }
     }
 
+#ifdef USE_SPIFFS
+    ESP_LOGI(TAG, "Mounting SPIFFS");
+
+    return AstrOsStorageManager::mountSpiffs();
+#else
     ESP_LOGI(TAG, "Mounting SD Card");
 
-    return AstrOsStorageManager::mountSdCard();
+    err = AstrOsStorageManager::mountSdCard();
+#ifdef USE_SCRIPT_ARCHIVE
+    if (err == ESP_OK)
+    {
+        openScriptArchive();
+    }
+#endif
+    return err;
+#endif
 }
 
 #pragma region Service Config
@@ -148,6 +470,10 @@ bool AstrOsStorageManager::saveModuleConfigs(std::string msg)
     // GPIO@bool|bool|...;MAESTRO@idx:uart_ch:baudrate@servo_cfg|servo_cfg|...
 
     std::vector<std::string> maestroConfigs;
+    // Text as saved, for the binary cache.
+    std::string gpioText;
+    bool haveGpio = false;
+    std::map<int, std::string> servoTexts;
 
     auto modules = AstrOsStringUtils::splitString(msg, ';');
 
@@ -158,6 +484,10 @@ bool AstrOsStorageManager::saveModuleConfigs(std::string msg)
         return false;
     }
 
+    // Blob first: if anything below fails, boot parses whatever text made
+    // it to the card instead of the configuration this save replaces.
+    this->dropConfigCache(true);
+
     for (const auto &module : modules)
     {
         auto parts = AstrOsStringUtils::splitString(module, '@');
@@ -174,6 +504,8 @@ bool AstrOsStorageManager::saveModuleConfigs(std::string msg)
         {
         case MODULE_TYPE::GPIO:
             success = this->saveGpioConfig(parts[1]);
+            gpioText = parts[1];
+            haveGpio = true;
             break;
         case MODULE_TYPE::MAESTRO:
         {
@@ -184,6 +516,10 @@ bool AstrOsStorageManager::saveModuleConfigs(std::string msg)
             else
             {
                 maestroConfigs.push_back(parts[1]);
+                for (const auto &cfg : AstrOsFileUtils::parseMaestroConfig(parts[1]))
+                {
+                    servoTexts[cfg.idx] = parts[2];
+                }
             }
             break;
         }
@@ -200,9 +536,111 @@ bool AstrOsStorageManager::saveModuleConfigs(std::string msg)
         success = false;
     }
 
+    // Without a GPIO module the old gpio file stands, and the blob would
+    // have to read it back; leave that boot to the text path.
+    if (success && haveGpio)
+    {
+        std::string maestroText;
+        for (const auto &maestroConfig : maestroConfigs)
+        {
+            maestroText += maestroConfig + "\n";
+        }
+        this->storeConfigCache(AstrOsConfigCache::fromText(gpioText, maestroText, servoTexts));
+    }
+
     return success;
 }
 
+std::shared_ptr<const AstrOsConfigCache::Snapshot> AstrOsStorageManager::configCache()
+{
+    uint32_t gen;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (configCacheLoaded_)
+        {
+            return configCache_;
+        }
+        gen = configCacheGen_;
+    }
+
+    std::shared_ptr<const AstrOsConfigCache::Snapshot> loaded = this->readConfigCacheFile();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!configCacheLoaded_ && configCacheGen_ == gen)
+    {
+        configCache_ = std::move(loaded);
+        configCacheLoaded_ = true;
+    }
+    return configCache_;
+}
+
+std::shared_ptr<const AstrOsConfigCache::Snapshot> AstrOsStorageManager::readConfigCacheFile()
+{
+    std::vector<uint8_t> blob;
+    const std::string path = AstrOsStorageManager::setFilePath(CONFIG_CACHE_FILE);
+
+    ReadResult r = this->readFileBlocks(path.c_str(), &appendConfigBlock, &blob);
+    if (!r.ok)
+    {
+        if (r.status == ReadStatus::NOT_FOUND)
+        {
+            ESP_LOGI(TAG, "No binary config cache, loading text configs");
+        }
+        else
+        {
+            ESP_LOGW(TAG, "Binary config cache unreadable (%s), loading text configs", readStatusName(r.status));
+        }
+        return nullptr;
+    }
+
+    auto snapshot = std::make_shared<AstrOsConfigCache::Snapshot>();
+    AstrOsConfigCache::Status s = AstrOsConfigCache::decode(blob.data(), blob.size(), *snapshot);
+    if (s != AstrOsConfigCache::Status::OK)
+    {
+        ESP_LOGW(TAG, "Binary config cache rejected (%s), loading text configs", AstrOsConfigCache::statusName(s));
+        return nullptr;
+    }
+
+    ESP_LOGI(TAG, "Loaded binary config cache: %u maestro modules, %u gpio channels",
+             static_cast<unsigned>(snapshot->maestros.size()), static_cast<unsigned>(snapshot->gpio.size()));
+    return snapshot;
+}
+
+void AstrOsStorageManager::storeConfigCache(AstrOsConfigCache::Snapshot snapshot)
+{
+    std::vector<uint8_t> blob;
+    AstrOsConfigCache::Status s = AstrOsConfigCache::encode(snapshot, blob);
+    if (s != AstrOsConfigCache::Status::OK)
+    {
+        ESP_LOGW(TAG, "Binary config cache not written (%s)", AstrOsConfigCache::statusName(s));
+        return;
+    }
+    if (!this->saveFile(CONFIG_CACHE_FILE, std::string(blob.begin(), blob.end())))
+    {
+        ESP_LOGW(TAG, "Binary config cache not written");
+        return;
+    }
+
+    auto installed = std::make_shared<const AstrOsConfigCache::Snapshot>(std::move(snapshot));
+    std::lock_guard<std::mutex> lock(mutex_);
+    configCache_ = std::move(installed);
+    configCacheLoaded_ = true;
+}
+
+void AstrOsStorageManager::dropConfigCache(bool removeFile)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        configCache_.reset();
+        configCacheLoaded_ = false;
+        configCacheGen_++;
+    }
+    if (removeFile && this->fileExists(CONFIG_CACHE_FILE))
+    {
+        this->deleteFile(CONFIG_CACHE_FILE);
+    }
+}
+
 #pragma endregion Module Configs
 #pragma region Maestro Configs
 
@@ -252,9 +690,14 @@ bool AstrOsStorageManager::saveMaestroModules(std::vector<std::string> config)
 
 std::vector<maestro_config> AstrOsStorageManager::loadMaestroConfigs()
 {
-    std::string maestroFile = this->readFile(MAESTRO_MODULES_FILE);
+    if (auto snapshot = this->configCache())
+    {
+        return snapshot->maestros;
+    }
 
-    if (maestroFile.empty() || maestroFile == "error")
+    std::string maestroFile;
+
+    if (!this->readFile(MAESTRO_MODULES_FILE, maestroFile).ok || maestroFile.empty())
     {
         ESP_LOGW(TAG, "Failed to load maestro configs, file not found or empty");
         return std::vector<maestro_config>(); // return empty list if file is empty or not found
@@ -263,32 +706,38 @@ std::vector<maestro_config> AstrOsStorageManager::loadMaestroConfigs()
     return AstrOsFileUtils::parseMaestroConfig(maestroFile);
 }
 
-bool AstrOsStorageManager::loadMaestroServos(int idx, servo_channel *servos, int arraySize)
+bool AstrOsStorageManager::loadMaestroServos(int idx, std::vector<servo_channel> &servos)
 {
+    // channels points into one or the other.
+    std::shared_ptr<const AstrOsConfigCache::Snapshot> snapshot = this->configCache();
+    std::vector<servo_channel> parsed;
+    const std::vector<servo_channel> *channels = nullptr;
 
-    if (arraySize <= 0 || servos == nullptr)
+    if (snapshot)
     {
-        ESP_LOGE(TAG, "Invalid array size or servos pointer");
-        return false;
+        channels = snapshot->servosFor(idx);
+        if (channels == nullptr || channels->empty())
+        {
+            ESP_LOGE(TAG, "Failed to load servo configs for module %d, not in config cache", idx);
+            return false;
+        }
     }
-
-    std::string servoFile = this->readFile(MAESTRO_FOLDER_PATH + std::to_string(idx) + CFIG_SUFFIX);
-
-    if (servoFile.empty() || servoFile == "error")
+    else
     {
-        ESP_LOGE(TAG, "Failed to load servo configs for module %d, file not found or empty", idx);
-        return false;
-    }
+        std::string servoFile;
 
-    std::vector<servo_channel> channels = AstrOsFileUtils::parseServoConfig(servoFile);
+        if (!this->readFile(MAESTRO_FOLDER_PATH + std::to_string(idx) + CFIG_SUFFIX, servoFile).ok ||
+            servoFile.empty())
+        {
+            ESP_LOGE(TAG, "Failed to load servo configs for module %d, file not found or empty", idx);
+            return false;
+        }
 
-    if (channels.size() > arraySize)
-    {
-        ESP_LOGE(TAG, "Not enough space in servos array, required: %zu, available: %d", channels.size(), arraySize);
-        return false;
+        parsed = AstrOsFileUtils::parseServoConfig(servoFile);
+        channels = &parsed;
     }
 
-    std::copy(channels.begin(), channels.end(), servos);
+    servos.assign(channels->begin(), channels->end());
 
     return true;
 
@@ -381,31 +830,20 @@ bool AstrOsStorageManager::saveGpioConfig(std::string config)
 
 std::vector<bool> AstrOsStorageManager::loadGpioConfigs()
 {
-    std::vector<bool> results;
-
-    std::string gpioFile = this->readFile(GPIO_FILE);
-
-    if (gpioFile.empty() || gpioFile == "error")
+    if (auto snapshot = this->configCache())
     {
-        ESP_LOGW(TAG, "Failed to load gpio configs, file not found or empty");
-
-        // default to all false
-        for (int i = 0; i < 10; i++)
-        {
-            results.push_back(false);
-        }
-        return results;
+        return snapshot->gpio;
     }
 
-    auto parts = AstrOsStringUtils::splitString(gpioFile, '|');
+    std::string gpioFile;
 
-    for (const auto &part : parts)
+    if (!this->readFile(GPIO_FILE, gpioFile).ok || gpioFile.empty())
     {
-        // 1 is default high, 0 is default low
-        results.push_back(part == "1");
+        // parseGpioConfig defaults every channel low
+        ESP_LOGW(TAG, "Failed to load gpio configs, file not found or empty");
     }
 
-    return results;
+    return AstrOsFileUtils::parseGpioConfig(gpioFile);
 }
 
 #pragma endregion GPIO Configs
@@ -432,85 +870,649 @@ bool AstrOsStorageManager::saveFile(std::string filename, std::string data)
     {
         return false;
     }
-#ifdef USE_SPIFFS
-    return AstrOsStorageManager::saveFileSpiffs(filename, data);
-#else
-    return AstrOsStorageManager::saveFileSd(filename, data);
-#endif
+
+    std::vector<AstrOsWriteBehind::Waiter> superseded;
+    bool result;
+    {
+        std::lock_guard<std::mutex> writeLock(writeMutex_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            superseded = writeQueue_.cancel(filename);
+        }
+        result = saveFileNow(filename, data);
+    }
+    AstrOsWriteBehind::complete(superseded, filename, result);
+    return result;
 }
 
-bool AstrOsStorageManager::deleteFile(std::string filename)
+bool AstrOsStorageManager::saveFileAsync(const std::string &filename, const std::string &data,
+                                         AstrOsWriteBehind::DoneFn done, void *ctx, const std::string &token)
 {
-    if (!isPathSafeAndLog(filename))
+    if (writeJobQueue_ == nullptr || !isPathSafeAndLog(filename))
     {
         return false;
     }
-#ifdef USE_SPIFFS
-    return AstrOsStorageManager::deleteFileSpiffs(filename);
-#else
-    return AstrOsStorageManager::deleteFileSd(filename);
-#endif
-}
 
-std::string AstrOsStorageManager::readFile(std::string filename)
-{
-    if (!isPathSafeAndLog(filename))
+    AstrOsWriteBehind::PushStatus status;
     {
-        return "error";
+        std::lock_guard<std::mutex> lock(mutex_);
+        status = writeQueue_.push(filename, data, AstrOsWriteBehind::Waiter{done, ctx, token});
     }
-#ifdef USE_SPIFFS
-    return AstrOsStorageManager::readFileSpiffs(filename);
-#else
-    return AstrOsStorageManager::readFileSd(filename);
-#endif
-}
 
-bool AstrOsStorageManager::fileExists(std::string filename)
-{
-    if (!isPathSafeAndLog(filename))
+    if (status == AstrOsWriteBehind::PushStatus::FULL)
     {
+        ESP_LOGW(TAG, "Write-behind queue full, saving %s directly", filename.c_str());
         return false;
     }
-#ifdef USE_SPIFFS
-    return AstrOsStorageManager::fileExistsSpiffs(filename);
-#else
-    return AstrOsStorageManager::fileExistsSd(filename);
-#endif
-}
-
-std::vector<std::string> AstrOsStorageManager::listFiles(std::string folder)
-{
-    if (!isPathSafeAndLog(folder))
+    if (status == AstrOsWriteBehind::PushStatus::QUEUED)
     {
-        return {};
+        // A full wake-up queue already has storageWriterTask on its way.
+        const uint8_t wake = 0;
+        xQueueSend(writeJobQueue_, &wake, 0);
     }
-#ifdef USE_SPIFFS
-    return AstrOsStorageManager::listFilesSpiffs(folder);
-#else
-    return AstrOsStorageManager::listFilesSd(folder);
-#endif
+    return true;
 }
 
-#pragma endregion ESP - NOW
-#pragma region SD CARD
-
-esp_err_t AstrOsStorageManager::formatSdCard()
+bool AstrOsStorageManager::initWriteBehind()
 {
-    char drv[3] = {'0', ':', 0};
-    const size_t workbuf_size = 4096;
-    void *workbuf = NULL;
-    ESP_LOGI(TAG, "Formatting the SD card");
-
-    if (card == nullptr)
+    if (writeJobQueue_ == nullptr)
     {
-        ESP_LOGE(TAG, "Error formatting SD card: card not mounted");
-        return ESP_ERR_INVALID_STATE;
+        writeJobQueue_ = xQueueCreate(kWriteWakeQueueLength, sizeof(uint8_t));
     }
+    return writeJobQueue_ != nullptr;
+}
 
-    size_t allocation_unit_size = 16 * 1024;
-
-    workbuf = ff_memalloc(workbuf_size);
-    if (workbuf == NULL)
+void AstrOsStorageManager::processWriteJobs()
+{
+    while (true)
+    {
+        std::vector<AstrOsWriteBehind::Waiter> waiters;
+        std::string path;
+        bool ok;
+        {
+            std::lock_guard<std::mutex> writeLock(writeMutex_);
+            const AstrOsWriteBehind::Job *job;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                job = writeQueue_.take();
+            }
+            if (job == nullptr)
+            {
+                return;
+            }
+            // Only this task takes or finishes jobs, so *job holds still
+            // without mutex_; readers peek at it under mutex_.
+            path = job->path;
+            ok = saveFileNow(job->path, job->data);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                waiters = writeQueue_.finish();
+            }
+        }
+        if (!ok)
+        {
+            ESP_LOGE(TAG, "Write-behind save of %s failed", path.c_str());
+        }
+        AstrOsWriteBehind::complete(waiters, path, ok);
+    }
+}
+
+void AstrOsStorageManager::flushWrites(uint32_t timeoutMs)
+{
+    const int64_t deadline = esp_timer_get_time() + static_cast<int64_t>(timeoutMs) * 1000;
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (writeQueue_.idle())
+            {
+                return;
+            }
+        }
+        if (esp_timer_get_time() >= deadline)
+        {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    std::vector<AstrOsWriteBehind::Job> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dropped = writeQueue_.cancelAll();
+    }
+    ESP_LOGE(TAG, "Write-behind flush timed out, dropping %u queued saves", static_cast<unsigned>(dropped.size()));
+    for (const AstrOsWriteBehind::Job &job : dropped)
+    {
+        AstrOsWriteBehind::complete(job.waiters, job.path, false);
+    }
+}
+
+AstrOsWriteBehind::Stats AstrOsStorageManager::writeBehindStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writeQueue_.stats();
+}
+
+bool AstrOsStorageManager::saveFileNow(const std::string &filename, const std::string &data)
+{
+    const int64_t start = esp_timer_get_time();
+#ifdef USE_SCRIPT_ARCHIVE
+    std::optional<bool> archived = saveArchivedScript(filename, data);
+    if (archived.has_value())
+    {
+        recordOp(StorageOp::SAVE, start);
+        return *archived;
+    }
+#endif
+#ifdef USE_SPIFFS
+    bool result = AstrOsStorageManager::saveFileSpiffs(filename, data);
+#else
+    bool result = AstrOsStorageManager::saveFileSd(filename, data);
+#endif
+    recordOp(StorageOp::SAVE, start);
+    return result;
+}
+
+bool AstrOsStorageManager::deleteFile(std::string filename)
+{
+    if (!isPathSafeAndLog(filename))
+    {
+        return false;
+    }
+    // After any in-flight save of this file, and instead of a queued one.
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+    std::vector<AstrOsWriteBehind::Waiter> superseded;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        superseded = writeQueue_.cancel(filename);
+    }
+    const int64_t start = esp_timer_get_time();
+#ifdef USE_SPIFFS
+    bool result = AstrOsStorageManager::deleteFileSpiffs(filename);
+#else
+    bool result = AstrOsStorageManager::deleteFileSd(filename);
+#endif
+#ifdef USE_SCRIPT_ARCHIVE
+    // Both: a loose copy left behind would resurface once the archived one is gone.
+    std::optional<bool> archived = deleteArchivedScript(filename);
+    if (archived.has_value())
+    {
+        result = *archived;
+    }
+#endif
+    recordOp(StorageOp::DELETE, start);
+    AstrOsWriteBehind::complete(superseded, filename, result);
+    return result;
+}
+
+AstrOsStorageManager::ReadResult AstrOsStorageManager::readFile(const std::string &filename, std::string &out)
+{
+    std::string text;
+    ReadResult r = readFileTimed(filename, ReadSink{&text, nullptr, 0});
+    if (r.ok)
+    {
+        out.swap(text);
+    }
+    return r;
+}
+
+AstrOsStorageManager::ReadResult AstrOsStorageManager::readFile(const std::string &filename, uint8_t *buf, size_t cap)
+{
+    return readFileTimed(filename, ReadSink{nullptr, buf, cap});
+}
+
+AstrOsStorageManager::ReadResult AstrOsStorageManager::readFileTimed(const std::string &filename,
+                                                                     const ReadSink &sink)
+{
+    if (!isPathSafeAndLog(filename))
+    {
+        return ReadResult::failed(ReadStatus::INVALID_PATH);
+    }
+    const int64_t start = esp_timer_get_time();
+    {
+        // A save still queued is the file's content as far as readers go.
+        std::string queued;
+        bool haveQueued;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            haveQueued = writeQueue_.peek(filename, queued);
+        }
+        if (haveQueued)
+        {
+            recordOp(StorageOp::READ, start);
+            return readQueued(queued, sink);
+        }
+    }
+#ifdef USE_SCRIPT_ARCHIVE
+    std::optional<ReadResult> archived = readArchivedScript(filename, sink);
+    if (archived.has_value())
+    {
+        recordOp(StorageOp::READ, start);
+        if (!archived->ok)
+        {
+            ESP_LOGE(TAG, "readFile %s (archive): %s", filename.c_str(), readStatusName(archived->status));
+        }
+        return *archived;
+    }
+#endif
+#ifdef USE_SPIFFS
+    ReadResult result = AstrOsStorageManager::readFileSpiffs(filename, sink);
+#else
+    ReadResult result = AstrOsStorageManager::readFileSd(filename, sink);
+#endif
+    recordOp(StorageOp::READ, start);
+    if (!result.ok)
+    {
+        ESP_LOGE(TAG, "readFile %s: %s", filename.c_str(), readStatusName(result.status));
+    }
+    return result;
+}
+
+AstrOsStorageManager::ReadResult AstrOsStorageManager::readFileBlocks(const char *path, BlockFn fn, void *ctx)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return ReadResult::failed(errno == ENOENT ? ReadStatus::NOT_FOUND : ReadStatus::IO_ERROR);
+    }
+    std::unique_ptr<uint8_t[]> block(new (std::nothrow) uint8_t[kReadBlockSize]);
+    if (!block)
+    {
+        fclose(f);
+        return ReadResult::failed(ReadStatus::NO_MEM);
+    }
+    setvbuf(f, NULL, _IONBF, 0);
+
+    size_t total = 0;
+    size_t got;
+    while ((got = fread(block.get(), 1, kReadBlockSize, f)) > 0)
+    {
+        fn(ctx, block.get(), got);
+        total += got;
+    }
+    const bool readOk = !ferror(f);
+    fclose(f);
+    return readOk ? ReadResult::success(total) : ReadResult::failed(ReadStatus::IO_ERROR, total);
+}
+
+AstrOsStorageManager::ReadResult AstrOsStorageManager::readOpenFile(FILE *f, const ReadSink &sink)
+{
+    struct stat st;
+    if (fstat(fileno(f), &st) != 0 || st.st_size < 0)
+    {
+        return ReadResult::failed(ReadStatus::IO_ERROR);
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+
+    if (sink.text == nullptr)
+    {
+        if (size > sink.cap)
+        {
+            return ReadResult::failed(ReadStatus::TOO_LARGE, size);
+        }
+        if (size > 0 && fread(sink.buf, 1, size, f) != size)
+        {
+            return ReadResult::failed(ReadStatus::IO_ERROR);
+        }
+        return ReadResult::success(size);
+    }
+
+    // No exceptions in this build: an allocation the heap can't satisfy
+    // aborts, so check for one contiguous block first.
+    if (size + 1 > heap_caps_get_largest_free_block(MALLOC_CAP_8BIT))
+    {
+        return ReadResult::failed(ReadStatus::NO_MEM, size);
+    }
+    std::string &text = *sink.text;
+    text.reserve(size);
+    text.resize(size);
+    if (size > 0 && fread(&text[0], 1, size, f) != size)
+    {
+        return ReadResult::failed(ReadStatus::IO_ERROR);
+    }
+    // Files saved by older firmware end in a NUL.
+    text.resize(strnlen(text.data(), size));
+    return ReadResult::success(text.size());
+}
+
+AstrOsStorageManager::ReadResult AstrOsStorageManager::readQueued(const std::string &data, const ReadSink &sink)
+{
+    if (sink.text == nullptr)
+    {
+        if (data.size() > sink.cap)
+        {
+            return ReadResult::failed(ReadStatus::TOO_LARGE, data.size());
+        }
+        memcpy(sink.buf, data.data(), data.size());
+        return ReadResult::success(data.size());
+    }
+    *sink.text = data;
+    return ReadResult::success(data.size());
+}
+
+const char *AstrOsStorageManager::readStatusName(ReadStatus s)
+{
+    switch (s)
+    {
+    case ReadStatus::OK:
+        return "ok";
+    case ReadStatus::INVALID_PATH:
+        return "invalid_path";
+    case ReadStatus::NOT_FOUND:
+        return "not_found";
+    case ReadStatus::NOT_MOUNTED:
+        return "not_mounted";
+    case ReadStatus::TOO_LARGE:
+        return "too_large";
+    case ReadStatus::NO_MEM:
+        return "no_mem";
+    case ReadStatus::IO_ERROR:
+        return "io_error";
+    }
+    return "unknown";
+}
+
+bool AstrOsStorageManager::fileExists(std::string filename)
+{
+    if (!isPathSafeAndLog(filename))
+    {
+        return false;
+    }
+    const int64_t start = esp_timer_get_time();
+    bool queued;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued = writeQueue_.contains(filename);
+    }
+    if (queued)
+    {
+        recordOp(StorageOp::EXISTS, start);
+        return true;
+    }
+#ifdef USE_SCRIPT_ARCHIVE
+    std::optional<bool> archived = archivedScriptExists(filename);
+    if (archived.has_value())
+    {
+        recordOp(StorageOp::EXISTS, start);
+        return *archived;
+    }
+#endif
+#ifdef USE_SPIFFS
+    bool result = AstrOsStorageManager::fileExistsSpiffs(filename);
+#else
+    bool result = AstrOsStorageManager::fileExistsSd(filename);
+#endif
+    recordOp(StorageOp::EXISTS, start);
+    return result;
+}
+
+std::vector<std::string> AstrOsStorageManager::listFiles(std::string folder)
+{
+    if (!isPathSafeAndLog(folder))
+    {
+        return {};
+    }
+    const int64_t start = esp_timer_get_time();
+#ifdef USE_SPIFFS
+    std::vector<std::string> result = AstrOsStorageManager::listFilesSpiffs(folder);
+#else
+    std::vector<std::string> result = AstrOsStorageManager::listFilesSd(folder);
+#endif
+    // replaceFile temps: mid-save, or left by a power cut.
+    result.erase(std::remove_if(result.begin(), result.end(),
+                                [](const std::string &name) { return endsWith(name, kReplaceSuffix); }),
+                 result.end());
+#ifdef USE_SCRIPT_ARCHIVE
+    if (folder == "scripts" || folder == kScriptsPrefix)
+    {
+        // Archived scripts, then any loose file not migrated.
+        std::vector<std::string> archived = listArchivedScripts();
+        for (std::string &name : result)
+        {
+            if (!std::binary_search(archived.begin(), archived.end(), name))
+            {
+                archived.push_back(std::move(name));
+            }
+        }
+        result.swap(archived);
+    }
+#endif
+    recordOp(StorageOp::LIST, start);
+    return result;
+}
+
+AstrOsStorageManager::OpStats AstrOsStorageManager::opStats(StorageOp op) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return opStats_[static_cast<size_t>(op)];
+}
+
+void AstrOsStorageManager::resetOpStats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (OpStats &s : opStats_)
+    {
+        s = OpStats();
+    }
+}
+
+void AstrOsStorageManager::logOpStats() const
+{
+    static const char *const names[] = {"save", "delete", "exists", "read", "list"};
+    for (size_t i = 0; i < static_cast<size_t>(StorageOp::COUNT); i++)
+    {
+        const OpStats s = opStats(static_cast<StorageOp>(i));
+        if (s.count == 0)
+        {
+            continue;
+        }
+        ESP_LOGD(TAG, "op %-6s n=%" PRIu32 " avg=%" PRIu64 "us max=%" PRIu32 "us", names[i], s.count,
+                 s.totalUs / s.count, s.maxUs);
+    }
+}
+
+void AstrOsStorageManager::recordOp(StorageOp op, int64_t startUs)
+{
+    const uint32_t us = static_cast<uint32_t>(esp_timer_get_time() - startUs);
+    std::lock_guard<std::mutex> lock(mutex_);
+    OpStats &s = opStats_[static_cast<size_t>(op)];
+    s.count++;
+    s.totalUs += us;
+    s.maxUs = std::max(s.maxUs, us);
+}
+
+#pragma endregion ESP - NOW
+#ifdef USE_SCRIPT_ARCHIVE
+#pragma region Script Archive
+
+void AstrOsStorageManager::openScriptArchive()
+{
+    // Scripts saved before the archive existed (or while it couldn't open)
+    // are loose files; fold them in once so lookups stop touching scripts/.
+    std::vector<std::string> loose = listFilesSd("scripts");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    AstrOsScriptArchive::Result r = scriptArchive_.open(archiveOps());
+    if (!r.ok)
+    {
+        archiveFiles.releaseAll();
+        ESP_LOGE(TAG, "Script archive unavailable (%s); scripts stay loose files",
+                 AstrOsScriptArchive::statusName(r.status));
+        return;
+    }
+
+    uint32_t migrated = 0;
+    for (const std::string &name : loose)
+    {
+        const std::string filename = kScriptsPrefix + name;
+        std::string id;
+        std::string text;
+        if (!archiveScriptId(filename, id) || !readFileSd(filename, ReadSink{&text, nullptr, 0}).ok)
+        {
+            continue;
+        }
+        if (scriptArchive_.put(id, reinterpret_cast<const uint8_t *>(text.data()), text.size()).ok &&
+            unlink(setFilePath(filename).c_str()) == 0)
+        {
+            migrated++;
+        }
+    }
+    if (migrated > 0 && !scriptArchive_.flush().ok)
+    {
+        ESP_LOGW(TAG, "Script archive index not written; next boot replays");
+    }
+
+    const AstrOsScriptArchive::Stats st = scriptArchive_.stats();
+    ESP_LOGI(TAG,
+             "Script archive: %" PRIu32 " scripts, %" PRIu32 " B (%" PRIu32 " dead), replayed %" PRIu32
+             ", dropped %" PRIu32 " B, migrated %" PRIu32 "%s",
+             st.scripts, st.dataBytes, st.deadBytes, st.replayedRecords, st.droppedTailBytes, migrated,
+             st.indexRebuilt ? ", index rebuilt" : "");
+}
+
+std::optional<bool> AstrOsStorageManager::saveArchivedScript(const std::string &filename, const std::string &data)
+{
+    std::string id;
+    if (!archiveScriptId(filename, id))
+    {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!scriptArchive_.isOpen())
+    {
+        return std::nullopt;
+    }
+    AstrOsScriptArchive::Result r =
+        scriptArchive_.put(id, reinterpret_cast<const uint8_t *>(data.data()), data.size());
+    if (!r.ok)
+    {
+        ESP_LOGE(TAG, "Archive save %s: %s", id.c_str(), AstrOsScriptArchive::statusName(r.status));
+        return false;
+    }
+    return true;
+}
+
+std::optional<bool> AstrOsStorageManager::deleteArchivedScript(const std::string &filename)
+{
+    std::string id;
+    if (!archiveScriptId(filename, id))
+    {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!scriptArchive_.isOpen())
+    {
+        return std::nullopt;
+    }
+    AstrOsScriptArchive::Result r = scriptArchive_.remove(id);
+    if (!r.ok && r.status != AstrOsScriptArchive::Status::NOT_FOUND)
+    {
+        ESP_LOGE(TAG, "Archive delete %s: %s", id.c_str(), AstrOsScriptArchive::statusName(r.status));
+        return false;
+    }
+    return true;
+}
+
+std::optional<bool> AstrOsStorageManager::archivedScriptExists(const std::string &filename)
+{
+    std::string id;
+    if (!archiveScriptId(filename, id))
+    {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!scriptArchive_.contains(id))
+    {
+        return std::nullopt;
+    }
+    return true;
+}
+
+std::optional<AstrOsStorageManager::ReadResult> AstrOsStorageManager::readArchivedScript(const std::string &filename,
+                                                                                         const ReadSink &sink)
+{
+    std::string id;
+    if (!archiveScriptId(filename, id))
+    {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!scriptArchive_.contains(id))
+    {
+        return std::nullopt;
+    }
+
+    if (sink.text == nullptr)
+    {
+        AstrOsScriptArchive::Result r = scriptArchive_.read(id, sink.buf, sink.cap);
+        return r.ok ? ReadResult::success(r.bytes) : ReadResult::failed(toReadStatus(r.status), r.bytes);
+    }
+
+    // Size first (a zero-capacity read reports it), so the allocation can
+    // be checked the same way readOpenFile does.
+    AstrOsScriptArchive::Result probe = scriptArchive_.read(id, nullptr, 0);
+    if (!probe.ok && probe.status != AstrOsScriptArchive::Status::TOO_LARGE)
+    {
+        return ReadResult::failed(toReadStatus(probe.status));
+    }
+    const size_t size = probe.bytes;
+    if (size + 1 > heap_caps_get_largest_free_block(MALLOC_CAP_8BIT))
+    {
+        return ReadResult::failed(ReadStatus::NO_MEM, size);
+    }
+    std::string &text = *sink.text;
+    text.reserve(size);
+    text.resize(size);
+    AstrOsScriptArchive::Result r = scriptArchive_.read(id, reinterpret_cast<uint8_t *>(&text[0]), size);
+    if (!r.ok)
+    {
+        return ReadResult::failed(toReadStatus(r.status));
+    }
+    text.resize(strnlen(text.data(), size));
+    return ReadResult::success(text.size());
+}
+
+std::vector<std::string> AstrOsStorageManager::listArchivedScripts()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scriptArchive_.list();
+}
+
+#pragma endregion Script Archive
+#endif
+#pragma region SD CARD
+
+esp_err_t AstrOsStorageManager::formatSdCard()
+{
+    char drv[3] = {'0', ':', 0};
+    const size_t workbuf_size = 4096;
+    void *workbuf = NULL;
+    ESP_LOGI(TAG, "Formatting the SD card");
+
+    if (card == nullptr)
+    {
+        ESP_LOGE(TAG, "Error formatting SD card: card not mounted");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Saves queued before the format land before it, as they would have
+    // when saves were synchronous.
+    flushWrites(kFlushTimeoutMs);
+    std::lock_guard<std::mutex> writeLock(writeMutex_);
+
+    size_t allocation_unit_size = 16 * 1024;
+
+#ifdef USE_SCRIPT_ARCHIVE
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scriptArchive_.close();
+        archiveFiles.releaseAll();
+    }
+#endif
+
+    workbuf = ff_memalloc(workbuf_size);
+    if (workbuf == NULL)
     {
         ESP_LOGE(TAG, "Error formatting SD card: work-buffer allocation failed");
         return ESP_ERR_NO_MEM;
@@ -544,6 +1546,13 @@ esp_err_t AstrOsStorageManager::formatSdCard()
         }
     }
 
+    // The blob went with everything else.
+    dropConfigCache(false);
+
+#ifdef USE_SCRIPT_ARCHIVE
+    openScriptArchive();
+#endif
+
     ESP_LOGI(TAG, "Successfully formatted the SD card");
     return ESP_OK;
 }
@@ -582,6 +1591,20 @@ bool AstrOsStorageManager::ensureSdFirmwareDir()
     ESP_LOGE(TAG, "ensureSdFirmwareDir: mkdir(%s) failed: errno=%d (%s)", path, errno, strerror(errno));
     return false;
 }
+
+bool AstrOsStorageManager::preallocateSdFile(const char *path, uint32_t size)
+{
+    // f_expand(alloc_now) under the hood: the clusters are linked and the
+    // file's size is set to `size` up front, so the file has to be opened
+    // "r+b" afterwards — "wb" would truncate the reservation away.
+    esp_err_t err = esp_vfs_fat_create_contiguous_file(MOUNT_POINT, path, size, true);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "preallocateSdFile: %s (%u bytes) failed: %s", path, (unsigned)size, esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
 #endif
 
 esp_err_t AstrOsStorageManager::mountSdCard()
@@ -654,29 +1677,17 @@ esp_err_t AstrOsStorageManager::mountSdCard()
 
 bool AstrOsStorageManager::saveFileSd(std::string filename, std::string data)
 {
-    FILE *fd = NULL;
-
     std::string path = AstrOsStorageManager::setFilePath(filename);
 
     ESP_LOGI(TAG, "Saving %s", path.c_str());
 
-    if (access(path.c_str(), F_OK) == 0)
-    {
-        ESP_LOGI(TAG, "File %s exists already. Deleting...", path.c_str());
-        unlink(path.c_str());
-    }
-
-    fd = fopen(path.c_str(), "w");
-    if (!fd)
+    // Exactly data.size() bytes, as on SPIFFS: the config cache is binary
+    // and text readers size from fstat, not a terminator.
+    if (!replaceFile(path, data.data(), data.size()))
     {
-        ESP_LOGE(TAG, "Failed to create file : %s", path.c_str());
         return false;
     }
 
-    fwrite(data.c_str(), sizeof(char), strlen(data.c_str()) + 1, fd);
-
-    fclose(fd);
-
     ESP_LOGI(TAG, "Saved %s", path.c_str());
 
     return true;
@@ -703,31 +1714,24 @@ bool AstrOsStorageManager::fileExistsSd(std::string filename)
     return access(path.c_str(), F_OK) == 0;
 }
 
-std::string AstrOsStorageManager::readFileSd(std::string filename)
+AstrOsStorageManager::ReadResult AstrOsStorageManager::readFileSd(const std::string &filename,
+                                                                  const ReadSink &sink)
 {
     std::string path = AstrOsStorageManager::setFilePath(filename);
 
-    if (access(path.c_str(), F_OK) != 0)
+    // fopen's errno is the existence check; no separate access() walk.
+    FILE *f = fopen(path.c_str(), "r");
+    if (f == NULL && errno == ENOENT && recoverReplacement(path))
     {
-        ESP_LOGE(TAG, "File does not exist: %s", path.c_str());
-        return "error";
+        f = fopen(path.c_str(), "r");
     }
-
-    FILE *f = fopen(path.c_str(), "r");
     if (f == NULL)
     {
-        ESP_LOGE(TAG, "Failed to open %s for reading", path.c_str());
-        return "error";
+        return ReadResult::failed(errno == ENOENT ? ReadStatus::NOT_FOUND : ReadStatus::IO_ERROR);
     }
+    setvbuf(f, NULL, _IONBF, 0);
 
-    std::string result = "";
-
-    char segment[100];
-
-    while (fgets(segment, sizeof(segment), f))
-    {
-        result.append(segment);
-    }
+    ReadResult result = readOpenFile(f, sink);
 
     fclose(f);
 
@@ -775,10 +1779,19 @@ std::vector<std::string> AstrOsStorageManager::listFilesSd(std::string folder)
 #pragma endregion SD CARD
 #pragma region SPIFFS
 
-bool AstrOsStorageManager::saveFileSpiffs(std::string filename, std::string data)
+// Mounted once for the life of the process. Registering the partition per
+// operation (as this backend used to) re-reads the whole SPIFFS object index
+// on every mount — far longer than the read or write it wrapped.
+esp_err_t AstrOsStorageManager::mountSpiffs()
 {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (spiffsMounted_)
+    {
+        return ESP_OK;
+    }
+
     esp_vfs_spiffs_conf_t config = {
-        .base_path = "/spiffs",
+        .base_path = MOUNT_POINT,
         .partition_label = NULL,
         .max_files = 5,
         .format_if_mount_failed = true,
@@ -787,123 +1800,163 @@ bool AstrOsStorageManager::saveFileSpiffs(std::string filename, std::string data
     esp_err_t err = esp_vfs_spiffs_register(&config);
     if (logError(TAG, __FUNCTION__, __LINE__, err))
     {
-        return false;
+        ESP_LOGE(TAG, "Failed to mount SPIFFS.");
+        return err;
     }
+    spiffsMounted_ = true;
 
-    ESP_LOGE(TAG, "Creating file: %s", filename.c_str());
-
-    std::string path = AstrOsStorageManager::setFilePath(filename);
+    size_t total = 0;
+    size_t used = 0;
+    if (esp_spiffs_info(NULL, &total, &used) == ESP_OK)
+    {
+        ESP_LOGI(TAG, "SPIFFS mounted: %u of %u bytes used", (unsigned)used, (unsigned)total);
+    }
+    return ESP_OK;
+}
 
-    FILE *f = fopen(path.c_str(), "w");
-    if (f == NULL)
+bool AstrOsStorageManager::saveFileSpiffs(std::string filename, std::string data)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!spiffsMounted_)
     {
-        ESP_LOGE(TAG, "Failed to open file for writing");
+        ESP_LOGE(TAG, "%s: SPIFFS not mounted", __FUNCTION__);
         return false;
     }
 
-    fprintf(f, data.c_str());
-    fclose(f);
+    std::string path = AstrOsStorageManager::setFilePath(filename);
 
-    esp_vfs_spiffs_unregister(NULL);
+    ESP_LOGI(TAG, "Saving %s", path.c_str());
+
+    if (readHandlePath_ == path)
+    {
+        closeReadHandle();
+    }
 
+    // fwrite, not fprintf(f, data): script text is not a format string.
+    if (!replaceFile(path, data.data(), data.size()))
+    {
+        statCacheForget(path);
+        return false;
+    }
+    statCacheStore(path, true);
     return true;
 }
 
 bool AstrOsStorageManager::deleteFileSpiffs(std::string filename)
 {
-    esp_vfs_spiffs_conf_t config = {
-        .base_path = MOUNT_POINT,
-        .partition_label = NULL,
-        .max_files = 5,
-        .format_if_mount_failed = true,
-    };
-
-    esp_err_t err = esp_vfs_spiffs_register(&config);
-    if (logError(TAG, __FUNCTION__, __LINE__, err))
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!spiffsMounted_)
     {
+        ESP_LOGE(TAG, "%s: SPIFFS not mounted", __FUNCTION__);
         return false;
     }
 
     std::string path = AstrOsStorageManager::setFilePath(filename);
 
-    struct stat st;
-    if (stat(path.c_str(), &st) == 0)
+    if (readHandlePath_ == path)
     {
-        unlink(path.c_str());
-        return true;
+        closeReadHandle();
     }
 
-    ESP_LOGI(TAG, "File %s does not exist!", filename.c_str());
+    const StatCacheEntry *cached = statCacheFind(path);
+    if (cached == nullptr || cached->exists)
+    {
+        // unlink reports a missing file itself; no stat walk first.
+        if (unlink(path.c_str()) == 0)
+        {
+            statCacheStore(path, false);
+            return true;
+        }
+        if (errno != ENOENT)
+        {
+            ESP_LOGE(TAG, "Failed to delete %s: errno=%d (%s)", path.c_str(), errno, strerror(errno));
+            statCacheForget(path);
+            return false;
+        }
+        statCacheStore(path, false);
+    }
 
-    esp_vfs_spiffs_unregister(NULL);
+    ESP_LOGI(TAG, "File %s does not exist!", filename.c_str());
     return false;
 }
 
 bool AstrOsStorageManager::fileExistsSpiffs(std::string filename)
 {
-    esp_vfs_spiffs_conf_t config = {
-        .base_path = MOUNT_POINT,
-        .partition_label = NULL,
-        .max_files = 5,
-        .format_if_mount_failed = true,
-    };
-
-    esp_err_t err = esp_vfs_spiffs_register(&config);
-    if (logError(TAG, __FUNCTION__, __LINE__, err))
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!spiffsMounted_)
     {
+        ESP_LOGE(TAG, "%s: SPIFFS not mounted", __FUNCTION__);
         return false;
     }
 
     std::string path = AstrOsStorageManager::setFilePath(filename);
 
-    struct stat st;
-    if (stat(path.c_str(), &st) == 0)
+    const StatCacheEntry *cached = statCacheFind(path);
+    bool exists = false;
+    if (cached != nullptr)
     {
-        esp_vfs_spiffs_unregister(NULL);
-        return true;
+        exists = cached->exists;
+    }
+    else
+    {
+        struct stat st;
+        exists = stat(path.c_str(), &st) == 0;
+        statCacheStore(path, exists);
     }
 
-    ESP_LOGI(TAG, "File %s does not exist!", filename.c_str());
-
-    esp_vfs_spiffs_unregister(NULL);
-    return false;
+    if (!exists)
+    {
+        ESP_LOGI(TAG, "File %s does not exist!", filename.c_str());
+    }
+    return exists;
 }
 
-std::string AstrOsStorageManager::readFileSpiffs(std::string filename)
+AstrOsStorageManager::ReadResult AstrOsStorageManager::readFileSpiffs(const std::string &filename,
+                                                                      const ReadSink &sink)
 {
-    esp_vfs_spiffs_conf_t config = {
-        .base_path = MOUNT_POINT,
-        .partition_label = NULL,
-        .max_files = 5,
-        .format_if_mount_failed = true,
-    };
-
-    esp_err_t err = esp_vfs_spiffs_register(&config);
-    if (logError(TAG, __FUNCTION__, __LINE__, err))
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!spiffsMounted_)
     {
-        return "error";
+        return ReadResult::failed(ReadStatus::NOT_MOUNTED);
     }
 
     std::string path = AstrOsStorageManager::setFilePath(filename);
 
-    FILE *file = fopen(path.c_str(), "r");
-    if (file == NULL)
+    if (readHandle_ != nullptr && readHandlePath_ == path)
     {
-        ESP_LOGE(TAG, "File does not exist!");
-        return "error";
+        rewind(readHandle_);
     }
+    else
+    {
+        closeReadHandle();
 
-    std::string result = "";
+        const StatCacheEntry *cached = statCacheFind(path);
+        if (cached != nullptr && !cached->exists)
+        {
+            return ReadResult::failed(ReadStatus::NOT_FOUND);
+        }
 
-    char segment[256];
-    while (fgets(segment, sizeof(segment), file) != NULL)
-    {
-        result.append(segment);
+        readHandle_ = fopen(path.c_str(), "r");
+        if (readHandle_ == NULL)
+        {
+            if (errno != ENOENT)
+            {
+                return ReadResult::failed(ReadStatus::IO_ERROR);
+            }
+            statCacheStore(path, false);
+            return ReadResult::failed(ReadStatus::NOT_FOUND);
+        }
+        setvbuf(readHandle_, NULL, _IONBF, 0);
+        readHandlePath_ = path;
+        statCacheStore(path, true);
     }
-    fclose(file);
-
-    esp_vfs_spiffs_unregister(NULL);
 
+    ReadResult result = readOpenFile(readHandle_, sink);
+    if (result.status == ReadStatus::IO_ERROR)
+    {
+        closeReadHandle();
+        statCacheForget(path);
+    }
     return result;
 }
 
@@ -911,16 +1964,10 @@ std::vector<std::string> AstrOsStorageManager::listFilesSpiffs(std::string folde
 {
     std::vector<std::string> result;
 
-    esp_vfs_spiffs_conf_t config = {
-        .base_path = MOUNT_POINT,
-        .partition_label = NULL,
-        .max_files = 5,
-        .format_if_mount_failed = true,
-    };
-
-    esp_err_t err = esp_vfs_spiffs_register(&config);
-    if (logError(TAG, __FUNCTION__, __LINE__, err))
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!spiffsMounted_)
     {
+        ESP_LOGE(TAG, "%s: SPIFFS not mounted", __FUNCTION__);
         return result;
     }
 
@@ -929,7 +1976,6 @@ std::vector<std::string> AstrOsStorageManager::listFilesSpiffs(std::string folde
     DIR *dir = opendir(path.c_str());
     if (dir == NULL)
     {
-        esp_vfs_spiffs_unregister(NULL);
         return result;
     }
 
@@ -945,11 +1991,66 @@ std::vector<std::string> AstrOsStorageManager::listFilesSpiffs(std::string folde
     }
 
     closedir(dir);
-    esp_vfs_spiffs_unregister(NULL);
 
     return result;
 }
 
+const AstrOsStorageManager::StatCacheEntry *AstrOsStorageManager::statCacheFind(const std::string &path)
+{
+    for (StatCacheEntry &e : statCache_)
+    {
+        if (e.lastUse != 0 && e.path == path)
+        {
+            e.lastUse = ++statCacheClock_;
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+void AstrOsStorageManager::statCacheStore(const std::string &path, bool exists)
+{
+    // Same path, else an empty slot, else the least recently used.
+    StatCacheEntry *slot = &statCache_[0];
+    for (StatCacheEntry &e : statCache_)
+    {
+        if (e.lastUse != 0 && e.path == path)
+        {
+            slot = &e;
+            break;
+        }
+        if (e.lastUse < slot->lastUse)
+        {
+            slot = &e;
+        }
+    }
+    slot->path = path;
+    slot->exists = exists;
+    slot->lastUse = ++statCacheClock_;
+}
+
+void AstrOsStorageManager::statCacheForget(const std::string &path)
+{
+    for (StatCacheEntry &e : statCache_)
+    {
+        if (e.lastUse != 0 && e.path == path)
+        {
+            e.path.clear();
+            e.lastUse = 0;
+        }
+    }
+}
+
+void AstrOsStorageManager::closeReadHandle()
+{
+    if (readHandle_ != nullptr)
+    {
+        fclose(readHandle_);
+        readHandle_ = nullptr;
+    }
+    readHandlePath_.clear();
+}
+
 #pragma endregion SPIFFS
 #pragma region Utility
 
@@ -4,7 +4,11 @@
 #include <driver/i2c.h>
 
 #define I2C_PORT I2C_NUM_0
-#define I2C_FREQ_HZ 100 * 1000
+// Bus clock; build with -D I2C_FREQ_HZ=400000 (fast mode) or 1000000 (fast
+// mode plus) when every device on the bus supports it.
+#ifndef I2C_FREQ_HZ
+#define I2C_FREQ_HZ (100 * 1000)
+#endif
 
 #define ACK_CHECK_EN 0x1  /*!< I2C master will check ack from slave */
 #define ACK_CHECK_DIS 0x0 /*!< I2C master will not check ack from slave */
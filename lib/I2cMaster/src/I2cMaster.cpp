@@ -27,7 +27,7 @@ esp_err_t I2cMaster::Init(gpio_num_t sda, gpio_num_t scl)
     conf.scl_io_num = scl;
     conf.sda_pullup_en = GPIO_PULLUP_ENABLE;
     conf.scl_pullup_en = GPIO_PULLUP_ENABLE;
-    conf.master.clk_speed = 100000;
+    conf.master.clk_speed = I2C_FREQ_HZ;
     conf.clk_flags = 0;
 
     esp_err_t err = i2c_param_config(I2C_PORT, &conf);
@@ -10,6 +10,8 @@ private:
     std::vector<int> gpioChannels;
     std::vector<bool> defaults;
 
+    void setMasked(uint32_t setMask, uint32_t clearMask);
+
 public:
     GpioModule();
     ~GpioModule();
@@ -27,6 +27,8 @@ public:
     esp_err_t Init();
     void SendCommand(uint8_t *cmd);
     void WriteDisplay(uint8_t *cmd);
+    // Draws a display command on the OLED; runs on the I2C engine task.
+    void Draw(uint8_t *cmd);
 };
 
 extern I2cModule I2cMod;
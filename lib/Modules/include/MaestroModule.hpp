@@ -1,12 +1,16 @@
 #ifndef MAESTROMODULE_HPP
 #define MAESTROMODULE_HPP
 
+#include <AstrOsMaestroChannels.hpp>
+#include <AstrOsMaestroShadow.hpp>
+
 #include <esp_err.h>
 #include <hal/uart_types.h>
 #include <string>
 // needed for QueueHandle_t, must be in this order
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
+#include <freertos/semphr.h>
 
 #define BAUD_RATE_INDICATION 0xAA
 #define SET_SERVO_COMMAND 0x84
@@ -18,6 +22,11 @@
 #define GET_ERROR_COMMAND 0xA1
 #define HOME_COMMAND 0xA2
 
+// Slack on top of the wire time of a readback query and its reply.
+#define READBACK_MARGIN_MS 20
+
+class SerialModule;
+
 // speed is (.25us/10ms) * n, where n is 0-255
 // 0 is no speed limit
 // An extended range servo is 500-2500us at 180 degrees
@@ -43,18 +52,48 @@ private:
 
     QueueHandle_t serialQueue;
     SemaphoreHandle_t mutex;
+
+    // This controller's channels, sized to its model. Guarded by
+    // stateMutex, which is always taken before mutex: the servo queue task
+    // (QueueCommand), the shutdown timer (CheckServos) and config reloads
+    // (LoadConfig) all reach it.
+    AstrOsMaestro::ChannelTable channels;
+    // What was last sent to each channel, so a move carries only the
+    // commands that change something. Guarded by stateMutex.
+    AstrOsMaestro::ShadowRegisters shadow;
+    SemaphoreHandle_t stateMutex;
+    // Set when the controller's TX line is wired back to our RX (build with
+    // MAESTRO_READBACK); CheckServos then asks the controller where its
+    // servos are. Guarded by stateMutex.
+    SerialModule *readback;
     void SendCommand(uint8_t *cmd);
     void setServoPosition(uint8_t channel, int ms, int lastPos, int speed, int acceleration);
+    // Encodes a move into `out` (room for AstrOsMaestro::kMaxMoveBytes)
+    // and returns the byte count; positions in microseconds.
+    size_t encodeMove(uint8_t channel, int ms, int lastPos, int speed, int acceleration, uint8_t *out);
     void setServoOff(uint8_t channel);
-    int getServoPosition(uint8_t channel);
     void getError();
-    void sendQueueMsg(uint8_t cmd[], size_t size);
+    // Positions the controller reported for the channels powered at the
+    // time of the query, with each channel's generation then.
+    struct ReadbackSample
+    {
+        uint8_t chs[AstrOsMaestro::kMaxChannels];
+        uint16_t generations[AstrOsMaestro::kMaxChannels];
+        uint16_t positions[AstrOsMaestro::kMaxChannels];
+        size_t n;
+    };
+    // Queries the powered channels' positions. Takes stateMutex only to
+    // snapshot them, not across the UART round trip. false if readback
+    // isn't wired, nothing is powered or the reply never came.
+    bool readPositions(ReadbackSample &sample);
+    // false if the command never made it onto the serial queue
+    bool sendQueueMsg(uint8_t cmd[], size_t size);
 
 public:
-    MaestroModule(QueueHandle_t queue, int idx, int baud);
+    MaestroModule(QueueHandle_t queue, int idx, int baud, SerialModule *readback = nullptr);
     ~MaestroModule();
 
-    void UpdateConfig(QueueHandle_t queue, int baud);
+    void UpdateConfig(QueueHandle_t queue, int baud, SerialModule *readback = nullptr);
     void LoadConfig();
     void HomeServos();
     void QueueCommand(uint8_t *cmd);
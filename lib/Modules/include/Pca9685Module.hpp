@@ -0,0 +1,53 @@
+#ifndef PCA9685MODULE_HPP
+#define PCA9685MODULE_HPP
+
+#include <AstrOsPca9685Frame.hpp>
+#include <pca9685.hpp>
+
+#include <atomic>
+#include <esp_err.h>
+// needed for SemaphoreHandle_t, must be in this order
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Board n (script module n) answers at PCA9685_BASE_ADDRESS + n.
+#define PCA9685_BASE_ADDRESS 0x40
+
+// A PCA9685 as a servo backend: script moves (MODULE_TYPE::PCA9685, same
+// template as a Maestro move) set the channel's OFF count in a shadow
+// frame, and only the channels that changed are written, each run of
+// neighbouring channels as one auto-increment burst through the I2C
+// engine. No UART in the path, so a move reaches the servo within one I2C
+// write of the command.
+//
+// Every channel is a servo on 500-2500 us, home at 1500 us. The board has
+// no speed or acceleration control, so those fields are ignored.
+class Pca9685Module
+{
+private:
+    int idx;
+    uint8_t address;
+    Pca9685 board;
+
+    // Guards frame: the I2C / GPIO task moves servos, init homes them.
+    SemaphoreHandle_t mutex;
+    AstrOsPca9685::Frame frame;
+    // Set by a failed write on the I2C engine task; the next flush
+    // rewrites every channel.
+    std::atomic<bool> resync;
+
+    void flush();
+    static void writeDone(void *ctx, esp_err_t err);
+
+public:
+    Pca9685Module(int idx, uint8_t address);
+    ~Pca9685Module();
+
+    // Resets the board, sets it to 50 Hz (with `slop` prescale correction)
+    // and turns on register auto-increment. Synchronous.
+    esp_err_t Init(int slop);
+    void QueueCommand(uint8_t *cmd);
+    void HomeServos();
+};
+
+#endif
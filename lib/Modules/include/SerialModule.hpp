@@ -5,6 +5,8 @@
 
 #include <driver/uart.h>
 #include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <string>
 
 typedef struct
@@ -21,6 +23,9 @@ class SerialModule
 private:
     void SendData(int baud, const uint8_t *data, size_t size);
     esp_err_t InstallSerial(uart_port_t port, int tx, int rx, int baud);
+    // Drains the TX ring buffer before switching, so queued bytes go out at
+    // the rate they were written for. Caller holds mutex.
+    void SetBaudRate(int baud);
 
     uart_port_t port;
     int tx;
@@ -28,12 +33,25 @@ private:
     int defaultBaudrate;
     bool isMaster;
 
+    // Per channel, so a write to one UART never waits on another.
+    SemaphoreHandle_t mutex = NULL;
+    // The rate last set on the port; avoids a uart_get_baudrate() per send,
+    // which also reads back the divider's approximation of the rate rather
+    // than the rate requested.
+    uint32_t currentBaud = 0;
+
 public:
     SerialModule(/* args */);
     ~SerialModule();
     esp_err_t Init(serial_config_t cfig);
     void SendCommand(uint8_t *cmd);
     void SendBytes(int baud, uint8_t *data, size_t size);
+    // Writes `tx` and reads up to `rxSize` reply bytes into `rx` within
+    // `timeoutMs`, holding the channel so no other write lands in between.
+    // Pending output is drained and stale input discarded first, so
+    // `timeoutMs` covers only the round trip. Returns the bytes read, -1 on
+    // error.
+    int Query(int baud, const uint8_t *tx, size_t txSize, uint8_t *rx, size_t rxSize, int timeoutMs);
 };
 
 #endif
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include <driver/gpio.h>
 #include <esp_log.h>
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
 #include <string>
 #include <vector>
 
@@ -75,6 +77,12 @@ void GpioModule::SendCommand(uint8_t *cmd)
     auto command = GpioCommand(std::string(reinterpret_cast<char *>(cmd)));
     ESP_LOGI(TAG, "Sending Command => %s", cmd);
 
+    if (command.isMask)
+    {
+        this->setMasked(command.setMask, command.clearMask);
+        return;
+    }
+
     if (command.channel > this->gpioChannels.size())
     {
         ESP_LOGE(TAG, "invalid GPIO channel");
@@ -88,4 +96,46 @@ void GpioModule::SendCommand(uint8_t *cmd)
     }
 
     gpio_set_level(static_cast<gpio_num_t>(this->gpioChannels.at(command.channel)), command.state);
-}
\ No newline at end of file
+}
+
+/// @brief Drives every channel in setMask high and every channel in
+/// clearMask low at once. Channels are mapped to pins, then each output
+/// bank gets one write-1-to-set and one write-1-to-clear store, so all the
+/// edges land within a few APB cycles instead of one script event each.
+void GpioModule::setMasked(uint32_t setMask, uint32_t clearMask)
+{
+    // pins 0-31 and 32-39 (32-48 on the S3) are separate registers
+    uint32_t set[2] = {0, 0};
+    uint32_t clear[2] = {0, 0};
+
+    for (size_t i = 0; i < this->gpioChannels.size() && i < 32; i++)
+    {
+        const uint32_t bit = 1UL << i;
+        if (((setMask | clearMask) & bit) == 0)
+        {
+            continue;
+        }
+
+        const int pin = this->gpioChannels.at(i);
+        if (pin <= 0)
+        {
+            ESP_LOGW(TAG, "GPIO channel %d not available", static_cast<int>(i));
+            continue;
+        }
+
+        uint32_t *bank = (setMask & bit) ? set : clear;
+        bank[pin / 32] |= 1UL << (pin % 32);
+    }
+
+    const size_t count = this->gpioChannels.size();
+    const uint32_t known = count >= 32 ? UINT32_MAX : (1UL << count) - 1;
+    if (((setMask | clearMask) & ~known) != 0)
+    {
+        ESP_LOGW(TAG, "GPIO mask names channels past %d", static_cast<int>(count) - 1);
+    }
+
+    REG_WRITE(GPIO_OUT_W1TS_REG, set[0]);
+    REG_WRITE(GPIO_OUT_W1TC_REG, clear[0]);
+    REG_WRITE(GPIO_OUT1_W1TS_REG, set[1]);
+    REG_WRITE(GPIO_OUT1_W1TC_REG, clear[1]);
+}
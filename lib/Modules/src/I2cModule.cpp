@@ -1,6 +1,8 @@
 #include <AnimationCommands.hpp>
 #include <AstrOsDisplay.hpp>
+#include <AstrOsI2cEngine.hpp>
 #include <AstrOsUtility.h>
+#include <I2cMaster.hpp>
 #include <I2cModule.hpp>
 
 #include <driver/i2c.h>
@@ -10,11 +12,21 @@
 #include <freertos/semphr.h>
 #include <ssd1306.h>
 #include <sstream>
+#include <string.h>
 #include <string>
 
+#if defined(USE_I2C_OLED) && I2C_FREQ_HZ > 400000
+#error "The SSD1306 OLED runs at 400 kHz at most; lower I2C_FREQ_HZ or drop USE_I2C_OLED"
+#endif
+
 static const char *TAG = "I2cModule";
+// Guards the OLED between Init and the engine task, which draws on it
+// through Call jobs afterwards.
 static SemaphoreHandle_t i2cMutex = NULL;
 
+static void writeResult(void *ctx, esp_err_t err);
+static void drawDisplay(void *ctx);
+
 SSD1306_t oled;
 
 I2cModule I2cMod;
@@ -34,6 +46,12 @@ esp_err_t I2cModule::Init()
         return ESP_ERR_NO_MEM;
     }
 
+    result = I2cBus.Init(I2C_NUM_0);
+    if (result != ESP_OK)
+    {
+        return result;
+    }
+
 #ifdef USE_I2C_OLED
     oled._address = I2CAddress;
     oled._flip = false;
@@ -57,30 +75,52 @@ void I2cModule::SendCommand(uint8_t *cmd)
     I2cModule::write(command.channel, (uint8_t *)command.value.c_str(), command.value.size() + 1);
 }
 
+/// @brief Queues the write on the I2C engine and returns; the result is
+/// logged when the engine gets to it.
 esp_err_t I2cModule::write(uint8_t addr, uint8_t *data, size_t size)
 {
-    esp_err_t ret = ESP_OK;
-    if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(1000)) == pdTRUE)
+    if (!I2cBus.Write(addr, data, size, &writeResult, (void *)(uintptr_t)addr))
     {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (addr << 1) | WRITE_BIT, ACK_CHECK_EN);
-        i2c_master_write(cmd, data, size, ACK_CHECK_EN);
-        i2c_master_stop(cmd);
-        ret = i2c_master_cmd_begin(I2C_NUM_0, cmd, 1000 / portTICK_PERIOD_MS);
-        i2c_cmd_link_delete(cmd);
-        xSemaphoreGive(i2cMutex);
+        return ESP_ERR_TIMEOUT;
     }
-    else
+    return ESP_OK;
+}
+
+static void writeResult(void *ctx, esp_err_t err)
+{
+    if (err != ESP_OK)
     {
-        ESP_LOGE(TAG, "write: failed to acquire i2cMutex within 1s");
-        ret = ESP_ERR_TIMEOUT;
+        ESP_LOGE(TAG, "Write to I2C device 0x%02x failed: %s", (int)(uintptr_t)ctx, esp_err_to_name(err));
     }
-    return ret;
 }
 
+/// @brief Draws on the engine task, in the OLED's turn on the bus, so a
+/// display update no longer waits behind (or holds up) light-board writes.
 void I2cModule::WriteDisplay(uint8_t *cmd)
 {
+#ifdef USE_I2C_OLED
+    char *copy = strdup(reinterpret_cast<char *>(cmd));
+    if (copy == NULL)
+    {
+        ESP_LOGE(TAG, "Malloc display command fail");
+        return;
+    }
+
+    if (!I2cBus.Call(I2CAddress, &drawDisplay, copy))
+    {
+        free(copy);
+    }
+#endif
+}
+
+static void drawDisplay(void *ctx)
+{
+    I2cMod.Draw(reinterpret_cast<uint8_t *>(ctx));
+    free(ctx);
+}
+
+void I2cModule::Draw(uint8_t *cmd)
+{
 #ifdef USE_I2C_OLED
     auto command = DisplayCommand(std::string(reinterpret_cast<char *>(cmd)));
 
@@ -1,28 +1,28 @@
 #include "MaestroModule.hpp"
 
 #include <AnimationCommands.hpp>
+#include <AstrOsMaestroReadback.hpp>
+#include <AstrOsPooledQueue.hpp>
 #include <AstrOsStorageManager.hpp>
 #include <AstrOsUtility.h>
-
-#include <AstrOsServoUtils.hpp>
-#include <AstrOsUtility.h>
 #include <AstrOsUtility_ESP.h>
 #include <SerialModule.hpp>
+#include <algorithm>
 #include <driver/uart.h>
 #include <esp_log.h>
 #include <esp_system.h>
 #include <string.h>
+#include <vector>
 
 static const char *TAG = "MaestroModule";
-static const int RX_BUF_SIZE = 1024;
-
-servo_channel channels[24] = {};
 
-MaestroModule::MaestroModule(QueueHandle_t serialQueue, int idx, int baudRate)
+MaestroModule::MaestroModule(QueueHandle_t serialQueue, int idx, int baudRate, SerialModule *readback)
 {
+    this->readback = readback;
 
     this->mutex = xSemaphoreCreateMutex();
-    if (this->mutex == NULL)
+    this->stateMutex = xSemaphoreCreateMutex();
+    if (this->mutex == NULL || this->stateMutex == NULL)
     {
         ESP_LOGE(TAG, "Failed to create mutex");
         return;
@@ -36,7 +36,7 @@ MaestroModule::MaestroModule(QueueHandle_t serialQueue, int idx, int baudRate)
 
 MaestroModule::~MaestroModule() {}
 
-void MaestroModule::UpdateConfig(QueueHandle_t serialQueue, int baudRate)
+void MaestroModule::UpdateConfig(QueueHandle_t serialQueue, int baudRate, SerialModule *readback)
 {
     bool configChanged = false;
 
@@ -60,6 +60,12 @@ void MaestroModule::UpdateConfig(QueueHandle_t serialQueue, int baudRate)
             vTaskDelay(10 / portTICK_PERIOD_MS);
         }
     }
+
+    // The controller may have been swapped or reset along with the config.
+    xSemaphoreTake(this->stateMutex, portMAX_DELAY);
+    this->shadow.invalidateAll();
+    this->readback = readback;
+    xSemaphoreGive(this->stateMutex);
 }
 
 void MaestroModule::LoadConfig()
@@ -68,7 +74,19 @@ void MaestroModule::LoadConfig()
 
     ESP_LOGI(TAG, "Loading Maestro servos for module %d", this->idx);
 
-    AstrOs_Storage.loadMaestroServos(this->idx, channels, 24);
+    std::vector<servo_channel> servos;
+    if (!AstrOs_Storage.loadMaestroServos(this->idx, servos))
+    {
+        servos.clear();
+    }
+
+    xSemaphoreTake(this->stateMutex, portMAX_DELAY);
+    this->channels.load(servos.data(), servos.size());
+    this->shadow.reset(this->channels.size());
+    xSemaphoreGive(this->stateMutex);
+
+    ESP_LOGI(TAG, "Maestro module %d: %d channels configured, %d-channel model", this->idx, (int)servos.size(),
+             this->channels.size());
 
     this->HomeServos();
 
@@ -80,45 +98,28 @@ void MaestroModule::QueueCommand(uint8_t *cmd)
     ESP_LOGI(TAG, "Queueing servo command => %s", cmd);
     MaestroCommand servoCmd = MaestroCommand(std::string(reinterpret_cast<char *>(cmd)));
 
-    if (servoCmd.channel > 23 || servoCmd.channel < 0)
+    xSemaphoreTake(this->stateMutex, portMAX_DELAY);
+
+    if (!this->channels.contains(servoCmd.channel))
     {
-        ESP_LOGE(TAG, "Invalid channel %d", servoCmd.channel);
+        xSemaphoreGive(this->stateMutex);
+        ESP_LOGE(TAG, "Invalid channel %d for module %d", servoCmd.channel, this->idx);
         return;
     }
 
-    int ch = servoCmd.channel;
+    uint8_t ch = servoCmd.channel;
 
     // set channel requested position to percentage of max - min taking into account inverted
-    int requestPos = servoCmd.position;
-
-    // if it's not a servo it's an on/off GPIO
-    if (!channels[ch].isServo)
-    {
-        channels[ch].requestedPos = requestPos >= 1500 ? 2500 : 500;
-    }
-    else if (requestPos < 0)
-    {
-        channels[ch].requestedPos = channels[ch].home;
-    }
-    else
-    {
-        if (channels[ch].inverted)
-        {
-            requestPos = 100 - requestPos;
-        }
-        channels[ch].requestedPos = GetRelativeRequestedPosition(channels[ch].minPos, channels[ch].maxPos, requestPos);
-    }
+    int target = this->channels.request(ch, servoCmd.position, servoCmd.speed, servoCmd.acceleration);
 
     ESP_LOGI(TAG, "Setting servo %d (min: %d, max: %d) to %d, cmd: %d. speed: %d. accel: %d. inverted: %d", ch,
-             channels[ch].minPos, channels[ch].maxPos, channels[ch].requestedPos, servoCmd.position, servoCmd.speed,
-             servoCmd.acceleration, channels[ch].inverted);
+             this->channels.minPos(ch), this->channels.maxPos(ch), target, servoCmd.position, servoCmd.speed,
+             servoCmd.acceleration, this->channels.inverted(ch));
 
-    channels[ch].currentPos = 0;
-    channels[ch].speed = servoCmd.speed;
-    channels[ch].acceleration = servoCmd.acceleration;
-    channels[ch].on = true;
+    this->setServoPosition(ch, target, this->channels.lastPos(ch), this->channels.speed(ch),
+                           this->channels.acceleration(ch));
 
-    this->setServoPosition(ch, channels[ch].requestedPos, channels[ch].lastPos, servoCmd.speed, servoCmd.acceleration);
+    xSemaphoreGive(this->stateMutex);
 }
 
 void MaestroModule::SetServoPosition(uint8_t channel, int ms)
@@ -128,155 +129,198 @@ void MaestroModule::SetServoPosition(uint8_t channel, int ms)
         return;
     }
 
+    xSemaphoreTake(this->stateMutex, portMAX_DELAY);
     this->setServoPosition(channel, ms, -1, 0, 0);
+    xSemaphoreGive(this->stateMutex);
 }
 
 void MaestroModule::Panic()
 {
     ESP_LOGI(TAG, "Panic");
 
-    uint8_t cmd[74] = {};
+    xSemaphoreTake(this->stateMutex, portMAX_DELAY);
+
+    this->channels.powerOffAll();
+
+    // Before a config load the model is unknown: stop all 24.
+    const uint8_t count = this->channels.size() == 0 ? AstrOsMaestro::kMaxChannels : this->channels.size();
+    const size_t size = 2 + count * 3;
+
+    uint8_t cmd[2 + AstrOsMaestro::kMaxChannels * 3] = {};
     cmd[0] = SET_MULTIPLE_SERVOS_COMMAND;
-    cmd[1] = 24;
+    cmd[1] = count;
 
-    for (size_t i = 0; i < 24; i++)
+    for (uint8_t i = 0; i < count; i++)
     {
-        channels[i].on = false;
         cmd[2 + (i * 3)] = i;
     }
 
-    this->sendQueueMsg(cmd, 74);
+    if (this->sendQueueMsg(cmd, size))
+    {
+        this->shadow.allOff(count);
+    }
+    else
+    {
+        this->shadow.invalidateAll();
+    }
+
+    xSemaphoreGive(this->stateMutex);
 }
 
 void MaestroModule::HomeServos()
 {
     ESP_LOGI(TAG, "Homing Servos");
 
-    for (size_t i = 0; i < 24; i++)
+    // Every channel's commands go out as one UART write.
+    uint8_t cmd[AstrOsMaestro::kMaxChannels * AstrOsMaestro::kMaxMoveBytes];
+    size_t size = 0;
+
+    xSemaphoreTake(this->stateMutex, portMAX_DELAY);
+
+    for (uint8_t i = 0; i < this->channels.size(); i++)
     {
-        if (channels[i].enabled)
+        if (!this->channels.enabled(i))
         {
-            if (!channels[i].isServo)
-            {
-                if (channels[i].inverted)
-                {
-                    this->setServoPosition(i, 2500, 0, 0, 0);
-                }
-                else
-                {
-                    this->setServoPosition(i, 500, 0, 0, 0);
-                }
-            }
-            else
-            {
+            continue;
+        }
 
-                channels[i].requestedPos = channels[i].home;
-                channels[i].currentPos = 0;
-                channels[i].on = true;
-                channels[i].speed = 0;
-                channels[i].acceleration = 0;
-                this->setServoPosition(i, channels[i].home, 0, 0, 0);
-                channels[i].lastPos = channels[i].home;
-            }
+        if (!this->channels.isServo(i))
+        {
+            size += this->encodeMove(i, this->channels.inverted(i) ? 2500 : 500, 0, 0, 0, cmd + size);
+        }
+        else
+        {
+            this->channels.home(i);
+            size += this->encodeMove(i, this->channels.homePos(i), 0, 0, 0, cmd + size);
         }
     }
+
+    if (size > 0 && !this->sendQueueMsg(cmd, size))
+    {
+        this->shadow.invalidateAll();
+    }
+
+    xSemaphoreGive(this->stateMutex);
 }
 
-/// @brief Since we can't really know where the servo is actually at
-/// and we don't want to keep the servo on all the time, we need to
-/// see if the servo could have moved it's entire range in the time
-/// since the last command. If it could have, we need to turn it off.
+/// @brief We don't want to keep the servos on all the time. With readback
+/// wired, a servo is turned off once the controller reports it settled at
+/// its target. Otherwise, or if the controller doesn't answer, it is turned
+/// off once it could have moved its entire range since its last command
+/// (a deadline per channel; only the due ones are visited).
 /// @param msSinceLastCheck The time since the last check in milliseconds
 void MaestroModule::CheckServos(int msSinceLastCheck)
 {
-    for (size_t i = 0; i < 24; i++)
-    {
-        if (!channels[i].isServo)
-        {
-            continue;
-        }
-        if (channels[i].on)
-        {
-            // speed is (.25us/10ms) * n, where n is 0-255
-            // 0 is no speed limit
-            // An extended range servo is 500-2500us at 180 degrees
-            // to give us some buffer, we will calculate 0 to 3000 us
-            // if accel is less than speed, we will use accel to account for
-            // slower start and stop
-            // UPDATE: increase the timeout to accomidate linear acuators Doug is using
-            // being slow as fuck to react to changes
-            double speed = channels[i].speed == 0 ? 255 : channels[i].speed;
-            if (channels[i].acceleration < speed && channels[i].acceleration != 0)
-            {
-                speed = channels[i].acceleration;
-            }
+    uint8_t off[AstrOsMaestro::kMaxChannels];
+    size_t count = 0;
 
-            channels[i].currentPos = channels[i].currentPos + (((.25 * speed) * (msSinceLastCheck / 100)) / 4);
+    // The query runs unlocked, so moves and Panic don't wait behind it.
+    ReadbackSample sample;
+    const bool readBack = this->readPositions(sample);
 
-            if (channels[i].currentPos >= 3000)
-            {
-                ESP_LOGI(TAG, "Turning off servo %d", i);
-                this->setServoOff(i);
-                channels[i].on = false;
-                channels[i].currentPos = 0;
-            }
-        }
+    xSemaphoreTake(this->stateMutex, portMAX_DELAY);
+
+    if (readBack)
+    {
+        count = this->channels.checkReadback(sample.chs, sample.generations, sample.positions, sample.n, off);
     }
+    count += this->channels.checkIdle(msSinceLastCheck, off + count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        ESP_LOGI(TAG, "Turning off servo %d", off[i]);
+        this->setServoOff(off[i]);
+    }
+
+    xSemaphoreGive(this->stateMutex);
 }
 
-void MaestroModule::setServoPosition(uint8_t channel, int ms, int lastpos, int speed, int acceleration)
+bool MaestroModule::readPositions(ReadbackSample &sample)
 {
-    uint8_t cmd[4] = {};
+    xSemaphoreTake(this->stateMutex, portMAX_DELAY);
 
-    cmd[1] = channel;
+    SerialModule *port = this->readback;
+    const int baud = this->baudRate;
+    sample.n = port == nullptr ? 0 : this->channels.activeChannels(sample.chs);
+    for (size_t i = 0; i < sample.n; i++)
+    {
+        sample.generations[i] = this->channels.generation(sample.chs[i]);
+    }
 
-    // we need to send the last requested position
-    // before we send speed/accel commands if the servo
-    // was set to off as these commands will not work
-    // if they happen before the servo is turned on
-    if (lastpos != -1)
+    xSemaphoreGive(this->stateMutex);
+
+    if (sample.n == 0)
     {
-        cmd[0] = SET_SERVO_COMMAND;
-        cmd[2] = lastpos & 0x7F;
-        cmd[3] = (lastpos >> 7) & 0x7F;
+        return false;
+    }
 
-        this->sendQueueMsg(cmd, 4);
+    uint8_t query[AstrOsMaestro::queryBytes(AstrOsMaestro::kMaxChannels)];
+    uint8_t reply[AstrOsMaestro::replyBytes(AstrOsMaestro::kMaxChannels)];
+
+    const size_t queryLen = AstrOsMaestro::encodePositionQuery(sample.chs, sample.n, query);
+    const size_t replyLen = AstrOsMaestro::replyBytes(sample.n);
+
+    // 10 bits a byte each way; at most ~100 ms for 24 channels at 9600.
+    // Query drains what is already on the port first, so this only has to
+    // cover the round trip.
+    const int timeoutMs = (int)((queryLen + replyLen) * 10 * 1000 / std::max(baud, 1)) + READBACK_MARGIN_MS;
+
+    // Goes straight to the port, possibly ahead of moves still on the
+    // serial queue; those channels read back away from their new target
+    // and are left on.
+    const int rxBytes = port->Query(baud, query, queryLen, reply, replyLen, timeoutMs);
+
+    bool anyMoving = false;
+    if (rxBytes < 0 || !AstrOsMaestro::parsePositionReply(reply, rxBytes, sample.n, sample.positions, &anyMoving))
+    {
+        ESP_LOGW(TAG, "Maestro module %d: no position readback (%d bytes), using idle deadlines", this->idx, rxBytes);
+        return false;
     }
 
-    cmd[0] = SET_SERVO_SPEED_COMMAND;
-    cmd[2] = speed & 0x7F;
-    cmd[3] = (speed >> 7) & 0x7F;
+    ESP_LOGD(TAG, "Maestro module %d: %d channels read back, moving: %d", this->idx, (int)sample.n, anyMoving);
 
-    this->sendQueueMsg(cmd, 4);
+    return true;
+}
 
-    cmd[0] = SET_SERVO_ACCELERATION_COMMAND;
-    cmd[2] = acceleration & 0x7F;
-    cmd[3] = (acceleration >> 7) & 0x7F;
+void MaestroModule::setServoPosition(uint8_t channel, int ms, int lastPos, int speed, int acceleration)
+{
+    uint8_t cmd[AstrOsMaestro::kMaxMoveBytes];
+    const size_t size = this->encodeMove(channel, ms, lastPos, speed, acceleration, cmd);
 
-    this->sendQueueMsg(cmd, 4);
+    // What the shadow recorded never reached the controller.
+    if (!this->sendQueueMsg(cmd, size))
+    {
+        this->shadow.invalidate(channel);
+        return;
+    }
 
-    // .25us resolution
-    int target = ms * 4;
+    ESP_LOGD(TAG, "%d command bytes sent to channel: %d", (int)size, channel);
+}
 
-    cmd[0] = SET_SERVO_COMMAND;
-    cmd[2] = target & 0x7F;
-    cmd[3] = (target >> 7) & 0x7F;
+size_t MaestroModule::encodeMove(uint8_t channel, int ms, int lastPos, int speed, int acceleration, uint8_t *out)
+{
+    // .25us resolution, 14 bits on the wire
+    auto quarterUs = [](int us) { return (uint16_t)std::clamp(us * 4, 0, 0x3FFF); };
+    auto clamp14 = [](int v) { return (uint16_t)std::clamp(v, 0, 0x3FFF); };
 
-    this->sendQueueMsg(cmd, 4);
+    // we need to send the last requested position
+    // before we send speed/accel commands if the servo
+    // was set to off as these commands will not work
+    // if they happen before the servo is turned on
+    const uint16_t wake = lastPos > 0 ? quarterUs(lastPos) : 0;
 
-    ESP_LOGD(TAG, "command sent to channel: %d", channel);
+    return this->shadow.move(channel, quarterUs(ms), clamp14(speed), clamp14(acceleration), wake, out);
 }
 
 void MaestroModule::setServoOff(uint8_t channel)
 {
-    uint8_t cmd[4] = {};
-
-    cmd[0] = SET_SERVO_COMMAND;
-    cmd[1] = channel;
-    cmd[2] = 0x00;
-    cmd[3] = 0x00;
+    uint8_t cmd[4];
+    const size_t size = this->shadow.off(channel, cmd);
 
-    this->sendQueueMsg(cmd, 4);
+    if (!this->sendQueueMsg(cmd, size))
+    {
+        this->shadow.invalidate(channel);
+    }
 }
 
 void MaestroModule::getError()
@@ -288,26 +332,33 @@ void MaestroModule::getError()
     this->sendQueueMsg(cmd, 1);
 }
 
-void MaestroModule::sendQueueMsg(uint8_t cmd[], size_t size)
+bool MaestroModule::sendQueueMsg(uint8_t cmd[], size_t size)
 {
     queue_serial_msg_t msg;
 
     msg.message_id = 1;
     msg.baudrate = this->baudRate;
-    msg.data = (uint8_t *)malloc(size);
+    AstrOsBlockPool::Buffer payload(size);
+    msg.data = payload.data();
+    if (msg.data == NULL)
+    {
+        ESP_LOGE(TAG, "Malloc serial command fail");
+        return false;
+    }
     memcpy(msg.data, cmd, size);
     msg.dataSize = size;
 
     bool sent = false;
+    bool queued = false;
 
     while (!sent)
     {
         if (xSemaphoreTake(this->mutex, 100 / portTICK_PERIOD_MS))
         {
-            if (xQueueSend(this->serialQueue, &msg, pdMS_TO_TICKS(500)) != pdTRUE)
+            queued = sendPooled(this->serialQueue, msg, payload, pdMS_TO_TICKS(500));
+            if (!queued)
             {
                 ESP_LOGW(TAG, "Send serial queue fail");
-                free(msg.data);
             }
             sent = true;
             xSemaphoreGive(this->mutex);
@@ -317,4 +368,6 @@ void MaestroModule::sendQueueMsg(uint8_t cmd[], size_t size)
             vTaskDelay(10 / portTICK_PERIOD_MS); // wait a bit before retrying
         }
     }
+
+    return queued;
 }
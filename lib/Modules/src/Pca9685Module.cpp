@@ -0,0 +1,108 @@
+#include "Pca9685Module.hpp"
+
+#include <AnimationCommands.hpp>
+#include <AstrOsI2cEngine.hpp>
+#include <AstrOsServoUtils.hpp>
+#include <I2cMaster.hpp>
+
+#include <esp_log.h>
+#include <string>
+
+static const char *TAG = "Pca9685Module";
+
+static const int HOME_US = 1500;
+
+Pca9685Module::Pca9685Module(int idx, uint8_t address) : resync(false)
+{
+    this->idx = idx;
+    this->address = address;
+
+    this->mutex = xSemaphoreCreateMutex();
+    if (this->mutex == NULL)
+    {
+        ESP_LOGE(TAG, "Failed to create mutex");
+    }
+}
+
+Pca9685Module::~Pca9685Module() {}
+
+esp_err_t Pca9685Module::Init(int slop)
+{
+    if (this->mutex == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // MODE1 ends up 0xA0: restart, auto-increment on.
+    return this->board.Init(i2cMaster, this->address, AstrOsPca9685::kServoFreqHz, slop);
+}
+
+void Pca9685Module::QueueCommand(uint8_t *cmd)
+{
+    ESP_LOGD(TAG, "Queueing servo command => %s", cmd);
+    MaestroCommand servoCmd = MaestroCommand(std::string(reinterpret_cast<char *>(cmd)));
+
+    if (servoCmd.channel < 0 || servoCmd.channel >= AstrOsPca9685::kChannels)
+    {
+        ESP_LOGE(TAG, "Invalid channel %d for PCA9685 module %d", servoCmd.channel, this->idx);
+        return;
+    }
+
+    // percentage of min..max, home when negative
+    const int us = servoCmd.position < 0
+                       ? HOME_US
+                       : GetRelativeRequestedPosition(AstrOsPca9685::kServoMinUs, AstrOsPca9685::kServoMaxUs,
+                                                      servoCmd.position);
+
+    xSemaphoreTake(this->mutex, portMAX_DELAY);
+    this->frame.set(servoCmd.channel, AstrOsPca9685::pulseTicks(us));
+    this->flush();
+    xSemaphoreGive(this->mutex);
+}
+
+void Pca9685Module::HomeServos()
+{
+    ESP_LOGI(TAG, "Homing PCA9685 module %d", this->idx);
+
+    xSemaphoreTake(this->mutex, portMAX_DELAY);
+    for (uint8_t ch = 0; ch < AstrOsPca9685::kChannels; ch++)
+    {
+        this->frame.set(ch, AstrOsPca9685::pulseTicks(HOME_US));
+    }
+    this->flush();
+    xSemaphoreGive(this->mutex);
+}
+
+/// @brief Queues a write for every run of changed channels. Caller holds
+/// mutex.
+void Pca9685Module::flush()
+{
+    if (this->resync.exchange(false))
+    {
+        this->frame.invalidate();
+    }
+
+    uint8_t data[AstrOsPca9685::kChannels * AstrOsPca9685::kBytesPerChannel];
+    AstrOsPca9685::ChannelRun run;
+
+    while (this->frame.nextRun(run))
+    {
+        const size_t size = this->frame.encode(run, data);
+        if (!I2cBus.WriteRegisters(this->address, run.reg(), data, size, &Pca9685Module::writeDone, this))
+        {
+            this->resync = true;
+        }
+    }
+}
+
+void Pca9685Module::writeDone(void *ctx, esp_err_t err)
+{
+    if (err == ESP_OK)
+    {
+        return;
+    }
+
+    Pca9685Module *self = static_cast<Pca9685Module *>(ctx);
+    ESP_LOGW(TAG, "PCA9685 module %d write failed: %s", self->idx, esp_err_to_name(err));
+    self->resync = true;
+}
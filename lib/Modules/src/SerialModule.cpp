@@ -10,9 +10,16 @@
 #include <string>
 
 static const char *TAG = "SerialModule";
-static SemaphoreHandle_t serialMutex;
 
 static const int RX_BUF_SIZE = 1024;
+// uart_write_bytes() copies into this ring and returns; the driver's ISR
+// feeds the FIFO. It only blocks once the ring is full, so a Maestro burst
+// or a Kangaroo command no longer holds the sending task for the time it
+// takes to shift out (about 1 ms per byte at 9600 baud).
+static const int TX_BUF_SIZE = 1024;
+// Longest a baud-rate switch or a query waits for the ring to drain: a
+// full ring at 9600 baud, with margin.
+static const int BAUD_SWITCH_DRAIN_MS = 2000;
 
 SerialModule SerialMod;
 
@@ -24,8 +31,11 @@ esp_err_t SerialModule::Init(serial_config_t cfig)
 {
     esp_err_t result = ESP_OK;
 
-    serialMutex = xSemaphoreCreateMutex();
-    if (serialMutex == NULL)
+    if (this->mutex == NULL)
+    {
+        this->mutex = xSemaphoreCreateMutex();
+    }
+    if (this->mutex == NULL)
     {
         ESP_LOGE(TAG, "Failed to initialize the serial mutex for port %d", cfig.port);
         return ESP_FAIL;
@@ -44,6 +54,8 @@ esp_err_t SerialModule::Init(serial_config_t cfig)
         return result;
     }
 
+    this->currentBaud = (uint32_t)defaultBaudrate;
+
     return result;
 }
 
@@ -75,7 +87,7 @@ esp_err_t SerialModule::InstallSerial(uart_port_t port, int tx, int rx, int baud
         return err;
     }
 
-    uart_driver_install(port, RX_BUF_SIZE * 2, 0, 0, NULL, 0);
+    err = uart_driver_install(port, RX_BUF_SIZE * 2, TX_BUF_SIZE, 0, NULL, 0);
     logError(TAG, __FUNCTION__, __LINE__, err);
 
     return err;
@@ -98,51 +110,76 @@ void SerialModule::SendBytes(int baud, uint8_t *data, size_t size)
 
 void SerialModule::SendData(int baud, const uint8_t *data, size_t size)
 {
-    bool sent = false;
+    xSemaphoreTake(this->mutex, portMAX_DELAY);
+
+    // don't change the baud rate if this is the master node
+    if (!this->isMaster && this->currentBaud != (uint32_t)baud)
+    {
+        SerialModule::SetBaudRate(baud);
+    }
 
-    while (!sent)
+    const int txBytes = uart_write_bytes(port, data, size);
+    if (txBytes < 0)
+    {
+        ESP_LOGE(TAG, "Serial port %d - Failed to queue %u bytes", this->port, (unsigned int)size);
+    }
+    else
     {
-        if (xSemaphoreTake(serialMutex, 100 / portTICK_PERIOD_MS))
-        {
-            // don't change the baud rate if this is the master node
-            if (!this->isMaster)
-            {
-
-                uint32_t currentBaud = 0;
-
-                auto err = uart_get_baudrate(port, &currentBaud);
-
-                if (logError(TAG, __FUNCTION__, __LINE__, err))
-                {
-                    ESP_LOGE(TAG, "Serial port %d - Failed to get baudrate!", this->port);
-                }
-                else if (currentBaud != (uint32_t)baud)
-                {
-                    err = uart_set_baudrate(port, (uint32_t)baud);
-
-                    if (logError(TAG, __FUNCTION__, __LINE__, err))
-                    {
-                        ESP_LOGE(TAG, "Serial port %d - Failed to set baudrate %d!", this->port, baud);
-                    }
-                    else
-                    {
-                        auto err = uart_get_baudrate(port, &currentBaud);
-                        if (logError(TAG, __FUNCTION__, __LINE__, err))
-                        {
-                            ESP_LOGE(TAG, "Serial port %d - Failed to get baudrate after setting it!", this->port);
-                        }
-                    }
-                }
-            }
-
-            const int txBytes = uart_write_bytes(port, data, size);
-            ESP_LOGD(TAG, "Wrote %d bytes", txBytes);
-            sent = true;
-            xSemaphoreGive(serialMutex);
-        }
-        else
-        {
-            vTaskDelay(10 / portTICK_PERIOD_MS);
-        }
+        ESP_LOGD(TAG, "Wrote %d bytes", txBytes);
     }
+
+    xSemaphoreGive(this->mutex);
+}
+
+int SerialModule::Query(int baud, const uint8_t *tx, size_t txSize, uint8_t *rx, size_t rxSize, int timeoutMs)
+{
+    xSemaphoreTake(this->mutex, portMAX_DELAY);
+
+    // Let earlier writes go out first, so the timeout is only the round
+    // trip and any reply they draw arrives before the input is flushed.
+    if (uart_wait_tx_done(port, pdMS_TO_TICKS(BAUD_SWITCH_DRAIN_MS)) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Serial port %d - TX not drained before query", this->port);
+        xSemaphoreGive(this->mutex);
+        return -1;
+    }
+
+    if (!this->isMaster && this->currentBaud != (uint32_t)baud)
+    {
+        SerialModule::SetBaudRate(baud);
+    }
+
+    uart_flush_input(port);
+
+    int rxBytes = -1;
+    if (uart_write_bytes(port, tx, txSize) < 0)
+    {
+        ESP_LOGE(TAG, "Serial port %d - Failed to queue %u query bytes", this->port, (unsigned int)txSize);
+    }
+    else
+    {
+        rxBytes = uart_read_bytes(port, rx, rxSize, pdMS_TO_TICKS(timeoutMs));
+    }
+
+    xSemaphoreGive(this->mutex);
+
+    return rxBytes;
+}
+
+void SerialModule::SetBaudRate(int baud)
+{
+    if (uart_wait_tx_done(port, pdMS_TO_TICKS(BAUD_SWITCH_DRAIN_MS)) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Serial port %d - TX not drained before baud change to %d", this->port, baud);
+    }
+
+    auto err = uart_set_baudrate(port, (uint32_t)baud);
+
+    if (logError(TAG, __FUNCTION__, __LINE__, err))
+    {
+        ESP_LOGE(TAG, "Serial port %d - Failed to set baudrate %d!", this->port, baud);
+        return;
+    }
+
+    this->currentBaud = (uint32_t)baud;
 }
@@ -3,11 +3,15 @@
 
 #include <AstrOsBulkTransport.hpp>
 #include <AstrOsEspNowProtocol.hpp>
+#include <AstrOsOtaMerkle.hpp>
+#include <AstrOsOtaReadAhead.hpp>
 #include <OtaForwarderQueueMessage.h>
 
 #include <atomic>
 #include <cstdint>
 #include <cstdio>
+#include <ctime>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -59,6 +63,10 @@ public:
         return otaForwarderQueue_;
     }
 
+    // BulkSender ACK timeout, tuned with kWindowSize (see there). Public so
+    // OtaWriter can keep its flash stall timeout below it.
+    static constexpr uint32_t kAckTimeoutMs = 1500;
+
 private:
     // State machine (single in-flight transfer; sequential per-padawan).
     enum class Phase : uint8_t
@@ -107,6 +115,29 @@ private:
     void emitOtaBeginFrame();
     void emitOtaEndFrame();
     void streamDrain(uint64_t nowMs); // for each SEND from BulkSender::nextChunkToSend, read+emit OTA_DATA
+    // Loads wire bytes [offset, offset + len) for an OTA_DATA frame — the
+    // staged file itself, or its Merkle framed stream. Returns nullptr on
+    // success, else the FW_DEPLOY_DONE failure reason (firmware_seek_failed
+    // / firmware_read_short).
+    const char *readWireBytes(uint32_t offset, uint8_t *out, uint32_t len);
+    // Staged-file bytes through imageCache_; same return convention.
+    const char *readFirmware(uint32_t offset, uint8_t *out, size_t len);
+    // StreamEncoder's data source — arg is `this`.
+    static bool merkleReadCb(void *arg, uint32_t offset, uint8_t *out, size_t len);
+    // imageCache_'s IO: fseek + fread on firmwareFile_, timed into the
+    // cache stats. arg is `this`.
+    static bool fileReadCb(void *arg, uint32_t offset, uint8_t *out, size_t len);
+    const char *readFile(uint32_t offset, uint8_t *out, size_t len);
+    // Points imageCache_ at the staged file, keeping it (and a resident
+    // copy) when it is the same file the previous padawan got.
+    void prepareImageCache(const std::string &path, uint32_t size, time_t mtime);
+    void releaseImageCache();
+    // The one pass over the staged file before OTA_BEGIN: file SHA-256
+    // into outSha and, when merkleLeaves_ is allocated, the leaf table.
+    bool scanFirmware(uint8_t outSha[32]);
+    // Sizes the wire stream (Merkle-framed or plain) and (re)starts bulk_
+    // for it. False if BulkSender rejects the geometry.
+    bool beginWireStream(bool merkle);
 
     // Posts a synthetic timeout sentinel (xferId=0xFF, reason/status=0xFF)
     // of the given kind into otaForwarderQueue_. Used by the timer
@@ -166,10 +197,27 @@ private:
     // order. Called from handleLocalFlashResult (OK and FAILED paths).
     void insertMasterRow(PadawanStatus status, const std::string &finalVersion, const std::string &errorReason);
     // Computes SHA-256 of a file on disk. Returns false on fopen/fread
-    // failure. Used by startNextPadawan (for padawan deploy) and
-    // startMasterSelfFlash (for master self-flash).
+    // failure. Used by startMasterSelfFlash; padawan deploys hash through
+    // imageCache_ (scanFirmware) instead.
     bool computeFileSha256(const std::string &path, uint8_t outSha[32]) const;
 
+    // What a staged file's leading bytes say about it. flags are the
+    // OTA_BEGIN_FLAG_* bits to announce (COMPRESSED and/or DELTA); for an
+    // encoded file imageSha256 is the digest of the image the receiver
+    // rebuilds, taken from the stream headers, and replaces the file SHA in
+    // OTA_BEGIN/END. version is the expected post-reboot version, empty when
+    // it can't be determined (version-confirm then falls back to timeout).
+    struct StagedFirmwareInfo
+    {
+        uint8_t flags = 0;
+        uint8_t imageSha256[32] = {0};
+        std::string version;
+    };
+    // Reads only the file's first few hundred bytes; a compressed file's
+    // prefix is inflated just far enough to see the inner header. Unreadable
+    // or unrecognised files classify as a plain image with no version.
+    StagedFirmwareInfo inspectStagedFirmware(const std::string &path) const;
+
     // Phase A — AWAITING_VERSION_CONFIRMED machinery.
     bool versionConfirmTimerStart();
     void versionConfirmTimerStop();
@@ -255,7 +303,6 @@ private:
     // on a 1.27 MB image. Smaller window bounds in-flight airtime; longer
     // timeout stops retransmitting chunks still being flashed.
     static constexpr uint8_t kWindowSize = 4;
-    static constexpr uint32_t kAckTimeoutMs = 1500;
     static constexpr uint8_t kMaxRetries = 3;
 
     // Hard upper bound on the order list size. Must stay well below 254 so
@@ -293,6 +340,42 @@ private:
     uint32_t firmwareTotalSize_ = 0;
     uint32_t firmwareTotalChunks_ = 0;
     uint8_t firmwareSha256_[32] = {0};
+    // OTA_BEGIN_FLAG_* for the staged file (see inspectStagedFirmware). When
+    // non-zero, firmwareSha256_ holds the decoded image's digest, not the
+    // file digest.
+    uint8_t firmwareFlags_ = 0;
+
+    // Merkle-verified transfer (OTA_BEGIN_FLAG_MERKLE). firmwareTotalSize_
+    // stays the file size; wireTotalSize_ is what OTA_DATA actually carries
+    // (the framed stream while merkleOn_, the file otherwise). The leaf
+    // table is heap-allocated per padawan (32 B per 4 KB block); if that
+    // allocation fails the transfer just goes out plain. A padawan that
+    // predates the flag never ACKs the longer BEGIN, so the first BEGIN_ACK
+    // timeout with merkleOn_ retries once with a plain BEGIN.
+    static constexpr uint8_t kMerkleBlockLog2 = AstrOsOtaMerkle::kDefaultBlockLog2;
+    bool merkleOn_ = false;
+    uint32_t wireTotalSize_ = 0;
+    std::unique_ptr<uint8_t[]> merkleLeaves_;
+    AstrOsOtaMerkle::Geometry merkleGeo_;
+    AstrOsOtaMerkle::StreamEncoder merkleEnc_;
+    uint8_t merkleRoot_[32] = {0};
+    const char *merkleReadFailure_ = nullptr; // merkleReadCb's failure reason
+
+    // Read-ahead over the staged file (AstrOsOtaReadAhead), so OTA_DATA
+    // frames and retransmits are served from RAM instead of one SD seek +
+    // read each. Deploy-scoped: kept across padawans while the staged file
+    // is unchanged and released in emitDeployDoneAndReset. Storage, best
+    // first: the whole file in PSRAM (resident — read from SD once per
+    // deploy), kCacheWindowSlots internal-RAM blocks, or cacheFallback_.
+    static constexpr uint32_t kCacheBlockSize = 4096;
+    static constexpr uint8_t kCacheWindowSlots = 3;
+    static constexpr uint32_t kCacheFallbackSize = 512;
+    AstrOsOtaReadAhead::ImageCache imageCache_;
+    uint8_t *imageCacheStorage_ = nullptr; // heap_caps_malloc'd; null while on cacheFallback_
+    uint8_t cacheFallback_[kCacheFallbackSize] = {0};
+    std::string imageCachePath_;
+    time_t imageCacheMtime_ = 0;
+    const char *fileReadFailure_ = nullptr; // fileReadCb's failure reason
 
     // Stats counters (reset in startNextPadawan). All read+written by the
     // owning task only (otaForwarderTask) — no atomics. lastSentSeq_ is the
@@ -304,6 +387,12 @@ private:
     bool statsAnyAcked_ = false; // disambiguates "0 acked" from "none acked yet"
     uint32_t statsNaksRecvCount_ = 0;
     uint32_t statsSendFailCount_ = 0;
+    // Cache activity since this padawan's SHA pass: stats() at that point,
+    // and fileReadCb's total / slowest single load (an SD spike shows up in
+    // the max).
+    AstrOsOtaReadAhead::Stats statsCacheBase_{};
+    uint32_t statsCacheLoadUs_ = 0;
+    uint32_t statsCacheLoadMaxUs_ = 0;
 
     // FW_PROGRESS SENDING throttle: emit on every >=5% byte advance.
     // Reset to 0 in startNextPadawan; updated in streamDrain.
@@ -81,6 +81,7 @@ extern "C"
             {
                 uint8_t srcMac[6];
                 uint8_t xferId;
+                uint32_t resumeSeq; // 0 unless the padawan resumed from a checkpoint
             } begin_ack;
 
             struct
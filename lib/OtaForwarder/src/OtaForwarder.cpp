@@ -3,11 +3,15 @@
 #include <AstrOsEspAppDescParser.hpp>
 #include <AstrOsEspNow.h>
 #include <AstrOsMessaging.hpp>
+#include <AstrOsOtaCompress.hpp>
+#include <AstrOsOtaDelta.hpp>
 #include <AstrOsSerialMsgHandler.hpp>
 #include <AstrOsSha256.h>
+#include <AstrOsStorageManager.hpp>
 #include <AstrOsStringUtils.hpp>
 #include <OtaReceiver.hpp>
 #include <OtaWriter.hpp>
+#include <esp_heap_caps.h>
 #include <esp_log.h>
 #include <esp_system.h>
 #include <freertos/task.h>
@@ -16,11 +20,68 @@
 #include <cstddef>
 #include <cstdio>
 #include <cstring>
+#include <memory>
+#include <new>
 #include <sys/stat.h>
 
 namespace
 {
     constexpr const char *TAG = "OtaForwarder";
+
+    // StreamDecoder sink for inspectStagedFirmware: keeps the first
+    // `cap` decoded bytes and drops the rest.
+    struct PrefixSink
+    {
+        uint8_t *buf;
+        size_t cap;
+        size_t len;
+
+        static bool writeOut(void *ctx, const uint8_t *data, size_t n)
+        {
+            auto self = static_cast<PrefixSink *>(ctx);
+            size_t take = std::min(n, self->cap - self->len);
+            std::memcpy(self->buf + self->len, data, take);
+            self->len += take;
+            return true;
+        }
+    };
+
+    // readFileBlocks sink for computeFileSha256.
+    void sha256Block(void *ctx, const uint8_t *data, size_t len)
+    {
+        AstrOsSha256_update(static_cast<AstrOsSha256Ctx *>(ctx), data, len);
+    }
+
+    // ImageCache::scan sink for scanFirmware: splits the file's bytes at
+    // block boundaries into Merkle leaf digests.
+    struct MerkleLeafBuilder
+    {
+        const AstrOsOtaMerkle::Geometry *geo;
+        uint8_t *leaves;
+        AstrOsSha256Ctx ctx;
+        uint32_t block;
+        uint32_t fill;
+
+        static void onData(void *arg, const uint8_t *data, size_t len)
+        {
+            auto self = static_cast<MerkleLeafBuilder *>(arg);
+            while (len > 0 && self->block < self->geo->blockCount())
+            {
+                const size_t n = std::min(len, static_cast<size_t>(self->geo->blockLen(self->block) - self->fill));
+                AstrOsSha256_update(&self->ctx, data, n);
+                data += n;
+                len -= n;
+                self->fill += static_cast<uint32_t>(n);
+                if (self->fill == self->geo->blockLen(self->block))
+                {
+                    AstrOsSha256_final(&self->ctx, self->leaves + self->block * AstrOsOtaMerkle::kHashSize);
+                    AstrOsOtaMerkle::leafBegin(self->ctx);
+                    self->block++;
+                    self->fill = 0;
+                }
+            }
+        }
+    };
 } // namespace
 
 OtaForwarder AstrOs_OtaForwarder;
@@ -270,13 +331,18 @@ void OtaForwarder::handleBeginAck(queue_ota_forwarder_msg_t &msg)
         ESP_LOGW(TAG, "OTA_BEGIN_ACK from unexpected peer (xferId=%u); dropping", msg.begin_ack.xferId);
         return;
     }
-    auto r = bulk_.onBeginAck(msg.begin_ack.xferId);
+    auto r = bulk_.onBeginAck(msg.begin_ack.xferId, msg.begin_ack.resumeSeq);
     if (r.decision != AstrOsBulkTransport::BeginAckResult::Decision::OK)
     {
-        ESP_LOGW(TAG, "BulkSender::onBeginAck rejected decision=%d (xferId=%u); waiting on timeout", (int)r.decision,
-                 msg.begin_ack.xferId);
+        ESP_LOGW(TAG, "BulkSender::onBeginAck rejected decision=%d (xferId=%u resumeSeq=%u); waiting on timeout",
+                 (int)r.decision, msg.begin_ack.xferId, (unsigned)msg.begin_ack.resumeSeq);
         return;
     }
+    if (msg.begin_ack.resumeSeq > 0)
+    {
+        ESP_LOGI(TAG, "%s resuming xferId=%u at seq %u/%u", currentControllerId_.c_str(), msg.begin_ack.xferId,
+                 (unsigned)msg.begin_ack.resumeSeq, (unsigned)firmwareTotalChunks_);
+    }
     beginAckTimerStop();
     phase_ = Phase::STREAMING;
     tickTimerStart();
@@ -298,6 +364,23 @@ void OtaForwarder::handleBeginNak(queue_ota_forwarder_msg_t &msg)
     // all-zero srcMac (zero-init), so srcMac check would reject it.
     if (msg.begin_nak.xferId == 0xFF && msg.begin_nak.reason == 0xFF)
     {
+        if (merkleOn_)
+        {
+            // Padawans that predate OTA_BEGIN_FLAG_MERKLE drop the longer
+            // BEGIN as malformed and never answer. Offer the plain stream
+            // once before giving up on the padawan.
+            ESP_LOGW(TAG, "OTA_BEGIN_ACK timeout for %s with Merkle offered; retrying with a plain BEGIN",
+                     currentControllerId_.c_str());
+            merkleLeaves_.reset();
+            if (!beginWireStream(false))
+            {
+                abortCurrentPadawan("begin_rejected");
+                return;
+            }
+            emitOtaBeginFrame();
+            beginAckTimerStart();
+            return;
+        }
         ESP_LOGW(TAG, "OTA_BEGIN_ACK timeout for %s after 5s; abandoning", currentControllerId_.c_str());
         abortCurrentPadawan("begin_ack_timeout");
         return;
@@ -384,6 +467,11 @@ void OtaForwarder::handleDataNak(queue_ota_forwarder_msg_t &msg)
         return;
     }
     statsNaksRecvCount_++;
+    if (msg.data_nak.reason == static_cast<uint8_t>(OtaDataNakReason::BLOCK))
+    {
+        ESP_LOGW(TAG, "%s rejected a Merkle block; resending from seq %u", currentControllerId_.c_str(),
+                 (unsigned)msg.data_nak.nextExpectedSeq);
+    }
     auto r = bulk_.onDataNak(msg.data_nak.xferId, msg.data_nak.nextExpectedSeq,
                              static_cast<AstrOsBulkTransport::NakReason>(msg.data_nak.reason));
     switch (r.decision)
@@ -526,9 +614,9 @@ void OtaForwarder::handleTick()
         const uint32_t seq = tr.retransmitSeqs[i];
         const uint32_t offset = seq * kChunkSize;
         uint32_t expectedLen = kChunkSize;
-        if (offset + kChunkSize > firmwareTotalSize_)
+        if (offset + kChunkSize > wireTotalSize_)
         {
-            expectedLen = firmwareTotalSize_ - offset;
+            expectedLen = wireTotalSize_ - offset;
         }
 
         uint8_t payloadBuf[sizeof(OtaDataHeader) + kChunkSize];
@@ -538,27 +626,21 @@ void OtaForwarder::handleTick()
         hdr.payloadLen = static_cast<uint16_t>(expectedLen);
 
         std::memcpy(payloadBuf, &hdr, sizeof(hdr));
-        // Split fseek/fread checks so a seek failure isn't conflated with a
-        // short read in FW_DEPLOY_DONE. Reason vocabulary:
+        // readWireBytes keeps fseek and fread failures apart so a seek
+        // failure isn't conflated with a short read in FW_DEPLOY_DONE.
+        // Reason vocabulary:
         //   firmware_seek_failed — fseek returned non-zero (seek-time fault)
         //   firmware_read_short  — fread returned fewer bytes than requested
         //                          (file changed mid-transfer: truncation,
         //                          unlink, sparse-file weirdness)
         //   firmware_read_failed — ferror() set during the SHA pass at file
         //                          open (SD driver/hardware fault)
-        // Different root causes → different operator next-steps. Matches
-        // streamDrain's per-check splitting.
-        if (std::fseek(firmwareFile_, offset, SEEK_SET) != 0)
+        // Different root causes → different operator next-steps.
+        if (const char *failure = readWireBytes(offset, payloadBuf + sizeof(hdr), expectedLen))
         {
-            ESP_LOGE(TAG, "fseek(%u) failed for retransmit seq=%u; abandoning", offset, seq);
-            abortCurrentPadawan("firmware_seek_failed");
-            return;
-        }
-        size_t read = std::fread(payloadBuf + sizeof(hdr), 1, expectedLen, firmwareFile_);
-        if (read != expectedLen)
-        {
-            ESP_LOGE(TAG, "fread(%u) returned %zu for retransmit seq=%u; abandoning", expectedLen, read, seq);
-            abortCurrentPadawan("firmware_read_short");
+            ESP_LOGE(TAG, "reading %u wire bytes at %u for retransmit seq=%u failed (%s); abandoning", expectedLen,
+                     offset, seq, failure);
+            abortCurrentPadawan(failure);
             return;
         }
 
@@ -583,6 +665,15 @@ void OtaForwarder::handleTick()
 
     // After retransmits, drain new chunks until WINDOW_FULL / ALL_SENT.
     streamDrain(nowMs);
+
+    // With the window full the task would otherwise sit idle until the next
+    // ACK; load the next file block now so the drain after that ACK is
+    // served from RAM. A failure here is left for that read to report.
+    if (phase_ == Phase::STREAMING && !imageCache_.prefetchNext().ok)
+    {
+        ESP_LOGD(TAG, "read-ahead failed (%s); the next chunk read retries",
+                 fileReadFailure_ != nullptr ? fileReadFailure_ : "?");
+    }
 }
 
 void OtaForwarder::startNextPadawan()
@@ -682,69 +773,50 @@ void OtaForwarder::startNextPadawan()
         }
 
         // Compute SHA-256 of the file (forensic-grade defensive check; the
-        // padawan also verifies). One-shot at file open; ships in the
-        // OTA_BEGIN frame's sha256Expected field.
-        if (!computeFileSha256(firmwarePath, firmwareSha256_))
+        // padawan also verifies). One pass through imageCache_ at file open,
+        // which also loads a resident copy (or hashes the one the previous
+        // padawan loaded); ships in the OTA_BEGIN frame's sha256Expected
+        // field. The Merkle leaves come out of the same pass; without RAM
+        // for them the transfer goes plain.
+        prepareImageCache(firmwarePath, firmwareTotalSize_, st.st_mtime);
+        statsCacheBase_ = imageCache_.stats();
+        statsCacheLoadUs_ = 0;
+        statsCacheLoadMaxUs_ = 0;
+        merkleLeaves_.reset();
+        if (merkleGeo_.init(firmwareTotalSize_, kMerkleBlockLog2))
         {
-            ESP_LOGE(TAG, "fread error during SHA pass; abandoning padawan");
-            std::fclose(firmwareFile_);
-            firmwareFile_ = nullptr;
-            results_.push_back({currentControllerId_, PadawanStatus::FAILED, "", "firmware_sha_failed"});
-            nextOrderIdx_++;
-            continue;
+            merkleLeaves_.reset(new (std::nothrow) uint8_t[merkleGeo_.blockCount() * AstrOsOtaMerkle::kHashSize]);
+            if (!merkleLeaves_)
+            {
+                ESP_LOGW(TAG, "no RAM for %u Merkle leaves; sending without block verification",
+                         (unsigned)merkleGeo_.blockCount());
+            }
         }
-
-        // fseek(SEEK_SET) over rewind(): rewind silently swallows errors. A
-        // bad seek here would burn the full chunk budget shipping wrong
-        // bytes before the padawan's SHA mismatch catches it — fail fast.
-        if (std::fseek(firmwareFile_, 0, SEEK_SET) != 0)
+        if (!scanFirmware(firmwareSha256_))
         {
-            ESP_LOGE(TAG, "fseek(0) failed after SHA pass");
+            ESP_LOGE(TAG, "read error during SHA pass (%s); abandoning padawan",
+                     fileReadFailure_ != nullptr ? fileReadFailure_ : "?");
             std::fclose(firmwareFile_);
             firmwareFile_ = nullptr;
-            results_.push_back({currentControllerId_, PadawanStatus::FAILED, "", "firmware_seek_failed"});
+            results_.push_back({currentControllerId_, PadawanStatus::FAILED, "", "firmware_sha_failed"});
             nextOrderIdx_++;
             continue;
         }
 
-        // Phase A: read the staged .bin's esp_app_desc_t to learn the expected
-        // post-reboot version string. The 80-byte prefix is plenty — the
-        // parser only reads bytes 0..79. fseek back to 0 afterward so the
-        // streaming send loop starts at the beginning.
-        expectedNewVersion_.clear();
+        // Phase A: classify the staged file and learn the expected
+        // post-reboot version string — from the .bin's esp_app_desc_t, or
+        // from the stream headers of a compressed / delta file.
+        //
+        // Encoded files ship as-is (padawans decode them), but OTA_BEGIN
+        // announces the *decoded image's* SHA instead of the file SHA
+        // computed above.
         {
-            uint8_t prefix[80] = {0};
-            if (std::fread(prefix, 1, sizeof(prefix), firmwareFile_) != sizeof(prefix))
+            StagedFirmwareInfo staged = inspectStagedFirmware(firmwarePath);
+            expectedNewVersion_ = staged.version;
+            firmwareFlags_ = staged.flags;
+            if (firmwareFlags_ != 0)
             {
-                ESP_LOGW(TAG,
-                         "Could not read 80-byte prefix from staged .bin (%s); "
-                         "version-confirm will fall back to timeout",
-                         firmwarePath.c_str());
-            }
-            else
-            {
-                auto desc = AstrOsEspAppDescParser::parse(prefix, sizeof(prefix));
-                if (desc.ok)
-                {
-                    expectedNewVersion_ = desc.version;
-                    ESP_LOGI(TAG, "Parsed expected new version '%s' from staged .bin", expectedNewVersion_.c_str());
-                }
-                else
-                {
-                    ESP_LOGW(TAG,
-                             "esp_app_desc parse failed (%s); version-confirm will "
-                             "fall back to timeout",
-                             desc.error.c_str());
-                }
-            }
-            if (std::fseek(firmwareFile_, 0, SEEK_SET) != 0)
-            {
-                ESP_LOGE(TAG, "fseek(0) failed on firmware file");
-                std::fclose(firmwareFile_);
-                firmwareFile_ = nullptr;
-                results_.push_back({currentControllerId_, PadawanStatus::FAILED, "", "firmware_seek_failed"});
-                nextOrderIdx_++;
-                continue;
+                std::memcpy(firmwareSha256_, staged.imageSha256, sizeof(firmwareSha256_));
             }
         }
 
@@ -754,11 +826,8 @@ void OtaForwarder::startNextPadawan()
         // 0xFF ("timeout sentinel").
         currentXferId_ = static_cast<uint8_t>(nextOrderIdx_ + 1);
 
-        auto br =
-            bulk_.begin(currentXferId_, firmwareTotalChunks_, kChunkSize, kWindowSize, kAckTimeoutMs, kMaxRetries);
-        if (!br.valid)
+        if (!beginWireStream(merkleLeaves_ != nullptr))
         {
-            ESP_LOGE(TAG, "BulkSender::begin rejected reason=%d", (int)br.reason);
             std::fclose(firmwareFile_);
             firmwareFile_ = nullptr;
             results_.push_back({currentControllerId_, PadawanStatus::FAILED, "", "begin_rejected"});
@@ -766,8 +835,9 @@ void OtaForwarder::startNextPadawan()
             continue;
         }
 
-        ESP_LOGI(TAG, "Starting transfer to %s (xferId=%u, chunks=%u, size=%u)", currentControllerId_.c_str(),
-                 currentXferId_, firmwareTotalChunks_, firmwareTotalSize_);
+        ESP_LOGI(TAG, "Starting transfer to %s (xferId=%u, chunks=%u, size=%u, wire=%u%s)",
+                 currentControllerId_.c_str(), currentXferId_, firmwareTotalChunks_, firmwareTotalSize_, wireTotalSize_,
+                 merkleOn_ ? ", merkle" : "");
 
         // Reset per-padawan stats counters before the first wire activity.
         statsLastSentSeq_ = 0;
@@ -808,6 +878,9 @@ void OtaForwarder::finishCurrentPadawanAndAdvance()
     versionConfirmTimerStop();
 
     bulk_.reset();
+    merkleEnc_.reset();
+    merkleLeaves_.reset();
+    merkleOn_ = false;
 
     if (firmwareFile_)
     {
@@ -864,6 +937,7 @@ void OtaForwarder::emitDeployDoneAndReset()
     }
     AstrOs_SerialMsgHandler.sendFwDeployDone(deployMsgId_, deployTransferId_, wire);
 
+    releaseImageCache();
     deployMsgId_.clear();
     deployTransferId_.clear();
     orderList_.clear();
@@ -918,14 +992,28 @@ void OtaForwarder::emitOtaBeginFrame()
 {
     OtaBeginPayload payload{};
     payload.xferId = currentXferId_;
-    payload.totalSize = firmwareTotalSize_;
+    payload.totalSize = wireTotalSize_;
     payload.chunkSize = kChunkSize;
     payload.totalChunks = firmwareTotalChunks_;
     std::memcpy(payload.sha256Expected, firmwareSha256_, 32);
-    payload.flags = 0;
+    // RESUME is a capability, not a property of the file: the sender seeks
+    // per chunk, so it can start anywhere the padawan asks.
+    payload.flags = firmwareFlags_ | OTA_BEGIN_FLAG_RESUME | (merkleOn_ ? OTA_BEGIN_FLAG_MERKLE : 0);
 
-    esp_err_t err = AstrOs_EspNow.sendOtaFrame(currentPadawanMac_, AstrOsPacketType::OTA_BEGIN,
-                                               reinterpret_cast<const uint8_t *>(&payload), sizeof(payload));
+    uint8_t frame[OTA_BEGIN_MERKLE_SIZE];
+    std::memcpy(frame, &payload, sizeof(payload));
+    size_t frameLen = sizeof(payload);
+    if (merkleOn_)
+    {
+        OtaBeginMerkleExt ext{};
+        ext.dataSize = firmwareTotalSize_;
+        ext.blockLog2 = kMerkleBlockLog2;
+        std::memcpy(ext.root, merkleRoot_, sizeof(ext.root));
+        std::memcpy(frame + sizeof(payload), &ext, sizeof(ext));
+        frameLen += sizeof(ext);
+    }
+
+    esp_err_t err = AstrOs_EspNow.sendOtaFrame(currentPadawanMac_, AstrOsPacketType::OTA_BEGIN, frame, frameLen);
     if (err != ESP_OK)
     {
         ESP_LOGW(TAG, "OTA_BEGIN sendOtaFrame returned %s; posting timeout sentinel immediately", esp_err_to_name(err));
@@ -984,9 +1072,9 @@ void OtaForwarder::streamDrain(uint64_t nowMs)
             const uint32_t seq = sr.seq;
             const uint32_t offset = seq * kChunkSize;
             uint32_t expectedLen = kChunkSize;
-            if (offset + kChunkSize > firmwareTotalSize_)
+            if (offset + kChunkSize > wireTotalSize_)
             {
-                expectedLen = firmwareTotalSize_ - offset;
+                expectedLen = wireTotalSize_ - offset;
             }
 
             uint8_t payloadBuf[sizeof(OtaDataHeader) + kChunkSize];
@@ -997,17 +1085,11 @@ void OtaForwarder::streamDrain(uint64_t nowMs)
             // CRC computed after the bytes are loaded below.
 
             std::memcpy(payloadBuf, &hdr, sizeof(hdr));
-            if (std::fseek(firmwareFile_, offset, SEEK_SET) != 0)
+            if (const char *failure = readWireBytes(offset, payloadBuf + sizeof(hdr), expectedLen))
             {
-                ESP_LOGE(TAG, "fseek(%u) failed mid-transfer; abandoning", offset);
-                abortCurrentPadawan("firmware_seek_failed");
-                return;
-            }
-            size_t read = std::fread(payloadBuf + sizeof(hdr), 1, expectedLen, firmwareFile_);
-            if (read != expectedLen)
-            {
-                ESP_LOGE(TAG, "fread(%u) returned %zu mid-transfer; abandoning", expectedLen, read);
-                abortCurrentPadawan("firmware_read_short");
+                ESP_LOGE(TAG, "reading %u wire bytes at %u failed mid-transfer (%s); abandoning", expectedLen, offset,
+                         failure);
+                abortCurrentPadawan(failure);
                 return;
             }
 
@@ -1066,6 +1148,147 @@ void OtaForwarder::streamDrain(uint64_t nowMs)
     }
 }
 
+const char *OtaForwarder::readWireBytes(uint32_t offset, uint8_t *out, uint32_t len)
+{
+    if (!merkleOn_)
+    {
+        return readFirmware(offset, out, len);
+    }
+    merkleReadFailure_ = nullptr;
+    if (!merkleEnc_.read(offset, out, len))
+    {
+        // The encoder only fails through merkleReadCb, or on a range past
+        // the stream — which would be a short read of the file behind it.
+        return merkleReadFailure_ != nullptr ? merkleReadFailure_ : "firmware_read_short";
+    }
+    return nullptr;
+}
+
+const char *OtaForwarder::readFirmware(uint32_t offset, uint8_t *out, size_t len)
+{
+    fileReadFailure_ = nullptr;
+    if (!imageCache_.read(offset, out, len).ok)
+    {
+        // No IO failure recorded means the range ran past the file the
+        // cache was sized for — a short read of it.
+        return fileReadFailure_ != nullptr ? fileReadFailure_ : "firmware_read_short";
+    }
+    return nullptr;
+}
+
+const char *OtaForwarder::readFile(uint32_t offset, uint8_t *out, size_t len)
+{
+    if (std::fseek(firmwareFile_, offset, SEEK_SET) != 0)
+    {
+        return "firmware_seek_failed";
+    }
+    if (std::fread(out, 1, len, firmwareFile_) != len)
+    {
+        return "firmware_read_short";
+    }
+    return nullptr;
+}
+
+bool OtaForwarder::merkleReadCb(void *arg, uint32_t offset, uint8_t *out, size_t len)
+{
+    auto self = static_cast<OtaForwarder *>(arg);
+    self->merkleReadFailure_ = self->readFirmware(offset, out, len);
+    return self->merkleReadFailure_ == nullptr;
+}
+
+bool OtaForwarder::fileReadCb(void *arg, uint32_t offset, uint8_t *out, size_t len)
+{
+    auto self = static_cast<OtaForwarder *>(arg);
+    const int64_t start = esp_timer_get_time();
+    self->fileReadFailure_ = self->readFile(offset, out, len);
+    const uint32_t us = static_cast<uint32_t>(esp_timer_get_time() - start);
+    self->statsCacheLoadUs_ += us;
+    self->statsCacheLoadMaxUs_ = std::max(self->statsCacheLoadMaxUs_, us);
+    return self->fileReadFailure_ == nullptr;
+}
+
+void OtaForwarder::prepareImageCache(const std::string &path, uint32_t size, time_t mtime)
+{
+    if (imageCache_.active() && imageCache_.size() == size && imageCachePath_ == path && imageCacheMtime_ == mtime)
+    {
+        return;
+    }
+    releaseImageCache();
+
+    // Boards without PSRAM (CONFIG_SPIRAM off) just get nullptr here.
+    uint32_t blockSize = kCacheBlockSize;
+    size_t storageLen = size;
+    imageCacheStorage_ = static_cast<uint8_t *>(heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (imageCacheStorage_ == nullptr)
+    {
+        storageLen = size_t(kCacheBlockSize) * kCacheWindowSlots;
+        imageCacheStorage_ = static_cast<uint8_t *>(heap_caps_malloc(storageLen, MALLOC_CAP_8BIT));
+    }
+    uint8_t *storage = imageCacheStorage_;
+    if (storage == nullptr)
+    {
+        storage = cacheFallback_;
+        storageLen = sizeof(cacheFallback_);
+        blockSize = kCacheFallbackSize;
+    }
+    // Every option holds at least one block and the caller rejected empty
+    // files, so begin() can't refuse.
+    if (!imageCache_.begin(size, blockSize, storage, storageLen, &fileReadCb, this))
+    {
+        ESP_LOGE(TAG, "ImageCache::begin rejected size=%u block=%u", (unsigned)size, (unsigned)blockSize);
+    }
+    imageCachePath_ = path;
+    imageCacheMtime_ = mtime;
+    ESP_LOGI(TAG, "firmware read-ahead: %s, %u B", imageCache_.resident() ? "resident" : "window",
+             (unsigned)storageLen);
+}
+
+void OtaForwarder::releaseImageCache()
+{
+    imageCache_.reset();
+    heap_caps_free(imageCacheStorage_);
+    imageCacheStorage_ = nullptr;
+    imageCachePath_.clear();
+    imageCacheMtime_ = 0;
+}
+
+bool OtaForwarder::scanFirmware(uint8_t outSha[32])
+{
+    MerkleLeafBuilder leaves{&merkleGeo_, merkleLeaves_.get(), {}, 0, 0};
+    if (merkleLeaves_)
+    {
+        AstrOsOtaMerkle::leafBegin(leaves.ctx);
+    }
+    fileReadFailure_ = nullptr;
+    return imageCache_.scan(outSha, merkleLeaves_ ? &MerkleLeafBuilder::onData : nullptr, &leaves).ok;
+}
+
+bool OtaForwarder::beginWireStream(bool merkle)
+{
+    merkleOn_ = merkle;
+    if (merkle)
+    {
+        merkleEnc_.begin(merkleGeo_, merkleLeaves_.get(), &merkleReadCb, this);
+        merkleEnc_.root(merkleRoot_);
+        wireTotalSize_ = merkleGeo_.streamSize();
+    }
+    else
+    {
+        merkleEnc_.reset();
+        wireTotalSize_ = firmwareTotalSize_;
+    }
+    firmwareTotalChunks_ = (wireTotalSize_ + kChunkSize - 1) / kChunkSize;
+    // begin() on a sender already waiting for BEGIN_ACK reinitializes it,
+    // which is what the plain-BEGIN fallback relies on.
+    auto br = bulk_.begin(currentXferId_, firmwareTotalChunks_, kChunkSize, kWindowSize, kAckTimeoutMs, kMaxRetries);
+    if (!br.valid)
+    {
+        ESP_LOGE(TAG, "BulkSender::begin rejected reason=%d", (int)br.reason);
+        return false;
+    }
+    return true;
+}
+
 // All three Start helpers use stop-then-start: esp_timer has no native
 // restart and start on an already-running timer returns
 // ESP_ERR_INVALID_STATE. Stop on an idle timer is a documented no-op,
@@ -1235,9 +1458,14 @@ void OtaForwarder::handleStatsFire()
         break;
     }
     const long long acked = statsAnyAcked_ ? static_cast<long long>(statsHighestAckedSeq_) : -1;
-    ESP_LOGI(TAG, "OTA_STATS_TX: xferId=%u seq=%u/%u acked=%lld naks-rx=%u send-fail=%u phase=%s",
+    const AstrOsOtaReadAhead::Stats cache = imageCache_.stats();
+    ESP_LOGI(TAG,
+             "OTA_STATS_TX: xferId=%u seq=%u/%u acked=%lld naks-rx=%u send-fail=%u phase=%s "
+             "cache-hits=%u cache-loads=%u load-ms=%u load-max-ms=%u",
              (unsigned)currentXferId_, (unsigned)statsLastSentSeq_, (unsigned)firmwareTotalChunks_, acked,
-             (unsigned)statsNaksRecvCount_, (unsigned)statsSendFailCount_, phaseStr);
+             (unsigned)statsNaksRecvCount_, (unsigned)statsSendFailCount_, phaseStr,
+             (unsigned)(cache.hits - statsCacheBase_.hits), (unsigned)(cache.loads - statsCacheBase_.loads),
+             (unsigned)(statsCacheLoadUs_ / 1000), (unsigned)(statsCacheLoadMaxUs_ / 1000));
 }
 
 void OtaForwarder::flashResultTimerStart()
@@ -1500,6 +1728,9 @@ void OtaForwarder::handleMasterSelfFlashTimeout()
 void OtaForwarder::startMasterSelfFlash()
 {
     ESP_LOGI(TAG, "startMasterSelfFlash: beginning master self-flash");
+    // Padawans are done with the read-ahead copy; free it before the
+    // self-flash path needs its own buffers.
+    releaseImageCache();
 
     // ─── Resolve staged firmware path ───────────────────────────────
     auto firmwarePathOpt = AstrOs_OtaReceiver.getLastFirmwarePath();
@@ -1558,6 +1789,11 @@ void OtaForwarder::startMasterSelfFlash()
     req.local_flash_req.firmwarePath[sizeof(req.local_flash_req.firmwarePath) - 1] = '\0';
     req.local_flash_req.expectedSize = expectedSize;
     std::memcpy(req.local_flash_req.expectedSha256, expectedSha, 32);
+    // Same classification as the padawan path: OtaWriter decodes a
+    // compressed / delta staged file through the same stages as OTA_DATA.
+    StagedFirmwareInfo staged = inspectStagedFirmware(firmwarePath);
+    req.local_flash_req.flags = staged.flags;
+    std::memcpy(req.local_flash_req.imageSha256, staged.imageSha256, 32);
 
     QueueHandle_t writerQueue = AstrOs_OtaWriter.getWriterQueue();
     if (writerQueue == nullptr)
@@ -1664,30 +1900,94 @@ void OtaForwarder::insertMasterRow(PadawanStatus status, const std::string &fina
 
 bool OtaForwarder::computeFileSha256(const std::string &path, uint8_t outSha[32]) const
 {
-    FILE *f = std::fopen(path.c_str(), "rb");
-    if (f == nullptr)
-    {
-        return false;
-    }
     AstrOsSha256Ctx ctx;
     AstrOsSha256_init(&ctx);
-    constexpr size_t kBufSize = 512;
-    uint8_t buf[kBufSize];
-    size_t got;
-    while ((got = std::fread(buf, 1, kBufSize, f)) > 0)
-    {
-        AstrOsSha256_update(&ctx, buf, got);
-    }
-    bool readOk = !std::ferror(f);
-    std::fclose(f);
-    if (!readOk)
+    // Sector-sized unbuffered reads rather than 512 B through stdio's buffer.
+    auto result = AstrOs_Storage.readFileBlocks(path.c_str(), &sha256Block, &ctx);
+    if (!result.ok)
     {
+        ESP_LOGE(TAG, "computeFileSha256(%s): %s", path.c_str(),
+                 AstrOsStorageManager::readStatusName(result.status));
         return false;
     }
     AstrOsSha256_final(&ctx, outSha);
     return true;
 }
 
+OtaForwarder::StagedFirmwareInfo OtaForwarder::inspectStagedFirmware(const std::string &path) const
+{
+    StagedFirmwareInfo info;
+
+    // 512 B covers the worst case: a 44 B stream header plus a literal-only
+    // encoding of the 112 B PatchHeader (or 80 B app-desc prefix).
+    uint8_t raw[512];
+    size_t rawLen = 0;
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (f != nullptr)
+    {
+        rawLen = std::fread(raw, 1, sizeof(raw), f);
+        std::fclose(f);
+    }
+
+    // Leading bytes of the *decoded* stream: the file itself, or the
+    // inflated prefix of a compressed file.
+    uint8_t decoded[sizeof(AstrOsOtaDelta::PatchHeader)] = {0};
+    const uint8_t *inner = raw;
+    size_t innerLen = rawLen;
+
+    auto compressed = AstrOsOtaCompress::parseHeader(raw, rawLen);
+    if (compressed.valid)
+    {
+        info.flags |= OTA_BEGIN_FLAG_COMPRESSED;
+        std::memcpy(info.imageSha256, compressed.header.rawSha256, sizeof(info.imageSha256));
+        // Heap, not stack: the decoder carries its 4 KB window inline and
+        // this runs on otaForwarderTask's 8 KB stack. Transient.
+        auto decoder = std::make_unique<AstrOsOtaCompress::StreamDecoder>();
+        PrefixSink sink{decoded, sizeof(decoded), 0};
+        AstrOsOtaCompress::StreamIo io;
+        io.ctx = &sink;
+        io.writeOut = &PrefixSink::writeOut;
+        decoder->begin(io);
+        // Feeding a prefix leaves the decoder mid-stream; only a malformed
+        // prefix fails here, and the padawan rejects that stream anyway.
+        (void)decoder->feed(raw, rawLen);
+        inner = decoded;
+        innerLen = sink.len;
+        ESP_LOGI(TAG, "Staged file is compressed (decodes to %u B, window %u B)", (unsigned)compressed.header.rawSize,
+                 1u << compressed.header.windowBits);
+    }
+
+    auto delta = AstrOsOtaDelta::parseHeader(inner, innerLen);
+    if (delta.valid)
+    {
+        info.flags |= OTA_BEGIN_FLAG_DELTA;
+        std::memcpy(info.imageSha256, delta.header.targetSha256, sizeof(info.imageSha256));
+        info.version.assign(delta.header.targetVersion,
+                            strnlen(delta.header.targetVersion, sizeof(delta.header.targetVersion)));
+        ESP_LOGI(TAG, "Staged file is a delta patch (base %u B -> target %u B), expected new version '%s'",
+                 (unsigned)delta.header.baseSize, (unsigned)delta.header.targetSize, info.version.c_str());
+        return info;
+    }
+
+    if (innerLen < 80)
+    {
+        ESP_LOGW(TAG, "Could not read 80-byte prefix from staged .bin (%s); version-confirm will fall back to timeout",
+                 path.c_str());
+        return info;
+    }
+    auto desc = AstrOsEspAppDescParser::parse(inner, innerLen);
+    if (desc.ok)
+    {
+        info.version = desc.version;
+        ESP_LOGI(TAG, "Parsed expected new version '%s' from staged .bin", info.version.c_str());
+    }
+    else
+    {
+        ESP_LOGW(TAG, "esp_app_desc parse failed (%s); version-confirm will fall back to timeout", desc.error.c_str());
+    }
+    return info;
+}
+
 void OtaForwarder::checkPeerVersionForCurrentPadawan()
 {
     if (phase_ != Phase::AWAITING_VERSION_CONFIRMED)
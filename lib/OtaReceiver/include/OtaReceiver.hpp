@@ -4,6 +4,7 @@
 #include <AstrOsBulkTransport.hpp>
 #include <AstrOsSha256.h>
 #include <OtaQueueMessage.h>
+#include <OtaStagingWriter.hpp>
 
 #include <atomic>
 #include <cstdint>
@@ -26,6 +27,10 @@
 // The idle watchdog timer fires from esp_timer's dispatch task, but its
 // callback only does xQueueSend(OTA_MSG_WATCHDOG_FIRE) — state mutation still
 // runs on otaReceiverTask, preserving the single-task-state invariant.
+//
+// Staging-file writes are handed to otaStagingTask through stagingWriter_
+// (see OtaStagingWriter.hpp); otaReceiverTask still owns staging_ itself and
+// only closes it after the writer has drained.
 class OtaReceiver
 {
 private:
@@ -55,6 +60,9 @@ private:
     // context's state got clobbered by another SHA consumer; `shaActive_`
     // gates init-vs-update ordering without needing an explicit free.
     FILE *staging_ = nullptr;
+    // Active between BEGIN and END / abort when the ring could be allocated;
+    // otherwise handleChunk fwrite()s inline as before.
+    OtaStagingWriter stagingWriter_;
     AstrOsSha256Ctx shaCtx_;
     bool shaActive_ = false;
 
@@ -81,6 +89,18 @@ public:
 
     void process(queue_ota_msg_t &msg);
 
+    // Queue for otaStagingTask, or nullptr if the writer couldn't be set up
+    // (main.cpp then skips the task and chunks are written synchronously).
+    QueueHandle_t getStagingJobQueue() const
+    {
+        return stagingWriter_.ready() ? stagingWriter_.getJobQueue() : nullptr;
+    }
+    // otaStagingTask entry point.
+    void processStagingJob(const ota_staging_job_t &job)
+    {
+        stagingWriter_.process(job);
+    }
+
     // Safe to call from any task. Gates poll work during OTA.
     bool isActive() const noexcept
     {
@@ -113,7 +133,8 @@ private:
     // esp_timer callback indirection — arg is `this`.
     static void watchdogTimerCb(void *arg);
 
-    // Closes staging_ (unlinking unless keepStaging) and releases shaCtx_.
+    // Aborts the staging writer, closes staging_ (unlinking unless
+    // keepStaging) and releases shaCtx_.
     // Idempotent so callers don't need to track which fields are live.
     void resetCryptoAndFile(bool keepStaging);
 };
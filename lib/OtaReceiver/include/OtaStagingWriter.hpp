@@ -0,0 +1,129 @@
+#ifndef OTASTAGINGWRITER_HPP
+#define OTASTAGINGWRITER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// needed for QueueHandle_t, must be in this order
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <esp_err.h>
+
+// One unit of work for otaStagingTask: write `len` bytes of ring buffer
+// `buffer` at the staging file's current position, then hand the buffer
+// back to the free list.
+typedef struct
+{
+    uint8_t buffer;
+    uint16_t len; // < kBlockSize only for the final block
+} ota_staging_job_t;
+
+// Ring-buffered, block-aligned SD sink for OtaReceiver's staging file.
+//
+// otaReceiverTask copies each ACKed FW_CHUNK payload into the fill block;
+// every full block goes to otaStagingTask, which fwrite()s it while
+// otaReceiverTask goes back to ACKing chunks. The file is opened unbuffered
+// (_IONBF) and every block starts at a multiple of kBlockSize, so FATFS
+// hands each one to the card as whole-sector writes with no stdio or FATFS
+// window copy in between. Paired with a staging file preallocated as one
+// contiguous cluster run (AstrOsStorageManager::preallocateSdFile), a block
+// write never has to extend the FAT chain either.
+//
+// Same shape as OtaWriter's OtaFlashPipeline. Threading: begin / append /
+// finish / abort run on otaReceiverTask only; process runs on
+// otaStagingTask only. Buffers travel through freeQueue_ / jobQueue_ — the
+// FreeRTOS queue operations are the memory barrier for their contents. The
+// only shared scalars are the std::atomic error / timing fields.
+//
+// Backpressure: with every block queued, append blocks on freeQueue_ until
+// otaStagingTask returns one (bounded by kStallTimeoutMs). kBufferCount
+// blocks absorb an SD latency spike of roughly ring size / serial rate
+// before the ACK stream notices.
+class OtaStagingWriter
+{
+public:
+    // Two 4 KB FATFS sectors (CONFIG_FATFS_SECTOR_4096) per write.
+    static constexpr size_t kBlockSize = 8192;
+    static constexpr uint8_t kBufferCount = 3;
+    // SD writes stall for hundreds of ms at worst; a block that takes longer
+    // than this to come back means the card is gone.
+    static constexpr uint32_t kStallTimeoutMs = 3000;
+
+    // Totals since the last begin(), microseconds.
+    struct Stats
+    {
+        uint32_t writeUs = 0;    // otaStagingTask: fwrite
+        uint32_t writeMaxUs = 0; // slowest single block
+        uint32_t stallUs = 0;    // otaReceiverTask: waiting for a free block
+        uint32_t blocks = 0;     // blocks written
+    };
+
+    // Creates the two queues. Returns false on allocation failure; the
+    // caller then keeps writing through fwrite on its own task.
+    bool Init();
+    bool ready() const
+    {
+        return jobQueue_ != nullptr;
+    }
+    // Queue otaStagingTask drains (pass as the task arg, main.cpp).
+    QueueHandle_t getJobQueue() const
+    {
+        return jobQueue_;
+    }
+
+    // Starts a session writing `file` from its current position, which must
+    // be 0. Allocates the ring (kBufferCount * kBlockSize) for the session;
+    // ESP_ERR_NO_MEM if that fails, and the caller writes synchronously.
+    esp_err_t begin(FILE *file);
+    // Copies `len` bytes into the ring. Returns the first write error seen
+    // so far (sticky), or ESP_ERR_TIMEOUT if no block came back in time.
+    esp_err_t append(const uint8_t *data, size_t len);
+    // Submits the partial tail block and waits until every byte has been
+    // handed to the file. Returns the sticky error. The session ends and the
+    // ring is freed either way; the caller still owns (and closes) the file.
+    esp_err_t finish();
+    // Drops the unsubmitted fill block, waits out in-flight writes, ends the
+    // session. Idempotent.
+    void abort();
+
+    bool active() const
+    {
+        return file_ != nullptr;
+    }
+    Stats stats() const;
+
+    // otaStagingTask entry point.
+    void process(const ota_staging_job_t &job);
+
+private:
+    esp_err_t takeFreeBuffer();
+    esp_err_t submitFill();
+    bool drain();
+    void releaseRing();
+
+    QueueHandle_t jobQueue_ = nullptr;
+    QueueHandle_t freeQueue_ = nullptr;
+    // Heap, per session: a padawan never stages firmware, so it never pays
+    // for the ring.
+    uint8_t *ring_ = nullptr;
+
+    // Set by begin before the first job is queued, cleared only after a
+    // drain — otaStagingTask reads it between those points.
+    FILE *file_ = nullptr;
+
+    // otaReceiverTask side.
+    int fillIndex_ = -1; // block being filled, -1 = none held
+    size_t fillLen_ = 0; // bytes in the fill block
+
+    std::atomic<esp_err_t> error_{ESP_OK};
+    std::atomic<int> errno_{0}; // errno of the failed fwrite, for the log
+    std::atomic<uint32_t> writeUs_{0};
+    std::atomic<uint32_t> writeMaxUs_{0};
+    std::atomic<uint32_t> blocks_{0};
+    uint32_t stallUs_ = 0; // otaReceiverTask only
+};
+
+#endif
@@ -64,7 +64,14 @@ void OtaReceiver::Init(QueueHandle_t otaQueue)
         watchdog_ = nullptr;
     }
 
-    ESP_LOGI(TAG, "OtaReceiver initialized (watchdog idle threshold: %llums)", kWatchdogIdleUs / 1000ULL);
+    if (!stagingWriter_.Init())
+    {
+        // Transfers still work: handleChunk fwrite()s on otaReceiverTask.
+        ESP_LOGE(TAG, "staging writer queue allocation failed — writing synchronously");
+    }
+
+    ESP_LOGI(TAG, "OtaReceiver initialized (watchdog idle threshold: %llums, staging writer: %s)",
+             kWatchdogIdleUs / 1000ULL, stagingWriter_.ready() ? "on" : "off");
 }
 
 void OtaReceiver::watchdogTimerCb(void *arg)
@@ -120,6 +127,8 @@ void OtaReceiver::watchdogStop()
 
 void OtaReceiver::resetCryptoAndFile(bool keepStaging)
 {
+    // Before fclose: otaStagingTask may still be writing through staging_.
+    stagingWriter_.abort();
     if (staging_ != nullptr)
     {
         if (fclose(staging_) != 0)
@@ -241,7 +250,7 @@ void OtaReceiver::handleBegin(queue_ota_msg_t &msg)
     }
 
     // A prior HASH_MISMATCH (or finalize IO_ERROR) leaves staging.bin on disk
-    // for forensics. The fopen("wb") below truncates it before any new bytes
+    // for forensics. Opening it below truncates it before any new bytes
     // land, so its current clusters return to the free pool — count them as
     // available so we don't falsely reject a same-size re-upload as sd_full.
     uint64_t reclaimableStaging = 0;
@@ -260,16 +269,38 @@ void OtaReceiver::handleBegin(queue_ota_msg_t &msg)
         return;
     }
 
-    // "wb" truncates — cleans up any HASH_MISMATCH leftover from a prior transfer.
-    staging_ = fopen(kStagingPath, "wb");
+    // Reserve the whole image as one contiguous cluster run up front, so no
+    // chunk write ever has to search the FAT for a free cluster or extend
+    // the chain mid-transfer. The reserved file already has its final size,
+    // hence "r+b"; writes start at 0 and overwrite it in order. A fragmented
+    // card can't offer such a run — fall back to a growing "wb" file. Both
+    // truncate any HASH_MISMATCH leftover from a prior transfer.
+    const bool preallocated = AstrOs_Storage.preallocateSdFile(kStagingPath, msg.begin.totalSize);
+    staging_ = fopen(kStagingPath, preallocated ? "r+b" : "wb");
     if (staging_ == nullptr)
     {
         ESP_LOGE(TAG, "FW_TRANSFER_BEGIN: fopen(%s) failed: errno=%d (%s)", kStagingPath, errno, strerror(errno));
         bulk_.reset();
+        unlink(kStagingPath);
         AstrOs_SerialMsgHandler.sendFwTransferBeginAck(msgId, transferIdIn, "io_error");
         return;
     }
 
+    // With the writer running, every write reaching staging_ is a whole
+    // OtaStagingWriter block at a block-aligned offset, so stdio buffering
+    // would only add a copy; unbuffered, FATFS hands full sectors straight
+    // to the card. Without it, keep stdio's buffer to coalesce the chunks.
+    esp_err_t swErr = stagingWriter_.begin(staging_);
+    if (swErr == ESP_OK)
+    {
+        setvbuf(staging_, nullptr, _IONBF, 0);
+    }
+    else if (stagingWriter_.ready())
+    {
+        ESP_LOGW(TAG, "FW_TRANSFER_BEGIN: staging writer unavailable (%s) — writing synchronously",
+                 esp_err_to_name(swErr));
+    }
+
     // Invalidate the prior firmware's accessor entry now that we're
     // committed to a new staging file. Placed AFTER all rejection paths
     // (parse / SD / fopen) so a failed BEGIN attempt doesn't invalidate
@@ -288,8 +319,10 @@ void OtaReceiver::handleBegin(queue_ota_msg_t &msg)
     active_ = true;
     transferIdStr_ = transferIdIn;
 
-    ESP_LOGI(TAG, "FW_TRANSFER_BEGIN accepted: transferId=%s totalSize=%u chunks=%u sha=%s", transferIdIn.c_str(),
-             (unsigned)msg.begin.totalSize, (unsigned)msg.begin.totalChunks, msg.begin.sha256Hex);
+    ESP_LOGI(TAG, "FW_TRANSFER_BEGIN accepted: transferId=%s totalSize=%u chunks=%u sha=%s (%s, %s)",
+             transferIdIn.c_str(), (unsigned)msg.begin.totalSize, (unsigned)msg.begin.totalChunks,
+             msg.begin.sha256Hex, preallocated ? "contiguous" : "growing",
+             stagingWriter_.active() ? "pipelined" : "synchronous");
 
     AstrOs_SerialMsgHandler.sendFwTransferBeginAck(msgId, transferIdIn, "OK");
     watchdogStart();
@@ -319,8 +352,8 @@ void OtaReceiver::handleChunk(queue_ota_msg_t &msg)
 
     if (cr.decision == AstrOsBulkTransport::Decision::ACK)
     {
-        // Persist before ACK — a short fwrite means the bytes we'd be
-        // acknowledging aren't on disk.
+        // Persist (or, pipelined, buffer) before ACK — a failed write means
+        // the bytes we'd be acknowledging will never reach disk.
         if (staging_ == nullptr || !shaActive_)
         {
             // Defensive — should be unreachable if BEGIN succeeded.
@@ -346,11 +379,33 @@ void OtaReceiver::handleChunk(queue_ota_msg_t &msg)
             }
             ESP_LOGI(TAG, "FW_CHUNK seq=0 first16=%s", hex);
         }
-        size_t wrote = fwrite(cr.payload, 1, cr.payloadLen, staging_);
-        if (wrote != cr.payloadLen)
+        bool persisted;
+        if (stagingWriter_.active())
+        {
+            // Pipelined: the chunk lands in RAM and otaStagingTask writes it
+            // with its block. A write error on an earlier block (or a card
+            // that stopped returning blocks) surfaces here, so the NAK
+            // arrives a few chunks after the bytes that actually failed —
+            // harmless, since any FLASH_FULL aborts the whole transfer.
+            esp_err_t aErr = stagingWriter_.append(cr.payload, cr.payloadLen);
+            persisted = aErr == ESP_OK;
+            if (!persisted)
+            {
+                ESP_LOGE(TAG, "staging write failed: %s — aborting transfer", esp_err_to_name(aErr));
+            }
+        }
+        else
+        {
+            size_t wrote = fwrite(cr.payload, 1, cr.payloadLen, staging_);
+            persisted = wrote == cr.payloadLen;
+            if (!persisted)
+            {
+                ESP_LOGE(TAG, "fwrite short: wrote=%zu of %u (errno=%d %s) — aborting transfer", wrote,
+                         (unsigned)cr.payloadLen, errno, strerror(errno));
+            }
+        }
+        if (!persisted)
         {
-            ESP_LOGE(TAG, "fwrite short: wrote=%zu of %u (errno=%d %s) — aborting transfer", wrote,
-                     (unsigned)cr.payloadLen, errno, strerror(errno));
             AstrOs_SerialMsgHandler.sendFwChunkNak(transferIdIn, cr.highestContiguousSeq, cr.nextExpectedSeq,
                                                    "FLASH_FULL");
             resetCryptoAndFile(/*keepStaging=*/false);
@@ -429,7 +484,30 @@ void OtaReceiver::handleEnd(queue_ota_msg_t &msg)
         bool fileOpen = (staging_ != nullptr);
         bool fcloseOk = false;
         int fcloseErrno = 0;
-        if (fileOpen)
+        // Pipelined: the tail block is still in RAM and earlier blocks may
+        // still be queued. Drain them first; a write error that happened
+        // after the last chunk was ACKed can only be reported here, so it
+        // fails the finalize like a failed fclose.
+        bool drainOk = true;
+        if (stagingWriter_.active())
+        {
+            esp_err_t fErr = stagingWriter_.finish();
+            const OtaStagingWriter::Stats st = stagingWriter_.stats();
+            ESP_LOGI(TAG, "FW_TRANSFER_END staging: blocks=%u write=%ums max=%ums stall=%ums", (unsigned)st.blocks,
+                     (unsigned)(st.writeUs / 1000), (unsigned)(st.writeMaxUs / 1000), (unsigned)(st.stallUs / 1000));
+            if (fErr != ESP_OK)
+            {
+                ESP_LOGE(TAG, "FW_TRANSFER_END finalize: staging writer failed: %s", esp_err_to_name(fErr));
+                drainOk = false;
+            }
+        }
+        if (stagingWriter_.active())
+        {
+            // finish() timed out with a block still in flight: leave the FILE
+            // to the wedged write rather than close it underneath.
+            ESP_LOGE(TAG, "FW_TRANSFER_END finalize: staging writer wedged — leaving staging file open");
+        }
+        else if (fileOpen)
         {
             if (fclose(staging_) == 0)
             {
@@ -462,13 +540,13 @@ void OtaReceiver::handleEnd(queue_ota_msg_t &msg)
             AstrOsStringUtils::toHexLower(digest, sizeof(digest), computedHex);
         }
 
-        if (!fcloseOk || !hashOk)
+        if (!drainOk || !fcloseOk || !hashOk)
         {
             if (!fileOpen)
             {
                 ESP_LOGE(TAG, "FW_TRANSFER_END finalize: staging_ was null (BEGIN/chunk-handler bug)");
             }
-            else if (!fcloseOk)
+            else if (drainOk && !fcloseOk)
             {
                 ESP_LOGE(TAG, "FW_TRANSFER_END finalize: fclose failed errno=%d (%s)", fcloseErrno,
                          strerror(fcloseErrno));
@@ -0,0 +1,257 @@
+#include <OtaStagingWriter.hpp>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+static const char *TAG = "OtaStagingWriter";
+
+namespace
+{
+    uint32_t elapsedUs(int64_t since)
+    {
+        return static_cast<uint32_t>(esp_timer_get_time() - since);
+    }
+} // namespace
+
+bool OtaStagingWriter::Init()
+{
+    if (ready())
+    {
+        return true;
+    }
+    // Every job carries a block, so the job queue never holds more than
+    // there are blocks.
+    jobQueue_ = xQueueCreate(kBufferCount, sizeof(ota_staging_job_t));
+    freeQueue_ = xQueueCreate(kBufferCount, sizeof(uint8_t));
+    if (jobQueue_ == nullptr || freeQueue_ == nullptr)
+    {
+        for (QueueHandle_t *q : {&jobQueue_, &freeQueue_})
+        {
+            if (*q != nullptr)
+            {
+                vQueueDelete(*q);
+                *q = nullptr;
+            }
+        }
+        return false;
+    }
+    for (uint8_t i = 0; i < kBufferCount; i++)
+    {
+        xQueueSend(freeQueue_, &i, 0);
+    }
+    return true;
+}
+
+esp_err_t OtaStagingWriter::begin(FILE *file)
+{
+    if (!ready() || file == nullptr)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    abort();
+    if (active())
+    {
+        // abort() couldn't drain: the previous session is wedged.
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (ring_ == nullptr)
+    {
+        ring_ = new (std::nothrow) uint8_t[kBufferCount * kBlockSize];
+        if (ring_ == nullptr)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    fillIndex_ = -1;
+    fillLen_ = 0;
+    error_.store(ESP_OK);
+    errno_.store(0);
+    writeUs_.store(0);
+    writeMaxUs_.store(0);
+    blocks_.store(0);
+    stallUs_ = 0;
+    file_ = file;
+    return ESP_OK;
+}
+
+esp_err_t OtaStagingWriter::append(const uint8_t *data, size_t len)
+{
+    if (!active())
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    while (len > 0)
+    {
+        if (fillIndex_ < 0)
+        {
+            esp_err_t err = takeFreeBuffer();
+            if (err != ESP_OK)
+            {
+                return err;
+            }
+        }
+        const size_t n = std::min(len, kBlockSize - fillLen_);
+        std::memcpy(ring_ + size_t(fillIndex_) * kBlockSize + fillLen_, data, n);
+        fillLen_ += n;
+        data += n;
+        len -= n;
+        if (fillLen_ == kBlockSize)
+        {
+            esp_err_t err = submitFill();
+            if (err != ESP_OK)
+            {
+                return err;
+            }
+        }
+    }
+    // A failure on a block handed off earlier surfaces here, a few chunks late.
+    return error_.load();
+}
+
+esp_err_t OtaStagingWriter::finish()
+{
+    if (!active())
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = ESP_OK;
+    if (fillIndex_ >= 0)
+    {
+        err = submitFill();
+    }
+    if (!drain())
+    {
+        // otaStagingTask still holds a block: keep the ring (and the FILE
+        // pointer it writes through) alive rather than free it under it.
+        ESP_LOGE(TAG, "finish: in-flight blocks did not complete within %ums", (unsigned)kStallTimeoutMs);
+        return ESP_ERR_TIMEOUT;
+    }
+    if (err == ESP_OK)
+    {
+        err = error_.load();
+    }
+    if (err != ESP_OK && errno_.load() != 0)
+    {
+        ESP_LOGE(TAG, "staging write failed: errno=%d (%s)", errno_.load(), strerror(errno_.load()));
+    }
+    file_ = nullptr;
+    releaseRing();
+    return err;
+}
+
+void OtaStagingWriter::abort()
+{
+    if (!ready())
+    {
+        return;
+    }
+    if (fillIndex_ >= 0)
+    {
+        const uint8_t idx = static_cast<uint8_t>(fillIndex_);
+        xQueueSend(freeQueue_, &idx, 0);
+        fillIndex_ = -1;
+    }
+    if (file_ != nullptr && !drain())
+    {
+        // Same as finish: leak the session rather than free memory a wedged
+        // write is still using. The next begin() then times out cleanly.
+        ESP_LOGE(TAG, "abort: in-flight blocks did not complete within %ums", (unsigned)kStallTimeoutMs);
+        return;
+    }
+    file_ = nullptr;
+    fillLen_ = 0;
+    releaseRing();
+}
+
+OtaStagingWriter::Stats OtaStagingWriter::stats() const
+{
+    Stats s;
+    s.writeUs = writeUs_.load();
+    s.writeMaxUs = writeMaxUs_.load();
+    s.stallUs = stallUs_;
+    s.blocks = blocks_.load();
+    return s;
+}
+
+void OtaStagingWriter::process(const ota_staging_job_t &job)
+{
+    // After the first failure the session is dead: keep cycling blocks so
+    // otaReceiverTask never blocks, but don't touch the card again.
+    if (error_.load() == ESP_OK)
+    {
+        const int64_t t0 = esp_timer_get_time();
+        errno = 0;
+        const size_t wrote = std::fwrite(ring_ + size_t(job.buffer) * kBlockSize, 1, job.len, file_);
+        const uint32_t us = elapsedUs(t0);
+        writeUs_.fetch_add(us);
+        writeMaxUs_.store(std::max(writeMaxUs_.load(), us));
+        if (wrote == job.len)
+        {
+            blocks_.fetch_add(1);
+        }
+        else
+        {
+            errno_.store(errno);
+            error_.store(ESP_FAIL);
+        }
+    }
+    xQueueSend(freeQueue_, &job.buffer, portMAX_DELAY);
+}
+
+esp_err_t OtaStagingWriter::takeFreeBuffer()
+{
+    const int64_t t0 = esp_timer_get_time();
+    uint8_t idx = 0;
+    if (xQueueReceive(freeQueue_, &idx, pdMS_TO_TICKS(kStallTimeoutMs)) != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    stallUs_ += elapsedUs(t0);
+    fillIndex_ = idx;
+    return ESP_OK;
+}
+
+esp_err_t OtaStagingWriter::submitFill()
+{
+    const ota_staging_job_t job = {static_cast<uint8_t>(fillIndex_), static_cast<uint16_t>(fillLen_)};
+    // Can't be full: it holds at most the blocks not in freeQueue_, and
+    // this one is in our hands.
+    if (xQueueSend(jobQueue_, &job, 0) != pdTRUE)
+    {
+        return ESP_FAIL;
+    }
+    fillIndex_ = -1;
+    fillLen_ = 0;
+    return ESP_OK;
+}
+
+bool OtaStagingWriter::drain()
+{
+    // Every block back in freeQueue_ means every queued write has run.
+    uint8_t held[kBufferCount];
+    uint8_t n = 0;
+    for (; n < kBufferCount; n++)
+    {
+        if (xQueueReceive(freeQueue_, &held[n], pdMS_TO_TICKS(kStallTimeoutMs)) != pdTRUE)
+        {
+            break;
+        }
+    }
+    for (uint8_t i = 0; i < n; i++)
+    {
+        xQueueSend(freeQueue_, &held[i], 0);
+    }
+    return n == kBufferCount;
+}
+
+void OtaStagingWriter::releaseRing()
+{
+    delete[] ring_;
+    ring_ = nullptr;
+}
@@ -0,0 +1,161 @@
+#ifndef OTAFLASHPIPELINE_HPP
+#define OTAFLASHPIPELINE_HPP
+
+#include <AstrOsOtaMerkle.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// needed for QueueHandle_t, must be in this order
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <esp_err.h>
+#include <esp_partition.h>
+
+// One unit of work for otaFlashTask. `buffer` indexes the pipeline's sector
+// buffers and goes back to the free list when the job is done. len == 0 is
+// an erase-only job: posted by begin() so the first sectors erase while
+// chunk 0 is still in flight. verify != 0 (appendSector) reads the sector
+// back after programming and checks it against the buffer's leaf digest.
+typedef struct
+{
+    uint8_t buffer;
+    uint32_t offset; // sector-aligned partition offset the buffer lands at
+    uint16_t len;    // bytes to program; < kSectorSize only for the final buffer
+    uint8_t verify;
+} ota_flash_job_t;
+
+// Double-buffered, sector-aligned flash sink for the ESP-NOW OTA path.
+//
+// otaWriterTask appends image bytes into the fill buffer; every full 4 KB
+// sector is handed to otaFlashTask, which erases (if the erase-ahead hasn't
+// already) and programs it while otaWriterTask goes back to ACKing chunks.
+// After each sector it erases the next kEraseAheadSectors, so erase time
+// also overlaps with the radio instead of landing on the next write.
+//
+// Threading: begin / append / finish / abort run on otaWriterTask only;
+// process runs on otaFlashTask only. The two hand buffers back and forth
+// through freeQueue_ / jobQueue_ — the FreeRTOS queue operations are the
+// memory barrier for the buffer contents. The only shared scalars are the
+// std::atomic error / progress / timing fields.
+//
+// Backpressure: with both buffers queued, append blocks on freeQueue_ until
+// otaFlashTask returns one (bounded by kStallTimeoutMs). That wait is the
+// "radio stalled on flash" time the stats report.
+class OtaFlashPipeline
+{
+public:
+    static constexpr size_t kSectorSize = 4096;
+    static constexpr uint8_t kBufferCount = 2;
+    // Two sectors (8 KB) ahead covers a full 128 B-chunk window several
+    // times over without erasing far past the end of short images.
+    static constexpr uint32_t kEraseAheadSectors = 2;
+    // Worst-case sector erase on the supported flash parts is ~400 ms, and
+    // one job is at most an erase, a program and the erase-ahead; a buffer
+    // that takes longer than this to come back means flash is stuck. Below
+    // the sender's ACK timeout (OtaForwarder::kAckTimeoutMs), so a stuck
+    // flash fails the session here before the sender starts retrying
+    // chunks into it.
+    static constexpr uint32_t kStallTimeoutMs = 1200;
+
+    // Timing totals since the last begin(), microseconds. Read from
+    // otaWriterTask while otaFlashTask updates them, hence snapshots.
+    struct Stats
+    {
+        uint32_t eraseUs = 0;   // otaFlashTask: esp_partition_erase_range
+        uint32_t programUs = 0; // otaFlashTask: esp_partition_write
+        uint32_t verifyUs = 0;  // otaFlashTask: appendSector read-back + leaf hash
+        uint32_t stallUs = 0;   // otaWriterTask: waiting for a free buffer
+        uint32_t sectors = 0;   // buffers programmed
+    };
+
+    // Creates the two queues. Returns false on allocation failure; the
+    // caller then keeps writing through esp_ota_write on its own task.
+    bool Init();
+    bool ready() const
+    {
+        return jobQueue_ != nullptr;
+    }
+    // Queue otaFlashTask drains (pass as the task arg, main.cpp).
+    QueueHandle_t getJobQueue() const
+    {
+        return jobQueue_;
+    }
+
+    // Starts a write session at `startOffset`. Nothing below it is touched.
+    // An unaligned start (resume) pre-loads the sector's head from flash into
+    // the first fill buffer, so that sector is erased and re-programmed whole.
+    // Erase-ahead never passes `eraseLimit` (rounded up to a sector).
+    esp_err_t begin(const esp_partition_t *partition, uint32_t startOffset, uint32_t eraseLimit);
+    // Copies `len` bytes into the pipeline. Returns the first flash error seen
+    // so far (sticky), or ESP_ERR_TIMEOUT if no buffer came back in time.
+    esp_err_t append(const uint8_t *data, size_t len);
+    // One whole sector (or the short final one) of a Merkle-verified
+    // transfer, whose leaf digest is `leaf`. otaFlashTask reads the sector
+    // back after programming it and fails the session with
+    // ESP_ERR_INVALID_CRC if it doesn't hash to `leaf`, so every sector is
+    // checked against the tree on flash, not only in RAM. Must start on a
+    // sector boundary (no partial fill buffer); ESP_ERR_INVALID_STATE
+    // otherwise.
+    esp_err_t appendSector(const uint8_t *data, size_t len, const uint8_t leaf[AstrOsOtaMerkle::kHashSize]);
+    // Submits the partial tail buffer and waits until every byte is on flash.
+    // Returns the sticky error and ends the session, or ESP_ERR_TIMEOUT with
+    // the session left open if otaFlashTask is wedged (it still uses the
+    // partition).
+    esp_err_t finish();
+    // Drops the unsubmitted fill buffer, waits out in-flight jobs, ends the
+    // session. If the jobs don't drain the session stays open, and begin()
+    // refuses with ESP_ERR_TIMEOUT until they do. Idempotent.
+    void abort();
+
+    bool active() const
+    {
+        return partition_ != nullptr;
+    }
+    // Every appended byte below this offset has been programmed. Resume
+    // checkpoints are persisted only once they fall under it.
+    uint32_t flashedBytes() const
+    {
+        return flashedBytes_.load();
+    }
+    Stats stats() const;
+
+    // otaFlashTask entry point.
+    void process(const ota_flash_job_t &job);
+
+private:
+    esp_err_t takeFreeBuffer();
+    esp_err_t submitFill(bool verify = false);
+    bool sectorMatchesLeaf(const ota_flash_job_t &job);
+    bool drain();
+    esp_err_t eraseThrough(uint32_t end);
+
+    QueueHandle_t jobQueue_ = nullptr;
+    QueueHandle_t freeQueue_ = nullptr;
+    // Static singleton storage (OtaWriter is a global) — never on a stack.
+    uint8_t buffers_[kBufferCount][kSectorSize] = {};
+    // appendSector's expected leaf per buffer; travels with the buffer.
+    uint8_t leaves_[kBufferCount][AstrOsOtaMerkle::kHashSize] = {};
+
+    // otaWriterTask side.
+    const esp_partition_t *partition_ = nullptr;
+    int fillIndex_ = -1;      // buffer being filled, -1 = none held
+    uint32_t fillBase_ = 0;   // sector offset of the fill buffer
+    size_t fillLen_ = 0;      // bytes in the fill buffer
+    uint32_t eraseLimit_ = 0; // set in begin, read by otaFlashTask after the first job
+
+    // otaFlashTask side; begin() seeds it before the first job is queued.
+    uint32_t eraseWatermark_ = 0; // end of the erased span
+
+    std::atomic<esp_err_t> error_{ESP_OK};
+    std::atomic<uint32_t> flashedBytes_{0};
+    std::atomic<uint32_t> eraseUs_{0};
+    std::atomic<uint32_t> programUs_{0};
+    std::atomic<uint32_t> verifyUs_{0};
+    std::atomic<uint32_t> sectors_{0};
+    uint32_t stallUs_ = 0; // otaWriterTask only
+};
+
+#endif
@@ -2,7 +2,11 @@
 #define OTAWRITER_HPP
 
 #include <AstrOsBulkTransport.hpp>
+#include <AstrOsOtaCompress.hpp>
+#include <AstrOsOtaDelta.hpp>
+#include <AstrOsOtaMerkle.hpp>
 #include <AstrOsSha256.h>
+#include <OtaFlashPipeline.hpp>
 #include <OtaWriterQueueMessage.h>
 
 #include <atomic>
@@ -60,6 +64,17 @@ public:
         return otaWriterQueue_;
     }
 
+    // otaFlashTask plumbing (main.cpp): the task drains this queue and hands
+    // each job back here. nullptr if the pipeline failed to initialize.
+    QueueHandle_t getFlashJobQueue() const noexcept
+    {
+        return flash_.getJobQueue();
+    }
+    void processFlashJob(const ota_flash_job_t &job)
+    {
+        flash_.process(job);
+    }
+
 private:
     // Per-handler entry points. All run on otaWriterTask.
     void handleBegin(queue_ota_writer_msg_t &msg);
@@ -105,7 +120,9 @@ private:
     // Returns esp_err_t from the underlying send. Caller logs but does not
     // act on the result — a failed reply will be re-elicited by the
     // master's tick-driven retransmit.
-    esp_err_t sendBeginAck(const uint8_t mac[6], uint8_t xferId);
+    // resumeOffered selects the frame size: the full payload when the BEGIN
+    // carried OTA_BEGIN_FLAG_RESUME, the 1-byte legacy frame otherwise.
+    esp_err_t sendBeginAck(const uint8_t mac[6], uint8_t xferId, bool resumeOffered, uint32_t resumeSeq);
     esp_err_t sendBeginNak(const uint8_t mac[6], uint8_t xferId, OtaBeginNakReason reason);
     esp_err_t sendDataAck(const uint8_t mac[6], uint8_t xferId, uint32_t highestContiguousSeq, uint32_t nextExpectedSeq,
                           uint8_t windowRemaining);
@@ -123,6 +140,119 @@ private:
     // inline if-block.
     void logSendResult(const char *site, esp_err_t err);
 
+    // Single sink for image bytes on every path (wire full-image, wire
+    // delta/compressed, master self-flash): esp_ota_write + streaming SHA
+    // update + imageBytesWritten_. `leaf` (per-sector Merkle transfers
+    // only) routes one whole sector through flash_.appendSector.
+    esp_err_t writeImage(const uint8_t *data, size_t len, const uint8_t *leaf = nullptr);
+
+    // Decode pipeline for encoded transfers (OTA_BEGIN_FLAG_COMPRESSED /
+    // OTA_BEGIN_FLAG_DELTA): wire bytes -> [inflate] -> [delta apply] ->
+    // writeImage. beginDecodeStages opens the stages the flags select and
+    // returns false only if a delta base can't be located. consume/finish
+    // return false on the first failing stage, already logged; the caller
+    // NAKs (or fails the self-flash) and resets.
+    bool beginDecodeStages(uint8_t flags);
+    bool consumeEncoded(const uint8_t *data, size_t len);
+    bool consumeDecoded(const uint8_t *data, size_t len);
+    bool finishDecodeStages();
+    bool encodedTransfer() const
+    {
+        return deltaMode_ || compressedMode_;
+    }
+
+    // Merkle-verified transfers (OTA_BEGIN_FLAG_MERKLE). The wire carries
+    // the AstrOsOtaMerkle framed stream; merkle_ holds each block until it
+    // verifies against the BEGIN's root, and only then does the block reach
+    // the decode stages or the flash sink — so it runs ahead of inflate /
+    // delta. A rejected block is NAKed back (OTA_DATA_NAK reason BLOCK)
+    // from its record start instead of failing the image at END.
+    static bool merkleBlockOutCb(void *arg, uint32_t block, const uint8_t *data, size_t len,
+                                 const uint8_t leaf[AstrOsOtaMerkle::kHashSize]);
+    // Consecutive rejections of the same block before the transfer is
+    // failed: past a few, the staged file or the sender is bad, not the link.
+    static constexpr uint8_t kMaxBlockRejects = 8;
+
+    // StreamDecoder callbacks — arg is `this`. writeOut hands decoded bytes
+    // to consumeDecoded; acceptHeader checks a plain compressed image
+    // against the announced size/SHA before anything is written.
+    AstrOsOtaCompress::StreamIo inflateIo();
+    static bool inflateWriteOutCb(void *arg, const uint8_t *data, size_t len);
+    static bool inflateAcceptHeaderCb(void *arg, const AstrOsOtaCompress::StreamHeader &header);
+
+    // Delta OTA (OTA_BEGIN_FLAG_DELTA / staged patch file). PatchApplier
+    // callbacks — arg is `this`, same indirection as the timer callbacks.
+    // readBase reads the running partition; writeOut routes through
+    // writeImage; acceptHeader verifies the patch base before any flash
+    // write (see verifyRunningImageSha).
+    AstrOsOtaDelta::PatchIo deltaIo();
+    static bool deltaReadBaseCb(void *arg, uint32_t offset, uint8_t *out, size_t len);
+    static bool deltaWriteOutCb(void *arg, const uint8_t *data, size_t len);
+    static bool deltaAcceptHeaderCb(void *arg, const AstrOsOtaDelta::PatchHeader &header);
+    // SHA-256 over running partition [0, size) compared to `expected`.
+    // Proves the padawan runs the exact build the server diffed against —
+    // the POLL_ACK version string alone can't tell two builds apart.
+    bool verifyRunningImageSha(uint32_t size, const uint8_t expected[32]);
+
+    // Resumable transfers (OTA_BEGIN_FLAG_RESUME). A plain transfer persists
+    // its progress to NVS every kCheckpointIntervalBytes; a later BEGIN for
+    // the same image (SHA + geometry + target slot) continues from there
+    // instead of seq 0 — after a padawan power cut, a master reboot or a
+    // watchdog abort. Encoded transfers are never checkpointed: the inflate
+    // window and patch cursor are too large to persist, so they restart.
+    // A plain Merkle transfer checkpoints at block boundaries only, with the
+    // verifier's path alongside the SHA state (v2).
+    //
+    // Not a wire struct — versioned and length-checked on load instead.
+    struct ResumeCheckpoint
+    {
+        uint8_t version = 0;
+        uint8_t xferId = 0; // informational; a resume is keyed by image, not xferId
+        uint16_t chunkSize = 0;
+        uint32_t partitionAddress = 0;
+        uint32_t totalSize = 0;
+        uint32_t totalChunks = 0;
+        uint32_t nextSeq = 0;      // first seq not on flash
+        uint32_t bytesWritten = 0; // nextSeq * chunkSize
+        uint8_t imageSha256[32] = {0};
+        AstrOsSha256Ctx sha{}; // streaming SHA over [0, bytesWritten)
+        uint8_t merkleBlockLog2 = 0; // 0 = not a Merkle transfer
+        uint8_t merkleRoot[32] = {0};
+        AstrOsOtaMerkle::VerifierState merkle{}; // merkle.nextBlock * blockSize == bytesWritten
+    };
+    static constexpr uint8_t kCheckpointVersion = 2;
+    // 64 KB: a handful of NVS writes per image, and at most ~500 chunks of
+    // the default 128 B re-sent after a restart.
+    static constexpr uint32_t kCheckpointIntervalBytes = 64u * 1024u;
+
+    // Loads the checkpoint and returns true only if it matches this BEGIN
+    // and the current inactive partition.
+    bool loadMatchingCheckpoint(const queue_ota_writer_msg_t &msg, ResumeCheckpoint &out);
+    // A checkpoint describes bytes on flash, but flash_ programs a sector
+    // behind the radio. So a checkpoint is first snapshotted as pending and
+    // only persisted once flash_.flashedBytes() has passed it.
+    void snapshotCheckpoint(uint32_t nextSeq);
+    void persistPendingCheckpoint();
+    // Best effort: a failed save costs progress on the next restart, never
+    // the transfer, so both only log. clearCheckpoint also drops a pending one.
+    void saveCheckpoint(const ResumeCheckpoint &ckpt);
+    void clearCheckpoint();
+
+    // Per-stage wall time for the current transfer, so a stats line shows
+    // where a slow transfer spends its time. Writer-side stages only; the
+    // flash-side erase/program totals come from flash_.stats().
+    struct StageTimes
+    {
+        uint64_t bulkUs = 0;       // BulkReceiver::onChunk (seq + CRC checks)
+        uint64_t decodeUs = 0;     // inflate / delta apply, excluding sink + sha below
+        uint64_t sinkUs = 0;       // hand-off to flash_ (incl. stalls) or esp_ota_write
+        uint64_t shaUs = 0;        // streaming SHA-256
+        uint64_t merkleUs = 0;     // block verification, excluding the stages it feeds
+        uint64_t ackUs = 0;        // DATA_ACK / NAK send
+        uint64_t checkpointUs = 0; // NVS commits
+    };
+    void logStageTimes(const char *when);
+
     std::atomic<bool> active_{false};
     QueueHandle_t otaWriterQueue_ = nullptr;
 
@@ -147,8 +277,43 @@ private:
     uint8_t currentMasterMac_[6] = {0};
     uint32_t currentTotalSize_ = 0;
     uint32_t currentTotalChunks_ = 0;
+    uint16_t currentChunkSize_ = 0;
     uint8_t expectedSha256_[32] = {0};
 
+    // Decode state — live only for encoded transfers. There
+    // currentTotalSize_ counts encoded bytes on the wire; the image size is
+    // imageBytesWritten_. inflate_ carries its 4 KB window inline, which is
+    // why it lives here (static singleton) and never on otaWriterTask's stack.
+    bool deltaMode_ = false;
+    bool compressedMode_ = false;
+    const esp_partition_t *runningPartition_ = nullptr;
+    AstrOsOtaDelta::PatchApplier delta_;
+    AstrOsOtaCompress::StreamDecoder inflate_;
+    uint32_t imageBytesWritten_ = 0;
+    esp_err_t imageWriteErr_ = ESP_OK; // last writeImage failure inside a decode stage, for logging
+
+    // Merkle state — live only with OTA_BEGIN_FLAG_MERKLE. merkleSectors_:
+    // plain image, 4 KB blocks and the flash pipeline, so each block goes
+    // down as one appendSector and is read back against its leaf.
+    bool merkleMode_ = false;
+    bool merkleSectors_ = false;
+    uint8_t merkleRoot_[32] = {0};
+    uint8_t merkleRejects_ = 0;
+    AstrOsOtaMerkle::BlockVerifier merkle_;
+
+    // Wire transfers write through flash_ on otaFlashTask rather than an
+    // esp_ota handle (which would also always start at offset 0, ruling out
+    // resume). otaHandle_ then stays 0; the master self-flash path and the
+    // no-pipeline fallback still use esp_ota_write.
+    OtaFlashPipeline flash_;
+
+    // Resume state.
+    uint32_t lastCheckpointBytes_ = 0; // imageBytesWritten_ at the last snapshot
+    ResumeCheckpoint pendingCheckpoint_;
+    bool pendingCheckpointValid_ = false;
+
+    StageTimes stageUs_;
+
     // Stats counters (reset in handleBegin success path). All read+written
     // only by otaWriterTask — no atomics. NAKs split by wire reason so a
     // bench log can pinpoint which failure mode dominates.
@@ -159,6 +324,7 @@ private:
     uint32_t statsNaksSIZE_ = 0;
     uint32_t statsNaksOOO_ = 0;
     uint32_t statsNaksFLASH_ = 0;
+    uint32_t statsNaksBLOCK_ = 0;
     uint32_t statsSendFailCount_ = 0;
 };
 
@@ -62,6 +62,10 @@ extern "C"
                 uint32_t totalChunks;
                 uint8_t sha256Expected[32];
                 uint8_t flags;
+                // OtaBeginMerkleExt, set when flags has OTA_BEGIN_FLAG_MERKLE.
+                uint32_t merkleDataSize;
+                uint8_t merkleBlockLog2;
+                uint8_t merkleRoot[32];
             } begin;
 
             struct
@@ -86,7 +90,9 @@ extern "C"
             {
                 char firmwarePath[64];
                 uint32_t expectedSize;
-                uint8_t expectedSha256[32];
+                uint8_t expectedSha256[32]; // SHA-256 of the staged file
+                uint8_t flags;              // OTA_BEGIN_FLAG_* the forwarder derived from the staged file's header
+                uint8_t imageSha256[32];    // digest of the decoded image; meaningful only when flags != 0
             } local_flash_req;
             // OTA_WR_WATCHDOG_FIRE and OTA_WR_STATS_FIRE have no union arm.
         };
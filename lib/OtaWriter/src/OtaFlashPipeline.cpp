@@ -0,0 +1,374 @@
+#include <OtaFlashPipeline.hpp>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <cstring>
+
+static const char *TAG = "OtaFlashPipeline";
+
+namespace
+{
+    constexpr uint32_t kEraseAheadBytes = OtaFlashPipeline::kEraseAheadSectors * OtaFlashPipeline::kSectorSize;
+
+    uint32_t alignUpToSector(uint64_t offset)
+    {
+        constexpr uint64_t s = OtaFlashPipeline::kSectorSize;
+        return static_cast<uint32_t>((offset + s - 1) / s * s);
+    }
+
+    uint32_t elapsedUs(int64_t since)
+    {
+        return static_cast<uint32_t>(esp_timer_get_time() - since);
+    }
+} // namespace
+
+bool OtaFlashPipeline::Init()
+{
+    if (ready())
+    {
+        return true;
+    }
+    // Every job carries a buffer, so the job queue never holds more than
+    // there are buffers.
+    jobQueue_ = xQueueCreate(kBufferCount, sizeof(ota_flash_job_t));
+    freeQueue_ = xQueueCreate(kBufferCount, sizeof(uint8_t));
+    if (jobQueue_ == nullptr || freeQueue_ == nullptr)
+    {
+        for (QueueHandle_t *q : {&jobQueue_, &freeQueue_})
+        {
+            if (*q != nullptr)
+            {
+                vQueueDelete(*q);
+                *q = nullptr;
+            }
+        }
+        return false;
+    }
+    for (uint8_t i = 0; i < kBufferCount; i++)
+    {
+        xQueueSend(freeQueue_, &i, 0);
+    }
+    return true;
+}
+
+esp_err_t OtaFlashPipeline::begin(const esp_partition_t *partition, uint32_t startOffset, uint32_t eraseLimit)
+{
+    if (!ready() || partition == nullptr || startOffset > partition->size)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    abort();
+    if (partition_ != nullptr)
+    {
+        // The previous session's jobs still haven't drained.
+        return ESP_ERR_TIMEOUT;
+    }
+
+    const uint32_t sectorStart = startOffset - (startOffset % kSectorSize);
+    partition_ = partition;
+    eraseLimit_ = std::min(alignUpToSector(eraseLimit), static_cast<uint32_t>(partition->size));
+    eraseWatermark_ = sectorStart;
+    fillBase_ = sectorStart;
+    fillLen_ = 0;
+    error_.store(ESP_OK);
+    flashedBytes_.store(sectorStart);
+    eraseUs_.store(0);
+    programUs_.store(0);
+    verifyUs_.store(0);
+    sectors_.store(0);
+    stallUs_ = 0;
+
+    // Resume mid-sector: the bytes after startOffset may be stale, and NOR
+    // flash can't reprogram without an erase. Carry the valid head in RAM so
+    // the sector goes back down whole.
+    const size_t head = startOffset - sectorStart;
+    if (head > 0)
+    {
+        esp_err_t err = takeFreeBuffer();
+        if (err == ESP_OK)
+        {
+            err = esp_partition_read(partition, sectorStart, buffers_[fillIndex_], head);
+        }
+        if (err != ESP_OK)
+        {
+            abort();
+            return err;
+        }
+        fillLen_ = head;
+    }
+
+    // Start erasing now so the first sector is ready before it fills. The
+    // job borrows the spare buffer (len 0) purely so drain() can tell when
+    // it has run; the first sector doesn't need that buffer until it fills.
+    uint8_t spare = 0;
+    if (xQueueReceive(freeQueue_, &spare, 0) == pdTRUE)
+    {
+        const ota_flash_job_t job = {spare, sectorStart, 0, 0};
+        xQueueSend(jobQueue_, &job, 0);
+    }
+    return ESP_OK;
+}
+
+esp_err_t OtaFlashPipeline::append(const uint8_t *data, size_t len)
+{
+    if (!active())
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (static_cast<uint64_t>(fillBase_) + fillLen_ + len > partition_->size)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    while (len > 0)
+    {
+        if (fillIndex_ < 0)
+        {
+            esp_err_t err = takeFreeBuffer();
+            if (err != ESP_OK)
+            {
+                return err;
+            }
+        }
+        const size_t n = std::min(len, kSectorSize - fillLen_);
+        std::memcpy(buffers_[fillIndex_] + fillLen_, data, n);
+        fillLen_ += n;
+        data += n;
+        len -= n;
+        if (fillLen_ == kSectorSize)
+        {
+            esp_err_t err = submitFill();
+            if (err != ESP_OK)
+            {
+                return err;
+            }
+        }
+    }
+    // A failure on a sector handed off earlier surfaces here, one chunk late.
+    return error_.load();
+}
+
+esp_err_t OtaFlashPipeline::appendSector(const uint8_t *data, size_t len,
+                                         const uint8_t leaf[AstrOsOtaMerkle::kHashSize])
+{
+    if (!active() || fillLen_ != 0 || len == 0 || len > kSectorSize)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (static_cast<uint64_t>(fillBase_) + len > partition_->size)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (fillIndex_ < 0)
+    {
+        esp_err_t err = takeFreeBuffer();
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    std::memcpy(buffers_[fillIndex_], data, len);
+    std::memcpy(leaves_[fillIndex_], leaf, AstrOsOtaMerkle::kHashSize);
+    fillLen_ = len;
+    esp_err_t err = submitFill(/*verify=*/true);
+    return err != ESP_OK ? err : error_.load();
+}
+
+esp_err_t OtaFlashPipeline::finish()
+{
+    if (!active())
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = ESP_OK;
+    if (fillIndex_ >= 0)
+    {
+        err = submitFill();
+    }
+    if (!drain())
+    {
+        // otaFlashTask is still inside a flash call on partition_: keep it
+        // rather than clear it under the job. abort() / begin() retry.
+        ESP_LOGE(TAG, "finish: in-flight sectors did not complete within %ums", (unsigned)kStallTimeoutMs);
+        return ESP_ERR_TIMEOUT;
+    }
+    if (err == ESP_OK)
+    {
+        err = error_.load();
+    }
+    partition_ = nullptr;
+    return err;
+}
+
+void OtaFlashPipeline::abort()
+{
+    if (!ready())
+    {
+        return;
+    }
+    if (fillIndex_ >= 0)
+    {
+        const uint8_t idx = static_cast<uint8_t>(fillIndex_);
+        xQueueSend(freeQueue_, &idx, 0);
+        fillIndex_ = -1;
+    }
+    fillLen_ = 0;
+    if (partition_ != nullptr && !drain())
+    {
+        // otaFlashTask is wedged inside a flash call that still reads
+        // partition_ (and the erase watermark begin() would reseed). Leave
+        // the session open; begin() refuses until a later drain succeeds.
+        ESP_LOGE(TAG, "abort: in-flight sectors did not complete within %ums", (unsigned)kStallTimeoutMs);
+        return;
+    }
+    partition_ = nullptr;
+}
+
+OtaFlashPipeline::Stats OtaFlashPipeline::stats() const
+{
+    Stats s;
+    s.eraseUs = eraseUs_.load();
+    s.programUs = programUs_.load();
+    s.verifyUs = verifyUs_.load();
+    s.stallUs = stallUs_;
+    s.sectors = sectors_.load();
+    return s;
+}
+
+void OtaFlashPipeline::process(const ota_flash_job_t &job)
+{
+    if (job.len == 0)
+    {
+        if (error_.load() == ESP_OK)
+        {
+            esp_err_t err = eraseThrough(std::min(job.offset + kEraseAheadBytes, eraseLimit_));
+            if (err != ESP_OK)
+            {
+                error_.store(err);
+            }
+        }
+        xQueueSend(freeQueue_, &job.buffer, portMAX_DELAY);
+        return;
+    }
+
+    // After the first failure the session is dead: keep cycling buffers so
+    // otaWriterTask never blocks, but don't touch flash again.
+    if (error_.load() == ESP_OK)
+    {
+        esp_err_t err = eraseThrough(job.offset + job.len);
+        if (err == ESP_OK)
+        {
+            const int64_t t0 = esp_timer_get_time();
+            err = esp_partition_write(partition_, job.offset, buffers_[job.buffer], job.len);
+            programUs_.fetch_add(elapsedUs(t0));
+        }
+        if (err == ESP_OK && job.verify != 0 && !sectorMatchesLeaf(job))
+        {
+            err = ESP_ERR_INVALID_CRC;
+        }
+        if (err == ESP_OK)
+        {
+            // Only after the read-back: a checkpoint must never cover a
+            // sector that didn't verify.
+            flashedBytes_.store(job.offset + job.len);
+            sectors_.fetch_add(1);
+            // Erase-ahead: while otaWriterTask fills the other buffer.
+            const uint32_t ahead = alignUpToSector(job.offset + job.len) + kEraseAheadBytes;
+            err = eraseThrough(std::min(ahead, eraseLimit_));
+        }
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "sector at 0x%lx (%u B) failed: %s", (unsigned long)job.offset, (unsigned)job.len,
+                     esp_err_to_name(err));
+            error_.store(err);
+        }
+    }
+    xQueueSend(freeQueue_, &job.buffer, portMAX_DELAY);
+}
+
+bool OtaFlashPipeline::sectorMatchesLeaf(const ota_flash_job_t &job)
+{
+    // The buffer's contents are already on flash, so it doubles as the
+    // read-back target — no second 4 KB on otaFlashTask's stack.
+    const int64_t t0 = esp_timer_get_time();
+    uint8_t *buf = buffers_[job.buffer];
+    bool ok = esp_partition_read(partition_, job.offset, buf, job.len) == ESP_OK;
+    if (ok)
+    {
+        AstrOsSha256Ctx ctx;
+        AstrOsOtaMerkle::leafBegin(ctx);
+        AstrOsSha256_update(&ctx, buf, job.len);
+        uint8_t digest[AstrOsOtaMerkle::kHashSize];
+        AstrOsSha256_final(&ctx, digest);
+        ok = std::memcmp(digest, leaves_[job.buffer], sizeof(digest)) == 0;
+    }
+    verifyUs_.fetch_add(elapsedUs(t0));
+    return ok;
+}
+
+esp_err_t OtaFlashPipeline::takeFreeBuffer()
+{
+    const int64_t t0 = esp_timer_get_time();
+    uint8_t idx = 0;
+    if (xQueueReceive(freeQueue_, &idx, pdMS_TO_TICKS(kStallTimeoutMs)) != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    stallUs_ += elapsedUs(t0);
+    fillIndex_ = idx;
+    return ESP_OK;
+}
+
+esp_err_t OtaFlashPipeline::submitFill(bool verify)
+{
+    const ota_flash_job_t job = {static_cast<uint8_t>(fillIndex_), fillBase_, static_cast<uint16_t>(fillLen_),
+                                 static_cast<uint8_t>(verify ? 1 : 0)};
+    // Can't be full: it holds at most the buffers not in freeQueue_, and
+    // this one is in our hands.
+    if (xQueueSend(jobQueue_, &job, 0) != pdTRUE)
+    {
+        return ESP_FAIL;
+    }
+    fillIndex_ = -1;
+    fillBase_ += kSectorSize;
+    fillLen_ = 0;
+    return ESP_OK;
+}
+
+bool OtaFlashPipeline::drain()
+{
+    // Every buffer back in freeQueue_ means every queued job has run,
+    // including begin()'s erase-only one.
+    uint8_t held[kBufferCount];
+    uint8_t n = 0;
+    for (; n < kBufferCount; n++)
+    {
+        if (xQueueReceive(freeQueue_, &held[n], pdMS_TO_TICKS(kStallTimeoutMs)) != pdTRUE)
+        {
+            break;
+        }
+    }
+    for (uint8_t i = 0; i < n; i++)
+    {
+        xQueueSend(freeQueue_, &held[i], 0);
+    }
+    return n == kBufferCount;
+}
+
+esp_err_t OtaFlashPipeline::eraseThrough(uint32_t end)
+{
+    end = std::min(alignUpToSector(end), static_cast<uint32_t>(partition_->size));
+    if (end <= eraseWatermark_)
+    {
+        return ESP_OK;
+    }
+    const int64_t t0 = esp_timer_get_time();
+    esp_err_t err = esp_partition_erase_range(partition_, eraseWatermark_, end - eraseWatermark_);
+    eraseUs_.fetch_add(elapsedUs(t0));
+    if (err == ESP_OK)
+    {
+        eraseWatermark_ = end;
+    }
+    return err;
+}
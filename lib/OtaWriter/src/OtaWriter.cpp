@@ -2,7 +2,9 @@
 
 #include <AstrOsEspNowService.hpp>
 #include <OtaForwarder.hpp>
+#include <esp_image_format.h>
 #include <esp_log.h>
+#include <nvs.h>
 
 #include <algorithm>
 #include <cstdio>
@@ -11,6 +13,15 @@
 
 static const char *TAG = "OtaWriter";
 
+// NVS location of the resume checkpoint (OtaWriter::ResumeCheckpoint).
+static const char *kResumeNvsNamespace = "ota_writer";
+static const char *kResumeNvsKey = "resume";
+
+// A stalled flash must fail the session before the sender's ACK timeout
+// fires and it starts retransmitting chunks we are blocked on.
+static_assert(OtaFlashPipeline::kStallTimeoutMs < OtaForwarder::kAckTimeoutMs,
+              "flash stall timeout must be shorter than the sender's ACK timeout");
+
 OtaWriter AstrOs_OtaWriter;
 
 OtaWriter::OtaWriter() {}
@@ -71,7 +82,15 @@ void OtaWriter::Init(QueueHandle_t otaWriterQueue)
         statsTimer_ = nullptr;
     }
 
-    ESP_LOGI(TAG, "OtaWriter initialized (watchdog idle threshold: %llums)", kWatchdogIdleUs / 1000ULL);
+    if (!flash_.Init())
+    {
+        // Transfers still work, just without the overlap: writeImage falls
+        // back to esp_ota_write on otaWriterTask.
+        ESP_LOGE(TAG, "flash pipeline queue allocation failed — writing synchronously");
+    }
+
+    ESP_LOGI(TAG, "OtaWriter initialized (watchdog idle threshold: %llums, flash pipeline: %s)",
+             kWatchdogIdleUs / 1000ULL, flash_.ready() ? "on" : "off");
 }
 
 void OtaWriter::watchdogTimerCb(void *arg)
@@ -165,10 +184,30 @@ void OtaWriter::handleStatsFire()
         return;
     }
     const long long acked = statsAnyAcked_ ? static_cast<long long>(statsHighestAckedSeq_) : -1;
-    ESP_LOGI(TAG, "OTA_STATS_RX: xferId=%u seq=%u/%u acked=%lld naks-tx(CRC=%u SIZE=%u OOO=%u FLASH=%u) send-fail=%u",
+    ESP_LOGI(TAG,
+             "OTA_STATS_RX: xferId=%u seq=%u/%u acked=%lld naks-tx(CRC=%u SIZE=%u OOO=%u FLASH=%u BLOCK=%u) "
+             "send-fail=%u",
              (unsigned)currentXferId_, (unsigned)statsLastRecvSeq_, (unsigned)currentTotalChunks_, acked,
              (unsigned)statsNaksCRC_, (unsigned)statsNaksSIZE_, (unsigned)statsNaksOOO_, (unsigned)statsNaksFLASH_,
-             (unsigned)statsSendFailCount_);
+             (unsigned)statsNaksBLOCK_, (unsigned)statsSendFailCount_);
+    logStageTimes("progress");
+}
+
+void OtaWriter::logStageTimes(const char *when)
+{
+    // Where the transfer's time went. bulk/merkle/decode/sink/sha/ack/ckpt
+    // are otaWriterTask's own stages; erase/program/verify run on
+    // otaFlashTask in parallel with them, and stall is how long the writer
+    // waited on it.
+    const OtaFlashPipeline::Stats f = flash_.stats();
+    ESP_LOGI(TAG,
+             "OTA_STATS_TIME(%s): xferId=%u ms bulk=%llu merkle=%llu decode=%llu sink=%llu sha=%llu ack=%llu "
+             "ckpt=%llu | flash erase=%u program=%u verify=%u stall=%u sectors=%u",
+             when, (unsigned)currentXferId_, stageUs_.bulkUs / 1000ULL, stageUs_.merkleUs / 1000ULL,
+             stageUs_.decodeUs / 1000ULL, stageUs_.sinkUs / 1000ULL, stageUs_.shaUs / 1000ULL,
+             stageUs_.ackUs / 1000ULL, stageUs_.checkpointUs / 1000ULL, (unsigned)(f.eraseUs / 1000),
+             (unsigned)(f.programUs / 1000), (unsigned)(f.verifyUs / 1000), (unsigned)(f.stallUs / 1000),
+             (unsigned)f.sectors);
 }
 
 void OtaWriter::resetOtaHandleAndSha()
@@ -178,6 +217,10 @@ void OtaWriter::resetOtaHandleAndSha()
     // late-signal path below (active_ = false by the time it dispatches).
     watchdogStop();
     statsTimerStop();
+    // Wait out the sectors otaFlashTask still holds, then keep whatever
+    // resume point they completed — an abort is exactly when it's needed.
+    flash_.abort();
+    persistPendingCheckpoint();
     if (otaHandle_ != 0)
     {
         // esp_ota_abort releases the handle. Return value isn't actionable
@@ -196,7 +239,22 @@ void OtaWriter::resetOtaHandleAndSha()
     currentXferId_ = 0;
     memset(currentMasterMac_, 0, sizeof(currentMasterMac_));
     currentTotalSize_ = 0;
+    currentChunkSize_ = 0;
     memset(expectedSha256_, 0, sizeof(expectedSha256_));
+    deltaMode_ = false;
+    compressedMode_ = false;
+    runningPartition_ = nullptr;
+    delta_.reset();
+    inflate_.reset();
+    imageBytesWritten_ = 0;
+    imageWriteErr_ = ESP_OK;
+    merkleMode_ = false;
+    merkleSectors_ = false;
+    memset(merkleRoot_, 0, sizeof(merkleRoot_));
+    merkleRejects_ = 0;
+    merkle_.reset();
+    lastCheckpointBytes_ = 0;
+    pendingCheckpointValid_ = false;
     active_ = false;
 }
 
@@ -265,43 +323,102 @@ void OtaWriter::handleBegin(queue_ota_writer_msg_t &msg)
         return;
     }
 
-    if (msg.begin.totalSize > inactivePartition_->size)
+    // Merkle: the tree must describe exactly the framed stream announced,
+    // and the size that has to fit is the file inside it.
+    const bool merkleOffered = (msg.begin.flags & OTA_BEGIN_FLAG_MERKLE) != 0;
+    AstrOsOtaMerkle::Geometry geo;
+    if (merkleOffered && (!geo.init(msg.begin.merkleDataSize, msg.begin.merkleBlockLog2) ||
+                          geo.streamSize() != msg.begin.totalSize))
     {
-        ESP_LOGW(TAG, "handleBegin: totalSize=%u exceeds partition '%s' size=%u — NAK NO_PARTITION",
-                 (unsigned)msg.begin.totalSize, inactivePartition_->label, (unsigned)inactivePartition_->size);
+        ESP_LOGW(TAG, "handleBegin: bad Merkle geometry (dataSize=%u blockLog2=%u totalSize=%u) — NAK BEGIN_FAILED",
+                 (unsigned)msg.begin.merkleDataSize, (unsigned)msg.begin.merkleBlockLog2,
+                 (unsigned)msg.begin.totalSize);
         inactivePartition_ = nullptr;
-        logSendResult("handleBegin NO_PARTITION (oversize) NAK",
-                      sendBeginNak(mac, xferId, OtaBeginNakReason::NO_PARTITION));
+        logSendResult("handleBegin BEGIN_FAILED (merkle geometry) NAK",
+                      sendBeginNak(mac, xferId, OtaBeginNakReason::BEGIN_FAILED));
         return;
     }
+    const uint32_t fileSize = merkleOffered ? msg.begin.merkleDataSize : msg.begin.totalSize;
 
-    // OTA_SIZE_UNKNOWN tells esp_ota_begin to erase sectors lazily inside
-    // esp_ota_write. Passing the exact totalSize would erase the entire
-    // reserved span up front — a ~2 MB (8MB board) / ~6.4 MB (16MB board)
-    // one-shot erase that can exceed the BEGIN_ACK timeout window.
-    esp_err_t bErr = esp_ota_begin(inactivePartition_, OTA_SIZE_UNKNOWN, &otaHandle_);
-    if (bErr != ESP_OK)
+    if (fileSize > inactivePartition_->size)
     {
-        ESP_LOGE(TAG, "handleBegin: esp_ota_begin failed: %s — NAK BEGIN_FAILED", esp_err_to_name(bErr));
-        otaHandle_ = 0;
+        ESP_LOGW(TAG, "handleBegin: size=%u exceeds partition '%s' size=%u — NAK NO_PARTITION", (unsigned)fileSize,
+                 inactivePartition_->label, (unsigned)inactivePartition_->size);
         inactivePartition_ = nullptr;
-        logSendResult("handleBegin BEGIN_FAILED (esp_ota_begin) NAK",
-                      sendBeginNak(mac, xferId, OtaBeginNakReason::BEGIN_FAILED));
+        logSendResult("handleBegin NO_PARTITION (oversize) NAK",
+                      sendBeginNak(mac, xferId, OtaBeginNakReason::NO_PARTITION));
         return;
     }
 
+    // Resume only if the master can seek (it offered RESUME) and the stream
+    // is plain — see ResumeCheckpoint for why encoded transfers restart.
+    const bool resumeOffered = (msg.begin.flags & OTA_BEGIN_FLAG_RESUME) != 0;
+    const bool plainStream = (msg.begin.flags & (OTA_BEGIN_FLAG_DELTA | OTA_BEGIN_FLAG_COMPRESSED)) == 0;
+    ResumeCheckpoint ckpt{};
+    const bool resuming = resumeOffered && plainStream && flash_.ready() && loadMatchingCheckpoint(msg, ckpt);
+
+    // Any checkpoint is stale from here on: a fresh transfer rewrites the
+    // partition from offset 0, and a resumed one re-programs the sector the
+    // checkpoint points into. Cleared before any erase so a power cut
+    // mid-erase can't resume onto wiped bytes; a resume re-arms it once that
+    // sector is back on flash (pendingCheckpoint_ below). A failed resume
+    // therefore retries fresh instead of failing the same way again.
+    clearCheckpoint();
+
+    if (flash_.ready())
+    {
+        // Nothing is erased up front: otaFlashTask erases ahead of the write
+        // cursor while chunks arrive, so BEGIN_ACK goes out at once. An
+        // encoded transfer doesn't know its image size yet — its erase-ahead
+        // is bounded by the partition instead.
+        const uint32_t startOffset = resuming ? ckpt.bytesWritten : 0;
+        const uint32_t eraseLimit = plainStream ? fileSize : inactivePartition_->size;
+        esp_err_t fErr = flash_.begin(inactivePartition_, startOffset, eraseLimit);
+        if (fErr != ESP_OK)
+        {
+            ESP_LOGE(TAG, "handleBegin: flash pipeline begin at offset %u failed: %s — NAK BEGIN_FAILED",
+                     (unsigned)startOffset, esp_err_to_name(fErr));
+            inactivePartition_ = nullptr;
+            logSendResult("handleBegin BEGIN_FAILED (flash pipeline) NAK",
+                          sendBeginNak(mac, xferId, OtaBeginNakReason::BEGIN_FAILED));
+            return;
+        }
+    }
+    else
+    {
+        // Fallback when Init couldn't create otaFlashTask's queues: the
+        // original synchronous esp_ota_write path, no resume.
+        //
+        // OTA_SIZE_UNKNOWN tells esp_ota_begin to erase sectors lazily inside
+        // esp_ota_write. Passing the exact totalSize would erase the entire
+        // reserved span up front — a ~2 MB (8MB board) / ~6.4 MB (16MB board)
+        // one-shot erase that can exceed the BEGIN_ACK timeout window.
+        esp_err_t bErr = esp_ota_begin(inactivePartition_, OTA_SIZE_UNKNOWN, &otaHandle_);
+        if (bErr != ESP_OK)
+        {
+            ESP_LOGE(TAG, "handleBegin: esp_ota_begin failed: %s — NAK BEGIN_FAILED", esp_err_to_name(bErr));
+            otaHandle_ = 0;
+            inactivePartition_ = nullptr;
+            logSendResult("handleBegin BEGIN_FAILED (esp_ota_begin) NAK",
+                          sendBeginNak(mac, xferId, OtaBeginNakReason::BEGIN_FAILED));
+            return;
+        }
+    }
+    const uint32_t resumeSeq = resuming ? ckpt.nextSeq : 0;
+
     // Must equal the master's BulkSender kWindowSize in OtaForwarder.hpp
     // (currently 4). Mismatched windows desync ack accounting. windowSize is
     // not carried on the OTA_BEGIN wire payload, so it can't be derived here —
     // the two compile-time constants must be kept in lockstep by hand.
     constexpr uint8_t kWindowSize = 4;
-    auto br = bulk_.begin(xferId, msg.begin.totalSize, msg.begin.totalChunks, msg.begin.chunkSize, kWindowSize);
+    auto br = bulk_.begin(xferId, msg.begin.totalSize, msg.begin.totalChunks, msg.begin.chunkSize, kWindowSize,
+                          resumeSeq);
     if (!br.valid)
     {
         ESP_LOGW(TAG, "handleBegin: BulkReceiver::begin rejected: reason=%d (totalSize=%u chunks=%u chunkSize=%u)",
                  (int)br.reason, (unsigned)msg.begin.totalSize, (unsigned)msg.begin.totalChunks,
                  (unsigned)msg.begin.chunkSize);
-        // esp_ota_begin succeeded but BulkReceiver setup failed —
+        // The flash sink is open but BulkReceiver setup failed —
         // resetOtaHandleAndSha clears the partial state.
         resetOtaHandleAndSha();
         logSendResult("handleBegin BEGIN_FAILED (BulkReceiver) NAK",
@@ -309,13 +426,53 @@ void OtaWriter::handleBegin(queue_ota_writer_msg_t &msg)
         return;
     }
 
-    AstrOsSha256_init(&shaCtx_);
+    // Encoded transfers: the stream headers (compressed / delta) arrive in
+    // chunk 0 and are checked there — BEGIN only selects the stages.
+    if (!beginDecodeStages(msg.begin.flags))
+    {
+        resetOtaHandleAndSha();
+        logSendResult("handleBegin NO_PARTITION (delta base) NAK",
+                      sendBeginNak(mac, xferId, OtaBeginNakReason::NO_PARTITION));
+        return;
+    }
+
+    merkleMode_ = merkleOffered;
+    if (merkleMode_)
+    {
+        memcpy(merkleRoot_, msg.begin.merkleRoot, sizeof(merkleRoot_));
+        merkleSectors_ = plainStream && flash_.active() && geo.blockSize() == OtaFlashPipeline::kSectorSize;
+        merkleRejects_ = 0;
+        const bool started = resuming ? merkle_.resume(geo, merkleRoot_, ckpt.merkle, &merkleBlockOutCb, this)
+                                      : merkle_.begin(geo, merkleRoot_, &merkleBlockOutCb, this);
+        if (!started)
+        {
+            resetOtaHandleAndSha();
+            logSendResult("handleBegin BEGIN_FAILED (merkle) NAK",
+                          sendBeginNak(mac, xferId, OtaBeginNakReason::BEGIN_FAILED));
+            return;
+        }
+    }
+
+    if (resuming)
+    {
+        // Pick up the streaming SHA and the write cursor exactly where the
+        // checkpoint left them; the bytes before it are already on flash.
+        shaCtx_ = ckpt.sha;
+        imageBytesWritten_ = ckpt.bytesWritten;
+    }
+    else
+    {
+        AstrOsSha256_init(&shaCtx_);
+    }
     shaActive_ = true;
+    lastCheckpointBytes_ = imageBytesWritten_;
+    stageUs_ = StageTimes{};
 
     currentXferId_ = xferId;
     memcpy(currentMasterMac_, mac, sizeof(currentMasterMac_));
     currentTotalSize_ = msg.begin.totalSize;
     currentTotalChunks_ = msg.begin.totalChunks;
+    currentChunkSize_ = msg.begin.chunkSize;
     memcpy(expectedSha256_, msg.begin.sha256Expected, sizeof(expectedSha256_));
 
     // Reset stats counters before the first wire activity.
@@ -326,21 +483,33 @@ void OtaWriter::handleBegin(queue_ota_writer_msg_t &msg)
     statsNaksSIZE_ = 0;
     statsNaksOOO_ = 0;
     statsNaksFLASH_ = 0;
+    statsNaksBLOCK_ = 0;
     statsSendFailCount_ = 0;
 
     active_ = true;
 
     ESP_LOGI(
         TAG,
-        "handleBegin accepted: xferId=%u totalSize=%u chunks=%u chunkSize=%u partition='%s' (size=%u, offset=0x%lx)",
+        "handleBegin accepted: xferId=%u totalSize=%u chunks=%u chunkSize=%u partition='%s' (size=%u, offset=0x%lx)"
+        "%s%s",
         xferId, (unsigned)msg.begin.totalSize, (unsigned)msg.begin.totalChunks, (unsigned)msg.begin.chunkSize,
-        inactivePartition_->label, (unsigned)inactivePartition_->size, (unsigned long)inactivePartition_->address);
+        inactivePartition_->label, (unsigned)inactivePartition_->size, (unsigned long)inactivePartition_->address,
+        compressedMode_ ? (deltaMode_ ? " [compressed delta]" : " [compressed]") : (deltaMode_ ? " [delta]" : ""),
+        merkleMode_ ? (merkleSectors_ ? " [merkle, per-sector]" : " [merkle]") : "");
+    if (resuming)
+    {
+        ESP_LOGI(TAG, "handleBegin: resuming at seq %u (%u bytes already on flash, checkpoint from xferId=%u)",
+                 (unsigned)resumeSeq, (unsigned)ckpt.bytesWritten, ckpt.xferId);
+        pendingCheckpoint_ = ckpt;
+        pendingCheckpoint_.xferId = xferId;
+        pendingCheckpointValid_ = true;
+    }
 
     // If the ACK frame never even got enqueued, the master will hit its
     // BEGIN_ACK timeout and abandon (OtaForwarder::handleBeginNak). Leaving
     // active_=true would force an operator retry to wait out the 10 s
     // watchdog before getting anything but a BUSY NAK. Release state now.
-    esp_err_t ackErr = sendBeginAck(mac, xferId);
+    esp_err_t ackErr = sendBeginAck(mac, xferId, resumeOffered, resumeSeq);
     logSendResult("handleBegin BEGIN_ACK", ackErr);
     if (ackErr != ESP_OK)
     {
@@ -377,7 +546,9 @@ void OtaWriter::handleData(queue_ota_writer_msg_t &msg)
     if (seq > statsLastRecvSeq_)
         statsLastRecvSeq_ = seq;
 
+    int64_t t0 = esp_timer_get_time();
     auto cr = bulk_.onChunk(xferId, seq, msg.data.payloadLen, msg.data.crc16, msg.data.payload);
+    stageUs_.bulkUs += esp_timer_get_time() - t0;
 
     if (cr.decision == AstrOsBulkTransport::Decision::NAK)
     {
@@ -405,9 +576,10 @@ void OtaWriter::handleData(queue_ota_writer_msg_t &msg)
             statsNaksFLASH_++;
             break;
         case AstrOsBulkTransport::NakReason::NONE:
+        case AstrOsBulkTransport::NakReason::BLOCK_REJECTED: // raised by the merkle stage, never by onChunk
             // Shouldn't happen on a NAK decision; fall through to OUT_OF_ORDER
             // as the safest hint for the master.
-            ESP_LOGW(TAG, "handleData: NAK with reason=NONE — wire-encoding as OUT_OF_ORDER");
+            ESP_LOGW(TAG, "handleData: NAK with reason=%d — wire-encoding as OUT_OF_ORDER", (int)cr.reason);
             wireReason = OtaDataNakReason::OUT_OF_ORDER;
             statsNaksOOO_++;
             break;
@@ -431,33 +603,103 @@ void OtaWriter::handleData(queue_ota_writer_msg_t &msg)
         return;
     }
 
-    esp_err_t wErr = esp_ota_write(otaHandle_, cr.payload, cr.payloadLen);
-    if (wErr != ESP_OK)
+    if (merkleMode_)
     {
-        ESP_LOGE(TAG, "handleData: esp_ota_write failed: %s — aborting transfer xferId=%u seq=%u",
-                 esp_err_to_name(wErr), xferId, seq);
-        // Terminal failure: send WRITE NAK with zero hint fields. The wire
-        // contract treats windowRemaining=0 as "receiver inactive" — that
-        // matches our post-reset state and prevents the master from
-        // retransmitting into a torn-down writer.
-        esp_err_t nakErr = sendDataNak(mac, xferId, /*hcs=*/0, /*nes=*/0, /*wr=*/0, OtaDataNakReason::WRITE);
-        logSendResult("handleData WRITE NAK (esp_ota_write)", nakErr);
-        if (nakErr != ESP_OK)
-            statsSendFailCount_++;
-        resetOtaHandleAndSha();
-        return;
+        // Chunk carries framed-stream bytes. Verified blocks continue to the
+        // decode stages / flash sink from inside merkleBlockOutCb, so the
+        // merkle stage is the feed time minus everything downstream of it.
+        const uint64_t downstreamUsBefore = stageUs_.decodeUs + stageUs_.sinkUs + stageUs_.shaUs;
+        t0 = esp_timer_get_time();
+        auto vr = merkle_.feed(seq * currentChunkSize_, cr.payload, cr.payloadLen);
+        stageUs_.merkleUs += (esp_timer_get_time() - t0) -
+                             (stageUs_.decodeUs + stageUs_.sinkUs + stageUs_.shaUs - downstreamUsBefore);
+        if (vr.status == AstrOsOtaMerkle::Status::BLOCK_MISMATCH)
+        {
+            // Recoverable: the verifier dropped the block and waits for its
+            // record again. Un-commit the chunks from the record's first one
+            // on and NAK the master back there — reason BLOCK lets it rewind
+            // below chunks it already saw ACKed.
+            const uint32_t resendSeq = vr.resendFrom / currentChunkSize_;
+            statsNaksBLOCK_++;
+            if (++merkleRejects_ <= kMaxBlockRejects && bulk_.rewind(resendSeq))
+            {
+                ESP_LOGW(TAG, "handleData: xferId=%u block %u failed verification (%u/%u) — NAK BLOCK from seq %u",
+                         xferId, (unsigned)vr.block, (unsigned)merkleRejects_, (unsigned)kMaxBlockRejects,
+                         (unsigned)resendSeq);
+                esp_err_t nakErr = sendDataNak(mac, xferId, resendSeq == 0 ? 0 : resendSeq - 1, resendSeq,
+                                               cr.windowRemaining, OtaDataNakReason::BLOCK);
+                logSendResult("handleData BLOCK NAK", nakErr);
+                if (nakErr != ESP_OK)
+                    statsSendFailCount_++;
+                watchdogRestart();
+                return;
+            }
+            ESP_LOGE(TAG, "handleData: xferId=%u block %u rejected %u times — aborting", xferId, (unsigned)vr.block,
+                     (unsigned)merkleRejects_);
+        }
+        if (!vr.ok)
+        {
+            if (vr.status != AstrOsOtaMerkle::Status::BLOCK_MISMATCH)
+            {
+                ESP_LOGE(TAG, "handleData: merkle stage failed: status=%d (write err %s) — aborting xferId=%u seq=%u",
+                         (int)vr.status, esp_err_to_name(imageWriteErr_), xferId, seq);
+            }
+            // Terminal, same wire shape as an esp_ota_write failure.
+            esp_err_t nakErr = sendDataNak(mac, xferId, /*hcs=*/0, /*nes=*/0, /*wr=*/0, OtaDataNakReason::WRITE);
+            logSendResult("handleData WRITE NAK (merkle)", nakErr);
+            if (nakErr != ESP_OK)
+                statsSendFailCount_++;
+            if (vr.status == AstrOsOtaMerkle::Status::WRITE_FAILED && !encodedTransfer())
+            {
+                clearCheckpoint();
+            }
+            resetOtaHandleAndSha();
+            return;
+        }
     }
-
-    if (shaActive_)
+    else if (encodedTransfer())
     {
-        AstrOsSha256_update(&shaCtx_, cr.payload, cr.payloadLen);
+        // Chunk carries encoded bytes: the decode stages rebuild image bytes
+        // and push them through writeImage (flash sink + streaming SHA).
+        // Decode time is what's left after writeImage's own stages.
+        const uint64_t writeUsBefore = stageUs_.sinkUs + stageUs_.shaUs;
+        t0 = esp_timer_get_time();
+        const bool decoded = consumeEncoded(cr.payload, cr.payloadLen);
+        stageUs_.decodeUs += (esp_timer_get_time() - t0) - (stageUs_.sinkUs + stageUs_.shaUs - writeUsBefore);
+        if (!decoded)
+        {
+            ESP_LOGE(TAG, "handleData: decode failed (write err %s) — aborting xferId=%u seq=%u",
+                     esp_err_to_name(imageWriteErr_), xferId, seq);
+            // Terminal, same wire shape as an esp_ota_write failure: a bad
+            // base or malformed stream will not get better on retransmit.
+            esp_err_t nakErr = sendDataNak(mac, xferId, /*hcs=*/0, /*nes=*/0, /*wr=*/0, OtaDataNakReason::WRITE);
+            logSendResult("handleData WRITE NAK (decode)", nakErr);
+            if (nakErr != ESP_OK)
+                statsSendFailCount_++;
+            resetOtaHandleAndSha();
+            return;
+        }
     }
     else
     {
-        // Should be unreachable: handleBegin sets shaActive_ on the same
-        // path that opens otaHandle_. Reaching here means the END compare
-        // will trip HASH_MISMATCH.
-        ESP_LOGE(TAG, "handleData: shaActive_=false on accepted chunk — END will report HASH_MISMATCH");
+        esp_err_t wErr = writeImage(cr.payload, cr.payloadLen);
+        if (wErr != ESP_OK)
+        {
+            ESP_LOGE(TAG, "handleData: image write failed: %s — aborting transfer xferId=%u seq=%u",
+                     esp_err_to_name(wErr), xferId, seq);
+            // Terminal failure: send WRITE NAK with zero hint fields. The wire
+            // contract treats windowRemaining=0 as "receiver inactive" — that
+            // matches our post-reset state and prevents the master from
+            // retransmitting into a torn-down writer.
+            esp_err_t nakErr = sendDataNak(mac, xferId, /*hcs=*/0, /*nes=*/0, /*wr=*/0, OtaDataNakReason::WRITE);
+            logSendResult("handleData WRITE NAK (esp_ota_write)", nakErr);
+            if (nakErr != ESP_OK)
+                statsSendFailCount_++;
+            // Flash we can't write is flash we shouldn't resume onto.
+            clearCheckpoint();
+            resetOtaHandleAndSha();
+            return;
+        }
     }
 
     ESP_LOGD(TAG, "handleData: xferId=%u seq=%u accepted (cum=%u next=%u wr=%u)", xferId, seq,
@@ -467,10 +709,23 @@ void OtaWriter::handleData(queue_ota_writer_msg_t &msg)
     statsHighestAckedSeq_ = cr.highestContiguousSeq;
     statsAnyAcked_ = true;
 
+    // An ACK means "buffered", not "programmed": a flash failure on this
+    // chunk's sector surfaces as a WRITE NAK on a later chunk or as
+    // WRITE_ERROR at OTA_END, and the read-back verify still gates the flip.
+    t0 = esp_timer_get_time();
     esp_err_t ackErr = sendDataAck(mac, xferId, cr.highestContiguousSeq, cr.nextExpectedSeq, cr.windowRemaining);
+    stageUs_.ackUs += esp_timer_get_time() - t0;
     logSendResult("handleData DATA_ACK", ackErr);
     if (ackErr != ESP_OK)
         statsSendFailCount_++;
+    // After the ACK so the NVS commit overlaps the master's next window
+    // instead of delaying it. Dying in between only costs the last interval.
+    // Merkle transfers snapshot at block boundaries instead (merkleBlockOutCb).
+    if (!encodedTransfer() && !merkleMode_ && imageBytesWritten_ - lastCheckpointBytes_ >= kCheckpointIntervalBytes)
+    {
+        snapshotCheckpoint(cr.nextExpectedSeq);
+    }
+    persistPendingCheckpoint();
     watchdogRestart();
 }
 
@@ -508,6 +763,62 @@ void OtaWriter::handleEnd(queue_ota_writer_msg_t &msg)
         return;
     }
 
+    // Every chunk has arrived: whatever the verdict below, there is nothing
+    // left to resume.
+    clearCheckpoint();
+
+    // The last block must have verified; like the decode stages below,
+    // checked before the SHA so a short stream reports as a write error.
+    if (merkleMode_)
+    {
+        auto vr = merkle_.finish();
+        if (!vr.ok)
+        {
+            ESP_LOGE(TAG, "handleEnd: merkle stream incomplete (status=%d, %u of %u blocks) — replying WRITE_ERROR",
+                     (int)vr.status, (unsigned)merkle_.state().nextBlock, (unsigned)merkle_.geometry().blockCount());
+            uint8_t zero[32] = {0};
+            logSendResult("handleEnd WRITE_ERROR (merkle incomplete) END_ACK",
+                          sendEndAck(mac, xferId, OtaEndStatus::WRITE_ERROR, zero));
+            resetOtaHandleAndSha();
+            return;
+        }
+    }
+
+    // Every decode stage must have ended exactly at its declared size.
+    // Checked before the SHA so a short stream reports as a write error,
+    // not as a corrupted image.
+    if (encodedTransfer() && !finishDecodeStages())
+    {
+        ESP_LOGE(TAG, "handleEnd: encoded stream incomplete (rebuilt %u bytes) — replying WRITE_ERROR",
+                 (unsigned)imageBytesWritten_);
+        uint8_t zero[32] = {0};
+        logSendResult("handleEnd WRITE_ERROR (decode incomplete) END_ACK",
+                      sendEndAck(mac, xferId, OtaEndStatus::WRITE_ERROR, zero));
+        resetOtaHandleAndSha();
+        return;
+    }
+    // Push the partial tail sector down and wait for otaFlashTask to finish
+    // everything queued. A sector that failed after its chunk was ACKed
+    // reports here.
+    const bool pipelined = flash_.active();
+    if (pipelined)
+    {
+        esp_err_t fErr = flash_.finish();
+        if (fErr != ESP_OK)
+        {
+            ESP_LOGE(TAG, "handleEnd: flash pipeline failed: %s — replying WRITE_ERROR", esp_err_to_name(fErr));
+            uint8_t zero[32] = {0};
+            logSendResult("handleEnd WRITE_ERROR (flash) END_ACK",
+                          sendEndAck(mac, xferId, OtaEndStatus::WRITE_ERROR, zero));
+            resetOtaHandleAndSha();
+            return;
+        }
+    }
+    // Bytes actually written to the inactive partition — the decoded image
+    // for encoded transfers, the verified blocks (wire bytes minus the tree
+    // hashes) for Merkle ones, the wire bytes otherwise.
+    const uint32_t imageSize = (encodedTransfer() || merkleMode_) ? imageBytesWritten_ : currentTotalSize_;
+
     // 1. Finalize streaming SHA.
     uint8_t streamedDigest[32];
     if (shaActive_)
@@ -523,8 +834,8 @@ void OtaWriter::handleEnd(queue_ota_writer_msg_t &msg)
 
     if (memcmp(streamedDigest, expectedSha256_, sizeof(streamedDigest)) != 0)
     {
-        ESP_LOGE(TAG, "handleEnd: streaming SHA mismatch — replying HASH_MISMATCH (chunks=%u, totalSize=%u)",
-                 (unsigned)msg.end.totalChunksSent, (unsigned)currentTotalSize_);
+        ESP_LOGE(TAG, "handleEnd: streaming SHA mismatch — replying HASH_MISMATCH (chunks=%u, imageSize=%u)",
+                 (unsigned)msg.end.totalChunksSent, (unsigned)imageSize);
         logSendResult("handleEnd HASH_MISMATCH END_ACK",
                       sendEndAck(mac, xferId, OtaEndStatus::HASH_MISMATCH, streamedDigest));
         resetOtaHandleAndSha();
@@ -534,11 +845,23 @@ void OtaWriter::handleEnd(queue_ota_writer_msg_t &msg)
     // esp_ota_end validates the image header (magic byte + size). With
     // secure boot disabled (our config) that's the only check. Does NOT
     // activate the new partition — a follow-up step owns the boot-table
-    // flip.
-    esp_err_t eErr = esp_ota_end(otaHandle_);
+    // flip. The flash pipeline writes through esp_partition_* and has no
+    // handle to end, so it runs the same esp_image_verify esp_ota_end would;
+    // esp_ota_set_boot_partition repeats it before it flips anything.
+    esp_err_t eErr = ESP_OK;
+    if (pipelined)
+    {
+        const esp_partition_pos_t pos = {inactivePartition_->address, inactivePartition_->size};
+        esp_image_metadata_t meta = {};
+        eErr = esp_image_verify(ESP_IMAGE_VERIFY, &pos, &meta);
+    }
+    else
+    {
+        eErr = esp_ota_end(otaHandle_);
+    }
     if (eErr != ESP_OK)
     {
-        ESP_LOGE(TAG, "handleEnd: esp_ota_end failed: %s — replying WRITE_ERROR", esp_err_to_name(eErr));
+        ESP_LOGE(TAG, "handleEnd: image validation failed: %s — replying WRITE_ERROR", esp_err_to_name(eErr));
         // esp_ota_end has already released the handle internally even on
         // failure (per IDF docs); zero the handle so resetOtaHandleAndSha
         // doesn't try to re-abort it.
@@ -551,32 +874,42 @@ void OtaWriter::handleEnd(queue_ota_writer_msg_t &msg)
     otaHandle_ = 0;
 
     // Read-back-and-rehash: catches silent flash corruption that landed
-    // between esp_ota_write and esp_ota_end's finalize. 4 KB buffer
+    // between the sector writes and the image validation above. 4 KB buffer
     // matches the flash sector size. Stack-allocated; sized against
     // otaWriterTask's stack (12 KB). Re-verify HWM if the stack is shrunk.
-    AstrOsSha256Ctx rbCtx;
-    AstrOsSha256_init(&rbCtx);
-
-    constexpr size_t kReadBufSize = 4096;
-    uint8_t buf[kReadBufSize];
+    //
+    // A per-sector Merkle transfer skips it: otaFlashTask already read every
+    // sector back against its leaf before counting it flashed, and the
+    // leaves chain to the root the streamed bytes were checked against.
+    uint8_t readbackDigest[32];
     bool readbackOk = true;
-    for (size_t off = 0; off < currentTotalSize_; off += kReadBufSize)
+    if (merkleSectors_)
+    {
+        memcpy(readbackDigest, streamedDigest, sizeof(readbackDigest));
+    }
+    else
     {
-        size_t chunk = (currentTotalSize_ - off < kReadBufSize) ? (currentTotalSize_ - off) : kReadBufSize;
-        esp_err_t rErr = esp_partition_read(inactivePartition_, off, buf, chunk);
-        if (rErr != ESP_OK)
+        AstrOsSha256Ctx rbCtx;
+        AstrOsSha256_init(&rbCtx);
+
+        constexpr size_t kReadBufSize = 4096;
+        uint8_t buf[kReadBufSize];
+        for (size_t off = 0; off < imageSize; off += kReadBufSize)
         {
-            ESP_LOGE(TAG, "handleEnd: esp_partition_read at off=%zu len=%zu failed: %s", off, chunk,
-                     esp_err_to_name(rErr));
-            readbackOk = false;
-            break;
+            size_t chunk = (imageSize - off < kReadBufSize) ? (imageSize - off) : kReadBufSize;
+            esp_err_t rErr = esp_partition_read(inactivePartition_, off, buf, chunk);
+            if (rErr != ESP_OK)
+            {
+                ESP_LOGE(TAG, "handleEnd: esp_partition_read at off=%zu len=%zu failed: %s", off, chunk,
+                         esp_err_to_name(rErr));
+                readbackOk = false;
+                break;
+            }
+            AstrOsSha256_update(&rbCtx, buf, chunk);
         }
-        AstrOsSha256_update(&rbCtx, buf, chunk);
+        AstrOsSha256_final(&rbCtx, readbackDigest);
     }
 
-    uint8_t readbackDigest[32];
-    AstrOsSha256_final(&rbCtx, readbackDigest);
-
     if (!readbackOk)
     {
         logSendResult("handleEnd WRITE_ERROR (readback IO) END_ACK",
@@ -597,8 +930,9 @@ void OtaWriter::handleEnd(queue_ota_writer_msg_t &msg)
         return;
     }
 
-    ESP_LOGI(TAG, "handleEnd: transfer xferId=%u OK — %u bytes verified on partition '%s'", xferId,
-             (unsigned)currentTotalSize_, inactivePartition_->label);
+    ESP_LOGI(TAG, "handleEnd: transfer xferId=%u OK — %u bytes verified on partition '%s'%s", xferId,
+             (unsigned)imageSize, inactivePartition_->label, encodedTransfer() ? " (decoded)" : "");
+    logStageTimes("end");
 
     // Stop watchdog and stats timer before the 2 s delay so neither
     // fires while we're sleeping. resetOtaHandleAndSha() at the end of
@@ -721,6 +1055,9 @@ void OtaWriter::handleLocalFlashReq(queue_ota_writer_msg_t &msg)
         return;
     }
 
+    // Same slot the wire path checkpoints into — a half-done padawan-style
+    // transfer can't survive this write.
+    clearCheckpoint();
     esp_err_t err = esp_ota_begin(inactivePartition_, OTA_SIZE_UNKNOWN, &otaHandle_);
     if (err != ESP_OK)
     {
@@ -734,8 +1071,34 @@ void OtaWriter::handleLocalFlashReq(queue_ota_writer_msg_t &msg)
     // ─── Step 3: stream the file in 4 KB chunks ──────────────────────
     // This buffer is reused by the Step 6 readback verify — keep it a single
     // 4 KB array. A second function-scoped 4 KB buffer overflows the stack.
+    //
+    // An encoded staged file (compressed and/or delta — the deploy's file is
+    // shared by every target, master included) runs through the same decode
+    // stages as the wire path; the forwarder already classified it and sent
+    // the decoded image's SHA. shaCtx_ always hashes the image written to
+    // flash; fileCtx hashes the staged file so the file SHA is still checked.
+    const uint8_t flags = msg.local_flash_req.flags;
+    if (flags != 0)
+    {
+        // The decode stages' header checks compare against expectedSha256_,
+        // which the wire path fills from OTA_BEGIN.
+        memcpy(expectedSha256_, msg.local_flash_req.imageSha256, sizeof(expectedSha256_));
+    }
+    if (!beginDecodeStages(flags))
+    {
+        std::fclose(f);
+        esp_ota_abort(otaHandle_);
+        otaHandle_ = 0; // tell resetOtaHandleAndSha not to abort again
+        resetOtaHandleAndSha();
+        active_.store(false);
+        postResult(OtaFlashStatus::FAILED, "no_running_partition");
+        return;
+    }
+    const bool encoded = encodedTransfer();
     AstrOsSha256_init(&shaCtx_);
     shaActive_ = true;
+    AstrOsSha256Ctx fileCtx;
+    AstrOsSha256_init(&fileCtx);
     constexpr size_t kChunkBytes = 4096;
     uint8_t buf[kChunkBytes];
     size_t totalRead = 0;
@@ -754,7 +1117,15 @@ void OtaWriter::handleLocalFlashReq(queue_ota_writer_msg_t &msg)
             postResult(OtaFlashStatus::FAILED, "firmware_read_short");
             return;
         }
-        err = esp_ota_write(otaHandle_, buf, got);
+        if (encoded)
+        {
+            AstrOsSha256_update(&fileCtx, buf, got);
+            err = consumeEncoded(buf, got) ? ESP_OK : (imageWriteErr_ != ESP_OK ? imageWriteErr_ : ESP_FAIL);
+        }
+        else
+        {
+            err = writeImage(buf, got);
+        }
         if (err != ESP_OK)
         {
             ESP_LOGE(TAG, "handleLocalFlashReq: esp_ota_write failed at offset %zu: %s", totalRead,
@@ -764,28 +1135,56 @@ void OtaWriter::handleLocalFlashReq(queue_ota_writer_msg_t &msg)
             otaHandle_ = 0; // tell resetOtaHandleAndSha not to abort again
             resetOtaHandleAndSha();
             active_.store(false);
-            postResult(OtaFlashStatus::FAILED, esp_err_to_name(err));
+            postResult(OtaFlashStatus::FAILED, encoded ? "decode_failed" : esp_err_to_name(err));
             return;
         }
-        AstrOsSha256_update(&shaCtx_, buf, got);
         totalRead += got;
     }
     std::fclose(f);
 
     // ─── Step 4: finalize streaming SHA, compare to expected ─────────
+    // Full image: the image digest IS the file digest. Encoded: the file
+    // digest guards the staged file, and the decoded image must match the
+    // digest the forwarder took from the stream headers (expectedSha256_).
     uint8_t streamedDigest[32];
     AstrOsSha256_final(&shaCtx_, streamedDigest);
     shaActive_ = false;
-    if (std::memcmp(streamedDigest, expectedSha, 32) != 0)
+    const char *digestFailure = nullptr;
+    if (encoded)
     {
-        ESP_LOGE(TAG, "handleLocalFlashReq: streaming SHA mismatch");
+        uint8_t fileDigest[32];
+        AstrOsSha256_final(&fileCtx, fileDigest);
+        if (std::memcmp(fileDigest, expectedSha, 32) != 0)
+        {
+            digestFailure = "sha_mismatch";
+        }
+        else if (!finishDecodeStages())
+        {
+            digestFailure = "decode_truncated";
+        }
+        else if (std::memcmp(streamedDigest, expectedSha256_, 32) != 0)
+        {
+            digestFailure = "image_sha_mismatch";
+        }
+    }
+    else if (std::memcmp(streamedDigest, expectedSha, 32) != 0)
+    {
+        digestFailure = "sha_mismatch";
+    }
+    if (digestFailure != nullptr)
+    {
+        ESP_LOGE(TAG, "handleLocalFlashReq: streaming verify failed: %s", digestFailure);
         esp_ota_abort(otaHandle_);
         otaHandle_ = 0; // tell resetOtaHandleAndSha not to abort again
         resetOtaHandleAndSha();
         active_.store(false);
-        postResult(OtaFlashStatus::FAILED, "sha_mismatch");
+        postResult(OtaFlashStatus::FAILED, digestFailure);
         return;
     }
+    // What actually landed on flash, and the digest it must read back as.
+    const uint32_t imageSize = encoded ? imageBytesWritten_ : expectedSize;
+    uint8_t imageSha[32];
+    std::memcpy(imageSha, encoded ? expectedSha256_ : expectedSha, sizeof(imageSha));
 
     // ─── Step 5: esp_ota_end (commits the writes; partition pointer not yet flipped) ──
     err = esp_ota_end(otaHandle_);
@@ -809,9 +1208,9 @@ void OtaWriter::handleLocalFlashReq(queue_ota_writer_msg_t &msg)
     // overflow the stack mid-flash (see src/main.cpp ota_writer_task sizing).
     AstrOsSha256Ctx rbCtx;
     AstrOsSha256_init(&rbCtx);
-    for (size_t off = 0; off < expectedSize;)
+    for (size_t off = 0; off < imageSize;)
     {
-        size_t chunk = std::min(kChunkBytes, static_cast<size_t>(expectedSize - off));
+        size_t chunk = std::min(kChunkBytes, static_cast<size_t>(imageSize - off));
         err = esp_partition_read(inactivePartition_, off, buf, chunk);
         if (err != ESP_OK)
         {
@@ -826,7 +1225,7 @@ void OtaWriter::handleLocalFlashReq(queue_ota_writer_msg_t &msg)
     }
     uint8_t readbackDigest[32];
     AstrOsSha256_final(&rbCtx, readbackDigest);
-    if (std::memcmp(readbackDigest, expectedSha, 32) != 0)
+    if (std::memcmp(readbackDigest, imageSha, 32) != 0)
     {
         ESP_LOGE(TAG, "handleLocalFlashReq: read-back SHA mismatch");
         resetOtaHandleAndSha();
@@ -873,12 +1272,435 @@ void OtaWriter::handleWatchdogFire()
     resetOtaHandleAndSha();
 }
 
-esp_err_t OtaWriter::sendBeginAck(const uint8_t mac[6], uint8_t xferId)
+esp_err_t OtaWriter::writeImage(const uint8_t *data, size_t len, const uint8_t *leaf)
+{
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = ESP_OK;
+    if (!flash_.active())
+    {
+        err = esp_ota_write(otaHandle_, data, len);
+    }
+    else
+    {
+        err = leaf != nullptr ? flash_.appendSector(data, len, leaf) : flash_.append(data, len);
+    }
+    stageUs_.sinkUs += esp_timer_get_time() - t0;
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    imageBytesWritten_ += static_cast<uint32_t>(len);
+    if (shaActive_)
+    {
+        t0 = esp_timer_get_time();
+        AstrOsSha256_update(&shaCtx_, data, len);
+        stageUs_.shaUs += esp_timer_get_time() - t0;
+    }
+    else
+    {
+        // Should be unreachable: every path sets shaActive_ on the same
+        // path that opens otaHandle_. Reaching here means the final
+        // compare will trip HASH_MISMATCH.
+        ESP_LOGE(TAG, "writeImage: shaActive_=false on accepted bytes — verify will report HASH_MISMATCH");
+    }
+    return ESP_OK;
+}
+
+bool OtaWriter::merkleBlockOutCb(void *arg, uint32_t block, const uint8_t *data, size_t len,
+                                 const uint8_t leaf[AstrOsOtaMerkle::kHashSize])
+{
+    auto self = static_cast<OtaWriter *>(arg);
+    // A verified block is progress: the reject budget is per stuck block.
+    self->merkleRejects_ = 0;
+    if (self->encodedTransfer())
+    {
+        const uint64_t writeUsBefore = self->stageUs_.sinkUs + self->stageUs_.shaUs;
+        const int64_t t0 = esp_timer_get_time();
+        const bool decoded = self->consumeEncoded(data, len);
+        self->stageUs_.decodeUs +=
+            (esp_timer_get_time() - t0) - (self->stageUs_.sinkUs + self->stageUs_.shaUs - writeUsBefore);
+        return decoded;
+    }
+    self->imageWriteErr_ = self->writeImage(data, len, self->merkleSectors_ ? leaf : nullptr);
+    if (self->imageWriteErr_ != ESP_OK)
+    {
+        return false;
+    }
+    // The verifier has already moved past `block`, so this is a clean
+    // resume point: every byte below it verified and handed to flash_.
+    const AstrOsOtaMerkle::Geometry &geo = self->merkle_.geometry();
+    if (block + 1 < geo.blockCount() &&
+        self->imageBytesWritten_ - self->lastCheckpointBytes_ >= kCheckpointIntervalBytes)
+    {
+        self->snapshotCheckpoint(geo.recordStart(block + 1) / self->currentChunkSize_);
+    }
+    return true;
+}
+
+bool OtaWriter::loadMatchingCheckpoint(const queue_ota_writer_msg_t &msg, ResumeCheckpoint &out)
+{
+    nvs_handle_t h;
+    if (nvs_open(kResumeNvsNamespace, NVS_READONLY, &h) != ESP_OK)
+    {
+        return false; // namespace never written — nothing to resume
+    }
+    size_t len = sizeof(out);
+    esp_err_t err = nvs_get_blob(h, kResumeNvsKey, &out, &len);
+    nvs_close(h);
+    if (err != ESP_OK || len != sizeof(out) || out.version != kCheckpointVersion)
+    {
+        return false;
+    }
+
+    // Same image, same chunk grid, same slot. The chunk grid matters because
+    // the resume point is a seq; the slot because an OTA in between flips
+    // which partition is inactive.
+    // A Merkle transfer must also agree on the tree: the saved path only
+    // means anything under the same root.
+    const bool merkle = (msg.begin.flags & OTA_BEGIN_FLAG_MERKLE) != 0;
+    const bool matches = memcmp(out.imageSha256, msg.begin.sha256Expected, sizeof(out.imageSha256)) == 0 &&
+                         out.totalSize == msg.begin.totalSize && out.totalChunks == msg.begin.totalChunks &&
+                         out.chunkSize == msg.begin.chunkSize && out.partitionAddress == inactivePartition_->address &&
+                         out.merkleBlockLog2 == (merkle ? msg.begin.merkleBlockLog2 : 0) &&
+                         (!merkle || memcmp(out.merkleRoot, msg.begin.merkleRoot, sizeof(out.merkleRoot)) == 0);
+    // Plain transfers write exactly one chunk per seq, so the cursor is
+    // fully determined by nextSeq; a Merkle one stops at a block boundary
+    // and resumes from the chunk holding that block's record start.
+    // Anything else is a corrupt record.
+    bool consistent = out.nextSeq > 0 && out.nextSeq < out.totalChunks;
+    AstrOsOtaMerkle::Geometry geo;
+    if (!merkle)
+    {
+        consistent = consistent && static_cast<uint64_t>(out.nextSeq) * out.chunkSize == out.bytesWritten;
+    }
+    else
+    {
+        const uint32_t next = out.merkle.nextBlock;
+        consistent = consistent && geo.init(msg.begin.merkleDataSize, msg.begin.merkleBlockLog2) && next > 0 &&
+                     next < geo.blockCount() && static_cast<uint64_t>(next) * geo.blockSize() == out.bytesWritten &&
+                     out.nextSeq == geo.recordStart(next) / out.chunkSize;
+    }
+    if (matches && !consistent)
+    {
+        ESP_LOGW(TAG, "resume checkpoint inconsistent (nextSeq=%u bytes=%u) — starting fresh", (unsigned)out.nextSeq,
+                 (unsigned)out.bytesWritten);
+    }
+    return matches && consistent;
+}
+
+void OtaWriter::snapshotCheckpoint(uint32_t nextSeq)
+{
+    // Captured now, while shaCtx_ and imageBytesWritten_ describe exactly
+    // `nextSeq` chunks; persisted once otaFlashTask has programmed that far.
+    ResumeCheckpoint &ckpt = pendingCheckpoint_;
+    ckpt = ResumeCheckpoint{};
+    ckpt.version = kCheckpointVersion;
+    ckpt.xferId = currentXferId_;
+    ckpt.chunkSize = currentChunkSize_;
+    ckpt.partitionAddress = inactivePartition_->address;
+    ckpt.totalSize = currentTotalSize_;
+    ckpt.totalChunks = currentTotalChunks_;
+    ckpt.nextSeq = nextSeq;
+    ckpt.bytesWritten = imageBytesWritten_;
+    memcpy(ckpt.imageSha256, expectedSha256_, sizeof(ckpt.imageSha256));
+    ckpt.sha = shaCtx_;
+    if (merkleMode_)
+    {
+        ckpt.merkleBlockLog2 = merkle_.geometry().blockLog2();
+        memcpy(ckpt.merkleRoot, merkleRoot_, sizeof(ckpt.merkleRoot));
+        ckpt.merkle = merkle_.state();
+    }
+    pendingCheckpointValid_ = true;
+    lastCheckpointBytes_ = imageBytesWritten_;
+}
+
+void OtaWriter::persistPendingCheckpoint()
+{
+    // A checkpoint must never point past bytes that are still in a RAM
+    // buffer: a restart would resume onto erased flash.
+    if (!pendingCheckpointValid_ || flash_.flashedBytes() < pendingCheckpoint_.bytesWritten)
+    {
+        return;
+    }
+    pendingCheckpointValid_ = false;
+    const int64_t t0 = esp_timer_get_time();
+    saveCheckpoint(pendingCheckpoint_);
+    stageUs_.checkpointUs += esp_timer_get_time() - t0;
+}
+
+void OtaWriter::saveCheckpoint(const ResumeCheckpoint &ckpt)
+{
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(kResumeNvsNamespace, NVS_READWRITE, &h);
+    if (err == ESP_OK)
+    {
+        err = nvs_set_blob(h, kResumeNvsKey, &ckpt, sizeof(ckpt));
+        if (err == ESP_OK)
+        {
+            err = nvs_commit(h);
+        }
+        nvs_close(h);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "saveCheckpoint(seq=%u) failed: %s — a restart will resume from an older point",
+                 (unsigned)ckpt.nextSeq, esp_err_to_name(err));
+        return;
+    }
+    ESP_LOGD(TAG, "checkpoint: xferId=%u nextSeq=%u bytes=%u", ckpt.xferId, (unsigned)ckpt.nextSeq,
+             (unsigned)ckpt.bytesWritten);
+}
+
+void OtaWriter::clearCheckpoint()
+{
+    pendingCheckpointValid_ = false;
+    nvs_handle_t h;
+    if (nvs_open(kResumeNvsNamespace, NVS_READWRITE, &h) != ESP_OK)
+    {
+        return;
+    }
+    esp_err_t err = nvs_erase_key(h, kResumeNvsKey);
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(h);
+    }
+    nvs_close(h);
+    if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND)
+    {
+        // A stale record is harmless while it can't match, but log it: the
+        // next BEGIN for the same image would try to resume onto it.
+        ESP_LOGW(TAG, "clearCheckpoint failed: %s", esp_err_to_name(err));
+    }
+}
+
+bool OtaWriter::beginDecodeStages(uint8_t flags)
+{
+    deltaMode_ = (flags & OTA_BEGIN_FLAG_DELTA) != 0;
+    compressedMode_ = (flags & OTA_BEGIN_FLAG_COMPRESSED) != 0;
+    imageBytesWritten_ = 0;
+    imageWriteErr_ = ESP_OK;
+    if (deltaMode_)
+    {
+        // Delta transfers read COPY spans from the image we're running. The
+        // base itself is verified against the patch header once it arrives
+        // (deltaAcceptHeaderCb) — BEGIN doesn't carry it.
+        runningPartition_ = esp_ota_get_running_partition();
+        if (runningPartition_ == nullptr)
+        {
+            ESP_LOGE(TAG, "delta transfer but esp_ota_get_running_partition returned NULL");
+            return false;
+        }
+        delta_.begin(deltaIo());
+    }
+    if (compressedMode_)
+    {
+        inflate_.begin(inflateIo());
+    }
+    return true;
+}
+
+bool OtaWriter::consumeEncoded(const uint8_t *data, size_t len)
+{
+    if (!compressedMode_)
+    {
+        return consumeDecoded(data, len);
+    }
+    // A failure further down the chain surfaces here as WRITE_FAILED; the
+    // failing stage has already logged its own status.
+    auto dr = inflate_.feed(data, len);
+    if (!dr.ok && dr.status != AstrOsOtaCompress::Status::WRITE_FAILED)
+    {
+        ESP_LOGE(TAG, "inflate failed: status=%d after %u decoded bytes", (int)dr.status,
+                 (unsigned)inflate_.bytesOut());
+    }
+    return dr.ok;
+}
+
+bool OtaWriter::consumeDecoded(const uint8_t *data, size_t len)
+{
+    if (!deltaMode_)
+    {
+        imageWriteErr_ = writeImage(data, len);
+        return imageWriteErr_ == ESP_OK;
+    }
+    auto ar = delta_.feed(data, len);
+    if (!ar.ok && ar.status != AstrOsOtaDelta::Status::WRITE_FAILED)
+    {
+        ESP_LOGE(TAG, "delta apply failed: status=%d after %u rebuilt bytes", (int)ar.status,
+                 (unsigned)delta_.bytesWritten());
+    }
+    return ar.ok;
+}
+
+bool OtaWriter::finishDecodeStages()
+{
+    if (compressedMode_)
+    {
+        auto dr = inflate_.finish();
+        if (!dr.ok)
+        {
+            ESP_LOGE(TAG, "inflate incomplete: status=%d (%u of %u bytes)", (int)dr.status,
+                     (unsigned)inflate_.bytesOut(), (unsigned)inflate_.header().rawSize);
+            return false;
+        }
+    }
+    if (deltaMode_)
+    {
+        auto ar = delta_.finish();
+        if (!ar.ok)
+        {
+            ESP_LOGE(TAG, "delta patch incomplete: status=%d (%u of %u bytes)", (int)ar.status,
+                     (unsigned)delta_.bytesWritten(), (unsigned)delta_.header().targetSize);
+            return false;
+        }
+    }
+    return true;
+}
+
+AstrOsOtaCompress::StreamIo OtaWriter::inflateIo()
+{
+    AstrOsOtaCompress::StreamIo io;
+    io.ctx = this;
+    io.writeOut = &OtaWriter::inflateWriteOutCb;
+    io.acceptHeader = &OtaWriter::inflateAcceptHeaderCb;
+    return io;
+}
+
+bool OtaWriter::inflateWriteOutCb(void *arg, const uint8_t *data, size_t len)
+{
+    return static_cast<OtaWriter *>(arg)->consumeDecoded(data, len);
+}
+
+bool OtaWriter::inflateAcceptHeaderCb(void *arg, const AstrOsOtaCompress::StreamHeader &header)
+{
+    auto self = static_cast<OtaWriter *>(arg);
+    if (self->deltaMode_)
+    {
+        // The decoded stream is a patch; its own header carries the image
+        // size/SHA and is checked by deltaAcceptHeaderCb.
+        ESP_LOGI(TAG, "inflate: compressed patch, %u B decoded, window %u B", (unsigned)header.rawSize,
+                 1u << header.windowBits);
+        return true;
+    }
+    if (memcmp(header.rawSha256, self->expectedSha256_, sizeof(header.rawSha256)) != 0)
+    {
+        ESP_LOGE(TAG, "inflate: stream rawSha256 disagrees with the announced image SHA — rejecting");
+        return false;
+    }
+    if (self->inactivePartition_ == nullptr || header.rawSize > self->inactivePartition_->size)
+    {
+        ESP_LOGE(TAG, "inflate: rawSize=%u does not fit the inactive partition — rejecting",
+                 (unsigned)header.rawSize);
+        return false;
+    }
+    ESP_LOGI(TAG, "inflate: compressed image, %u B decoded, window %u B", (unsigned)header.rawSize,
+             1u << header.windowBits);
+    return true;
+}
+
+AstrOsOtaDelta::PatchIo OtaWriter::deltaIo()
+{
+    AstrOsOtaDelta::PatchIo io;
+    io.ctx = this;
+    io.readBase = &OtaWriter::deltaReadBaseCb;
+    io.writeOut = &OtaWriter::deltaWriteOutCb;
+    io.acceptHeader = &OtaWriter::deltaAcceptHeaderCb;
+    return io;
+}
+
+bool OtaWriter::deltaReadBaseCb(void *arg, uint32_t offset, uint8_t *out, size_t len)
+{
+    auto self = static_cast<OtaWriter *>(arg);
+    if (self->runningPartition_ == nullptr)
+    {
+        return false;
+    }
+    esp_err_t err = esp_partition_read(self->runningPartition_, offset, out, len);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "delta: esp_partition_read(base) at off=%u len=%zu failed: %s", (unsigned)offset, len,
+                 esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+bool OtaWriter::deltaWriteOutCb(void *arg, const uint8_t *data, size_t len)
+{
+    auto self = static_cast<OtaWriter *>(arg);
+    self->imageWriteErr_ = self->writeImage(data, len);
+    return self->imageWriteErr_ == ESP_OK;
+}
+
+bool OtaWriter::deltaAcceptHeaderCb(void *arg, const AstrOsOtaDelta::PatchHeader &header)
+{
+    auto self = static_cast<OtaWriter *>(arg);
+    if (memcmp(header.targetSha256, self->expectedSha256_, sizeof(header.targetSha256)) != 0)
+    {
+        ESP_LOGE(TAG, "delta: patch targetSha256 disagrees with the announced image SHA — rejecting");
+        return false;
+    }
+    if (self->inactivePartition_ == nullptr || header.targetSize > self->inactivePartition_->size)
+    {
+        ESP_LOGE(TAG, "delta: targetSize=%u does not fit the inactive partition — rejecting",
+                 (unsigned)header.targetSize);
+        return false;
+    }
+    if (self->runningPartition_ == nullptr || header.baseSize > self->runningPartition_->size)
+    {
+        ESP_LOGE(TAG, "delta: baseSize=%u exceeds the running partition — rejecting", (unsigned)header.baseSize);
+        return false;
+    }
+    // Runs once per transfer while the first chunk is being handled. Hashing
+    // a ~1.5 MB base costs a few hundred ms — inside the master's 1.5 s ack
+    // timeout, and far cheaper than flashing a patch against the wrong base.
+    if (!self->verifyRunningImageSha(header.baseSize, header.baseSha256))
+    {
+        ESP_LOGE(TAG, "delta: running image does not match the patch base (server diffed against another build)");
+        return false;
+    }
+    ESP_LOGI(TAG, "delta: base verified (%u B); rebuilding %u B image, target version '%.*s'",
+             (unsigned)header.baseSize, (unsigned)header.targetSize, (int)sizeof(header.targetVersion),
+             header.targetVersion);
+    return true;
+}
+
+bool OtaWriter::verifyRunningImageSha(uint32_t size, const uint8_t expected[32])
+{
+    AstrOsSha256Ctx ctx;
+    AstrOsSha256_init(&ctx);
+    // 1 KB, not 4 KB: this runs nested inside handleLocalFlashReq, which
+    // already holds a 4 KB buffer on otaWriterTask's stack.
+    constexpr size_t kBufSize = 1024;
+    uint8_t buf[kBufSize];
+    for (uint32_t off = 0; off < size;)
+    {
+        size_t chunk = std::min(kBufSize, static_cast<size_t>(size - off));
+        esp_err_t err = esp_partition_read(runningPartition_, off, buf, chunk);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "delta: esp_partition_read(running) at off=%u failed: %s", (unsigned)off,
+                     esp_err_to_name(err));
+            return false;
+        }
+        AstrOsSha256_update(&ctx, buf, chunk);
+        off += chunk;
+    }
+    uint8_t digest[32];
+    AstrOsSha256_final(&ctx, digest);
+    return memcmp(digest, expected, sizeof(digest)) == 0;
+}
+
+esp_err_t OtaWriter::sendBeginAck(const uint8_t mac[6], uint8_t xferId, bool resumeOffered, uint32_t resumeSeq)
 {
     OtaBeginAckPayload p{};
     p.xferId = xferId;
+    p.resumeSeq = resumeSeq;
+    // A master that didn't offer RESUME predates the field and rejects any
+    // BEGIN_ACK that isn't exactly the 1-byte legacy frame.
+    const size_t len = resumeOffered ? sizeof(p) : OTA_BEGIN_ACK_LEGACY_SIZE;
     return AstrOs_EspNow.sendOtaFrame(mac, AstrOsPacketType::OTA_BEGIN_ACK, reinterpret_cast<const uint8_t *>(&p),
-                                      sizeof(p));
+                                      len);
 }
 
 esp_err_t OtaWriter::sendBeginNak(const uint8_t mac[6], uint8_t xferId, OtaBeginNakReason reason)
@@ -3,8 +3,23 @@
 
 #include <AnimationCommon.hpp>
 #include <AstrOsEnums.h>
+#include <AstrOsKangarooPacket.hpp>
+
+#include <array>
+#include <cstdint>
 #include <memory>
 
+// Kangaroo packet serial: the packet encoded at script load, sent as is at
+// baudRate. Commands hold it by pointer, null unless a KANGAROO command was
+// encoded, so every other command (and every build without packet serial)
+// carries only the pointer.
+struct KangarooPacket
+{
+    std::array<uint8_t, AstrOsKangaroo::kMaxPacketBytes> bytes{};
+    uint8_t size = 0;
+    int baudRate = 0;
+};
+
 class CommandTemplate
 {
 public:
@@ -13,6 +28,7 @@ public:
     MODULE_TYPE type;
     std::string val;
     int module;
+    std::shared_ptr<const KangarooPacket> packet;
 };
 
 class AnimationCommand
@@ -29,6 +45,12 @@ public:
     std::string commandTemplate;
     int duration;
     int module;
+    std::shared_ptr<const KangarooPacket> packet;
+
+    // For a KANGAROO command, encodes the packet serial form once so
+    // dispatch only copies bytes. Returns false for any other command or a
+    // Kangaroo command that can't be encoded (left to go out as text).
+    bool EncodeKangarooPacket(uint8_t address);
 
     std::unique_ptr<CommandTemplate> GetCommandTemplatePtr();
 };
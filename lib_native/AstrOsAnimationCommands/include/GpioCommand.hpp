@@ -3,14 +3,32 @@
 
 #include <BaseCommand.hpp>
 
+#include <cstdint>
+
+// Single channel:  type|duration|channel|state
+// Bitmask:         type|duration|-2|setMask|clearMask
+//
+// A bitmask command drives several GPIO channels at once: bit n of setMask
+// takes channel n high, bit n of clearMask takes it low, all in the same
+// register write. Masks are decimal or 0x-prefixed hex. The -2 channel
+// keeps older firmware from acting on it (out of range, rejected).
 class GpioCommand : public BaseCommand
 {
 private:
+    void parseMasks(const str_vec_t &parts);
+
 public:
+    static constexpr int MASK_CHANNEL = -2;
+
     GpioCommand(std::string val);
     ~GpioCommand();
     int channel;
     bool state;
+    // Bitmask command; setMask and clearMask are 0 if they failed to parse
+    // or overlap.
+    bool isMask;
+    uint32_t setMask;
+    uint32_t clearMask;
 };
 
 #endif
@@ -3,6 +3,8 @@
 
 #include <BaseCommand.hpp>
 
+#include <cstdint>
+
 class SerialCommand : public BaseCommand
 {
 private:
@@ -17,6 +19,10 @@ public:
     SerialCommand();
     ~SerialCommand();
     std::string GetValue();
+    // Kangaroo packet serial form of a KANGAROO command, written to `out`
+    // (room for AstrOsKangaroo::kMaxPacketBytes). Returns its length, 0
+    // for any other command or one that can't be encoded.
+    size_t ToKangarooPacket(uint8_t address, uint8_t *out);
     int serialChannel;
     int baudRate;
     std::string value;
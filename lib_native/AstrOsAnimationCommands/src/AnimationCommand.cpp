@@ -1,5 +1,7 @@
 #include "AnimationCommand.hpp"
 
+#include <SerialCommand.hpp>
+
 #include <cstdlib>
 #include <string>
 #include <vector>
@@ -19,9 +21,33 @@ AnimationCommand::AnimationCommand(std::string val) : commandTemplate(std::move(
 
 AnimationCommand::~AnimationCommand() {}
 
+bool AnimationCommand::EncodeKangarooPacket(uint8_t address)
+{
+    this->packet.reset();
+
+    if (this->commandType != MODULE_TYPE::KANGAROO)
+    {
+        return false;
+    }
+
+    SerialCommand cmd(this->commandTemplate);
+    auto encoded = std::make_shared<KangarooPacket>();
+    encoded->size = static_cast<uint8_t>(cmd.ToKangarooPacket(address, encoded->bytes.data()));
+    encoded->baudRate = cmd.baudRate;
+    if (encoded->size == 0)
+    {
+        return false;
+    }
+
+    this->packet = std::move(encoded);
+    return true;
+}
+
 std::unique_ptr<CommandTemplate> AnimationCommand::GetCommandTemplatePtr()
 {
-    return std::make_unique<CommandTemplate>(commandType, module, commandTemplate);
+    auto ptr = std::make_unique<CommandTemplate>(commandType, module, commandTemplate);
+    ptr->packet = this->packet;
+    return ptr;
 }
 
 void AnimationCommand::parseCommandType()
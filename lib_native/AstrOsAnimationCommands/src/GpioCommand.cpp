@@ -1,9 +1,16 @@
 #include "GpioCommand.hpp"
 
+#include <cctype>
+#include <cstdlib>
+
 GpioCommand::GpioCommand(std::string val)
 {
     str_vec_t parts = SplitTemplate(val);
 
+    this->isMask = false;
+    this->setMask = 0;
+    this->clearMask = 0;
+
     if (parts.size() < 4)
     {
         this->channel = -1;
@@ -12,7 +19,55 @@ GpioCommand::GpioCommand(std::string val)
     }
 
     this->channel = std::stoi(parts.at(2));
+    this->state = false;
+
+    if (this->channel == MASK_CHANNEL)
+    {
+        this->parseMasks(parts);
+        return;
+    }
+
     this->state = std::stoi(parts.at(3));
 }
 
 GpioCommand::~GpioCommand() {}
+
+void GpioCommand::parseMasks(const str_vec_t &parts)
+{
+    this->isMask = true;
+
+    if (parts.size() < 5)
+    {
+        return;
+    }
+
+    uint32_t masks[2];
+    for (int i = 0; i < 2; i++)
+    {
+        // Decimal unless 0x-prefixed: a zero-padded "010" is ten, not octal.
+        const std::string &field = parts.at(3 + i);
+        const bool hex = field.size() > 2 && field[0] == '0' && (field[1] == 'x' || field[1] == 'X');
+        const char *digits = field.c_str() + (hex ? 2 : 0);
+        char *end = nullptr;
+        // strtoull: unsigned long is 32 bits on the target, so strtoul would
+        // saturate an over-wide mask to 0xFFFFFFFF instead of failing.
+        unsigned long long value = std::strtoull(digits, &end, hex ? 16 : 10);
+        // strtoull also takes a sign or leading spaces
+        const unsigned char first = static_cast<unsigned char>(*digits);
+
+        if (!(hex ? std::isxdigit(first) : std::isdigit(first)) || *end != '\0' || value > UINT32_MAX)
+        {
+            return;
+        }
+        masks[i] = static_cast<uint32_t>(value);
+    }
+
+    // a channel can't go both ways
+    if ((masks[0] & masks[1]) != 0)
+    {
+        return;
+    }
+
+    this->setMask = masks[0];
+    this->clearMask = masks[1];
+}
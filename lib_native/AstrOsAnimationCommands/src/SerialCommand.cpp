@@ -1,5 +1,6 @@
 #include "SerialCommand.hpp"
 
+#include <AstrOsKangarooPacket.hpp>
 #include <AstrOsStringUtils.hpp>
 
 SerialCommand::SerialCommand(std::string val)
@@ -53,6 +54,18 @@ std::string SerialCommand::GetValue()
     }
 }
 
+size_t SerialCommand::ToKangarooPacket(uint8_t address, uint8_t *out)
+{
+    if (this->type != MODULE_TYPE::KANGAROO || this->cmd < KangarooAction::START ||
+        this->cmd > KangarooAction::POSITION_INCREMENTAL)
+    {
+        return 0;
+    }
+
+    return AstrOsKangaroo::encode(address, this->ch, static_cast<AstrOsKangaroo::Action>(this->cmd), this->spd,
+                                  this->pos, out);
+}
+
 std::string SerialCommand::ToKangarooCommand()
 {
     switch (this->cmd)
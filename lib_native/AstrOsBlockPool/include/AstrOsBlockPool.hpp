@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-size block pools for the payloads handed between tasks through
+// FreeRTOS queues (queue_msg_t::data and friends). Those used to be a
+// malloc() per hop and a free() in the consumer, thousands an hour while
+// a script runs, all different sizes, which fragments the heap over days
+// of uptime. Blocks come from static storage instead and go back to the
+// same free list.
+//
+// acquire() and release() are lock-free (one 32-bit compare-and-swap on
+// the free list head), so any task on either core, or the ESP-NOW receive
+// callback, can use them without a mutex. The head packs the first free
+// block's index with a tag that changes on every update, which keeps a
+// stalled compare-and-swap from succeeding after the list changed under
+// it (ABA).
+namespace AstrOsBlockPool
+{
+    struct Stats
+    {
+        uint32_t blockSize = 0;
+        uint32_t blocks = 0;
+        uint32_t inUse = 0;
+        // Most blocks in use at once since boot.
+        uint32_t highWater = 0;
+        // acquire() calls that found the pool empty.
+        uint32_t exhausted = 0;
+    };
+
+    template <size_t BlockSize, size_t Count> class BlockPool
+    {
+        static_assert(Count > 0 && Count < 0xFFFF, "BlockPool holds 1 to 65534 blocks");
+        static_assert(BlockSize % alignof(std::max_align_t) == 0, "BlockPool blocks must keep malloc alignment");
+
+    public:
+        BlockPool()
+        {
+            for (size_t i = 0; i < Count; i++)
+            {
+                next_[i].store(i + 1 < Count ? static_cast<uint16_t>(i + 1) : kNone, std::memory_order_relaxed);
+            }
+            head_.store(pack(0, 0), std::memory_order_release);
+        }
+
+        BlockPool(const BlockPool &) = delete;
+        BlockPool &operator=(const BlockPool &) = delete;
+
+        // A free block, or nullptr when all are in use.
+        void *acquire()
+        {
+            uint32_t head = head_.load(std::memory_order_acquire);
+            uint16_t idx;
+            do
+            {
+                idx = indexOf(head);
+                if (idx == kNone)
+                {
+                    exhausted_.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                // Stale if another task took idx meanwhile; the tag then
+                // fails the exchange and the loop rereads.
+                uint16_t next = next_[idx].load(std::memory_order_relaxed);
+                if (head_.compare_exchange_weak(head, pack(next, tagOf(head) + 1), std::memory_order_acq_rel,
+                                                std::memory_order_acquire))
+                {
+                    break;
+                }
+            } while (true);
+
+            uint32_t used = inUse_.fetch_add(1, std::memory_order_relaxed) + 1;
+            uint32_t high = highWater_.load(std::memory_order_relaxed);
+            while (used > high && !highWater_.compare_exchange_weak(high, used, std::memory_order_relaxed))
+            {
+            }
+            return storage_ + static_cast<size_t>(idx) * BlockSize;
+        }
+
+        bool owns(const void *p) const
+        {
+            const uint8_t *b = static_cast<const uint8_t *>(p);
+            return b >= storage_ && b < storage_ + sizeof(storage_);
+        }
+
+        // `p` must come from this pool's acquire() and not be released yet.
+        void release(void *p)
+        {
+            const uint16_t idx = static_cast<uint16_t>((static_cast<uint8_t *>(p) - storage_) / BlockSize);
+
+            uint32_t head = head_.load(std::memory_order_relaxed);
+            do
+            {
+                next_[idx].store(indexOf(head), std::memory_order_relaxed);
+            } while (!head_.compare_exchange_weak(head, pack(idx, tagOf(head) + 1), std::memory_order_release,
+                                                  std::memory_order_relaxed));
+
+            inUse_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        Stats stats() const
+        {
+            Stats s;
+            s.blockSize = BlockSize;
+            s.blocks = Count;
+            s.inUse = inUse_.load(std::memory_order_relaxed);
+            s.highWater = highWater_.load(std::memory_order_relaxed);
+            s.exhausted = exhausted_.load(std::memory_order_relaxed);
+            return s;
+        }
+
+    private:
+        static constexpr uint16_t kNone = 0xFFFF;
+
+        static uint32_t pack(uint16_t idx, uint16_t tag)
+        {
+            return (static_cast<uint32_t>(tag) << 16) | idx;
+        }
+        static uint16_t indexOf(uint32_t head)
+        {
+            return static_cast<uint16_t>(head & 0xFFFF);
+        }
+        static uint16_t tagOf(uint32_t head)
+        {
+            return static_cast<uint16_t>(head >> 16);
+        }
+
+        alignas(std::max_align_t) uint8_t storage_[BlockSize * Count];
+        // Free list links, by block index.
+        std::atomic<uint16_t> next_[Count];
+        std::atomic<uint32_t> head_{0};
+
+        std::atomic<uint32_t> inUse_{0};
+        std::atomic<uint32_t> highWater_{0};
+        std::atomic<uint32_t> exhausted_{0};
+    };
+
+    // The size classes queue payloads are drawn from. A request takes the
+    // smallest class it fits, the next one up if that is empty, and the
+    // heap only when every class that fits is empty or it is bigger than
+    // the largest block (config and interface messages can be). release()
+    // tells the two apart by address, so a consumer never needs to know
+    // where its payload came from.
+    class MessagePool
+    {
+    public:
+        static constexpr size_t kClasses = 4;
+
+        void *allocate(size_t size);
+        // nullptr is ignored; anything not from a block goes to free().
+        void release(void *p);
+
+        Stats stats(size_t cls) const;
+        // allocate() calls served by the heap.
+        uint32_t heapAllocations() const
+        {
+            return heapAllocations_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        // 20 KB: script commands and serial lines, ESP-NOW frames (up to
+        // 250 bytes), and the odd larger interface message.
+        BlockPool<16, 32> tiny_;
+        BlockPool<64, 48> small_;
+        BlockPool<256, 32> medium_;
+        BlockPool<2048, 4> large_;
+
+        std::atomic<uint32_t> heapAllocations_{0};
+    };
+
+    // Owns one MessagePool allocation until release() hands it on, usually
+    // into a queue message whose consumer returns it with
+    // MessagePool::release(). Freed on destruction otherwise, so a failed
+    // send can't leak it.
+    class Buffer
+    {
+    public:
+        Buffer() = default;
+        explicit Buffer(size_t size);
+        ~Buffer();
+
+        Buffer(Buffer &&other) noexcept;
+        Buffer &operator=(Buffer &&other) noexcept;
+        Buffer(const Buffer &) = delete;
+        Buffer &operator=(const Buffer &) = delete;
+
+        uint8_t *data() const
+        {
+            return data_;
+        }
+        explicit operator bool() const
+        {
+            return data_ != nullptr;
+        }
+        // Gives up ownership; the caller (or whoever it passes the pointer
+        // to) releases it.
+        uint8_t *release();
+
+    private:
+        uint8_t *data_ = nullptr;
+    };
+} // namespace AstrOsBlockPool
+
+extern AstrOsBlockPool::MessagePool QueuePool;
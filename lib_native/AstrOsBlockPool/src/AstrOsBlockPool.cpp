@@ -0,0 +1,107 @@
+#include <AstrOsBlockPool.hpp>
+
+#include <cstdlib>
+
+AstrOsBlockPool::MessagePool QueuePool;
+
+namespace AstrOsBlockPool
+{
+    void *MessagePool::allocate(size_t size)
+    {
+        void *p = nullptr;
+        if (size <= 16)
+        {
+            p = this->tiny_.acquire();
+        }
+        if (p == nullptr && size <= 64)
+        {
+            p = this->small_.acquire();
+        }
+        if (p == nullptr && size <= 256)
+        {
+            p = this->medium_.acquire();
+        }
+        if (p == nullptr && size <= 2048)
+        {
+            p = this->large_.acquire();
+        }
+        if (p == nullptr)
+        {
+            this->heapAllocations_.fetch_add(1, std::memory_order_relaxed);
+            p = std::malloc(size);
+        }
+        return p;
+    }
+
+    void MessagePool::release(void *p)
+    {
+        if (p == nullptr)
+        {
+            return;
+        }
+
+        if (this->tiny_.owns(p))
+        {
+            this->tiny_.release(p);
+        }
+        else if (this->small_.owns(p))
+        {
+            this->small_.release(p);
+        }
+        else if (this->medium_.owns(p))
+        {
+            this->medium_.release(p);
+        }
+        else if (this->large_.owns(p))
+        {
+            this->large_.release(p);
+        }
+        else
+        {
+            std::free(p);
+        }
+    }
+
+    Stats MessagePool::stats(size_t cls) const
+    {
+        switch (cls)
+        {
+        case 0:
+            return this->tiny_.stats();
+        case 1:
+            return this->small_.stats();
+        case 2:
+            return this->medium_.stats();
+        case 3:
+            return this->large_.stats();
+        default:
+            return Stats();
+        }
+    }
+
+    Buffer::Buffer(size_t size) : data_(static_cast<uint8_t *>(QueuePool.allocate(size))) {}
+
+    Buffer::~Buffer()
+    {
+        QueuePool.release(this->data_);
+    }
+
+    Buffer::Buffer(Buffer &&other) noexcept : data_(other.release()) {}
+
+    Buffer &Buffer::operator=(Buffer &&other) noexcept
+    {
+        if (this != &other)
+        {
+            QueuePool.release(this->data_);
+            this->data_ = other.release();
+        }
+        return *this;
+    }
+
+    uint8_t *Buffer::release()
+    {
+        uint8_t *p = this->data_;
+        this->data_ = nullptr;
+        return p;
+    }
+} // namespace AstrOsBlockPool
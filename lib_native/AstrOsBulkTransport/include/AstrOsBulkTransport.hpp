@@ -27,6 +27,44 @@ namespace AstrOsBulkTransport
     // ESP-IDF helper.
     uint16_t crc16_ccitt_false(const uint8_t *data, size_t len);
 
+    // Init value of CRC-16/CCITT-FALSE; also the CRC of empty input.
+    constexpr uint16_t kCrc16Init = 0xFFFFu;
+
+    // Incremental form: folds `len` more bytes into a running CRC. With no
+    // XOR-out or reflection the running value is the CRC itself, so
+    //   crc16_ccitt_false_update(crc16_ccitt_false(a, n), b, m)
+    // equals the CRC of a‖b. Same nullptr precondition as above.
+    uint16_t crc16_ccitt_false_update(uint16_t crc, const uint8_t *data, size_t len);
+
+    // Accumulator over scattered buffers (header + payload, ring-buffer
+    // halves) without copying them into one span first:
+    //
+    //   Crc16CcittFalse c;
+    //   c.update(hdr, sizeof(hdr));
+    //   c.update(payload, payloadLen);
+    //   uint16_t crc = c.final();
+    //
+    // final() doesn't consume the state; reset() starts over.
+    class Crc16CcittFalse
+    {
+    public:
+        void update(const uint8_t *data, size_t len)
+        {
+            crc_ = crc16_ccitt_false_update(crc_, data, len);
+        }
+        uint16_t final() const
+        {
+            return crc_;
+        }
+        void reset()
+        {
+            crc_ = kCrc16Init;
+        }
+
+    private:
+        uint16_t crc_ = kCrc16Init;
+    };
+
     enum class Decision : uint8_t
     {
         ACK,
@@ -46,7 +84,11 @@ namespace AstrOsBulkTransport
         CRC = 1,
         SIZE = 2,
         OUT_OF_ORDER = 3,
-        FLASH_FULL = 4
+        FLASH_FULL = 4,
+        // The chunks committed fine but the block they completed failed a
+        // content check above this layer (Merkle-verified OTA). Unlike the
+        // others it may rewind BELOW already-ACKed seqs; see onDataNak.
+        BLOCK_REJECTED = 5
     };
 
     // Result of `BulkReceiver::onChunk`. Carries both ACK and NAK information
@@ -165,7 +207,8 @@ namespace AstrOsBulkTransport
             ZERO_CHUNK_SIZE = 1,
             ZERO_TOTAL_CHUNKS = 2,
             ZERO_WINDOW_SIZE = 3,
-            SIZE_INCONSISTENT = 4 // totalSize outside ((totalChunks - 1) * chunkSize, totalChunks * chunkSize]
+            SIZE_INCONSISTENT = 4,  // totalSize outside ((totalChunks - 1) * chunkSize, totalChunks * chunkSize]
+            RESUME_OUT_OF_RANGE = 5 // resumeSeq >= totalChunks — nothing left to receive
         };
         bool valid = false;
         Reason reason = Reason::ZERO_CHUNK_SIZE;
@@ -275,10 +318,18 @@ namespace AstrOsBulkTransport
     class BulkReceiver
     {
     public:
+        // resumeSeq > 0 starts the receiver as if seqs 0..resumeSeq-1 had
+        // already been committed — the MIXED caller restored them from a
+        // checkpoint and is responsible for the bytes really being on flash.
         BeginResult begin(uint8_t xferId, uint32_t totalSize, uint32_t totalChunks, uint16_t chunkSize,
-                          uint8_t windowSize);
+                          uint8_t windowSize, uint32_t resumeSeq = 0);
         ChunkResult onChunk(uint8_t xferId, uint32_t seq, uint16_t payloadLen, uint16_t crc16, const uint8_t *payload);
         EndResult onEnd(uint8_t xferId, uint32_t totalChunksSent);
+        // Un-commits seqs seq..nextSeq-1 so they are accepted again — the
+        // caller rejected bytes it had already taken (BLOCK_REJECTED) and
+        // NAKs the sender back to `seq`. False (no change) when inactive or
+        // seq > nextSeq.
+        bool rewind(uint32_t seq);
         void reset();
 
     private:
@@ -356,7 +407,8 @@ namespace AstrOsBulkTransport
         {
             OK = 0,
             WRONG_XFER_ID = 1,
-            NOT_AWAITING_BEGIN_ACK = 2
+            NOT_AWAITING_BEGIN_ACK = 2,
+            RESUME_OUT_OF_RANGE = 3 // resumeSeq >= totalChunks; sender stays AWAITING_BEGIN_ACK
         };
         Decision decision = Decision::NOT_AWAITING_BEGIN_ACK;
 
@@ -372,6 +424,10 @@ namespace AstrOsBulkTransport
         {
             return {Decision::NOT_AWAITING_BEGIN_ACK};
         }
+        static BeginAckResult resumeOutOfRange()
+        {
+            return {Decision::RESUME_OUT_OF_RANGE};
+        }
     };
 
     // Result of BulkSender::nextChunkToSend. On SEND, `seq` is the seq
@@ -615,7 +671,10 @@ namespace AstrOsBulkTransport
 
         [[nodiscard]] BeginSenderResult begin(uint8_t xferId, uint32_t totalChunks, uint16_t chunkSize,
                                               uint8_t windowSize, uint32_t ackTimeoutMs, uint8_t maxRetries);
-        [[nodiscard]] BeginAckResult onBeginAck(uint8_t xferId);
+        // resumeSeq is the receiver's first missing seq (OTA_BEGIN_ACK
+        // resumeSeq; 0 for a fresh transfer). Seqs below it count as
+        // confirmed and are never sent.
+        [[nodiscard]] BeginAckResult onBeginAck(uint8_t xferId, uint32_t resumeSeq = 0);
         // Precondition: `nowMs` must be monotonically non-decreasing across
         // successive calls. M3's MIXED caller drives this from
         // esp_timer_get_time()/1000. Non-monotonic clocks would corrupt the
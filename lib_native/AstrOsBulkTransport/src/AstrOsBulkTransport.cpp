@@ -53,16 +53,60 @@ namespace AstrOsBulkTransport
     static_assert(!std::is_copy_assignable_v<ChunkResult>);
     static_assert(std::is_copy_constructible_v<ChunkResult>);
 
-    // CRC-16/CCITT-FALSE. Bit-by-bit reference implementation:
+    // CRC-16/CCITT-FALSE, table-driven, slicing-by-8:
     //   poly = 0x1021, init = 0xFFFF, refIn = false, refOut = false, xorOut = 0.
-    // Table-based variants would be faster but the FW_CHUNK rate is bounded
-    // by the 115200-baud serial link (~11 KB/s sustained, so each ~4 KB
-    // chunk's CRC completes in well under a millisecond). No table needed.
-    uint16_t crc16_ccitt_false(const uint8_t *data, size_t len)
+    //
+    // The CRC runs on every OTA chunk at both ends (and on the sender's
+    // retransmits), so the bit-at-a-time loop it replaced showed up next to
+    // the radio. kCrc16Tables[k][b] is the CRC contribution of byte b
+    // followed by k zero bytes, starting from a zero register; eight bytes
+    // then fold in with eight independent lookups instead of 64 dependent
+    // shift/XOR steps. The tables are built at compile time (8 × 256 ×
+    // uint16_t = 4 KB of .rodata); nothing is generated at boot.
+    namespace
+    {
+        constexpr uint16_t kCrc16Poly = 0x1021u;
+        constexpr size_t kCrc16Slices = 8;
+
+        using Crc16Tables = std::array<std::array<uint16_t, 256>, kCrc16Slices>;
+
+        constexpr Crc16Tables makeCrc16Tables()
+        {
+            Crc16Tables t{};
+            for (size_t b = 0; b < 256; b++)
+            {
+                uint16_t crc = static_cast<uint16_t>(b << 8);
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    crc = (crc & 0x8000u) ? static_cast<uint16_t>((crc << 1) ^ kCrc16Poly)
+                                          : static_cast<uint16_t>(crc << 1);
+                }
+                t[0][b] = crc;
+            }
+            for (size_t k = 1; k < kCrc16Slices; k++)
+            {
+                for (size_t b = 0; b < 256; b++)
+                {
+                    const uint16_t prev = t[k - 1][b];
+                    t[k][b] = static_cast<uint16_t>((prev << 8) ^ t[0][prev >> 8]);
+                }
+            }
+            return t;
+        }
+
+        constexpr Crc16Tables kCrc16Tables = makeCrc16Tables();
+
+        // Spot-check the generator against the canonical byte table.
+        static_assert(kCrc16Tables[0][0x01] == 0x1021u);
+        static_assert(kCrc16Tables[0][0x80] == 0x9188u);
+        static_assert(kCrc16Tables[0][0xFF] == 0x1EF0u);
+    } // namespace
+
+    uint16_t crc16_ccitt_false_update(uint16_t crc, const uint8_t *data, size_t len)
     {
         // Precondition: `data` must be non-null whenever `len > 0`.
         //   - (anything, 0) is the legitimate empty-input case and returns
-        //     the init value 0xFFFFu.
+        //     `crc` unchanged (the init value 0xFFFFu via crc16_ccitt_false).
         //   - (nullptr, len > 0) is a caller programming error. The check
         //     below uses an unconditional abort path (NOT bare assert) so
         //     the precondition holds in NDEBUG/release builds too — assert()
@@ -81,34 +125,35 @@ namespace AstrOsBulkTransport
         // gets the same deterministic failure mode.
         if (data == nullptr && len > 0)
         {
-            assert(false && "crc16_ccitt_false: data is nullptr but len > 0");
+            assert(false && "crc16_ccitt_false_update: data is nullptr but len > 0");
             std::abort();
         }
-        if (len == 0)
+
+        const auto &t = kCrc16Tables;
+        // Only the first two bytes of a slice meet the 16-bit register; the
+        // other six are looked up as-is.
+        while (len >= kCrc16Slices)
         {
-            return 0xFFFFu;
+            crc = static_cast<uint16_t>(t[7][data[0] ^ (crc >> 8)] ^ t[6][data[1] ^ (crc & 0xFFu)] ^ t[5][data[2]] ^
+                                        t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^
+                                        t[0][data[7]]);
+            data += kCrc16Slices;
+            len -= kCrc16Slices;
         }
-        uint16_t crc = 0xFFFFu;
-        for (size_t i = 0; i < len; i++)
+        while (len-- > 0)
         {
-            crc ^= static_cast<uint16_t>(data[i]) << 8;
-            for (int bit = 0; bit < 8; bit++)
-            {
-                if (crc & 0x8000u)
-                {
-                    crc = static_cast<uint16_t>((crc << 1) ^ 0x1021u);
-                }
-                else
-                {
-                    crc = static_cast<uint16_t>(crc << 1);
-                }
-            }
+            crc = static_cast<uint16_t>((crc << 8) ^ t[0][(crc >> 8) ^ *data++]);
         }
         return crc;
     }
 
+    uint16_t crc16_ccitt_false(const uint8_t *data, size_t len)
+    {
+        return crc16_ccitt_false_update(kCrc16Init, data, len);
+    }
+
     BeginResult BulkReceiver::begin(uint8_t xferId, uint32_t totalSize, uint32_t totalChunks, uint16_t chunkSize,
-                                    uint8_t windowSize)
+                                    uint8_t windowSize, uint32_t resumeSeq)
     {
         // Reject protocol-illegal parameters by leaving the receiver inactive.
         // A zero chunkSize would make every chunk NAK with SIZE (because
@@ -155,9 +200,17 @@ namespace AstrOsBulkTransport
             reset();
             return BeginResult::invalid(BeginResult::Reason::SIZE_INCONSISTENT);
         }
+        // A resume point at or past the last chunk would leave onChunk
+        // nothing to accept and let onEnd pass without a single chunk on
+        // the wire; the caller restarts from 0 instead.
+        if (resumeSeq >= totalChunks)
+        {
+            reset();
+            return BeginResult::invalid(BeginResult::Reason::RESUME_OUT_OF_RANGE);
+        }
 
         xferId_ = xferId;
-        nextSeq_ = 0;
+        nextSeq_ = resumeSeq;
         totalSize_ = totalSize;
         totalChunks_ = totalChunks;
         chunkSize_ = chunkSize;
@@ -166,6 +219,16 @@ namespace AstrOsBulkTransport
         return BeginResult::ok();
     }
 
+    bool BulkReceiver::rewind(uint32_t seq)
+    {
+        if (!active_ || seq > nextSeq_)
+        {
+            return false;
+        }
+        nextSeq_ = seq;
+        return true;
+    }
+
     void BulkReceiver::reset()
     {
         xferId_ = 0;
@@ -393,7 +456,7 @@ namespace AstrOsBulkTransport
         return BeginSenderResult::ok();
     }
 
-    BeginAckResult BulkSender::onBeginAck(uint8_t xferId)
+    BeginAckResult BulkSender::onBeginAck(uint8_t xferId, uint32_t resumeSeq)
     {
         if (status_ != Status::AWAITING_BEGIN_ACK)
         {
@@ -403,6 +466,24 @@ namespace AstrOsBulkTransport
         {
             return BeginAckResult::wrongXferId();
         }
+        // Peer-controlled: a resume point past the last chunk would make
+        // nextChunkToSend report ALL_SENT without anything on the wire.
+        // Mirrors BulkReceiver::begin, which never offers one.
+        if (resumeSeq >= totalChunks_)
+        {
+            return BeginAckResult::resumeOutOfRange();
+        }
+        // Resume: the receiver already holds seqs 0..resumeSeq-1. Seed the
+        // watermarks as though they had been sent and cumulatively ACKed, so
+        // the ACK/NAK bounds checks treat the restored prefix like any other
+        // confirmed range.
+        if (resumeSeq > 0)
+        {
+            nextSeqToSend_ = resumeSeq;
+            highWaterSentSeq_ = resumeSeq;
+            highestConfirmedSeq_ = resumeSeq - 1;
+            anyConfirmed_ = true;
+        }
         status_ = Status::STREAMING;
         return BeginAckResult::ok();
     }
@@ -524,11 +605,21 @@ namespace AstrOsBulkTransport
             }
         }
 
+        // A NAK may have rewound the send cursor below seqs this ACK now
+        // covers (the ACK was overtaken on the way back). Move the cursor
+        // past them: resending would only draw OUT_OF_ORDER NAKs, and if the
+        // ACK covers the last chunk the caller sends OTA_END next, which
+        // onEndAck would reject as PREMATURE with the cursor left behind.
+        if (nextSeqToSend_ <= cumulativeSeq)
+        {
+            nextSeqToSend_ = cumulativeSeq + 1;
+        }
+
         const uint32_t newlyConfirmed = cumulativeSeq + 1 - prev;
         return AckResult::ok(newlyConfirmed);
     }
 
-    NakResult BulkSender::onDataNak(uint8_t xferId, uint32_t nextExpectedSeq, NakReason /*reason*/)
+    NakResult BulkSender::onDataNak(uint8_t xferId, uint32_t nextExpectedSeq, NakReason reason)
     {
         if (status_ != Status::STREAMING)
         {
@@ -577,7 +668,17 @@ namespace AstrOsBulkTransport
         //
         // nextExpectedSeq == 0 is the "receiver got nothing" case — no
         // implicit confirmation; leave the watermark untouched.
-        if (nextExpectedSeq > 0)
+        //
+        // BLOCK_REJECTED is the one reason that moves the watermark DOWN: the
+        // receiver un-committed chunks it had already ACKed (their block
+        // failed verification), so ACKs for their resends must count as new
+        // progress again, and DONE_OK must wait for them.
+        if (reason == NakReason::BLOCK_REJECTED)
+        {
+            highestConfirmedSeq_ = nextExpectedSeq > 0 ? nextExpectedSeq - 1 : 0;
+            anyConfirmed_ = nextExpectedSeq > 0;
+        }
+        else if (nextExpectedSeq > 0)
         {
             const uint32_t impliedCumulative = nextExpectedSeq - 1;
             if (!anyConfirmed_ || impliedCumulative > highestConfirmedSeq_)
@@ -593,9 +694,8 @@ namespace AstrOsBulkTransport
         // subsequent nextChunkToSend calls. The MIXED layer doesn't need to
         // know which slot belongs to which seq.
         //
-        // Reason is currently unused by the state machine (the wire layer
-        // logs it in M3); it's in the signature so future reason-aware
-        // retry policies don't break the API.
+        // Beyond BLOCK_REJECTED's watermark above, the reason doesn't change
+        // the rewind itself (the wire layer logs it).
         nextSeqToSend_ = nextExpectedSeq;
         inFlight_.fill(InFlightEntry{});
         return NakResult::ok(nextExpectedSeq);
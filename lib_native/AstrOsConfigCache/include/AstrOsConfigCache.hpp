@@ -0,0 +1,78 @@
+#pragma once
+
+#include <AstrOsStructs.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Binary image of the module configuration that boot reads instead of the
+// text files under gpio/ and maestro/. The text files stay the source of
+// truth; the blob is written next to them on every config save and is
+// thrown away (falling back to text) on any version, layout, length or
+// CRC mismatch.
+//
+//   header   magic "ACFG", version, layout tag, payload length, crc16   16 B
+//   payload  gpioCount u16, maestroCount u16
+//            gpioCount bytes (0 / 1)
+//            maestroCount raw maestro_config
+//            per maestro: channelCount u16, channelCount raw servo_channel
+//
+// The structs are stored in their in-memory layout so decode is a memcpy
+// per array. kLayoutTag folds in every field's size and offset: firmware
+// whose structs differ from the writer's rejects the blob rather than
+// misreading it.
+namespace AstrOsConfigCache
+{
+    constexpr uint16_t kFormatVersion = 1;
+    constexpr size_t kHeaderSize = 16;
+
+    constexpr size_t kMaxGpio = 64;
+    constexpr size_t kMaxMaestros = 16;
+    constexpr size_t kMaxChannels = 32;
+
+    constexpr size_t kMaxEncodedSize = kHeaderSize + 4 + kMaxGpio + kMaxMaestros * sizeof(maestro_config) +
+                                       kMaxMaestros * (2 + kMaxChannels * sizeof(servo_channel));
+
+    uint32_t layoutTag();
+
+    enum class Status : uint8_t
+    {
+        OK = 0,
+        TOO_SHORT = 1,
+        BAD_MAGIC = 2,
+        BAD_VERSION = 3,
+        BAD_LAYOUT = 4, // written by firmware with different structs
+        BAD_LENGTH = 5, // payload length disagrees with its counts or the buffer
+        BAD_CRC = 6,
+        TOO_LARGE = 7 // encode(): over one of the kMax* limits
+    };
+
+    const char *statusName(Status s);
+
+    // What the boot loaders hand out: GPIO defaults, the maestro module
+    // list, and each module's channels (servos[i] belongs to maestros[i]).
+    struct Snapshot
+    {
+        std::vector<bool> gpio;
+        std::vector<maestro_config> maestros;
+        std::vector<std::vector<servo_channel>> servos;
+
+        // Channels of the last module with this idx, nullptr if none.
+        const std::vector<servo_channel> *servosFor(int idx) const;
+    };
+
+    // Parses the same text the file loaders would: the GPIO config, the
+    // maestro modules file, and each module's servo config keyed by idx.
+    // A module without servo text gets no channels.
+    Snapshot fromText(const std::string &gpioText, const std::string &maestroText,
+                      const std::map<int, std::string> &servoTexts);
+
+    // Replaces `out` only on OK.
+    Status encode(const Snapshot &snapshot, std::vector<uint8_t> &out);
+    // Bytes after the payload are ignored (older firmware's SD backend
+    // stored a NUL terminator after every file). Replaces `out` only on OK.
+    Status decode(const uint8_t *data, size_t len, Snapshot &out);
+} // namespace AstrOsConfigCache
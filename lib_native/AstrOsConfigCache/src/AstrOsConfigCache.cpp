@@ -0,0 +1,263 @@
+#include <AstrOsBulkTransport.hpp>
+#include <AstrOsConfigCache.hpp>
+#include <AstrOsFileUtils.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+namespace AstrOsConfigCache
+{
+    namespace
+    {
+        // Little-endian "ACFG".
+        constexpr uint32_t kMagic = 0x47464341u;
+
+        void put16(uint8_t *p, uint16_t v)
+        {
+            p[0] = static_cast<uint8_t>(v);
+            p[1] = static_cast<uint8_t>(v >> 8);
+        }
+
+        void put32(uint8_t *p, uint32_t v)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                p[i] = static_cast<uint8_t>(v >> (8 * i));
+            }
+        }
+
+        uint16_t get16(const uint8_t *p)
+        {
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        uint32_t get32(const uint8_t *p)
+        {
+            return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+
+        // FNV-1a, one value at a time.
+        void mix(uint32_t &h, size_t v)
+        {
+            h ^= static_cast<uint32_t>(v);
+            h *= 16777619u;
+        }
+    } // namespace
+
+    uint32_t layoutTag()
+    {
+        uint32_t h = 2166136261u;
+        mix(h, sizeof(maestro_config));
+        mix(h, offsetof(maestro_config, idx));
+        mix(h, offsetof(maestro_config, uartChannel));
+        mix(h, offsetof(maestro_config, baudrate));
+        mix(h, sizeof(servo_channel));
+        mix(h, offsetof(servo_channel, id));
+        mix(h, offsetof(servo_channel, enabled));
+        mix(h, offsetof(servo_channel, isServo));
+        mix(h, offsetof(servo_channel, minPos));
+        mix(h, offsetof(servo_channel, maxPos));
+        mix(h, offsetof(servo_channel, home));
+        mix(h, offsetof(servo_channel, currentPos));
+        mix(h, offsetof(servo_channel, requestedPos));
+        mix(h, offsetof(servo_channel, lastPos));
+        mix(h, offsetof(servo_channel, speed));
+        mix(h, offsetof(servo_channel, acceleration));
+        mix(h, offsetof(servo_channel, inverted));
+        mix(h, offsetof(servo_channel, on));
+        mix(h, sizeof(bool));
+        return h;
+    }
+
+    const char *statusName(Status s)
+    {
+        switch (s)
+        {
+        case Status::OK:
+            return "ok";
+        case Status::TOO_SHORT:
+            return "too_short";
+        case Status::BAD_MAGIC:
+            return "bad_magic";
+        case Status::BAD_VERSION:
+            return "bad_version";
+        case Status::BAD_LAYOUT:
+            return "bad_layout";
+        case Status::BAD_LENGTH:
+            return "bad_length";
+        case Status::BAD_CRC:
+            return "bad_crc";
+        case Status::TOO_LARGE:
+            return "too_large";
+        }
+        return "unknown";
+    }
+
+    const std::vector<servo_channel> *Snapshot::servosFor(int idx) const
+    {
+        for (size_t i = maestros.size(); i > 0; i--)
+        {
+            if (maestros[i - 1].idx == idx)
+            {
+                return &servos[i - 1];
+            }
+        }
+        return nullptr;
+    }
+
+    Snapshot fromText(const std::string &gpioText, const std::string &maestroText,
+                      const std::map<int, std::string> &servoTexts)
+    {
+        Snapshot s;
+        s.gpio = AstrOsFileUtils::parseGpioConfig(gpioText);
+        s.maestros = AstrOsFileUtils::parseMaestroConfig(maestroText);
+        s.servos.reserve(s.maestros.size());
+        for (const maestro_config &m : s.maestros)
+        {
+            auto it = servoTexts.find(m.idx);
+            s.servos.push_back(it == servoTexts.end() || it->second.empty()
+                                   ? std::vector<servo_channel>()
+                                   : AstrOsFileUtils::parseServoConfig(it->second));
+        }
+        return s;
+    }
+
+    Status encode(const Snapshot &snapshot, std::vector<uint8_t> &out)
+    {
+        if (snapshot.gpio.size() > kMaxGpio || snapshot.maestros.size() > kMaxMaestros ||
+            snapshot.servos.size() != snapshot.maestros.size())
+        {
+            return Status::TOO_LARGE;
+        }
+        size_t payload = 4 + snapshot.gpio.size() + snapshot.maestros.size() * sizeof(maestro_config);
+        for (const auto &channels : snapshot.servos)
+        {
+            if (channels.size() > kMaxChannels)
+            {
+                return Status::TOO_LARGE;
+            }
+            payload += 2 + channels.size() * sizeof(servo_channel);
+        }
+
+        std::vector<uint8_t> blob(kHeaderSize + payload);
+        uint8_t *p = blob.data() + kHeaderSize;
+
+        put16(p, static_cast<uint16_t>(snapshot.gpio.size()));
+        put16(p + 2, static_cast<uint16_t>(snapshot.maestros.size()));
+        p += 4;
+        for (bool level : snapshot.gpio)
+        {
+            *p++ = level ? 1 : 0;
+        }
+        if (!snapshot.maestros.empty())
+        {
+            const size_t n = snapshot.maestros.size() * sizeof(maestro_config);
+            std::memcpy(p, snapshot.maestros.data(), n);
+            p += n;
+        }
+        for (const auto &channels : snapshot.servos)
+        {
+            put16(p, static_cast<uint16_t>(channels.size()));
+            p += 2;
+            if (!channels.empty())
+            {
+                const size_t n = channels.size() * sizeof(servo_channel);
+                std::memcpy(p, channels.data(), n);
+                p += n;
+            }
+        }
+
+        put32(blob.data(), kMagic);
+        put16(blob.data() + 4, kFormatVersion);
+        put32(blob.data() + 6, layoutTag());
+        put32(blob.data() + 10, static_cast<uint32_t>(payload));
+        put16(blob.data() + 14, AstrOsBulkTransport::crc16_ccitt_false(blob.data() + kHeaderSize, payload));
+
+        out.swap(blob);
+        return Status::OK;
+    }
+
+    Status decode(const uint8_t *data, size_t len, Snapshot &out)
+    {
+        if (data == nullptr || len < kHeaderSize)
+        {
+            return Status::TOO_SHORT;
+        }
+        if (get32(data) != kMagic)
+        {
+            return Status::BAD_MAGIC;
+        }
+        if (get16(data + 4) != kFormatVersion)
+        {
+            return Status::BAD_VERSION;
+        }
+        if (get32(data + 6) != layoutTag())
+        {
+            return Status::BAD_LAYOUT;
+        }
+        const size_t payload = get32(data + 10);
+        if (payload < 4 || payload > kMaxEncodedSize - kHeaderSize || payload > len - kHeaderSize)
+        {
+            return Status::BAD_LENGTH;
+        }
+        const uint8_t *p = data + kHeaderSize;
+        if (AstrOsBulkTransport::crc16_ccitt_false(p, payload) != get16(data + 14))
+        {
+            return Status::BAD_CRC;
+        }
+
+        // The CRC says these are the bytes encode() wrote, but the counts
+        // still bound every copy so a colliding blob can't overrun.
+        const uint8_t *end = p + payload;
+        const size_t gpioCount = get16(p);
+        const size_t maestroCount = get16(p + 2);
+        p += 4;
+        if (gpioCount > kMaxGpio || maestroCount > kMaxMaestros ||
+            static_cast<size_t>(end - p) < gpioCount + maestroCount * sizeof(maestro_config))
+        {
+            return Status::BAD_LENGTH;
+        }
+
+        Snapshot s;
+        s.gpio.reserve(gpioCount);
+        for (size_t i = 0; i < gpioCount; i++)
+        {
+            s.gpio.push_back(*p++ != 0);
+        }
+        s.maestros.resize(maestroCount);
+        if (maestroCount > 0)
+        {
+            std::memcpy(s.maestros.data(), p, maestroCount * sizeof(maestro_config));
+            p += maestroCount * sizeof(maestro_config);
+        }
+        s.servos.resize(maestroCount);
+        for (auto &channels : s.servos)
+        {
+            if (end - p < 2)
+            {
+                return Status::BAD_LENGTH;
+            }
+            const size_t count = get16(p);
+            p += 2;
+            if (count > kMaxChannels || static_cast<size_t>(end - p) < count * sizeof(servo_channel))
+            {
+                return Status::BAD_LENGTH;
+            }
+            channels.resize(count);
+            if (count > 0)
+            {
+                std::memcpy(channels.data(), p, count * sizeof(servo_channel));
+                p += count * sizeof(servo_channel);
+            }
+        }
+        if (p != end)
+        {
+            return Status::BAD_LENGTH;
+        }
+
+        out = std::move(s);
+        return Status::OK;
+    }
+} // namespace AstrOsConfigCache
@@ -56,12 +56,17 @@ namespace AstrOsEspNowProtocol
         uint32_t totalChunks = 0;
         uint8_t sha256Expected[32] = {0};
         uint8_t flags = 0;
+        // OtaBeginMerkleExt; only meaningful when flags has OTA_BEGIN_FLAG_MERKLE.
+        uint32_t merkleDataSize = 0;
+        uint8_t merkleBlockLog2 = 0;
+        uint8_t merkleRoot[32] = {0};
         bool valid = false;
     };
 
     struct OtaBeginAckRecord
     {
         uint8_t xferId = 0;
+        uint32_t resumeSeq = 0; // 0 for the legacy 1-byte frame
         bool valid = false;
     };
 
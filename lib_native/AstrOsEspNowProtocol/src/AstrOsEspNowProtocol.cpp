@@ -312,13 +312,30 @@ namespace AstrOsEspNowProtocol
     OtaBeginRecord parseOtaBegin(const astros_packet_t &packet)
     {
         OtaBeginRecord rec;
+        // Two wire sizes: the plain 44-byte payload, and 81 bytes with the
+        // OtaBeginMerkleExt trailer. The MERKLE flag and the trailer come
+        // together or not at all.
         if (packet.packetType != AstrOsPacketType::OTA_BEGIN ||
-            packet.payloadSize != static_cast<int>(sizeof(OtaBeginPayload)))
+            (packet.payloadSize != static_cast<int>(sizeof(OtaBeginPayload)) &&
+             packet.payloadSize != static_cast<int>(OTA_BEGIN_MERKLE_SIZE)))
         {
             return rec; // valid stays false
         }
         OtaBeginPayload p;
         std::memcpy(&p, packet.payload, sizeof(p));
+        const bool merkle = (p.flags & OTA_BEGIN_FLAG_MERKLE) != 0;
+        if (merkle != (packet.payloadSize == static_cast<int>(OTA_BEGIN_MERKLE_SIZE)))
+        {
+            return rec;
+        }
+        if (merkle)
+        {
+            OtaBeginMerkleExt ext;
+            std::memcpy(&ext, packet.payload + sizeof(p), sizeof(ext));
+            rec.merkleDataSize = ext.dataSize;
+            rec.merkleBlockLog2 = ext.blockLog2;
+            std::memcpy(rec.merkleRoot, ext.root, 32);
+        }
         rec.xferId = p.xferId;
         rec.totalSize = p.totalSize;
         rec.chunkSize = p.chunkSize;
@@ -332,14 +349,18 @@ namespace AstrOsEspNowProtocol
     OtaBeginAckRecord parseOtaBeginAck(const astros_packet_t &packet)
     {
         OtaBeginAckRecord rec;
+        // Two wire sizes: the legacy 1-byte {xferId} from padawans that
+        // predate resume (or were not offered it), and the full payload.
         if (packet.packetType != AstrOsPacketType::OTA_BEGIN_ACK ||
-            packet.payloadSize != static_cast<int>(sizeof(OtaBeginAckPayload)))
+            (packet.payloadSize != static_cast<int>(sizeof(OtaBeginAckPayload)) &&
+             packet.payloadSize != static_cast<int>(OTA_BEGIN_ACK_LEGACY_SIZE)))
         {
             return rec;
         }
-        OtaBeginAckPayload p;
-        std::memcpy(&p, packet.payload, sizeof(p));
+        OtaBeginAckPayload p{};
+        std::memcpy(&p, packet.payload, packet.payloadSize);
         rec.xferId = p.xferId;
+        rec.resumeSeq = p.resumeSeq;
         rec.valid = true;
         return rec;
     }
@@ -421,7 +442,7 @@ namespace AstrOsEspNowProtocol
         OtaDataNakPayload p;
         std::memcpy(&p, packet.payload, sizeof(p));
         if (p.reason < static_cast<uint8_t>(OtaDataNakReason::CRC) ||
-            p.reason > static_cast<uint8_t>(OtaDataNakReason::WRITE))
+            p.reason > static_cast<uint8_t>(OtaDataNakReason::BLOCK))
         {
             return rec;
         }
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Groups queued I2C writes into bus transactions for the I2C engine
+// (lib/AstrOsI2cEngine). Writes are held in a FIFO per device address and
+// handed out one transaction per device in turn, so a device with a long
+// backlog (or one that keeps timing out) doesn't hold up the others.
+//
+// Register writes that continue the previous write's register range on the
+// same device are merged into one burst: a START, the address, the first
+// register and every data byte. That relies on the device auto-incrementing
+// its register pointer, so callers only submit Register writes for devices
+// that do (PCA9685 with MODE1.AI set, most sensor and LED drivers); raw
+// writes and calls are never merged.
+//
+// The batcher only decides grouping. Each write carries an opaque `tag`
+// (the engine's job) and a transaction lists the tags it covers, in order.
+namespace AstrOsI2cBatch
+{
+    constexpr size_t kMaxDevices = 8;
+    // Writes held per device.
+    constexpr size_t kQueueDepth = 16;
+    // Writes, and data bytes after the register, per merged transaction;
+    // 64 bytes is a whole PCA9685 frame (16 channels x 4 registers).
+    constexpr size_t kMaxMerge = 8;
+    constexpr size_t kMaxBurst = 64;
+
+    enum class Kind : uint8_t
+    {
+        // Bytes written as given (AstrOs light-board commands).
+        Raw,
+        // `len` bytes starting at register `reg`.
+        Register,
+        // Not a write: a function the engine runs on the bus in this
+        // device's turn (the OLED driver builds its own transactions).
+        Call,
+    };
+
+    struct Write
+    {
+        uint8_t addr;
+        Kind kind;
+        uint8_t reg;
+        uint8_t len;
+        void *tag;
+    };
+
+    struct Transaction
+    {
+        uint8_t addr;
+        Kind kind;
+        uint8_t reg;
+        // Data bytes over all merged writes.
+        uint16_t len;
+        size_t count;
+        void *tags[kMaxMerge];
+    };
+
+    class WriteBatcher
+    {
+    public:
+        // False if `w.addr` already has kQueueDepth writes waiting, or
+        // kMaxDevices other devices do; run next() to make room.
+        bool push(const Write &w);
+        // Takes the next transaction, rotating over devices with writes
+        // waiting. False when nothing is waiting.
+        bool next(Transaction &out);
+
+        size_t pending() const
+        {
+            return pending_;
+        }
+
+    private:
+        struct Device
+        {
+            uint8_t addr = 0;
+            uint8_t head = 0;
+            uint8_t count = 0;
+            Write fifo[kQueueDepth];
+        };
+
+        const Write &at(const Device &d, size_t i) const
+        {
+            return d.fifo[(d.head + i) % kQueueDepth];
+        }
+
+        Device devices_[kMaxDevices];
+        size_t cursor_ = 0;
+        size_t pending_ = 0;
+    };
+} // namespace AstrOsI2cBatch
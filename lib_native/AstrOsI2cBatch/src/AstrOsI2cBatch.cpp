@@ -0,0 +1,79 @@
+#include <AstrOsI2cBatch.hpp>
+
+namespace AstrOsI2cBatch
+{
+    bool WriteBatcher::push(const Write &w)
+    {
+        // A device keeps its slot only while it has writes waiting.
+        Device *slot = nullptr;
+        for (Device &d : devices_)
+        {
+            if (d.count > 0 && d.addr == w.addr)
+            {
+                slot = &d;
+                break;
+            }
+            if (d.count == 0 && slot == nullptr)
+            {
+                slot = &d;
+            }
+        }
+
+        if (slot == nullptr || slot->count == kQueueDepth)
+        {
+            return false;
+        }
+
+        if (slot->count == 0)
+        {
+            slot->addr = w.addr;
+            slot->head = 0;
+        }
+        slot->fifo[(slot->head + slot->count) % kQueueDepth] = w;
+        slot->count++;
+        pending_++;
+        return true;
+    }
+
+    bool WriteBatcher::next(Transaction &out)
+    {
+        for (size_t n = 0; n < kMaxDevices; n++)
+        {
+            Device &d = devices_[cursor_];
+            cursor_ = (cursor_ + 1) % kMaxDevices;
+            if (d.count == 0)
+            {
+                continue;
+            }
+
+            const Write &first = at(d, 0);
+            out.addr = d.addr;
+            out.kind = first.kind;
+            out.reg = first.reg;
+            out.len = first.len;
+            out.tags[0] = first.tag;
+            out.count = 1;
+
+            if (first.kind == Kind::Register)
+            {
+                while (out.count < d.count && out.count < kMaxMerge)
+                {
+                    const Write &w = at(d, out.count);
+                    if (w.kind != Kind::Register || w.reg != out.reg + out.len || out.len + w.len > kMaxBurst)
+                    {
+                        break;
+                    }
+                    out.len += w.len;
+                    out.tags[out.count++] = w.tag;
+                }
+            }
+
+            d.head = (d.head + out.count) % kQueueDepth;
+            d.count -= out.count;
+            pending_ -= out.count;
+            return true;
+        }
+
+        return false;
+    }
+} // namespace AstrOsI2cBatch
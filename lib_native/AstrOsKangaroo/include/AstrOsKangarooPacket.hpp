@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Kangaroo x2 packet serial encoder: the binary alternative to simplified
+// serial text ("1,p1234 s500\n"). A packet is
+//
+//   address | command | data length | data... | CRC-14 low 7 | high 7
+//
+// where only the address byte (128..135) has its top bit set, so the
+// Kangaroo can find the start of a packet in a stream, and a 14-bit CRC
+// over everything before it rejects a corrupted one instead of moving on
+// it. Numbers in the data are bit-packed: sign in bit 0, 6 bits per byte,
+// bit 6 set on every byte but the last.
+//
+// A move is about as long as its text form, but the Kangaroo can check it
+// and it needs no formatting: scripts encode each Kangaroo event once, at
+// load.
+namespace AstrOsKangaroo
+{
+    constexpr uint8_t kDefaultAddress = 128;
+
+    // commands
+    constexpr uint8_t kStart = 0x20;
+    constexpr uint8_t kHome = 0x22;
+    constexpr uint8_t kMove = 0x24;
+
+    // move types; a position move's speed limit follows as a kMoveSpeed pair
+    constexpr uint8_t kMovePosition = 0x01;
+    constexpr uint8_t kMoveSpeed = 0x02;
+    constexpr uint8_t kMovePositionIncremental = 0x41;
+    constexpr uint8_t kMoveSpeedIncremental = 0x42;
+
+    // Bit-packed int32_t: 33 bits at 6 per byte.
+    constexpr size_t kMaxNumberBytes = 6;
+    // Longest packet: header 3, name, flags, two move type / value pairs,
+    // CRC 2.
+    constexpr size_t kMaxPacketBytes = 3 + 2 + 2 * (1 + kMaxNumberBytes) + 2;
+
+    // Same values as KangarooAction in AstrOsAnimationCommands.
+    enum class Action : uint8_t
+    {
+        Start = 0,
+        Home = 1,
+        Speed = 2,
+        Position = 3,
+        SpeedIncremental = 4,
+        PositionIncremental = 5,
+    };
+
+    // CRC-14 of the packet's bytes (polynomial 0x22F0 reflected, initial
+    // and final XOR 0x3FFF), as the Kangaroo checks it.
+    uint16_t crc14(const uint8_t *data, size_t len);
+
+    // Writes `value` bit-packed to `out` (room for kMaxNumberBytes);
+    // returns the byte count.
+    size_t bitPack(int32_t value, uint8_t *out);
+
+    // Encodes `action` on channel `channel` (1, 2, ...; sent as its ASCII
+    // name) into `out` (room for kMaxPacketBytes). `speed` is the speed,
+    // or for a position move its speed limit (none when 0 or less).
+    // Returns the packet length, or 0 for an address below 128, a channel
+    // outside 0..9 or an unknown action.
+    size_t encode(uint8_t address, int channel, Action action, int32_t speed, int32_t position, uint8_t *out);
+} // namespace AstrOsKangaroo
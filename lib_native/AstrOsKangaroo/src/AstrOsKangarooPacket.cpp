@@ -0,0 +1,98 @@
+#include <AstrOsKangarooPacket.hpp>
+
+namespace AstrOsKangaroo
+{
+    namespace
+    {
+        constexpr uint8_t kHeaderBytes = 3;
+        constexpr uint8_t kFlagsDefault = 0x00;
+    } // namespace
+
+    uint16_t crc14(const uint8_t *data, size_t len)
+    {
+        uint16_t crc = 0x3FFF;
+        for (size_t i = 0; i < len; i++)
+        {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ 0x22F0 : crc >> 1;
+            }
+        }
+        return crc ^ 0x3FFF;
+    }
+
+    size_t bitPack(int32_t value, uint8_t *out)
+    {
+        // magnitude in a uint32_t, so INT32_MIN doesn't overflow
+        uint32_t magnitude = value < 0 ? 0U - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+        uint64_t encoded = (static_cast<uint64_t>(magnitude) << 1) | (value < 0 ? 1 : 0);
+
+        size_t n = 0;
+        do
+        {
+            uint8_t next = encoded & 0x3F;
+            encoded >>= 6;
+            if (encoded != 0)
+            {
+                next |= 0x40;
+            }
+            out[n++] = next;
+        } while (encoded != 0);
+        return n;
+    }
+
+    size_t encode(uint8_t address, int channel, Action action, int32_t speed, int32_t position, uint8_t *out)
+    {
+        if (address < 0x80 || channel < 0 || channel > 9)
+        {
+            return 0;
+        }
+
+        uint8_t *data = out + kHeaderBytes;
+        size_t n = 0;
+        data[n++] = static_cast<uint8_t>('0' + channel);
+        data[n++] = kFlagsDefault;
+
+        uint8_t command = kMove;
+        switch (action)
+        {
+        case Action::Start:
+            command = kStart;
+            break;
+        case Action::Home:
+            command = kHome;
+            break;
+        case Action::Speed:
+            data[n++] = kMoveSpeed;
+            n += bitPack(speed, data + n);
+            break;
+        case Action::SpeedIncremental:
+            data[n++] = kMoveSpeedIncremental;
+            n += bitPack(speed, data + n);
+            break;
+        case Action::Position:
+        case Action::PositionIncremental:
+            data[n++] = action == Action::Position ? kMovePosition : kMovePositionIncremental;
+            n += bitPack(position, data + n);
+            if (speed > 0)
+            {
+                data[n++] = kMoveSpeed;
+                n += bitPack(speed, data + n);
+            }
+            break;
+        default:
+            return 0;
+        }
+
+        out[0] = address;
+        out[1] = command;
+        out[2] = static_cast<uint8_t>(n);
+        n += kHeaderBytes;
+
+        const uint16_t crc = crc14(out, n);
+        out[n++] = crc & 0x7F;
+        out[n++] = (crc >> 7) & 0x7F;
+        return n;
+    }
+} // namespace AstrOsKangaroo
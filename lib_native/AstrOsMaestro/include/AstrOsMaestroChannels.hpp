@@ -0,0 +1,179 @@
+#pragma once
+
+#include <AstrOsStructs.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-controller channel state for MaestroModule. Each MaestroModule owns
+// one ChannelTable, so several Maestros on different UARTs no longer share
+// (and overwrite) one file-level servo_channel[24].
+//
+// Fields are stored one array per field, sized to the controller model
+// rather than always 24. Positions are microseconds.
+//
+// Powered servo channels are kept in a min-heap keyed on the time they
+// could have covered their whole range, computed once per command, so an
+// idle check looks only at the channels that are due. With position
+// readback wired, checkReadback() powers a channel off as soon as the
+// controller reports it at its target instead.
+//
+// Not synchronized: MaestroModule serializes every call.
+namespace AstrOsMaestro
+{
+    constexpr uint8_t kMaxChannels = 24;
+
+    // Channel count of the smallest Maestro model (Micro 6, Mini 12 / 18 /
+    // 24) with at least `configured` channels; 24 for anything larger.
+    uint8_t modelChannels(size_t configured);
+
+    class ChannelTable
+    {
+    public:
+        // Replaces all state. servos[i] configures channel i; channels past
+        // `count` up to the model size are disabled.
+        void load(const servo_channel *servos, size_t count);
+
+        uint8_t size() const
+        {
+            return size_;
+        }
+        bool contains(int ch) const
+        {
+            return ch >= 0 && ch < size_;
+        }
+
+        bool enabled(uint8_t ch) const
+        {
+            return (flags_[ch] & kEnabled) != 0;
+        }
+        bool isServo(uint8_t ch) const
+        {
+            return (flags_[ch] & kServo) != 0;
+        }
+        bool inverted(uint8_t ch) const
+        {
+            return (flags_[ch] & kInverted) != 0;
+        }
+        bool on(uint8_t ch) const
+        {
+            return on_[ch] != 0;
+        }
+        int minPos(uint8_t ch) const
+        {
+            return minPos_[ch];
+        }
+        int maxPos(uint8_t ch) const
+        {
+            return maxPos_[ch];
+        }
+        int homePos(uint8_t ch) const
+        {
+            return home_[ch];
+        }
+        int requestedPos(uint8_t ch) const
+        {
+            return requestedPos_[ch];
+        }
+        int lastPos(uint8_t ch) const
+        {
+            return lastPos_[ch];
+        }
+        int speed(uint8_t ch) const
+        {
+            return speed_[ch];
+        }
+        int acceleration(uint8_t ch) const
+        {
+            return accel_[ch];
+        }
+        // Bumped by every request() or home() on the channel and by load(),
+        // so a caller that dropped the lock can tell whether the channel was
+        // commanded again in the meantime.
+        uint16_t generation(uint8_t ch) const
+        {
+            return generation_[ch];
+        }
+
+        // Records a move and returns its target. `position` is a percentage
+        // of min..max (flipped when inverted), or home when negative; a
+        // GPIO channel goes high (2500) at 1500 or more and low (500) below.
+        // A servo channel is powered and its idle deadline restarts.
+        int request(uint8_t ch, int position, int speed, int acceleration);
+        // Homing a servo channel: target home at unlimited speed and
+        // acceleration, powered; home also becomes its last position.
+        void home(uint8_t ch);
+
+        // Advances the table's clock by `msSinceLastCheck` and powers off
+        // the servo channels whose deadline has passed. Writes them to `off`
+        // (room for size() entries) and returns how many.
+        size_t checkIdle(int msSinceLastCheck, uint8_t *off);
+        // `positions[i]` is the position (quarter microseconds) the
+        // controller reported for channel `chs[i]`, queried when its
+        // generation() was `generations[i]`. A powered servo channel
+        // reported at its target on kSettleChecks readbacks in a row is
+        // powered off; written to `off`, count returned. A channel not at
+        // its target (still moving, or its command not yet sent) starts
+        // settling over. A channel commanded since the query is skipped.
+        size_t checkReadback(const uint8_t *chs, const uint16_t *generations, const uint16_t *positions, size_t n,
+                             uint8_t *off);
+        void powerOffAll();
+        // Powered servo channels.
+        uint8_t activeCount() const
+        {
+            return activeCount_;
+        }
+        // Writes the powered servo channels to `out` (room for size()
+        // entries), soonest deadline first; returns how many.
+        size_t activeChannels(uint8_t *out) const;
+
+        // Readbacks a channel must match its target on before power-off:
+        // the controller's position is where it is driving the servo, and
+        // an unlimited-speed move gets there before the servo does.
+        static constexpr uint8_t kSettleChecks = 2;
+
+    private:
+        static constexpr uint8_t kEnabled = 0x01;
+        static constexpr uint8_t kServo = 0x02;
+        static constexpr uint8_t kInverted = 0x04;
+
+        void powerOn(uint8_t ch);
+        void powerOff(uint8_t ch);
+
+        // min-heap of powered channels on deadline_
+        bool before(uint8_t a, uint8_t b) const;
+        void swapAt(uint8_t i, uint8_t j);
+        void siftUp(uint8_t i);
+        void siftDown(uint8_t i);
+
+        uint8_t size_ = 0;
+
+        // config
+        std::vector<uint8_t> flags_;
+        std::vector<uint16_t> minPos_;
+        std::vector<uint16_t> maxPos_;
+        std::vector<uint16_t> home_;
+
+        // state
+        std::vector<uint16_t> requestedPos_;
+        std::vector<uint16_t> lastPos_;
+        std::vector<uint16_t> speed_;
+        std::vector<uint16_t> accel_;
+        std::vector<uint32_t> deadline_; // on clock_
+        std::vector<uint8_t> settle_;
+        std::vector<uint8_t> on_;
+        // Not reset by load(); see generation().
+        uint16_t generation_[kMaxChannels] = {};
+
+        // Milliseconds of checkIdle() so far; wraps after ~49 days, and
+        // deadlines are compared by signed difference.
+        uint32_t clock_ = 0;
+
+        // Powered servo channels, soonest deadline at heap_[0]; heapPos_
+        // is each channel's slot, for re-keying on a new command.
+        uint8_t heap_[kMaxChannels] = {};
+        uint8_t heapPos_[kMaxChannels] = {};
+        uint8_t activeCount_ = 0;
+    };
+} // namespace AstrOsMaestro
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Position readback over the Maestro's TX line. One query asks for every
+// powered channel at once, so a check is a single UART round trip:
+//
+//   request   GET_POSITION ch (2 bytes) per channel, then GET_MOVING_STATE
+//   reply     position low, high per channel (quarter microseconds), then
+//             1 if any servo is still moving, else 0
+//
+// The trailing moving-state byte frames the reply: if it is not 0 or 1 the
+// bytes are out of step and the reply is discarded.
+namespace AstrOsMaestro
+{
+    constexpr uint8_t kGetPosition = 0x90;
+    constexpr uint8_t kGetMovingState = 0x93;
+
+    // Bytes in the query and in its reply for `n` channels.
+    constexpr size_t queryBytes(size_t n)
+    {
+        return 2 * n + 1;
+    }
+    constexpr size_t replyBytes(size_t n)
+    {
+        return 2 * n + 1;
+    }
+
+    // Writes the query for `chs[0..n)` to `out` (room for queryBytes(n));
+    // returns the byte count.
+    size_t encodePositionQuery(const uint8_t *chs, size_t n, uint8_t *out);
+
+    // Reads `n` positions out of a reply of `len` bytes. False, with
+    // `positions` untouched, if the reply is short or misframed.
+    bool parsePositionReply(const uint8_t *in, size_t len, size_t n, uint16_t *positions, bool *anyMoving);
+} // namespace AstrOsMaestro
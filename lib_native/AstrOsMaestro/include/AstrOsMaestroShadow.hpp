@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What each channel of one Maestro holds — target, speed, acceleration —
+// as far as the commands sent to it say. A move is encoded as only the
+// compact-protocol commands that change something, back to back in one
+// buffer the caller sends as a single UART write:
+//
+//   SET_SPEED / SET_ACCELERATION   only when different from the shadow
+//   wake target                    before those, only if the channel is off
+//                                  (speed and acceleration don't take on an
+//                                  unpowered channel)
+//   SET_TARGET                     always; it is the move itself, and a
+//                                  cheap resync if the board was reset
+//
+// A repeated script move at the same speed and acceleration is 4 bytes
+// instead of 16.
+//
+// Registers start unknown and return to unknown on invalidate(), so after
+// a config reload, baud change or failed send everything is re-sent.
+// Not synchronized: MaestroModule serializes every call.
+namespace AstrOsMaestro
+{
+    // Compact protocol.
+    constexpr uint8_t kSetTarget = 0x84;
+    constexpr uint8_t kSetSpeed = 0x87;
+    constexpr uint8_t kSetAcceleration = 0x89;
+    constexpr uint8_t kSetMultipleTargets = 0x9F;
+
+    // Longest move(): wake, speed, acceleration and target.
+    constexpr size_t kMaxMoveBytes = 16;
+
+    class ShadowRegisters
+    {
+    public:
+        // `channels` registers, all unknown.
+        void reset(uint8_t channels);
+        void invalidate(uint8_t ch);
+        void invalidateAll();
+
+        // Appends to `out` (room for kMaxMoveBytes) the commands that take
+        // `ch` to `target` (quarter microseconds) at `speed` and
+        // `acceleration`; returns the byte count. `wakeTarget` (quarter
+        // microseconds, 0 for none) is what an unpowered channel is set to
+        // before a speed or acceleration change.
+        size_t move(uint8_t ch, uint16_t target, uint16_t speed, uint16_t acceleration, uint16_t wakeTarget,
+                    uint8_t *out);
+        // Appends SET_TARGET 0, which powers the channel off; returns 4.
+        size_t off(uint8_t ch, uint8_t *out);
+        // Records that the first `count` channels were sent target 0 (a
+        // SET_MULTIPLE_TARGETS panic stop).
+        void allOff(uint8_t count);
+
+        uint8_t size() const
+        {
+            return static_cast<uint8_t>(target_.size());
+        }
+
+    private:
+        static constexpr uint8_t kTargetKnown = 0x01;
+        static constexpr uint8_t kSpeedKnown = 0x02;
+        static constexpr uint8_t kAccelKnown = 0x04;
+
+        std::vector<uint16_t> target_; // 0 = off
+        std::vector<uint16_t> speed_;
+        std::vector<uint16_t> accel_;
+        std::vector<uint8_t> known_;
+    };
+} // namespace AstrOsMaestro
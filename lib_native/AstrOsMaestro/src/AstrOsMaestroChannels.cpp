@@ -0,0 +1,279 @@
+#include <AstrOsMaestroChannels.hpp>
+#include <AstrOsServoUtils.hpp>
+
+#include <algorithm>
+
+namespace AstrOsMaestro
+{
+    namespace
+    {
+        // Travel after which a servo is assumed to have arrived, at
+        // .25 * speed / 4 per 100 ms. 0..3000 covers an extended range servo
+        // (500..2500 us) with margin, and the slow step keeps power on long
+        // enough for the linear actuators, which are slow to react to
+        // changes.
+        constexpr uint32_t kIdleTravel = 3000;
+
+        // Milliseconds to cover kIdleTravel at `speed` and `acceleration`.
+        uint32_t idleMs(uint16_t speed, uint16_t acceleration)
+        {
+            // speed is (.25us/10ms) * n, where n is 0-255, 0 is no limit;
+            // acceleration, when lower, bounds it too (slow start / stop).
+            uint32_t step = speed == 0 ? 255 : speed;
+            if (acceleration != 0 && acceleration < step)
+            {
+                step = acceleration;
+            }
+            // kIdleTravel / (step / 1600 per ms), rounded up
+            return (kIdleTravel * 1600 + step - 1) / step;
+        }
+
+        // Wire value of a microsecond target.
+        uint16_t quarterUs(uint16_t us)
+        {
+            return static_cast<uint16_t>(std::min(us * 4, 0x3FFF));
+        }
+
+        // Maestro targets, speeds and accelerations are 14-bit on the wire.
+        uint16_t clamp14(int v)
+        {
+            return static_cast<uint16_t>(std::clamp(v, 0, 0x3FFF));
+        }
+    } // namespace
+
+    uint8_t modelChannels(size_t configured)
+    {
+        static const uint8_t models[] = {6, 12, 18, 24};
+        for (uint8_t n : models)
+        {
+            if (configured <= n)
+            {
+                return configured == 0 ? 0 : n;
+            }
+        }
+        return kMaxChannels;
+    }
+
+    void ChannelTable::load(const servo_channel *servos, size_t count)
+    {
+        count = std::min(count, static_cast<size_t>(kMaxChannels));
+        size_ = modelChannels(count);
+
+        flags_.assign(size_, 0);
+        minPos_.assign(size_, 0);
+        maxPos_.assign(size_, 0);
+        home_.assign(size_, 0);
+        requestedPos_.assign(size_, 0);
+        lastPos_.assign(size_, 0);
+        speed_.assign(size_, 0);
+        accel_.assign(size_, 0);
+        deadline_.assign(size_, 0);
+        settle_.assign(size_, 0);
+        on_.assign(size_, 0);
+        activeCount_ = 0;
+
+        for (uint16_t &g : generation_)
+        {
+            g++;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const servo_channel &s = servos[i];
+            flags_[i] = (s.enabled ? kEnabled : 0) | (s.isServo ? kServo : 0) | (s.inverted ? kInverted : 0);
+            minPos_[i] = clamp14(s.minPos);
+            maxPos_[i] = clamp14(s.maxPos);
+            home_[i] = clamp14(s.home);
+            requestedPos_[i] = clamp14(s.requestedPos);
+            lastPos_[i] = clamp14(s.lastPos);
+        }
+    }
+
+    int ChannelTable::request(uint8_t ch, int position, int speed, int acceleration)
+    {
+        int target = 0;
+
+        // if it's not a servo it's an on/off GPIO
+        if (!isServo(ch))
+        {
+            target = position >= 1500 ? 2500 : 500;
+        }
+        else if (position < 0)
+        {
+            target = home_[ch];
+        }
+        else
+        {
+            if (inverted(ch))
+            {
+                position = 100 - position;
+            }
+            target = GetRelativeRequestedPosition(minPos_[ch], maxPos_[ch], position);
+        }
+
+        requestedPos_[ch] = clamp14(target);
+        speed_[ch] = clamp14(speed);
+        accel_[ch] = clamp14(acceleration);
+
+        // A GPIO channel holds its level; only servos are powered down.
+        if (isServo(ch))
+        {
+            powerOn(ch);
+        }
+
+        return requestedPos_[ch];
+    }
+
+    void ChannelTable::home(uint8_t ch)
+    {
+        requestedPos_[ch] = home_[ch];
+        speed_[ch] = 0;
+        accel_[ch] = 0;
+        powerOn(ch);
+        lastPos_[ch] = home_[ch];
+    }
+
+    size_t ChannelTable::checkIdle(int msSinceLastCheck, uint8_t *off)
+    {
+        clock_ += static_cast<uint32_t>(std::max(msSinceLastCheck, 0));
+        size_t count = 0;
+
+        while (activeCount_ > 0 && static_cast<int32_t>(clock_ - deadline_[heap_[0]]) >= 0)
+        {
+            const uint8_t ch = heap_[0];
+            powerOff(ch);
+            off[count++] = ch;
+        }
+
+        return count;
+    }
+
+    size_t ChannelTable::checkReadback(const uint8_t *chs, const uint16_t *generations, const uint16_t *positions,
+                                       size_t n, uint8_t *off)
+    {
+        size_t count = 0;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const uint8_t ch = chs[i];
+            if (!contains(ch) || !on(ch) || generation_[ch] != generations[i])
+            {
+                continue;
+            }
+
+            if (positions[i] != quarterUs(requestedPos_[ch]))
+            {
+                settle_[ch] = 0;
+                continue;
+            }
+
+            if (++settle_[ch] >= kSettleChecks)
+            {
+                powerOff(ch);
+                off[count++] = ch;
+            }
+        }
+
+        return count;
+    }
+
+    void ChannelTable::powerOffAll()
+    {
+        std::fill(on_.begin(), on_.end(), 0);
+        activeCount_ = 0;
+    }
+
+    size_t ChannelTable::activeChannels(uint8_t *out) const
+    {
+        // Heap order is soonest-first at the root only; sort a copy so a
+        // partial readback still covers the channels due next.
+        std::copy(heap_, heap_ + activeCount_, out);
+        std::sort(out, out + activeCount_, [this](uint8_t a, uint8_t b) { return before(a, b); });
+        return activeCount_;
+    }
+
+    void ChannelTable::powerOn(uint8_t ch)
+    {
+        deadline_[ch] = clock_ + idleMs(speed_[ch], accel_[ch]);
+        settle_[ch] = 0;
+        generation_[ch]++;
+
+        if (on_[ch] == 0)
+        {
+            on_[ch] = 1;
+            heapPos_[ch] = activeCount_;
+            heap_[activeCount_++] = ch;
+            siftUp(heapPos_[ch]);
+            return;
+        }
+
+        // New command on a powered channel: its deadline moved either way.
+        siftUp(heapPos_[ch]);
+        siftDown(heapPos_[ch]);
+    }
+
+    void ChannelTable::powerOff(uint8_t ch)
+    {
+        const uint8_t i = heapPos_[ch];
+        on_[ch] = 0;
+        settle_[ch] = 0;
+
+        swapAt(i, --activeCount_);
+        if (i < activeCount_)
+        {
+            siftUp(i);
+            siftDown(i);
+        }
+    }
+
+    bool ChannelTable::before(uint8_t a, uint8_t b) const
+    {
+        return static_cast<int32_t>(deadline_[a] - deadline_[b]) < 0;
+    }
+
+    void ChannelTable::swapAt(uint8_t i, uint8_t j)
+    {
+        std::swap(heap_[i], heap_[j]);
+        heapPos_[heap_[i]] = i;
+        heapPos_[heap_[j]] = j;
+    }
+
+    void ChannelTable::siftUp(uint8_t i)
+    {
+        while (i > 0)
+        {
+            const uint8_t parent = (i - 1) / 2;
+            if (!before(heap_[i], heap_[parent]))
+            {
+                break;
+            }
+            swapAt(i, parent);
+            i = parent;
+        }
+    }
+
+    void ChannelTable::siftDown(uint8_t i)
+    {
+        while (true)
+        {
+            const uint8_t left = 2 * i + 1;
+            const uint8_t right = left + 1;
+            uint8_t smallest = i;
+
+            if (left < activeCount_ && before(heap_[left], heap_[smallest]))
+            {
+                smallest = left;
+            }
+            if (right < activeCount_ && before(heap_[right], heap_[smallest]))
+            {
+                smallest = right;
+            }
+            if (smallest == i)
+            {
+                break;
+            }
+            swapAt(i, smallest);
+            i = smallest;
+        }
+    }
+} // namespace AstrOsMaestro
@@ -0,0 +1,30 @@
+#include <AstrOsMaestroReadback.hpp>
+
+namespace AstrOsMaestro
+{
+    size_t encodePositionQuery(const uint8_t *chs, size_t n, uint8_t *out)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            out[2 * i] = kGetPosition;
+            out[2 * i + 1] = chs[i];
+        }
+        out[2 * n] = kGetMovingState;
+        return queryBytes(n);
+    }
+
+    bool parsePositionReply(const uint8_t *in, size_t len, size_t n, uint16_t *positions, bool *anyMoving)
+    {
+        if (len != replyBytes(n) || in[2 * n] > 1)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            positions[i] = static_cast<uint16_t>(in[2 * i] | (in[2 * i + 1] << 8));
+        }
+        *anyMoving = in[2 * n] == 1;
+        return true;
+    }
+} // namespace AstrOsMaestro
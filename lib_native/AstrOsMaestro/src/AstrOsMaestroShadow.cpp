@@ -0,0 +1,96 @@
+#include <AstrOsMaestroShadow.hpp>
+
+#include <algorithm>
+
+namespace AstrOsMaestro
+{
+    namespace
+    {
+        // Command, channel, 14-bit value as two 7-bit bytes.
+        size_t put(uint8_t *out, uint8_t cmd, uint8_t ch, uint16_t value)
+        {
+            out[0] = cmd;
+            out[1] = ch;
+            out[2] = value & 0x7F;
+            out[3] = (value >> 7) & 0x7F;
+            return 4;
+        }
+    } // namespace
+
+    void ShadowRegisters::reset(uint8_t channels)
+    {
+        target_.assign(channels, 0);
+        speed_.assign(channels, 0);
+        accel_.assign(channels, 0);
+        known_.assign(channels, 0);
+    }
+
+    void ShadowRegisters::invalidate(uint8_t ch)
+    {
+        if (ch < known_.size())
+        {
+            known_[ch] = 0;
+        }
+    }
+
+    void ShadowRegisters::invalidateAll()
+    {
+        std::fill(known_.begin(), known_.end(), 0);
+    }
+
+    size_t ShadowRegisters::move(uint8_t ch, uint16_t target, uint16_t speed, uint16_t acceleration,
+                                 uint16_t wakeTarget, uint8_t *out)
+    {
+        // A channel past the registers is encoded in full and not tracked.
+        const bool tracked = ch < known_.size();
+        const uint8_t known = tracked ? known_[ch] : 0;
+
+        const bool sendSpeed = !(known & kSpeedKnown) || speed_[ch] != speed;
+        const bool sendAccel = !(known & kAccelKnown) || accel_[ch] != acceleration;
+        const bool powered = (known & kTargetKnown) && target_[ch] != 0;
+
+        size_t n = 0;
+        if ((sendSpeed || sendAccel) && !powered && wakeTarget != 0)
+        {
+            n += put(out + n, kSetTarget, ch, wakeTarget);
+        }
+        if (sendSpeed)
+        {
+            n += put(out + n, kSetSpeed, ch, speed);
+        }
+        if (sendAccel)
+        {
+            n += put(out + n, kSetAcceleration, ch, acceleration);
+        }
+        n += put(out + n, kSetTarget, ch, target);
+
+        if (tracked)
+        {
+            target_[ch] = target;
+            speed_[ch] = speed;
+            accel_[ch] = acceleration;
+            known_[ch] = kTargetKnown | kSpeedKnown | kAccelKnown;
+        }
+        return n;
+    }
+
+    size_t ShadowRegisters::off(uint8_t ch, uint8_t *out)
+    {
+        if (ch < known_.size())
+        {
+            target_[ch] = 0;
+            known_[ch] |= kTargetKnown;
+        }
+        return put(out, kSetTarget, ch, 0);
+    }
+
+    void ShadowRegisters::allOff(uint8_t count)
+    {
+        count = std::min<size_t>(count, known_.size());
+        for (uint8_t ch = 0; ch < count; ch++)
+        {
+            target_[ch] = 0;
+            known_[ch] |= kTargetKnown;
+        }
+    }
+} // namespace AstrOsMaestro
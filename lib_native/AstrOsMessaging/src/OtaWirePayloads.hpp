@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 // On-wire byte layouts for ESP-NOW OTA frames (PR set 1).
@@ -32,7 +33,8 @@ enum class OtaDataNakReason : uint8_t
     CRC = 1,
     SIZE = 2,
     OUT_OF_ORDER = 3,
-    WRITE = 4 // esp_ota_write failed (MIXED layer only)
+    WRITE = 4, // esp_ota_write failed (MIXED layer only)
+    BLOCK = 5  // Merkle block failed verification; resend from nextExpectedSeq
 };
 
 enum class OtaEndStatus : uint8_t
@@ -51,10 +53,52 @@ struct __attribute__((packed)) OtaBeginPayload
     uint16_t chunkSize;
     uint32_t totalChunks;
     uint8_t sha256Expected[32];
-    uint8_t flags; // bit0=enable-psram-buffer (reserved for future use); 0 in PR set 1
+    uint8_t flags; // OTA_BEGIN_FLAG_* bits; 0 = plain full-image transfer
 };
 static_assert(sizeof(OtaBeginPayload) == 44, "OtaBeginPayload must be 44 bytes on the wire");
 
+// OtaBeginPayload::flags bits (wire-stable; never reassign a bit).
+//
+// DELTA: the OTA_DATA stream is an AstrOsOtaDelta patch against the image
+// the padawan is running, not the image itself. totalSize/totalChunks
+// describe the patch bytes on the wire; sha256Expected is the digest of the
+// REBUILT image (the patch header's targetSha256), so the padawan's
+// streamed + read-back verification is unchanged. Padawans that predate
+// this bit write the patch verbatim and fail safe with HASH_MISMATCH.
+//
+// COMPRESSED: the OTA_DATA stream is an AstrOsOtaCompress stream; the
+// padawan inflates it before anything else sees the bytes. Combines with
+// DELTA (a compressed patch). sha256Expected is still the digest of the
+// image that ends up on flash.
+//
+// RESUME: the master can restart the stream at OtaBeginAckPayload::resumeSeq.
+// Only with this bit set may the padawan resume from a checkpoint and reply
+// with the 5-byte BEGIN_ACK; otherwise it replies with the 1-byte legacy
+// form and starts from seq 0, so masters that predate resume keep working.
+//
+// MERKLE: an OtaBeginMerkleExt follows the 44-byte payload, and the OTA_DATA
+// stream is the AstrOsOtaMerkle framed stream (each block preceded by the
+// sibling hashes the padawan is missing). totalSize/totalChunks describe the
+// framed stream; OtaBeginMerkleExt::dataSize is the file inside it (the
+// image, or the delta / compressed file when those bits are also set).
+// Padawans that predate this bit reject the 81-byte BEGIN as malformed and
+// never ACK, so the master falls back to a plain BEGIN after the timeout.
+constexpr uint8_t OTA_BEGIN_FLAG_PSRAM_BUFFER = 0x01; // reserved for future use
+constexpr uint8_t OTA_BEGIN_FLAG_DELTA = 0x02;
+constexpr uint8_t OTA_BEGIN_FLAG_COMPRESSED = 0x04;
+constexpr uint8_t OTA_BEGIN_FLAG_RESUME = 0x08;
+constexpr uint8_t OTA_BEGIN_FLAG_MERKLE = 0x10;
+
+// Trailer on OTA_BEGIN when OTA_BEGIN_FLAG_MERKLE is set.
+struct __attribute__((packed)) OtaBeginMerkleExt
+{
+    uint32_t dataSize; // bytes the tree covers (unframed)
+    uint8_t blockLog2; // leaf block = 1 << blockLog2 bytes
+    uint8_t root[32];  // tree root over those blocks
+};
+static_assert(sizeof(OtaBeginMerkleExt) == 37, "OtaBeginMerkleExt must be 37 bytes on the wire");
+constexpr size_t OTA_BEGIN_MERKLE_SIZE = sizeof(OtaBeginPayload) + sizeof(OtaBeginMerkleExt);
+
 // OTA_DATA payload = header + variable-length firmware bytes.
 // The MIXED layer reads payloadLen bytes immediately after the header.
 struct __attribute__((packed)) OtaDataHeader
@@ -81,11 +125,16 @@ static_assert(sizeof(OtaEndPayload) == 37, "OtaEndPayload must be 37 bytes on th
 
 // ─── Upstream frames (padawan → master) ──────────────────────────────────
 
+// Appended-to, never reordered: the legacy frame is the 1-byte xferId
+// prefix (OTA_BEGIN_ACK_LEGACY_SIZE), sent whenever the BEGIN lacked
+// OTA_BEGIN_FLAG_RESUME. parseOtaBeginAck accepts both sizes.
 struct __attribute__((packed)) OtaBeginAckPayload
 {
     uint8_t xferId;
+    uint32_t resumeSeq = 0; // first seq the padawan still needs; 0 = fresh transfer
 };
-static_assert(sizeof(OtaBeginAckPayload) == 1, "OtaBeginAckPayload must be 1 byte on the wire");
+static_assert(sizeof(OtaBeginAckPayload) == 5, "OtaBeginAckPayload must be 5 bytes on the wire");
+constexpr size_t OTA_BEGIN_ACK_LEGACY_SIZE = 1;
 
 struct __attribute__((packed)) OtaBeginNakPayload
 {
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Streaming decoder for compressed OTA transfers.
+//
+// A compressed transfer ships an LZ77-style token stream instead of the raw
+// bytes; the receiver inflates it while the chunks arrive over OTA_DATA and
+// hands every decoded byte on (to esp_ota_write, or to the delta applier
+// when the decoded stream is itself an AstrOsOtaDelta patch). Back-references
+// are resolved against a bounded window that lives inside the decoder, so
+// the receiver never has to re-read flash it already wrote.
+//
+// Stream layout (all multi-byte integers little-endian, matching the
+// OtaWirePayloads.hpp convention):
+//
+//   StreamHeader (44 B)
+//   token*                  until exactly rawSize bytes are decoded
+//
+//   token LITERAL = 0b0nnnnnnn | (n + 1) literal bytes        (1..128)
+//   token MATCH   = 0b1nnnnnnn | u16 (distance - 1)
+//                   copy (n + kMinMatch) bytes from `distance` back (3..130)
+//
+// A MATCH may overlap the bytes it produces (distance < length), which is
+// how runs are encoded. distance never exceeds the header's window nor the
+// number of bytes decoded so far.
+//
+// The decoder is pure: output goes through a C-style callback (fn pointer +
+// void *ctx, same shape as esp_timer callbacks) so the MIXED caller decides
+// what "output" means.
+namespace AstrOsOtaCompress
+{
+    constexpr uint8_t kMagic[4] = {'A', 'L', 'Z', 'S'};
+    constexpr uint8_t kFormatVersion = 1;
+    // Largest window a stream may declare. Sets the decoder's RAM cost
+    // (1 << kMaxWindowBits bytes); generators must not reference further back.
+    constexpr uint8_t kMaxWindowBits = 12;
+    constexpr uint8_t kMinWindowBits = 8;
+    constexpr size_t kMinMatch = 3;
+    constexpr size_t kMaxMatch = 0x7F + kMinMatch;
+    constexpr size_t kMaxLiteralRun = 0x80;
+    constexpr uint8_t kMatchBit = 0x80;
+
+    struct __attribute__((packed)) StreamHeader
+    {
+        uint8_t magic[4];      // kMagic
+        uint8_t formatVersion; // kFormatVersion
+        uint8_t windowBits;    // kMinWindowBits..kMaxWindowBits
+        uint8_t reserved[2];   // zero
+        uint32_t rawSize;      // bytes the stream decodes to
+        uint8_t rawSha256[32]; // SHA-256 over the decoded bytes
+    };
+    static_assert(sizeof(StreamHeader) == 44, "StreamHeader must be 44 bytes on the wire");
+
+    // Output sink, called in stream order with at most window-size bytes.
+    // Returns false on IO failure; the decoder then fails with WRITE_FAILED.
+    using WriteOutFn = bool (*)(void *ctx, const uint8_t *data, size_t len);
+    // Called once, after the header parses and before any token decodes.
+    // Returns false to reject the stream with HEADER_REJECTED.
+    using AcceptHeaderFn = bool (*)(void *ctx, const StreamHeader &header);
+
+    struct StreamIo
+    {
+        void *ctx = nullptr;
+        WriteOutFn writeOut = nullptr;
+        AcceptHeaderFn acceptHeader = nullptr; // optional
+    };
+
+    enum class Status : uint8_t
+    {
+        OK = 0,
+        NOT_STARTED = 1,     // feed()/finish() before begin()
+        BAD_MAGIC = 2,       // header magic mismatch — not a compressed stream
+        BAD_VERSION = 3,     // unsupported formatVersion
+        BAD_HEADER = 4,      // zero rawSize / windowBits out of range / non-zero reserved bytes
+        HEADER_REJECTED = 5, // AcceptHeaderFn returned false
+        BAD_DISTANCE = 6,    // MATCH reaches before the window or the stream start
+        OUTPUT_OVERFLOW = 7, // token would decode past rawSize
+        TRAILING_DATA = 8,   // bytes after the final token
+        TRUNCATED = 9,       // finish() before rawSize bytes were decoded
+        WRITE_FAILED = 10    // WriteOutFn returned false
+    };
+
+    struct [[nodiscard]] DecodeResult
+    {
+        bool ok = false;
+        Status status = Status::NOT_STARTED;
+
+        static DecodeResult success()
+        {
+            return {true, Status::OK};
+        }
+        static DecodeResult failed(Status s)
+        {
+            return {false, s};
+        }
+    };
+
+    struct [[nodiscard]] HeaderResult
+    {
+        bool valid = false;
+        Status status = Status::BAD_MAGIC;
+        StreamHeader header{};
+    };
+
+    // Stateless header check for callers that only need to know whether a
+    // staged file is a compressed stream. Validates magic, formatVersion,
+    // windowBits, reserved bytes and rawSize; does not look at any token.
+    HeaderResult parseHeader(const uint8_t *buf, size_t len);
+
+    // Incremental decoder. feed() accepts the stream in arbitrary splits —
+    // token headers and literal runs may straddle calls. Decoded bytes are
+    // batched in the window and flushed to WriteOutFn when the window wraps
+    // and before feed() returns, so the sink sees few, large writes.
+    //
+    // Errors are sticky: after the first failure every feed()/finish()
+    // returns the same status until begin() or reset(). On any failure the
+    // sink may already hold a partial stream; the caller aborts.
+    //
+    // Usage:
+    //   StreamDecoder d;
+    //   d.begin(io);
+    //   for each chunk: if (!d.feed(p, n).ok) abort;
+    //   if (!d.finish().ok) abort;   // TRUNCATED if the stream ended early
+    class StreamDecoder
+    {
+    public:
+        void begin(const StreamIo &io);
+        DecodeResult feed(const uint8_t *data, size_t len);
+        DecodeResult finish() const;
+        void reset();
+
+        // True once the header parsed and AcceptHeaderFn (if any) accepted it.
+        bool headerAccepted() const
+        {
+            return headerAccepted_;
+        }
+        // Valid only when headerAccepted().
+        const StreamHeader &header() const
+        {
+            return header_;
+        }
+        // Decoded bytes handed to WriteOutFn so far.
+        uint32_t bytesOut() const
+        {
+            return flushedTotal_;
+        }
+
+    private:
+        enum class State : uint8_t
+        {
+            IDLE,
+            HEADER,
+            TOKEN,
+            MATCH_DISTANCE,
+            LITERAL,
+            DONE,
+            FAILED
+        };
+
+        static constexpr size_t kWindowSize = size_t(1) << kMaxWindowBits;
+
+        DecodeResult fail(Status s);
+        DecodeResult onHeaderComplete();
+        DecodeResult emitMatch(uint32_t distance, size_t length);
+        bool put(uint8_t b);
+        bool putSpan(const uint8_t *data, size_t len);
+        bool flush();
+        void markDoneIfComplete();
+
+        StreamIo io_{};
+        State state_ = State::IDLE;
+        bool headerAccepted_ = false;
+        Status failStatus_ = Status::NOT_STARTED;
+        StreamHeader header_{};
+        // Accumulates the header, then a MATCH's distance bytes, across feeds.
+        uint8_t pending_[sizeof(StreamHeader)] = {0};
+        size_t pendingLen_ = 0;
+        size_t runRemaining_ = 0;   // literal bytes left, or match length while reading its distance
+        uint32_t windowLimit_ = 0;  // 1 << header.windowBits
+        uint32_t decoded_ = 0;      // bytes decoded (flushed or not)
+        uint32_t flushedTotal_ = 0; // bytes handed to WriteOutFn
+        size_t head_ = 0;           // next write position in window_
+        size_t flushStart_ = 0;     // first unflushed position in window_
+        // Ring of the most recent decoded bytes. Lives in the object (not on
+        // the caller's stack) because the OTA writer task is stack-bound.
+        uint8_t window_[kWindowSize] = {0};
+    };
+} // namespace AstrOsOtaCompress
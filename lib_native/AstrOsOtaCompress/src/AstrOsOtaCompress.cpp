@@ -0,0 +1,297 @@
+#include <AstrOsOtaCompress.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace AstrOsOtaCompress
+{
+    // Pin the wire-stable token layout + status values. A change here
+    // silently changes what existing staged streams decode to.
+    static_assert(kMatchBit == 0x80 && kMaxLiteralRun == 0x80, "token layout is wire-stable");
+    static_assert(kMinMatch == 3 && kMaxMatch == 130, "match length range is wire-stable");
+    static_assert(static_cast<uint8_t>(Status::WRITE_FAILED) == 10, "Status values are log-stable");
+
+    HeaderResult parseHeader(const uint8_t *buf, size_t len)
+    {
+        HeaderResult r;
+        if (buf == nullptr || len < sizeof(StreamHeader))
+        {
+            r.status = Status::TRUNCATED;
+            return r;
+        }
+        std::memcpy(&r.header, buf, sizeof(StreamHeader));
+
+        if (std::memcmp(r.header.magic, kMagic, sizeof(kMagic)) != 0)
+        {
+            r.status = Status::BAD_MAGIC;
+            return r;
+        }
+        if (r.header.formatVersion != kFormatVersion)
+        {
+            r.status = Status::BAD_VERSION;
+            return r;
+        }
+        if (r.header.windowBits < kMinWindowBits || r.header.windowBits > kMaxWindowBits ||
+            r.header.reserved[0] != 0 || r.header.reserved[1] != 0 || r.header.rawSize == 0)
+        {
+            r.status = Status::BAD_HEADER;
+            return r;
+        }
+
+        r.valid = true;
+        r.status = Status::OK;
+        return r;
+    }
+
+    void StreamDecoder::begin(const StreamIo &io)
+    {
+        reset();
+        io_ = io;
+        state_ = State::HEADER;
+    }
+
+    void StreamDecoder::reset()
+    {
+        io_ = StreamIo{};
+        state_ = State::IDLE;
+        headerAccepted_ = false;
+        failStatus_ = Status::NOT_STARTED;
+        header_ = StreamHeader{};
+        pendingLen_ = 0;
+        runRemaining_ = 0;
+        windowLimit_ = 0;
+        decoded_ = 0;
+        flushedTotal_ = 0;
+        head_ = 0;
+        flushStart_ = 0;
+    }
+
+    DecodeResult StreamDecoder::fail(Status s)
+    {
+        state_ = State::FAILED;
+        failStatus_ = s;
+        return DecodeResult::failed(s);
+    }
+
+    DecodeResult StreamDecoder::feed(const uint8_t *data, size_t len)
+    {
+        if (state_ == State::IDLE)
+        {
+            return DecodeResult::failed(Status::NOT_STARTED);
+        }
+        if (state_ == State::FAILED)
+        {
+            return DecodeResult::failed(failStatus_);
+        }
+
+        size_t pos = 0;
+        while (pos < len)
+        {
+            switch (state_)
+            {
+            case State::HEADER:
+            {
+                size_t take = std::min(sizeof(StreamHeader) - pendingLen_, len - pos);
+                std::memcpy(pending_ + pendingLen_, data + pos, take);
+                pendingLen_ += take;
+                pos += take;
+                if (pendingLen_ == sizeof(StreamHeader))
+                {
+                    auto r = onHeaderComplete();
+                    if (!r.ok)
+                    {
+                        return r;
+                    }
+                }
+                break;
+            }
+            case State::TOKEN:
+            {
+                const uint8_t token = data[pos++];
+                if (token & kMatchBit)
+                {
+                    runRemaining_ = (token & 0x7F) + kMinMatch;
+                    pendingLen_ = 0;
+                    state_ = State::MATCH_DISTANCE;
+                }
+                else
+                {
+                    runRemaining_ = static_cast<size_t>(token) + 1;
+                    if (static_cast<uint64_t>(decoded_) + runRemaining_ > header_.rawSize)
+                    {
+                        return fail(Status::OUTPUT_OVERFLOW);
+                    }
+                    state_ = State::LITERAL;
+                }
+                break;
+            }
+            case State::MATCH_DISTANCE:
+            {
+                size_t take = std::min(size_t(2) - pendingLen_, len - pos);
+                std::memcpy(pending_ + pendingLen_, data + pos, take);
+                pendingLen_ += take;
+                pos += take;
+                if (pendingLen_ == 2)
+                {
+                    const uint32_t distance = (static_cast<uint32_t>(pending_[0]) |
+                                               (static_cast<uint32_t>(pending_[1]) << 8)) + 1;
+                    pendingLen_ = 0;
+                    auto r = emitMatch(distance, runRemaining_);
+                    if (!r.ok)
+                    {
+                        return r;
+                    }
+                    state_ = State::TOKEN;
+                    markDoneIfComplete();
+                }
+                break;
+            }
+            case State::LITERAL:
+            {
+                size_t take = std::min(runRemaining_, len - pos);
+                if (!putSpan(data + pos, take))
+                {
+                    return fail(Status::WRITE_FAILED);
+                }
+                runRemaining_ -= take;
+                pos += take;
+                if (runRemaining_ == 0)
+                {
+                    state_ = State::TOKEN;
+                    markDoneIfComplete();
+                }
+                break;
+            }
+            case State::DONE:
+                return fail(Status::TRAILING_DATA);
+            case State::IDLE:
+            case State::FAILED:
+                // Unreachable: both are handled before the loop and no
+                // branch inside the loop transitions into IDLE, and every
+                // transition into FAILED returns immediately.
+                return DecodeResult::failed(failStatus_);
+            }
+        }
+
+        // Hand everything decoded by this call to the sink before returning,
+        // so a caller that acks the chunk afterwards has really written it.
+        if (!flush())
+        {
+            return fail(Status::WRITE_FAILED);
+        }
+        return DecodeResult::success();
+    }
+
+    DecodeResult StreamDecoder::finish() const
+    {
+        switch (state_)
+        {
+        case State::DONE:
+            return DecodeResult::success();
+        case State::IDLE:
+            return DecodeResult::failed(Status::NOT_STARTED);
+        case State::FAILED:
+            return DecodeResult::failed(failStatus_);
+        default:
+            return DecodeResult::failed(Status::TRUNCATED);
+        }
+    }
+
+    DecodeResult StreamDecoder::onHeaderComplete()
+    {
+        auto hr = parseHeader(pending_, sizeof(StreamHeader));
+        if (!hr.valid)
+        {
+            return fail(hr.status);
+        }
+        header_ = hr.header;
+        if (io_.acceptHeader != nullptr && !io_.acceptHeader(io_.ctx, header_))
+        {
+            return fail(Status::HEADER_REJECTED);
+        }
+        headerAccepted_ = true;
+        windowLimit_ = uint32_t(1) << header_.windowBits;
+        pendingLen_ = 0;
+        state_ = State::TOKEN;
+        return DecodeResult::success();
+    }
+
+    DecodeResult StreamDecoder::emitMatch(uint32_t distance, size_t length)
+    {
+        if (distance > windowLimit_ || distance > decoded_)
+        {
+            return fail(Status::BAD_DISTANCE);
+        }
+        if (static_cast<uint64_t>(decoded_) + length > header_.rawSize)
+        {
+            return fail(Status::OUTPUT_OVERFLOW);
+        }
+        // Byte-at-a-time on purpose: an overlapping match (distance <
+        // length) must read bytes it has just produced.
+        size_t src = (head_ + kWindowSize - distance) % kWindowSize;
+        for (size_t i = 0; i < length; ++i)
+        {
+            const uint8_t b = window_[src];
+            src = (src + 1) % kWindowSize;
+            if (!put(b))
+            {
+                return fail(Status::WRITE_FAILED);
+            }
+        }
+        return DecodeResult::success();
+    }
+
+    bool StreamDecoder::put(uint8_t b)
+    {
+        return putSpan(&b, 1);
+    }
+
+    bool StreamDecoder::putSpan(const uint8_t *data, size_t len)
+    {
+        while (len > 0)
+        {
+            size_t n = std::min(len, kWindowSize - head_);
+            std::memcpy(window_ + head_, data, n);
+            head_ += n;
+            decoded_ += static_cast<uint32_t>(n);
+            data += n;
+            len -= n;
+            if (head_ == kWindowSize)
+            {
+                // Flush before wrapping: the unflushed span must stay
+                // contiguous and must never be overwritten.
+                if (!flush())
+                {
+                    return false;
+                }
+                head_ = 0;
+                flushStart_ = 0;
+            }
+        }
+        return true;
+    }
+
+    bool StreamDecoder::flush()
+    {
+        if (head_ == flushStart_)
+        {
+            return true;
+        }
+        const size_t n = head_ - flushStart_;
+        if (io_.writeOut == nullptr || !io_.writeOut(io_.ctx, window_ + flushStart_, n))
+        {
+            return false;
+        }
+        flushedTotal_ += static_cast<uint32_t>(n);
+        flushStart_ = head_;
+        return true;
+    }
+
+    void StreamDecoder::markDoneIfComplete()
+    {
+        if (state_ == State::TOKEN && decoded_ == header_.rawSize)
+        {
+            state_ = State::DONE;
+        }
+    }
+} // namespace AstrOsOtaCompress
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Streaming binary-patch ("delta OTA") applier.
+//
+// A delta patch rebuilds a target firmware image from the image the
+// padawan is already running (the "base") plus a stream of ops. The
+// patch is generated server-side against the firmware version the
+// padawan reported in POLL_ACK; the padawan applies it while the bytes
+// arrive over OTA_DATA, reading the running partition for COPY ops and
+// handing every rebuilt byte to esp_ota_write.
+//
+// Patch layout (all multi-byte integers little-endian, matching the
+// OtaWirePayloads.hpp convention):
+//
+//   PatchHeader (112 B)
+//   op*                     until exactly targetSize bytes are emitted
+//
+//   op COPY   = 0x01 | u32 baseOffset | u32 length
+//               emit base[baseOffset .. baseOffset+length)
+//   op INSERT = 0x02 | u32 length | length literal bytes
+//               emit the literal bytes
+//   op FILL   = 0x03 | u32 length | u8 value
+//               emit `length` copies of `value` (padding runs)
+//
+// The applier is pure: base reads and output writes go through C-style
+// callbacks (fn pointer + void *ctx, same shape as esp_timer callbacks)
+// so the MIXED caller decides what "base" and "output" mean. Every op is
+// bounds-checked against the header before any byte is emitted; a patch
+// can never read past baseSize or write past targetSize.
+namespace AstrOsOtaDelta
+{
+    constexpr uint8_t kMagic[4] = {'A', 'D', 'L', 'T'};
+    constexpr uint8_t kFormatVersion = 1;
+
+    enum class OpCode : uint8_t
+    {
+        COPY = 0x01,
+        INSERT = 0x02,
+        FILL = 0x03
+    };
+
+    struct __attribute__((packed)) PatchHeader
+    {
+        uint8_t magic[4];         // kMagic
+        uint8_t formatVersion;    // kFormatVersion
+        uint8_t reserved[3];      // zero
+        uint32_t baseSize;        // bytes of the running image the patch was diffed against
+        uint32_t targetSize;      // bytes the patch rebuilds
+        uint8_t baseSha256[32];   // SHA-256 over base[0 .. baseSize)
+        uint8_t targetSha256[32]; // SHA-256 over the rebuilt image
+        char targetVersion[32];   // esp_app_desc version of the target; NUL-padded
+    };
+    static_assert(sizeof(PatchHeader) == 112, "PatchHeader must be 112 bytes on the wire");
+
+    // Base-image reader. Returns false on IO failure; the applier then
+    // fails with READ_FAILED. Never asked for bytes outside [0, baseSize).
+    using ReadBaseFn = bool (*)(void *ctx, uint32_t offset, uint8_t *out, size_t len);
+    // Output sink, called in target order. Returns false on IO failure.
+    using WriteOutFn = bool (*)(void *ctx, const uint8_t *data, size_t len);
+    // Called once, after the header parses and before any op runs. The
+    // caller verifies the base (running image SHA, partition sizes) and
+    // returns false to reject the patch with HEADER_REJECTED.
+    using AcceptHeaderFn = bool (*)(void *ctx, const PatchHeader &header);
+
+    struct PatchIo
+    {
+        void *ctx = nullptr;
+        ReadBaseFn readBase = nullptr;
+        WriteOutFn writeOut = nullptr;
+        AcceptHeaderFn acceptHeader = nullptr; // optional
+    };
+
+    enum class Status : uint8_t
+    {
+        OK = 0,
+        NOT_STARTED = 1,       // feed()/finish() before begin()
+        BAD_MAGIC = 2,         // header magic mismatch — not a delta patch
+        BAD_VERSION = 3,       // unsupported formatVersion
+        BAD_HEADER = 4,        // zero targetSize / non-zero reserved bytes
+        HEADER_REJECTED = 5,   // AcceptHeaderFn returned false
+        BAD_OPCODE = 6,        // unknown op byte
+        ZERO_LENGTH = 7,       // op with length 0
+        BASE_OUT_OF_RANGE = 8, // COPY reaches past baseSize
+        TARGET_OVERFLOW = 9,   // op would emit past targetSize
+        TRAILING_DATA = 10,    // bytes after the final op
+        TRUNCATED = 11,        // finish() before targetSize bytes were emitted
+        READ_FAILED = 12,      // ReadBaseFn returned false
+        WRITE_FAILED = 13      // WriteOutFn returned false
+    };
+
+    struct [[nodiscard]] ApplyResult
+    {
+        bool ok = false;
+        Status status = Status::NOT_STARTED;
+
+        static ApplyResult success()
+        {
+            return {true, Status::OK};
+        }
+        static ApplyResult failed(Status s)
+        {
+            return {false, s};
+        }
+    };
+
+    struct [[nodiscard]] HeaderResult
+    {
+        bool valid = false;
+        Status status = Status::BAD_MAGIC;
+        PatchHeader header{};
+    };
+
+    // Stateless header check for callers that only need to know whether a
+    // staged file is a delta patch (OtaForwarder peeks the first bytes of
+    // the staged firmware). Validates magic, formatVersion, reserved bytes
+    // and targetSize; does not look at any op.
+    HeaderResult parseHeader(const uint8_t *buf, size_t len);
+
+    // Incremental patch applier. feed() accepts the patch in arbitrary
+    // splits — op headers and INSERT payloads may straddle calls — so the
+    // caller can hand it each OTA_DATA chunk as it commits.
+    //
+    // Errors are sticky: after the first failure every feed()/finish()
+    // returns the same status until begin() or reset(). On any failure the
+    // output sink may already hold a partial image; the caller aborts the
+    // OTA handle.
+    //
+    // COPY and FILL emit their whole run inside one feed() call, bounded
+    // only by targetSize. Patch generators should split long runs so one
+    // wire chunk never triggers more flash work than the sender's ack
+    // timeout tolerates.
+    //
+    // Usage:
+    //   PatchApplier a;
+    //   a.begin(io);
+    //   for each chunk: if (!a.feed(p, n).ok) abort;
+    //   if (!a.finish().ok) abort;   // TRUNCATED if the patch ended early
+    class PatchApplier
+    {
+    public:
+        void begin(const PatchIo &io);
+        ApplyResult feed(const uint8_t *data, size_t len);
+        ApplyResult finish() const;
+        void reset();
+
+        // True once the header parsed and AcceptHeaderFn (if any) accepted it.
+        bool headerAccepted() const
+        {
+            return headerAccepted_;
+        }
+        // Valid only when headerAccepted().
+        const PatchHeader &header() const
+        {
+            return header_;
+        }
+        // Target bytes emitted so far.
+        uint32_t bytesWritten() const
+        {
+            return written_;
+        }
+
+    private:
+        enum class State : uint8_t
+        {
+            IDLE,
+            HEADER,
+            OP,
+            INSERT_DATA,
+            DONE,
+            FAILED
+        };
+
+        ApplyResult fail(Status s);
+        ApplyResult onHeaderComplete();
+        ApplyResult onOpComplete();
+        ApplyResult emitCopy(uint32_t baseOffset, uint32_t length);
+        ApplyResult emitFill(uint32_t length, uint8_t value);
+        void markDoneIfComplete();
+
+        // Scratch for COPY/FILL runs; lives in the object (not on the
+        // caller's stack) because the OTA writer task is stack-bound.
+        static constexpr size_t kScratchSize = 512;
+
+        PatchIo io_{};
+        State state_ = State::IDLE;
+        bool headerAccepted_ = false;
+        Status failStatus_ = Status::NOT_STARTED;
+        PatchHeader header_{};
+        // Accumulates the header, then each op header (<= 9 B), across feeds.
+        uint8_t pending_[sizeof(PatchHeader)] = {0};
+        size_t pendingLen_ = 0;
+        uint32_t insertRemaining_ = 0;
+        uint32_t written_ = 0;
+        uint8_t scratch_[kScratchSize] = {0};
+    };
+} // namespace AstrOsOtaDelta
@@ -0,0 +1,300 @@
+#include <AstrOsOtaDelta.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace AstrOsOtaDelta
+{
+    // Pin the wire-stable status + opcode values. A renumbering would
+    // silently change what the MIXED callers log and what existing patch
+    // files mean.
+    static_assert(static_cast<uint8_t>(OpCode::COPY) == 0x01, "OpCode::COPY is wire-stable");
+    static_assert(static_cast<uint8_t>(OpCode::INSERT) == 0x02, "OpCode::INSERT is wire-stable");
+    static_assert(static_cast<uint8_t>(OpCode::FILL) == 0x03, "OpCode::FILL is wire-stable");
+    static_assert(static_cast<uint8_t>(Status::WRITE_FAILED) == 13, "Status values are log-stable");
+
+    namespace
+    {
+        // Explicit little-endian assembly so the parser does not depend on
+        // host byte order or on unaligned loads from the pending buffer.
+        uint32_t readU32Le(const uint8_t *p)
+        {
+            return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+
+        // Full op-header length for a given opcode byte, or 0 if unknown.
+        size_t opHeaderLen(uint8_t opcode)
+        {
+            switch (static_cast<OpCode>(opcode))
+            {
+            case OpCode::COPY:
+                return 1 + 4 + 4;
+            case OpCode::INSERT:
+                return 1 + 4;
+            case OpCode::FILL:
+                return 1 + 4 + 1;
+            }
+            return 0;
+        }
+    } // namespace
+
+    HeaderResult parseHeader(const uint8_t *buf, size_t len)
+    {
+        HeaderResult r;
+        if (buf == nullptr || len < sizeof(PatchHeader))
+        {
+            r.status = Status::TRUNCATED;
+            return r;
+        }
+        std::memcpy(&r.header, buf, sizeof(PatchHeader));
+
+        if (std::memcmp(r.header.magic, kMagic, sizeof(kMagic)) != 0)
+        {
+            r.status = Status::BAD_MAGIC;
+            return r;
+        }
+        if (r.header.formatVersion != kFormatVersion)
+        {
+            r.status = Status::BAD_VERSION;
+            return r;
+        }
+        if (r.header.reserved[0] != 0 || r.header.reserved[1] != 0 || r.header.reserved[2] != 0 ||
+            r.header.targetSize == 0)
+        {
+            r.status = Status::BAD_HEADER;
+            return r;
+        }
+
+        r.valid = true;
+        r.status = Status::OK;
+        return r;
+    }
+
+    void PatchApplier::begin(const PatchIo &io)
+    {
+        reset();
+        io_ = io;
+        state_ = State::HEADER;
+    }
+
+    void PatchApplier::reset()
+    {
+        io_ = PatchIo{};
+        state_ = State::IDLE;
+        headerAccepted_ = false;
+        failStatus_ = Status::NOT_STARTED;
+        header_ = PatchHeader{};
+        pendingLen_ = 0;
+        insertRemaining_ = 0;
+        written_ = 0;
+    }
+
+    ApplyResult PatchApplier::fail(Status s)
+    {
+        state_ = State::FAILED;
+        failStatus_ = s;
+        return ApplyResult::failed(s);
+    }
+
+    ApplyResult PatchApplier::feed(const uint8_t *data, size_t len)
+    {
+        if (state_ == State::IDLE)
+        {
+            return ApplyResult::failed(Status::NOT_STARTED);
+        }
+        if (state_ == State::FAILED)
+        {
+            return ApplyResult::failed(failStatus_);
+        }
+
+        size_t pos = 0;
+        while (pos < len)
+        {
+            switch (state_)
+            {
+            case State::HEADER:
+            {
+                size_t take = std::min(sizeof(PatchHeader) - pendingLen_, len - pos);
+                std::memcpy(pending_ + pendingLen_, data + pos, take);
+                pendingLen_ += take;
+                pos += take;
+                if (pendingLen_ == sizeof(PatchHeader))
+                {
+                    auto r = onHeaderComplete();
+                    if (!r.ok)
+                    {
+                        return r;
+                    }
+                }
+                break;
+            }
+            case State::OP:
+            {
+                size_t need = opHeaderLen(pendingLen_ == 0 ? data[pos] : pending_[0]);
+                if (need == 0)
+                {
+                    return fail(Status::BAD_OPCODE);
+                }
+                size_t take = std::min(need - pendingLen_, len - pos);
+                std::memcpy(pending_ + pendingLen_, data + pos, take);
+                pendingLen_ += take;
+                pos += take;
+                if (pendingLen_ == need)
+                {
+                    auto r = onOpComplete();
+                    if (!r.ok)
+                    {
+                        return r;
+                    }
+                }
+                break;
+            }
+            case State::INSERT_DATA:
+            {
+                // Literal bytes go straight from the caller's buffer to the
+                // sink — no copy through scratch.
+                size_t take = std::min(static_cast<size_t>(insertRemaining_), len - pos);
+                if (io_.writeOut == nullptr || !io_.writeOut(io_.ctx, data + pos, take))
+                {
+                    return fail(Status::WRITE_FAILED);
+                }
+                written_ += static_cast<uint32_t>(take);
+                insertRemaining_ -= static_cast<uint32_t>(take);
+                pos += take;
+                if (insertRemaining_ == 0)
+                {
+                    state_ = State::OP;
+                    markDoneIfComplete();
+                }
+                break;
+            }
+            case State::DONE:
+                return fail(Status::TRAILING_DATA);
+            case State::IDLE:
+            case State::FAILED:
+                // Unreachable: both are handled before the loop and no
+                // branch inside the loop transitions into IDLE, and every
+                // transition into FAILED returns immediately.
+                return ApplyResult::failed(failStatus_);
+            }
+        }
+        return ApplyResult::success();
+    }
+
+    ApplyResult PatchApplier::finish() const
+    {
+        switch (state_)
+        {
+        case State::DONE:
+            return ApplyResult::success();
+        case State::IDLE:
+            return ApplyResult::failed(Status::NOT_STARTED);
+        case State::FAILED:
+            return ApplyResult::failed(failStatus_);
+        default:
+            return ApplyResult::failed(Status::TRUNCATED);
+        }
+    }
+
+    ApplyResult PatchApplier::onHeaderComplete()
+    {
+        auto hr = parseHeader(pending_, sizeof(PatchHeader));
+        if (!hr.valid)
+        {
+            return fail(hr.status);
+        }
+        header_ = hr.header;
+        if (io_.acceptHeader != nullptr && !io_.acceptHeader(io_.ctx, header_))
+        {
+            return fail(Status::HEADER_REJECTED);
+        }
+        headerAccepted_ = true;
+        pendingLen_ = 0;
+        state_ = State::OP;
+        return ApplyResult::success();
+    }
+
+    ApplyResult PatchApplier::onOpComplete()
+    {
+        const auto op = static_cast<OpCode>(pending_[0]);
+        const uint32_t first = readU32Le(pending_ + 1);
+        pendingLen_ = 0;
+
+        // COPY: first = baseOffset, length follows. INSERT/FILL: first = length.
+        const uint32_t length = (op == OpCode::COPY) ? readU32Le(pending_ + 5) : first;
+        if (length == 0)
+        {
+            return fail(Status::ZERO_LENGTH);
+        }
+        // 64-bit sums: a hostile u32 offset + length must not wrap past the
+        // bounds check.
+        if (static_cast<uint64_t>(written_) + length > header_.targetSize)
+        {
+            return fail(Status::TARGET_OVERFLOW);
+        }
+
+        switch (op)
+        {
+        case OpCode::COPY:
+            if (static_cast<uint64_t>(first) + length > header_.baseSize)
+            {
+                return fail(Status::BASE_OUT_OF_RANGE);
+            }
+            return emitCopy(first, length);
+        case OpCode::INSERT:
+            insertRemaining_ = length;
+            state_ = State::INSERT_DATA;
+            return ApplyResult::success();
+        case OpCode::FILL:
+            return emitFill(length, pending_[5]);
+        }
+        return fail(Status::BAD_OPCODE);
+    }
+
+    ApplyResult PatchApplier::emitCopy(uint32_t baseOffset, uint32_t length)
+    {
+        while (length > 0)
+        {
+            size_t n = std::min(static_cast<size_t>(length), kScratchSize);
+            if (io_.readBase == nullptr || !io_.readBase(io_.ctx, baseOffset, scratch_, n))
+            {
+                return fail(Status::READ_FAILED);
+            }
+            if (io_.writeOut == nullptr || !io_.writeOut(io_.ctx, scratch_, n))
+            {
+                return fail(Status::WRITE_FAILED);
+            }
+            baseOffset += static_cast<uint32_t>(n);
+            length -= static_cast<uint32_t>(n);
+            written_ += static_cast<uint32_t>(n);
+        }
+        markDoneIfComplete();
+        return ApplyResult::success();
+    }
+
+    ApplyResult PatchApplier::emitFill(uint32_t length, uint8_t value)
+    {
+        std::memset(scratch_, value, std::min(static_cast<size_t>(length), kScratchSize));
+        while (length > 0)
+        {
+            size_t n = std::min(static_cast<size_t>(length), kScratchSize);
+            if (io_.writeOut == nullptr || !io_.writeOut(io_.ctx, scratch_, n))
+            {
+                return fail(Status::WRITE_FAILED);
+            }
+            length -= static_cast<uint32_t>(n);
+            written_ += static_cast<uint32_t>(n);
+        }
+        markDoneIfComplete();
+        return ApplyResult::success();
+    }
+
+    void PatchApplier::markDoneIfComplete()
+    {
+        if (state_ == State::OP && written_ == header_.targetSize)
+        {
+            state_ = State::DONE;
+        }
+    }
+} // namespace AstrOsOtaDelta
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Discrete-event simulator for the ESP-NOW OTA data path.
+//
+// Wires the real AstrOsBulkTransport::BulkSender to the real BulkReceiver
+// through a pair of modelled channels (one per direction) on a virtual
+// microsecond clock, and drives them the way OtaForwarder and OtaWriter do:
+//
+//   sender    OTA_BEGIN, wait for OTA_BEGIN_ACK; then drain nextChunkToSend
+//             after every ACK / NAK / tick, emit tick() retransmits every
+//             tickPeriodMs, send OTA_END once an ACK covers the last chunk
+//             and wait for OTA_END_ACK. BEGIN and END are sent once and
+//             fail the transfer after handshakeTimeoutMs, like the
+//             forwarder's 5 s BEGIN_ACK / END_ACK timers.
+//   receiver  onChunk for every OTA_DATA copy that arrives; an OTA_DATA_ACK
+//             for each ACK decision, an OTA_DATA_NAK for each NAK. A
+//             duplicated OTA_BEGIN is answered OTA_BEGIN_NAK BUSY, as
+//             OtaWriter does for any BEGIN while a transfer is active.
+//
+// Every frame is sized from OtaWirePayloads, so byte counts and the link's
+// serialization time reflect what goes over the air. The received image is
+// reassembled from ACKed payloads and compared with the sent one at the end.
+//
+// Same seed, same config: same result, on any host — randomness comes from
+// a private splitmix64 stream, not <random>'s distributions.
+//
+// Pure and host-only in practice: uses the heap (event queue, image
+// buffers) and is not linked into any firmware env.
+namespace AstrOsOtaLinkSim
+{
+    // One direction of a link. Probabilities are per frame, 0..1.
+    struct ChannelModel
+    {
+        // Independent loss while the channel is in its good state.
+        double lossRate = 0.0;
+        // Gilbert-Elliott burst loss. Before each frame the channel moves
+        // good -> bad with burstEnterRate and bad -> good with burstExitRate;
+        // a frame sent in the bad state is lost with burstLossRate.
+        double burstEnterRate = 0.0;
+        double burstExitRate = 0.0;
+        double burstLossRate = 1.0;
+        // Fixed one-way delay after serialization, plus a uniform extra in
+        // [0, jitterUs]. Jitter larger than the frame spacing reorders.
+        uint32_t latencyUs = 0;
+        uint32_t jitterUs = 0;
+        // Frames held back a further reorderDelayUs, landing behind later ones.
+        double reorderRate = 0.0;
+        uint32_t reorderDelayUs = 0;
+        // Frames delivered twice; the copy gets its own jitter.
+        double duplicateRate = 0.0;
+        // Payload damage the link-layer CRC missed; the receiver's CRC-16
+        // rejects the chunk. Only OTA_DATA carries enough payload to matter.
+        double corruptRate = 0.0;
+        // Serialization rate; 0 = unlimited. Frames queue behind each other,
+        // lost ones included (they still took the air).
+        uint32_t bytesPerSec = 0;
+        // Link framing added to every frame's serialized size (ESP-NOW MAC
+        // header, vendor IE, AstrOs packet header).
+        uint16_t frameOverheadBytes = 0;
+        // Frames the sending stack can hold before serialization finishes
+        // (WiFi TX buffer pool); a send beyond it is refused, like
+        // esp_now_send's ESP_ERR_ESPNOW_NO_MEM. 0 = unlimited.
+        uint16_t txBufferFrames = 0;
+    };
+
+    struct Path
+    {
+        ChannelModel toReceiver; // OTA_BEGIN / OTA_DATA / OTA_END
+        ChannelModel toSender;   // the ACKs and NAKs
+    };
+
+    // Defaults are OtaForwarder's constants.
+    struct TransferConfig
+    {
+        uint32_t imageSize = 64 * 1024;
+        uint16_t chunkSize = 128;
+        uint8_t windowSize = 4;
+        uint32_t ackTimeoutMs = 1500;
+        uint8_t maxRetries = 3;
+        uint32_t tickPeriodMs = 50;
+        uint32_t handshakeTimeoutMs = 5000;
+        // streamDrain's backpressure gate (kEspnowTxInFlightCap): no new
+        // chunks while this many frames are still serializing. Retransmits
+        // and replies are not gated. 0 = no gate.
+        uint8_t txInFlightCap = 6;
+        // Stops a run that neither finishes nor fails (virtual time).
+        uint32_t timeLimitMs = 30 * 60 * 1000;
+    };
+
+    enum class Outcome : uint8_t
+    {
+        COMPLETED = 0,
+        INVALID_CONFIG = 1,    // BulkSender / BulkReceiver rejected the config
+        HANDSHAKE_TIMEOUT = 2, // BEGIN_ACK or END_ACK never arrived
+        BEGIN_REJECTED = 3,    // OTA_BEGIN_NAK (BUSY) reached the sender first
+        ABANDONED = 4,         // tick(): a chunk ran out of retries
+        END_REJECTED = 5,      // onEndAck returned something other than DONE_OK
+        TIME_LIMIT = 6,
+        CORRUPTED = 7 // DONE_OK, but the reassembled image differs — a protocol bug
+    };
+
+    const char *outcomeName(Outcome o);
+
+    struct TransferResult
+    {
+        Outcome outcome = Outcome::INVALID_CONFIG;
+        uint64_t elapsedUs = 0; // OTA_BEGIN sent -> OTA_END_ACK received, or to the failure
+        uint32_t imageBytes = 0;
+        uint32_t chunks = 0;
+
+        uint32_t dataFrames = 0;      // OTA_DATA sent, retransmits included
+        uint32_t retransmits = 0;     // OTA_DATA for a seq that had been sent before
+        uint32_t tickRetransmits = 0; // ... of which fired by an ACK timeout
+        uint32_t acks = 0;            // OTA_DATA_ACK sent by the receiver
+        uint32_t naks = 0;            // OTA_DATA_NAK sent by the receiver
+        uint64_t bytesToReceiver = 0; // all frames, framing included
+        uint64_t bytesToSender = 0;
+
+        uint32_t framesLost = 0;
+        uint32_t framesRefused = 0; // over txBufferFrames; never sent
+        uint32_t framesDuplicated = 0;
+        uint32_t framesCorrupted = 0;
+
+        bool completed() const
+        {
+            return outcome == Outcome::COMPLETED;
+        }
+        // Image bytes per second of the whole exchange; 0 unless completed.
+        double goodputBytesPerSec() const;
+        // Reverse-channel bytes per image byte.
+        double ackOverhead() const;
+    };
+
+    struct DeployResult
+    {
+        std::vector<TransferResult> transfers; // one per path, in order
+        uint64_t elapsedUs = 0;
+        uint32_t completed = 0;
+        // Completed image bytes over the whole deploy's time.
+        double goodputBytesPerSec() const;
+    };
+
+    // One sender -> receiver transfer over `path`.
+    TransferResult simulateTransfer(const TransferConfig &config, const Path &path, uint64_t seed);
+
+    // OtaForwarder's deploy: the same image to each receiver in turn, the
+    // next starting when the previous one ends either way. Each path gets
+    // its own random stream derived from `seed`.
+    DeployResult simulateDeploy(const TransferConfig &config, const Path *paths, size_t count, uint64_t seed);
+} // namespace AstrOsOtaLinkSim
@@ -0,0 +1,546 @@
+#include <AstrOsBulkTransport.hpp>
+#include <AstrOsOtaLinkSim.hpp>
+#include <OtaWirePayloads.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <queue>
+
+namespace AstrOsOtaLinkSim
+{
+    static_assert(static_cast<uint8_t>(Outcome::CORRUPTED) == 7, "Outcome values are log-stable");
+
+    namespace
+    {
+        using AstrOsBulkTransport::BulkReceiver;
+        using AstrOsBulkTransport::BulkSender;
+
+        // splitmix64: tiny, seedable, and identical on every host.
+        class Rng
+        {
+        public:
+            explicit Rng(uint64_t seed) : state_(seed) {}
+
+            uint64_t next()
+            {
+                uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                return z ^ (z >> 31);
+            }
+            // [0, 1)
+            double unit()
+            {
+                return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+            }
+            // Draws nothing for p <= 0, so a disabled effect doesn't shift
+            // the stream the enabled ones see.
+            bool chance(double p)
+            {
+                return p > 0.0 && unit() < p;
+            }
+            // [0, max]
+            uint32_t upTo(uint32_t max)
+            {
+                return max == 0 ? 0 : static_cast<uint32_t>(next() % (uint64_t(max) + 1));
+            }
+
+        private:
+            uint64_t state_;
+        };
+
+        enum class Kind : uint8_t
+        {
+            BEGIN,
+            BEGIN_ACK,
+            BEGIN_NAK,
+            DATA,
+            DATA_ACK,
+            DATA_NAK,
+            END,
+            END_ACK,
+            TICK,
+            HANDSHAKE_TIMEOUT
+        };
+
+        struct Event
+        {
+            uint64_t atUs;
+            uint64_t order; // FIFO among events due at the same instant
+            Kind kind;
+            uint32_t value; // seq / cumulative seq / next-expected seq / phase token
+            uint8_t reason; // DATA_NAK: NakReason; END_ACK: OtaEndStatus
+            bool corrupt;   // DATA only
+        };
+
+        struct Later
+        {
+            bool operator()(const Event &a, const Event &b) const
+            {
+                return a.atUs != b.atUs ? a.atUs > b.atUs : a.order > b.order;
+            }
+        };
+
+        struct Channel
+        {
+            const ChannelModel *model = nullptr;
+            uint64_t busyUntilUs = 0;
+            bool bad = false;
+            // Serialization end times of frames still in the TX path; the
+            // send-done callback fires at each.
+            std::deque<uint64_t> pendingDoneUs;
+
+            size_t inFlight(uint64_t nowUs)
+            {
+                while (!pendingDoneUs.empty() && pendingDoneUs.front() <= nowUs)
+                {
+                    pendingDoneUs.pop_front();
+                }
+                return pendingDoneUs.size();
+            }
+        };
+
+        enum class Phase : uint8_t
+        {
+            BEGIN,
+            STREAMING,
+            END,
+            DONE
+        };
+
+        class Transfer
+        {
+        public:
+            Transfer(const TransferConfig &config, const Path &path, uint64_t seed, uint8_t xferId)
+                : config_(config), rng_(seed), xferId_(xferId)
+            {
+                toReceiver_.model = &path.toReceiver;
+                toSender_.model = &path.toSender;
+            }
+
+            TransferResult run();
+
+        private:
+            void send(Channel &ch, Kind kind, size_t wireBytes, uint32_t value, uint8_t reason = 0);
+            void schedule(uint64_t atUs, Kind kind, uint32_t value, uint8_t reason = 0, bool corrupt = false);
+            void sendChunk(uint32_t seq);
+            void drain();
+            uint32_t chunkLen(uint32_t seq) const
+            {
+                return std::min<uint32_t>(config_.chunkSize, config_.imageSize - seq * config_.chunkSize);
+            }
+            uint64_t nowMs() const
+            {
+                return nowUs_ / 1000;
+            }
+            void finish(Outcome o)
+            {
+                result_.outcome = o;
+                result_.elapsedUs = nowUs_;
+                phase_ = Phase::DONE;
+            }
+
+            void onReceiverData(const Event &e);
+            void onSenderAck(const Event &e);
+            void onSenderNak(const Event &e);
+            void onTick();
+            void onEndAck(const Event &e);
+
+            const TransferConfig &config_;
+            Rng rng_;
+            const uint8_t xferId_;
+            Channel toReceiver_;
+            Channel toSender_;
+
+            std::priority_queue<Event, std::vector<Event>, Later> events_;
+            uint64_t nextOrder_ = 0;
+            uint64_t nowUs_ = 0;
+            Phase phase_ = Phase::BEGIN;
+
+            BulkSender sender_;
+            BulkReceiver receiver_;
+            bool receiverBegun_ = false;
+            std::vector<uint8_t> image_;
+            std::vector<uint8_t> received_;
+            std::vector<bool> sentOnce_;
+            std::vector<uint8_t> scratch_;
+            TransferResult result_;
+        };
+
+        void Transfer::schedule(uint64_t atUs, Kind kind, uint32_t value, uint8_t reason, bool corrupt)
+        {
+            events_.push(Event{atUs, nextOrder_++, kind, value, reason, corrupt});
+        }
+
+        void Transfer::send(Channel &ch, Kind kind, size_t wireBytes, uint32_t value, uint8_t reason)
+        {
+            const ChannelModel &m = *ch.model;
+            if (m.txBufferFrames != 0 && ch.inFlight(nowUs_) >= m.txBufferFrames)
+            {
+                result_.framesRefused++;
+                return;
+            }
+            const size_t frameBytes = wireBytes + m.frameOverheadBytes;
+            (&ch == &toReceiver_ ? result_.bytesToReceiver : result_.bytesToSender) += frameBytes;
+
+            // Serialize first: a lost frame still held the air.
+            const uint64_t departUs = std::max(nowUs_, ch.busyUntilUs);
+            const uint64_t txUs = m.bytesPerSec == 0 ? 0 : uint64_t(frameBytes) * 1000000ULL / m.bytesPerSec;
+            ch.busyUntilUs = departUs + txUs;
+            ch.pendingDoneUs.push_back(ch.busyUntilUs);
+
+            if (ch.bad ? rng_.chance(m.burstExitRate) : rng_.chance(m.burstEnterRate))
+            {
+                ch.bad = !ch.bad;
+            }
+            if (rng_.chance(ch.bad ? m.burstLossRate : m.lossRate))
+            {
+                result_.framesLost++;
+                return;
+            }
+
+            const uint64_t sentUs = departUs + txUs + m.latencyUs;
+            bool corrupt = false;
+            if (kind == Kind::DATA && rng_.chance(m.corruptRate))
+            {
+                corrupt = true;
+                result_.framesCorrupted++;
+            }
+            uint64_t arriveUs = sentUs + rng_.upTo(m.jitterUs);
+            if (rng_.chance(m.reorderRate))
+            {
+                arriveUs += m.reorderDelayUs;
+            }
+            schedule(arriveUs, kind, value, reason, corrupt);
+            if (rng_.chance(m.duplicateRate))
+            {
+                result_.framesDuplicated++;
+                schedule(sentUs + rng_.upTo(m.jitterUs), kind, value, reason, corrupt);
+            }
+        }
+
+        void Transfer::sendChunk(uint32_t seq)
+        {
+            result_.dataFrames++;
+            if (sentOnce_[seq])
+            {
+                result_.retransmits++;
+            }
+            sentOnce_[seq] = true;
+            send(toReceiver_, Kind::DATA, sizeof(OtaDataHeader) + chunkLen(seq), seq);
+        }
+
+        // OtaForwarder::streamDrain: claim window slots until the sender says
+        // stop or the radio is backed up (the next tick comes back).
+        void Transfer::drain()
+        {
+            for (;;)
+            {
+                if (config_.txInFlightCap != 0 && toReceiver_.inFlight(nowUs_) >= config_.txInFlightCap)
+                {
+                    return;
+                }
+                auto sr = sender_.nextChunkToSend(nowMs());
+                if (sr.decision != AstrOsBulkTransport::SendResult::Decision::SEND)
+                {
+                    return;
+                }
+                sendChunk(sr.seq);
+            }
+        }
+
+        void Transfer::onReceiverData(const Event &e)
+        {
+            const uint32_t seq = e.value;
+            const uint32_t len = chunkLen(seq);
+            const uint8_t *src = image_.data() + size_t(seq) * config_.chunkSize;
+            // The sender's CRC covers the bytes it sent; damage lands after.
+            const uint16_t crc = AstrOsBulkTransport::crc16_ccitt_false(src, len);
+            std::memcpy(scratch_.data(), src, len);
+            if (e.corrupt)
+            {
+                scratch_[rng_.upTo(len - 1)] ^= static_cast<uint8_t>(1u << rng_.upTo(7));
+            }
+
+            auto cr = receiver_.onChunk(xferId_, seq, static_cast<uint16_t>(len), crc, scratch_.data());
+            if (cr.decision == AstrOsBulkTransport::Decision::ACK)
+            {
+                std::memcpy(received_.data() + size_t(seq) * config_.chunkSize, cr.payload, cr.payloadLen);
+                result_.acks++;
+                send(toSender_, Kind::DATA_ACK, sizeof(OtaDataAckPayload), cr.highestContiguousSeq);
+            }
+            else
+            {
+                result_.naks++;
+                send(toSender_, Kind::DATA_NAK, sizeof(OtaDataNakPayload), cr.nextExpectedSeq,
+                     static_cast<uint8_t>(cr.reason));
+            }
+        }
+
+        // OtaForwarder::handleDataAck.
+        void Transfer::onSenderAck(const Event &e)
+        {
+            if (phase_ != Phase::STREAMING)
+            {
+                return;
+            }
+            auto r = sender_.onDataAck(xferId_, e.value);
+            if (r.decision != AstrOsBulkTransport::AckResult::Decision::OK)
+            {
+                return;
+            }
+            if (e.value + 1 >= result_.chunks)
+            {
+                phase_ = Phase::END;
+                send(toReceiver_, Kind::END, sizeof(OtaEndPayload), 0);
+                schedule(nowUs_ + uint64_t(config_.handshakeTimeoutMs) * 1000, Kind::HANDSHAKE_TIMEOUT,
+                         static_cast<uint32_t>(Phase::END));
+                return;
+            }
+            drain();
+        }
+
+        // OtaForwarder::handleDataNak.
+        void Transfer::onSenderNak(const Event &e)
+        {
+            if (phase_ != Phase::STREAMING)
+            {
+                return;
+            }
+            auto r = sender_.onDataNak(xferId_, e.value, static_cast<AstrOsBulkTransport::NakReason>(e.reason));
+            if (r.decision != AstrOsBulkTransport::NakResult::Decision::OK)
+            {
+                return;
+            }
+            drain();
+        }
+
+        // OtaForwarder::handleTick: retransmits first, then new chunks.
+        void Transfer::onTick()
+        {
+            if (phase_ != Phase::STREAMING)
+            {
+                return;
+            }
+            auto tr = sender_.tick(nowMs());
+            if (tr.abandon)
+            {
+                finish(Outcome::ABANDONED);
+                return;
+            }
+            for (uint8_t i = 0; i < tr.count; i++)
+            {
+                result_.tickRetransmits++;
+                sendChunk(tr.retransmitSeqs[i]);
+            }
+            drain();
+            schedule(nowUs_ + uint64_t(config_.tickPeriodMs) * 1000, Kind::TICK, 0);
+        }
+
+        void Transfer::onEndAck(const Event &e)
+        {
+            if (phase_ != Phase::END)
+            {
+                return;
+            }
+            auto r = sender_.onEndAck(xferId_, static_cast<OtaEndStatus>(e.reason));
+            if (r.decision != AstrOsBulkTransport::EndAckResult::Decision::DONE_OK)
+            {
+                finish(Outcome::END_REJECTED);
+                return;
+            }
+            finish(received_ == image_ ? Outcome::COMPLETED : Outcome::CORRUPTED);
+        }
+
+        TransferResult Transfer::run()
+        {
+            result_.imageBytes = config_.imageSize;
+            if (config_.chunkSize == 0 || config_.imageSize == 0 || config_.tickPeriodMs == 0)
+            {
+                return result_;
+            }
+            const uint32_t chunks = (config_.imageSize + config_.chunkSize - 1) / config_.chunkSize;
+            result_.chunks = chunks;
+            if (!sender_
+                     .begin(xferId_, chunks, config_.chunkSize, config_.windowSize, config_.ackTimeoutMs,
+                            config_.maxRetries)
+                     .valid)
+            {
+                return result_;
+            }
+
+            image_.resize(config_.imageSize);
+            for (auto &b : image_)
+            {
+                b = static_cast<uint8_t>(rng_.next());
+            }
+            received_.assign(config_.imageSize, 0);
+            sentOnce_.assign(chunks, false);
+            scratch_.resize(config_.chunkSize);
+
+            send(toReceiver_, Kind::BEGIN, sizeof(OtaBeginPayload), 0);
+            schedule(uint64_t(config_.handshakeTimeoutMs) * 1000, Kind::HANDSHAKE_TIMEOUT,
+                     static_cast<uint32_t>(Phase::BEGIN));
+
+            const uint64_t limitUs = uint64_t(config_.timeLimitMs) * 1000;
+            while (phase_ != Phase::DONE)
+            {
+                if (events_.empty())
+                {
+                    // Nothing in flight and no timer armed; can't happen
+                    // while a handshake timeout or tick is pending.
+                    finish(Outcome::TIME_LIMIT);
+                    break;
+                }
+                const Event e = events_.top();
+                events_.pop();
+                if (e.atUs > limitUs)
+                {
+                    nowUs_ = limitUs;
+                    finish(Outcome::TIME_LIMIT);
+                    break;
+                }
+                nowUs_ = e.atUs;
+
+                switch (e.kind)
+                {
+                case Kind::BEGIN:
+                    if (receiverBegun_)
+                    {
+                        send(toSender_, Kind::BEGIN_NAK, sizeof(OtaBeginNakPayload), 0);
+                        break;
+                    }
+                    if (!receiver_.begin(xferId_, config_.imageSize, chunks, config_.chunkSize, config_.windowSize)
+                             .valid)
+                    {
+                        finish(Outcome::INVALID_CONFIG);
+                        break;
+                    }
+                    receiverBegun_ = true;
+                    send(toSender_, Kind::BEGIN_ACK, sizeof(OtaBeginAckPayload), 0);
+                    break;
+                case Kind::BEGIN_ACK:
+                    if (phase_ == Phase::BEGIN &&
+                        sender_.onBeginAck(xferId_).decision == AstrOsBulkTransport::BeginAckResult::Decision::OK)
+                    {
+                        phase_ = Phase::STREAMING;
+                        schedule(nowUs_ + uint64_t(config_.tickPeriodMs) * 1000, Kind::TICK, 0);
+                        drain();
+                    }
+                    break;
+                case Kind::BEGIN_NAK:
+                    // OtaForwarder drops a BEGIN_NAK once it is streaming.
+                    if (phase_ == Phase::BEGIN)
+                    {
+                        finish(Outcome::BEGIN_REJECTED);
+                    }
+                    break;
+                case Kind::DATA:
+                    onReceiverData(e);
+                    break;
+                case Kind::DATA_ACK:
+                    onSenderAck(e);
+                    break;
+                case Kind::DATA_NAK:
+                    onSenderNak(e);
+                    break;
+                case Kind::END:
+                {
+                    auto er = receiver_.onEnd(xferId_, chunks);
+                    const OtaEndStatus status = er.status == AstrOsBulkTransport::EndResult::Status::OK
+                                                    ? OtaEndStatus::OK
+                                                    : OtaEndStatus::WRITE_ERROR;
+                    send(toSender_, Kind::END_ACK, sizeof(OtaEndAckPayload), 0, static_cast<uint8_t>(status));
+                    break;
+                }
+                case Kind::END_ACK:
+                    onEndAck(e);
+                    break;
+                case Kind::TICK:
+                    onTick();
+                    break;
+                case Kind::HANDSHAKE_TIMEOUT:
+                    if (static_cast<uint32_t>(phase_) == e.value)
+                    {
+                        finish(Outcome::HANDSHAKE_TIMEOUT);
+                    }
+                    break;
+                }
+            }
+            return result_;
+        }
+    } // namespace
+
+    const char *outcomeName(Outcome o)
+    {
+        switch (o)
+        {
+        case Outcome::COMPLETED:
+            return "COMPLETED";
+        case Outcome::INVALID_CONFIG:
+            return "INVALID_CONFIG";
+        case Outcome::HANDSHAKE_TIMEOUT:
+            return "HANDSHAKE_TIMEOUT";
+        case Outcome::BEGIN_REJECTED:
+            return "BEGIN_REJECTED";
+        case Outcome::ABANDONED:
+            return "ABANDONED";
+        case Outcome::END_REJECTED:
+            return "END_REJECTED";
+        case Outcome::TIME_LIMIT:
+            return "TIME_LIMIT";
+        case Outcome::CORRUPTED:
+            return "CORRUPTED";
+        }
+        return "UNKNOWN";
+    }
+
+    double TransferResult::goodputBytesPerSec() const
+    {
+        if (!completed() || elapsedUs == 0)
+        {
+            return 0.0;
+        }
+        return static_cast<double>(imageBytes) * 1e6 / static_cast<double>(elapsedUs);
+    }
+
+    double TransferResult::ackOverhead() const
+    {
+        return imageBytes == 0 ? 0.0 : static_cast<double>(bytesToSender) / imageBytes;
+    }
+
+    double DeployResult::goodputBytesPerSec() const
+    {
+        uint64_t bytes = 0;
+        for (const auto &t : transfers)
+        {
+            if (t.completed())
+            {
+                bytes += t.imageBytes;
+            }
+        }
+        return elapsedUs == 0 ? 0.0 : static_cast<double>(bytes) * 1e6 / static_cast<double>(elapsedUs);
+    }
+
+    TransferResult simulateTransfer(const TransferConfig &config, const Path &path, uint64_t seed)
+    {
+        return Transfer(config, path, seed, /*xferId=*/1).run();
+    }
+
+    DeployResult simulateDeploy(const TransferConfig &config, const Path *paths, size_t count, uint64_t seed)
+    {
+        DeployResult out;
+        out.transfers.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            // OtaForwarder hands each padawan a fresh xferId.
+            const uint8_t xferId = static_cast<uint8_t>(i + 1);
+            TransferResult r = Transfer(config, paths[i], seed ^ (0x9E3779B97F4A7C15ULL * (i + 1)), xferId).run();
+            out.elapsedUs += r.elapsedUs;
+            out.completed += r.completed() ? 1 : 0;
+            out.transfers.push_back(r);
+        }
+        return out;
+    }
+} // namespace AstrOsOtaLinkSim
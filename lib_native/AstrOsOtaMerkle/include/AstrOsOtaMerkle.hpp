@@ -0,0 +1,299 @@
+#pragma once
+
+#include <AstrOsSha256.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Merkle-tree verification for OTA transfers.
+//
+// The image (or encoded file) is split into fixed-size blocks; each block is
+// a leaf and OTA_BEGIN carries the root. The OTA_DATA stream then interleaves
+// the blocks with just enough sibling hashes for the receiver to check every
+// block against the root the moment its last byte arrives. A corrupted block
+// that slipped past the per-chunk CRC-16 costs one block's retransmit instead
+// of the whole transfer, and only authenticated bytes ever reach flash.
+//
+// Tree (all hashes SHA-256, domain-separated so a leaf can't pose as a node):
+//
+//   leaf  = H(0x00 || block)
+//   node  = H(0x01 || left || right)
+//   level 0 holds the blockCount leaves; level k+1 pairs level k left to
+//   right. An odd node out at the end of a level is promoted unchanged.
+//
+// Framed stream: one record per block, in block order,
+//
+//   record b = sibling hashes (32 B each, bottom-up) || block b
+//
+// Record b carries the right sibling of b's ancestor at level k exactly when
+// that ancestor is a left child, the sibling exists, and b is the first
+// block under the ancestor — i.e. the first time the sibling is needed.
+// Every later block under the same ancestor reuses the cached copy, and
+// left siblings are hashes the receiver already computed itself. That is
+// blockCount - 1 hashes in total: under 1% on top of 4 KB blocks.
+//
+// Pure: no ESP-IDF includes, no heap, no logging. Data comes in and goes
+// out through C-style callbacks (fn pointer + void *ctx), same shape as
+// AstrOsOtaCompress / AstrOsOtaDelta.
+namespace AstrOsOtaMerkle
+{
+    constexpr size_t kHashSize = 32;
+    constexpr uint8_t kLeafPrefix = 0x00;
+    constexpr uint8_t kNodePrefix = 0x01;
+    // 4 KB blocks line up with flash sectors, which lets the padawan check
+    // each sector it programs against its leaf (OtaFlashPipeline).
+    constexpr uint8_t kDefaultBlockLog2 = 12;
+    constexpr uint8_t kMinBlockLog2 = 10;
+    // Sets BlockVerifier's RAM cost (one block buffer).
+    constexpr uint8_t kMaxBlockLog2 = 12;
+    // Tree height cap: 65536 blocks, 256 MB at 4 KB — past any OTA slot.
+    // Bounds every per-level array below.
+    constexpr uint8_t kMaxLevels = 16;
+
+    // Starts a leaf hash: `ctx` then takes the block bytes via
+    // AstrOsSha256_update and AstrOsSha256_final yields the leaf. For
+    // callers that can't hold a whole block in one buffer.
+    void leafBegin(AstrOsSha256Ctx &ctx);
+    void hashLeaf(const uint8_t *data, size_t len, uint8_t out[kHashSize]);
+    // `out` may alias either input.
+    void hashNode(const uint8_t left[kHashSize], const uint8_t right[kHashSize], uint8_t out[kHashSize]);
+
+    // Shape of the tree and the framed stream for one data size. Cheap to
+    // copy; every query is O(height) or better except recordAt.
+    class Geometry
+    {
+    public:
+        // False (and valid() stays false) for a zero dataSize, a blockLog2
+        // outside [kMinBlockLog2, kMaxBlockLog2], or more than
+        // 1 << kMaxLevels blocks.
+        bool init(uint32_t dataSize, uint8_t blockLog2);
+
+        bool valid() const
+        {
+            return blockCount_ != 0;
+        }
+        uint32_t dataSize() const
+        {
+            return dataSize_;
+        }
+        uint8_t blockLog2() const
+        {
+            return blockLog2_;
+        }
+        uint32_t blockSize() const
+        {
+            return uint32_t(1) << blockLog2_;
+        }
+        uint32_t blockCount() const
+        {
+            return blockCount_;
+        }
+        // Levels above the leaves; 0 for a single block (root == leaf).
+        uint8_t height() const
+        {
+            return height_;
+        }
+        // Nodes at `level`, 0 = leaves. Valid for level <= height().
+        uint32_t width(uint8_t level) const
+        {
+            return widths_[level];
+        }
+        // Bytes in block `block`; only the last one may be short.
+        uint32_t blockLen(uint32_t block) const;
+
+        // True if record `block` carries the right sibling at `level`.
+        bool carries(uint32_t block, uint8_t level) const;
+        // Sibling hashes in record `block`.
+        uint8_t siblingCount(uint32_t block) const;
+        // Level of the i-th sibling hash in record `block` (bottom-up); the
+        // hash is node ((block >> level) + 1) at that level.
+        uint8_t siblingLevel(uint32_t block, uint8_t i) const;
+
+        // Stream offset of record `block`; blockCount() gives streamSize().
+        uint32_t recordStart(uint32_t block) const;
+        uint32_t streamSize() const
+        {
+            return streamSize_;
+        }
+        // Record containing stream offset `offset` (< streamSize()).
+        uint32_t recordAt(uint32_t offset) const;
+
+    private:
+        uint32_t dataSize_ = 0;
+        uint32_t blockCount_ = 0;
+        uint32_t streamSize_ = 0;
+        uint8_t blockLog2_ = 0;
+        uint8_t height_ = 0;
+        uint32_t widths_[kMaxLevels + 1] = {0};
+    };
+
+    // ─── Sender ──────────────────────────────────────────────────────────
+
+    // Reads `len` bytes of the unframed data at `offset`. Returns false on
+    // IO failure.
+    using ReadDataFn = bool (*)(void *ctx, uint32_t offset, uint8_t *out, size_t len);
+
+    // Produces the framed stream from the leaf digests plus the data itself.
+    // Only the leaves are held (blockCount * 32 B, caller-owned); the
+    // carried siblings are rebuilt on demand and cached one per level, so a
+    // sequential send — retransmits included — hashes each node about once.
+    //
+    // Usage:
+    //   enc.begin(geo, leaves, readFn, ctx);
+    //   enc.root(root);                           // for OTA_BEGIN
+    //   enc.read(seq * chunkSize, buf, len);      // per OTA_DATA chunk
+    class StreamEncoder
+    {
+    public:
+        // `leaves` holds geo.blockCount() digests back to back and must
+        // outlive the encoder.
+        void begin(const Geometry &geo, const uint8_t *leaves, ReadDataFn readData, void *ctx);
+        void reset();
+
+        void root(uint8_t out[kHashSize]);
+        // Copies stream bytes [offset, offset + len). False past the end of
+        // the stream, before begin(), or when ReadDataFn fails.
+        bool read(uint32_t offset, uint8_t *out, size_t len);
+
+    private:
+        const uint8_t *node(uint8_t level, uint32_t index);
+        void computeNode(uint8_t level, uint32_t index, uint8_t out[kHashSize]);
+
+        struct CachedNode
+        {
+            uint32_t index = 0;
+            bool valid = false;
+            uint8_t hash[kHashSize] = {0};
+        };
+
+        Geometry geo_{};
+        const uint8_t *leaves_ = nullptr;
+        ReadDataFn readData_ = nullptr;
+        void *ctx_ = nullptr;
+        CachedNode cache_[kMaxLevels + 1];
+        // Fold stack for computeNode; in the object so the caller's task
+        // stack isn't charged for it.
+        uint8_t scratch_[kMaxLevels + 1][kHashSize] = {{0}};
+    };
+
+    // ─── Receiver ────────────────────────────────────────────────────────
+
+    // Everything BlockVerifier needs to continue at a record boundary. Plain
+    // bytes, so it can be persisted as-is (OtaWriter's resume checkpoint
+    // embeds it; changing the layout means bumping that checkpoint version).
+    //
+    // path[k] is the sibling the next block's level-k ancestor pairs with:
+    // the left sibling (computed from verified blocks) when the ancestor is a
+    // right child, the right sibling (carried earlier, verified with the
+    // block that carried it) when it's a left child, unused when promoted.
+    struct VerifierState
+    {
+        uint32_t nextBlock = 0;
+        uint8_t path[kMaxLevels][kHashSize] = {{0}};
+    };
+
+    // Called once per verified block, in order. `leaf` is the block's leaf
+    // hash. Runs with state() already advanced past `block`, so a caller can
+    // snapshot a resume point from inside it. Returns false on IO failure;
+    // the verifier then fails with WRITE_FAILED.
+    using BlockOutFn = bool (*)(void *ctx, uint32_t block, const uint8_t *data, size_t len,
+                                const uint8_t leaf[kHashSize]);
+
+    enum class Status : uint8_t
+    {
+        OK = 0,
+        NOT_STARTED = 1,    // feed()/finish() before begin()/resume()
+        BLOCK_MISMATCH = 2, // a block didn't hash to the root — resend its record
+        GAP = 3,            // feed() starts past cursor(): bytes were skipped
+        OVERFLOW = 4,       // bytes past the end of the stream
+        WRITE_FAILED = 5,   // BlockOutFn returned false
+        TRUNCATED = 6       // finish() before every block verified
+    };
+
+    struct [[nodiscard]] VerifyResult
+    {
+        bool ok = false;
+        Status status = Status::NOT_STARTED;
+        // BLOCK_MISMATCH only: the rejected block and the stream offset to
+        // resend from (its record start).
+        uint32_t block = 0;
+        uint32_t resendFrom = 0;
+
+        static VerifyResult success()
+        {
+            return {true, Status::OK, 0, 0};
+        }
+        static VerifyResult failed(Status s)
+        {
+            return {false, s, 0, 0};
+        }
+        static VerifyResult mismatch(uint32_t block, uint32_t resendFrom)
+        {
+            return {false, Status::BLOCK_MISMATCH, block, resendFrom};
+        }
+    };
+
+    // Incremental receiver. feed() takes stream bytes tagged with their
+    // stream offset, in any split. Bytes before cursor() are skipped, so a
+    // resend that restarts at a chunk boundary below the record is fine.
+    //
+    // BLOCK_MISMATCH is not sticky: the verifier drops the record, rewinds
+    // cursor() to resendFrom and waits for it again. Every other failure is
+    // sticky until begin()/resume()/reset().
+    //
+    // Usage:
+    //   v.begin(geo, root, out, ctx);
+    //   per chunk: r = v.feed(seq * chunkSize, p, n);
+    //              r.status == BLOCK_MISMATCH -> ask for r.resendFrom
+    //   at end:    v.finish().ok
+    class BlockVerifier
+    {
+    public:
+        // False if `geo` is invalid.
+        bool begin(const Geometry &geo, const uint8_t root[kHashSize], BlockOutFn out, void *ctx);
+        // Continues from a state() captured at a record boundary. False if
+        // `geo` is invalid or state.nextBlock is past the last block.
+        bool resume(const Geometry &geo, const uint8_t root[kHashSize], const VerifierState &state, BlockOutFn out,
+                    void *ctx);
+        VerifyResult feed(uint32_t offset, const uint8_t *data, size_t len);
+        VerifyResult finish() const;
+        void reset();
+
+        // Next stream offset the verifier needs.
+        uint32_t cursor() const
+        {
+            return cursor_;
+        }
+        const VerifierState &state() const
+        {
+            return state_;
+        }
+        const Geometry &geometry() const
+        {
+            return geo_;
+        }
+
+    private:
+        VerifyResult fail(Status s);
+        VerifyResult completeRecord();
+        void startRecord();
+
+        Geometry geo_{};
+        uint8_t root_[kHashSize] = {0};
+        BlockOutFn out_ = nullptr;
+        void *ctx_ = nullptr;
+        bool started_ = false;
+        Status failStatus_ = Status::NOT_STARTED;
+        bool failed_ = false;
+        VerifierState state_{};
+        uint32_t cursor_ = 0;
+        uint32_t recordStart_ = 0;
+        // Current record, as it arrives.
+        size_t siblingBytesNeeded_ = 0;
+        size_t siblingBytes_ = 0;
+        uint8_t siblings_[kMaxLevels][kHashSize] = {{0}};
+        size_t blockFill_ = 0;
+        // In the object, not on the caller's stack: otaWriterTask is stack-bound.
+        uint8_t block_[size_t(1) << kMaxBlockLog2] = {0};
+    };
+} // namespace AstrOsOtaMerkle
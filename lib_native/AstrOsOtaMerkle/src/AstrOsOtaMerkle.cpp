@@ -0,0 +1,486 @@
+#include <AstrOsOtaMerkle.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace AstrOsOtaMerkle
+{
+    // Pin the tree encoding. A change here silently changes every root a
+    // master announces to padawans already in the field.
+    static_assert(kLeafPrefix == 0x00 && kNodePrefix == 0x01, "hash domain prefixes are wire-stable");
+    static_assert(kHashSize == ASTROS_SHA256_DIGEST_LEN, "tree hashes are SHA-256");
+    static_assert(static_cast<uint8_t>(Status::TRUNCATED) == 6, "Status values are log-stable");
+
+    namespace
+    {
+        // Nodes at `level` whose index is even, has a right neighbour, and
+        // whose first block lies below `block` — i.e. siblings carried by
+        // records [0, block). Those indices are the even j with
+        // j < ceil(block / 2^level) and j + 1 < width.
+        uint32_t carriedBefore(uint32_t block, uint8_t level, uint32_t width)
+        {
+            const uint32_t firstBlocks = (block + (uint32_t(1) << level) - 1) >> level;
+            const uint32_t m = std::min(firstBlocks, width - 1);
+            return (m + 1) / 2;
+        }
+    } // namespace
+
+    void leafBegin(AstrOsSha256Ctx &ctx)
+    {
+        AstrOsSha256_init(&ctx);
+        AstrOsSha256_update(&ctx, &kLeafPrefix, 1);
+    }
+
+    void hashLeaf(const uint8_t *data, size_t len, uint8_t out[kHashSize])
+    {
+        AstrOsSha256Ctx ctx;
+        leafBegin(ctx);
+        AstrOsSha256_update(&ctx, data, len);
+        AstrOsSha256_final(&ctx, out);
+    }
+
+    void hashNode(const uint8_t left[kHashSize], const uint8_t right[kHashSize], uint8_t out[kHashSize])
+    {
+        // Both inputs are absorbed before `out` is written, so aliasing is safe.
+        AstrOsSha256Ctx ctx;
+        AstrOsSha256_init(&ctx);
+        AstrOsSha256_update(&ctx, &kNodePrefix, 1);
+        AstrOsSha256_update(&ctx, left, kHashSize);
+        AstrOsSha256_update(&ctx, right, kHashSize);
+        AstrOsSha256_final(&ctx, out);
+    }
+
+    // ─── Geometry ────────────────────────────────────────────────────────
+
+    bool Geometry::init(uint32_t dataSize, uint8_t blockLog2)
+    {
+        *this = Geometry{};
+        if (dataSize == 0 || blockLog2 < kMinBlockLog2 || blockLog2 > kMaxBlockLog2)
+        {
+            return false;
+        }
+        const uint32_t blocks = static_cast<uint32_t>((uint64_t(dataSize) + (uint64_t(1) << blockLog2) - 1) >> blockLog2);
+        if (blocks > (uint32_t(1) << kMaxLevels))
+        {
+            return false;
+        }
+
+        uint8_t height = 0;
+        widths_[0] = blocks;
+        while (widths_[height] > 1)
+        {
+            widths_[height + 1] = (widths_[height] + 1) / 2;
+            height++;
+        }
+        dataSize_ = dataSize;
+        blockLog2_ = blockLog2;
+        height_ = height;
+        blockCount_ = blocks;
+        // Every node but the root is some record's sibling exactly when it is
+        // a right child, so the stream carries blockCount - 1 hashes.
+        streamSize_ = dataSize + (blocks - 1) * static_cast<uint32_t>(kHashSize);
+        return true;
+    }
+
+    uint32_t Geometry::blockLen(uint32_t block) const
+    {
+        const uint32_t start = block << blockLog2_;
+        return std::min(blockSize(), dataSize_ - start);
+    }
+
+    bool Geometry::carries(uint32_t block, uint8_t level) const
+    {
+        if (level >= height_ || (block & ((uint32_t(1) << level) - 1)) != 0)
+        {
+            return false;
+        }
+        const uint32_t j = block >> level;
+        return (j & 1) == 0 && j + 1 < widths_[level];
+    }
+
+    uint8_t Geometry::siblingCount(uint32_t block) const
+    {
+        uint8_t n = 0;
+        for (uint8_t k = 0; k < height_; k++)
+        {
+            n += carries(block, k) ? 1 : 0;
+        }
+        return n;
+    }
+
+    uint8_t Geometry::siblingLevel(uint32_t block, uint8_t i) const
+    {
+        for (uint8_t k = 0; k < height_; k++)
+        {
+            if (carries(block, k) && i-- == 0)
+            {
+                return k;
+            }
+        }
+        return height_; // out of range; callers stay below siblingCount()
+    }
+
+    uint32_t Geometry::recordStart(uint32_t block) const
+    {
+        // Closed form per level instead of summing siblingCount over every
+        // earlier record: the sender maps every chunk through here.
+        uint32_t hashes = 0;
+        for (uint8_t k = 0; k < height_; k++)
+        {
+            hashes += carriedBefore(block, k, widths_[k]);
+        }
+        const uint32_t dataBefore = block >= blockCount_ ? dataSize_ : block << blockLog2_;
+        return dataBefore + hashes * static_cast<uint32_t>(kHashSize);
+    }
+
+    uint32_t Geometry::recordAt(uint32_t offset) const
+    {
+        // Largest block whose record starts at or before offset.
+        uint32_t lo = 0;
+        uint32_t hi = blockCount_;
+        while (hi - lo > 1)
+        {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (recordStart(mid) <= offset)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    // ─── StreamEncoder ───────────────────────────────────────────────────
+
+    void StreamEncoder::begin(const Geometry &geo, const uint8_t *leaves, ReadDataFn readData, void *ctx)
+    {
+        reset();
+        geo_ = geo;
+        leaves_ = leaves;
+        readData_ = readData;
+        ctx_ = ctx;
+    }
+
+    void StreamEncoder::reset()
+    {
+        geo_ = Geometry{};
+        leaves_ = nullptr;
+        readData_ = nullptr;
+        ctx_ = nullptr;
+        for (CachedNode &c : cache_)
+        {
+            c.valid = false;
+        }
+    }
+
+    void StreamEncoder::root(uint8_t out[kHashSize])
+    {
+        if (leaves_ == nullptr || !geo_.valid())
+        {
+            std::memset(out, 0, kHashSize);
+            return;
+        }
+        computeNode(geo_.height(), 0, out);
+    }
+
+    bool StreamEncoder::read(uint32_t offset, uint8_t *out, size_t len)
+    {
+        if (leaves_ == nullptr || readData_ == nullptr || offset > geo_.streamSize() ||
+            len > geo_.streamSize() - offset)
+        {
+            return false;
+        }
+        if (len == 0)
+        {
+            return true;
+        }
+        uint32_t block = geo_.recordAt(offset);
+        uint32_t start = geo_.recordStart(block);
+        while (len > 0)
+        {
+            const uint32_t siblingBytes = geo_.siblingCount(block) * static_cast<uint32_t>(kHashSize);
+            const uint32_t pos = offset - start;
+            size_t n = 0;
+            if (pos < siblingBytes)
+            {
+                const uint8_t level = geo_.siblingLevel(block, static_cast<uint8_t>(pos / kHashSize));
+                const size_t within = pos % kHashSize;
+                n = std::min(len, kHashSize - within);
+                std::memcpy(out, node(level, (block >> level) + 1) + within, n);
+            }
+            else
+            {
+                const uint32_t dataPos = pos - siblingBytes;
+                n = std::min<size_t>(len, geo_.blockLen(block) - dataPos);
+                if (!readData_(ctx_, (block << geo_.blockLog2()) + dataPos, out, n))
+                {
+                    return false;
+                }
+            }
+            out += n;
+            offset += static_cast<uint32_t>(n);
+            len -= n;
+            if (offset - start == siblingBytes + geo_.blockLen(block))
+            {
+                block++;
+                start = offset;
+            }
+        }
+        return true;
+    }
+
+    const uint8_t *StreamEncoder::node(uint8_t level, uint32_t index)
+    {
+        if (level == 0)
+        {
+            return leaves_ + size_t(index) * kHashSize;
+        }
+        // Records ask for a level's siblings in increasing index order, and a
+        // resend only reaches back one record, so one slot per level is
+        // enough to hash each node about once per transfer.
+        CachedNode &c = cache_[level];
+        if (!c.valid || c.index != index)
+        {
+            computeNode(level, index, c.hash);
+            c.index = index;
+            c.valid = true;
+        }
+        return c.hash;
+    }
+
+    void StreamEncoder::computeNode(uint8_t level, uint32_t index, uint8_t out[kHashSize])
+    {
+        // Fold the node's leaves left to right on a stack, merging equal
+        // levels as they meet. What is left at the end is the ragged right
+        // edge: each entry is promoted up to the one below it and merged,
+        // which is exactly the odd-node-promotion rule.
+        const uint32_t first = index << level;
+        const uint32_t last = std::min(geo_.blockCount(), (index + 1) << level);
+        uint8_t levels[kMaxLevels + 1];
+        size_t depth = 0;
+        for (uint32_t i = first; i < last; i++)
+        {
+            std::memcpy(scratch_[depth], leaves_ + size_t(i) * kHashSize, kHashSize);
+            levels[depth] = 0;
+            depth++;
+            while (depth >= 2 && levels[depth - 1] == levels[depth - 2])
+            {
+                hashNode(scratch_[depth - 2], scratch_[depth - 1], scratch_[depth - 2]);
+                levels[depth - 2]++;
+                depth--;
+            }
+        }
+        while (depth >= 2)
+        {
+            hashNode(scratch_[depth - 2], scratch_[depth - 1], scratch_[depth - 2]);
+            depth--;
+        }
+        std::memcpy(out, scratch_[0], kHashSize);
+    }
+
+    // ─── BlockVerifier ───────────────────────────────────────────────────
+
+    bool BlockVerifier::begin(const Geometry &geo, const uint8_t root[kHashSize], BlockOutFn out, void *ctx)
+    {
+        return resume(geo, root, VerifierState{}, out, ctx);
+    }
+
+    bool BlockVerifier::resume(const Geometry &geo, const uint8_t root[kHashSize], const VerifierState &state,
+                               BlockOutFn out, void *ctx)
+    {
+        reset();
+        if (!geo.valid() || state.nextBlock >= geo.blockCount())
+        {
+            return false;
+        }
+        geo_ = geo;
+        std::memcpy(root_, root, kHashSize);
+        out_ = out;
+        ctx_ = ctx;
+        state_ = state;
+        cursor_ = geo_.recordStart(state_.nextBlock);
+        started_ = true;
+        startRecord();
+        return true;
+    }
+
+    void BlockVerifier::reset()
+    {
+        geo_ = Geometry{};
+        std::memset(root_, 0, sizeof(root_));
+        out_ = nullptr;
+        ctx_ = nullptr;
+        started_ = false;
+        failed_ = false;
+        failStatus_ = Status::NOT_STARTED;
+        state_ = VerifierState{};
+        cursor_ = 0;
+        recordStart_ = 0;
+        siblingBytesNeeded_ = 0;
+        siblingBytes_ = 0;
+        blockFill_ = 0;
+    }
+
+    VerifyResult BlockVerifier::fail(Status s)
+    {
+        failed_ = true;
+        failStatus_ = s;
+        return VerifyResult::failed(s);
+    }
+
+    void BlockVerifier::startRecord()
+    {
+        recordStart_ = cursor_;
+        siblingBytes_ = 0;
+        blockFill_ = 0;
+        siblingBytesNeeded_ =
+            state_.nextBlock < geo_.blockCount() ? geo_.siblingCount(state_.nextBlock) * kHashSize : 0;
+    }
+
+    VerifyResult BlockVerifier::feed(uint32_t offset, const uint8_t *data, size_t len)
+    {
+        if (!started_)
+        {
+            return VerifyResult::failed(Status::NOT_STARTED);
+        }
+        if (failed_)
+        {
+            return VerifyResult::failed(failStatus_);
+        }
+        if (offset > cursor_)
+        {
+            return fail(Status::GAP);
+        }
+        // Already-consumed prefix: a resend that starts at the chunk holding
+        // the record start, or a duplicate.
+        const size_t skip = cursor_ - offset;
+        if (skip >= len)
+        {
+            return VerifyResult::success();
+        }
+        data += skip;
+        len -= skip;
+        if (len > geo_.streamSize() - cursor_)
+        {
+            return fail(Status::OVERFLOW);
+        }
+
+        while (len > 0)
+        {
+            size_t n = 0;
+            if (siblingBytes_ < siblingBytesNeeded_)
+            {
+                n = std::min(len, siblingBytesNeeded_ - siblingBytes_);
+                std::memcpy(&siblings_[0][0] + siblingBytes_, data, n);
+                siblingBytes_ += n;
+            }
+            else
+            {
+                n = std::min<size_t>(len, geo_.blockLen(state_.nextBlock) - blockFill_);
+                std::memcpy(block_ + blockFill_, data, n);
+                blockFill_ += n;
+            }
+            data += n;
+            len -= n;
+            cursor_ += static_cast<uint32_t>(n);
+
+            if (blockFill_ == geo_.blockLen(state_.nextBlock))
+            {
+                VerifyResult r = completeRecord();
+                if (!r.ok)
+                {
+                    return r;
+                }
+            }
+        }
+        return VerifyResult::success();
+    }
+
+    VerifyResult BlockVerifier::completeRecord()
+    {
+        const uint32_t b = state_.nextBlock;
+        const size_t blockLen = blockFill_;
+        uint8_t leaf[kHashSize];
+        hashLeaf(block_, blockLen, leaf);
+
+        // The one path entry the next block needs that isn't carried: at
+        // level ctz(b + 1) the next block's ancestor is a right child whose
+        // left sibling is this block's ancestor — captured on the way up.
+        const uint8_t splitLevel = static_cast<uint8_t>(__builtin_ctz(b + 1));
+        uint8_t split[kHashSize] = {0};
+
+        uint8_t h[kHashSize];
+        std::memcpy(h, leaf, kHashSize);
+        uint8_t carried = 0;
+        for (uint8_t k = 0; k < geo_.height(); k++)
+        {
+            if (k == splitLevel)
+            {
+                std::memcpy(split, h, kHashSize);
+            }
+            const uint32_t j = b >> k;
+            if ((j & 1) != 0)
+            {
+                hashNode(state_.path[k], h, h);
+            }
+            else if (j + 1 < geo_.width(k))
+            {
+                const uint8_t *right = geo_.carries(b, k) ? siblings_[carried++] : state_.path[k];
+                hashNode(h, right, h);
+            }
+            // else: last node of its level, promoted unchanged
+        }
+
+        if (std::memcmp(h, root_, kHashSize) != 0)
+        {
+            // Drop the record — block and carried siblings alike, since either
+            // could be the corrupt part — and wait for it again.
+            cursor_ = recordStart_;
+            startRecord();
+            return VerifyResult::mismatch(b, recordStart_);
+        }
+
+        // Verified: the carried siblings are now trusted, and this block's
+        // ancestor at splitLevel becomes the next block's left sibling.
+        carried = 0;
+        for (uint8_t k = 0; k < geo_.height(); k++)
+        {
+            if (geo_.carries(b, k))
+            {
+                std::memcpy(state_.path[k], siblings_[carried++], kHashSize);
+            }
+        }
+        if (splitLevel < geo_.height())
+        {
+            std::memcpy(state_.path[splitLevel], split, kHashSize);
+        }
+        state_.nextBlock++;
+        startRecord();
+
+        if (out_ != nullptr && !out_(ctx_, b, block_, blockLen, leaf))
+        {
+            return fail(Status::WRITE_FAILED);
+        }
+        return VerifyResult::success();
+    }
+
+    VerifyResult BlockVerifier::finish() const
+    {
+        if (!started_)
+        {
+            return VerifyResult::failed(Status::NOT_STARTED);
+        }
+        if (failed_)
+        {
+            return VerifyResult::failed(failStatus_);
+        }
+        if (state_.nextBlock != geo_.blockCount())
+        {
+            return VerifyResult::failed(Status::TRUNCATED);
+        }
+        return VerifyResult::success();
+    }
+} // namespace AstrOsOtaMerkle
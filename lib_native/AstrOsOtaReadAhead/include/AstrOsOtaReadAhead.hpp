@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-ahead cache for the staged firmware file the master forwards.
+//
+// OtaForwarder sends 128 B chunks and retransmits any of the last window's
+// worth on timeout. Reading each of those straight from the SD card puts a
+// seek + read — and every SD latency spike — on the path of every OTA_DATA
+// frame. ImageCache sits in between and reads the file in large blocks:
+//
+//   resident: storage holds the whole image. scan() loads it during the one
+//             pass that hashes it; every read() afterwards is a memcpy, and
+//             later scans (the next padawan) hash from RAM without any IO.
+//   window:   storage holds a few blocks, direct-mapped by block index, so
+//             block b and its neighbours coexist. read() loads a missing
+//             block in one call; prefetchNext() loads the block after the
+//             last one read, so the caller can pull it in while it is only
+//             waiting on ACKs.
+//
+// scan() is the single sequential pass that produces the SHA-256 OTA_BEGIN
+// announces; an optional callback sees the same bytes (Merkle leaves).
+//
+// Pure: no ESP-IDF includes, no heap (storage is the caller's), no logging.
+// IO goes through a C-style callback (fn pointer + void *ctx), same shape
+// as AstrOsOtaMerkle::ReadDataFn.
+namespace AstrOsOtaReadAhead
+{
+    // Bounds the tag array; a window never needs more than a handful.
+    constexpr uint8_t kMaxSlots = 8;
+
+    // Reads `len` bytes of the image at `offset`. Returns false on IO failure.
+    using ReadFn = bool (*)(void *ctx, uint32_t offset, uint8_t *out, size_t len);
+    // Sees every image byte once, in order, during scan().
+    using ScanFn = void (*)(void *ctx, const uint8_t *data, size_t len);
+
+    enum class Status : uint8_t
+    {
+        OK = 0,
+        NOT_STARTED = 1,  // called before begin()
+        OUT_OF_RANGE = 2, // read() past the end of the image
+        READ_FAILED = 3   // ReadFn returned false
+    };
+
+    struct [[nodiscard]] CacheResult
+    {
+        bool ok = false;
+        Status status = Status::NOT_STARTED;
+
+        static CacheResult success()
+        {
+            return {true, Status::OK};
+        }
+        static CacheResult failed(Status s)
+        {
+            return {false, s};
+        }
+    };
+
+    // Since begin(). A load is one ReadFn call of up to one block.
+    struct Stats
+    {
+        uint32_t hits = 0;  // read() blocks served without IO
+        uint32_t loads = 0; // blocks read through ReadFn (scan included)
+        uint32_t bytesLoaded = 0;
+    };
+
+    // Usage:
+    //   cache.begin(size, 4096, storage, storageLen, readFn, ctx);
+    //   cache.scan(sha, leafFn, leafCtx);     // before OTA_BEGIN
+    //   cache.read(offset, buf, len);         // per OTA_DATA chunk
+    //   cache.prefetchNext();                 // when idle
+    class ImageCache
+    {
+    public:
+        // `storage` must outlive the cache. storageLen >= size selects
+        // resident mode; otherwise storageLen / blockSize slots (at most
+        // kMaxSlots are used). False for a zero size, a null storage, a
+        // blockSize that isn't a power of two, or room for no block.
+        bool begin(uint32_t size, uint32_t blockSize, uint8_t *storage, size_t storageLen, ReadFn read, void *ctx);
+        void reset();
+
+        bool active() const
+        {
+            return storage_ != nullptr;
+        }
+        bool resident() const
+        {
+            return resident_;
+        }
+        uint32_t size() const
+        {
+            return size_;
+        }
+        Stats stats() const
+        {
+            return stats_;
+        }
+
+        // Hashes the whole image in block-sized reads into `sha`, handing
+        // each block to `onData` (may be null) first. Resident mode keeps
+        // what it read; once a scan has completed, later scans read nothing.
+        CacheResult scan(uint8_t sha[32], ScanFn onData, void *onDataCtx);
+        // Copies image bytes [offset, offset + len).
+        CacheResult read(uint32_t offset, uint8_t *out, size_t len);
+        // Window mode with two or more slots: loads the block after the last
+        // one read() touched if it isn't cached yet. Otherwise a no-op.
+        CacheResult prefetchNext();
+
+    private:
+        uint32_t blockLen(uint32_t block) const;
+        // Window mode: makes `block` current in its slot.
+        CacheResult ensure(uint32_t block, bool &hit);
+        uint8_t *slot(uint32_t block) const;
+
+        uint8_t *storage_ = nullptr;
+        ReadFn read_ = nullptr;
+        void *ctx_ = nullptr;
+        uint32_t size_ = 0;
+        uint32_t blockSize_ = 0;
+        uint32_t blockCount_ = 0;
+        bool resident_ = false;
+        bool loaded_ = false; // resident: the whole image is in storage_
+        uint8_t slots_ = 0;
+        uint32_t tags_[kMaxSlots] = {0}; // block in each slot, kNoBlock if none
+        uint32_t lastBlock_ = 0;
+        bool anyRead_ = false;
+        Stats stats_{};
+    };
+} // namespace AstrOsOtaReadAhead
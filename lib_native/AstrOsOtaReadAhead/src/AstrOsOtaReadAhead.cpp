@@ -0,0 +1,206 @@
+#include <AstrOsOtaReadAhead.hpp>
+#include <AstrOsSha256.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace AstrOsOtaReadAhead
+{
+    static_assert(static_cast<uint8_t>(Status::READ_FAILED) == 3, "Status values are log-stable");
+
+    namespace
+    {
+        constexpr uint32_t kNoBlock = 0xFFFFFFFF;
+    } // namespace
+
+    bool ImageCache::begin(uint32_t size, uint32_t blockSize, uint8_t *storage, size_t storageLen, ReadFn read,
+                           void *ctx)
+    {
+        reset();
+        if (size == 0 || storage == nullptr || read == nullptr || blockSize == 0 ||
+            (blockSize & (blockSize - 1)) != 0)
+        {
+            return false;
+        }
+        resident_ = storageLen >= size;
+        if (!resident_)
+        {
+            if (storageLen < blockSize)
+            {
+                return false;
+            }
+            slots_ = static_cast<uint8_t>(std::min<size_t>(storageLen / blockSize, kMaxSlots));
+        }
+        storage_ = storage;
+        read_ = read;
+        ctx_ = ctx;
+        size_ = size;
+        blockSize_ = blockSize;
+        blockCount_ = static_cast<uint32_t>((uint64_t(size) + blockSize - 1) / blockSize);
+        return true;
+    }
+
+    void ImageCache::reset()
+    {
+        *this = ImageCache{};
+        std::fill(tags_, tags_ + kMaxSlots, kNoBlock);
+    }
+
+    uint32_t ImageCache::blockLen(uint32_t block) const
+    {
+        const uint32_t start = block * blockSize_;
+        return std::min(blockSize_, size_ - start);
+    }
+
+    uint8_t *ImageCache::slot(uint32_t block) const
+    {
+        return storage_ + size_t(block % slots_) * blockSize_;
+    }
+
+    CacheResult ImageCache::ensure(uint32_t block, bool &hit)
+    {
+        uint32_t &tag = tags_[block % slots_];
+        hit = tag == block;
+        if (hit)
+        {
+            return CacheResult::success();
+        }
+        const uint32_t len = blockLen(block);
+        if (!read_(ctx_, block * blockSize_, slot(block), len))
+        {
+            // The slot holds a partial read now; don't let a later hit
+            // serve it.
+            tag = kNoBlock;
+            return CacheResult::failed(Status::READ_FAILED);
+        }
+        tag = block;
+        stats_.loads++;
+        stats_.bytesLoaded += len;
+        return CacheResult::success();
+    }
+
+    CacheResult ImageCache::scan(uint8_t sha[32], ScanFn onData, void *onDataCtx)
+    {
+        if (!active())
+        {
+            return CacheResult::failed(Status::NOT_STARTED);
+        }
+        AstrOsSha256Ctx ctx;
+        AstrOsSha256_init(&ctx);
+        for (uint32_t block = 0; block < blockCount_; block++)
+        {
+            const uint32_t len = blockLen(block);
+            const uint8_t *data;
+            if (resident_)
+            {
+                uint8_t *dst = storage_ + size_t(block) * blockSize_;
+                if (!loaded_)
+                {
+                    if (!read_(ctx_, block * blockSize_, dst, len))
+                    {
+                        return CacheResult::failed(Status::READ_FAILED);
+                    }
+                    stats_.loads++;
+                    stats_.bytesLoaded += len;
+                }
+                data = dst;
+            }
+            else
+            {
+                bool hit;
+                auto r = ensure(block, hit);
+                if (!r.ok)
+                {
+                    return r;
+                }
+                data = slot(block);
+            }
+            if (onData != nullptr)
+            {
+                onData(onDataCtx, data, len);
+            }
+            AstrOsSha256_update(&ctx, data, len);
+        }
+        loaded_ = resident_;
+        AstrOsSha256_final(&ctx, sha);
+        return CacheResult::success();
+    }
+
+    CacheResult ImageCache::read(uint32_t offset, uint8_t *out, size_t len)
+    {
+        if (!active())
+        {
+            return CacheResult::failed(Status::NOT_STARTED);
+        }
+        if (offset > size_ || len > size_ - offset)
+        {
+            return CacheResult::failed(Status::OUT_OF_RANGE);
+        }
+        if (len == 0)
+        {
+            return CacheResult::success();
+        }
+        if (resident_)
+        {
+            if (!loaded_)
+            {
+                // Nothing scanned yet: pass straight through rather than
+                // load blocks the caller may never come back for.
+                if (!read_(ctx_, offset, out, len))
+                {
+                    return CacheResult::failed(Status::READ_FAILED);
+                }
+                stats_.loads++;
+                stats_.bytesLoaded += static_cast<uint32_t>(len);
+                return CacheResult::success();
+            }
+            std::memcpy(out, storage_ + offset, len);
+            stats_.hits++;
+            return CacheResult::success();
+        }
+        while (len > 0)
+        {
+            const uint32_t block = offset / blockSize_;
+            bool hit;
+            auto r = ensure(block, hit);
+            if (!r.ok)
+            {
+                return r;
+            }
+            if (hit)
+            {
+                stats_.hits++;
+            }
+            const uint32_t within = offset - block * blockSize_;
+            const size_t n = std::min<size_t>(len, blockLen(block) - within);
+            std::memcpy(out, slot(block) + within, n);
+            out += n;
+            offset += static_cast<uint32_t>(n);
+            len -= n;
+            lastBlock_ = block;
+            anyRead_ = true;
+        }
+        return CacheResult::success();
+    }
+
+    CacheResult ImageCache::prefetchNext()
+    {
+        if (!active())
+        {
+            return CacheResult::failed(Status::NOT_STARTED);
+        }
+        // One slot: the next block would evict the current one, which the
+        // sender's retransmits still need.
+        if (resident_ || slots_ < 2)
+        {
+            return CacheResult::success();
+        }
+        const uint32_t next = anyRead_ ? lastBlock_ + 1 : 0;
+        if (next >= blockCount_)
+        {
+            return CacheResult::success();
+        }
+        bool hit;
+        return ensure(next, hit);
+    }
+} // namespace AstrOsOtaReadAhead
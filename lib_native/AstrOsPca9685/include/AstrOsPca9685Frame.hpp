@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Output state of one PCA9685 as the servo backend last wrote it, and the
+// step map that turns a pulse width into the board's 12-bit OFF count.
+//
+// Every channel is 4 registers (ON_L, ON_H, OFF_L, OFF_H) starting at
+// LED0_ON_L, and with MODE1.AI set the board auto-increments through them,
+// so a run of neighbouring channels is one I2C write. set() only marks a
+// channel dirty when its value changes; nextRun() hands out each run of
+// contiguous dirty channels once, as one burst.
+//
+// Servo outputs are fixed at 50 Hz so the step map can be built at compile
+// time. ON is always 0; OFF is the pulse's count or kFullOff.
+namespace AstrOsPca9685
+{
+    constexpr uint8_t kChannels = 16;
+    constexpr uint8_t kLed0OnL = 0x06;
+    constexpr uint8_t kAllLedOnL = 0xFA;
+    constexpr uint8_t kBytesPerChannel = 4;
+    // OFF_H bit 4: output held low. The reset state of every channel.
+    constexpr uint16_t kFullOff = 0x1000;
+
+    constexpr uint32_t kServoFreqHz = 50;
+    constexpr int kServoSteps = 360;
+    constexpr int kServoMinUs = 500;
+    constexpr int kServoMaxUs = 2500;
+
+    namespace detail
+    {
+        // std::round isn't constexpr; this is, for the positive values here.
+        constexpr long roundPositive(long double v)
+        {
+            long r = static_cast<long>(v);
+            return (v - r >= 0.5L) ? r + 1 : r;
+        }
+
+        // GetMicroSecondsAsStep (AstrOsServoUtils.hpp), step for step.
+        constexpr int microSecondsAsStep(int us, double freq_us)
+        {
+            const double percent = (static_cast<double>(us) * 100.0) / freq_us;
+            return static_cast<int>(roundPositive(percent / .0244l));
+        }
+    } // namespace detail
+
+    // CalculateStepMap (AstrOsServoUtils.hpp) evaluated at compile time:
+    // kServoSteps OFF counts spread evenly over kServoMinUs..kServoMaxUs.
+    constexpr std::array<uint16_t, kServoSteps> stepMap(double freq)
+    {
+        std::array<uint16_t, kServoSteps> map = {};
+        const double freq_us = 1000000.0 / freq;
+        const int minStep = detail::microSecondsAsStep(kServoMinUs, freq_us);
+        const int maxStep = detail::microSecondsAsStep(kServoMaxUs, freq_us);
+
+        double currentStep = static_cast<double>(minStep);
+        const double stepSize = (maxStep - minStep) / static_cast<double>(kServoSteps);
+
+        for (int i = 0; i < kServoSteps; i++)
+        {
+            map[i] = static_cast<uint16_t>(detail::roundPositive(currentStep));
+            currentStep += stepSize;
+        }
+        return map;
+    }
+
+    inline constexpr std::array<uint16_t, kServoSteps> kStepMap = stepMap(kServoFreqHz);
+
+    // OFF count for a `us` pulse: the nearest kStepMap entry.
+    constexpr uint16_t pulseTicks(int us)
+    {
+        const int span = kServoMaxUs - kServoMinUs;
+        int i = ((us - kServoMinUs) * kServoSteps + span / 2) / span;
+        i = i < 0 ? 0 : (i > kServoSteps - 1 ? kServoSteps - 1 : i);
+        return kStepMap[i];
+    }
+
+    struct ChannelRun
+    {
+        uint8_t first;
+        uint8_t count;
+
+        uint8_t reg() const
+        {
+            return kLed0OnL + kBytesPerChannel * first;
+        }
+        size_t bytes() const
+        {
+            return kBytesPerChannel * count;
+        }
+    };
+
+    class Frame
+    {
+    public:
+        // `off` is an OFF count (0..4095) or kFullOff; channels past
+        // kChannels are ignored.
+        void set(uint8_t ch, uint16_t off);
+        uint16_t get(uint8_t ch) const
+        {
+            return off_[ch];
+        }
+        // Records that every output was switched off at once (ALL_LED_OFF).
+        void allOff();
+        // Marks every channel dirty, e.g. after a failed write.
+        void invalidate()
+        {
+            dirty_ = 0xFFFF;
+        }
+        uint16_t dirty() const
+        {
+            return dirty_;
+        }
+
+        // Takes the lowest run of contiguous dirty channels and marks it
+        // clean. False when nothing is dirty.
+        bool nextRun(ChannelRun &run);
+        // Register bytes for `run` (room for run.bytes()), written from
+        // run.reg(); returns the count.
+        size_t encode(const ChannelRun &run, uint8_t *out) const;
+
+    private:
+        uint16_t off_[kChannels] = {kFullOff, kFullOff, kFullOff, kFullOff, kFullOff, kFullOff, kFullOff, kFullOff,
+                                    kFullOff, kFullOff, kFullOff, kFullOff, kFullOff, kFullOff, kFullOff, kFullOff};
+        uint16_t dirty_ = 0;
+    };
+} // namespace AstrOsPca9685
@@ -0,0 +1,65 @@
+#include <AstrOsPca9685Frame.hpp>
+
+namespace AstrOsPca9685
+{
+    // Spot checks against CalculateStepMap(50, map, 360): a wrong constexpr
+    // port fails the build rather than moving servos.
+    static_assert(kStepMap[0] == 102 && kStepMap[kServoSteps - 1] == 511, "step map range");
+    static_assert(pulseTicks(1500) == kStepMap[180], "step map midpoint");
+
+    void Frame::set(uint8_t ch, uint16_t off)
+    {
+        if (ch >= kChannels || off_[ch] == off)
+        {
+            return;
+        }
+        off_[ch] = off;
+        dirty_ |= 1u << ch;
+    }
+
+    void Frame::allOff()
+    {
+        for (uint16_t &off : off_)
+        {
+            off = kFullOff;
+        }
+        dirty_ = 0;
+    }
+
+    bool Frame::nextRun(ChannelRun &run)
+    {
+        if (dirty_ == 0)
+        {
+            return false;
+        }
+
+        uint8_t first = 0;
+        while ((dirty_ & (1u << first)) == 0)
+        {
+            first++;
+        }
+        uint8_t end = first;
+        while (end < kChannels && (dirty_ & (1u << end)) != 0)
+        {
+            dirty_ &= ~(1u << end);
+            end++;
+        }
+
+        run.first = first;
+        run.count = end - first;
+        return true;
+    }
+
+    size_t Frame::encode(const ChannelRun &run, uint8_t *out) const
+    {
+        for (uint8_t i = 0; i < run.count; i++)
+        {
+            const uint16_t off = off_[run.first + i];
+            out[4 * i] = 0x00;
+            out[4 * i + 1] = 0x00;
+            out[4 * i + 2] = off & 0xFF;
+            out[4 * i + 3] = (off >> 8) & 0xFF;
+        }
+        return run.bytes();
+    }
+} // namespace AstrOsPca9685
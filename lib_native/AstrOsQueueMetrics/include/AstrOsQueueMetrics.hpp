@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Counters for one queue consumer (lib/AstrOsQueueConsumer). The consumer
+// task blocks until its queue has work, then handles everything queued
+// before blocking again; each such pass is a wake and its messages are a
+// batch.
+//
+//   depth     messages waiting, the one just received included, sampled
+//             at every receive
+//   wait      from the producer's send (the enqueuedUs stamp every queued
+//             message carries) to the start of the message's handler: time
+//             in the queue, the consumer's wake-up and any earlier messages
+//             in its batch
+//   service   time spent in the message's own handler
+//
+// One task records, another (the maintenance timer) reads. Each field is
+// an atomic on its own, so a snapshot taken mid-batch can be off by the
+// message being recorded; that is fine for diagnostics. Totals are 32-bit
+// microseconds, meant to be read with take() every few seconds.
+namespace AstrOsQueueMetrics
+{
+    struct Snapshot
+    {
+        uint32_t wakes = 0;
+        uint32_t messages = 0;
+        uint32_t maxBatch = 0;
+        uint32_t maxDepth = 0;
+        uint32_t totalWaitUs = 0;
+        uint32_t maxWaitUs = 0;
+        uint32_t totalServiceUs = 0;
+        uint32_t maxServiceUs = 0;
+
+        uint32_t avgWaitUs() const
+        {
+            return messages == 0 ? 0 : totalWaitUs / messages;
+        }
+        uint32_t avgServiceUs() const
+        {
+            return messages == 0 ? 0 : totalServiceUs / messages;
+        }
+        // Messages per wake, x100 (e.g. 250 = 2.5).
+        uint32_t avgBatchX100() const
+        {
+            return wakes == 0 ? 0 : static_cast<uint32_t>(static_cast<uint64_t>(messages) * 100 / wakes);
+        }
+    };
+
+    class ConsumerMetrics
+    {
+    public:
+        void onMessage(uint32_t depth, uint32_t waitUs, uint32_t serviceUs);
+        // Closes a wake that handled `batch` messages; a wake that found
+        // nothing (timeout) is not counted.
+        void onWake(uint32_t batch);
+
+        Snapshot snapshot() const;
+        // Snapshot, then zero every counter.
+        Snapshot take();
+        void reset();
+
+    private:
+        std::atomic<uint32_t> wakes_{0};
+        std::atomic<uint32_t> messages_{0};
+        std::atomic<uint32_t> maxBatch_{0};
+        std::atomic<uint32_t> maxDepth_{0};
+        std::atomic<uint32_t> totalWaitUs_{0};
+        std::atomic<uint32_t> maxWaitUs_{0};
+        std::atomic<uint32_t> totalServiceUs_{0};
+        std::atomic<uint32_t> maxServiceUs_{0};
+    };
+} // namespace AstrOsQueueMetrics
@@ -0,0 +1,70 @@
+#include "AstrOsQueueMetrics.hpp"
+
+namespace AstrOsQueueMetrics
+{
+    namespace
+    {
+        // take() may zero the field between the load and the store; losing
+        // one sample of a maximum is acceptable, a torn value is not.
+        void raise(std::atomic<uint32_t> &field, uint32_t value)
+        {
+            uint32_t current = field.load(std::memory_order_relaxed);
+            while (value > current && !field.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            {
+            }
+        }
+    } // namespace
+
+    void ConsumerMetrics::onMessage(uint32_t depth, uint32_t waitUs, uint32_t serviceUs)
+    {
+        messages_.fetch_add(1, std::memory_order_relaxed);
+        totalWaitUs_.fetch_add(waitUs, std::memory_order_relaxed);
+        totalServiceUs_.fetch_add(serviceUs, std::memory_order_relaxed);
+        raise(maxDepth_, depth);
+        raise(maxWaitUs_, waitUs);
+        raise(maxServiceUs_, serviceUs);
+    }
+
+    void ConsumerMetrics::onWake(uint32_t batch)
+    {
+        if (batch == 0)
+        {
+            return;
+        }
+        wakes_.fetch_add(1, std::memory_order_relaxed);
+        raise(maxBatch_, batch);
+    }
+
+    Snapshot ConsumerMetrics::snapshot() const
+    {
+        Snapshot s;
+        s.wakes = wakes_.load(std::memory_order_relaxed);
+        s.messages = messages_.load(std::memory_order_relaxed);
+        s.maxBatch = maxBatch_.load(std::memory_order_relaxed);
+        s.maxDepth = maxDepth_.load(std::memory_order_relaxed);
+        s.totalWaitUs = totalWaitUs_.load(std::memory_order_relaxed);
+        s.maxWaitUs = maxWaitUs_.load(std::memory_order_relaxed);
+        s.totalServiceUs = totalServiceUs_.load(std::memory_order_relaxed);
+        s.maxServiceUs = maxServiceUs_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    Snapshot ConsumerMetrics::take()
+    {
+        Snapshot s;
+        s.wakes = wakes_.exchange(0, std::memory_order_relaxed);
+        s.messages = messages_.exchange(0, std::memory_order_relaxed);
+        s.maxBatch = maxBatch_.exchange(0, std::memory_order_relaxed);
+        s.maxDepth = maxDepth_.exchange(0, std::memory_order_relaxed);
+        s.totalWaitUs = totalWaitUs_.exchange(0, std::memory_order_relaxed);
+        s.maxWaitUs = maxWaitUs_.exchange(0, std::memory_order_relaxed);
+        s.totalServiceUs = totalServiceUs_.exchange(0, std::memory_order_relaxed);
+        s.maxServiceUs = maxServiceUs_.exchange(0, std::memory_order_relaxed);
+        return s;
+    }
+
+    void ConsumerMetrics::reset()
+    {
+        (void)take();
+    }
+} // namespace AstrOsQueueMetrics
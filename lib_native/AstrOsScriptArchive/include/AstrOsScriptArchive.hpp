@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Packed, append-only store for animation scripts: one data file holding
+// every script as a CRC-checked record, plus a sorted index of
+// (scriptId -> record offset, length, crc) that is loaded into RAM at open.
+// A lookup is a binary search over the index and one seek-read.
+//
+// Data file (kDataFile):
+//
+//   header   magic "ASPK", version, generation                     16 B
+//   record   magic, idLen, flags, crc16(id ‖ data), dataLen         12 B
+//            id, data
+//   ...
+//
+// A put appends a record; a remove appends a tombstone (flags bit 0, no
+// data). Superseded records and tombstones are dead space until compact()
+// rewrites the live records into a new file of the next generation.
+//
+// Index file (kIndexFile): the generation and data-file length it
+// describes, the dead-byte count, and the sorted entries, closed by a
+// CRC-16 over all of it. It is only a cache of the data file:
+//
+//   - records appended after the index was written are replayed at open,
+//     so the index is rewritten every Config::indexEveryRecords appends
+//     (and on flush() / close()), not on every put;
+//   - a torn tail record (power loss mid-append) fails its length or CRC
+//     check on replay and is truncated away;
+//   - an index that is missing, torn, or from another generation is
+//     rebuilt by replaying the whole data file.
+//
+// Files are replaced by writing a ".tmp" sibling and renaming it over the
+// original, so a crash leaves either the old file or the new one. The one
+// window with neither — between removing the old data file and the rename
+// — is closed at open() by promoting a complete kDataTmp.
+//
+// All IO goes through FileOps, so the format logic runs (and is tested)
+// on the host; the firmware binds it to stdio on the SD card.
+namespace AstrOsScriptArchive
+{
+    constexpr const char *kDataFile = "scripts.pak";
+    constexpr const char *kDataTmp = "scripts.pak.tmp";
+    constexpr const char *kIndexFile = "scripts.idx";
+    constexpr const char *kIndexTmp = "scripts.idx.tmp";
+
+    constexpr size_t kMaxIdLen = 64;
+    constexpr uint32_t kDataHeaderSize = 16;
+    constexpr uint32_t kRecordHeaderSize = 12;
+
+    // Files are named by the constants above. Every call returns false on
+    // failure; size() also when the file does not exist.
+    struct FileOps
+    {
+        bool (*size)(void *ctx, const char *name, uint32_t &out);
+        bool (*read)(void *ctx, const char *name, uint32_t offset, uint8_t *out, size_t len);
+        // Creates the file if needed.
+        bool (*append)(void *ctx, const char *name, const uint8_t *data, size_t len);
+        bool (*truncate)(void *ctx, const char *name, uint32_t len);
+        // Creates or replaces the whole file.
+        bool (*write)(void *ctx, const char *name, const uint8_t *data, size_t len);
+        // Replaces `to` if it exists.
+        bool (*rename)(void *ctx, const char *from, const char *to);
+        // True if the file is gone afterwards, whether or not it existed.
+        bool (*remove)(void *ctx, const char *name);
+        void *ctx;
+    };
+
+    struct Config
+    {
+        // Appends between index rewrites; each one left unindexed costs a
+        // record-header read at the next open.
+        uint32_t indexEveryRecords = 16;
+        // put() / remove() compact once dead space is at least this many
+        // bytes and this share of the data file.
+        uint32_t compactMinDeadBytes = 32 * 1024;
+        uint8_t compactDeadPercent = 50;
+    };
+
+    enum class Status : uint8_t
+    {
+        OK = 0,
+        NOT_OPEN = 1,
+        NOT_FOUND = 2,
+        INVALID_ID = 3, // empty, longer than kMaxIdLen, or contains '/' or NUL
+        TOO_LARGE = 4,  // read(): bigger than the buffer; bytes = the size needed
+        IO_ERROR = 5,
+        CORRUPT = 6 // read(): the record no longer matches its CRC
+    };
+
+    const char *statusName(Status s);
+
+    struct [[nodiscard]] Result
+    {
+        bool ok = false;
+        Status status = Status::NOT_OPEN;
+        uint32_t bytes = 0;
+
+        static Result success(uint32_t bytes = 0)
+        {
+            return {true, Status::OK, bytes};
+        }
+        static Result failed(Status s, uint32_t bytes = 0)
+        {
+            return {false, s, bytes};
+        }
+    };
+
+    struct Stats
+    {
+        uint32_t scripts = 0;
+        uint32_t dataBytes = 0; // data file length
+        uint32_t deadBytes = 0; // superseded records and tombstones
+        uint32_t unindexedRecords = 0;
+        // From the last open().
+        uint32_t replayedRecords = 0;
+        uint32_t droppedTailBytes = 0;
+        bool indexRebuilt = false;
+        uint32_t compactions = 0;
+    };
+
+    class Archive
+    {
+    public:
+        // Loads the index, replays unindexed records, repairs a torn tail,
+        // and creates an empty archive when there is none. `ops` is copied.
+        Result open(const FileOps &ops, const Config &config = Config());
+        // Writes the index if anything is unindexed, then forgets the ops.
+        void close();
+        bool isOpen() const
+        {
+            return open_;
+        }
+
+        Result put(const std::string &id, const uint8_t *data, size_t len);
+        Result remove(const std::string &id);
+        bool contains(const std::string &id) const;
+        // bytes = the script's length.
+        Result read(const std::string &id, uint8_t *out, size_t cap) const;
+        // Replaces `out` only on success.
+        Result read(const std::string &id, std::string &out) const;
+        // Sorted.
+        std::vector<std::string> list() const;
+
+        // Rewrites the index if any record is unindexed.
+        Result flush();
+        // Copies the live records into a new generation; the old one is
+        // replaced only once the copy is complete.
+        Result compact();
+        bool shouldCompact() const;
+
+        Stats stats() const;
+
+        static bool validId(const std::string &id);
+
+    private:
+        struct Entry
+        {
+            std::string id;
+            uint32_t record = 0; // offset of the record header
+            uint32_t len = 0;
+            uint16_t crc = 0;
+
+            uint32_t recordSize() const
+            {
+                return kRecordHeaderSize + static_cast<uint32_t>(id.size()) + len;
+            }
+            uint32_t dataOffset() const
+            {
+                return record + kRecordHeaderSize + static_cast<uint32_t>(id.size());
+            }
+        };
+
+        Result create();
+        bool loadIndex(const char *name, uint32_t dataSize);
+        // Applies records in [from, to); returns where the valid ones end.
+        uint32_t replay(uint32_t from, uint32_t to);
+        // Fills `out` for the record it appended.
+        Result appendRecord(const std::string &id, uint8_t flags, const uint8_t *data, size_t len, Entry &out);
+        bool writeIndex();
+        bool copyRange(const char *to, uint32_t from, uint32_t len);
+        // Update entries_ and the dead-byte count.
+        void applyPut(const Entry &e);
+        void applyRemove(const std::string &id, uint32_t tombstoneSize);
+        std::vector<Entry>::iterator find(const std::string &id);
+        std::vector<Entry>::const_iterator find(const std::string &id) const;
+        // Index rewrite and compaction when due.
+        void afterAppend();
+
+        FileOps ops_{};
+        Config config_{};
+        bool open_ = false;
+        uint32_t generation_ = 0;
+        uint32_t dataEnd_ = 0;
+        uint32_t deadBytes_ = 0;
+        std::vector<Entry> entries_; // sorted by id
+        Stats stats_{};
+    };
+} // namespace AstrOsScriptArchive
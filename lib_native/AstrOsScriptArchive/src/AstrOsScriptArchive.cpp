@@ -0,0 +1,688 @@
+#include <AstrOsBulkTransport.hpp>
+#include <AstrOsScriptArchive.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace AstrOsScriptArchive
+{
+    namespace
+    {
+        // Little-endian "ASPK", "ASPR", "ASIX".
+        constexpr uint32_t kDataMagic = 0x4B505341u;
+        constexpr uint32_t kRecordMagic = 0x52505341u;
+        constexpr uint32_t kIndexMagic = 0x58495341u;
+        constexpr uint16_t kVersion = 1;
+
+        constexpr uint8_t kFlagTombstone = 0x01;
+
+        // Anything longer is a damaged length field, not a script.
+        constexpr uint32_t kMaxDataLen = 16u * 1024 * 1024;
+
+        // magic, version, reserved, generation, dataEnd, deadBytes, count
+        constexpr uint32_t kIndexHeaderSize = 24;
+        // idLen, record, len, crc; then the id
+        constexpr uint32_t kIndexEntryFixed = 11;
+
+        constexpr size_t kCopyBlock = 4096;
+        constexpr size_t kSmallBlock = 256;
+
+        void put16(uint8_t *p, uint16_t v)
+        {
+            p[0] = static_cast<uint8_t>(v);
+            p[1] = static_cast<uint8_t>(v >> 8);
+        }
+
+        void put32(uint8_t *p, uint32_t v)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                p[i] = static_cast<uint8_t>(v >> (8 * i));
+            }
+        }
+
+        uint16_t get16(const uint8_t *p)
+        {
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        uint32_t get32(const uint8_t *p)
+        {
+            return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+        }
+
+        void dataHeader(uint8_t out[kDataHeaderSize], uint32_t generation)
+        {
+            std::memset(out, 0, kDataHeaderSize);
+            put32(out, kDataMagic);
+            put16(out + 4, kVersion);
+            put32(out + 8, generation);
+        }
+
+        bool lessById(const std::string &a, const std::string &b)
+        {
+            return a < b;
+        }
+    } // namespace
+
+    const char *statusName(Status s)
+    {
+        switch (s)
+        {
+        case Status::OK:
+            return "ok";
+        case Status::NOT_OPEN:
+            return "not_open";
+        case Status::NOT_FOUND:
+            return "not_found";
+        case Status::INVALID_ID:
+            return "invalid_id";
+        case Status::TOO_LARGE:
+            return "too_large";
+        case Status::IO_ERROR:
+            return "io_error";
+        case Status::CORRUPT:
+            return "corrupt";
+        }
+        return "unknown";
+    }
+
+    bool Archive::validId(const std::string &id)
+    {
+        return !id.empty() && id.size() <= kMaxIdLen && id.find('/') == std::string::npos &&
+               id.find('\0') == std::string::npos;
+    }
+
+    Result Archive::open(const FileOps &ops, const Config &config)
+    {
+        open_ = false;
+        entries_.clear();
+        stats_ = Stats();
+        ops_ = ops;
+        config_ = config;
+
+        uint32_t dataSize = 0;
+        bool have = ops_.size(ops_.ctx, kDataFile, dataSize);
+        if (have)
+        {
+            // An unfinished compaction; the data file it was copying is intact.
+            ops_.remove(ops_.ctx, kDataTmp);
+        }
+        else
+        {
+            // compact() got as far as removing the old data file but not
+            // renaming the new one in. The copy was complete before that.
+            uint32_t tmpSize = 0;
+            if (ops_.size(ops_.ctx, kDataTmp, tmpSize) && ops_.rename(ops_.ctx, kDataTmp, kDataFile))
+            {
+                have = ops_.size(ops_.ctx, kDataFile, dataSize);
+            }
+        }
+        if (!have || dataSize < kDataHeaderSize)
+        {
+            // None yet, or power was lost while create() wrote the header.
+            return create();
+        }
+
+        uint8_t hdr[kDataHeaderSize];
+        if (!ops_.read(ops_.ctx, kDataFile, 0, hdr, sizeof(hdr)))
+        {
+            return Result::failed(Status::IO_ERROR);
+        }
+        if (get32(hdr) != kDataMagic || get16(hdr + 4) != kVersion)
+        {
+            // Not ours, or damaged where nothing can be recovered. Leave it
+            // for someone to look at rather than overwrite it.
+            return Result::failed(Status::CORRUPT);
+        }
+        generation_ = get32(hdr + 8);
+
+        uint32_t from = kDataHeaderSize;
+        if (loadIndex(kIndexFile, dataSize) || loadIndex(kIndexTmp, dataSize))
+        {
+            from = dataEnd_;
+        }
+        else
+        {
+            entries_.clear();
+            deadBytes_ = 0;
+            stats_.indexRebuilt = true;
+        }
+        ops_.remove(ops_.ctx, kIndexTmp);
+
+        const uint32_t end = replay(from, dataSize);
+        if (end < dataSize)
+        {
+            if (!ops_.truncate(ops_.ctx, kDataFile, end))
+            {
+                return Result::failed(Status::IO_ERROR);
+            }
+            stats_.droppedTailBytes = dataSize - end;
+        }
+        dataEnd_ = end;
+        open_ = true;
+
+        stats_.unindexedRecords = stats_.replayedRecords;
+        if (stats_.replayedRecords > 0 || stats_.indexRebuilt || stats_.droppedTailBytes > 0)
+        {
+            // Failure only costs the same replay at the next open.
+            writeIndex();
+        }
+        return Result::success(static_cast<uint32_t>(entries_.size()));
+    }
+
+    void Archive::close()
+    {
+        if (open_ && stats_.unindexedRecords > 0)
+        {
+            writeIndex();
+        }
+        open_ = false;
+        entries_.clear();
+        ops_ = FileOps{};
+    }
+
+    Result Archive::put(const std::string &id, const uint8_t *data, size_t len)
+    {
+        if (!open_)
+        {
+            return Result::failed(Status::NOT_OPEN);
+        }
+        if (!validId(id))
+        {
+            return Result::failed(Status::INVALID_ID);
+        }
+        if (len > kMaxDataLen)
+        {
+            return Result::failed(Status::TOO_LARGE, static_cast<uint32_t>(std::min<size_t>(len, UINT32_MAX)));
+        }
+        Entry e;
+        Result r = appendRecord(id, 0, data, len, e);
+        if (!r.ok)
+        {
+            return r;
+        }
+        applyPut(e);
+        afterAppend();
+        return Result::success(e.len);
+    }
+
+    Result Archive::remove(const std::string &id)
+    {
+        if (!open_)
+        {
+            return Result::failed(Status::NOT_OPEN);
+        }
+        if (!validId(id))
+        {
+            return Result::failed(Status::INVALID_ID);
+        }
+        if (find(id) == entries_.end())
+        {
+            return Result::failed(Status::NOT_FOUND);
+        }
+        Entry tombstone;
+        Result r = appendRecord(id, kFlagTombstone, nullptr, 0, tombstone);
+        if (!r.ok)
+        {
+            return r;
+        }
+        applyRemove(id, tombstone.recordSize());
+        afterAppend();
+        return Result::success();
+    }
+
+    bool Archive::contains(const std::string &id) const
+    {
+        return open_ && find(id) != entries_.end();
+    }
+
+    Result Archive::read(const std::string &id, uint8_t *out, size_t cap) const
+    {
+        if (!open_)
+        {
+            return Result::failed(Status::NOT_OPEN);
+        }
+        auto it = find(id);
+        if (it == entries_.end())
+        {
+            return Result::failed(Status::NOT_FOUND);
+        }
+        if (it->len > cap)
+        {
+            return Result::failed(Status::TOO_LARGE, it->len);
+        }
+        if (it->len > 0 && !ops_.read(ops_.ctx, kDataFile, it->dataOffset(), out, it->len))
+        {
+            return Result::failed(Status::IO_ERROR);
+        }
+        AstrOsBulkTransport::Crc16CcittFalse crc;
+        crc.update(reinterpret_cast<const uint8_t *>(it->id.data()), it->id.size());
+        if (it->len > 0)
+        {
+            crc.update(out, it->len);
+        }
+        if (crc.final() != it->crc)
+        {
+            return Result::failed(Status::CORRUPT);
+        }
+        return Result::success(it->len);
+    }
+
+    Result Archive::read(const std::string &id, std::string &out) const
+    {
+        if (!open_)
+        {
+            return Result::failed(Status::NOT_OPEN);
+        }
+        auto it = find(id);
+        if (it == entries_.end())
+        {
+            return Result::failed(Status::NOT_FOUND);
+        }
+        std::string text;
+        text.resize(it->len);
+        Result r = read(id, reinterpret_cast<uint8_t *>(&text[0]), text.size());
+        if (r.ok)
+        {
+            out.swap(text);
+        }
+        return r;
+    }
+
+    std::vector<std::string> Archive::list() const
+    {
+        std::vector<std::string> ids;
+        ids.reserve(entries_.size());
+        for (const Entry &e : entries_)
+        {
+            ids.push_back(e.id);
+        }
+        return ids;
+    }
+
+    Result Archive::flush()
+    {
+        if (!open_)
+        {
+            return Result::failed(Status::NOT_OPEN);
+        }
+        if (stats_.unindexedRecords > 0 && !writeIndex())
+        {
+            return Result::failed(Status::IO_ERROR);
+        }
+        return Result::success();
+    }
+
+    Result Archive::compact()
+    {
+        if (!open_)
+        {
+            return Result::failed(Status::NOT_OPEN);
+        }
+        uint8_t hdr[kDataHeaderSize];
+        dataHeader(hdr, generation_ + 1);
+        if (!ops_.write(ops_.ctx, kDataTmp, hdr, sizeof(hdr)))
+        {
+            ops_.remove(ops_.ctx, kDataTmp);
+            return Result::failed(Status::IO_ERROR);
+        }
+
+        // Sorted order, so the file reads front to back in id order too.
+        std::vector<Entry> moved = entries_;
+        uint32_t pos = kDataHeaderSize;
+        for (Entry &e : moved)
+        {
+            if (!copyRange(kDataTmp, e.record, e.recordSize()))
+            {
+                ops_.remove(ops_.ctx, kDataTmp);
+                return Result::failed(Status::IO_ERROR);
+            }
+            e.record = pos;
+            pos += e.recordSize();
+        }
+
+        if (!ops_.rename(ops_.ctx, kDataTmp, kDataFile))
+        {
+            // The old data file may already be gone; open() promotes the
+            // complete copy. Until then, nothing here can be trusted.
+            open_ = false;
+            return Result::failed(Status::IO_ERROR);
+        }
+
+        const uint32_t reclaimed = dataEnd_ - pos;
+        generation_++;
+        entries_.swap(moved);
+        dataEnd_ = pos;
+        deadBytes_ = 0;
+        stats_.compactions++;
+        // The index on disk is the old generation's; until this lands,
+        // the next open rebuilds from the (now dead-space-free) data file.
+        stats_.unindexedRecords = static_cast<uint32_t>(entries_.size());
+        writeIndex();
+        return Result::success(reclaimed);
+    }
+
+    bool Archive::shouldCompact() const
+    {
+        return open_ && deadBytes_ >= config_.compactMinDeadBytes &&
+               uint64_t(deadBytes_) * 100 >= uint64_t(config_.compactDeadPercent) * dataEnd_;
+    }
+
+    Stats Archive::stats() const
+    {
+        Stats s = stats_;
+        s.scripts = static_cast<uint32_t>(entries_.size());
+        s.dataBytes = dataEnd_;
+        s.deadBytes = deadBytes_;
+        return s;
+    }
+
+    Result Archive::create()
+    {
+        uint8_t hdr[kDataHeaderSize];
+        dataHeader(hdr, 1);
+        if (!ops_.write(ops_.ctx, kDataFile, hdr, sizeof(hdr)))
+        {
+            return Result::failed(Status::IO_ERROR);
+        }
+        generation_ = 1;
+        dataEnd_ = kDataHeaderSize;
+        deadBytes_ = 0;
+        entries_.clear();
+        open_ = true;
+        stats_.indexRebuilt = true;
+        // An index left from an archive whose data file vanished would name
+        // generation 1 too; overwrite it now.
+        if (!writeIndex())
+        {
+            ops_.remove(ops_.ctx, kIndexFile);
+        }
+        return Result::success();
+    }
+
+    bool Archive::loadIndex(const char *name, uint32_t dataSize)
+    {
+        uint32_t size = 0;
+        if (!ops_.size(ops_.ctx, name, size) || size < kIndexHeaderSize + 2)
+        {
+            return false;
+        }
+        std::vector<uint8_t> buf(size);
+        if (!ops_.read(ops_.ctx, name, 0, buf.data(), size))
+        {
+            return false;
+        }
+        const uint8_t *p = buf.data();
+        if (AstrOsBulkTransport::crc16_ccitt_false(p, size - 2) != get16(p + size - 2))
+        {
+            return false;
+        }
+        const uint32_t end = get32(p + 12);
+        const uint32_t dead = get32(p + 16);
+        const uint32_t count = get32(p + 20);
+        if (get32(p) != kIndexMagic || get16(p + 4) != kVersion || get32(p + 8) != generation_ ||
+            end < kDataHeaderSize || end > dataSize || dead > end)
+        {
+            return false;
+        }
+
+        std::vector<Entry> entries;
+        entries.reserve(count);
+        uint32_t pos = kIndexHeaderSize;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (size - 2 - pos < kIndexEntryFixed)
+            {
+                return false;
+            }
+            Entry e;
+            const uint8_t idLen = p[pos];
+            e.record = get32(p + pos + 1);
+            e.len = get32(p + pos + 5);
+            e.crc = get16(p + pos + 9);
+            pos += kIndexEntryFixed;
+            if (idLen == 0 || idLen > kMaxIdLen || size - 2 - pos < idLen)
+            {
+                return false;
+            }
+            e.id.assign(reinterpret_cast<const char *>(p + pos), idLen);
+            pos += idLen;
+            if (e.record < kDataHeaderSize || e.len > kMaxDataLen || e.record + e.recordSize() > end ||
+                (!entries.empty() && !lessById(entries.back().id, e.id)))
+            {
+                return false;
+            }
+            entries.push_back(std::move(e));
+        }
+        if (pos != size - 2)
+        {
+            return false;
+        }
+
+        entries_.swap(entries);
+        dataEnd_ = end;
+        deadBytes_ = dead;
+        return true;
+    }
+
+    uint32_t Archive::replay(uint32_t from, uint32_t to)
+    {
+        uint8_t hdr[kRecordHeaderSize];
+        char id[kMaxIdLen];
+        uint8_t chunk[kSmallBlock];
+
+        uint32_t pos = from;
+        while (to - pos >= kRecordHeaderSize)
+        {
+            if (!ops_.read(ops_.ctx, kDataFile, pos, hdr, sizeof(hdr)))
+            {
+                break;
+            }
+            const uint8_t idLen = hdr[4];
+            const uint8_t flags = hdr[5];
+            const uint16_t crc = get16(hdr + 6);
+            const uint32_t len = get32(hdr + 8);
+            const bool tombstone = (flags & kFlagTombstone) != 0;
+            if (get32(hdr) != kRecordMagic || idLen == 0 || idLen > kMaxIdLen || (flags & ~kFlagTombstone) != 0 ||
+                len > kMaxDataLen || (tombstone && len != 0))
+            {
+                break;
+            }
+            const uint32_t size = kRecordHeaderSize + idLen + len;
+            if (size > to - pos ||
+                !ops_.read(ops_.ctx, kDataFile, pos + kRecordHeaderSize, reinterpret_cast<uint8_t *>(id), idLen))
+            {
+                break;
+            }
+
+            AstrOsBulkTransport::Crc16CcittFalse sum;
+            sum.update(reinterpret_cast<const uint8_t *>(id), idLen);
+            uint32_t off = pos + kRecordHeaderSize + idLen;
+            uint32_t left = len;
+            bool readOk = true;
+            while (left > 0 && readOk)
+            {
+                const uint32_t n = std::min<uint32_t>(left, sizeof(chunk));
+                readOk = ops_.read(ops_.ctx, kDataFile, off, chunk, n);
+                sum.update(chunk, n);
+                off += n;
+                left -= n;
+            }
+            std::string key(id, idLen);
+            if (!readOk || sum.final() != crc || !validId(key))
+            {
+                break;
+            }
+
+            if (tombstone)
+            {
+                applyRemove(key, size);
+            }
+            else
+            {
+                Entry e;
+                e.id = std::move(key);
+                e.record = pos;
+                e.len = len;
+                e.crc = crc;
+                applyPut(e);
+            }
+            stats_.replayedRecords++;
+            pos += size;
+        }
+        return pos;
+    }
+
+    Result Archive::appendRecord(const std::string &id, uint8_t flags, const uint8_t *data, size_t len, Entry &out)
+    {
+        AstrOsBulkTransport::Crc16CcittFalse crc;
+        crc.update(reinterpret_cast<const uint8_t *>(id.data()), id.size());
+        if (len > 0)
+        {
+            crc.update(data, len);
+        }
+
+        uint8_t head[kRecordHeaderSize + kMaxIdLen];
+        put32(head, kRecordMagic);
+        head[4] = static_cast<uint8_t>(id.size());
+        head[5] = flags;
+        put16(head + 6, crc.final());
+        put32(head + 8, static_cast<uint32_t>(len));
+        std::memcpy(head + kRecordHeaderSize, id.data(), id.size());
+
+        const bool wrote = ops_.append(ops_.ctx, kDataFile, head, kRecordHeaderSize + id.size()) &&
+                           (len == 0 || ops_.append(ops_.ctx, kDataFile, data, len));
+        if (!wrote)
+        {
+            // Replay stops at the first bad record, so a torn one left here
+            // would hide every record appended after it.
+            if (!ops_.truncate(ops_.ctx, kDataFile, dataEnd_))
+            {
+                open_ = false;
+            }
+            return Result::failed(Status::IO_ERROR);
+        }
+
+        out.id = id;
+        out.record = dataEnd_;
+        out.len = static_cast<uint32_t>(len);
+        out.crc = crc.final();
+        dataEnd_ += out.recordSize();
+        return Result::success();
+    }
+
+    bool Archive::writeIndex()
+    {
+        size_t size = kIndexHeaderSize + 2;
+        for (const Entry &e : entries_)
+        {
+            size += kIndexEntryFixed + e.id.size();
+        }
+        std::vector<uint8_t> buf(size);
+        uint8_t *p = buf.data();
+        put32(p, kIndexMagic);
+        put16(p + 4, kVersion);
+        put16(p + 6, 0);
+        put32(p + 8, generation_);
+        put32(p + 12, dataEnd_);
+        put32(p + 16, deadBytes_);
+        put32(p + 20, static_cast<uint32_t>(entries_.size()));
+        size_t pos = kIndexHeaderSize;
+        for (const Entry &e : entries_)
+        {
+            p[pos] = static_cast<uint8_t>(e.id.size());
+            put32(p + pos + 1, e.record);
+            put32(p + pos + 5, e.len);
+            put16(p + pos + 9, e.crc);
+            pos += kIndexEntryFixed;
+            std::memcpy(p + pos, e.id.data(), e.id.size());
+            pos += e.id.size();
+        }
+        put16(p + pos, AstrOsBulkTransport::crc16_ccitt_false(p, pos));
+
+        if (!ops_.write(ops_.ctx, kIndexTmp, p, size) || !ops_.rename(ops_.ctx, kIndexTmp, kIndexFile))
+        {
+            return false;
+        }
+        stats_.unindexedRecords = 0;
+        return true;
+    }
+
+    bool Archive::copyRange(const char *to, uint32_t from, uint32_t len)
+    {
+        std::unique_ptr<uint8_t[]> heap(new (std::nothrow) uint8_t[kCopyBlock]);
+        uint8_t small[kSmallBlock];
+        uint8_t *buf = heap ? heap.get() : small;
+        const size_t bufLen = heap ? kCopyBlock : sizeof(small);
+        while (len > 0)
+        {
+            const uint32_t n = static_cast<uint32_t>(std::min<size_t>(len, bufLen));
+            if (!ops_.read(ops_.ctx, kDataFile, from, buf, n) || !ops_.append(ops_.ctx, to, buf, n))
+            {
+                return false;
+            }
+            from += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    void Archive::applyPut(const Entry &e)
+    {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), e.id,
+                                   [](const Entry &a, const std::string &id) { return lessById(a.id, id); });
+        if (it != entries_.end() && it->id == e.id)
+        {
+            deadBytes_ += it->recordSize();
+            *it = e;
+        }
+        else
+        {
+            entries_.insert(it, e);
+        }
+    }
+
+    void Archive::applyRemove(const std::string &id, uint32_t tombstoneSize)
+    {
+        auto it = find(id);
+        if (it != entries_.end())
+        {
+            deadBytes_ += it->recordSize();
+            entries_.erase(it);
+        }
+        deadBytes_ += tombstoneSize;
+    }
+
+    std::vector<Archive::Entry>::iterator Archive::find(const std::string &id)
+    {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), id,
+                                   [](const Entry &a, const std::string &key) { return lessById(a.id, key); });
+        return (it != entries_.end() && it->id == id) ? it : entries_.end();
+    }
+
+    std::vector<Archive::Entry>::const_iterator Archive::find(const std::string &id) const
+    {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), id,
+                                   [](const Entry &a, const std::string &key) { return lessById(a.id, key); });
+        return (it != entries_.end() && it->id == id) ? it : entries_.end();
+    }
+
+    void Archive::afterAppend()
+    {
+        stats_.unindexedRecords++;
+        if (stats_.unindexedRecords >= config_.indexEveryRecords)
+        {
+            // The record is already durable; a failed index write only
+            // means a longer replay at the next open.
+            writeIndex();
+        }
+        if (shouldCompact())
+        {
+            // Same: the put / remove stands whether or not this lands.
+            (void)compact();
+        }
+    }
+} // namespace AstrOsScriptArchive
@@ -8,9 +8,11 @@
 // streaming digest. This implementation runs entirely in software
 // so the OTA hash is isolated from any other SHA consumer.
 //
-// Implementation lives in AstrOsSha256.c (Brad Conte, public domain).
-// Pure C — no ESP-IDF/FreeRTOS includes — so it builds under the
-// native test env and on both boards from one source.
+// Implementation lives in AstrOsSha256.c (Brad Conte, public domain,
+// restructured for throughput: whole blocks hash straight from the
+// caller's buffer, so feed it large spans where you can). Pure C — no
+// ESP-IDF/FreeRTOS includes — so it builds under the native test env
+// and on both boards from one source.
 
 #include <stddef.h>
 #include <stdint.h>
@@ -22,6 +24,8 @@ extern "C"
 
 #define ASTROS_SHA256_DIGEST_LEN 32
 
+    // Layout is persisted (OtaWriter's NVS resume checkpoint embeds it);
+    // changing it means bumping that checkpoint's version.
     typedef struct
     {
         uint8_t data[64];
@@ -12,7 +12,8 @@ extern "C"
         I2C,
         GENERIC_SERIAL,
         KANGAROO,
-        GPIO
+        GPIO,
+        PCA9685
     } MODULE_TYPE;
 
     typedef enum
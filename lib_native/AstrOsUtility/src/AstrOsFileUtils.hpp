@@ -60,6 +60,28 @@ private:
     }
 
 public:
+    // bool|bool|...; 1 is default high, anything else default low. An empty
+    // file (or none) means the 10 onboard channels all default low.
+    static std::vector<bool> parseGpioConfig(const std::string &gpioFile)
+    {
+        std::vector<bool> results;
+
+        if (gpioFile.empty())
+        {
+            results.assign(10, false);
+            return results;
+        }
+
+        auto parts = AstrOsStringUtils::splitString(gpioFile, '|');
+        results.reserve(parts.size());
+        for (const auto &part : parts)
+        {
+            results.push_back(part == "1");
+        }
+
+        return results;
+    }
+
     static std::vector<maestro_config> parseMaestroConfig(const std::string maestroFile)
     {
         std::vector<maestro_config> configs;
@@ -12,7 +12,7 @@
 /// @param us
 /// @param freq_us
 /// @return
-int GetMicroSecondsAsStep(int us, double freq_us)
+inline int GetMicroSecondsAsStep(int us, double freq_us)
 {
     auto asdouble = (double)us;
     auto percent = (asdouble * 100.0) / freq_us; // percent of duty cycle
@@ -27,7 +27,7 @@ int GetMicroSecondsAsStep(int us, double freq_us)
 /// @param minStep
 /// @param maxStep
 /// @return
-int MicroSecondsToMapPosition(int val, double freq_us, int minStep, int maxStep, int steps)
+inline int MicroSecondsToMapPosition(int val, double freq_us, int minStep, int maxStep, int steps)
 {
     auto step = GetMicroSecondsAsStep(val, freq_us);
 
@@ -47,7 +47,7 @@ int MicroSecondsToMapPosition(int val, double freq_us, int minStep, int maxStep,
 /// @param freq frequency in Hz
 /// @param map the map to fill
 /// @return return the step size so we can calculate requested positions
-double CalculateStepMap(double freq, uint16_t *map, int steps)
+inline double CalculateStepMap(double freq, uint16_t *map, int steps)
 {
     auto freq_us = 1000000.0 / freq; // frequency in microseconds
     auto minStep = GetMicroSecondsAsStep(500, freq_us);
@@ -71,7 +71,7 @@ double CalculateStepMap(double freq, uint16_t *map, int steps)
 /// @param maxPos
 /// @param requestPercentage
 /// @return
-int GetRelativeRequestedPosition(int minPos, int maxPos, int requestPercentage)
+inline int GetRelativeRequestedPosition(int minPos, int maxPos, int requestPercentage)
 {
     if (requestPercentage <= 0)
     {
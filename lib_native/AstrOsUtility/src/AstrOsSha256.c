@@ -1,7 +1,18 @@
-// SHA-256 implementation derived from Brad Conte's public-domain
-// reference (https://github.com/B-Con/crypto-algorithms). Renamed
-// types/functions to the AstrOs namespace and adapted to our header.
-// No algorithmic changes.
+// SHA-256 derived from Brad Conte's public-domain reference
+// (https://github.com/B-Con/crypto-algorithms), renamed to the AstrOs
+// namespace and restructured for throughput:
+//
+//  - update() hashes whole 64-byte blocks straight out of the caller's
+//    buffer; only a partial head/tail goes through ctx->data.
+//  - The transform keeps a rolling 16-word message schedule instead of
+//    the 64-word array, and the round loop is unrolled eight-wide so the
+//    working variables rotate by renaming instead of by seven moves.
+//  - Big-endian words load with one (possibly unaligned) 32-bit read plus
+//    a byte swap on little-endian targets (ESP32 and the native host).
+//
+// Output is bit-identical to the reference; the native KATs and the
+// reference-vs-optimised differential test in astros_sha256_tests.cpp
+// hold it to that.
 
 #include "AstrOsSha256.h"
 
@@ -27,52 +38,88 @@ static const uint32_t kSha256RoundConstants[64] = {
     0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
 };
 
-static void sha256_transform(AstrOsSha256Ctx *ctx, const uint8_t data[64])
+static inline uint32_t load_be32(const uint8_t *p)
 {
-    uint32_t a, b, c, d, e, f, g, h, t1, t2, m[64];
-    int i, j;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // memcpy of a constant 4 compiles to a single load (or the byte loads
+    // the target needs for an unaligned address) — no call.
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return __builtin_bswap32(v);
+#else
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | ((uint32_t)p[3]);
+#endif
+}
 
-    for (i = 0, j = 0; i < 16; ++i, j += 4)
-    {
-        m[i] = ((uint32_t)data[j] << 24) | ((uint32_t)data[j + 1] << 16) | ((uint32_t)data[j + 2] << 8) |
-               ((uint32_t)data[j + 3]);
-    }
-    for (; i < 64; ++i)
+// Schedule word for round i >= 16, written back over w[i & 15] — the slot
+// of w[i - 16], which nothing needs after this.
+#define SCHEDULE(i)                                                                                                    \
+    (w[(i) & 15] += SIG1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] + SIG0(w[((i) - 15) & 15]))
+
+// One round with the working variables named in their rotated positions,
+// so eight consecutive rounds cycle a..h back to where they started.
+#define ROUND(a, b, c, d, e, f, g, h, k, wi)                                                                           \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        uint32_t t1 = (h) + EP1(e) + CH(e, f, g) + (k) + (wi);                                                         \
+        uint32_t t2 = EP0(a) + MAJ(a, b, c);                                                                           \
+        (d) += t1;                                                                                                     \
+        (h) = t1 + t2;                                                                                                 \
+    } while (0)
+
+#define ROUNDS8(i, W)                                                                                                  \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        ROUND(a, b, c, d, e, f, g, h, kSha256RoundConstants[(i) + 0], W((i) + 0));                                     \
+        ROUND(h, a, b, c, d, e, f, g, kSha256RoundConstants[(i) + 1], W((i) + 1));                                     \
+        ROUND(g, h, a, b, c, d, e, f, kSha256RoundConstants[(i) + 2], W((i) + 2));                                     \
+        ROUND(f, g, h, a, b, c, d, e, kSha256RoundConstants[(i) + 3], W((i) + 3));                                     \
+        ROUND(e, f, g, h, a, b, c, d, kSha256RoundConstants[(i) + 4], W((i) + 4));                                     \
+        ROUND(d, e, f, g, h, a, b, c, kSha256RoundConstants[(i) + 5], W((i) + 5));                                     \
+        ROUND(c, d, e, f, g, h, a, b, kSha256RoundConstants[(i) + 6], W((i) + 6));                                     \
+        ROUND(b, c, d, e, f, g, h, a, kSha256RoundConstants[(i) + 7], W((i) + 7));                                     \
+    } while (0)
+
+#define W_LOAD(i) (w[(i)] = load_be32(data + 4 * (i)))
+
+// Compresses `blocks` consecutive 64-byte blocks into state. The state
+// stays in locals across blocks; `data` needs no particular alignment.
+static void sha256_transform_blocks(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    uint32_t a, b, c, d, e, f, g, h;
+    uint32_t w[16];
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    while (blocks-- > 0)
     {
-        m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
-    }
-
-    a = ctx->state[0];
-    b = ctx->state[1];
-    c = ctx->state[2];
-    d = ctx->state[3];
-    e = ctx->state[4];
-    f = ctx->state[5];
-    g = ctx->state[6];
-    h = ctx->state[7];
+        // Rounds 0..15 consume the block itself; 16..63 extend the schedule
+        // in place. Unrolled eight-wide: eight rounds bring the variable
+        // naming back round, and the code stays small enough for flash cache.
+        ROUNDS8(0, W_LOAD);
+        ROUNDS8(8, W_LOAD);
+        for (int i = 16; i < 64; i += 8)
+        {
+            ROUNDS8(i, SCHEDULE);
+        }
 
-    for (i = 0; i < 64; ++i)
-    {
-        t1 = h + EP1(e) + CH(e, f, g) + kSha256RoundConstants[i] + m[i];
-        t2 = EP0(a) + MAJ(a, b, c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
+        a = (state[0] += a);
+        b = (state[1] += b);
+        c = (state[2] += c);
+        d = (state[3] += d);
+        e = (state[4] += e);
+        f = (state[5] += f);
+        g = (state[6] += g);
+        h = (state[7] += h);
+        data += 64;
     }
-
-    ctx->state[0] += a;
-    ctx->state[1] += b;
-    ctx->state[2] += c;
-    ctx->state[3] += d;
-    ctx->state[4] += e;
-    ctx->state[5] += f;
-    ctx->state[6] += g;
-    ctx->state[7] += h;
 }
 
 void AstrOsSha256_init(AstrOsSha256Ctx *ctx)
@@ -91,16 +138,41 @@ void AstrOsSha256_init(AstrOsSha256Ctx *ctx)
 
 void AstrOsSha256_update(AstrOsSha256Ctx *ctx, const uint8_t *data, size_t len)
 {
-    for (size_t i = 0; i < len; ++i)
+    // Top up a partial block left by the previous call first.
+    if (ctx->datalen > 0)
     {
-        ctx->data[ctx->datalen] = data[i];
-        ctx->datalen++;
-        if (ctx->datalen == 64)
+        size_t take = 64 - ctx->datalen;
+        if (take > len)
         {
-            sha256_transform(ctx, ctx->data);
-            ctx->bitlen += 512;
-            ctx->datalen = 0;
+            take = len;
         }
+        memcpy(ctx->data + ctx->datalen, data, take);
+        ctx->datalen += (uint32_t)take;
+        data += take;
+        len -= take;
+        if (ctx->datalen < 64)
+        {
+            return;
+        }
+        sha256_transform_blocks(ctx->state, ctx->data, 1);
+        ctx->bitlen += 512;
+        ctx->datalen = 0;
+    }
+
+    // Whole blocks straight from the caller's buffer — no copy.
+    const size_t blocks = len / 64;
+    if (blocks > 0)
+    {
+        sha256_transform_blocks(ctx->state, data, blocks);
+        ctx->bitlen += (uint64_t)blocks * 512;
+        data += blocks * 64;
+        len -= blocks * 64;
+    }
+
+    if (len > 0)
+    {
+        memcpy(ctx->data, data, len);
+        ctx->datalen = (uint32_t)len;
     }
 }
 
@@ -111,45 +183,30 @@ void AstrOsSha256_final(AstrOsSha256Ctx *ctx, uint8_t hash[ASTROS_SHA256_DIGEST_
     // Pad with 0x80 then zeros, finishing the current block. If the
     // residual already crosses 56 bytes we need an extra block to
     // hold the 64-bit length field.
+    ctx->data[i++] = 0x80;
     if (ctx->datalen < 56)
     {
-        ctx->data[i++] = 0x80;
-        while (i < 56)
-        {
-            ctx->data[i++] = 0x00;
-        }
+        memset(ctx->data + i, 0, 56 - i);
     }
     else
     {
-        ctx->data[i++] = 0x80;
-        while (i < 64)
-        {
-            ctx->data[i++] = 0x00;
-        }
-        sha256_transform(ctx, ctx->data);
+        memset(ctx->data + i, 0, 64 - i);
+        sha256_transform_blocks(ctx->state, ctx->data, 1);
         memset(ctx->data, 0, 56);
     }
 
     ctx->bitlen += (uint64_t)ctx->datalen * 8;
-    ctx->data[63] = (uint8_t)(ctx->bitlen);
-    ctx->data[62] = (uint8_t)(ctx->bitlen >> 8);
-    ctx->data[61] = (uint8_t)(ctx->bitlen >> 16);
-    ctx->data[60] = (uint8_t)(ctx->bitlen >> 24);
-    ctx->data[59] = (uint8_t)(ctx->bitlen >> 32);
-    ctx->data[58] = (uint8_t)(ctx->bitlen >> 40);
-    ctx->data[57] = (uint8_t)(ctx->bitlen >> 48);
-    ctx->data[56] = (uint8_t)(ctx->bitlen >> 56);
-    sha256_transform(ctx, ctx->data);
-
-    for (i = 0; i < 4; ++i)
+    for (i = 0; i < 8; ++i)
+    {
+        ctx->data[63 - i] = (uint8_t)(ctx->bitlen >> (8 * i));
+    }
+    sha256_transform_blocks(ctx->state, ctx->data, 1);
+
+    for (i = 0; i < 8; ++i)
     {
-        hash[i] = (uint8_t)(ctx->state[0] >> (24 - i * 8));
-        hash[i + 4] = (uint8_t)(ctx->state[1] >> (24 - i * 8));
-        hash[i + 8] = (uint8_t)(ctx->state[2] >> (24 - i * 8));
-        hash[i + 12] = (uint8_t)(ctx->state[3] >> (24 - i * 8));
-        hash[i + 16] = (uint8_t)(ctx->state[4] >> (24 - i * 8));
-        hash[i + 20] = (uint8_t)(ctx->state[5] >> (24 - i * 8));
-        hash[i + 24] = (uint8_t)(ctx->state[6] >> (24 - i * 8));
-        hash[i + 28] = (uint8_t)(ctx->state[7] >> (24 - i * 8));
+        hash[4 * i] = (uint8_t)(ctx->state[i] >> 24);
+        hash[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+        hash[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+        hash[4 * i + 3] = (uint8_t)(ctx->state[i]);
     }
 }
@@ -15,6 +15,8 @@ extern "C"
         SERVICE_COMMAND cmd;
         uint8_t *data;
         size_t dataSize;
+        // low 32 bits of esp_timer_get_time() at send, see sendStamped()
+        uint32_t enqueuedUs;
     } queue_svc_cmd_t;
 
     typedef struct
@@ -27,6 +29,8 @@ extern "C"
     {
         ANIMATION_COMMAND cmd;
         char data[100];
+        // low 32 bits of esp_timer_get_time() at send, see sendStamped()
+        uint32_t enqueuedUs;
     } queue_ani_cmd_t;
 
     typedef struct
@@ -47,6 +51,8 @@ extern "C"
         int message_id;
         uint8_t *data;
         size_t dataSize;
+        // low 32 bits of esp_timer_get_time() at send, see sendStamped()
+        uint32_t enqueuedUs;
     } queue_msg_t;
 
     typedef struct
@@ -56,6 +62,8 @@ extern "C"
         int baudrate;
         uint8_t *data;
         size_t dataSize;
+        // low 32 bits of esp_timer_get_time() at send, see sendStamped()
+        uint32_t enqueuedUs;
     } queue_serial_msg_t;
 
     typedef struct
@@ -0,0 +1,10 @@
+// AUTO-GENERATED by scripts/version_gen.py - do not edit.
+// Regenerated on every build from the VERSION file + git state.
+#pragma once
+
+namespace AstrOsConstants
+{
+    constexpr const char *Version = "1.3.0-dev.0";
+    constexpr const char *GitSha = "e68adfb";
+    constexpr const char *Variant = "native";
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Bookkeeping for AstrOsStorageManager's write-behind saves: whole-file
+// writes wait here, newest content per path, until the storage writer task
+// takes them one at a time. The interface task returns as soon as a save is
+// queued; whoever queued it hears back through its Waiter once the file is
+// durable.
+//
+//   - A save to a path that is still pending replaces that entry's data in
+//     place (coalescing) and adds its waiter, so a redeploy of the same
+//     script is written once and both requests are answered by that write.
+//   - The entry being written (in flight) is no longer coalesced into; a
+//     newer save for its path queues behind it.
+//   - peek() answers reads with the newest queued content, so a script run
+//     right after its deploy sees the new version before it reaches the card.
+//   - Bounded by entry count and by bytes held (in-flight entry included);
+//     push() reports FULL and the caller writes synchronously instead.
+//
+// Not synchronized: the MIXED owner serializes every call.
+namespace AstrOsWriteBehind
+{
+    // `ok`: the file (or the save / delete that superseded it) is durable.
+    using DoneFn = void (*)(void *ctx, const std::string &path, const std::string &token, bool ok);
+
+    struct Waiter
+    {
+        DoneFn fn = nullptr;
+        void *ctx = nullptr;
+        std::string token; // e.g. the originating message id
+    };
+
+    // Calls every waiter that has a fn.
+    void complete(const std::vector<Waiter> &waiters, const std::string &path, bool ok);
+
+    struct Config
+    {
+        size_t maxEntries = 8;
+        size_t maxBytes = 32 * 1024;
+    };
+
+    enum class PushStatus : uint8_t
+    {
+        QUEUED = 0,    // new entry; the writer needs one more wake-up
+        COALESCED = 1, // replaced a pending entry's data
+        FULL = 2       // nothing queued
+    };
+
+    struct Job
+    {
+        std::string path;
+        std::string data;
+        std::vector<Waiter> waiters;
+    };
+
+    struct Stats
+    {
+        uint32_t queued = 0;
+        uint32_t coalesced = 0;
+        uint32_t full = 0;
+        uint32_t written = 0;
+        uint32_t superseded = 0; // pending entries cancelled by a direct save / delete
+        uint32_t maxDepth = 0;
+        uint32_t maxBytes = 0;
+    };
+
+    class WriteQueue
+    {
+    public:
+        explicit WriteQueue(const Config &config = Config());
+
+        PushStatus push(const std::string &path, std::string data, Waiter waiter);
+
+        // Moves the oldest pending entry in flight and returns it; nullptr
+        // when nothing is pending or a job is already in flight. Valid until
+        // finish().
+        const Job *take();
+        // Ends the in-flight job; returns its waiters for the caller to
+        // complete (outside its lock).
+        std::vector<Waiter> finish();
+
+        // Drops the pending entry for `path` (not the in-flight one) and
+        // returns its waiters.
+        std::vector<Waiter> cancel(const std::string &path);
+        // Drops every pending entry (the in-flight one stays) and returns
+        // them for their waiters.
+        std::vector<Job> cancelAll();
+
+        // Newest queued content for `path`, pending or in flight.
+        bool peek(const std::string &path, std::string &out) const;
+        bool contains(const std::string &path) const;
+
+        size_t pendingCount() const
+        {
+            return pending_.size();
+        }
+        bool inFlight() const
+        {
+            return inFlight_;
+        }
+        bool idle() const
+        {
+            return pending_.empty() && !inFlight_;
+        }
+        size_t bytes() const
+        {
+            return bytes_;
+        }
+        Stats stats() const
+        {
+            return stats_;
+        }
+
+    private:
+        std::deque<Job>::iterator findPending(const std::string &path);
+        std::deque<Job>::const_iterator findPending(const std::string &path) const;
+
+        Config config_;
+        std::deque<Job> pending_; // oldest first
+        Job current_;
+        bool inFlight_ = false;
+        size_t bytes_ = 0;
+        Stats stats_{};
+    };
+} // namespace AstrOsWriteBehind
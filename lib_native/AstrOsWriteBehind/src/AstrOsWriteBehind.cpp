@@ -0,0 +1,145 @@
+#include <AstrOsWriteBehind.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace AstrOsWriteBehind
+{
+    void complete(const std::vector<Waiter> &waiters, const std::string &path, bool ok)
+    {
+        for (const Waiter &w : waiters)
+        {
+            if (w.fn != nullptr)
+            {
+                w.fn(w.ctx, path, w.token, ok);
+            }
+        }
+    }
+
+    WriteQueue::WriteQueue(const Config &config) : config_(config)
+    {
+    }
+
+    std::deque<Job>::iterator WriteQueue::findPending(const std::string &path)
+    {
+        return std::find_if(pending_.begin(), pending_.end(), [&](const Job &j) { return j.path == path; });
+    }
+
+    std::deque<Job>::const_iterator WriteQueue::findPending(const std::string &path) const
+    {
+        return std::find_if(pending_.begin(), pending_.end(), [&](const Job &j) { return j.path == path; });
+    }
+
+    PushStatus WriteQueue::push(const std::string &path, std::string data, Waiter waiter)
+    {
+        auto it = findPending(path);
+        if (it != pending_.end())
+        {
+            // Only the size difference is new memory.
+            const size_t after = bytes_ - it->data.size() + data.size();
+            if (after > config_.maxBytes)
+            {
+                stats_.full++;
+                return PushStatus::FULL;
+            }
+            bytes_ = after;
+            it->data = std::move(data);
+            it->waiters.push_back(std::move(waiter));
+            stats_.coalesced++;
+            stats_.maxBytes = std::max(stats_.maxBytes, static_cast<uint32_t>(bytes_));
+            return PushStatus::COALESCED;
+        }
+
+        if (pending_.size() >= config_.maxEntries || bytes_ + data.size() > config_.maxBytes)
+        {
+            stats_.full++;
+            return PushStatus::FULL;
+        }
+        bytes_ += data.size();
+        Job job;
+        job.path = path;
+        job.data = std::move(data);
+        job.waiters.push_back(std::move(waiter));
+        pending_.push_back(std::move(job));
+        stats_.queued++;
+        stats_.maxDepth = std::max(stats_.maxDepth, static_cast<uint32_t>(pending_.size()));
+        stats_.maxBytes = std::max(stats_.maxBytes, static_cast<uint32_t>(bytes_));
+        return PushStatus::QUEUED;
+    }
+
+    const Job *WriteQueue::take()
+    {
+        if (inFlight_ || pending_.empty())
+        {
+            return nullptr;
+        }
+        current_ = std::move(pending_.front());
+        pending_.pop_front();
+        inFlight_ = true;
+        return &current_;
+    }
+
+    std::vector<Waiter> WriteQueue::finish()
+    {
+        std::vector<Waiter> waiters;
+        if (!inFlight_)
+        {
+            return waiters;
+        }
+        waiters.swap(current_.waiters);
+        bytes_ -= current_.data.size();
+        current_ = Job();
+        inFlight_ = false;
+        stats_.written++;
+        return waiters;
+    }
+
+    std::vector<Waiter> WriteQueue::cancel(const std::string &path)
+    {
+        std::vector<Waiter> waiters;
+        auto it = findPending(path);
+        if (it != pending_.end())
+        {
+            waiters.swap(it->waiters);
+            bytes_ -= it->data.size();
+            pending_.erase(it);
+            stats_.superseded++;
+        }
+        return waiters;
+    }
+
+    std::vector<Job> WriteQueue::cancelAll()
+    {
+        std::vector<Job> jobs;
+        jobs.reserve(pending_.size());
+        for (Job &job : pending_)
+        {
+            bytes_ -= job.data.size();
+            stats_.superseded++;
+            jobs.push_back(std::move(job));
+        }
+        pending_.clear();
+        return jobs;
+    }
+
+    bool WriteQueue::peek(const std::string &path, std::string &out) const
+    {
+        auto it = findPending(path);
+        if (it != pending_.end())
+        {
+            out = it->data;
+            return true;
+        }
+        if (inFlight_ && current_.path == path)
+        {
+            out = current_.data;
+            return true;
+        }
+        return false;
+    }
+
+    bool WriteQueue::contains(const std::string &path) const
+    {
+        return findPending(path) != pending_.end() || (inFlight_ && current_.path == path);
+    }
+} // namespace AstrOsWriteBehind
@@ -34,11 +34,16 @@
 #include <SerialModule.hpp>
 
 #include <AstrOsEspNow.h>
+#include <AstrOsI2cEngine.hpp>
 #include <AstrOsInterfaceResponseMsg.hpp>
 #include <AstrOsNames.h>
+#include <AstrOsPooledQueue.hpp>
+#include <AstrOsQueueConsumer.hpp>
 #include <AstrOsStorageManager.hpp>
 #include <AstrOsUtility_ESP.h>
+#include <MaestroCommand.hpp>
 #include <MaestroModule.hpp>
+#include <Pca9685Module.hpp>
 #include <guid.h>
 
 static const char *TAG = AstrOsConstants::ModuleName;
@@ -132,6 +137,17 @@ static SerialModule SerialChannel2;
 static std::map<int, std::shared_ptr<MaestroModule>> maestroModules;
 static SemaphoreHandle_t maestroModulesMutex = NULL;
 
+// Build with -D MAESTRO_READBACK when the Maestros' TX lines are wired to
+// the serial channels' RX pins; servos are then turned off as soon as the
+// controller reports them settled instead of after a worst-case estimate.
+#ifdef MAESTRO_READBACK
+static SerialModule *const MAESTRO_READBACK_CH1 = &SerialChannel1;
+static SerialModule *const MAESTRO_READBACK_CH2 = &SerialChannel2;
+#else
+static SerialModule *const MAESTRO_READBACK_CH1 = nullptr;
+static SerialModule *const MAESTRO_READBACK_CH2 = nullptr;
+#endif
+
 // #define BAUD_RATE_1 (9600)
 
 // #define MAESTRO_UART_PORT UART_NUM_2
@@ -150,6 +166,15 @@ static SemaphoreHandle_t maestroModulesMutex = NULL;
 #define SERVO_BOARD_0_ADDR 0x40
 #define SERVO_BOARD_1_ADDR 0x41
 
+// PCA9685 servo boards, module n at PCA9685_BASE_ADDRESS + n. Build with
+// -D PCA9685_BOARDS=n to drive them; boards that don't answer at boot are
+// skipped. Filled in by init() before any task runs, read-only after.
+#ifndef PCA9685_BOARDS
+#define PCA9685_BOARDS 0
+#endif
+
+static std::vector<std::unique_ptr<Pca9685Module>> pcaModules;
+
 /**********************************
  * Method definitions
  *********************************/
@@ -182,24 +207,61 @@ void animationDispatchTask(void *arg);
 void serialCh1QueueTask(void *arg);
 void serialCh2QueueTask(void *arg);
 void servoQueueTask(void *arg);
-void i2cQueueTask(void *arg);
-void gpioQueueTask(void *arg);
+void ioQueueTask(void *arg);
+void i2cEngineTask(void *arg);
 void espnowQueueTask(void *arg);
 void otaReceiverTask(void *arg);
+void otaStagingTask(void *arg);
 void otaForwarderTask(void *arg);
 void otaWriterTask(void *arg);
+void otaFlashTask(void *arg);
+void storageWriterTask(void *arg);
 
 // handlers
 static AstrOsSerialMessageType getSerialMessageType(AstrOsInterfaceResponseType type);
 static void handleRegistrationSync(astros_interface_response_t msg);
 static void handleSetConfig(astros_interface_response_t msg);
 static void handleSaveScript(astros_interface_response_t msg);
+static void scriptSavedCallback(void *ctx, const std::string &path, const std::string &msgId, bool ok);
+static void sendScriptDeployAckNak(const std::string &msgId, const std::string &scriptId, bool success);
 static void handleRunSctipt(astros_interface_response_t msg);
 static void handleRunCommand(astros_interface_response_t msg);
 static void handlePanicStop(astros_interface_response_t msg);
 static void handleFormatSD(std::string id);
 static void handleServoTest(astros_interface_response_t msg);
 
+// queue consumers: each task blocks until its queue has work and then
+// drains it (lib/AstrOsQueueConsumer)
+static void handleInterfaceResponseMsg(void *ctx, void *item);
+static void handleServiceMsg(void *ctx, void *item);
+static void handleAnimationMsg(void *ctx, void *item);
+static void handleSerialCh1Msg(void *ctx, void *item);
+static void handleSerialCh2Msg(void *ctx, void *item);
+static void handleServoMsg(void *ctx, void *item);
+static void handleI2cMsg(void *ctx, void *item);
+static void handleGpioMsg(void *ctx, void *item);
+static void handleEspnowMsg(void *ctx, void *item);
+
+static QueueConsumer interfaceResponseConsumer("interface", &handleInterfaceResponseMsg);
+static QueueConsumer serviceConsumer("service", &handleServiceMsg);
+static QueueConsumer animationConsumer("animation", &handleAnimationMsg);
+static QueueConsumer serialCh1Consumer("serial1", &handleSerialCh1Msg);
+static QueueConsumer serialCh2Consumer("serial2", &handleSerialCh2Msg);
+static QueueConsumer servoConsumer("servo", &handleServoMsg);
+static QueueConsumer i2cConsumer("i2c", &handleI2cMsg);
+static QueueConsumer gpioConsumer("gpio", &handleGpioMsg);
+static QueueConsumer espnowConsumer("espnow", &handleEspnowMsg);
+static QueueSetConsumer ioConsumer("io");
+
+// Item storage for the queue-set members, bound in init() because the set
+// has to be built before anything is sent to its queues.
+static queue_msg_t i2cItem;
+static queue_msg_t gpioItem;
+
+static QueueConsumer *const queueConsumers[] = {
+    &interfaceResponseConsumer, &serviceConsumer, &animationConsumer, &serialCh1Consumer, &serialCh2Consumer,
+    &servoConsumer,             &i2cConsumer,     &gpioConsumer,      &espnowConsumer};
+
 esp_err_t mountSdCard(void);
 
 #pragma region Main()
@@ -223,14 +285,28 @@ void app_main()
     xTaskCreatePinnedToCore(&serialCh1QueueTask, "serial_ch1_queue_task", 4096, (void *)serialCh1Queue, 9, NULL, 1);
     xTaskCreatePinnedToCore(&serialCh2QueueTask, "serial_ch2_queue_task", 4096, (void *)serialCh2Queue, 9, NULL, 1);
     xTaskCreatePinnedToCore(&servoQueueTask, "servo_queue_task", 4096, (void *)servoQueue, 10, NULL, 1);
-    xTaskCreatePinnedToCore(&i2cQueueTask, "i2c_queue_task", 3072, (void *)i2cQueue, 8, NULL, 1);
-    xTaskCreatePinnedToCore(&gpioQueueTask, "gpio_queue_task", 3072, (void *)gpioQueue, 8, NULL, 1);
+    xTaskCreatePinnedToCore(&ioQueueTask, "io_queue_task", 4096, NULL, 8, NULL, 1);
+    // Below the I2C / GPIO task: queueing a write never waits on the bus.
+    xTaskCreatePinnedToCore(&i2cEngineTask, "i2c_engine_task", 4096, NULL, 7, NULL, 1);
     if (xTaskCreatePinnedToCore(&otaReceiverTask, "ota_receiver_task", 4096, (void *)otaQueue, 6, NULL, 1) != pdPASS)
     {
         ESP_LOGE(TAG, "Failed to create ota_receiver_task — aborting init");
         abort();
     }
 
+    // Writes the 8 KB staging-file blocks OtaReceiver hands off, so SD
+    // latency overlaps with serial RX and FW_CHUNK_ACKs instead of sitting
+    // in front of each ACK. Same shape and priority split as otaFlashTask;
+    // no queue means OtaReceiver writes synchronously.
+    QueueHandle_t otaStagingQueue = AstrOs_OtaReceiver.getStagingJobQueue();
+    if (otaStagingQueue != nullptr &&
+        xTaskCreatePinnedToCore(&otaStagingTask, "ota_staging_task", 4096, (void *)otaStagingQueue, 5, NULL, 1) !=
+            pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to create otaStagingTask — aborting init");
+        abort();
+    }
+
     if (isMasterNode.load())
     {
         if (xTaskCreatePinnedToCore(&otaForwarderTask, "ota_forwarder_task", 8192, (void *)otaForwarderQueue, 6, NULL,
@@ -254,6 +330,32 @@ void app_main()
         abort();
     }
 
+    // Programs the 4 KB sectors OtaWriter hands off, so flash erase/write
+    // overlaps with ESP-NOW RX and ACKs. One priority below otaWriterTask:
+    // it runs while the writer waits on the radio. No queue means
+    // OtaWriter::Init fell back to synchronous writes — nothing to drain.
+    QueueHandle_t otaFlashQueue = AstrOs_OtaWriter.getFlashJobQueue();
+    if (otaFlashQueue != nullptr &&
+        xTaskCreatePinnedToCore(&otaFlashTask, "ota_flash_task", 3072, (void *)otaFlashQueue, 5, NULL, 1) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to create otaFlashTask — aborting init");
+        abort();
+    }
+
+    // Lands the script saves handleSaveScript queues, so a multi-script
+    // deploy doesn't hold the interface queue for every SD write; the
+    // DEPLOY_SCRIPT ACK goes out from here once the file is durable. Below
+    // interface_queue_task so queuing the next script wins over writing
+    // this one. No queue means saves stay synchronous.
+    QueueHandle_t storageWriteQueue = AstrOs_Storage.getWriteJobQueue();
+    if (storageWriteQueue != nullptr &&
+        xTaskCreatePinnedToCore(&storageWriterTask, "storage_writer_task", 4096, (void *)storageWriteQueue, 5, NULL,
+                                1) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to create storageWriterTask — aborting init");
+        abort();
+    }
+
     // core 0
     xTaskCreatePinnedToCore(&astrosRxTask, "astros_rx_task", 4096, (void *)animationQueue, 9, NULL, 0);
     xTaskCreatePinnedToCore(&espnowQueueTask, "espnow_queue_task", 4096, (void *)espnowQueue, 10, NULL, 0);
@@ -291,6 +393,16 @@ void init(void)
     i2cQueue = xQueueCreate(16, sizeof(queue_msg_t));
     gpioQueue = xQueueCreate(10, sizeof(queue_msg_t));
     espnowQueue = xQueueCreate(QUEUE_LENGTH, sizeof(queue_espnow_msg_t));
+
+    i2cConsumer.bind(i2cQueue, &i2cItem);
+    gpioConsumer.bind(gpioQueue, &gpioItem);
+    QueueConsumer *const ioMembers[] = {&i2cConsumer, &gpioConsumer};
+    if (!ioConsumer.init(ioMembers, sizeof(ioMembers) / sizeof(ioMembers[0])))
+    {
+        ESP_LOGE(TAG, "Failed to create I2C/GPIO queue set — aborting init");
+        abort();
+    }
+
     otaQueue = xQueueCreate(16, sizeof(queue_ota_msg_t));
     if (otaQueue == NULL)
     {
@@ -309,6 +421,10 @@ void init(void)
     }
 
     ESP_ERROR_CHECK(AstrOs_Storage.Init());
+    if (!AstrOs_Storage.initWriteBehind())
+    {
+        ESP_LOGW(TAG, "Write-behind queue unavailable, saving scripts synchronously");
+    }
 
     loadConfig();
 
@@ -402,6 +518,21 @@ void init(void)
     ESP_ERROR_CHECK(I2cMod.Init());
     ESP_LOGI(TAG, "I2C Module initiated");
 
+    pcaModules.resize(PCA9685_BOARDS);
+    for (int i = 0; i < PCA9685_BOARDS; i++)
+    {
+        auto board = std::make_unique<Pca9685Module>(i, PCA9685_BASE_ADDRESS + i);
+        if (board->Init(0) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "PCA9685 module %d not found at 0x%02x", i, PCA9685_BASE_ADDRESS + i);
+            continue;
+        }
+        // queued until the I2C engine task starts
+        board->HomeServos();
+        pcaModules[i] = std::move(board);
+        ESP_LOGI(TAG, "PCA9685 module %d initiated", i);
+    }
+
     ESP_ERROR_CHECK(GpioMod.Init({GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6,
                                   GPIO_PIN_7, GPIO_PIN_8, GPIO_PIN_9}));
     ESP_LOGI(TAG, "GPIO Module initiated");
@@ -578,7 +709,7 @@ static void pollingTimerCallback(void *arg)
             polling = false;
         }
 
-        if (xQueueSend(espnowQueue, &msg, pdMS_TO_TICKS(250)) != pdTRUE)
+        if (!sendStamped(espnowQueue, msg, pdMS_TO_TICKS(250)))
         {
             ESP_LOGW(TAG, "Send espnow queue fail");
         }
@@ -590,7 +721,7 @@ static void pollingTimerCallback(void *arg)
 
         msg.eventType = SEND_REGISTRAION_REQ;
 
-        if (xQueueSend(espnowQueue, &msg, pdMS_TO_TICKS(250)) != pdTRUE)
+        if (!sendStamped(espnowQueue, msg, pdMS_TO_TICKS(250)))
         {
             ESP_LOGW(TAG, "Send espnow queue fail");
         }
@@ -626,6 +757,37 @@ static void maintenanceTimerCallback(void *arg)
                  "err-counters rx-overflow=%" PRIu32 " espnow-malloc-fail=%" PRIu32 " dispatch-malloc-fail=%" PRIu32,
                  rxOverflow, espnowMallocFail, dispatchMallocFail);
     }
+
+    // Queue payload pools: a class that ran out, or payloads too big for
+    // any block, mean heap allocations are back.
+    uint32_t poolHeapAllocs = QueuePool.heapAllocations();
+    for (size_t i = 0; i < AstrOsBlockPool::MessagePool::kClasses; i++)
+    {
+        AstrOsBlockPool::Stats pool = QueuePool.stats(i);
+        if (pool.exhausted != 0)
+        {
+            ESP_LOGW(TAG, "pool-%" PRIu32 " in-use=%" PRIu32 "/%" PRIu32 " high-water=%" PRIu32 " exhausted=%" PRIu32,
+                     pool.blockSize, pool.inUse, pool.blocks, pool.highWater, pool.exhausted);
+        }
+        else
+        {
+            ESP_LOGD(TAG, "pool-%" PRIu32 " in-use=%" PRIu32 "/%" PRIu32 " high-water=%" PRIu32, pool.blockSize,
+                     pool.inUse, pool.blocks, pool.highWater);
+        }
+    }
+    if (poolHeapAllocs != 0)
+    {
+        ESP_LOGD(TAG, "pool heap-allocations=%" PRIu32, poolHeapAllocs);
+    }
+
+    // Debug level: per-operation file latency (count / avg / max).
+    AstrOs_Storage.logOpStats();
+
+    // Debug level: per-queue batch size, depth, wait and service time since the last tick.
+    for (QueueConsumer *consumer : queueConsumers)
+    {
+        consumer->logMetrics();
+    }
 }
 
 void animationDispatchTask(void *arg)
@@ -679,58 +841,77 @@ void animationDispatchTask(void *arg)
                 {
                     ESP_LOGI(TAG, "Serial command val: %s", val.c_str());
 
-                    // replace any occurances of \n with actual new line character
-                    std::string formatted;
-                    for (size_t i = 0; i < val.size(); i++)
+                    queue_serial_msg_t serialMsg;
+                    AstrOsBlockPool::Buffer payload;
+
+                    if (cmd->packet != nullptr)
                     {
-                        if (val[i] == '\\' && i + 1 < val.size() && val[i + 1] == 'n')
+                        // Kangaroo packet serial, encoded when the script loaded
+                        serialMsg.message_id = 1;
+                        serialMsg.baudrate = cmd->packet->baudRate;
+                        serialMsg.dataSize = cmd->packet->size;
+                        payload = AstrOsBlockPool::Buffer(cmd->packet->size);
+                        serialMsg.data = payload.data();
+                        if (serialMsg.data == NULL)
                         {
-                            formatted += '\n';
-                            i++; // skip the 'n'
+                            ESP_LOGE(TAG, "Malloc serial dispatch data fail");
+                            dispatchMallocFailureCount.fetch_add(1, std::memory_order_relaxed);
+                            break;
                         }
-                        else if (val[i] == '\\' && i + 1 < val.size() && val[i + 1] == 'r')
+                        memcpy(serialMsg.data, cmd->packet->bytes.data(), cmd->packet->size);
+                    }
+                    else
+                    {
+                        // replace any occurances of \n with actual new line character
+                        std::string formatted;
+                        for (size_t i = 0; i < val.size(); i++)
                         {
-                            formatted += '\r';
-                            i++; // skip the 'r'
+                            if (val[i] == '\\' && i + 1 < val.size() && val[i + 1] == 'n')
+                            {
+                                formatted += '\n';
+                                i++; // skip the 'n'
+                            }
+                            else if (val[i] == '\\' && i + 1 < val.size() && val[i + 1] == 'r')
+                            {
+                                formatted += '\r';
+                                i++; // skip the 'r'
+                            }
+                            else
+                            {
+                                formatted += val[i];
+                            }
                         }
-                        else
+
+                        serialMsg.message_id = 0;
+                        payload = AstrOsBlockPool::Buffer(formatted.size() + 1);
+                        serialMsg.data = payload.data();
+                        if (serialMsg.data == NULL)
                         {
-                            formatted += val[i];
+                            ESP_LOGE(TAG, "Malloc serial dispatch data fail");
+                            dispatchMallocFailureCount.fetch_add(1, std::memory_order_relaxed);
+                            break;
                         }
+                        memcpy(serialMsg.data, formatted.c_str(), formatted.size());
+                        serialMsg.data[formatted.size()] = '\0';
                     }
 
-                    queue_serial_msg_t serialMsg;
-                    serialMsg.message_id = 0;
-                    serialMsg.data = (uint8_t *)malloc(formatted.size() + 1);
-                    if (serialMsg.data == NULL)
-                    {
-                        ESP_LOGE(TAG, "Malloc serial dispatch data fail");
-                        dispatchMallocFailureCount.fetch_add(1, std::memory_order_relaxed);
-                        break;
-                    }
-                    memcpy(serialMsg.data, formatted.c_str(), formatted.size());
-                    serialMsg.data[formatted.size()] = '\0';
-
                     if (module == 1)
                     {
-                        if (xQueueSend(serialCh1Queue, &serialMsg, pdMS_TO_TICKS(2000)) != pdTRUE)
+                        if (!sendPooled(serialCh1Queue, serialMsg, payload, pdMS_TO_TICKS(2000)))
                         {
                             ESP_LOGW(TAG, "Send serial queue fail");
-                            free(serialMsg.data);
                         }
                     }
                     else if (module == 2)
                     {
-                        if (xQueueSend(serialCh2Queue, &serialMsg, pdMS_TO_TICKS(2000)) != pdTRUE)
+                        if (!sendPooled(serialCh2Queue, serialMsg, payload, pdMS_TO_TICKS(2000)))
                         {
                             ESP_LOGW(TAG, "Send serial queue fail");
-                            free(serialMsg.data);
                         }
                     }
                     else
                     {
                         ESP_LOGE(TAG, "Invalid serial module %d", module);
-                        free(serialMsg.data);
                     }
                     break;
                 }
@@ -739,7 +920,8 @@ void animationDispatchTask(void *arg)
                     ESP_LOGI(TAG, "Maestro command val: %s", val.c_str());
                     queue_msg_t servoMsg;
                     servoMsg.message_id = module;
-                    servoMsg.data = (uint8_t *)malloc(val.size() + 1);
+                    AstrOsBlockPool::Buffer payload(val.size() + 1);
+                    servoMsg.data = payload.data();
                     if (servoMsg.data == NULL)
                     {
                         ESP_LOGE(TAG, "Malloc servo dispatch data fail");
@@ -749,10 +931,9 @@ void animationDispatchTask(void *arg)
                     memcpy(servoMsg.data, val.c_str(), val.size());
                     servoMsg.data[val.size()] = '\0';
 
-                    if (xQueueSend(servoQueue, &servoMsg, pdMS_TO_TICKS(2000)) != pdTRUE)
+                    if (!sendPooled(servoQueue, servoMsg, payload, pdMS_TO_TICKS(2000)))
                     {
                         ESP_LOGW(TAG, "Send servo queue fail");
-                        free(servoMsg.data);
                     }
                     break;
                 }
@@ -761,7 +942,8 @@ void animationDispatchTask(void *arg)
                     ESP_LOGI(TAG, "I2C command val: %s", val.c_str());
                     queue_msg_t i2cMsg;
                     i2cMsg.message_id = 0;
-                    i2cMsg.data = (uint8_t *)malloc(val.size() + 1);
+                    AstrOsBlockPool::Buffer payload(val.size() + 1);
+                    i2cMsg.data = payload.data();
                     if (i2cMsg.data == NULL)
                     {
                         ESP_LOGE(TAG, "Malloc i2c dispatch data fail");
@@ -771,10 +953,31 @@ void animationDispatchTask(void *arg)
                     memcpy(i2cMsg.data, val.c_str(), val.size());
                     i2cMsg.data[val.size()] = '\0';
 
-                    if (xQueueSend(i2cQueue, &i2cMsg, pdMS_TO_TICKS(2000)) != pdTRUE)
+                    if (!sendPooled(i2cQueue, i2cMsg, payload, pdMS_TO_TICKS(2000)))
+                    {
+                        ESP_LOGW(TAG, "Send i2c queue fail");
+                    }
+                    break;
+                }
+                case MODULE_TYPE::PCA9685:
+                {
+                    ESP_LOGI(TAG, "PCA9685 command val: %s", val.c_str());
+                    queue_msg_t pcaMsg;
+                    pcaMsg.message_id = 2;
+                    AstrOsBlockPool::Buffer payload(val.size() + 1);
+                    pcaMsg.data = payload.data();
+                    if (pcaMsg.data == NULL)
+                    {
+                        ESP_LOGE(TAG, "Malloc pca9685 dispatch data fail");
+                        dispatchMallocFailureCount.fetch_add(1, std::memory_order_relaxed);
+                        break;
+                    }
+                    memcpy(pcaMsg.data, val.c_str(), val.size());
+                    pcaMsg.data[val.size()] = '\0';
+
+                    if (!sendPooled(i2cQueue, pcaMsg, payload, pdMS_TO_TICKS(2000)))
                     {
                         ESP_LOGW(TAG, "Send i2c queue fail");
-                        free(i2cMsg.data);
                     }
                     break;
                 }
@@ -783,7 +986,8 @@ void animationDispatchTask(void *arg)
                     ESP_LOGI(TAG, "GPIO command val: %s", val.c_str());
                     queue_msg_t gpioMsg;
                     gpioMsg.message_id = 0;
-                    gpioMsg.data = (uint8_t *)malloc(val.size() + 1);
+                    AstrOsBlockPool::Buffer payload(val.size() + 1);
+                    gpioMsg.data = payload.data();
                     if (gpioMsg.data == NULL)
                     {
                         ESP_LOGE(TAG, "Malloc gpio dispatch data fail");
@@ -793,10 +997,9 @@ void animationDispatchTask(void *arg)
                     memcpy(gpioMsg.data, val.c_str(), val.size());
                     gpioMsg.data[val.size()] = '\0';
 
-                    if (xQueueSend(gpioQueue, &gpioMsg, pdMS_TO_TICKS(2000)) != pdTRUE)
+                    if (!sendPooled(gpioQueue, gpioMsg, payload, pdMS_TO_TICKS(2000)))
                     {
                         ESP_LOGW(TAG, "Send gpio queue fail");
-                        free(gpioMsg.data);
                     }
                     break;
                 }
@@ -910,7 +1113,7 @@ void buttonListenerTask(void *arg)
 
                     cmd.data = nullptr;
 
-                    if (xQueueSend(serviceQueue, &cmd, pdMS_TO_TICKS(500)) != pdTRUE)
+                    if (!sendStamped(serviceQueue, cmd, pdMS_TO_TICKS(500)))
                     {
                         ESP_LOGW(TAG, "Send espnow queue fail");
                     }
@@ -923,7 +1126,7 @@ void buttonListenerTask(void *arg)
                     cmd.cmd = SERVICE_COMMAND::SHOW_DISPLAY;
                     cmd.data = nullptr;
 
-                    if (xQueueSend(serviceQueue, &cmd, pdMS_TO_TICKS(500)) != pdTRUE)
+                    if (!sendStamped(serviceQueue, cmd, pdMS_TO_TICKS(500)))
                     {
                         ESP_LOGW(TAG, "Send espnow queue fail");
                     }
@@ -940,178 +1143,162 @@ void buttonListenerTask(void *arg)
 
 void interfaceResponseQueueTask(void *arg)
 {
-    QueueHandle_t serverResponseQueue;
-
-    serverResponseQueue = (QueueHandle_t)arg;
     astros_interface_response_t msg;
+    interfaceResponseConsumer.bind((QueueHandle_t)arg, &msg);
+    interfaceResponseConsumer.run();
+}
 
-    while (1)
-    {
-        if (xQueueReceive(serverResponseQueue, &(msg), 0))
-        {
-            auto highWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (highWaterMark < 500)
-            {
-                ESP_LOGW(TAG, "Server Response Queue Stack HWM: %d", highWaterMark);
-            }
-
-            switch (msg.type)
-            {
-            case AstrOsInterfaceResponseType::SEND_POLL_ACK:
-            {
-                // The interface queue's `message` field for SEND_POLL_ACK is packed by
-                // AstrOsEspNow::handlePollAck as `fingerprint<US>version<US>variant`
-                // for newer peers, or fewer pieces for older peers that omit the trailing
-                // fields (splitString strips trailing empties). Missing pieces fall back
-                // to "" — the server then skips populating its variant cache for those peers.
-                auto pieces = AstrOsStringUtils::splitString(std::string(msg.message), UNIT_SEPARATOR);
-                std::string fp = pieces.size() > 0 ? pieces[0] : "";
-                std::string ver = pieces.size() > 1 ? pieces[1] : "";
-                std::string variant = pieces.size() > 2 ? pieces[2] : "";
-                AstrOs_SerialMsgHandler.sendPollAckNak(msg.peerMac, msg.peerName, fp, ver, variant, true);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SEND_POLL_NAK:
-            {
-                AstrOs_SerialMsgHandler.sendPollAckNak(msg.peerMac, msg.peerName, "", "", "", false);
-                break;
-            }
-            case AstrOsInterfaceResponseType::REGISTRATION_SYNC:
-            {
-                handleRegistrationSync(msg);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SET_CONFIG:
-            {
-                handleSetConfig(msg);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SEND_CONFIG:
-            {
-                AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::CONFIG, msg.peerMac, msg.originationMsgId,
-                                               msg.message);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SAVE_SCRIPT:
-            {
-                handleSaveScript(msg);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SEND_SCRIPT:
-            {
-                AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::SCRIPT_DEPLOY, msg.peerMac, msg.originationMsgId,
-                                               msg.message);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SCRIPT_RUN:
-            {
-                handleRunSctipt(msg);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SEND_SCRIPT_RUN:
-            {
-                AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::SCRIPT_RUN, msg.peerMac, msg.originationMsgId,
-                                               msg.message);
-                break;
-            }
-            case AstrOsInterfaceResponseType::COMMAND:
-            {
-                handleRunCommand(msg);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SEND_COMMAND:
-            {
-                AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::COMMAND_RUN, msg.peerMac, msg.originationMsgId,
-                                               msg.message);
-                break;
-            }
-            case AstrOsInterfaceResponseType::PANIC_STOP:
-            {
-                handlePanicStop(msg);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SEND_PANIC_STOP:
-            {
-                AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::PANIC_STOP, msg.peerMac, msg.originationMsgId,
-                                               "PANIC");
-                break;
-            }
-            case AstrOsInterfaceResponseType::FORMAT_SD:
-            {
-                auto id = std::string(msg.originationMsgId);
+static void handleInterfaceResponseMsg(void *ctx, void *item)
+{
+    astros_interface_response_t &msg = *static_cast<astros_interface_response_t *>(item);
 
-                queue_svc_cmd_t cmd;
-                cmd.cmd = SERVICE_COMMAND::FORMAT_SD;
-                cmd.data = (uint8_t *)malloc(id.size() + 1); // dummy data
-                if (cmd.data == NULL)
-                {
-                    ESP_LOGE(TAG, "Malloc FORMAT_SD command data fail");
-                    dispatchMallocFailureCount.fetch_add(1, std::memory_order_relaxed);
-                    break;
-                }
-                memccpy(cmd.data, id.c_str(), 0, id.size());
-                cmd.data[id.size()] = '\0';
-                cmd.dataSize = id.size() + 1;
+    switch (msg.type)
+    {
+    case AstrOsInterfaceResponseType::SEND_POLL_ACK:
+    {
+        // The interface queue's `message` field for SEND_POLL_ACK is packed by
+        // AstrOsEspNow::handlePollAck as `fingerprint<US>version<US>variant`
+        // for newer peers, or fewer pieces for older peers that omit the trailing
+        // fields (splitString strips trailing empties). Missing pieces fall back
+        // to "" — the server then skips populating its variant cache for those peers.
+        auto pieces = AstrOsStringUtils::splitString(std::string(msg.message), UNIT_SEPARATOR);
+        std::string fp = pieces.size() > 0 ? pieces[0] : "";
+        std::string ver = pieces.size() > 1 ? pieces[1] : "";
+        std::string variant = pieces.size() > 2 ? pieces[2] : "";
+        AstrOs_SerialMsgHandler.sendPollAckNak(msg.peerMac, msg.peerName, fp, ver, variant, true);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SEND_POLL_NAK:
+    {
+        AstrOs_SerialMsgHandler.sendPollAckNak(msg.peerMac, msg.peerName, "", "", "", false);
+        break;
+    }
+    case AstrOsInterfaceResponseType::REGISTRATION_SYNC:
+    {
+        handleRegistrationSync(msg);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SET_CONFIG:
+    {
+        handleSetConfig(msg);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SEND_CONFIG:
+    {
+        AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::CONFIG, msg.peerMac, msg.originationMsgId, msg.message);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SAVE_SCRIPT:
+    {
+        handleSaveScript(msg);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SEND_SCRIPT:
+    {
+        AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::SCRIPT_DEPLOY, msg.peerMac, msg.originationMsgId, msg.message);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SCRIPT_RUN:
+    {
+        handleRunSctipt(msg);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SEND_SCRIPT_RUN:
+    {
+        AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::SCRIPT_RUN, msg.peerMac, msg.originationMsgId, msg.message);
+        break;
+    }
+    case AstrOsInterfaceResponseType::COMMAND:
+    {
+        handleRunCommand(msg);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SEND_COMMAND:
+    {
+        AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::COMMAND_RUN, msg.peerMac, msg.originationMsgId, msg.message);
+        break;
+    }
+    case AstrOsInterfaceResponseType::PANIC_STOP:
+    {
+        handlePanicStop(msg);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SEND_PANIC_STOP:
+    {
+        AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::PANIC_STOP, msg.peerMac, msg.originationMsgId, "PANIC");
+        break;
+    }
+    case AstrOsInterfaceResponseType::FORMAT_SD:
+    {
+        auto id = std::string(msg.originationMsgId);
 
-                if (xQueueSend(serviceQueue, &cmd, pdMS_TO_TICKS(500)) != pdTRUE)
-                {
-                    ESP_LOGW(TAG, "Send espnow queue fail");
-                    free(cmd.data);
-                }
-                break;
-            }
-            case AstrOsInterfaceResponseType::SEND_FORMAT_SD:
-            {
-                AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::FORMAT_SD, msg.peerMac, msg.originationMsgId,
-                                               "FORMATSD");
-                break;
-            }
-            case AstrOsInterfaceResponseType::SEND_CONFIG_ACK:
-            {
-                auto responseType = getSerialMessageType(msg.type);
-                AstrOs_SerialMsgHandler.sendBasicAckNakResponse(responseType, msg.originationMsgId, msg.peerMac,
-                                                                msg.peerName, msg.message);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SERVO_TEST:
-            {
-                handleServoTest(msg);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SEND_SERVO_TEST:
-            {
-                AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::SERVO_TEST, msg.peerMac, msg.originationMsgId,
-                                               msg.message);
-                break;
-            }
-            case AstrOsInterfaceResponseType::SEND_CONFIG_NAK:
-            case AstrOsInterfaceResponseType::SAVE_SCRIPT_ACK:
-            case AstrOsInterfaceResponseType::SAVE_SCRIPT_NAK:
-            case AstrOsInterfaceResponseType::SCRIPT_RUN_ACK:
-            case AstrOsInterfaceResponseType::SCRIPT_RUN_NAK:
-            case AstrOsInterfaceResponseType::FORMAT_SD_ACK:
-            case AstrOsInterfaceResponseType::FORMAT_SD_NAK:
-            case AstrOsInterfaceResponseType::COMMAND_ACK:
-            case AstrOsInterfaceResponseType::COMMAND_NAK:
-            case AstrOsInterfaceResponseType::SERVO_TEST_ACK:
-            {
-                auto responseType = getSerialMessageType(msg.type);
-                AstrOs_SerialMsgHandler.sendBasicAckNakResponse(responseType, msg.originationMsgId, msg.peerMac,
-                                                                msg.peerName, msg.message);
-                break;
-            }
-            default:
-                ESP_LOGE(TAG, "Unknown/Invalid message type: %d", static_cast<int>(msg.type));
-                break;
-            }
+        queue_svc_cmd_t cmd;
+        cmd.cmd = SERVICE_COMMAND::FORMAT_SD;
+        AstrOsBlockPool::Buffer payload(id.size() + 1); // dummy data
+        cmd.data = payload.data();
+        if (cmd.data == NULL)
+        {
+            ESP_LOGE(TAG, "Malloc FORMAT_SD command data fail");
+            dispatchMallocFailureCount.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        memccpy(cmd.data, id.c_str(), 0, id.size());
+        cmd.data[id.size()] = '\0';
+        cmd.dataSize = id.size() + 1;
 
-            free(msg.originationMsgId);
-            free(msg.peerMac);
-            free(msg.peerName);
-            free(msg.message);
+        if (!sendPooled(serviceQueue, cmd, payload, pdMS_TO_TICKS(500)))
+        {
+            ESP_LOGW(TAG, "Send espnow queue fail");
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        break;
+    }
+    case AstrOsInterfaceResponseType::SEND_FORMAT_SD:
+    {
+        AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::FORMAT_SD, msg.peerMac, msg.originationMsgId, "FORMATSD");
+        break;
+    }
+    case AstrOsInterfaceResponseType::SEND_CONFIG_ACK:
+    {
+        auto responseType = getSerialMessageType(msg.type);
+        AstrOs_SerialMsgHandler.sendBasicAckNakResponse(responseType, msg.originationMsgId, msg.peerMac,
+                                                        msg.peerName, msg.message);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SERVO_TEST:
+    {
+        handleServoTest(msg);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SEND_SERVO_TEST:
+    {
+        AstrOs_EspNow.sendBasicCommand(AstrOsPacketType::SERVO_TEST, msg.peerMac, msg.originationMsgId, msg.message);
+        break;
+    }
+    case AstrOsInterfaceResponseType::SEND_CONFIG_NAK:
+    case AstrOsInterfaceResponseType::SAVE_SCRIPT_ACK:
+    case AstrOsInterfaceResponseType::SAVE_SCRIPT_NAK:
+    case AstrOsInterfaceResponseType::SCRIPT_RUN_ACK:
+    case AstrOsInterfaceResponseType::SCRIPT_RUN_NAK:
+    case AstrOsInterfaceResponseType::FORMAT_SD_ACK:
+    case AstrOsInterfaceResponseType::FORMAT_SD_NAK:
+    case AstrOsInterfaceResponseType::COMMAND_ACK:
+    case AstrOsInterfaceResponseType::COMMAND_NAK:
+    case AstrOsInterfaceResponseType::SERVO_TEST_ACK:
+    {
+        auto responseType = getSerialMessageType(msg.type);
+        AstrOs_SerialMsgHandler.sendBasicAckNakResponse(responseType, msg.originationMsgId, msg.peerMac,
+                                                        msg.peerName, msg.message);
+        break;
     }
+    default:
+        ESP_LOGE(TAG, "Unknown/Invalid message type: %d", static_cast<int>(msg.type));
+        break;
+    }
+
+    QueuePool.release(msg.originationMsgId);
+    QueuePool.release(msg.peerMac);
+    QueuePool.release(msg.peerName);
+    QueuePool.release(msg.message);
 }
 
 void astrosRxTask(void *arg)
@@ -1192,142 +1379,123 @@ void astrosRxTask(void *arg)
 
 void serviceQueueTask(void *arg)
 {
+    queue_svc_cmd_t msg;
+    serviceConsumer.bind((QueueHandle_t)arg, &msg);
+    serviceConsumer.run();
+}
 
-    QueueHandle_t svcQueue;
+static void handleServiceMsg(void *ctx, void *item)
+{
+    queue_svc_cmd_t &msg = *static_cast<queue_svc_cmd_t *>(item);
+
+    switch (msg.cmd)
+    {
+    case SERVICE_COMMAND::FORMAT_SD:
+    {
+        ESP_LOGI(TAG, "Formatting SD card");
+        std::string data(reinterpret_cast<char *>(msg.data), msg.dataSize);
+        handleFormatSD(data);
+        break;
+    }
+    case SERVICE_COMMAND::SHOW_DISPLAY:
+    {
+        AstrOs_Display.displayDefault();
+        displayTimeout.store(defaultDisplayTimeout.load());
+        break;
+    }
+    case SERVICE_COMMAND::ESPNOW_DISCOVERY_MODE_ON:
+    {
+        discoveryMode.store(true);
+        AstrOs_Display.displayUpdate("Discovery", "Mode On");
+        ESP_LOGI(TAG, "Discovery mode on");
+        break;
+    }
+    case SERVICE_COMMAND::ESPNOW_DISCOVERY_MODE_OFF:
+    {
+        discoveryMode.store(false);
+        AstrOs_Display.displayDefault();
+        displayTimeout.store(defaultDisplayTimeout.load());
+        ESP_LOGI(TAG, "Discovery mode off");
+        break;
+    }
+    case SERVICE_COMMAND::ASTROS_INTERFACE_MESSAGE:
+    {
+        queue_msg_t serialMsg;
+        serialMsg.message_id = 1;
+        AstrOsBlockPool::Buffer payload(msg.dataSize + 1);
+        serialMsg.data = payload.data();
+        if (serialMsg.data == NULL)
+        {
+            ESP_LOGE(TAG, "Malloc ASTROS_INTERFACE_MESSAGE data fail");
+            dispatchMallocFailureCount.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        memcpy(serialMsg.data, msg.data, msg.dataSize);
+        serialMsg.data[msg.dataSize] = '\n';
+        serialMsg.dataSize = msg.dataSize + 1;
+
+        if (!sendPooled(serialCh1Queue, serialMsg, payload, pdMS_TO_TICKS(500)))
+        {
+            ESP_LOGW(TAG, "Sending AstrOs Interface message to serial queue fail");
+        }
+
+        break;
+    }
+    case SERVICE_COMMAND::RELOAD_CONFIG:
+    {
+        ESP_LOGI(TAG, "Reloading config");
+        loadMaestroConfigs();
+        loadGpioConfig();
+        break;
+    }
+    default:
+        break;
+    }
+
+    QueuePool.release(msg.data);
+}
+
+void animationQueueTask(void *arg)
+{
+    queue_ani_cmd_t msg;
+    animationConsumer.bind((QueueHandle_t)arg, &msg);
+    animationConsumer.run();
+}
+
+static void handleAnimationMsg(void *ctx, void *item)
+{
+    queue_ani_cmd_t &msg = *static_cast<queue_ani_cmd_t *>(item);
+
+    switch (msg.cmd)
+    {
+    case ANIMATION_COMMAND::PANIC_STOP:
+        AnimationCtrl.panicStop();
+        break;
+    case ANIMATION_COMMAND::RUN_ANIMATION:
+        AnimationCtrl.queueScript(std::string(msg.data));
+        break;
+    default:
+        break;
+    }
+}
+
+/*void hardwareQueueTask(void *arg)
+{
+
+    QueueHandle_t hardwareQueue;
+
+    hardwareQueue = (QueueHandle_t)arg;
+    queue_hw_cmd_t msg;
 
-    svcQueue = (QueueHandle_t)arg;
-    queue_svc_cmd_t msg;
     while (1)
     {
-        if (xQueueReceive(svcQueue, &(msg), 0))
+        if (xQueueReceive(hardwareQueue, &(msg), 0))
         {
-            auto highWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (highWaterMark < 500)
-            {
-                ESP_LOGW(TAG, "Service Queue Stack HWM: %d", highWaterMark);
-            }
+            ESP_LOGI(TAG, "Hardware Queue Stack HWM: %d", uxTaskGetStackHighWaterMark(NULL));
 
             switch (msg.cmd)
             {
-            case SERVICE_COMMAND::FORMAT_SD:
-            {
-                ESP_LOGI(TAG, "Formatting SD card");
-                std::string data(reinterpret_cast<char *>(msg.data), msg.dataSize);
-                handleFormatSD(data);
-                break;
-            }
-            case SERVICE_COMMAND::SHOW_DISPLAY:
-            {
-                AstrOs_Display.displayDefault();
-                displayTimeout.store(defaultDisplayTimeout.load());
-                break;
-            }
-            case SERVICE_COMMAND::ESPNOW_DISCOVERY_MODE_ON:
-            {
-                discoveryMode.store(true);
-                AstrOs_Display.displayUpdate("Discovery", "Mode On");
-                ESP_LOGI(TAG, "Discovery mode on");
-                break;
-            }
-            case SERVICE_COMMAND::ESPNOW_DISCOVERY_MODE_OFF:
-            {
-                discoveryMode.store(false);
-                AstrOs_Display.displayDefault();
-                displayTimeout.store(defaultDisplayTimeout.load());
-                ESP_LOGI(TAG, "Discovery mode off");
-                break;
-            }
-            case SERVICE_COMMAND::ASTROS_INTERFACE_MESSAGE:
-            {
-                queue_msg_t serialMsg;
-                serialMsg.message_id = 1;
-                serialMsg.data = (uint8_t *)malloc(msg.dataSize + 1);
-                if (serialMsg.data == NULL)
-                {
-                    ESP_LOGE(TAG, "Malloc ASTROS_INTERFACE_MESSAGE data fail");
-                    dispatchMallocFailureCount.fetch_add(1, std::memory_order_relaxed);
-                    break;
-                }
-                memcpy(serialMsg.data, msg.data, msg.dataSize);
-                serialMsg.data[msg.dataSize] = '\n';
-                serialMsg.dataSize = msg.dataSize + 1;
-
-                if (xQueueSend(serialCh1Queue, &serialMsg, pdMS_TO_TICKS(500)) != pdTRUE)
-                {
-                    ESP_LOGW(TAG, "Sending AstrOs Interface message to serial queue fail");
-                    free(serialMsg.data);
-                }
-
-                break;
-            }
-            case SERVICE_COMMAND::RELOAD_CONFIG:
-            {
-                ESP_LOGI(TAG, "Reloading config");
-                loadMaestroConfigs();
-                loadGpioConfig();
-                break;
-            }
-            default:
-                break;
-            }
-
-            free(msg.data);
-        }
-        vTaskDelay(pdMS_TO_TICKS(10));
-    }
-}
-
-void animationQueueTask(void *arg)
-{
-
-    QueueHandle_t animationQueue;
-
-    animationQueue = (QueueHandle_t)arg;
-    queue_ani_cmd_t msg;
-
-    while (1)
-    {
-        if (xQueueReceive(animationQueue, &(msg), 0))
-        {
-            auto highWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (highWaterMark < 500)
-            {
-                ESP_LOGW(TAG, "Animation Queue Stack HWM: %d", highWaterMark);
-            }
-
-            switch (msg.cmd)
-            {
-            case ANIMATION_COMMAND::PANIC_STOP:
-                AnimationCtrl.panicStop();
-                break;
-            case ANIMATION_COMMAND::RUN_ANIMATION:
-                AnimationCtrl.queueScript(std::string(msg.data));
-                break;
-            default:
-                break;
-            }
-        }
-        vTaskDelay(pdMS_TO_TICKS(10));
-    }
-}
-
-/*void hardwareQueueTask(void *arg)
-{
-
-    QueueHandle_t hardwareQueue;
-
-    hardwareQueue = (QueueHandle_t)arg;
-    queue_hw_cmd_t msg;
-
-    while (1)
-    {
-        if (xQueueReceive(hardwareQueue, &(msg), 0))
-        {
-            ESP_LOGI(TAG, "Hardware Queue Stack HWM: %d", uxTaskGetStackHighWaterMark(NULL));
-
-            switch (msg.cmd)
-            {
-            case HARDWARE_COMMAND::SEND_SERIAL:
+            case HARDWARE_COMMAND::SEND_SERIAL:
             {
                 queue_msg_t serialMsg = {0, 0};
                 strncpy(serialMsg.data, msg.data, sizeof(serialMsg.data));
@@ -1376,190 +1544,155 @@ void animationQueueTask(void *arg)
 
 void serialCh1QueueTask(void *arg)
 {
-    QueueHandle_t serialCh1Queue;
-
-    serialCh1Queue = (QueueHandle_t)arg;
     queue_serial_msg_t msg;
+    serialCh1Consumer.bind((QueueHandle_t)arg, &msg);
+    serialCh1Consumer.run();
+}
 
-    while (1)
-    {
-        if (xQueueReceive(serialCh1Queue, &(msg), 0))
-        {
-            auto highWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (highWaterMark < 500)
-            {
-                ESP_LOGW(TAG, "Serial CH1 Queue Stack HWM: %d", highWaterMark);
-            }
-
-            if (msg.message_id == 0)
-            {
-                SerialChannel1.SendCommand(msg.data);
-            }
-            else if (msg.message_id == 1)
-            {
-                std::string str(reinterpret_cast<char *>(msg.data), msg.dataSize);
+static void handleSerialCh1Msg(void *ctx, void *item)
+{
+    queue_serial_msg_t &msg = *static_cast<queue_serial_msg_t *>(item);
 
-                ESP_LOGD(TAG, "Serial message: %s", str.c_str());
+    if (msg.message_id == 0)
+    {
+        SerialChannel1.SendCommand(msg.data);
+    }
+    else if (msg.message_id == 1)
+    {
+        std::string str(reinterpret_cast<char *>(msg.data), msg.dataSize);
 
-                SerialChannel1.SendBytes(msg.baudrate, msg.data, msg.dataSize);
-            }
+        ESP_LOGD(TAG, "Serial message: %s", str.c_str());
 
-            free(msg.data);
-        }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        SerialChannel1.SendBytes(msg.baudrate, msg.data, msg.dataSize);
     }
+
+    QueuePool.release(msg.data);
 }
 
 void serialCh2QueueTask(void *arg)
 {
-    QueueHandle_t serialCh2Queue;
-
-    serialCh2Queue = (QueueHandle_t)arg;
     queue_serial_msg_t msg;
+    serialCh2Consumer.bind((QueueHandle_t)arg, &msg);
+    serialCh2Consumer.run();
+}
 
-    while (1)
-    {
-        if (xQueueReceive(serialCh2Queue, &(msg), 0))
-        {
-            auto highWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (highWaterMark < 500)
-            {
-                ESP_LOGW(TAG, "Serial CH2 Queue Stack HWM: %d", highWaterMark);
-            }
-
-            if (msg.message_id == 0)
-            {
-                SerialChannel2.SendCommand(msg.data);
-            }
-            else if (msg.message_id == 1)
-            {
-                std::string str(reinterpret_cast<char *>(msg.data), msg.dataSize);
+static void handleSerialCh2Msg(void *ctx, void *item)
+{
+    queue_serial_msg_t &msg = *static_cast<queue_serial_msg_t *>(item);
 
-                ESP_LOGD(TAG, "Serial message: %s", str.c_str());
-                SerialChannel2.SendBytes(msg.baudrate, msg.data, msg.dataSize);
-            }
+    if (msg.message_id == 0)
+    {
+        SerialChannel2.SendCommand(msg.data);
+    }
+    else if (msg.message_id == 1)
+    {
+        std::string str(reinterpret_cast<char *>(msg.data), msg.dataSize);
 
-            free(msg.data);
-        }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        ESP_LOGD(TAG, "Serial message: %s", str.c_str());
+        SerialChannel2.SendBytes(msg.baudrate, msg.data, msg.dataSize);
     }
+
+    QueuePool.release(msg.data);
 }
 
 void servoQueueTask(void *arg)
 {
-    QueueHandle_t pwmQueue;
-
-    pwmQueue = (QueueHandle_t)arg;
     queue_msg_t msg;
+    servoConsumer.bind((QueueHandle_t)arg, &msg);
+    servoConsumer.run();
+}
 
-    while (1)
-    {
-        if (xQueueReceive(pwmQueue, &(msg), 0))
+static void handleServoMsg(void *ctx, void *item)
+{
+    queue_msg_t &msg = *static_cast<queue_msg_t *>(item);
+
+    ESP_LOGD(TAG, "Servo Command received on queue => %s", msg.data);
+
+    // Snapshot the target module under maestroModulesMutex, then
+    // release before calling QueueCommand(): QueueCommand ultimately
+    // calls sendQueueMsg() which spins on a per-module mutex and
+    // blocks on queue sends. Holding the map mutex across that would
+    // stall loadMaestroConfigs() and other callers of the map. The
+    // shared_ptr keeps the module alive for the duration of the call
+    // even if a concurrent config reload removes it from the map.
+    std::shared_ptr<MaestroModule> target;
+    if (xSemaphoreTake(maestroModulesMutex, pdMS_TO_TICKS(1000)) == pdTRUE)
+    {
+        auto it = maestroModules.find(msg.message_id);
+        if (it == maestroModules.end())
         {
-            auto highWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (highWaterMark < 500)
-            {
-                ESP_LOGW(TAG, "Servo Queue Stack HWM: %d", highWaterMark);
-            }
-
-            ESP_LOGD(TAG, "Servo Command received on queue => %s", msg.data);
-
-            // Snapshot the target module under maestroModulesMutex, then
-            // release before calling QueueCommand(): QueueCommand ultimately
-            // calls sendQueueMsg() which spins on a per-module mutex and
-            // blocks on queue sends. Holding the map mutex across that would
-            // stall loadMaestroConfigs() and other callers of the map. The
-            // shared_ptr keeps the module alive for the duration of the call
-            // even if a concurrent config reload removes it from the map.
-            std::shared_ptr<MaestroModule> target;
-            if (xSemaphoreTake(maestroModulesMutex, pdMS_TO_TICKS(1000)) == pdTRUE)
-            {
-                auto it = maestroModules.find(msg.message_id);
-                if (it == maestroModules.end())
-                {
-                    ESP_LOGE(TAG, "Maestro module %d not found", msg.message_id);
-                }
-                else
-                {
-                    target = it->second;
-                }
-                xSemaphoreGive(maestroModulesMutex);
-            }
-            else
-            {
-                ESP_LOGW(TAG, "servoQueueTask: failed to acquire maestroModulesMutex within 1s");
-            }
-
-            if (target)
-            {
-                target->QueueCommand(msg.data);
-            }
-            free(msg.data);
+            ESP_LOGE(TAG, "Maestro module %d not found", msg.message_id);
         }
+        else
+        {
+            target = it->second;
+        }
+        xSemaphoreGive(maestroModulesMutex);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "servoQueueTask: failed to acquire maestroModulesMutex within 1s");
+    }
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+    if (target)
+    {
+        target->QueueCommand(msg.data);
     }
+    QueuePool.release(msg.data);
 }
 
-void i2cQueueTask(void *arg)
+// I2C and GPIO commands share one task through a queue set (see init()).
+void ioQueueTask(void *arg)
 {
-    QueueHandle_t i2cQueue;
-
-    i2cQueue = (QueueHandle_t)arg;
-    queue_msg_t msg;
+    ioConsumer.run();
+}
 
-    while (1)
-    {
-        if (xQueueReceive(i2cQueue, &(msg), 0))
-        {
-            auto highWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (highWaterMark < 500)
-            {
-                ESP_LOGW(TAG, "I2C Queue Stack HWM: %d", highWaterMark);
-            }
+// Runs the I2C writes and display updates queued by I2cModule.
+void i2cEngineTask(void *arg)
+{
+    I2cBus.run();
+}
 
-            ESP_LOGI(TAG, "I2C Command received on queue => %d, %s", msg.message_id, msg.data);
+static void handleI2cMsg(void *ctx, void *item)
+{
+    queue_msg_t &msg = *static_cast<queue_msg_t *>(item);
 
-            if (msg.message_id == 0)
-            {
-                I2cMod.SendCommand(msg.data);
-            }
-            else if (msg.message_id == 1)
-            {
-                I2cMod.WriteDisplay(msg.data);
-            }
+    ESP_LOGI(TAG, "I2C Command received on queue => %d, %s", msg.message_id, msg.data);
 
-            free(msg.data);
+    if (msg.message_id == 0)
+    {
+        I2cMod.SendCommand(msg.data);
+    }
+    else if (msg.message_id == 1)
+    {
+        I2cMod.WriteDisplay(msg.data);
+    }
+    else if (msg.message_id == 2)
+    {
+        MaestroCommand cmd = MaestroCommand(std::string(reinterpret_cast<char *>(msg.data)));
+        int idx = atoi(cmd.controller.c_str());
+        if (idx >= 0 && idx < (int)pcaModules.size() && pcaModules[idx] != nullptr)
+        {
+            pcaModules[idx]->QueueCommand(msg.data);
+        }
+        else
+        {
+            ESP_LOGE(TAG, "PCA9685 module %d not found", idx);
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
+
+    QueuePool.release(msg.data);
 }
 
-void gpioQueueTask(void *arg)
+static void handleGpioMsg(void *ctx, void *item)
 {
-    QueueHandle_t gpioQueue;
+    queue_msg_t &msg = *static_cast<queue_msg_t *>(item);
 
-    gpioQueue = (QueueHandle_t)arg;
-    queue_msg_t msg;
+    ESP_LOGD(TAG, "GPIO Command received on queue => %d, %s", msg.message_id, msg.data);
 
-    while (1)
-    {
-        if (xQueueReceive(gpioQueue, &(msg), 0))
-        {
-            auto highWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (highWaterMark < 500)
-            {
-                ESP_LOGW(TAG, "GPIO Queue Stack HWM: %d", highWaterMark);
-            }
-
-            ESP_LOGD(TAG, "GPIO Command received on queue => %d, %s", msg.message_id, msg.data);
+    GpioMod.SendCommand(msg.data);
 
-            GpioMod.SendCommand(msg.data);
-
-            free(msg.data);
-        }
-        vTaskDelay(pdMS_TO_TICKS(10));
-    }
+    QueuePool.release(msg.data);
 }
 
 void otaReceiverTask(void *arg)
@@ -1584,6 +1717,26 @@ void otaReceiverTask(void *arg)
     }
 }
 
+void otaStagingTask(void *arg)
+{
+    QueueHandle_t queue = (QueueHandle_t)arg;
+    ota_staging_job_t job;
+
+    while (true)
+    {
+        if (xQueueReceive(queue, &job, portMAX_DELAY) == pdTRUE)
+        {
+            AstrOs_OtaReceiver.processStagingJob(job);
+        }
+
+        UBaseType_t hwm = uxTaskGetStackHighWaterMark(NULL);
+        if (hwm < 500)
+        {
+            ESP_LOGW(TAG, "OTA Staging Stack HWM: %u", (unsigned int)hwm);
+        }
+    }
+}
+
 void otaForwarderTask(void *arg)
 {
     QueueHandle_t queue = (QueueHandle_t)arg;
@@ -1626,12 +1779,48 @@ void otaWriterTask(void *arg)
     }
 }
 
-void espnowQueueTask(void *arg)
+void storageWriterTask(void *arg)
+{
+    QueueHandle_t queue = (QueueHandle_t)arg;
+    uint8_t wake;
+
+    while (true)
+    {
+        if (xQueueReceive(queue, &wake, portMAX_DELAY) == pdTRUE)
+        {
+            AstrOs_Storage.processWriteJobs();
+        }
+
+        UBaseType_t hwm = uxTaskGetStackHighWaterMark(NULL);
+        if (hwm < 500)
+        {
+            ESP_LOGW(TAG, "Storage Writer Stack HWM: %u", (unsigned int)hwm);
+        }
+    }
+}
+
+void otaFlashTask(void *arg)
 {
-    QueueHandle_t espnowQueue;
+    QueueHandle_t queue = (QueueHandle_t)arg;
+    ota_flash_job_t job;
 
-    espnowQueue = (QueueHandle_t)arg;
+    while (true)
+    {
+        if (xQueueReceive(queue, &job, portMAX_DELAY) == pdTRUE)
+        {
+            AstrOs_OtaWriter.processFlashJob(job);
+        }
+
+        UBaseType_t hwm = uxTaskGetStackHighWaterMark(NULL);
+        if (hwm < 500)
+        {
+            ESP_LOGW(TAG, "OTA Flash Stack HWM: %u", (unsigned int)hwm);
+        }
+    }
+}
 
+void espnowQueueTask(void *arg)
+{
     vTaskDelay(pdMS_TO_TICKS(5 * 1000));
 
     ESP_LOGI(TAG, "ESP-NOW Queue started");
@@ -1640,87 +1829,79 @@ void espnowQueueTask(void *arg)
     displayTimeout.store(defaultDisplayTimeout.load());
 
     queue_espnow_msg_t msg;
+    espnowConsumer.bind((QueueHandle_t)arg, &msg);
+    espnowConsumer.run();
+}
 
-    while (1)
+static void handleEspnowMsg(void *ctx, void *item)
+{
+    queue_espnow_msg_t &msg = *static_cast<queue_espnow_msg_t *>(item);
+
+    switch (msg.eventType)
+    {
+    case SEND_REGISTRAION_REQ:
     {
-        if (xQueueReceive(espnowQueue, &(msg), 0))
+        AstrOs_EspNow.sendRegistrationRequest();
+        break;
+    }
+    case POLL_PADAWANS:
+    {
+        AstrOs_EspNow.pollPadawans();
+        break;
+    }
+    case EXPIRE_POLLS:
+    {
+        AstrOs_EspNow.pollRepsonseTimeExpired();
+        break;
+    }
+    case ESPNOW_SEND:
+    {
+        ESP_LOGD(TAG, "Send data to " MACSTR, MAC2STR(msg.dest));
+
+        // Route through the in-flight-counted send so this path's
+        // send-done callback has a matching increment — espnowSendCallback
+        // calls notifyTxComplete() unconditionally, so an uncounted send
+        // here would drift espnowTxInFlight_ negative and disable OTA
+        // throttling.
+        if (AstrOs_EspNow.sendCounted(msg.dest, msg.data, msg.data_len) != ESP_OK)
         {
-            auto highWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (highWaterMark < 500)
-            {
-                ESP_LOGW(TAG, "ESP-NOW Queue Stack HWM: %d", highWaterMark);
-            }
+            ESP_LOGE(TAG, "Send error");
+        }
 
-            switch (msg.eventType)
-            {
-            case SEND_REGISTRAION_REQ:
-            {
-                AstrOs_EspNow.sendRegistrationRequest();
-                break;
-            }
-            case POLL_PADAWANS:
-            {
-                AstrOs_EspNow.pollPadawans();
-                break;
-            }
-            case EXPIRE_POLLS:
-            {
-                AstrOs_EspNow.pollRepsonseTimeExpired();
-                break;
-            }
-            case ESPNOW_SEND:
-            {
-                ESP_LOGD(TAG, "Send data to " MACSTR, MAC2STR(msg.dest));
-
-                // Route through the in-flight-counted send so this path's
-                // send-done callback has a matching increment — espnowSendCallback
-                // calls notifyTxComplete() unconditionally, so an uncounted send
-                // here would drift espnowTxInFlight_ negative and disable OTA
-                // throttling.
-                if (AstrOs_EspNow.sendCounted(msg.dest, msg.data, msg.data_len) != ESP_OK)
-                {
-                    ESP_LOGE(TAG, "Send error");
-                }
+        break;
+    }
+    case ESPNOW_RECV:
+    {
+        if (IS_BROADCAST_ADDR(msg.dest))
+        {
+            ESP_LOGD(TAG, "Received broadcast data from: " MACSTR ", len: %d", MAC2STR(msg.src), msg.data_len);
 
-                break;
-            }
-            case ESPNOW_RECV:
+            // only handle broadcast messages in discovery mode
+            if (!discoveryMode.load())
             {
-                if (IS_BROADCAST_ADDR(msg.dest))
-                {
-                    ESP_LOGD(TAG, "Received broadcast data from: " MACSTR ", len: %d", MAC2STR(msg.src), msg.data_len);
-
-                    // only handle broadcast messages in discovery mode
-                    if (!discoveryMode.load())
-                    {
-                        break;
-                    }
-
-                    AstrOs_EspNow.handleMessage(msg.src, msg.data, msg.data_len);
-                }
-                else if (esp_now_is_peer_exist(msg.src))
-                {
-                    ESP_LOGD(TAG, "Received unicast data from peer: " MACSTR ", len: %d", MAC2STR(msg.src),
-                             msg.data_len);
-
-                    AstrOs_EspNow.handleMessage(msg.src, msg.data, msg.data_len);
-                }
-                else
-                {
-                    ESP_LOGW(TAG, "Peer does not exist:" MACSTR, MAC2STR(msg.src));
-                }
-                break;
-            }
-            default:
-                ESP_LOGE(TAG, "Callback type error: %d", msg.eventType);
                 break;
             }
 
-            free(msg.data);
+            AstrOs_EspNow.handleMessage(msg.src, msg.data, msg.data_len);
         }
+        else if (esp_now_is_peer_exist(msg.src))
+        {
+            ESP_LOGD(TAG, "Received unicast data from peer: " MACSTR ", len: %d", MAC2STR(msg.src), msg.data_len);
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+            AstrOs_EspNow.handleMessage(msg.src, msg.data, msg.data_len);
+        }
+        else
+        {
+            ESP_LOGW(TAG, "Peer does not exist:" MACSTR, MAC2STR(msg.src));
+        }
+        break;
+    }
+    default:
+        ESP_LOGE(TAG, "Callback type error: %d", msg.eventType);
+        break;
     }
+
+    QueuePool.release(msg.data);
 }
 
 #pragma endregion
@@ -1728,9 +1909,9 @@ void espnowQueueTask(void *arg)
 
 static void loadConfig()
 {
-    auto cfig = AstrOs_Storage.readFile("config.txt");
+    std::string cfig;
 
-    if (cfig != "error")
+    if (AstrOs_Storage.readFile("config.txt", cfig).ok)
     {
         ESP_LOGI(TAG, "Service config file: %s", cfig.c_str());
 
@@ -1783,6 +1964,7 @@ static void loadMaestroConfigs()
         std::shared_ptr<MaestroModule> module;
         QueueHandle_t queue;
         int baudrate;
+        SerialModule *readback;
     };
     std::vector<PendingUpdate> pendingUpdates;
     std::vector<std::shared_ptr<MaestroModule>> toInitialize;
@@ -1817,11 +1999,11 @@ static void loadMaestroConfigs()
             }
             else if (cfg.uartChannel == 1)
             {
-                pendingUpdates.push_back({existing->second, serialCh1Queue, cfg.baudrate});
+                pendingUpdates.push_back({existing->second, serialCh1Queue, cfg.baudrate, MAESTRO_READBACK_CH1});
             }
             else if (cfg.uartChannel == 2)
             {
-                pendingUpdates.push_back({existing->second, serialCh2Queue, cfg.baudrate});
+                pendingUpdates.push_back({existing->second, serialCh2Queue, cfg.baudrate, MAESTRO_READBACK_CH2});
             }
             else
             {
@@ -1841,11 +2023,13 @@ static void loadMaestroConfigs()
             }
             if (cfg.uartChannel == 1)
             {
-                maestroModules[cfg.idx] = std::make_shared<MaestroModule>(serialCh1Queue, cfg.idx, cfg.baudrate);
+                maestroModules[cfg.idx] =
+                    std::make_shared<MaestroModule>(serialCh1Queue, cfg.idx, cfg.baudrate, MAESTRO_READBACK_CH1);
             }
             else if (cfg.uartChannel == 2)
             {
-                maestroModules[cfg.idx] = std::make_shared<MaestroModule>(serialCh2Queue, cfg.idx, cfg.baudrate);
+                maestroModules[cfg.idx] =
+                    std::make_shared<MaestroModule>(serialCh2Queue, cfg.idx, cfg.baudrate, MAESTRO_READBACK_CH2);
             }
             else
             {
@@ -1881,7 +2065,7 @@ static void loadMaestroConfigs()
     // concurrent reload removes its map entry in between.
     for (auto &pending : pendingUpdates)
     {
-        pending.module->UpdateConfig(pending.queue, pending.baudrate);
+        pending.module->UpdateConfig(pending.queue, pending.baudrate, pending.readback);
     }
 
     // Phase 3: initialize each module (NVS read + HomeServos) outside the
@@ -1959,7 +2143,8 @@ static void espnowRecvCallback(const esp_now_recv_info_t *recv_info, const uint8
     msg.eventType = ESPNOW_RECV;
     memcpy(msg.src, src_addr, ESP_NOW_ETH_ALEN);
     memcpy(msg.dest, dest_addr, ESP_NOW_ETH_ALEN);
-    msg.data = (uint8_t *)malloc(len);
+    AstrOsBlockPool::Buffer payload(len);
+    msg.data = payload.data();
     if (msg.data == NULL)
     {
         ESP_LOGE(TAG, "Malloc receive data fail");
@@ -1968,10 +2153,9 @@ static void espnowRecvCallback(const esp_now_recv_info_t *recv_info, const uint8
     }
     memcpy(msg.data, data, len);
     msg.data_len = len;
-    if (xQueueSend(espnowQueue, &msg, pdMS_TO_TICKS(500)) != pdTRUE)
+    if (!sendPooled(espnowQueue, msg, payload, pdMS_TO_TICKS(500)))
     {
         ESP_LOGW(TAG, "Send receive queue fail");
-        free(msg.data);
     }
 }
 
@@ -2049,7 +2233,7 @@ static void handleSetConfig(astros_interface_response_t msg)
         reloadMsg.cmd = SERVICE_COMMAND::RELOAD_CONFIG;
         reloadMsg.data = nullptr;
 
-        if (xQueueSend(serviceQueue, &reloadMsg, pdMS_TO_TICKS(500)) != pdTRUE)
+        if (!sendStamped(serviceQueue, reloadMsg, pdMS_TO_TICKS(500)))
         {
             ESP_LOGW(TAG, "Send servo reload fail");
         }
@@ -2083,22 +2267,40 @@ static void handleSaveScript(astros_interface_response_t msg)
     {
         ESP_LOGE(TAG, "Invalid script message: %s", message.c_str());
     }
+    else if (AstrOs_Storage.saveFileAsync("scripts/" + parts[0], parts[1], &scriptSavedCallback, nullptr,
+                                          msg.originationMsgId))
+    {
+        // scriptSavedCallback answers once it is on the card.
+        return;
+    }
     else
     {
         success = AstrOs_Storage.saveFile("scripts/" + parts[0], parts[1]);
     }
 
+    sendScriptDeployAckNak(msg.originationMsgId, parts.empty() ? "" : parts[0], success);
+}
+
+// storage_writer_task, or whichever task superseded the queued save.
+static void scriptSavedCallback(void *ctx, const std::string &path, const std::string &msgId, bool ok)
+{
+    // path is "scripts/<id>"
+    const size_t slash = path.find('/');
+    sendScriptDeployAckNak(msgId, slash == std::string::npos ? path : path.substr(slash + 1), ok);
+}
+
+static void sendScriptDeployAckNak(const std::string &msgId, const std::string &scriptId, bool success)
+{
     if (isMasterNode.load())
     {
         auto ackNak = success ? AstrOsSerialMessageType::DEPLOY_SCRIPT_ACK : AstrOsSerialMessageType::DEPLOY_SCRIPT_NAK;
 
-        AstrOs_SerialMsgHandler.sendBasicAckNakResponse(ackNak, msg.originationMsgId, AstrOs_EspNow.getMac(), "master",
-                                                        parts[0]);
+        AstrOs_SerialMsgHandler.sendBasicAckNakResponse(ackNak, msgId, AstrOs_EspNow.getMac(), "master", scriptId);
     }
     else
     {
         auto ackNak = success ? AstrOsPacketType::SCRIPT_DEPLOY_ACK : AstrOsPacketType::SCRIPT_DEPLOY_NAK;
-        AstrOs_EspNow.sendBasicAckNak(msg.originationMsgId, ackNak, parts[0]);
+        AstrOs_EspNow.sendBasicAckNak(msgId, ackNak, scriptId);
     }
 }
 
@@ -2144,7 +2346,8 @@ static void handlePanicStop(astros_interface_response_t msg)
 
 static void handleFormatSD(std::string id)
 {
-    auto cfig = AstrOs_Storage.readFile("config.txt");
+    std::string cfig;
+    const bool haveConfig = AstrOs_Storage.readFile("config.txt", cfig).ok;
 
     esp_err_t formatErr = AstrOs_Storage.formatSdCard();
     bool success = (formatErr == ESP_OK);
@@ -2154,7 +2357,7 @@ static void handleFormatSD(std::string id)
         ESP_LOGE(TAG, "formatSdCard failed: %s", esp_err_to_name(formatErr));
     }
 
-    if (cfig != "error")
+    if (haveConfig)
     {
         AstrOs_Storage.saveFile("config.txt", cfig);
     }
@@ -182,6 +182,69 @@ TEST(AnimationCommands, GpioCommandTooFewPartsSetsSafeDefaults)
     EXPECT_FALSE(cmd.state);
 }
 
+TEST(AnimationCommands, GpioCommandSingleChannelIsNotMask)
+{
+    GpioCommand cmd("5|100|2|1");
+    EXPECT_FALSE(cmd.isMask);
+    EXPECT_EQ(0u, cmd.setMask);
+    EXPECT_EQ(0u, cmd.clearMask);
+}
+
+TEST(AnimationCommands, GpioCommandParsesMasks)
+{
+    // type|X|-2|setMask|clearMask
+    GpioCommand dec("5|100|-2|5|10");
+    EXPECT_TRUE(dec.isMask);
+    EXPECT_EQ(GpioCommand::MASK_CHANNEL, dec.channel);
+    EXPECT_EQ(5u, dec.setMask);
+    EXPECT_EQ(10u, dec.clearMask);
+
+    GpioCommand hex("5|0|-2|0x3F0|0x00F");
+    EXPECT_TRUE(hex.isMask);
+    EXPECT_EQ(0x3F0u, hex.setMask);
+    EXPECT_EQ(0x00Fu, hex.clearMask);
+
+    // all clear
+    GpioCommand off("5|0|-2|0|0x3FF");
+    EXPECT_EQ(0u, off.setMask);
+    EXPECT_EQ(0x3FFu, off.clearMask);
+}
+
+TEST(AnimationCommands, GpioCommandMaskLeadingZerosAreDecimal)
+{
+    // Not octal: "010" is channels 1 and 3, not channel 3 alone.
+    GpioCommand cmd("5|0|-2|010|0X0F0");
+    EXPECT_TRUE(cmd.isMask);
+    EXPECT_EQ(10u, cmd.setMask);
+    EXPECT_EQ(0xF0u, cmd.clearMask);
+
+    GpioCommand padded("5|0|-2|0008|0");
+    EXPECT_EQ(8u, padded.setMask);
+}
+
+TEST(AnimationCommands, GpioCommandRejectsBadMasks)
+{
+    const char *bad[] = {
+        "5|0|-2|3",             // no clear mask
+        "5|0|-2|3|6",           // channel 1 both ways
+        "5|0|-2|abc|1",         // not a number
+        "5|0|-2|1x|2",          // trailing junk
+        "5|0|-2||2",            // empty
+        "5|0|-2|-1|0",          // negative
+        "5|0|-2|0x1FFFFFFFF|0", // wider than 32 bits
+        "5|0|-2|0x|1",          // prefix only
+        "5|0|-2|0x-1|0",        // negative hex
+        "5|0|-2|08x|0",         // not hex without the prefix
+    };
+    for (const char *val : bad)
+    {
+        GpioCommand cmd(val);
+        EXPECT_TRUE(cmd.isMask) << val;
+        EXPECT_EQ(0u, cmd.setMask) << val;
+        EXPECT_EQ(0u, cmd.clearMask) << val;
+    }
+}
+
 // ---------------- SerialCommand ----------------
 
 TEST(AnimationCommands, SerialCommandParsesGenericSerial)
@@ -0,0 +1,202 @@
+#include <AstrOsBlockPool.hpp>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+using AstrOsBlockPool::BlockPool;
+using AstrOsBlockPool::Buffer;
+using AstrOsBlockPool::MessagePool;
+
+TEST(AstrOsBlockPool, HandsOutEveryBlockOnce)
+{
+    BlockPool<16, 8> pool;
+
+    std::set<void *> seen;
+    for (int i = 0; i < 8; i++)
+    {
+        void *p = pool.acquire();
+        ASSERT_NE(nullptr, p);
+        EXPECT_TRUE(pool.owns(p));
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t));
+        EXPECT_TRUE(seen.insert(p).second);
+    }
+    EXPECT_EQ(nullptr, pool.acquire());
+
+    auto s = pool.stats();
+    EXPECT_EQ(16u, s.blockSize);
+    EXPECT_EQ(8u, s.inUse);
+    EXPECT_EQ(8u, s.highWater);
+    EXPECT_EQ(1u, s.exhausted);
+
+    for (void *p : seen)
+    {
+        pool.release(p);
+    }
+    s = pool.stats();
+    EXPECT_EQ(0u, s.inUse);
+    EXPECT_EQ(8u, s.highWater);
+
+    // last in, first out
+    void *p = pool.acquire();
+    pool.release(p);
+    EXPECT_EQ(p, pool.acquire());
+
+    int onStack = 0;
+    EXPECT_FALSE(pool.owns(&onStack));
+}
+
+TEST(AstrOsBlockPool, MessagePoolPicksTheSmallestClassThatFits)
+{
+    MessagePool pool;
+
+    void *a = pool.allocate(10);
+    void *b = pool.allocate(64);
+    void *c = pool.allocate(250);
+    void *d = pool.allocate(2048);
+    EXPECT_EQ(1u, pool.stats(0).inUse);
+    EXPECT_EQ(1u, pool.stats(1).inUse);
+    EXPECT_EQ(1u, pool.stats(2).inUse);
+    EXPECT_EQ(1u, pool.stats(3).inUse);
+    EXPECT_EQ(0u, pool.heapAllocations());
+
+    // too big for any block
+    void *e = pool.allocate(4096);
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ(1u, pool.heapAllocations());
+
+    for (void *p : {a, b, c, d, e})
+    {
+        pool.release(p);
+    }
+    pool.release(nullptr);
+    for (size_t i = 0; i < MessagePool::kClasses; i++)
+    {
+        EXPECT_EQ(0u, pool.stats(i).inUse);
+        EXPECT_EQ(1u, pool.stats(i).highWater);
+    }
+}
+
+TEST(AstrOsBlockPool, MessagePoolStepsUpThenFallsBackToHeap)
+{
+    MessagePool pool;
+    const uint32_t tiny = pool.stats(0).blocks;
+    const uint32_t small = pool.stats(1).blocks;
+
+    std::vector<void *> held;
+    for (uint32_t i = 0; i < tiny + small; i++)
+    {
+        held.push_back(pool.allocate(8));
+    }
+    EXPECT_EQ(tiny, pool.stats(0).inUse);
+    EXPECT_EQ(small, pool.stats(1).inUse);
+    EXPECT_EQ(small, pool.stats(0).exhausted);
+
+    // 64-byte requests skip the tiny class and, with small empty, go to medium
+    held.push_back(pool.allocate(64));
+    EXPECT_EQ(1u, pool.stats(2).inUse);
+
+    // a 2048-byte request with the large class gone lands on the heap
+    const uint32_t large = pool.stats(3).blocks;
+    for (uint32_t i = 0; i < large + 1; i++)
+    {
+        held.push_back(pool.allocate(2048));
+    }
+    EXPECT_EQ(1u, pool.heapAllocations());
+
+    for (void *p : held)
+    {
+        pool.release(p);
+    }
+    for (size_t i = 0; i < MessagePool::kClasses; i++)
+    {
+        EXPECT_EQ(0u, pool.stats(i).inUse);
+    }
+}
+
+TEST(AstrOsBlockPool, BufferTransfersOwnership)
+{
+    const uint32_t before = QueuePool.stats(1).inUse;
+    {
+        Buffer dropped(40);
+        ASSERT_TRUE(dropped);
+        EXPECT_EQ(before + 1, QueuePool.stats(1).inUse);
+    }
+    EXPECT_EQ(before, QueuePool.stats(1).inUse);
+
+    Buffer a(40);
+    Buffer b(std::move(a));
+    EXPECT_FALSE(a);
+    ASSERT_TRUE(b);
+
+    // handed on, e.g. into a queue message; the consumer releases it
+    uint8_t *sent = b.release();
+    EXPECT_FALSE(b);
+    EXPECT_EQ(before + 1, QueuePool.stats(1).inUse);
+    QueuePool.release(sent);
+    EXPECT_EQ(before, QueuePool.stats(1).inUse);
+}
+
+// Threads take and return blocks as fast as they can, each stamping the
+// block it holds; a block handed out twice shows up as a torn stamp.
+TEST(AstrOsBlockPool, StressNoBlockHeldTwice)
+{
+    static BlockPool<64, 16> pool;
+    constexpr int kThreads = 8;
+    constexpr int kRounds = 200000;
+
+    std::atomic<int> torn{0};
+    std::atomic<int> empty{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++)
+    {
+        threads.emplace_back(
+            [t, &torn, &empty]()
+            {
+                uint8_t stamp[64];
+                memset(stamp, t + 1, sizeof(stamp));
+                for (int i = 0; i < kRounds; i++)
+                {
+                    void *p = pool.acquire();
+                    if (p == nullptr)
+                    {
+                        empty.fetch_add(1);
+                        continue;
+                    }
+                    memcpy(p, stamp, sizeof(stamp));
+                    if (i % 7 == 0)
+                    {
+                        std::this_thread::yield();
+                    }
+                    if (memcmp(p, stamp, sizeof(stamp)) != 0)
+                    {
+                        torn.fetch_add(1);
+                    }
+                    pool.release(p);
+                }
+            });
+    }
+    for (auto &th : threads)
+    {
+        th.join();
+    }
+
+    EXPECT_EQ(0, torn.load());
+    auto s = pool.stats();
+    EXPECT_EQ(0u, s.inUse);
+    EXPECT_LE(s.highWater, 16u);
+    EXPECT_EQ(static_cast<uint32_t>(empty.load()), s.exhausted);
+
+    // every block made it back to the free list
+    std::set<void *> seen;
+    for (int i = 0; i < 16; i++)
+    {
+        void *p = pool.acquire();
+        ASSERT_NE(nullptr, p);
+        EXPECT_TRUE(seen.insert(p).second);
+    }
+    EXPECT_EQ(nullptr, pool.acquire());
+}
@@ -0,0 +1,215 @@
+#include <AstrOsConfigCache.hpp>
+#include <AstrOsFileUtils.hpp>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+using AstrOsConfigCache::Snapshot;
+using AstrOsConfigCache::Status;
+
+namespace
+{
+    // 24 channels, as the UI sends for a Mini Maestro 24.
+    std::string servoText(int seed)
+    {
+        std::string text;
+        for (int ch = 0; ch < 24; ch++)
+        {
+            const int min = 500 + (ch * 7 + seed) % 200;
+            const int max = 2300 + (ch * 13 + seed) % 200;
+            text += std::to_string(ch) + ":" + std::to_string((ch + seed) % 2) + ":1:" + std::to_string(min) + ":" +
+                    std::to_string(max) + ":1500:" + std::to_string(ch % 3 == 0 ? 1 : 0) + "|";
+        }
+        return text;
+    }
+
+    struct TextConfig
+    {
+        std::string gpio = "1|0|0|1|0|0|0|0|1|0";
+        std::string maestros;
+        std::map<int, std::string> servos;
+    };
+
+    TextConfig textConfig(int maestroCount)
+    {
+        TextConfig t;
+        for (int i = 0; i < maestroCount; i++)
+        {
+            t.maestros += std::to_string(i) + ":" + std::to_string(1 + i % 2) + ":57600\n";
+            t.servos[i] = servoText(i);
+        }
+        return t;
+    }
+
+    void expectSameChannels(const std::vector<servo_channel> &a, const std::vector<servo_channel> &b)
+    {
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            SCOPED_TRACE(i);
+            EXPECT_EQ(a[i].id, b[i].id);
+            EXPECT_EQ(a[i].enabled, b[i].enabled);
+            EXPECT_EQ(a[i].isServo, b[i].isServo);
+            EXPECT_EQ(a[i].minPos, b[i].minPos);
+            EXPECT_EQ(a[i].maxPos, b[i].maxPos);
+            EXPECT_EQ(a[i].home, b[i].home);
+            EXPECT_EQ(a[i].currentPos, b[i].currentPos);
+            EXPECT_EQ(a[i].requestedPos, b[i].requestedPos);
+            EXPECT_EQ(a[i].lastPos, b[i].lastPos);
+            EXPECT_EQ(a[i].speed, b[i].speed);
+            EXPECT_EQ(a[i].acceleration, b[i].acceleration);
+            EXPECT_EQ(a[i].inverted, b[i].inverted);
+            EXPECT_EQ(a[i].on, b[i].on);
+        }
+    }
+
+    void expectSameSnapshot(const Snapshot &a, const Snapshot &b)
+    {
+        EXPECT_EQ(a.gpio, b.gpio);
+        ASSERT_EQ(a.maestros.size(), b.maestros.size());
+        ASSERT_EQ(a.servos.size(), b.servos.size());
+        for (size_t i = 0; i < a.maestros.size(); i++)
+        {
+            SCOPED_TRACE(i);
+            EXPECT_EQ(a.maestros[i].idx, b.maestros[i].idx);
+            EXPECT_EQ(a.maestros[i].uartChannel, b.maestros[i].uartChannel);
+            EXPECT_EQ(a.maestros[i].baudrate, b.maestros[i].baudrate);
+            expectSameChannels(a.servos[i], b.servos[i]);
+        }
+    }
+
+    std::vector<uint8_t> encoded(const Snapshot &s)
+    {
+        std::vector<uint8_t> blob;
+        EXPECT_EQ(Status::OK, AstrOsConfigCache::encode(s, blob));
+        return blob;
+    }
+} // namespace
+
+TEST(AstrOsConfigCache, FromTextMatchesTheFileParsers)
+{
+    const TextConfig t = textConfig(2);
+    const Snapshot s = AstrOsConfigCache::fromText(t.gpio, t.maestros, t.servos);
+
+    EXPECT_EQ(AstrOsFileUtils::parseGpioConfig(t.gpio), s.gpio);
+    ASSERT_EQ(2u, s.maestros.size());
+    EXPECT_EQ(2, s.maestros[1].uartChannel);
+    expectSameChannels(AstrOsFileUtils::parseServoConfig(t.servos.at(1)), *s.servosFor(1));
+    EXPECT_EQ(nullptr, s.servosFor(7));
+}
+
+TEST(AstrOsConfigCache, RoundTripsAndIgnoresTrailingBytes)
+{
+    const TextConfig t = textConfig(3);
+    const Snapshot s = AstrOsConfigCache::fromText(t.gpio, t.maestros, t.servos);
+    std::vector<uint8_t> blob = encoded(s);
+    ASSERT_LE(blob.size(), AstrOsConfigCache::kMaxEncodedSize);
+
+    // Older firmware's SD backend stored a NUL after the file.
+    blob.push_back(0);
+
+    Snapshot out;
+    ASSERT_EQ(Status::OK, AstrOsConfigCache::decode(blob.data(), blob.size(), out));
+    expectSameSnapshot(s, out);
+}
+
+TEST(AstrOsConfigCache, EmptyConfigRoundTrips)
+{
+    const Snapshot s = AstrOsConfigCache::fromText("", "", {});
+    const std::vector<uint8_t> blob = encoded(s);
+
+    Snapshot out;
+    ASSERT_EQ(Status::OK, AstrOsConfigCache::decode(blob.data(), blob.size(), out));
+    EXPECT_EQ(std::vector<bool>(10, false), out.gpio);
+    EXPECT_TRUE(out.maestros.empty());
+}
+
+TEST(AstrOsConfigCache, RejectsDamagedBlobsWithoutTouchingOutput)
+{
+    const TextConfig t = textConfig(2);
+    const std::vector<uint8_t> good = encoded(AstrOsConfigCache::fromText(t.gpio, t.maestros, t.servos));
+
+    Snapshot out;
+    out.gpio = {true};
+
+    auto decodeWith = [&](size_t at, uint8_t flip) {
+        std::vector<uint8_t> bad = good;
+        bad[at] ^= flip;
+        return AstrOsConfigCache::decode(bad.data(), bad.size(), out);
+    };
+
+    EXPECT_EQ(Status::BAD_MAGIC, decodeWith(0, 0x01));
+    EXPECT_EQ(Status::BAD_VERSION, decodeWith(4, 0x01));
+    EXPECT_EQ(Status::BAD_LAYOUT, decodeWith(6, 0x01));
+    EXPECT_EQ(Status::BAD_LENGTH, decodeWith(12, 0x01)); // payload length past the buffer
+    EXPECT_EQ(Status::BAD_CRC, decodeWith(good.size() - 5, 0x40));
+    EXPECT_EQ(Status::TOO_SHORT, AstrOsConfigCache::decode(good.data(), 8, out));
+    EXPECT_EQ(Status::BAD_LENGTH, AstrOsConfigCache::decode(good.data(), good.size() - 1, out));
+
+    EXPECT_EQ(std::vector<bool>{true}, out.gpio);
+}
+
+TEST(AstrOsConfigCache, EncodeRefusesOversizedConfigs)
+{
+    Snapshot s;
+    s.gpio.assign(AstrOsConfigCache::kMaxGpio + 1, false);
+    std::vector<uint8_t> blob = {0xAA};
+    EXPECT_EQ(Status::TOO_LARGE, AstrOsConfigCache::encode(s, blob));
+    EXPECT_EQ(std::vector<uint8_t>{0xAA}, blob);
+
+    s.gpio.clear();
+    s.maestros.push_back(maestro_config{0, 1, 57600});
+    s.servos.push_back(std::vector<servo_channel>(AstrOsConfigCache::kMaxChannels + 1));
+    EXPECT_EQ(Status::TOO_LARGE, AstrOsConfigCache::encode(s, blob));
+}
+
+// What boot does with each form of the same config: parse the GPIO,
+// modules and per-module servo text, or decode the blob. Disabled by
+// default (timing, not correctness); run with
+//   --gtest_also_run_disabled_tests --gtest_filter=AstrOsConfigCache.DISABLED_BootLoad*
+TEST(AstrOsConfigCache, DISABLED_BootLoadTextVsBinary)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr int kRuns = 2000;
+
+    for (int maestroCount : {1, 4, 8})
+    {
+        const TextConfig t = textConfig(maestroCount);
+        const std::vector<uint8_t> blob = encoded(AstrOsConfigCache::fromText(t.gpio, t.maestros, t.servos));
+
+        size_t sinkText = 0;
+        auto t0 = Clock::now();
+        for (int run = 0; run < kRuns; run++)
+        {
+            sinkText += AstrOsFileUtils::parseGpioConfig(t.gpio).size();
+            for (const maestro_config &m : AstrOsFileUtils::parseMaestroConfig(t.maestros))
+            {
+                sinkText += AstrOsFileUtils::parseServoConfig(t.servos.at(m.idx)).size();
+            }
+        }
+        const double textUs = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / kRuns;
+
+        size_t sinkBinary = 0;
+        t0 = Clock::now();
+        for (int run = 0; run < kRuns; run++)
+        {
+            Snapshot s;
+            ASSERT_EQ(Status::OK, AstrOsConfigCache::decode(blob.data(), blob.size(), s));
+            sinkBinary += s.gpio.size();
+            for (const auto &channels : s.servos)
+            {
+                sinkBinary += channels.size();
+            }
+        }
+        const double binaryUs = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / kRuns;
+
+        EXPECT_EQ(sinkText, sinkBinary);
+        std::printf("[ CONFIG   ] maestros=%d  text %8.2f us  binary %6.2f us (%zu B)  x%.1f\n", maestroCount,
+                    textUs, binaryUs, blob.size(), textUs / binaryUs);
+    }
+}
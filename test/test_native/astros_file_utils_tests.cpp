@@ -72,3 +72,15 @@ TEST(FileUtils, ParseServoConfig)
     EXPECT_FALSE(channels[2].inverted);
     EXPECT_FALSE(channels[2].on);
 }
+
+TEST(FileUtils, ParseGpioConfig)
+{
+    auto levels = AstrOsFileUtils::parseGpioConfig("1|0|1|");
+    ASSERT_EQ(3u, levels.size());
+    EXPECT_TRUE(levels[0]);
+    EXPECT_FALSE(levels[1]);
+    EXPECT_TRUE(levels[2]);
+
+    // No file: the 10 onboard channels, all low.
+    EXPECT_EQ(std::vector<bool>(10, false), AstrOsFileUtils::parseGpioConfig(""));
+}
@@ -0,0 +1,140 @@
+#include <AstrOsI2cBatch.hpp>
+#include <gtest/gtest.h>
+
+using AstrOsI2cBatch::Kind;
+using AstrOsI2cBatch::Transaction;
+using AstrOsI2cBatch::Write;
+using AstrOsI2cBatch::WriteBatcher;
+
+namespace
+{
+    int tags[64];
+
+    Write reg(uint8_t addr, uint8_t reg, uint8_t len, int tag)
+    {
+        return Write{addr, Kind::Register, reg, len, &tags[tag]};
+    }
+
+    Write raw(uint8_t addr, uint8_t len, int tag)
+    {
+        return Write{addr, Kind::Raw, 0, len, &tags[tag]};
+    }
+} // namespace
+
+TEST(AstrOsI2cBatch, ContiguousRegisterWritesMerge)
+{
+    WriteBatcher b;
+    ASSERT_TRUE(b.push(reg(0x40, 0x06, 4, 0)));
+    ASSERT_TRUE(b.push(reg(0x40, 0x0A, 4, 1)));
+    ASSERT_TRUE(b.push(reg(0x40, 0x0E, 4, 2)));
+    // Gap: starts a new transaction.
+    ASSERT_TRUE(b.push(reg(0x40, 0x16, 4, 3)));
+
+    Transaction t;
+    ASSERT_TRUE(b.next(t));
+    EXPECT_EQ(0x40, t.addr);
+    EXPECT_EQ(Kind::Register, t.kind);
+    EXPECT_EQ(0x06, t.reg);
+    EXPECT_EQ(12, t.len);
+    ASSERT_EQ(3u, t.count);
+    EXPECT_EQ(&tags[0], t.tags[0]);
+    EXPECT_EQ(&tags[2], t.tags[2]);
+
+    ASSERT_TRUE(b.next(t));
+    EXPECT_EQ(0x16, t.reg);
+    EXPECT_EQ(1u, t.count);
+    EXPECT_FALSE(b.next(t));
+    EXPECT_EQ(0u, b.pending());
+}
+
+TEST(AstrOsI2cBatch, BurstIsCapped)
+{
+    WriteBatcher b;
+    for (int i = 0; i < 10; i++)
+    {
+        ASSERT_TRUE(b.push(reg(0x40, 0x06 + i * 4, 4, i)));
+    }
+
+    Transaction t;
+    ASSERT_TRUE(b.next(t));
+    EXPECT_EQ(8u, t.count);
+    EXPECT_EQ(32, t.len);
+    ASSERT_TRUE(b.next(t));
+    EXPECT_EQ(2u, t.count);
+    EXPECT_EQ(0x06 + 8 * 4, t.reg);
+
+    // and by bytes
+    ASSERT_TRUE(b.push(reg(0x41, 0x00, 30, 20)));
+    ASSERT_TRUE(b.push(reg(0x41, 30, 30, 21)));
+    ASSERT_TRUE(b.push(reg(0x41, 60, 30, 22)));
+    ASSERT_TRUE(b.next(t));
+    EXPECT_EQ(2u, t.count);
+    EXPECT_EQ(60, t.len);
+    ASSERT_TRUE(b.next(t));
+    EXPECT_EQ(1u, t.count);
+}
+
+TEST(AstrOsI2cBatch, RawWritesAndCallsAreNeverMerged)
+{
+    WriteBatcher b;
+    ASSERT_TRUE(b.push(raw(0x20, 6, 0)));
+    ASSERT_TRUE(b.push(raw(0x20, 6, 1)));
+    ASSERT_TRUE(b.push(reg(0x20, 0x00, 1, 2)));
+    ASSERT_TRUE(b.push(Write{0x20, Kind::Call, 0, 0, &tags[3]}));
+    ASSERT_TRUE(b.push(reg(0x20, 0x01, 1, 4)));
+
+    Transaction t;
+    for (int i = 0; i < 5; i++)
+    {
+        ASSERT_TRUE(b.next(t));
+        EXPECT_EQ(1u, t.count);
+        EXPECT_EQ(&tags[i], t.tags[0]);
+    }
+    EXPECT_FALSE(b.next(t));
+}
+
+TEST(AstrOsI2cBatch, DevicesTakeTurns)
+{
+    WriteBatcher b;
+    // A backlog on 0x20 doesn't hold up 0x3C.
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_TRUE(b.push(raw(0x20, 4, i)));
+    }
+    ASSERT_TRUE(b.push(raw(0x3C, 4, 10)));
+
+    Transaction t;
+    ASSERT_TRUE(b.next(t));
+    EXPECT_EQ(0x20, t.addr);
+    ASSERT_TRUE(b.next(t));
+    EXPECT_EQ(0x3C, t.addr);
+    ASSERT_TRUE(b.next(t));
+    EXPECT_EQ(0x20, t.addr);
+    EXPECT_EQ(&tags[1], t.tags[0]);
+    ASSERT_TRUE(b.next(t));
+    EXPECT_EQ(&tags[2], t.tags[0]);
+}
+
+TEST(AstrOsI2cBatch, FullQueuesRefuseUntilDrained)
+{
+    WriteBatcher b;
+    for (size_t i = 0; i < AstrOsI2cBatch::kQueueDepth; i++)
+    {
+        ASSERT_TRUE(b.push(raw(0x20, 1, 0)));
+    }
+    EXPECT_FALSE(b.push(raw(0x20, 1, 0)));
+
+    // Seven more devices fill the table.
+    for (uint8_t a = 1; a < AstrOsI2cBatch::kMaxDevices; a++)
+    {
+        ASSERT_TRUE(b.push(raw(0x20 + a, 1, 0)));
+    }
+    EXPECT_FALSE(b.push(raw(0x50, 1, 0)));
+
+    // A drained device frees its slot.
+    Transaction t;
+    ASSERT_TRUE(b.next(t)); // 0x20
+    ASSERT_TRUE(b.next(t)); // 0x21, now empty
+    EXPECT_TRUE(b.push(raw(0x50, 1, 0)));
+    EXPECT_TRUE(b.push(raw(0x20, 1, 0)));
+}
@@ -0,0 +1,110 @@
+#include <AnimationCommand.hpp>
+#include <AstrOsKangarooPacket.hpp>
+#include <SerialCommand.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using AstrOsKangaroo::Action;
+
+namespace
+{
+    std::vector<uint8_t> encode(uint8_t address, int channel, Action action, int32_t speed, int32_t position)
+    {
+        uint8_t out[AstrOsKangaroo::kMaxPacketBytes];
+        size_t n = AstrOsKangaroo::encode(address, channel, action, speed, position, out);
+        return std::vector<uint8_t>(out, out + n);
+    }
+
+    std::vector<uint8_t> bitPack(int32_t value)
+    {
+        uint8_t out[AstrOsKangaroo::kMaxNumberBytes];
+        size_t n = AstrOsKangaroo::bitPack(value, out);
+        return std::vector<uint8_t>(out, out + n);
+    }
+} // namespace
+
+TEST(AstrOsKangaroo, Crc14)
+{
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    EXPECT_EQ(0x2669, AstrOsKangaroo::crc14(check, sizeof(check)));
+    EXPECT_EQ(0, AstrOsKangaroo::crc14(check, 0));
+}
+
+TEST(AstrOsKangaroo, BitPackedNumbers)
+{
+    EXPECT_EQ(std::vector<uint8_t>({0x00}), bitPack(0));
+    EXPECT_EQ(std::vector<uint8_t>({0x3E}), bitPack(31));
+    EXPECT_EQ(std::vector<uint8_t>({0x40, 0x01}), bitPack(32));
+    EXPECT_EQ(std::vector<uint8_t>({0x03}), bitPack(-1));
+    EXPECT_EQ(std::vector<uint8_t>({0x7E, 0x7F, 0x7F, 0x7F, 0x7F, 0x03}), bitPack(INT32_MAX));
+    EXPECT_EQ(std::vector<uint8_t>({0x41, 0x40, 0x40, 0x40, 0x40, 0x04}), bitPack(INT32_MIN));
+}
+
+// Golden packets; every byte after the address is below 0x80.
+TEST(AstrOsKangaroo, GoldenPackets)
+{
+    EXPECT_EQ(std::vector<uint8_t>({0x80, 0x20, 0x02, 0x31, 0x00, 0x5E, 0x7B}), encode(128, 1, Action::Start, 0, 0));
+    EXPECT_EQ(std::vector<uint8_t>({0x80, 0x22, 0x02, 0x32, 0x00, 0x14, 0x50}), encode(128, 2, Action::Home, 0, 0));
+
+    // 1,p200 s50
+    EXPECT_EQ(std::vector<uint8_t>({0x80, 0x24, 0x08, 0x31, 0x00, 0x01, 0x50, 0x06, 0x02, 0x64, 0x01, 0x40, 0x56}),
+              encode(128, 1, Action::Position, 50, 200));
+    // 1,p200
+    EXPECT_EQ(std::vector<uint8_t>({0x80, 0x24, 0x05, 0x31, 0x00, 0x01, 0x50, 0x06, 0x46, 0x06}),
+              encode(128, 1, Action::Position, 0, 200));
+    // 2,s-50
+    EXPECT_EQ(std::vector<uint8_t>({0x80, 0x24, 0x05, 0x32, 0x00, 0x02, 0x65, 0x01, 0x2B, 0x37}),
+              encode(128, 2, Action::Speed, -50, 0));
+    // 2,si10
+    EXPECT_EQ(std::vector<uint8_t>({0x80, 0x24, 0x04, 0x32, 0x00, 0x42, 0x14, 0x2A, 0x25}),
+              encode(128, 2, Action::SpeedIncremental, 10, 0));
+    // 1,pi-1234 s500 at address 129
+    EXPECT_EQ(std::vector<uint8_t>({0x81, 0x24, 0x08, 0x31, 0x00, 0x41, 0x65, 0x26, 0x02, 0x68, 0x0F, 0x1A, 0x6A}),
+              encode(129, 1, Action::PositionIncremental, 500, -1234));
+}
+
+TEST(AstrOsKangaroo, RejectsWhatCantBeEncoded)
+{
+    EXPECT_TRUE(encode(127, 1, Action::Start, 0, 0).empty());
+    EXPECT_TRUE(encode(128, 10, Action::Start, 0, 0).empty());
+    EXPECT_TRUE(encode(128, -1, Action::Start, 0, 0).empty());
+    EXPECT_TRUE(encode(128, 1, static_cast<Action>(6), 0, 0).empty());
+
+    // longest packet fits
+    EXPECT_EQ(AstrOsKangaroo::kMaxPacketBytes,
+              encode(135, 9, Action::PositionIncremental, INT32_MAX, INT32_MIN).size());
+}
+
+TEST(AstrOsKangaroo, ScriptEventsEncodeOnce)
+{
+    // KANGAROO=4, type|X|serialChannel|baudRate|ch|cmd|spd|pos
+    SerialCommand serial("4|300|1|9600|1|3|50|200");
+    uint8_t out[AstrOsKangaroo::kMaxPacketBytes];
+    EXPECT_EQ(13u, serial.ToKangarooPacket(128, out));
+
+    AnimationCommand event("4|300|1|9600|1|3|50|200");
+    ASSERT_TRUE(event.EncodeKangarooPacket(128));
+    ASSERT_NE(nullptr, event.packet);
+    EXPECT_EQ(13, event.packet->size);
+    EXPECT_EQ(9600, event.packet->baudRate);
+
+    // queued templates share the packet rather than copy it
+    auto tpl = event.GetCommandTemplatePtr();
+    ASSERT_EQ(event.packet, tpl->packet);
+    EXPECT_EQ(std::vector<uint8_t>(out, out + 13),
+              std::vector<uint8_t>(tpl->packet->bytes.begin(), tpl->packet->bytes.begin() + tpl->packet->size));
+
+    // other commands stay text
+    SerialCommand generic("3|200|1|9600|hello");
+    EXPECT_EQ(0u, generic.ToKangarooPacket(128, out));
+    AnimationCommand gpio("5|100|2|1");
+    EXPECT_FALSE(gpio.EncodeKangarooPacket(128));
+    EXPECT_EQ(nullptr, gpio.GetCommandTemplatePtr()->packet);
+
+    // an unknown action too
+    AnimationCommand unknown("4|300|1|9600|1|9|0|0");
+    EXPECT_FALSE(unknown.EncodeKangarooPacket(128));
+    EXPECT_EQ(nullptr, unknown.packet);
+}
@@ -0,0 +1,306 @@
+#include <AstrOsMaestroChannels.hpp>
+#include <AstrOsMaestroReadback.hpp>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+using AstrOsMaestro::ChannelTable;
+using AstrOsMaestro::modelChannels;
+
+namespace
+{
+    servo_channel servo(int id, int minPos, int maxPos, int home, bool inverted = false)
+    {
+        servo_channel ch = {};
+        ch.id = id;
+        ch.enabled = true;
+        ch.isServo = true;
+        ch.minPos = minPos;
+        ch.maxPos = maxPos;
+        ch.home = home;
+        ch.inverted = inverted;
+        return ch;
+    }
+
+    servo_channel gpio(int id, bool inverted = false)
+    {
+        servo_channel ch = {};
+        ch.id = id;
+        ch.enabled = true;
+        ch.inverted = inverted;
+        return ch;
+    }
+} // namespace
+
+TEST(AstrOsMaestro, ModelChannelsRoundsUpToAMaestroModel)
+{
+    EXPECT_EQ(0, modelChannels(0));
+    EXPECT_EQ(6, modelChannels(1));
+    EXPECT_EQ(6, modelChannels(6));
+    EXPECT_EQ(12, modelChannels(7));
+    EXPECT_EQ(18, modelChannels(13));
+    EXPECT_EQ(24, modelChannels(24));
+    EXPECT_EQ(24, modelChannels(40));
+}
+
+TEST(AstrOsMaestro, LoadSizesToModelAndDisablesTheRest)
+{
+    std::vector<servo_channel> cfg = {servo(0, 500, 2500, 1500), gpio(1), servo(2, 1000, 2000, 1200, true)};
+    ChannelTable t;
+    t.load(cfg.data(), cfg.size());
+
+    EXPECT_EQ(6, t.size());
+    EXPECT_TRUE(t.contains(5));
+    EXPECT_FALSE(t.contains(6));
+    EXPECT_FALSE(t.contains(-1));
+
+    EXPECT_TRUE(t.enabled(0));
+    EXPECT_TRUE(t.isServo(0));
+    EXPECT_FALSE(t.isServo(1));
+    EXPECT_TRUE(t.inverted(2));
+    EXPECT_EQ(1200, t.homePos(2));
+    EXPECT_FALSE(t.enabled(3));
+    EXPECT_EQ(0, t.activeCount());
+}
+
+TEST(AstrOsMaestro, RequestResolvesTargets)
+{
+    std::vector<servo_channel> cfg = {servo(0, 500, 2500, 1500), gpio(1), servo(2, 1000, 2000, 1200, true)};
+    ChannelTable t;
+    t.load(cfg.data(), cfg.size());
+
+    EXPECT_EQ(1500, t.request(0, 50, 10, 5));
+    EXPECT_EQ(10, t.speed(0));
+    EXPECT_EQ(5, t.acceleration(0));
+    EXPECT_EQ(2500, t.request(0, 150, 0, 0));
+    EXPECT_EQ(1500, t.request(0, -1, 0, 0)); // home
+
+    // Inverted: 25% is measured from max.
+    EXPECT_EQ(1750, t.request(2, 25, 0, 0));
+
+    // GPIO channels are high / low and never powered down.
+    EXPECT_EQ(2500, t.request(1, 1500, 0, 0));
+    EXPECT_EQ(500, t.request(1, 1499, 0, 0));
+    EXPECT_FALSE(t.on(1));
+
+    EXPECT_TRUE(t.on(0));
+    EXPECT_TRUE(t.on(2));
+    EXPECT_EQ(2, t.activeCount());
+}
+
+TEST(AstrOsMaestro, CheckIdlePowersOffOnlyArrivedServos)
+{
+    std::vector<servo_channel> cfg = {servo(0, 500, 2500, 1500), servo(1, 500, 2500, 1500),
+                                      servo(2, 500, 2500, 1500)};
+    ChannelTable t;
+    t.load(cfg.data(), cfg.size());
+
+    t.request(0, 100, 0, 0);  // unlimited: 255 -> 18824 ms
+    t.request(2, 100, 32, 0); // 32 -> 150000 ms
+
+    uint8_t off[AstrOsMaestro::kMaxChannels];
+    size_t checks = 0;
+    size_t n = 0;
+    while ((n = t.checkIdle(300, off)) == 0)
+    {
+        checks++;
+    }
+    // First 300 ms check at or past 3000 * 1600 / 255 ms.
+    EXPECT_EQ(63u, checks + 1);
+    ASSERT_EQ(1u, n);
+    EXPECT_EQ(0, off[0]);
+    EXPECT_FALSE(t.on(0));
+    EXPECT_TRUE(t.on(2));
+    EXPECT_EQ(1, t.activeCount());
+
+    // A new command restarts the estimate.
+    t.request(0, 0, 0, 0);
+    EXPECT_EQ(0u, t.checkIdle(300, off));
+    EXPECT_EQ(2, t.activeCount());
+}
+
+TEST(AstrOsMaestro, AccelerationBoundsTheIdleEstimate)
+{
+    std::vector<servo_channel> cfg = {servo(0, 500, 2500, 1500), servo(1, 500, 2500, 1500)};
+    ChannelTable t;
+    t.load(cfg.data(), cfg.size());
+
+    t.request(0, 100, 0, 0);
+    t.request(1, 100, 0, 16); // accel 16 -> 300000 ms
+
+    uint8_t off[AstrOsMaestro::kMaxChannels];
+    size_t total = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        total += t.checkIdle(300, off);
+    }
+    EXPECT_EQ(1u, total);
+    EXPECT_TRUE(t.on(1));
+}
+
+TEST(AstrOsMaestro, HomeAndPowerOffAll)
+{
+    std::vector<servo_channel> cfg = {servo(0, 500, 2500, 1500), servo(1, 500, 2500, 900)};
+    ChannelTable t;
+    t.load(cfg.data(), cfg.size());
+
+    t.home(1);
+    EXPECT_EQ(900, t.requestedPos(1));
+    EXPECT_EQ(900, t.lastPos(1));
+    EXPECT_TRUE(t.on(1));
+    // Homing twice does not list the channel twice.
+    t.home(1);
+    EXPECT_EQ(1, t.activeCount());
+
+    t.request(0, 10, 0, 0);
+    t.powerOffAll();
+    EXPECT_EQ(0, t.activeCount());
+    EXPECT_FALSE(t.on(0));
+    EXPECT_FALSE(t.on(1));
+
+    uint8_t off[AstrOsMaestro::kMaxChannels];
+    EXPECT_EQ(0u, t.checkIdle(300, off));
+}
+
+// Two controllers no longer share channel state.
+TEST(AstrOsMaestro, TablesAreIndependent)
+{
+    std::vector<servo_channel> a = {servo(0, 500, 2500, 1500)};
+    std::vector<servo_channel> b(13, servo(0, 1000, 2000, 1100));
+    ChannelTable ta;
+    ChannelTable tb;
+    ta.load(a.data(), a.size());
+    tb.load(b.data(), b.size());
+
+    EXPECT_EQ(6, ta.size());
+    EXPECT_EQ(18, tb.size());
+
+    tb.request(0, 0, 0, 0);
+    EXPECT_TRUE(tb.on(0));
+    EXPECT_FALSE(ta.on(0));
+    EXPECT_EQ(1500, ta.homePos(0));
+}
+
+TEST(AstrOsMaestro, IdleDeadlinesPopInOrder)
+{
+    std::vector<servo_channel> cfg(6, servo(0, 500, 2500, 1500));
+    ChannelTable t;
+    t.load(cfg.data(), cfg.size());
+
+    t.request(4, 100, 160, 0); // 30000 ms
+    t.request(1, 100, 0, 0);   // 18824 ms
+    t.request(3, 100, 80, 0);  // 60000 ms
+    t.request(2, 100, 240, 0); // 20000 ms
+
+    uint8_t active[AstrOsMaestro::kMaxChannels];
+    ASSERT_EQ(4u, t.activeChannels(active));
+    EXPECT_EQ(1, active[0]);
+    EXPECT_EQ(2, active[1]);
+    EXPECT_EQ(4, active[2]);
+    EXPECT_EQ(3, active[3]);
+
+    // Re-commanding channel 1 slower pushes it behind 2 and 4.
+    t.request(1, 50, 120, 0); // 40000 ms from now
+
+    uint8_t off[AstrOsMaestro::kMaxChannels];
+    EXPECT_EQ(0u, t.checkIdle(19999, off));
+    ASSERT_EQ(1u, t.checkIdle(1, off));
+    EXPECT_EQ(2, off[0]);
+    ASSERT_EQ(1u, t.checkIdle(10000, off));
+    EXPECT_EQ(4, off[0]);
+    ASSERT_EQ(1u, t.checkIdle(10000, off));
+    EXPECT_EQ(1, off[0]);
+    ASSERT_EQ(1u, t.checkIdle(20000, off));
+    EXPECT_EQ(3, off[0]);
+    EXPECT_EQ(0, t.activeCount());
+}
+
+TEST(AstrOsMaestro, ReadbackPowersOffSettledChannels)
+{
+    std::vector<servo_channel> cfg = {servo(0, 500, 2500, 1500), servo(1, 500, 2500, 1500), gpio(2)};
+    ChannelTable t;
+    t.load(cfg.data(), cfg.size());
+
+    t.request(0, 100, 0, 0); // 2500 us -> 10000
+    t.request(1, 0, 0, 0);   // 500 us -> 2000
+
+    const uint8_t chs[] = {0, 1, 2};
+    const uint16_t gens[] = {t.generation(0), t.generation(1), t.generation(2)};
+    uint16_t positions[] = {10000, 3000, 0};
+    uint8_t off[AstrOsMaestro::kMaxChannels];
+
+    EXPECT_EQ(0u, t.checkReadback(chs, gens, positions, 3, off));
+    ASSERT_EQ(1u, t.checkReadback(chs, gens, positions, 3, off));
+    EXPECT_EQ(0, off[0]);
+    EXPECT_FALSE(t.on(0));
+    EXPECT_TRUE(t.on(1));
+
+    // Leaving the target starts settling over.
+    positions[1] = 2000;
+    EXPECT_EQ(0u, t.checkReadback(chs, gens, positions, 3, off));
+    positions[1] = 2100;
+    EXPECT_EQ(0u, t.checkReadback(chs, gens, positions, 3, off));
+    positions[1] = 2000;
+    EXPECT_EQ(0u, t.checkReadback(chs, gens, positions, 3, off));
+    EXPECT_EQ(1u, t.checkReadback(chs, gens, positions, 3, off));
+    EXPECT_EQ(0, t.activeCount());
+
+    // A channel powered off by readback no longer has a deadline.
+    EXPECT_EQ(0u, t.checkIdle(600000, off));
+}
+
+// The query runs without the table locked; a move that lands meanwhile
+// wins over what was read back before it.
+TEST(AstrOsMaestro, ReadbackSkipsChannelsCommandedSinceTheQuery)
+{
+    std::vector<servo_channel> cfg = {servo(0, 500, 2500, 1500), servo(1, 500, 2500, 1500)};
+    ChannelTable t;
+    t.load(cfg.data(), cfg.size());
+
+    t.request(0, 100, 0, 0);
+    t.request(1, 100, 0, 0);
+
+    const uint8_t chs[] = {0, 1};
+    const uint16_t gens[] = {t.generation(0), t.generation(1)};
+    const uint16_t positions[] = {10000, 10000};
+    uint8_t off[AstrOsMaestro::kMaxChannels];
+
+    EXPECT_EQ(0u, t.checkReadback(chs, gens, positions, 2, off));
+
+    // Same target again: still a new command.
+    t.request(1, 100, 0, 0);
+    ASSERT_EQ(1u, t.checkReadback(chs, gens, positions, 2, off));
+    EXPECT_EQ(0, off[0]);
+    EXPECT_TRUE(t.on(1));
+
+    // A reload invalidates every query in flight.
+    const uint16_t before = t.generation(1);
+    t.load(cfg.data(), cfg.size());
+    EXPECT_NE(before, t.generation(1));
+}
+
+TEST(AstrOsMaestro, PositionQueryRoundTrip)
+{
+    const uint8_t chs[] = {3, 7};
+    uint8_t query[AstrOsMaestro::queryBytes(2)];
+    ASSERT_EQ(5u, AstrOsMaestro::encodePositionQuery(chs, 2, query));
+    const uint8_t expected[] = {0x90, 3, 0x90, 7, 0x93};
+    EXPECT_EQ(0, memcmp(expected, query, sizeof(expected)));
+
+    // 6000 = 0x1770, 4000 = 0x0FA0; low byte first
+    const uint8_t reply[] = {0x70, 0x17, 0xA0, 0x0F, 1};
+    uint16_t positions[2] = {};
+    bool moving = false;
+    ASSERT_TRUE(AstrOsMaestro::parsePositionReply(reply, sizeof(reply), 2, positions, &moving));
+    EXPECT_EQ(6000, positions[0]);
+    EXPECT_EQ(4000, positions[1]);
+    EXPECT_TRUE(moving);
+
+    // Short, or out of step.
+    uint16_t untouched[2] = {1, 1};
+    EXPECT_FALSE(AstrOsMaestro::parsePositionReply(reply, 4, 2, untouched, &moving));
+    const uint8_t misframed[] = {0x70, 0x17, 0xA0, 0x0F, 0x17};
+    EXPECT_FALSE(AstrOsMaestro::parsePositionReply(misframed, sizeof(misframed), 2, untouched, &moving));
+    EXPECT_EQ(1, untouched[0]);
+}
@@ -0,0 +1,118 @@
+#include <AstrOsMaestroShadow.hpp>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using AstrOsMaestro::ShadowRegisters;
+
+namespace
+{
+    std::vector<uint8_t> move(ShadowRegisters &s, uint8_t ch, uint16_t target, uint16_t speed, uint16_t accel,
+                              uint16_t wake = 0)
+    {
+        uint8_t out[AstrOsMaestro::kMaxMoveBytes];
+        size_t n = s.move(ch, target, speed, accel, wake, out);
+        return std::vector<uint8_t>(out, out + n);
+    }
+} // namespace
+
+TEST(AstrOsMaestroShadow, FirstMoveSendsEverything)
+{
+    ShadowRegisters s;
+    s.reset(6);
+
+    // 1500us = 6000 quarter us = 0x2E, 0x70 in 7-bit bytes
+    std::vector<uint8_t> expected = {0x84, 2, 0x50, 0x0F, 0x87, 2, 10, 0, 0x89, 2, 5, 0, 0x84, 2, 0x70, 0x2E};
+    EXPECT_EQ(expected, move(s, 2, 6000, 10, 5, 2000));
+}
+
+TEST(AstrOsMaestroShadow, RepeatSendsOnlyTheTarget)
+{
+    ShadowRegisters s;
+    s.reset(6);
+    move(s, 0, 4000, 10, 5, 2000);
+
+    std::vector<uint8_t> expected = {0x84, 0, 0x70, 0x2E};
+    EXPECT_EQ(expected, move(s, 0, 6000, 10, 5, 2000));
+    // The same target again still goes out.
+    EXPECT_EQ(expected, move(s, 0, 6000, 10, 5, 2000));
+}
+
+TEST(AstrOsMaestroShadow, SpeedDeltaOnPoweredChannelSkipsWake)
+{
+    ShadowRegisters s;
+    s.reset(6);
+    move(s, 1, 4000, 10, 5, 2000);
+
+    std::vector<uint8_t> expected = {0x87, 1, 20, 0, 0x84, 1, 0x70, 0x2E};
+    EXPECT_EQ(expected, move(s, 1, 6000, 20, 5, 2000));
+}
+
+TEST(AstrOsMaestroShadow, WakeOnlyWhenOff)
+{
+    ShadowRegisters s;
+    s.reset(6);
+    move(s, 3, 4000, 10, 5);
+
+    uint8_t off[4];
+    ASSERT_EQ(4u, s.off(3, off));
+    EXPECT_EQ(0x84, off[0]);
+    EXPECT_EQ(0, off[2]);
+    EXPECT_EQ(0, off[3]);
+
+    // Speed change on an unpowered channel is preceded by the wake target.
+    std::vector<uint8_t> got = move(s, 3, 6000, 30, 5, 4000);
+    ASSERT_EQ(12u, got.size());
+    EXPECT_EQ(0x84, got[0]);
+    EXPECT_EQ(0x20, got[2]); // 4000 = 0x1F, 0x20
+    EXPECT_EQ(0x1F, got[3]);
+    EXPECT_EQ(0x87, got[4]);
+
+    // No speed / accel change: no wake needed, the target powers it.
+    s.off(3, off);
+    EXPECT_EQ(4u, move(s, 3, 6000, 30, 5, 4000).size());
+}
+
+TEST(AstrOsMaestroShadow, InvalidateResendsEverything)
+{
+    ShadowRegisters s;
+    s.reset(6);
+    move(s, 0, 4000, 10, 5, 2000);
+    move(s, 1, 4000, 10, 5, 2000);
+
+    s.invalidate(0);
+    EXPECT_EQ(16u, move(s, 0, 4000, 10, 5, 2000).size());
+    EXPECT_EQ(4u, move(s, 1, 4000, 10, 5, 2000).size());
+
+    s.invalidateAll();
+    EXPECT_EQ(16u, move(s, 1, 4000, 10, 5, 2000).size());
+}
+
+TEST(AstrOsMaestroShadow, AllOffWakesOnNextSpeedChange)
+{
+    ShadowRegisters s;
+    s.reset(6);
+    move(s, 0, 4000, 10, 5, 2000);
+    move(s, 5, 4000, 10, 5, 2000);
+
+    s.allOff(6);
+    std::vector<uint8_t> got = move(s, 5, 6000, 11, 5, 4000);
+    ASSERT_EQ(12u, got.size());
+    EXPECT_EQ(0x84, got[0]);
+    EXPECT_EQ(0x87, got[4]);
+}
+
+TEST(AstrOsMaestroShadow, ChannelPastRegistersIsNotTracked)
+{
+    ShadowRegisters s;
+    s.reset(6);
+
+    EXPECT_EQ(16u, move(s, 7, 4000, 10, 5, 2000).size());
+    EXPECT_EQ(16u, move(s, 7, 4000, 10, 5, 2000).size());
+
+    uint8_t off[4];
+    EXPECT_EQ(4u, s.off(7, off));
+    s.invalidate(7);
+    s.allOff(24);
+    EXPECT_EQ(6, s.size());
+}
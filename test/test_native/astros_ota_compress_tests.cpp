@@ -0,0 +1,567 @@
+#include <AstrOsOtaCompress.hpp>
+#include <AstrOsOtaDelta.hpp>
+#include <gtest/gtest.h>
+
+#include "astros_test_helpers.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using AstrOsOtaCompress::DecodeResult;
+using AstrOsOtaCompress::Status;
+using AstrOsOtaCompress::StreamDecoder;
+using AstrOsOtaCompress::StreamHeader;
+using AstrOsOtaCompress::StreamIo;
+
+namespace
+{
+    using AstrOsTestHelpers::Bytes;
+    using AstrOsTestHelpers::sha256;
+
+    // Firmware-shaped test image: code-like stretches assembled from a small
+    // vocabulary of 16-byte "instruction groups" (so back-references find
+    // matches, as they do in real .text), interleaved with incompressible
+    // constant tables and 0xFF padding runs. Deterministic so failures
+    // reproduce.
+    Bytes makeFirmwareLike(size_t len, uint32_t seed)
+    {
+        uint32_t x = seed;
+        auto next = [&x]()
+        {
+            x = x * 1664525u + 1013904223u;
+            return x >> 8;
+        };
+        uint8_t vocab[64][16];
+        for (auto &group : vocab)
+        {
+            for (auto &b : group)
+            {
+                b = static_cast<uint8_t>(next());
+            }
+        }
+
+        Bytes out;
+        out.reserve(len);
+        while (out.size() < len)
+        {
+            uint32_t kind = next() % 10;
+            size_t run = 64 + next() % 512;
+            for (size_t i = 0; i < run && out.size() < len;)
+            {
+                if (kind < 7)
+                {
+                    const uint8_t *group = vocab[next() % 64];
+                    for (size_t j = 0; j < 16 && out.size() < len; ++j, ++i)
+                    {
+                        out.push_back(group[j]);
+                    }
+                }
+                else
+                {
+                    out.push_back(kind < 9 ? static_cast<uint8_t>(next()) : 0xFF);
+                    ++i;
+                }
+            }
+        }
+        return out;
+    }
+
+    Bytes makeHeader(uint32_t rawSize, uint8_t windowBits, const uint8_t *rawSha = nullptr)
+    {
+        StreamHeader h{};
+        std::memcpy(h.magic, AstrOsOtaCompress::kMagic, sizeof(h.magic));
+        h.formatVersion = AstrOsOtaCompress::kFormatVersion;
+        h.windowBits = windowBits;
+        h.rawSize = rawSize;
+        if (rawSha != nullptr)
+        {
+            std::memcpy(h.rawSha256, rawSha, sizeof(h.rawSha256));
+        }
+        Bytes out(sizeof(h));
+        std::memcpy(out.data(), &h, sizeof(h));
+        return out;
+    }
+
+    void putLiteral(Bytes &out, const uint8_t *data, size_t len)
+    {
+        while (len > 0)
+        {
+            size_t n = std::min(len, AstrOsOtaCompress::kMaxLiteralRun);
+            out.push_back(static_cast<uint8_t>(n - 1));
+            out.insert(out.end(), data, data + n);
+            data += n;
+            len -= n;
+        }
+    }
+
+    void putMatch(Bytes &out, uint32_t distance, size_t length)
+    {
+        out.push_back(static_cast<uint8_t>(AstrOsOtaCompress::kMatchBit | (length - AstrOsOtaCompress::kMinMatch)));
+        out.push_back(static_cast<uint8_t>((distance - 1) & 0xFF));
+        out.push_back(static_cast<uint8_t>((distance - 1) >> 8));
+    }
+
+    // Reference compressor: greedy LZ77 with a 3-byte hash chain over the
+    // declared window. Stands in for the server-side packer; the stream
+    // format is the contract under test.
+    Bytes compress(const Bytes &raw, uint8_t windowBits = AstrOsOtaCompress::kMaxWindowBits)
+    {
+        uint8_t digest[32];
+        sha256(raw, digest);
+        Bytes out = makeHeader(static_cast<uint32_t>(raw.size()), windowBits, digest);
+
+        const size_t window = size_t(1) << windowBits;
+        constexpr size_t kHashSize = 1 << 14;
+        constexpr size_t kMaxChain = 32;
+        std::vector<int64_t> head(kHashSize, -1);
+        std::vector<int64_t> prev(raw.size(), -1);
+        auto hash = [&raw](size_t i)
+        {
+            uint32_t v = (uint32_t(raw[i]) << 16) | (uint32_t(raw[i + 1]) << 8) | raw[i + 2];
+            return (v * 2654435761u >> 18) & (kHashSize - 1);
+        };
+        auto insert = [&](size_t i)
+        {
+            if (i + AstrOsOtaCompress::kMinMatch <= raw.size())
+            {
+                size_t h = hash(i);
+                prev[i] = head[h];
+                head[h] = static_cast<int64_t>(i);
+            }
+        };
+
+        size_t literalStart = 0;
+        size_t i = 0;
+        while (i < raw.size())
+        {
+            size_t bestLen = 0;
+            size_t bestDist = 0;
+            if (i + AstrOsOtaCompress::kMinMatch <= raw.size())
+            {
+                int64_t cand = head[hash(i)];
+                for (size_t chain = 0; cand >= 0 && chain < kMaxChain; ++chain, cand = prev[cand])
+                {
+                    size_t dist = i - static_cast<size_t>(cand);
+                    if (dist > window)
+                    {
+                        break;
+                    }
+                    size_t len = 0;
+                    while (len < AstrOsOtaCompress::kMaxMatch && i + len < raw.size() &&
+                           raw[cand + len] == raw[i + len])
+                    {
+                        ++len;
+                    }
+                    if (len > bestLen)
+                    {
+                        bestLen = len;
+                        bestDist = dist;
+                    }
+                }
+            }
+            if (bestLen >= AstrOsOtaCompress::kMinMatch)
+            {
+                putLiteral(out, raw.data() + literalStart, i - literalStart);
+                putMatch(out, static_cast<uint32_t>(bestDist), bestLen);
+                for (size_t k = 0; k < bestLen; ++k)
+                {
+                    insert(i + k);
+                }
+                i += bestLen;
+                literalStart = i;
+            }
+            else
+            {
+                insert(i);
+                ++i;
+            }
+        }
+        putLiteral(out, raw.data() + literalStart, i - literalStart);
+        return out;
+    }
+
+    // In-memory sink wired through the C-style StreamIo callbacks.
+    struct MemSink
+    {
+        Bytes out;
+        size_t writes = 0;
+        size_t largestWrite = 0;
+        bool failWrites = false;
+        bool rejectHeader = false;
+        int headerCalls = 0;
+
+        static bool writeOut(void *ctx, const uint8_t *data, size_t len)
+        {
+            auto self = static_cast<MemSink *>(ctx);
+            if (self->failWrites)
+            {
+                return false;
+            }
+            self->out.insert(self->out.end(), data, data + len);
+            self->writes++;
+            self->largestWrite = std::max(self->largestWrite, len);
+            return true;
+        }
+
+        static bool acceptHeader(void *ctx, const StreamHeader &)
+        {
+            auto self = static_cast<MemSink *>(ctx);
+            self->headerCalls++;
+            return !self->rejectHeader;
+        }
+
+        StreamIo io()
+        {
+            StreamIo io;
+            io.ctx = this;
+            io.writeOut = &MemSink::writeOut;
+            io.acceptHeader = &MemSink::acceptHeader;
+            return io;
+        }
+    };
+
+    // Feeds `stream` in `split`-sized pieces; returns the first failing
+    // feed result or finish().
+    DecodeResult decode(StreamDecoder &d, MemSink &sink, const Bytes &stream, size_t split)
+    {
+        d.begin(sink.io());
+        for (size_t off = 0; off < stream.size(); off += split)
+        {
+            size_t n = std::min(split, stream.size() - off);
+            auto r = d.feed(stream.data() + off, n);
+            if (!r.ok)
+            {
+                return r;
+            }
+        }
+        return d.finish();
+    }
+} // namespace
+
+//=================================================================================================
+// Header parsing
+//=================================================================================================
+
+TEST(OtaCompress, ParseHeaderAcceptsBuiltHeader)
+{
+    Bytes h = makeHeader(1000, 10);
+    auto hr = AstrOsOtaCompress::parseHeader(h.data(), h.size());
+    ASSERT_TRUE(hr.valid);
+    EXPECT_EQ(1000u, hr.header.rawSize);
+    EXPECT_EQ(10, hr.header.windowBits);
+}
+
+TEST(OtaCompress, ParseHeaderRejectsOtherFormats)
+{
+    // Full images start with 0xE9; delta patches with "ADLT". Neither may
+    // be mistaken for a compressed stream.
+    Bytes image(64, 0);
+    image[0] = 0xE9;
+    EXPECT_EQ(Status::BAD_MAGIC, AstrOsOtaCompress::parseHeader(image.data(), image.size()).status);
+    Bytes patch(sizeof(AstrOsOtaDelta::PatchHeader), 0);
+    std::memcpy(patch.data(), AstrOsOtaDelta::kMagic, sizeof(AstrOsOtaDelta::kMagic));
+    EXPECT_EQ(Status::BAD_MAGIC, AstrOsOtaCompress::parseHeader(patch.data(), patch.size()).status);
+
+    Bytes h = makeHeader(16, 12);
+    EXPECT_EQ(Status::TRUNCATED, AstrOsOtaCompress::parseHeader(h.data(), h.size() - 1).status);
+}
+
+TEST(OtaCompress, ParseHeaderRejectsBadFields)
+{
+    Bytes v = makeHeader(16, 12);
+    v[4] = AstrOsOtaCompress::kFormatVersion + 1;
+    EXPECT_EQ(Status::BAD_VERSION, AstrOsOtaCompress::parseHeader(v.data(), v.size()).status);
+
+    Bytes big = makeHeader(16, AstrOsOtaCompress::kMaxWindowBits + 1);
+    EXPECT_EQ(Status::BAD_HEADER, AstrOsOtaCompress::parseHeader(big.data(), big.size()).status);
+    Bytes small = makeHeader(16, AstrOsOtaCompress::kMinWindowBits - 1);
+    EXPECT_EQ(Status::BAD_HEADER, AstrOsOtaCompress::parseHeader(small.data(), small.size()).status);
+
+    Bytes zero = makeHeader(0, 12);
+    EXPECT_EQ(Status::BAD_HEADER, AstrOsOtaCompress::parseHeader(zero.data(), zero.size()).status);
+
+    Bytes r = makeHeader(16, 12);
+    r[7] = 1; // reserved byte
+    EXPECT_EQ(Status::BAD_HEADER, AstrOsOtaCompress::parseHeader(r.data(), r.size()).status);
+}
+
+//=================================================================================================
+// Round trips
+//=================================================================================================
+
+TEST(OtaCompress, RoundTripFirmwareLikeImageShrinks)
+{
+    Bytes raw = makeFirmwareLike(256 * 1024, 7);
+    Bytes stream = compress(raw);
+
+    MemSink sink;
+    StreamDecoder d;
+    auto r = decode(d, sink, stream, 128);
+    ASSERT_TRUE(r.ok) << static_cast<int>(r.status);
+    EXPECT_EQ(raw, sink.out);
+    EXPECT_EQ(raw.size(), d.bytesOut());
+    EXPECT_EQ(1, sink.headerCalls);
+
+    uint8_t want[32];
+    uint8_t got[32];
+    sha256(raw, want);
+    sha256(sink.out, got);
+    EXPECT_EQ(0, std::memcmp(want, got, 32));
+    EXPECT_EQ(0, std::memcmp(want, d.header().rawSha256, 32));
+
+    // The point of the feature: airtime scales with the stream, not the image.
+    EXPECT_LT(stream.size(), raw.size() * 6 / 10) << "stream=" << stream.size() << " raw=" << raw.size();
+}
+
+TEST(OtaCompress, RoundTripAnySplit)
+{
+    Bytes raw = makeFirmwareLike(20 * 1024, 8);
+    Bytes stream = compress(raw);
+    for (size_t split : {size_t(1), size_t(3), size_t(7), size_t(128), size_t(4096), stream.size()})
+    {
+        MemSink sink;
+        StreamDecoder d;
+        auto r = decode(d, sink, stream, split);
+        ASSERT_TRUE(r.ok) << "split=" << split << " status=" << static_cast<int>(r.status);
+        EXPECT_EQ(raw, sink.out) << "split=" << split;
+    }
+}
+
+TEST(OtaCompress, SinkWritesAreBatchedAndBoundedByWindow)
+{
+    // One feed of a highly compressible stream decodes to many windows'
+    // worth of output; the sink must see window-sized batches, never more.
+    Bytes raw(64 * 1024, 0xFF);
+    Bytes stream = compress(raw);
+    EXPECT_LT(stream.size(), 2048u);
+
+    MemSink sink;
+    StreamDecoder d;
+    auto r = decode(d, sink, stream, stream.size());
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(raw, sink.out);
+    EXPECT_LE(sink.largestWrite, size_t(1) << AstrOsOtaCompress::kMaxWindowBits);
+    EXPECT_LE(sink.writes, raw.size() / (size_t(1) << AstrOsOtaCompress::kMaxWindowBits) + 1);
+}
+
+TEST(OtaCompress, OverlappingMatchEncodesRun)
+{
+    // "ab" then a 10-byte match at distance 2 => "abababababab".
+    Bytes stream = makeHeader(12, 8);
+    const uint8_t ab[] = {'a', 'b'};
+    putLiteral(stream, ab, 2);
+    putMatch(stream, 2, 10);
+
+    MemSink sink;
+    StreamDecoder d;
+    auto r = decode(d, sink, stream, 1);
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(std::string("abababababab"), std::string(sink.out.begin(), sink.out.end()));
+}
+
+TEST(OtaCompress, MatchAcrossWindowWrapUsesRecentBytes)
+{
+    // Larger than the ring, with a match whose source straddles the wrap.
+    Bytes raw = makeFirmwareLike(3 * 4096 + 100, 9);
+    Bytes stream = makeHeader(static_cast<uint32_t>(raw.size() + 64), 12);
+    putLiteral(stream, raw.data(), raw.size());
+    putMatch(stream, 4096, 64); // source = raw[end-4096 .. end-4032)
+    Bytes want = raw;
+    want.insert(want.end(), raw.end() - 4096, raw.end() - 4096 + 64);
+
+    MemSink sink;
+    StreamDecoder d;
+    auto r = decode(d, sink, stream, 100);
+    ASSERT_TRUE(r.ok) << static_cast<int>(r.status);
+    EXPECT_EQ(want, sink.out);
+}
+
+TEST(OtaCompress, CompressedDeltaPatchChainsIntoApplier)
+{
+    // COMPRESSED + DELTA: the decoded stream is a patch; its bytes go
+    // straight into PatchApplier, which rebuilds the image from the base.
+    Bytes base = makeFirmwareLike(32 * 1024, 10);
+    Bytes target = base;
+    target[5000] ^= 0x33;
+    const uint8_t extra[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    target.insert(target.begin() + 9000, extra, extra + sizeof(extra));
+
+    AstrOsOtaDelta::PatchHeader ph{};
+    std::memcpy(ph.magic, AstrOsOtaDelta::kMagic, sizeof(ph.magic));
+    ph.formatVersion = AstrOsOtaDelta::kFormatVersion;
+    ph.baseSize = static_cast<uint32_t>(base.size());
+    ph.targetSize = static_cast<uint32_t>(target.size());
+    Bytes patch(sizeof(ph));
+    std::memcpy(patch.data(), &ph, sizeof(ph));
+    auto copy = [&patch](uint32_t off, uint32_t len)
+    {
+        patch.push_back(static_cast<uint8_t>(AstrOsOtaDelta::OpCode::COPY));
+        for (uint32_t v : {off, len})
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                patch.push_back(static_cast<uint8_t>(v >> (8 * i)));
+            }
+        }
+    };
+    auto insert = [&patch](const uint8_t *data, uint32_t len)
+    {
+        patch.push_back(static_cast<uint8_t>(AstrOsOtaDelta::OpCode::INSERT));
+        for (int i = 0; i < 4; ++i)
+        {
+            patch.push_back(static_cast<uint8_t>(len >> (8 * i)));
+        }
+        patch.insert(patch.end(), data, data + len);
+    };
+    copy(0, 5000);
+    insert(&target[5000], 1);
+    copy(5001, 3999);
+    insert(extra, sizeof(extra));
+    copy(9000, static_cast<uint32_t>(base.size() - 9000));
+
+    struct Chain
+    {
+        const Bytes *base;
+        AstrOsOtaDelta::PatchApplier applier;
+        Bytes image;
+    } chain{&base, {}, {}};
+
+    AstrOsOtaDelta::PatchIo pio;
+    pio.ctx = &chain;
+    pio.readBase = [](void *ctx, uint32_t off, uint8_t *out, size_t len)
+    {
+        auto c = static_cast<Chain *>(ctx);
+        std::memcpy(out, c->base->data() + off, len);
+        return true;
+    };
+    pio.writeOut = [](void *ctx, const uint8_t *data, size_t len)
+    {
+        auto c = static_cast<Chain *>(ctx);
+        c->image.insert(c->image.end(), data, data + len);
+        return true;
+    };
+    chain.applier.begin(pio);
+
+    StreamIo sio;
+    sio.ctx = &chain;
+    sio.writeOut = [](void *ctx, const uint8_t *data, size_t len)
+    {
+        return static_cast<Chain *>(ctx)->applier.feed(data, len).ok;
+    };
+
+    Bytes stream = compress(patch);
+    StreamDecoder d;
+    d.begin(sio);
+    for (size_t off = 0; off < stream.size(); off += 128)
+    {
+        ASSERT_TRUE(d.feed(stream.data() + off, std::min<size_t>(128, stream.size() - off)).ok);
+    }
+    ASSERT_TRUE(d.finish().ok);
+    ASSERT_TRUE(chain.applier.finish().ok);
+    EXPECT_EQ(target, chain.image);
+}
+
+//=================================================================================================
+// Rejections
+//=================================================================================================
+
+TEST(OtaCompress, RejectsMatchBeforeStreamStart)
+{
+    Bytes stream = makeHeader(10, 12);
+    const uint8_t x[] = {'x', 'y'};
+    putLiteral(stream, x, 2);
+    putMatch(stream, 3, 8); // only 2 bytes decoded so far
+
+    MemSink sink;
+    StreamDecoder d;
+    auto r = decode(d, sink, stream, stream.size());
+    EXPECT_FALSE(r.ok);
+    EXPECT_EQ(Status::BAD_DISTANCE, r.status);
+}
+
+TEST(OtaCompress, RejectsMatchBeyondDeclaredWindow)
+{
+    // windowBits=8: a 300-byte back-reference is out of bounds even though
+    // the bytes are still in the decoder's (larger) ring.
+    Bytes raw = makeFirmwareLike(400, 11);
+    Bytes stream = makeHeader(static_cast<uint32_t>(raw.size() + 3), 8);
+    putLiteral(stream, raw.data(), raw.size());
+    putMatch(stream, 300, 3);
+
+    MemSink sink;
+    StreamDecoder d;
+    EXPECT_EQ(Status::BAD_DISTANCE, decode(d, sink, stream, 64).status);
+}
+
+TEST(OtaCompress, RejectsOutputOverflow)
+{
+    const uint8_t lit[] = {1, 2, 3, 4};
+
+    Bytes literal = makeHeader(3, 12);
+    putLiteral(literal, lit, 4);
+    MemSink s1;
+    StreamDecoder d1;
+    EXPECT_EQ(Status::OUTPUT_OVERFLOW, decode(d1, s1, literal, literal.size()).status);
+    EXPECT_TRUE(s1.out.empty()) << "nothing may be emitted past rawSize";
+
+    Bytes match = makeHeader(6, 12);
+    putLiteral(match, lit, 2);
+    putMatch(match, 1, 5);
+    MemSink s2;
+    StreamDecoder d2;
+    EXPECT_EQ(Status::OUTPUT_OVERFLOW, decode(d2, s2, match, match.size()).status);
+}
+
+TEST(OtaCompress, RejectsTrailingDataAndTruncation)
+{
+    Bytes raw = makeFirmwareLike(1000, 12);
+    Bytes stream = compress(raw);
+
+    Bytes trailing = stream;
+    trailing.push_back(0x00);
+    MemSink s1;
+    StreamDecoder d1;
+    EXPECT_EQ(Status::TRAILING_DATA, decode(d1, s1, trailing, 128).status);
+
+    Bytes truncated(stream.begin(), stream.end() - 1);
+    MemSink s2;
+    StreamDecoder d2;
+    EXPECT_EQ(Status::TRUNCATED, decode(d2, s2, truncated, 128).status);
+}
+
+TEST(OtaCompress, HeaderRejectionStopsBeforeAnyOutput)
+{
+    Bytes stream = compress(makeFirmwareLike(1000, 13));
+    MemSink sink;
+    sink.rejectHeader = true;
+    StreamDecoder d;
+    auto r = decode(d, sink, stream, stream.size());
+    EXPECT_EQ(Status::HEADER_REJECTED, r.status);
+    EXPECT_FALSE(d.headerAccepted());
+    EXPECT_TRUE(sink.out.empty());
+}
+
+TEST(OtaCompress, WriteFailureIsStickyAndResetRecovers)
+{
+    Bytes raw = makeFirmwareLike(2000, 14);
+    Bytes stream = compress(raw);
+
+    MemSink sink;
+    sink.failWrites = true;
+    StreamDecoder d;
+    d.begin(sink.io());
+    auto r = d.feed(stream.data(), stream.size());
+    EXPECT_EQ(Status::WRITE_FAILED, r.status);
+    sink.failWrites = false;
+    EXPECT_EQ(Status::WRITE_FAILED, d.feed(stream.data(), 1).status);
+    EXPECT_EQ(Status::WRITE_FAILED, d.finish().status);
+
+    d.reset();
+    EXPECT_EQ(Status::NOT_STARTED, d.feed(stream.data(), 1).status);
+    auto ok = decode(d, sink, stream, 64);
+    EXPECT_TRUE(ok.ok);
+    EXPECT_EQ(raw, sink.out);
+}
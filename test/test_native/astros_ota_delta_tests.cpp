@@ -0,0 +1,535 @@
+#include <AstrOsOtaDelta.hpp>
+#include <gtest/gtest.h>
+
+#include "astros_test_helpers.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using AstrOsOtaDelta::ApplyResult;
+using AstrOsOtaDelta::OpCode;
+using AstrOsOtaDelta::PatchApplier;
+using AstrOsOtaDelta::PatchHeader;
+using AstrOsOtaDelta::PatchIo;
+using AstrOsOtaDelta::Status;
+
+namespace
+{
+    using AstrOsTestHelpers::Bytes;
+    using AstrOsTestHelpers::makeData;
+    using AstrOsTestHelpers::sha256;
+
+    void putU32(Bytes &out, uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        }
+    }
+
+    // Hand-assembles patches op by op. Stands in for the server-side
+    // generator; the wire format is the contract under test.
+    struct PatchBuilder
+    {
+        Bytes bytes;
+
+        PatchBuilder(const Bytes &base, const Bytes &target, const char *version = "9.9.9")
+            : PatchBuilder(static_cast<uint32_t>(base.size()), static_cast<uint32_t>(target.size()))
+        {
+            PatchHeader h = header();
+            sha256(base, h.baseSha256);
+            sha256(target, h.targetSha256);
+            std::strncpy(h.targetVersion, version, sizeof(h.targetVersion));
+            std::memcpy(bytes.data(), &h, sizeof(h));
+        }
+
+        PatchBuilder(uint32_t baseSize, uint32_t targetSize)
+        {
+            PatchHeader h{};
+            std::memcpy(h.magic, AstrOsOtaDelta::kMagic, sizeof(h.magic));
+            h.formatVersion = AstrOsOtaDelta::kFormatVersion;
+            h.baseSize = baseSize;
+            h.targetSize = targetSize;
+            bytes.resize(sizeof(h));
+            std::memcpy(bytes.data(), &h, sizeof(h));
+        }
+
+        PatchHeader header() const
+        {
+            PatchHeader h;
+            std::memcpy(&h, bytes.data(), sizeof(h));
+            return h;
+        }
+
+        PatchBuilder &copy(uint32_t offset, uint32_t len)
+        {
+            bytes.push_back(static_cast<uint8_t>(OpCode::COPY));
+            putU32(bytes, offset);
+            putU32(bytes, len);
+            return *this;
+        }
+
+        PatchBuilder &insert(const uint8_t *data, uint32_t len)
+        {
+            bytes.push_back(static_cast<uint8_t>(OpCode::INSERT));
+            putU32(bytes, len);
+            bytes.insert(bytes.end(), data, data + len);
+            return *this;
+        }
+
+        PatchBuilder &fill(uint32_t len, uint8_t value)
+        {
+            bytes.push_back(static_cast<uint8_t>(OpCode::FILL));
+            putU32(bytes, len);
+            bytes.push_back(value);
+            return *this;
+        }
+    };
+
+    // Greedy reference diff: index every 8-byte window of the base, extend
+    // matches forward, emit COPY for runs >= 16 B, FILL for long constant
+    // runs, INSERT for the rest. Good enough to show a point release
+    // shrinks to a small patch; the real generator lives server-side.
+    Bytes diff(const Bytes &base, const Bytes &target)
+    {
+        constexpr size_t kKey = 8;
+        constexpr size_t kMinCopy = 16;
+        std::unordered_map<uint64_t, uint32_t> index;
+        for (size_t i = 0; i + kKey <= base.size(); ++i)
+        {
+            uint64_t k;
+            std::memcpy(&k, &base[i], kKey);
+            index.emplace(k, static_cast<uint32_t>(i));
+        }
+
+        PatchBuilder pb(base, target);
+        Bytes literal;
+        auto flushLiteral = [&]()
+        {
+            if (!literal.empty())
+            {
+                pb.insert(literal.data(), static_cast<uint32_t>(literal.size()));
+                literal.clear();
+            }
+        };
+
+        size_t t = 0;
+        while (t < target.size())
+        {
+            size_t run = 1;
+            while (t + run < target.size() && target[t + run] == target[t])
+            {
+                ++run;
+            }
+            if (run >= 64)
+            {
+                flushLiteral();
+                pb.fill(static_cast<uint32_t>(run), target[t]);
+                t += run;
+                continue;
+            }
+
+            size_t matchLen = 0;
+            uint32_t matchOff = 0;
+            if (t + kKey <= target.size())
+            {
+                uint64_t k;
+                std::memcpy(&k, &target[t], kKey);
+                auto it = index.find(k);
+                if (it != index.end())
+                {
+                    matchOff = it->second;
+                    while (matchOff + matchLen < base.size() && t + matchLen < target.size() &&
+                           base[matchOff + matchLen] == target[t + matchLen])
+                    {
+                        ++matchLen;
+                    }
+                }
+            }
+            if (matchLen >= kMinCopy)
+            {
+                flushLiteral();
+                pb.copy(matchOff, static_cast<uint32_t>(matchLen));
+                t += matchLen;
+            }
+            else
+            {
+                literal.push_back(target[t]);
+                ++t;
+            }
+        }
+        flushLiteral();
+        return pb.bytes;
+    }
+
+    // In-memory base + sink wired through the C-style PatchIo callbacks.
+    struct MemIo
+    {
+        const Bytes *base = nullptr;
+        Bytes out;
+        bool failReads = false;
+        bool failWrites = false;
+        bool rejectHeader = false;
+        int headerCalls = 0;
+
+        static bool readBase(void *ctx, uint32_t offset, uint8_t *dst, size_t len)
+        {
+            auto self = static_cast<MemIo *>(ctx);
+            if (self->failReads || offset + len > self->base->size())
+            {
+                return false;
+            }
+            std::memcpy(dst, self->base->data() + offset, len);
+            return true;
+        }
+
+        static bool writeOut(void *ctx, const uint8_t *data, size_t len)
+        {
+            auto self = static_cast<MemIo *>(ctx);
+            if (self->failWrites)
+            {
+                return false;
+            }
+            self->out.insert(self->out.end(), data, data + len);
+            return true;
+        }
+
+        static bool acceptHeader(void *ctx, const PatchHeader &)
+        {
+            auto self = static_cast<MemIo *>(ctx);
+            self->headerCalls++;
+            return !self->rejectHeader;
+        }
+
+        PatchIo io()
+        {
+            PatchIo io;
+            io.ctx = this;
+            io.readBase = &MemIo::readBase;
+            io.writeOut = &MemIo::writeOut;
+            io.acceptHeader = &MemIo::acceptHeader;
+            return io;
+        }
+    };
+
+    // Feeds `patch` in `split`-sized pieces; returns the first failing
+    // feed result or finish().
+    ApplyResult apply(PatchApplier &a, MemIo &io, const Bytes &patch, size_t split)
+    {
+        a.begin(io.io());
+        for (size_t off = 0; off < patch.size(); off += split)
+        {
+            size_t n = std::min(split, patch.size() - off);
+            auto r = a.feed(patch.data() + off, n);
+            if (!r.ok)
+            {
+                return r;
+            }
+        }
+        return a.finish();
+    }
+} // namespace
+
+//=================================================================================================
+// Header parsing
+//=================================================================================================
+
+TEST(OtaDelta, ParseHeaderAcceptsBuiltHeader)
+{
+    Bytes base = makeData(256, 1);
+    PatchBuilder pb(base, base, "1.2.3");
+    auto hr = AstrOsOtaDelta::parseHeader(pb.bytes.data(), pb.bytes.size());
+    ASSERT_TRUE(hr.valid);
+    EXPECT_EQ(Status::OK, hr.status);
+    EXPECT_EQ(256u, hr.header.baseSize);
+    EXPECT_EQ(256u, hr.header.targetSize);
+    EXPECT_STREQ("1.2.3", hr.header.targetVersion);
+}
+
+TEST(OtaDelta, ParseHeaderRejectsFullImage)
+{
+    // A plain ESP32 .bin starts with the 0xE9 image magic — OtaForwarder
+    // relies on this to tell full images from patches.
+    Bytes image = makeData(256, 2);
+    image[0] = 0xE9;
+    auto hr = AstrOsOtaDelta::parseHeader(image.data(), image.size());
+    EXPECT_FALSE(hr.valid);
+    EXPECT_EQ(Status::BAD_MAGIC, hr.status);
+}
+
+TEST(OtaDelta, ParseHeaderShortBufferIsTruncated)
+{
+    PatchBuilder pb(16, 16);
+    auto hr = AstrOsOtaDelta::parseHeader(pb.bytes.data(), sizeof(PatchHeader) - 1);
+    EXPECT_FALSE(hr.valid);
+    EXPECT_EQ(Status::TRUNCATED, hr.status);
+}
+
+TEST(OtaDelta, ParseHeaderRejectsUnknownVersionAndZeroTarget)
+{
+    PatchBuilder v(16, 16);
+    v.bytes[4] = AstrOsOtaDelta::kFormatVersion + 1;
+    EXPECT_EQ(Status::BAD_VERSION, AstrOsOtaDelta::parseHeader(v.bytes.data(), v.bytes.size()).status);
+
+    PatchBuilder z(16, 0);
+    EXPECT_EQ(Status::BAD_HEADER, AstrOsOtaDelta::parseHeader(z.bytes.data(), z.bytes.size()).status);
+
+    PatchBuilder r(16, 16);
+    r.bytes[6] = 1; // reserved byte
+    EXPECT_EQ(Status::BAD_HEADER, AstrOsOtaDelta::parseHeader(r.bytes.data(), r.bytes.size()).status);
+}
+
+//=================================================================================================
+// Round trips
+//=================================================================================================
+
+TEST(OtaDelta, RoundTripIdenticalImageIsTiny)
+{
+    Bytes base = makeData(64 * 1024, 3);
+    Bytes patch = diff(base, base);
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    auto r = apply(a, io, patch, 128);
+    ASSERT_TRUE(r.ok) << static_cast<int>(r.status);
+    EXPECT_EQ(base, io.out);
+    EXPECT_EQ(1, io.headerCalls);
+    EXPECT_LT(patch.size(), 200u);
+}
+
+TEST(OtaDelta, RoundTripPointReleaseMatchesTargetSha)
+{
+    // Point release: a handful of patched constants, a 300 B function
+    // growth that shifts everything after it, and 0xFF flash padding at
+    // the end.
+    Bytes base = makeData(96 * 1024, 4);
+    Bytes target = base;
+    target[100] ^= 0x5A;
+    target[40000] ^= 0x01;
+    Bytes grown = makeData(300, 5);
+    target.insert(target.begin() + 50000, grown.begin(), grown.end());
+    target.insert(target.end(), 2048, 0xFF);
+
+    Bytes patch = diff(base, target);
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    auto r = apply(a, io, patch, 128);
+    ASSERT_TRUE(r.ok) << static_cast<int>(r.status);
+    ASSERT_EQ(target, io.out);
+    EXPECT_EQ(target.size(), a.bytesWritten());
+
+    uint8_t digest[32];
+    sha256(io.out, digest);
+    EXPECT_EQ(0, std::memcmp(digest, a.header().targetSha256, 32));
+
+    // The whole point: the wire carries a small fraction of the image.
+    EXPECT_LT(patch.size() * 20, target.size());
+}
+
+TEST(OtaDelta, RoundTripIndependentOfChunkSplit)
+{
+    Bytes base = makeData(8 * 1024, 6);
+    Bytes target = base;
+    Bytes grown = makeData(77, 7);
+    target.insert(target.begin() + 1000, grown.begin(), grown.end());
+    target.insert(target.end(), 300, 0x00);
+    Bytes patch = diff(base, target);
+
+    // Op headers and INSERT payloads must straddle feed() boundaries.
+    for (size_t split : {size_t(1), size_t(3), size_t(7), size_t(128), size_t(4096), patch.size()})
+    {
+        MemIo io;
+        io.base = &base;
+        PatchApplier a;
+        auto r = apply(a, io, patch, split);
+        ASSERT_TRUE(r.ok) << "split=" << split << " status=" << static_cast<int>(r.status);
+        EXPECT_EQ(target, io.out) << "split=" << split;
+    }
+}
+
+TEST(OtaDelta, RoundTripAllOps)
+{
+    Bytes base = makeData(2000, 8);
+    const uint8_t lit[] = {1, 2, 3, 4, 5};
+    Bytes target;
+    target.insert(target.end(), base.begin() + 1500, base.begin() + 2000);
+    target.insert(target.end(), lit, lit + sizeof(lit));
+    target.insert(target.end(), 1500, 0xAA); // > scratch size
+    target.insert(target.end(), base.begin(), base.begin() + 1200);
+
+    PatchBuilder pb(base, target);
+    pb.copy(1500, 500).insert(lit, sizeof(lit)).fill(1500, 0xAA).copy(0, 1200);
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    auto r = apply(a, io, pb.bytes, 128);
+    ASSERT_TRUE(r.ok) << static_cast<int>(r.status);
+    EXPECT_EQ(target, io.out);
+}
+
+//=================================================================================================
+// Rejections
+//=================================================================================================
+
+TEST(OtaDelta, FeedBeforeBeginIsNotStarted)
+{
+    PatchApplier a;
+    uint8_t b = 0;
+    EXPECT_EQ(Status::NOT_STARTED, a.feed(&b, 1).status);
+    EXPECT_EQ(Status::NOT_STARTED, a.finish().status);
+}
+
+TEST(OtaDelta, HeaderRejectedStopsBeforeAnyWrite)
+{
+    Bytes base = makeData(512, 9);
+    PatchBuilder pb(base, base);
+    pb.copy(0, 512);
+
+    MemIo io;
+    io.base = &base;
+    io.rejectHeader = true;
+    PatchApplier a;
+    auto r = apply(a, io, pb.bytes, 128);
+    EXPECT_EQ(Status::HEADER_REJECTED, r.status);
+    EXPECT_FALSE(a.headerAccepted());
+    EXPECT_TRUE(io.out.empty());
+}
+
+TEST(OtaDelta, CopyPastBaseIsRejected)
+{
+    Bytes base = makeData(512, 10);
+    PatchBuilder pb(512, 600);
+    pb.copy(100, 500);
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    EXPECT_EQ(Status::BASE_OUT_OF_RANGE, apply(a, io, pb.bytes, 128).status);
+    EXPECT_TRUE(io.out.empty());
+}
+
+TEST(OtaDelta, CopyOffsetWrapIsRejected)
+{
+    // offset + length wraps a u32; the 64-bit bounds check must still fire.
+    Bytes base = makeData(512, 11);
+    PatchBuilder pb(512, 64);
+    pb.copy(0xFFFFFFF0u, 0x20);
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    EXPECT_EQ(Status::BASE_OUT_OF_RANGE, apply(a, io, pb.bytes, 128).status);
+}
+
+TEST(OtaDelta, OpPastTargetIsRejected)
+{
+    Bytes base = makeData(512, 12);
+    PatchBuilder pb(512, 100);
+    pb.fill(101, 0xFF);
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    EXPECT_EQ(Status::TARGET_OVERFLOW, apply(a, io, pb.bytes, 128).status);
+    EXPECT_TRUE(io.out.empty());
+}
+
+TEST(OtaDelta, ZeroLengthOpIsRejected)
+{
+    Bytes base = makeData(16, 13);
+    PatchBuilder pb(16, 16);
+    pb.insert(nullptr, 0);
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    EXPECT_EQ(Status::ZERO_LENGTH, apply(a, io, pb.bytes, 128).status);
+}
+
+TEST(OtaDelta, UnknownOpcodeIsRejected)
+{
+    Bytes base = makeData(16, 14);
+    PatchBuilder pb(16, 16);
+    pb.bytes.push_back(0x7F);
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    EXPECT_EQ(Status::BAD_OPCODE, apply(a, io, pb.bytes, 128).status);
+}
+
+TEST(OtaDelta, TrailingBytesAfterFinalOpAreRejected)
+{
+    Bytes base = makeData(64, 15);
+    PatchBuilder pb(base, base);
+    pb.copy(0, 64).fill(1, 0x00); // one op too many
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    EXPECT_EQ(Status::TRAILING_DATA, apply(a, io, pb.bytes, 128).status);
+}
+
+TEST(OtaDelta, TruncatedPatchFailsAtFinish)
+{
+    Bytes base = makeData(64, 16);
+    PatchBuilder pb(base, base);
+    pb.copy(0, 32); // second half never arrives
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    EXPECT_EQ(Status::TRUNCATED, apply(a, io, pb.bytes, 128).status);
+    EXPECT_EQ(32u, a.bytesWritten());
+}
+
+TEST(OtaDelta, ReadAndWriteFailuresPropagate)
+{
+    Bytes base = makeData(64, 17);
+    PatchBuilder pb(base, base);
+    pb.copy(0, 64);
+
+    MemIo readFail;
+    readFail.base = &base;
+    readFail.failReads = true;
+    PatchApplier a;
+    EXPECT_EQ(Status::READ_FAILED, apply(a, readFail, pb.bytes, 128).status);
+
+    MemIo writeFail;
+    writeFail.base = &base;
+    writeFail.failWrites = true;
+    PatchApplier b;
+    EXPECT_EQ(Status::WRITE_FAILED, apply(b, writeFail, pb.bytes, 128).status);
+}
+
+TEST(OtaDelta, ErrorsAreStickyUntilBegin)
+{
+    Bytes base = makeData(64, 18);
+    PatchBuilder bad(64, 64);
+    bad.bytes.push_back(0x7F);
+
+    MemIo io;
+    io.base = &base;
+    PatchApplier a;
+    ASSERT_EQ(Status::BAD_OPCODE, apply(a, io, bad.bytes, 128).status);
+
+    // Valid-looking bytes after the failure do not resurrect the applier.
+    const uint8_t copyOp[] = {0x01, 0, 0, 0, 0, 64, 0, 0, 0};
+    EXPECT_EQ(Status::BAD_OPCODE, a.feed(copyOp, sizeof(copyOp)).status);
+    EXPECT_EQ(Status::BAD_OPCODE, a.finish().status);
+
+    // begin() starts clean.
+    PatchBuilder good(base, base);
+    good.copy(0, 64);
+    MemIo io2;
+    io2.base = &base;
+    EXPECT_TRUE(apply(a, io2, good.bytes, 128).ok);
+    EXPECT_EQ(base, io2.out);
+}
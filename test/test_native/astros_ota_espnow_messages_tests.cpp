@@ -72,15 +72,27 @@ TEST(OtaWirePayloads, OtaBeginPayloadMatchesLittleEndianByteLayout)
     EXPECT_EQ(0u, buf[43]); // flags
 }
 
+TEST(OtaWirePayloads, OtaBeginFlagBitsMatchSpec)
+{
+    // Bits are wire-stable and must stay disjoint so DELTA | COMPRESSED
+    // (a compressed patch) is representable.
+    EXPECT_EQ(0x01, OTA_BEGIN_FLAG_PSRAM_BUFFER);
+    EXPECT_EQ(0x02, OTA_BEGIN_FLAG_DELTA);
+    EXPECT_EQ(0x04, OTA_BEGIN_FLAG_COMPRESSED);
+    EXPECT_EQ(0x08, OTA_BEGIN_FLAG_RESUME);
+    EXPECT_EQ(0, OTA_BEGIN_FLAG_DELTA & OTA_BEGIN_FLAG_COMPRESSED);
+}
+
 TEST(OtaWirePayloads, OtaDataNakReasonValuesMatchSpec)
 {
-    // Spec freezes these values: CRC=1, SIZE=2, OUT_OF_ORDER=3, WRITE=4.
-    // Reordering or renumbering breaks the wire contract.
+    // Spec freezes these values: CRC=1, SIZE=2, OUT_OF_ORDER=3, WRITE=4,
+    // BLOCK=5. Reordering or renumbering breaks the wire contract.
     EXPECT_EQ(0, static_cast<int>(OtaDataNakReason::NONE));
     EXPECT_EQ(1, static_cast<int>(OtaDataNakReason::CRC));
     EXPECT_EQ(2, static_cast<int>(OtaDataNakReason::SIZE));
     EXPECT_EQ(3, static_cast<int>(OtaDataNakReason::OUT_OF_ORDER));
     EXPECT_EQ(4, static_cast<int>(OtaDataNakReason::WRITE));
+    EXPECT_EQ(5, static_cast<int>(OtaDataNakReason::BLOCK));
 }
 
 TEST(OtaWirePayloads, OtaBeginNakReasonValuesMatchSpec)
@@ -346,6 +358,62 @@ TEST(OtaRecordParsers, ParseOtaBeginRejectsWrongPacketType)
         free(pkt.data);
 }
 
+TEST(OtaRecordParsers, ParseOtaBeginMerkleRoundTrip)
+{
+    auto svc = AstrOsEspNowMessageService();
+    uint8_t wire[OTA_BEGIN_MERKLE_SIZE] = {0};
+    OtaBeginPayload head{};
+    head.xferId = 0x42;
+    head.totalSize = 1228800 + 299 * 32;
+    head.chunkSize = 128;
+    head.totalChunks = (head.totalSize + 127) / 128;
+    head.flags = OTA_BEGIN_FLAG_MERKLE | OTA_BEGIN_FLAG_RESUME;
+    OtaBeginMerkleExt ext{};
+    ext.dataSize = 1228800;
+    ext.blockLog2 = 12;
+    for (int i = 0; i < 32; i++)
+        ext.root[i] = static_cast<uint8_t>(0xA0 + i);
+    std::memcpy(wire, &head, sizeof(head));
+    std::memcpy(wire + sizeof(head), &ext, sizeof(ext));
+
+    auto packets = svc.generateOtaPacket(AstrOsPacketType::OTA_BEGIN, wire, sizeof(wire));
+    ASSERT_EQ(1u, packets.size());
+    auto parsed = svc.parsePacket(packets[0].data);
+
+    auto rec = AstrOsEspNowProtocol::parseOtaBegin(parsed);
+    ASSERT_TRUE(rec.valid);
+    EXPECT_EQ(head.totalSize, rec.totalSize);
+    EXPECT_EQ(head.flags, rec.flags);
+    EXPECT_EQ(1228800u, rec.merkleDataSize);
+    EXPECT_EQ(12u, rec.merkleBlockLog2);
+    EXPECT_EQ(0, std::memcmp(ext.root, rec.merkleRoot, 32));
+
+    for (auto &pkt : packets)
+        free(pkt.data);
+}
+
+TEST(OtaRecordParsers, ParseOtaBeginRejectsMerkleFlagSizeMismatch)
+{
+    // The MERKLE flag and the 37-byte trailer come together: a flagged
+    // 44-byte BEGIN and an unflagged 81-byte BEGIN are both malformed.
+    auto svc = AstrOsEspNowMessageService();
+    OtaBeginPayload flagged{};
+    flagged.flags = OTA_BEGIN_FLAG_MERKLE;
+    auto packets = svc.generateOtaPacket(AstrOsPacketType::OTA_BEGIN, reinterpret_cast<const uint8_t *>(&flagged),
+                                         sizeof(flagged));
+    ASSERT_EQ(1u, packets.size());
+    EXPECT_FALSE(AstrOsEspNowProtocol::parseOtaBegin(svc.parsePacket(packets[0].data)).valid);
+    for (auto &pkt : packets)
+        free(pkt.data);
+
+    uint8_t wire[OTA_BEGIN_MERKLE_SIZE] = {0};
+    packets = svc.generateOtaPacket(AstrOsPacketType::OTA_BEGIN, wire, sizeof(wire));
+    ASSERT_EQ(1u, packets.size());
+    EXPECT_FALSE(AstrOsEspNowProtocol::parseOtaBegin(svc.parsePacket(packets[0].data)).valid);
+    for (auto &pkt : packets)
+        free(pkt.data);
+}
+
 TEST(OtaRecordParsers, ParseOtaDataRoundTrip)
 {
     auto svc = AstrOsEspNowMessageService();
@@ -444,6 +512,57 @@ TEST(OtaRecordParsers, ParseOtaBeginAckRoundTrip)
         free(pkt.data);
 }
 
+TEST(OtaRecordParsers, ParseOtaBeginAckCarriesResumeSeq)
+{
+    auto svc = AstrOsEspNowMessageService();
+    OtaBeginAckPayload original{0x42, 1234};
+    auto packets = svc.generateOtaPacket(AstrOsPacketType::OTA_BEGIN_ACK, reinterpret_cast<const uint8_t *>(&original),
+                                         sizeof(original));
+    ASSERT_EQ(1u, packets.size());
+    auto parsed = svc.parsePacket(packets[0].data);
+
+    auto rec = AstrOsEspNowProtocol::parseOtaBeginAck(parsed);
+    ASSERT_TRUE(rec.valid);
+    EXPECT_EQ(0x42, rec.xferId);
+    EXPECT_EQ(1234u, rec.resumeSeq);
+
+    for (auto &pkt : packets)
+        free(pkt.data);
+}
+
+TEST(OtaRecordParsers, ParseOtaBeginAckAcceptsLegacyOneByteFrame)
+{
+    // Padawans that predate resume (or were not offered it) send only the
+    // xferId. Parses as a fresh transfer.
+    auto svc = AstrOsEspNowMessageService();
+    const uint8_t legacy[OTA_BEGIN_ACK_LEGACY_SIZE] = {0x42};
+    auto packets = svc.generateOtaPacket(AstrOsPacketType::OTA_BEGIN_ACK, legacy, sizeof(legacy));
+    ASSERT_EQ(1u, packets.size());
+    auto parsed = svc.parsePacket(packets[0].data);
+
+    auto rec = AstrOsEspNowProtocol::parseOtaBeginAck(parsed);
+    ASSERT_TRUE(rec.valid);
+    EXPECT_EQ(0x42, rec.xferId);
+    EXPECT_EQ(0u, rec.resumeSeq);
+
+    for (auto &pkt : packets)
+        free(pkt.data);
+}
+
+TEST(OtaRecordParsers, ParseOtaBeginAckRejectsOtherSizes)
+{
+    auto svc = AstrOsEspNowMessageService();
+    const uint8_t truncated[3] = {0x42, 0x01, 0x02};
+    auto packets = svc.generateOtaPacket(AstrOsPacketType::OTA_BEGIN_ACK, truncated, sizeof(truncated));
+    ASSERT_EQ(1u, packets.size());
+    auto parsed = svc.parsePacket(packets[0].data);
+
+    EXPECT_FALSE(AstrOsEspNowProtocol::parseOtaBeginAck(parsed).valid);
+
+    for (auto &pkt : packets)
+        free(pkt.data);
+}
+
 TEST(OtaRecordParsers, ParseOtaBeginNakRoundTrip)
 {
     auto svc = AstrOsEspNowMessageService();
@@ -536,7 +655,7 @@ TEST(OtaRecordParsers, ParseOtaDataNakRejectsNoneReason)
 
 TEST(OtaRecordParsers, ParseOtaDataNakRejectsAboveWriteReason)
 {
-    // Upper bound: reason byte > WRITE (4) is out of range. Mirrors the
+    // Upper bound: reason byte > BLOCK (5) is out of range. Mirrors the
     // NONE-reason rejection on the lower bound, and the analogous Begin/End
     // out-of-range tests.
     auto svc = AstrOsEspNowMessageService();
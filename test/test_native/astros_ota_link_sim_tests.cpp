@@ -0,0 +1,257 @@
+#include <AstrOsOtaLinkSim.hpp>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+using AstrOsOtaLinkSim::ChannelModel;
+using AstrOsOtaLinkSim::Outcome;
+using AstrOsOtaLinkSim::Path;
+using AstrOsOtaLinkSim::TransferConfig;
+using AstrOsOtaLinkSim::TransferResult;
+
+namespace
+{
+    // 1 Mbit/s ESP-NOW with ~48 B of MAC / vendor-IE / packet framing per
+    // frame and a couple of ms through the WiFi stack.
+    ChannelModel espNowLink()
+    {
+        ChannelModel m;
+        m.bytesPerSec = 125000;
+        m.frameOverheadBytes = 48;
+        m.latencyUs = 2000;
+        m.jitterUs = 500;
+        return m;
+    }
+
+    Path symmetric(const ChannelModel &m)
+    {
+        return Path{m, m};
+    }
+
+    TransferConfig smallImage()
+    {
+        TransferConfig c;
+        c.imageSize = 16 * 1024 + 77; // short last chunk
+        return c;
+    }
+} // namespace
+
+TEST(AstrOsOtaLinkSim, CleanLinkCompletesWithoutRetransmits)
+{
+    const TransferConfig c = smallImage();
+    TransferResult r = AstrOsOtaLinkSim::simulateTransfer(c, symmetric(espNowLink()), 1);
+
+    ASSERT_EQ(r.outcome, Outcome::COMPLETED) << AstrOsOtaLinkSim::outcomeName(r.outcome);
+    EXPECT_EQ(r.chunks, (c.imageSize + c.chunkSize - 1) / c.chunkSize);
+    EXPECT_EQ(r.dataFrames, r.chunks);
+    EXPECT_EQ(r.retransmits, 0u);
+    EXPECT_EQ(r.acks, r.chunks);
+    EXPECT_EQ(r.naks, 0u);
+    EXPECT_EQ(r.framesLost, 0u);
+    EXPECT_GT(r.goodputBytesPerSec(), 0.0);
+    // Every chunk draws one 10 B ACK plus framing back.
+    EXPECT_NEAR(r.ackOverhead(), double(r.chunks) * (10 + 48) / c.imageSize, 0.01);
+}
+
+TEST(AstrOsOtaLinkSim, SameSeedSameResult)
+{
+    ChannelModel m = espNowLink();
+    m.lossRate = 0.05;
+    m.duplicateRate = 0.02;
+    TransferConfig c = smallImage();
+    c.maxRetries = 10;
+
+    TransferResult a = AstrOsOtaLinkSim::simulateTransfer(c, symmetric(m), 42);
+    TransferResult b = AstrOsOtaLinkSim::simulateTransfer(c, symmetric(m), 42);
+    TransferResult other = AstrOsOtaLinkSim::simulateTransfer(c, symmetric(m), 43);
+    EXPECT_EQ(a.outcome, b.outcome);
+    EXPECT_EQ(a.elapsedUs, b.elapsedUs);
+    EXPECT_EQ(a.dataFrames, b.dataFrames);
+    EXPECT_EQ(a.framesLost, b.framesLost);
+    EXPECT_NE(a.elapsedUs, other.elapsedUs);
+}
+
+TEST(AstrOsOtaLinkSim, RandomLossRecoversThroughRetransmits)
+{
+    ChannelModel m = espNowLink();
+    m.lossRate = 0.05;
+    TransferConfig c = smallImage();
+    c.ackTimeoutMs = 200;
+    c.maxRetries = 10;
+
+    TransferResult r = AstrOsOtaLinkSim::simulateTransfer(c, symmetric(m), 7);
+    ASSERT_EQ(r.outcome, Outcome::COMPLETED) << AstrOsOtaLinkSim::outcomeName(r.outcome);
+    EXPECT_GT(r.framesLost, 0u);
+    EXPECT_GT(r.retransmits, 0u);
+    EXPECT_EQ(r.dataFrames, r.chunks + r.retransmits);
+    // Slower than the clean link, but it got there.
+    TransferResult clean = AstrOsOtaLinkSim::simulateTransfer(c, symmetric(espNowLink()), 7);
+    EXPECT_LT(r.goodputBytesPerSec(), clean.goodputBytesPerSec());
+}
+
+TEST(AstrOsOtaLinkSim, DuplicatesReorderingAndCorruptionNeverReachTheImage)
+{
+    ChannelModel m = espNowLink();
+    m.duplicateRate = 0.1;
+    m.reorderRate = 0.1;
+    m.reorderDelayUs = 8000;
+    m.jitterUs = 3000;
+    m.corruptRate = 0.03;
+    TransferConfig c = smallImage();
+    c.windowSize = 8;
+    c.ackTimeoutMs = 300;
+    c.maxRetries = 10;
+
+    for (uint64_t seed = 1; seed <= 5; seed++)
+    {
+        TransferResult r = AstrOsOtaLinkSim::simulateTransfer(c, symmetric(m), seed);
+        // COMPLETED also means the reassembled image matched byte for byte.
+        ASSERT_EQ(r.outcome, Outcome::COMPLETED) << "seed " << seed << ": " << AstrOsOtaLinkSim::outcomeName(r.outcome);
+        EXPECT_GT(r.naks, 0u) << seed;
+    }
+}
+
+TEST(AstrOsOtaLinkSim, TimeoutShorterThanRoundTripAbandons)
+{
+    ChannelModel m;
+    m.latencyUs = 100 * 1000;
+    TransferConfig c = smallImage();
+    c.ackTimeoutMs = 50;
+    c.maxRetries = 2;
+
+    TransferResult r = AstrOsOtaLinkSim::simulateTransfer(c, symmetric(m), 1);
+    EXPECT_EQ(r.outcome, Outcome::ABANDONED);
+    EXPECT_GT(r.tickRetransmits, 0u);
+    EXPECT_EQ(r.goodputBytesPerSec(), 0.0);
+}
+
+TEST(AstrOsOtaLinkSim, DeadReverseChannelTimesOutTheHandshake)
+{
+    ChannelModel dead;
+    dead.lossRate = 1.0;
+    TransferResult r = AstrOsOtaLinkSim::simulateTransfer(smallImage(), Path{espNowLink(), dead}, 1);
+    EXPECT_EQ(r.outcome, Outcome::HANDSHAKE_TIMEOUT);
+    EXPECT_EQ(r.elapsedUs, 5000u * 1000u);
+    EXPECT_EQ(r.dataFrames, 0u);
+}
+
+TEST(AstrOsOtaLinkSim, SerializationRateBoundsGoodput)
+{
+    ChannelModel m;
+    m.bytesPerSec = 50000;
+    TransferConfig c = smallImage();
+    c.windowSize = 16;
+
+    TransferResult r = AstrOsOtaLinkSim::simulateTransfer(c, symmetric(m), 1);
+    ASSERT_TRUE(r.completed());
+    // Header bytes share the link, so goodput sits just under the line rate.
+    const double payloadShare = double(c.chunkSize) / (c.chunkSize + 9);
+    EXPECT_LT(r.goodputBytesPerSec(), m.bytesPerSec * payloadShare);
+    EXPECT_GT(r.goodputBytesPerSec(), m.bytesPerSec * payloadShare * 0.9);
+}
+
+TEST(AstrOsOtaLinkSim, RejectsInvalidConfig)
+{
+    TransferConfig c = smallImage();
+    c.windowSize = 0;
+    EXPECT_EQ(AstrOsOtaLinkSim::simulateTransfer(c, symmetric(espNowLink()), 1).outcome, Outcome::INVALID_CONFIG);
+    c = smallImage();
+    c.chunkSize = 0;
+    EXPECT_EQ(AstrOsOtaLinkSim::simulateTransfer(c, symmetric(espNowLink()), 1).outcome, Outcome::INVALID_CONFIG);
+}
+
+TEST(AstrOsOtaLinkSim, DeployRunsReceiversInTurn)
+{
+    ChannelModel dead;
+    dead.lossRate = 1.0;
+    const Path paths[] = {symmetric(espNowLink()), Path{dead, dead}, symmetric(espNowLink())};
+
+    auto d = AstrOsOtaLinkSim::simulateDeploy(smallImage(), paths, 3, 9);
+    ASSERT_EQ(d.transfers.size(), 3u);
+    EXPECT_EQ(d.completed, 2u);
+    EXPECT_EQ(d.transfers[1].outcome, Outcome::HANDSHAKE_TIMEOUT);
+    EXPECT_EQ(d.elapsedUs, d.transfers[0].elapsedUs + d.transfers[1].elapsedUs + d.transfers[2].elapsedUs);
+    EXPECT_LT(d.goodputBytesPerSec(), d.transfers[0].goodputBytesPerSec());
+}
+
+// Goodput sweep over window / chunk / ACK timeout on a few link profiles.
+// Disabled by default (a report, not a check); run with
+//   --gtest_also_run_disabled_tests --gtest_filter=AstrOsOtaLinkSim.DISABLED_GoodputSweep
+TEST(AstrOsOtaLinkSim, DISABLED_GoodputSweep)
+{
+    struct Profile
+    {
+        const char *name;
+        Path path;
+    };
+    std::vector<Profile> profiles;
+    profiles.push_back({"clean", symmetric(espNowLink())});
+    {
+        ChannelModel m = espNowLink();
+        m.lossRate = 0.02;
+        profiles.push_back({"loss 2%", symmetric(m)});
+    }
+    {
+        ChannelModel m = espNowLink();
+        m.lossRate = 0.01;
+        m.burstEnterRate = 0.005;
+        m.burstExitRate = 0.1;
+        profiles.push_back({"burst ~5%", symmetric(m)});
+    }
+    {
+        ChannelModel m = espNowLink();
+        m.lossRate = 0.02;
+        m.jitterUs = 4000;
+        m.reorderRate = 0.05;
+        m.reorderDelayUs = 10000;
+        m.duplicateRate = 0.02;
+        profiles.push_back({"messy", symmetric(m)});
+    }
+
+    constexpr uint64_t kSeeds = 20;
+    TransferConfig base;
+    base.imageSize = 256 * 1024;
+
+    std::printf("[ LINK SIM ] %-10s %3s %5s %5s | %5s %9s %8s %8s %7s %6s\n", "profile", "win", "chunk", "tmo",
+                "ok", "goodput", "time", "retx", "nak", "ack/B");
+    for (const auto &p : profiles)
+    {
+        for (uint8_t window : {uint8_t(4), uint8_t(8), uint8_t(16)})
+        {
+            for (uint16_t chunk : {uint16_t(128), uint16_t(232)})
+            {
+                for (uint32_t timeout : {300u, 1500u})
+                {
+                    TransferConfig c = base;
+                    c.windowSize = window;
+                    c.chunkSize = chunk;
+                    c.ackTimeoutMs = timeout;
+
+                    uint32_t ok = 0;
+                    double goodput = 0, seconds = 0, retx = 0, naks = 0, overhead = 0;
+                    for (uint64_t seed = 1; seed <= kSeeds; seed++)
+                    {
+                        TransferResult r = AstrOsOtaLinkSim::simulateTransfer(c, p.path, seed);
+                        EXPECT_NE(r.outcome, Outcome::CORRUPTED) << p.name << " seed " << seed;
+                        if (!r.completed())
+                        {
+                            continue;
+                        }
+                        ok++;
+                        goodput += r.goodputBytesPerSec();
+                        seconds += r.elapsedUs / 1e6;
+                        retx += r.retransmits;
+                        naks += r.naks;
+                        overhead += r.ackOverhead();
+                    }
+                    const double n = std::max<uint32_t>(ok, 1);
+                    std::printf("[ LINK SIM ] %-10s %3u %5u %5u | %2u/%2u %6.1fKB/s %7.2fs %8.0f %7.0f %6.3f\n",
+                                p.name, window, chunk, timeout, ok, (unsigned)kSeeds, goodput / n / 1024,
+                                seconds / n, retx / n, naks / n, overhead / n);
+                }
+            }
+        }
+    }
+}
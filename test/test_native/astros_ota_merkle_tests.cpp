@@ -0,0 +1,385 @@
+#include <AstrOsOtaMerkle.hpp>
+#include <AstrOsSha256.h>
+#include <gtest/gtest.h>
+
+#include "astros_test_helpers.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using AstrOsOtaMerkle::BlockVerifier;
+using AstrOsOtaMerkle::Geometry;
+using AstrOsOtaMerkle::kHashSize;
+using AstrOsOtaMerkle::Status;
+using AstrOsOtaMerkle::StreamEncoder;
+using AstrOsOtaMerkle::VerifierState;
+using AstrOsOtaMerkle::VerifyResult;
+
+namespace
+{
+    using AstrOsTestHelpers::Bytes;
+    using AstrOsTestHelpers::makeData;
+    using Digest = std::array<uint8_t, kHashSize>;
+
+    Bytes leafTable(const Geometry &geo, const Bytes &data)
+    {
+        Bytes leaves(geo.blockCount() * kHashSize);
+        for (uint32_t b = 0; b < geo.blockCount(); b++)
+        {
+            AstrOsOtaMerkle::hashLeaf(data.data() + (size_t(b) << geo.blockLog2()), geo.blockLen(b),
+                                      leaves.data() + b * kHashSize);
+        }
+        return leaves;
+    }
+
+    // Straight transcription of the tree definition, level by level — the
+    // oracle for StreamEncoder's fold and BlockVerifier's path walk.
+    Digest referenceRoot(const Geometry &geo, const Bytes &data)
+    {
+        std::vector<Digest> level(geo.blockCount());
+        Bytes leaves = leafTable(geo, data);
+        for (uint32_t b = 0; b < geo.blockCount(); b++)
+        {
+            std::memcpy(level[b].data(), leaves.data() + b * kHashSize, kHashSize);
+        }
+        while (level.size() > 1)
+        {
+            std::vector<Digest> up((level.size() + 1) / 2);
+            for (size_t j = 0; j < up.size(); j++)
+            {
+                if (2 * j + 1 < level.size())
+                {
+                    AstrOsOtaMerkle::hashNode(level[2 * j].data(), level[2 * j + 1].data(), up[j].data());
+                }
+                else
+                {
+                    up[j] = level[2 * j];
+                }
+            }
+            level.swap(up);
+        }
+        return level[0];
+    }
+
+    struct Source
+    {
+        const Bytes *data = nullptr;
+        static bool read(void *ctx, uint32_t offset, uint8_t *out, size_t len)
+        {
+            auto *self = static_cast<Source *>(ctx);
+            if (offset + len > self->data->size())
+            {
+                return false;
+            }
+            std::memcpy(out, self->data->data() + offset, len);
+            return true;
+        }
+    };
+
+    // Data + tree + the full framed stream for one test image.
+    struct Fixture
+    {
+        Bytes data;
+        Geometry geo;
+        Bytes leaves;
+        Source src;
+        StreamEncoder enc;
+        Digest root{};
+        Bytes stream;
+
+        Fixture(size_t len, uint8_t blockLog2 = AstrOsOtaMerkle::kDefaultBlockLog2, uint32_t seed = 1)
+            : data(makeData(len, seed))
+        {
+            EXPECT_TRUE(geo.init(static_cast<uint32_t>(len), blockLog2));
+            leaves = leafTable(geo, data);
+            src.data = &data;
+            enc.begin(geo, leaves.data(), &Source::read, &src);
+            enc.root(root.data());
+            stream.resize(geo.streamSize());
+            EXPECT_TRUE(enc.read(0, stream.data(), stream.size()));
+        }
+    };
+
+    // Collects verified blocks; optionally snapshots the verifier state after
+    // a given block, the way OtaWriter takes a resume checkpoint.
+    struct Sink
+    {
+        Bytes out;
+        std::vector<Digest> leaves;
+        const BlockVerifier *verifier = nullptr;
+        uint32_t snapshotAfter = UINT32_MAX;
+        VerifierState snapshot{};
+        bool failWrites = false;
+
+        static bool write(void *ctx, uint32_t block, const uint8_t *data, size_t len, const uint8_t leaf[kHashSize])
+        {
+            auto *self = static_cast<Sink *>(ctx);
+            if (self->failWrites)
+            {
+                return false;
+            }
+            EXPECT_EQ(self->leaves.size(), block);
+            self->out.insert(self->out.end(), data, data + len);
+            Digest d;
+            std::memcpy(d.data(), leaf, kHashSize);
+            self->leaves.push_back(d);
+            if (block == self->snapshotAfter && self->verifier != nullptr)
+            {
+                self->snapshot = self->verifier->state();
+            }
+            return true;
+        }
+    };
+
+    // Feeds stream[from, end) in `chunk`-sized pieces tagged with their
+    // offsets, stopping at the first failure.
+    VerifyResult feedChunks(BlockVerifier &v, const Bytes &stream, size_t chunk, size_t from = 0)
+    {
+        for (size_t off = from; off < stream.size(); off += chunk)
+        {
+            const size_t n = std::min(chunk, stream.size() - off);
+            VerifyResult r = v.feed(static_cast<uint32_t>(off), stream.data() + off, n);
+            if (!r.ok)
+            {
+                return r;
+            }
+        }
+        return VerifyResult::success();
+    }
+} // namespace
+
+TEST(AstrOsOtaMerkle, GeometryRejectsBadParameters)
+{
+    Geometry g;
+    EXPECT_FALSE(g.init(0, 12));
+    EXPECT_FALSE(g.init(4096, AstrOsOtaMerkle::kMinBlockLog2 - 1));
+    EXPECT_FALSE(g.init(4096, AstrOsOtaMerkle::kMaxBlockLog2 + 1));
+    // One block over the height cap.
+    EXPECT_FALSE(g.init((uint32_t(1) << (AstrOsOtaMerkle::kMaxLevels + 10)) + 1, 10));
+    EXPECT_FALSE(g.valid());
+    EXPECT_TRUE(g.init(uint32_t(1) << (AstrOsOtaMerkle::kMaxLevels + 10), 10));
+    EXPECT_EQ(g.height(), AstrOsOtaMerkle::kMaxLevels);
+}
+
+TEST(AstrOsOtaMerkle, GeometryRecordLayoutIsConsistent)
+{
+    for (uint32_t blocks : {1u, 2u, 3u, 4u, 5u, 7u, 8u, 9u, 31u, 33u, 100u})
+    {
+        Geometry g;
+        const uint32_t size = blocks * 1024 - (blocks > 1 ? 100 : 0);
+        ASSERT_TRUE(g.init(size, 10)) << blocks;
+        ASSERT_EQ(g.blockCount(), blocks);
+
+        uint32_t offset = 0;
+        uint32_t hashes = 0;
+        for (uint32_t b = 0; b < blocks; b++)
+        {
+            ASSERT_EQ(g.recordStart(b), offset) << "blocks=" << blocks << " b=" << b;
+            EXPECT_EQ(g.recordAt(offset), b);
+            const uint32_t recordLen = g.siblingCount(b) * kHashSize + g.blockLen(b);
+            EXPECT_EQ(g.recordAt(offset + recordLen - 1), b);
+            // Siblings come bottom-up.
+            for (uint8_t i = 1; i < g.siblingCount(b); i++)
+            {
+                EXPECT_LT(g.siblingLevel(b, i - 1), g.siblingLevel(b, i));
+            }
+            hashes += g.siblingCount(b);
+            offset += recordLen;
+        }
+        EXPECT_EQ(hashes, blocks - 1) << blocks;
+        EXPECT_EQ(offset, g.streamSize());
+        EXPECT_EQ(g.recordStart(blocks), g.streamSize());
+        EXPECT_EQ(g.streamSize(), size + (blocks - 1) * kHashSize);
+    }
+}
+
+TEST(AstrOsOtaMerkle, EncoderRootMatchesReferenceTree)
+{
+    for (size_t len : {1u, 4096u, 4097u, 3 * 4096u, 5 * 4096u + 17, 8 * 4096u, 9 * 4096u - 1, 37 * 4096u + 5})
+    {
+        Fixture f(len, 12, static_cast<uint32_t>(len));
+        EXPECT_EQ(f.root, referenceRoot(f.geo, f.data)) << len;
+    }
+}
+
+TEST(AstrOsOtaMerkle, SingleBlockRootIsTheLeaf)
+{
+    Fixture f(1000, 10);
+    Digest leaf;
+    AstrOsOtaMerkle::hashLeaf(f.data.data(), f.data.size(), leaf.data());
+    EXPECT_EQ(f.root, leaf);
+    EXPECT_EQ(f.stream, f.data); // nothing to carry
+}
+
+TEST(AstrOsOtaMerkle, RoundTripAcrossChunkSplits)
+{
+    Fixture f(37 * 1024 + 300, 10);
+    for (size_t chunk : {1u, 7u, 32u, 128u, 1000u, 4096u})
+    {
+        Sink sink;
+        BlockVerifier v;
+        ASSERT_TRUE(v.begin(f.geo, f.root.data(), &Sink::write, &sink));
+        VerifyResult r = feedChunks(v, f.stream, chunk);
+        ASSERT_TRUE(r.ok) << "chunk=" << chunk << " status=" << (int)r.status;
+        EXPECT_TRUE(v.finish().ok);
+        EXPECT_EQ(sink.out, f.data) << chunk;
+        ASSERT_EQ(sink.leaves.size(), f.geo.blockCount());
+        for (uint32_t b = 0; b < f.geo.blockCount(); b++)
+        {
+            EXPECT_EQ(0, std::memcmp(sink.leaves[b].data(), f.leaves.data() + b * kHashSize, kHashSize));
+        }
+    }
+}
+
+TEST(AstrOsOtaMerkle, CorruptBlockIsRejectedAndResentAlone)
+{
+    Fixture f(20 * 1024, 10);
+    const uint32_t bad = 13;
+    Bytes wire = f.stream;
+    const uint32_t dataAt = f.geo.recordStart(bad) + f.geo.siblingCount(bad) * kHashSize + 500;
+    wire[dataAt] ^= 0x40;
+
+    Sink sink;
+    BlockVerifier v;
+    ASSERT_TRUE(v.begin(f.geo, f.root.data(), &Sink::write, &sink));
+    constexpr size_t kChunk = 128;
+    VerifyResult r = feedChunks(v, wire, kChunk);
+    ASSERT_EQ(r.status, Status::BLOCK_MISMATCH);
+    EXPECT_EQ(r.block, bad);
+    EXPECT_EQ(r.resendFrom, f.geo.recordStart(bad));
+    EXPECT_EQ(v.cursor(), r.resendFrom);
+    // Nothing from the bad block reached the sink.
+    EXPECT_EQ(sink.out.size(), size_t(bad) * 1024);
+
+    // Resend from the chunk holding the record start — the overlap before
+    // it is skipped.
+    const size_t resendChunk = r.resendFrom / kChunk * kChunk;
+    ASSERT_TRUE(feedChunks(v, f.stream, kChunk, resendChunk).ok);
+    EXPECT_TRUE(v.finish().ok);
+    EXPECT_EQ(sink.out, f.data);
+}
+
+TEST(AstrOsOtaMerkle, CorruptCarriedSiblingIsRejectedAtItsRecord)
+{
+    Fixture f(16 * 1024, 10);
+    // Record 0 carries a sibling for every level; damage the top one.
+    ASSERT_EQ(f.geo.siblingCount(0), f.geo.height());
+    Bytes wire = f.stream;
+    wire[(f.geo.height() - 1) * kHashSize + 3] ^= 0x01;
+
+    Sink sink;
+    BlockVerifier v;
+    ASSERT_TRUE(v.begin(f.geo, f.root.data(), &Sink::write, &sink));
+    VerifyResult r = feedChunks(v, wire, 128);
+    ASSERT_EQ(r.status, Status::BLOCK_MISMATCH);
+    EXPECT_EQ(r.block, 0u);
+    EXPECT_TRUE(sink.out.empty());
+    ASSERT_TRUE(feedChunks(v, f.stream, 128).ok);
+    EXPECT_EQ(sink.out, f.data);
+}
+
+TEST(AstrOsOtaMerkle, WrongRootRejectsTheFirstBlock)
+{
+    Fixture f(8 * 1024, 10);
+    Digest wrong = f.root;
+    wrong[0] ^= 0xFF;
+    Sink sink;
+    BlockVerifier v;
+    ASSERT_TRUE(v.begin(f.geo, wrong.data(), &Sink::write, &sink));
+    VerifyResult r = feedChunks(v, f.stream, 128);
+    EXPECT_EQ(r.status, Status::BLOCK_MISMATCH);
+    EXPECT_EQ(r.block, 0u);
+    EXPECT_TRUE(sink.out.empty());
+}
+
+TEST(AstrOsOtaMerkle, ResumeFromSnapshotContinuesVerification)
+{
+    Fixture f(45 * 1024 + 10, 10);
+    const uint32_t stopAfter = 22;
+    constexpr size_t kChunk = 128;
+
+    // First session: snapshot after block 22, then "lose power".
+    Sink first;
+    BlockVerifier v1;
+    first.verifier = &v1;
+    first.snapshotAfter = stopAfter;
+    ASSERT_TRUE(v1.begin(f.geo, f.root.data(), &Sink::write, &first));
+    const uint32_t cut = f.geo.recordStart(stopAfter + 2);
+    ASSERT_TRUE(feedChunks(v1, Bytes(f.stream.begin(), f.stream.begin() + cut), kChunk).ok);
+    ASSERT_EQ(first.snapshot.nextBlock, stopAfter + 1);
+
+    // Second session: a fresh verifier from the snapshot, fed from the
+    // chunk that holds the resume record's start.
+    Sink second;
+    BlockVerifier v2;
+    ASSERT_TRUE(v2.resume(f.geo, f.root.data(), first.snapshot, &Sink::write, &second));
+    const uint32_t resumeAt = f.geo.recordStart(first.snapshot.nextBlock);
+    EXPECT_EQ(v2.cursor(), resumeAt);
+    second.leaves.resize(first.snapshot.nextBlock); // block numbering continues
+    ASSERT_TRUE(feedChunks(v2, f.stream, kChunk, resumeAt / kChunk * kChunk).ok);
+    EXPECT_TRUE(v2.finish().ok);
+
+    Bytes rebuilt(first.out.begin(), first.out.begin() + size_t(first.snapshot.nextBlock) * 1024);
+    rebuilt.insert(rebuilt.end(), second.out.begin(), second.out.end());
+    EXPECT_EQ(rebuilt, f.data);
+}
+
+TEST(AstrOsOtaMerkle, ResumeRejectsFinishedState)
+{
+    Fixture f(4 * 1024, 10);
+    VerifierState s;
+    s.nextBlock = f.geo.blockCount();
+    BlockVerifier v;
+    EXPECT_FALSE(v.resume(f.geo, f.root.data(), s, nullptr, nullptr));
+    EXPECT_EQ(v.feed(0, f.stream.data(), 1).status, Status::NOT_STARTED);
+}
+
+TEST(AstrOsOtaMerkle, StructuralErrorsAreSticky)
+{
+    Fixture f(4 * 1024, 10);
+    {
+        BlockVerifier v;
+        ASSERT_TRUE(v.begin(f.geo, f.root.data(), nullptr, nullptr));
+        EXPECT_EQ(v.feed(10, f.stream.data() + 10, 5).status, Status::GAP);
+        EXPECT_EQ(v.feed(0, f.stream.data(), 5).status, Status::GAP);
+    }
+    {
+        BlockVerifier v;
+        ASSERT_TRUE(v.begin(f.geo, f.root.data(), nullptr, nullptr));
+        Bytes longer = f.stream;
+        longer.push_back(0);
+        EXPECT_EQ(v.feed(0, longer.data(), longer.size()).status, Status::OVERFLOW);
+    }
+    {
+        BlockVerifier v;
+        ASSERT_TRUE(v.begin(f.geo, f.root.data(), nullptr, nullptr));
+        ASSERT_TRUE(v.feed(0, f.stream.data(), f.stream.size() - 1).ok);
+        EXPECT_EQ(v.finish().status, Status::TRUNCATED);
+    }
+    {
+        Sink sink;
+        sink.failWrites = true;
+        BlockVerifier v;
+        ASSERT_TRUE(v.begin(f.geo, f.root.data(), &Sink::write, &sink));
+        EXPECT_EQ(feedChunks(v, f.stream, 128).status, Status::WRITE_FAILED);
+        EXPECT_EQ(v.finish().status, Status::WRITE_FAILED);
+    }
+}
+
+TEST(AstrOsOtaMerkle, EncoderReadsArbitraryRangesAndRejectsOverrun)
+{
+    Fixture f(9 * 1024 + 77, 10);
+    // Re-reading any window (a retransmit) returns the same bytes.
+    for (uint32_t off : {0u, 31u, 32u, 1000u, 5000u, f.geo.streamSize() - 128})
+    {
+        uint8_t buf[128];
+        ASSERT_TRUE(f.enc.read(off, buf, sizeof(buf))) << off;
+        EXPECT_EQ(0, std::memcmp(buf, f.stream.data() + off, sizeof(buf))) << off;
+    }
+    uint8_t one = 0;
+    EXPECT_FALSE(f.enc.read(f.geo.streamSize(), &one, 1));
+    EXPECT_TRUE(f.enc.read(f.geo.streamSize(), &one, 0));
+}
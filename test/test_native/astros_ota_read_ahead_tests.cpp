@@ -0,0 +1,228 @@
+#include <AstrOsOtaReadAhead.hpp>
+#include <gtest/gtest.h>
+
+#include "astros_test_helpers.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using AstrOsOtaReadAhead::ImageCache;
+using AstrOsOtaReadAhead::Status;
+
+namespace
+{
+    using AstrOsTestHelpers::Bytes;
+    using AstrOsTestHelpers::makeData;
+    using AstrOsTestHelpers::sha256;
+
+    // Stand-in for the SD file: counts calls and can fail on demand.
+    struct FakeFile
+    {
+        Bytes data;
+        uint32_t calls = 0;
+        uint32_t failAtCall = 0; // 1-based; 0 = never
+        std::vector<uint32_t> offsets = {};
+
+        static bool read(void *ctx, uint32_t offset, uint8_t *out, size_t len)
+        {
+            auto self = static_cast<FakeFile *>(ctx);
+            self->calls++;
+            self->offsets.push_back(offset);
+            if (self->calls == self->failAtCall || offset + len > self->data.size())
+            {
+                return false;
+            }
+            std::memcpy(out, self->data.data() + offset, len);
+            return true;
+        }
+    };
+
+    void appendBytes(void *ctx, const uint8_t *data, size_t len)
+    {
+        auto out = static_cast<Bytes *>(ctx);
+        out->insert(out->end(), data, data + len);
+    }
+} // namespace
+
+TEST(AstrOsOtaReadAhead, BeginRejectsBadParameters)
+{
+    Bytes storage(4096);
+    FakeFile file;
+    ImageCache cache;
+    EXPECT_FALSE(cache.begin(0, 1024, storage.data(), storage.size(), &FakeFile::read, &file));
+    EXPECT_FALSE(cache.begin(10000, 1000, storage.data(), storage.size(), &FakeFile::read, &file));
+    EXPECT_FALSE(cache.begin(10000, 8192, storage.data(), storage.size(), &FakeFile::read, &file));
+    EXPECT_FALSE(cache.begin(10000, 1024, nullptr, storage.size(), &FakeFile::read, &file));
+    EXPECT_FALSE(cache.active());
+    uint8_t buf[4];
+    EXPECT_EQ(cache.read(0, buf, sizeof(buf)).status, Status::NOT_STARTED);
+}
+
+TEST(AstrOsOtaReadAhead, ScanMatchesShaAndFeedsEveryByteInOrder)
+{
+    FakeFile file{makeData(10000, 1)};
+    Bytes storage(3 * 1024);
+    ImageCache cache;
+    ASSERT_TRUE(cache.begin(10000, 1024, storage.data(), storage.size(), &FakeFile::read, &file));
+    EXPECT_FALSE(cache.resident());
+
+    uint8_t sha[32], expected[32];
+    Bytes seen;
+    ASSERT_TRUE(cache.scan(sha, &appendBytes, &seen).ok);
+    sha256(file.data, expected);
+    EXPECT_EQ(0, std::memcmp(sha, expected, 32));
+    EXPECT_EQ(seen, file.data);
+    // One read per block, including the short last one.
+    EXPECT_EQ(file.calls, 10u);
+    EXPECT_EQ(cache.stats().bytesLoaded, 10000u);
+}
+
+TEST(AstrOsOtaReadAhead, WindowServesSequentialChunksWithOneReadPerBlock)
+{
+    FakeFile file{makeData(10000, 2)};
+    Bytes storage(3 * 1024);
+    ImageCache cache;
+    ASSERT_TRUE(cache.begin(10000, 1024, storage.data(), storage.size(), &FakeFile::read, &file));
+
+    Bytes out(10000);
+    for (uint32_t off = 0; off < 10000; off += 128)
+    {
+        const size_t len = std::min<size_t>(128, 10000 - off);
+        ASSERT_TRUE(cache.read(off, out.data() + off, len).ok) << off;
+    }
+    EXPECT_EQ(out, file.data);
+    EXPECT_EQ(file.calls, 10u);
+    EXPECT_EQ(cache.stats().loads, 10u);
+}
+
+TEST(AstrOsOtaReadAhead, RetransmitBehindBlockBoundaryIsAHit)
+{
+    FakeFile file{makeData(8192, 3)};
+    Bytes storage(3 * 1024);
+    ImageCache cache;
+    ASSERT_TRUE(cache.begin(8192, 1024, storage.data(), storage.size(), &FakeFile::read, &file));
+
+    uint8_t buf[128];
+    ASSERT_TRUE(cache.read(896, buf, 128).ok);  // last chunk of block 0
+    ASSERT_TRUE(cache.read(1024, buf, 128).ok); // first chunk of block 1
+    ASSERT_TRUE(cache.prefetchNext().ok);       // block 2
+    const uint32_t calls = file.calls;
+    ASSERT_TRUE(cache.read(896, buf, 128).ok); // retransmit in block 0
+    EXPECT_EQ(file.calls, calls);
+    EXPECT_EQ(0, std::memcmp(buf, file.data.data() + 896, 128));
+}
+
+TEST(AstrOsOtaReadAhead, PrefetchLoadsFollowingBlockOnce)
+{
+    FakeFile file{makeData(4096, 4)};
+    Bytes storage(2 * 1024);
+    ImageCache cache;
+    ASSERT_TRUE(cache.begin(4096, 1024, storage.data(), storage.size(), &FakeFile::read, &file));
+
+    uint8_t buf[128];
+    ASSERT_TRUE(cache.read(0, buf, 128).ok);
+    ASSERT_TRUE(cache.prefetchNext().ok);
+    ASSERT_TRUE(cache.prefetchNext().ok);
+    EXPECT_EQ(file.calls, 2u);
+    EXPECT_EQ(file.offsets.back(), 1024u);
+    ASSERT_TRUE(cache.read(1024, buf, 128).ok);
+    EXPECT_EQ(file.calls, 2u);
+    EXPECT_EQ(0, std::memcmp(buf, file.data.data() + 1024, 128));
+}
+
+TEST(AstrOsOtaReadAhead, PrefetchIsNoOpWithOneSlotOrPastTheEnd)
+{
+    FakeFile file{makeData(2048, 5)};
+    Bytes storage(1024);
+    ImageCache cache;
+    ASSERT_TRUE(cache.begin(2048, 1024, storage.data(), storage.size(), &FakeFile::read, &file));
+    uint8_t buf[16];
+    ASSERT_TRUE(cache.read(0, buf, sizeof(buf)).ok);
+    ASSERT_TRUE(cache.prefetchNext().ok);
+    EXPECT_EQ(file.calls, 1u);
+
+    Bytes two(2048);
+    ASSERT_TRUE(cache.begin(2048, 1024, two.data(), 1024 + 512 + 1024, &FakeFile::read, &file));
+    ASSERT_TRUE(cache.read(1024, buf, sizeof(buf)).ok);
+    const uint32_t calls = file.calls;
+    ASSERT_TRUE(cache.prefetchNext().ok);
+    EXPECT_EQ(file.calls, calls);
+}
+
+TEST(AstrOsOtaReadAhead, ReadSpanningBlocksAndRangeChecks)
+{
+    FakeFile file{makeData(3000, 6)};
+    Bytes storage(2 * 1024);
+    ImageCache cache;
+    ASSERT_TRUE(cache.begin(3000, 1024, storage.data(), storage.size(), &FakeFile::read, &file));
+
+    uint8_t buf[300];
+    ASSERT_TRUE(cache.read(900, buf, sizeof(buf)).ok);
+    EXPECT_EQ(0, std::memcmp(buf, file.data.data() + 900, sizeof(buf)));
+    ASSERT_TRUE(cache.read(2900, buf, 100).ok);
+    EXPECT_EQ(0, std::memcmp(buf, file.data.data() + 2900, 100));
+    EXPECT_EQ(cache.read(2901, buf, 100).status, Status::OUT_OF_RANGE);
+    EXPECT_EQ(cache.read(0xFFFFFFF0u, buf, 100).status, Status::OUT_OF_RANGE);
+}
+
+TEST(AstrOsOtaReadAhead, FailedLoadIsNotServedLater)
+{
+    FakeFile file{makeData(4096, 7)};
+    file.failAtCall = 1;
+    Bytes storage(2 * 1024);
+    ImageCache cache;
+    ASSERT_TRUE(cache.begin(4096, 1024, storage.data(), storage.size(), &FakeFile::read, &file));
+
+    uint8_t buf[64];
+    EXPECT_EQ(cache.read(0, buf, sizeof(buf)).status, Status::READ_FAILED);
+    ASSERT_TRUE(cache.read(0, buf, sizeof(buf)).ok);
+    EXPECT_EQ(file.calls, 2u);
+    EXPECT_EQ(0, std::memcmp(buf, file.data.data(), sizeof(buf)));
+}
+
+TEST(AstrOsOtaReadAhead, ResidentLoadsOnceAcrossScans)
+{
+    FakeFile file{makeData(5000, 8)};
+    Bytes storage(5000);
+    ImageCache cache;
+    ASSERT_TRUE(cache.begin(5000, 1024, storage.data(), storage.size(), &FakeFile::read, &file));
+    EXPECT_TRUE(cache.resident());
+
+    uint8_t sha[32], again[32], expected[32];
+    ASSERT_TRUE(cache.scan(sha, nullptr, nullptr).ok);
+    const uint32_t calls = file.calls;
+    EXPECT_EQ(calls, 5u);
+    Bytes seen;
+    ASSERT_TRUE(cache.scan(again, &appendBytes, &seen).ok);
+    sha256(file.data, expected);
+    EXPECT_EQ(0, std::memcmp(sha, expected, 32));
+    EXPECT_EQ(0, std::memcmp(again, expected, 32));
+    EXPECT_EQ(seen, file.data);
+
+    Bytes out(5000);
+    for (uint32_t off = 0; off < 5000; off += 128)
+    {
+        ASSERT_TRUE(cache.read(off, out.data() + off, std::min<size_t>(128, 5000 - off)).ok);
+    }
+    EXPECT_EQ(out, file.data);
+    EXPECT_EQ(file.calls, calls);
+}
+
+TEST(AstrOsOtaReadAhead, ResidentScanFailureLeavesCacheUnloaded)
+{
+    FakeFile file{makeData(3000, 9)};
+    file.failAtCall = 2;
+    Bytes storage(3000);
+    ImageCache cache;
+    ASSERT_TRUE(cache.begin(3000, 1024, storage.data(), storage.size(), &FakeFile::read, &file));
+
+    uint8_t sha[32];
+    EXPECT_EQ(cache.scan(sha, nullptr, nullptr).status, Status::READ_FAILED);
+    // Not loaded: reads go straight to the file.
+    uint8_t buf[32];
+    const uint32_t calls = file.calls;
+    ASSERT_TRUE(cache.read(2000, buf, sizeof(buf)).ok);
+    EXPECT_EQ(file.calls, calls + 1);
+    EXPECT_EQ(0, std::memcmp(buf, file.data.data() + 2000, sizeof(buf)));
+}
@@ -0,0 +1,112 @@
+#include <AstrOsPca9685Frame.hpp>
+#include <AstrOsServoUtils.hpp>
+#include <gtest/gtest.h>
+
+using AstrOsPca9685::Frame;
+using AstrOsPca9685::kFullOff;
+using AstrOsPca9685::ChannelRun;
+
+TEST(AstrOsPca9685, CompileTimeStepMapMatchesCalculateStepMap)
+{
+    uint16_t map[AstrOsPca9685::kServoSteps];
+    CalculateStepMap(50, map, AstrOsPca9685::kServoSteps);
+
+    for (int i = 0; i < AstrOsPca9685::kServoSteps; i++)
+    {
+        EXPECT_EQ(map[i], AstrOsPca9685::kStepMap[i]) << "step " << i;
+    }
+}
+
+TEST(AstrOsPca9685, PulseTicksUsesTheStepMap)
+{
+    EXPECT_EQ(102, AstrOsPca9685::pulseTicks(500));
+    EXPECT_EQ(AstrOsPca9685::kStepMap[126], AstrOsPca9685::pulseTicks(1200));
+    EXPECT_EQ(511, AstrOsPca9685::pulseTicks(2500));
+    // clamped
+    EXPECT_EQ(102, AstrOsPca9685::pulseTicks(0));
+    EXPECT_EQ(511, AstrOsPca9685::pulseTicks(3000));
+}
+
+TEST(AstrOsPca9685, OnlyChangesAreDirty)
+{
+    Frame f;
+    EXPECT_EQ(0, f.dirty());
+
+    // The reset state is full off: setting it again is no change.
+    f.set(2, kFullOff);
+    EXPECT_EQ(0, f.dirty());
+
+    f.set(2, 307);
+    EXPECT_EQ(1 << 2, f.dirty());
+
+    ChannelRun r;
+    ASSERT_TRUE(f.nextRun(r));
+    EXPECT_FALSE(f.nextRun(r));
+
+    f.set(2, 307);
+    EXPECT_EQ(0, f.dirty());
+    f.set(16, 307); // ignored
+    EXPECT_EQ(0, f.dirty());
+}
+
+TEST(AstrOsPca9685, ContiguousDirtyChannelsAreOneRun)
+{
+    Frame f;
+    f.set(3, 300);
+    f.set(4, 0x123);
+    f.set(5, kFullOff - 1);
+    f.set(9, 400);
+
+    ChannelRun r;
+    ASSERT_TRUE(f.nextRun(r));
+    EXPECT_EQ(3, r.first);
+    EXPECT_EQ(3, r.count);
+    EXPECT_EQ(0x06 + 12, r.reg());
+
+    uint8_t out[AstrOsPca9685::kChannels * AstrOsPca9685::kBytesPerChannel];
+    ASSERT_EQ(12u, f.encode(r, out));
+    const uint8_t expected[] = {0, 0, 0x2C, 0x01, 0, 0, 0x23, 0x01, 0, 0, 0xFF, 0x0F};
+    for (size_t i = 0; i < sizeof(expected); i++)
+    {
+        EXPECT_EQ(expected[i], out[i]) << "byte " << i;
+    }
+
+    ASSERT_TRUE(f.nextRun(r));
+    EXPECT_EQ(9, r.first);
+    EXPECT_EQ(1, r.count);
+    EXPECT_FALSE(f.nextRun(r));
+}
+
+TEST(AstrOsPca9685, FullFrameIsOneRun)
+{
+    Frame f;
+    for (uint8_t ch = 0; ch < AstrOsPca9685::kChannels; ch++)
+    {
+        f.set(ch, 307);
+    }
+
+    ChannelRun r;
+    ASSERT_TRUE(f.nextRun(r));
+    EXPECT_EQ(0, r.first);
+    EXPECT_EQ(16, r.count);
+    EXPECT_EQ(64u, r.bytes());
+    EXPECT_FALSE(f.nextRun(r));
+}
+
+TEST(AstrOsPca9685, AllOffAndInvalidate)
+{
+    Frame f;
+    f.set(0, 300);
+    f.set(15, 300);
+    f.allOff();
+    EXPECT_EQ(0, f.dirty());
+    EXPECT_EQ(kFullOff, f.get(15));
+
+    f.set(1, 300);
+    ChannelRun r;
+    f.nextRun(r);
+    f.invalidate();
+    ASSERT_TRUE(f.nextRun(r));
+    EXPECT_EQ(0, r.first);
+    EXPECT_EQ(16, r.count);
+}
@@ -0,0 +1,73 @@
+#include <AstrOsQueueMetrics.hpp>
+#include <gtest/gtest.h>
+
+using AstrOsQueueMetrics::ConsumerMetrics;
+using AstrOsQueueMetrics::Snapshot;
+
+TEST(AstrOsQueueMetrics, EmptyMetricsAverageToZero)
+{
+    ConsumerMetrics m;
+    Snapshot s = m.snapshot();
+    EXPECT_EQ(0u, s.messages);
+    EXPECT_EQ(0u, s.wakes);
+    EXPECT_EQ(0u, s.avgWaitUs());
+    EXPECT_EQ(0u, s.avgServiceUs());
+    EXPECT_EQ(0u, s.avgBatchX100());
+}
+
+TEST(AstrOsQueueMetrics, RecordsBatchDepthWaitAndService)
+{
+    ConsumerMetrics m;
+
+    // A burst of three handled in one wake: each waits behind the last,
+    // on top of its time in the queue.
+    m.onMessage(3, 100, 100);
+    m.onMessage(2, 250, 150);
+    m.onMessage(1, 300, 50);
+    m.onWake(3);
+    // Then a single message.
+    m.onMessage(1, 50, 50);
+    m.onWake(1);
+
+    Snapshot s = m.snapshot();
+    EXPECT_EQ(2u, s.wakes);
+    EXPECT_EQ(4u, s.messages);
+    EXPECT_EQ(3u, s.maxBatch);
+    EXPECT_EQ(3u, s.maxDepth);
+    EXPECT_EQ(700u, s.totalWaitUs);
+    EXPECT_EQ(300u, s.maxWaitUs);
+    EXPECT_EQ(175u, s.avgWaitUs());
+    EXPECT_EQ(350u, s.totalServiceUs);
+    EXPECT_EQ(150u, s.maxServiceUs);
+    EXPECT_EQ(200u, s.avgBatchX100());
+}
+
+TEST(AstrOsQueueMetrics, EmptyWakeIsNotCounted)
+{
+    ConsumerMetrics m;
+    m.onWake(0);
+    EXPECT_EQ(0u, m.snapshot().wakes);
+}
+
+TEST(AstrOsQueueMetrics, TakeResetsCounters)
+{
+    ConsumerMetrics m;
+    m.onMessage(4, 900, 800);
+    m.onWake(1);
+
+    Snapshot first = m.take();
+    EXPECT_EQ(1u, first.messages);
+    EXPECT_EQ(4u, first.maxDepth);
+    EXPECT_EQ(900u, first.maxWaitUs);
+
+    // The next interval starts from zero, maxima included.
+    m.onMessage(1, 10, 5);
+    m.onWake(1);
+    Snapshot second = m.take();
+    EXPECT_EQ(1u, second.messages);
+    EXPECT_EQ(1u, second.maxDepth);
+    EXPECT_EQ(10u, second.maxWaitUs);
+    EXPECT_EQ(5u, second.maxServiceUs);
+
+    EXPECT_EQ(0u, m.snapshot().messages);
+}
@@ -0,0 +1,446 @@
+#include <AstrOsScriptArchive.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using AstrOsScriptArchive::Archive;
+using AstrOsScriptArchive::Config;
+using AstrOsScriptArchive::FileOps;
+using AstrOsScriptArchive::Status;
+
+namespace
+{
+    using Bytes = std::vector<uint8_t>;
+
+    // Stand-in for the SD card: named files in memory, with failures on
+    // demand. A torn append writes only part of its bytes, like power loss.
+    struct FakeFs
+    {
+        std::map<std::string, Bytes> files;
+        uint32_t appends = 0;
+        uint32_t failAppendAt = 0; // 1-based; 0 = never
+        size_t tornBytes = 0;      // written by the failing append
+        bool failRename = false;
+        bool failWrite = false;
+
+        FileOps ops()
+        {
+            return FileOps{&size, &read, &append, &truncate, &write, &rename, &remove, this};
+        }
+
+        static FakeFs &self(void *ctx)
+        {
+            return *static_cast<FakeFs *>(ctx);
+        }
+        static bool size(void *ctx, const char *name, uint32_t &out)
+        {
+            auto it = self(ctx).files.find(name);
+            if (it == self(ctx).files.end())
+            {
+                return false;
+            }
+            out = static_cast<uint32_t>(it->second.size());
+            return true;
+        }
+        static bool read(void *ctx, const char *name, uint32_t offset, uint8_t *out, size_t len)
+        {
+            auto it = self(ctx).files.find(name);
+            if (it == self(ctx).files.end() || offset + len > it->second.size())
+            {
+                return false;
+            }
+            std::memcpy(out, it->second.data() + offset, len);
+            return true;
+        }
+        static bool append(void *ctx, const char *name, const uint8_t *data, size_t len)
+        {
+            FakeFs &fs = self(ctx);
+            Bytes &f = fs.files[name];
+            if (++fs.appends == fs.failAppendAt)
+            {
+                f.insert(f.end(), data, data + std::min(len, fs.tornBytes));
+                return false;
+            }
+            f.insert(f.end(), data, data + len);
+            return true;
+        }
+        static bool truncate(void *ctx, const char *name, uint32_t len)
+        {
+            auto it = self(ctx).files.find(name);
+            if (it == self(ctx).files.end() || len > it->second.size())
+            {
+                return false;
+            }
+            it->second.resize(len);
+            return true;
+        }
+        static bool write(void *ctx, const char *name, const uint8_t *data, size_t len)
+        {
+            if (self(ctx).failWrite)
+            {
+                return false;
+            }
+            self(ctx).files[name] = Bytes(data, data + len);
+            return true;
+        }
+        static bool rename(void *ctx, const char *from, const char *to)
+        {
+            FakeFs &fs = self(ctx);
+            auto it = fs.files.find(from);
+            if (fs.failRename || it == fs.files.end())
+            {
+                return false;
+            }
+            fs.files[to] = it->second;
+            fs.files.erase(from);
+            return true;
+        }
+        static bool remove(void *ctx, const char *name)
+        {
+            self(ctx).files.erase(name);
+            return true;
+        }
+    };
+
+    std::string script(const std::string &id, size_t len)
+    {
+        std::string s;
+        while (s.size() < len)
+        {
+            s += id + ";1000|4|0|1|90|0\n";
+        }
+        s.resize(len);
+        return s;
+    }
+
+    bool put(Archive &a, const std::string &id, const std::string &data)
+    {
+        return a.put(id, reinterpret_cast<const uint8_t *>(data.data()), data.size()).ok;
+    }
+
+    std::string get(const Archive &a, const std::string &id)
+    {
+        std::string out;
+        auto r = a.read(id, out);
+        return r.ok ? out : std::string("<") + AstrOsScriptArchive::statusName(r.status) + ">";
+    }
+
+    Config noAutoCompact()
+    {
+        Config c;
+        c.compactMinDeadBytes = UINT32_MAX;
+        return c;
+    }
+} // namespace
+
+TEST(AstrOsScriptArchive, PutReadListRoundTrip)
+{
+    FakeFs fs;
+    Archive a;
+    ASSERT_TRUE(a.open(fs.ops()).ok);
+    EXPECT_TRUE(a.stats().indexRebuilt);
+
+    ASSERT_TRUE(put(a, "b-script", script("b", 300)));
+    ASSERT_TRUE(put(a, "a-script", script("a", 5000)));
+    ASSERT_TRUE(put(a, "empty", ""));
+
+    EXPECT_EQ(get(a, "a-script"), script("a", 5000));
+    EXPECT_EQ(get(a, "b-script"), script("b", 300));
+    EXPECT_EQ(get(a, "empty"), "");
+    EXPECT_EQ(get(a, "missing"), "<not_found>");
+    EXPECT_TRUE(a.contains("a-script"));
+    EXPECT_FALSE(a.contains("missing"));
+    EXPECT_EQ(a.list(), (std::vector<std::string>{"a-script", "b-script", "empty"}));
+
+    // One data file and one index, however many scripts.
+    EXPECT_EQ(fs.files.size(), 2u);
+    EXPECT_EQ(a.stats().deadBytes, 0u);
+}
+
+TEST(AstrOsScriptArchive, ReplaceAndRemoveCountDeadSpace)
+{
+    FakeFs fs;
+    Archive a;
+    ASSERT_TRUE(a.open(fs.ops(), noAutoCompact()).ok);
+    ASSERT_TRUE(put(a, "s1", script("s1", 100)));
+    const uint32_t oneRecord = a.stats().dataBytes - AstrOsScriptArchive::kDataHeaderSize;
+
+    ASSERT_TRUE(put(a, "s1", script("x", 100)));
+    EXPECT_EQ(get(a, "s1"), script("x", 100));
+    EXPECT_EQ(a.stats().deadBytes, oneRecord);
+
+    ASSERT_TRUE(a.remove("s1").ok);
+    EXPECT_FALSE(a.contains("s1"));
+    EXPECT_EQ(a.stats().deadBytes, 2 * oneRecord + AstrOsScriptArchive::kRecordHeaderSize + 2);
+    EXPECT_EQ(a.remove("s1").status, Status::NOT_FOUND);
+}
+
+TEST(AstrOsScriptArchive, ReopenLoadsIndexWithoutReplay)
+{
+    FakeFs fs;
+    {
+        Archive a;
+        ASSERT_TRUE(a.open(fs.ops()).ok);
+        for (int i = 0; i < 40; i++)
+        {
+            ASSERT_TRUE(put(a, "script-" + std::to_string(i), script(std::to_string(i), 200 + i)));
+        }
+        ASSERT_TRUE(a.remove("script-7").ok);
+        a.close();
+    }
+    Archive b;
+    auto r = b.open(fs.ops());
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(r.bytes, 39u);
+    EXPECT_EQ(b.stats().replayedRecords, 0u);
+    EXPECT_FALSE(b.stats().indexRebuilt);
+    EXPECT_EQ(get(b, "script-23"), script("23", 223));
+    EXPECT_FALSE(b.contains("script-7"));
+}
+
+TEST(AstrOsScriptArchive, UnindexedAppendsAreReplayedAtOpen)
+{
+    FakeFs fs;
+    Config c = noAutoCompact();
+    c.indexEveryRecords = 1000;
+    {
+        Archive a;
+        ASSERT_TRUE(a.open(fs.ops(), c).ok);
+        ASSERT_TRUE(put(a, "keep", "one"));
+        ASSERT_TRUE(put(a, "gone", "two"));
+        ASSERT_TRUE(put(a, "keep", "three"));
+        ASSERT_TRUE(a.remove("gone").ok);
+        EXPECT_EQ(a.stats().unindexedRecords, 4u);
+        // No close(): power lost with the index still describing an empty archive.
+    }
+    Archive b;
+    ASSERT_TRUE(b.open(fs.ops(), c).ok);
+    EXPECT_EQ(b.stats().replayedRecords, 4u);
+    EXPECT_EQ(get(b, "keep"), "three");
+    EXPECT_FALSE(b.contains("gone"));
+    // The replay was folded back into the index.
+    EXPECT_EQ(b.stats().unindexedRecords, 0u);
+    Archive again;
+    ASSERT_TRUE(again.open(fs.ops(), c).ok);
+    EXPECT_EQ(again.stats().replayedRecords, 0u);
+    EXPECT_EQ(again.stats().deadBytes, b.stats().deadBytes);
+}
+
+TEST(AstrOsScriptArchive, TornTailRecordIsTruncatedAway)
+{
+    FakeFs fs;
+    Config c = noAutoCompact();
+    c.indexEveryRecords = 1000;
+    {
+        Archive a;
+        ASSERT_TRUE(a.open(fs.ops(), c).ok);
+        ASSERT_TRUE(put(a, "whole", script("w", 400)));
+    }
+    // Power lost halfway through the next record's payload.
+    const uint32_t before = static_cast<uint32_t>(fs.files[AstrOsScriptArchive::kDataFile].size());
+    {
+        Archive a;
+        ASSERT_TRUE(a.open(fs.ops(), c).ok);
+        fs.failAppendAt = fs.appends + 2;
+        fs.tornBytes = 100;
+        EXPECT_EQ(a.put("torn", reinterpret_cast<const uint8_t *>(script("t", 400).data()), 400).status,
+                  Status::IO_ERROR);
+        // The failed put rolled the file back itself...
+        EXPECT_EQ(fs.files[AstrOsScriptArchive::kDataFile].size(), before);
+    }
+    // ...and a tail torn with no chance to roll back is dropped at open.
+    Bytes &data = fs.files[AstrOsScriptArchive::kDataFile];
+    const Bytes garbage = {0x41, 0x53, 0x50, 0x52, 4, 0, 0, 0, 0xFF, 0, 0, 0, 't', 'o'};
+    data.insert(data.end(), garbage.begin(), garbage.end());
+
+    Archive b;
+    ASSERT_TRUE(b.open(fs.ops(), c).ok);
+    EXPECT_EQ(b.stats().droppedTailBytes, garbage.size());
+    EXPECT_EQ(fs.files[AstrOsScriptArchive::kDataFile].size(), before);
+    EXPECT_EQ(get(b, "whole"), script("w", 400));
+    EXPECT_FALSE(b.contains("torn"));
+
+    // Appends land after the good records, not after the garbage.
+    ASSERT_TRUE(put(b, "next", "ok"));
+    b.close();
+    Archive c2;
+    ASSERT_TRUE(c2.open(fs.ops(), c).ok);
+    EXPECT_EQ(get(c2, "next"), "ok");
+}
+
+TEST(AstrOsScriptArchive, BadOrMissingIndexIsRebuiltFromData)
+{
+    FakeFs fs;
+    {
+        Archive a;
+        ASSERT_TRUE(a.open(fs.ops()).ok);
+        ASSERT_TRUE(put(a, "a", "alpha"));
+        ASSERT_TRUE(put(a, "b", "beta"));
+        ASSERT_TRUE(a.remove("a").ok);
+        a.close();
+    }
+    const uint32_t dead = [&]
+    {
+        Archive probe;
+        EXPECT_TRUE(probe.open(fs.ops()).ok);
+        return probe.stats().deadBytes;
+    }();
+
+    fs.files[AstrOsScriptArchive::kIndexFile][10] ^= 0x40;
+    Archive b;
+    ASSERT_TRUE(b.open(fs.ops()).ok);
+    EXPECT_TRUE(b.stats().indexRebuilt);
+    EXPECT_EQ(b.stats().replayedRecords, 3u);
+    EXPECT_EQ(get(b, "b"), "beta");
+    EXPECT_FALSE(b.contains("a"));
+    EXPECT_EQ(b.stats().deadBytes, dead);
+    b.close();
+
+    fs.files.erase(AstrOsScriptArchive::kIndexFile);
+    Archive c;
+    ASSERT_TRUE(c.open(fs.ops()).ok);
+    EXPECT_TRUE(c.stats().indexRebuilt);
+    EXPECT_EQ(c.list(), std::vector<std::string>{"b"});
+}
+
+TEST(AstrOsScriptArchive, CompactionReclaimsDeadSpace)
+{
+    FakeFs fs;
+    Archive a;
+    ASSERT_TRUE(a.open(fs.ops(), noAutoCompact()).ok);
+    for (int round = 0; round < 5; round++)
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            ASSERT_TRUE(put(a, "s" + std::to_string(i), script(std::to_string(round * 10 + i), 500)));
+        }
+    }
+    ASSERT_TRUE(a.remove("s3").ok);
+    const auto before = a.stats();
+    ASSERT_GT(before.deadBytes, before.dataBytes / 2);
+
+    auto r = a.compact();
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(r.bytes, before.deadBytes);
+    EXPECT_EQ(a.stats().deadBytes, 0u);
+    EXPECT_EQ(a.stats().dataBytes, before.dataBytes - before.deadBytes);
+    EXPECT_EQ(fs.files.count(AstrOsScriptArchive::kDataTmp), 0u);
+    for (int i = 0; i < 10; i++)
+    {
+        const std::string id = "s" + std::to_string(i);
+        EXPECT_EQ(get(a, id), i == 3 ? "<not_found>" : script(std::to_string(40 + i), 500)) << id;
+    }
+
+    // The new generation reopens from its index.
+    a.close();
+    Archive b;
+    ASSERT_TRUE(b.open(fs.ops()).ok);
+    EXPECT_FALSE(b.stats().indexRebuilt);
+    EXPECT_EQ(get(b, "s9"), script("49", 500));
+}
+
+TEST(AstrOsScriptArchive, CompactsAutomaticallyPastThreshold)
+{
+    FakeFs fs;
+    Config c;
+    c.compactMinDeadBytes = 4096;
+    c.compactDeadPercent = 50;
+    Archive a;
+    ASSERT_TRUE(a.open(fs.ops(), c).ok);
+    for (int i = 0; i < 30; i++)
+    {
+        ASSERT_TRUE(put(a, "same", script(std::to_string(i), 1000)));
+        EXPECT_FALSE(a.shouldCompact());
+    }
+    EXPECT_GT(a.stats().compactions, 0u);
+    EXPECT_LT(a.stats().dataBytes, 4u * 1024 + 2 * 1100);
+    EXPECT_EQ(get(a, "same"), script("29", 1000));
+}
+
+TEST(AstrOsScriptArchive, CrashDuringCompactionKeepsAnArchive)
+{
+    FakeFs fs;
+    {
+        Archive a;
+        ASSERT_TRUE(a.open(fs.ops(), noAutoCompact()).ok);
+        ASSERT_TRUE(put(a, "x", "old"));
+        ASSERT_TRUE(put(a, "x", "new"));
+        ASSERT_TRUE(put(a, "y", "why"));
+        a.close();
+    }
+    const auto snapshot = fs.files;
+
+    // Copy finished, old data file removed, rename never happened.
+    {
+        Archive a;
+        ASSERT_TRUE(a.open(fs.ops(), noAutoCompact()).ok);
+        fs.failRename = true;
+        EXPECT_EQ(a.compact().status, Status::IO_ERROR);
+        EXPECT_FALSE(a.isOpen());
+        fs.failRename = false;
+        fs.files.erase(AstrOsScriptArchive::kDataFile);
+    }
+    {
+        Archive b;
+        ASSERT_TRUE(b.open(fs.ops()).ok);
+        EXPECT_EQ(get(b, "x"), "new");
+        EXPECT_EQ(get(b, "y"), "why");
+        EXPECT_EQ(b.stats().deadBytes, 0u); // the compacted copy was promoted
+        EXPECT_EQ(fs.files.count(AstrOsScriptArchive::kDataTmp), 0u);
+    }
+
+    // Copy half written: the old archive stands and the copy is discarded.
+    fs.files = snapshot;
+    fs.files[AstrOsScriptArchive::kDataTmp] = Bytes(20, 0xAB);
+    Archive c;
+    ASSERT_TRUE(c.open(fs.ops()).ok);
+    EXPECT_EQ(get(c, "x"), "new");
+    EXPECT_GT(c.stats().deadBytes, 0u);
+    EXPECT_EQ(fs.files.count(AstrOsScriptArchive::kDataTmp), 0u);
+}
+
+TEST(AstrOsScriptArchive, ReadChecksCrcAndBufferSize)
+{
+    FakeFs fs;
+    Archive a;
+    ASSERT_TRUE(a.open(fs.ops()).ok);
+    ASSERT_TRUE(put(a, "s", "0123456789"));
+
+    uint8_t small[4];
+    auto r = a.read("s", small, sizeof(small));
+    EXPECT_EQ(r.status, Status::TOO_LARGE);
+    EXPECT_EQ(r.bytes, 10u);
+
+    uint8_t buf[16];
+    r = a.read("s", buf, sizeof(buf));
+    ASSERT_TRUE(r.ok);
+    EXPECT_EQ(std::string(reinterpret_cast<char *>(buf), r.bytes), "0123456789");
+
+    fs.files[AstrOsScriptArchive::kDataFile].back() ^= 0x01;
+    std::string out = "untouched";
+    EXPECT_EQ(a.read("s", out).status, Status::CORRUPT);
+    EXPECT_EQ(out, "untouched");
+}
+
+TEST(AstrOsScriptArchive, RejectsBadIdsAndForeignFiles)
+{
+    FakeFs fs;
+    Archive a;
+    EXPECT_EQ(a.put("s", nullptr, 0).status, Status::NOT_OPEN);
+    ASSERT_TRUE(a.open(fs.ops()).ok);
+    EXPECT_EQ(a.put("", nullptr, 0).status, Status::INVALID_ID);
+    EXPECT_EQ(a.put("a/b", nullptr, 0).status, Status::INVALID_ID);
+    EXPECT_EQ(a.put(std::string(65, 'x'), nullptr, 0).status, Status::INVALID_ID);
+    EXPECT_TRUE(a.put(std::string(64, 'x'), nullptr, 0).ok);
+    a.close();
+
+    fs.files[AstrOsScriptArchive::kDataFile] = Bytes(64, 'Z');
+    Archive b;
+    EXPECT_EQ(b.open(fs.ops()).status, Status::CORRUPT);
+    EXPECT_FALSE(b.isOpen());
+    EXPECT_EQ(fs.files[AstrOsScriptArchive::kDataFile], Bytes(64, 'Z'));
+}
@@ -1,7 +1,10 @@
 #include <AstrOsSha256.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -30,6 +33,108 @@ namespace
         AstrOsSha256_final(&ctx, digest);
         return toHex(digest, sizeof(digest));
     }
+
+    // The byte-at-a-time Brad Conte implementation AstrOsSha256.c shipped
+    // with before it was restructured. Kept here as a differential oracle
+    // and as the benchmark baseline — not linked into firmware.
+    namespace reference
+    {
+        constexpr uint32_t kK[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+        };
+
+        uint32_t rotr(uint32_t x, int n)
+        {
+            return (x >> n) | (x << (32 - n));
+        }
+
+        void transform(AstrOsSha256Ctx *ctx, const uint8_t data[64])
+        {
+            uint32_t m[64];
+            for (int i = 0, j = 0; i < 16; ++i, j += 4)
+            {
+                m[i] = ((uint32_t)data[j] << 24) | ((uint32_t)data[j + 1] << 16) | ((uint32_t)data[j + 2] << 8) |
+                       ((uint32_t)data[j + 3]);
+            }
+            for (int i = 16; i < 64; ++i)
+            {
+                const uint32_t s0 = rotr(m[i - 15], 7) ^ rotr(m[i - 15], 18) ^ (m[i - 15] >> 3);
+                const uint32_t s1 = rotr(m[i - 2], 17) ^ rotr(m[i - 2], 19) ^ (m[i - 2] >> 10);
+                m[i] = s1 + m[i - 7] + s0 + m[i - 16];
+            }
+            uint32_t v[8];
+            std::memcpy(v, ctx->state, sizeof(v));
+            for (int i = 0; i < 64; ++i)
+            {
+                const uint32_t ep1 = rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25);
+                const uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+                const uint32_t t1 = v[7] + ep1 + ch + kK[i] + m[i];
+                const uint32_t ep0 = rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22);
+                const uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+                std::memmove(v + 1, v, 7 * sizeof(uint32_t));
+                v[4] += t1;
+                v[0] = t1 + ep0 + maj;
+            }
+            for (int i = 0; i < 8; ++i)
+            {
+                ctx->state[i] += v[i];
+            }
+        }
+
+        void update(AstrOsSha256Ctx *ctx, const uint8_t *data, size_t len)
+        {
+            for (size_t i = 0; i < len; ++i)
+            {
+                ctx->data[ctx->datalen++] = data[i];
+                if (ctx->datalen == 64)
+                {
+                    transform(ctx, ctx->data);
+                    ctx->bitlen += 512;
+                    ctx->datalen = 0;
+                }
+            }
+        }
+
+        void final(AstrOsSha256Ctx *ctx, uint8_t hash[ASTROS_SHA256_DIGEST_LEN])
+        {
+            uint32_t i = ctx->datalen;
+            ctx->data[i++] = 0x80;
+            if (ctx->datalen >= 56)
+            {
+                while (i < 64)
+                    ctx->data[i++] = 0x00;
+                transform(ctx, ctx->data);
+                i = 0;
+            }
+            while (i < 56)
+                ctx->data[i++] = 0x00;
+            ctx->bitlen += (uint64_t)ctx->datalen * 8;
+            for (i = 0; i < 8; ++i)
+                ctx->data[63 - i] = (uint8_t)(ctx->bitlen >> (8 * i));
+            transform(ctx, ctx->data);
+            for (i = 0; i < 32; ++i)
+                hash[i] = (uint8_t)(ctx->state[i / 4] >> (24 - (i % 4) * 8));
+        }
+    } // namespace reference
+
+    std::vector<uint8_t> patternBytes(size_t len)
+    {
+        std::vector<uint8_t> data(len);
+        uint32_t x = 0x12345678;
+        for (auto &b : data)
+        {
+            x = x * 1103515245u + 12345u;
+            b = static_cast<uint8_t>(x >> 24);
+        }
+        return data;
+    }
 } // namespace
 
 // NIST FIPS-180-2 / RFC 6234 known-answer vectors.
@@ -112,3 +217,83 @@ TEST(Sha256, ContextIsReusableAfterReinit)
     AstrOsSha256_final(&ctx, digest);
     EXPECT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", toHex(digest, sizeof(digest)));
 }
+
+TEST(Sha256, MatchesReferenceAcrossLengthsAndOffsets)
+{
+    // Every length through three blocks (all padding cases), fed from an
+    // unaligned address so the direct-from-input block path sees misaligned
+    // words on hosts where that matters.
+    const std::vector<uint8_t> data = patternBytes(200);
+    for (size_t offset = 0; offset < 4; ++offset)
+    {
+        for (size_t len = 0; len + offset <= data.size(); ++len)
+        {
+            AstrOsSha256Ctx ref;
+            AstrOsSha256_init(&ref);
+            reference::update(&ref, data.data() + offset, len);
+            uint8_t expected[ASTROS_SHA256_DIGEST_LEN];
+            reference::final(&ref, expected);
+
+            EXPECT_EQ(toHex(expected, sizeof(expected)), sha256Hex(data.data() + offset, len))
+                << "len=" << len << " offset=" << offset;
+        }
+    }
+}
+
+TEST(Sha256, ContextMidStreamMatchesReference)
+{
+    // OtaWriter persists the context mid-transfer (resume checkpoint), so
+    // the buffered-tail / bitlen layout must match what byte-wise feeding
+    // would have produced, not just the final digest.
+    const std::vector<uint8_t> data = patternBytes(1000);
+    AstrOsSha256Ctx ref;
+    AstrOsSha256Ctx opt;
+    AstrOsSha256_init(&ref);
+    AstrOsSha256_init(&opt);
+    reference::update(&ref, data.data(), 130);
+    AstrOsSha256_update(&opt, data.data(), 7);
+    AstrOsSha256_update(&opt, data.data() + 7, 123);
+    EXPECT_EQ(ref.datalen, opt.datalen);
+    EXPECT_EQ(ref.bitlen, opt.bitlen);
+    EXPECT_EQ(0, std::memcmp(ref.state, opt.state, sizeof(ref.state)));
+    EXPECT_EQ(0, std::memcmp(ref.data, opt.data, ref.datalen));
+}
+
+// Throughput against the reference. Disabled by default (timing, not
+// correctness); run with
+//   --gtest_also_run_disabled_tests --gtest_filter=Sha256.DISABLED_Throughput*
+TEST(Sha256, DISABLED_ThroughputVsReference)
+{
+    // 1.5 MB image fed in 128 B wire chunks (OtaWriter) and 4 KB flash
+    // reads (read-back verify, OtaForwarder::computeFileSha256).
+    const std::vector<uint8_t> image = patternBytes(1536 * 1024);
+    using Clock = std::chrono::steady_clock;
+
+    for (size_t chunk : {size_t(128), size_t(4096)})
+    {
+        uint8_t refDigest[ASTROS_SHA256_DIGEST_LEN];
+        uint8_t optDigest[ASTROS_SHA256_DIGEST_LEN];
+
+        auto t0 = Clock::now();
+        AstrOsSha256Ctx ref;
+        AstrOsSha256_init(&ref);
+        for (size_t off = 0; off < image.size(); off += chunk)
+            reference::update(&ref, image.data() + off, std::min(chunk, image.size() - off));
+        reference::final(&ref, refDigest);
+        const double refMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        t0 = Clock::now();
+        AstrOsSha256Ctx opt;
+        AstrOsSha256_init(&opt);
+        for (size_t off = 0; off < image.size(); off += chunk)
+            AstrOsSha256_update(&opt, image.data() + off, std::min(chunk, image.size() - off));
+        AstrOsSha256_final(&opt, optDigest);
+        const double optMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        EXPECT_EQ(0, std::memcmp(refDigest, optDigest, sizeof(refDigest)));
+        const double mb = image.size() / (1024.0 * 1024.0);
+        std::printf("[ SHA-256  ] chunk=%4zu  reference %7.2f ms (%6.1f MB/s)  "
+                    "optimised %7.2f ms (%6.1f MB/s)  x%.2f\n",
+                    chunk, refMs, mb / (refMs / 1000.0), optMs, mb / (optMs / 1000.0), refMs / optMs);
+    }
+}
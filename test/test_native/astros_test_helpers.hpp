@@ -0,0 +1,34 @@
+#pragma once
+
+#include <AstrOsSha256.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Shared by the OTA and transport tests.
+namespace AstrOsTestHelpers
+{
+    using Bytes = std::vector<uint8_t>;
+
+    // Deterministic pseudo-random bytes (an LCG) so failures reproduce.
+    inline Bytes makeData(size_t len, uint32_t seed)
+    {
+        Bytes out(len);
+        uint32_t x = seed;
+        for (auto &b : out)
+        {
+            x = x * 1664525u + 1013904223u;
+            b = static_cast<uint8_t>(x >> 24);
+        }
+        return out;
+    }
+
+    inline void sha256(const Bytes &data, uint8_t out[32])
+    {
+        AstrOsSha256Ctx ctx;
+        AstrOsSha256_init(&ctx);
+        AstrOsSha256_update(&ctx, data.data(), data.size());
+        AstrOsSha256_final(&ctx, out);
+    }
+} // namespace AstrOsTestHelpers
@@ -0,0 +1,159 @@
+#include <AstrOsWriteBehind.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using AstrOsWriteBehind::Config;
+using AstrOsWriteBehind::Job;
+using AstrOsWriteBehind::PushStatus;
+using AstrOsWriteBehind::Waiter;
+using AstrOsWriteBehind::WriteQueue;
+
+namespace
+{
+    struct Ack
+    {
+        std::string path;
+        std::string token;
+        bool ok;
+    };
+
+    void record(void *ctx, const std::string &path, const std::string &token, bool ok)
+    {
+        static_cast<std::vector<Ack> *>(ctx)->push_back({path, token, ok});
+    }
+
+    Waiter waiter(std::vector<Ack> &acks, const std::string &token)
+    {
+        return Waiter{&record, &acks, token};
+    }
+} // namespace
+
+TEST(AstrOsWriteBehind, WritesInArrivalOrderOneAtATime)
+{
+    WriteQueue q;
+    std::vector<Ack> acks;
+    EXPECT_EQ(PushStatus::QUEUED, q.push("scripts/a", "A", waiter(acks, "1")));
+    EXPECT_EQ(PushStatus::QUEUED, q.push("scripts/b", "B", waiter(acks, "2")));
+
+    const Job *job = q.take();
+    ASSERT_NE(nullptr, job);
+    EXPECT_EQ("scripts/a", job->path);
+    EXPECT_EQ("A", job->data);
+    EXPECT_EQ(nullptr, q.take()); // one in flight at a time
+
+    AstrOsWriteBehind::complete(q.finish(), "scripts/a", true);
+    ASSERT_EQ(1u, acks.size());
+    EXPECT_EQ("1", acks[0].token);
+    EXPECT_TRUE(acks[0].ok);
+
+    job = q.take();
+    ASSERT_NE(nullptr, job);
+    EXPECT_EQ("scripts/b", job->path);
+    q.finish();
+    EXPECT_TRUE(q.idle());
+    EXPECT_EQ(0u, q.bytes());
+}
+
+TEST(AstrOsWriteBehind, CoalescesPendingSavesAndAnswersEveryRequest)
+{
+    WriteQueue q;
+    std::vector<Ack> acks;
+    ASSERT_EQ(PushStatus::QUEUED, q.push("scripts/a", "old", waiter(acks, "1")));
+    EXPECT_EQ(PushStatus::COALESCED, q.push("scripts/a", "newer", waiter(acks, "2")));
+    EXPECT_EQ(1u, q.pendingCount());
+    EXPECT_EQ(5u, q.bytes());
+
+    const Job *job = q.take();
+    ASSERT_NE(nullptr, job);
+    EXPECT_EQ("newer", job->data);
+
+    // In flight: a further save queues behind it instead of changing it.
+    EXPECT_EQ(PushStatus::QUEUED, q.push("scripts/a", "newest", waiter(acks, "3")));
+    std::string seen;
+    ASSERT_TRUE(q.peek("scripts/a", seen));
+    EXPECT_EQ("newest", seen);
+
+    AstrOsWriteBehind::complete(q.finish(), "scripts/a", true);
+    ASSERT_EQ(2u, acks.size());
+    EXPECT_EQ("1", acks[0].token);
+    EXPECT_EQ("2", acks[1].token);
+    EXPECT_EQ(1u, q.pendingCount());
+    EXPECT_EQ(1u, q.stats().coalesced);
+}
+
+TEST(AstrOsWriteBehind, PeekSeesInFlightContentUntilFinished)
+{
+    WriteQueue q;
+    std::vector<Ack> acks;
+    ASSERT_EQ(PushStatus::QUEUED, q.push("scripts/a", "A", waiter(acks, "1")));
+    ASSERT_NE(nullptr, q.take());
+
+    std::string seen;
+    EXPECT_TRUE(q.contains("scripts/a"));
+    ASSERT_TRUE(q.peek("scripts/a", seen));
+    EXPECT_EQ("A", seen);
+
+    q.finish();
+    EXPECT_FALSE(q.contains("scripts/a"));
+    EXPECT_FALSE(q.peek("scripts/a", seen));
+}
+
+TEST(AstrOsWriteBehind, BoundedByEntriesAndBytes)
+{
+    Config config;
+    config.maxEntries = 2;
+    config.maxBytes = 10;
+    WriteQueue q(config);
+    std::vector<Ack> acks;
+
+    EXPECT_EQ(PushStatus::QUEUED, q.push("a", "1234", waiter(acks, "1")));
+    EXPECT_EQ(PushStatus::QUEUED, q.push("b", "1234", waiter(acks, "2")));
+    EXPECT_EQ(PushStatus::FULL, q.push("c", "1", waiter(acks, "3")));
+    // Coalescing needs no new entry, only the extra bytes.
+    EXPECT_EQ(PushStatus::COALESCED, q.push("a", "123456", waiter(acks, "4")));
+    EXPECT_EQ(PushStatus::FULL, q.push("a", "1234567", waiter(acks, "5")));
+    EXPECT_EQ(10u, q.bytes());
+    EXPECT_EQ(2u, q.stats().full);
+
+    // The in-flight entry's bytes still count until it is finished.
+    ASSERT_NE(nullptr, q.take());
+    EXPECT_EQ(PushStatus::FULL, q.push("c", "1", waiter(acks, "6")));
+    q.finish();
+    EXPECT_EQ(PushStatus::QUEUED, q.push("c", "1", waiter(acks, "7")));
+    EXPECT_TRUE(acks.empty());
+}
+
+TEST(AstrOsWriteBehind, CancelHandsBackWaitersOfSupersededSaves)
+{
+    WriteQueue q;
+    std::vector<Ack> acks;
+    ASSERT_EQ(PushStatus::QUEUED, q.push("a", "A", waiter(acks, "1")));
+    ASSERT_EQ(PushStatus::QUEUED, q.push("b", "B", waiter(acks, "2")));
+    ASSERT_EQ(PushStatus::QUEUED, q.push("c", "C", waiter(acks, "3")));
+    ASSERT_NE(nullptr, q.take()); // "a" in flight: cancel leaves it alone
+
+    EXPECT_TRUE(q.cancel("a").empty());
+    AstrOsWriteBehind::complete(q.cancel("b"), "b", false);
+    ASSERT_EQ(1u, acks.size());
+    EXPECT_EQ("2", acks[0].token);
+    EXPECT_FALSE(acks[0].ok);
+
+    std::vector<Job> dropped = q.cancelAll();
+    ASSERT_EQ(1u, dropped.size());
+    EXPECT_EQ("c", dropped[0].path);
+    ASSERT_EQ(1u, dropped[0].waiters.size());
+    EXPECT_TRUE(q.inFlight());
+    EXPECT_EQ(1u, q.bytes());
+    EXPECT_EQ(2u, q.stats().superseded);
+}
+
+TEST(AstrOsWriteBehind, WaitersWithoutCallbackAreSkipped)
+{
+    WriteQueue q;
+    ASSERT_EQ(PushStatus::QUEUED, q.push("a", "A", Waiter()));
+    ASSERT_NE(nullptr, q.take());
+    AstrOsWriteBehind::complete(q.finish(), "a", true);
+    EXPECT_TRUE(q.idle());
+}
@@ -1,8 +1,12 @@
 #include <AstrOsBulkTransport.hpp>
 #include <gtest/gtest.h>
 
+#include "astros_test_helpers.hpp"
+
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <vector>
 
@@ -13,6 +17,27 @@ namespace
     {
         return AstrOsBulkTransport::crc16_ccitt_false(reinterpret_cast<const uint8_t *>(s), std::strlen(s));
     }
+
+    // The bit-at-a-time loop crc16_ccitt_false used before it went
+    // table-driven: differential oracle and benchmark baseline.
+    uint16_t crc16Bitwise(const uint8_t *data, size_t len)
+    {
+        uint16_t crc = 0xFFFFu;
+        for (size_t i = 0; i < len; i++)
+        {
+            crc ^= static_cast<uint16_t>(data[i]) << 8;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 0x8000u) ? static_cast<uint16_t>((crc << 1) ^ 0x1021u) : static_cast<uint16_t>(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    std::vector<uint8_t> crcPattern(size_t len)
+    {
+        return AstrOsTestHelpers::makeData(len, 0xC0FFEEu);
+    }
 } // namespace
 
 //=================================================================================================
@@ -67,6 +92,72 @@ TEST(BulkTransport, Crc16MultiByteNonStringVector)
     EXPECT_EQ(0x4097u, AstrOsBulkTransport::crc16_ccitt_false(data, 4));
 }
 
+TEST(BulkTransport, Crc16MatchesBitwiseAcrossLengths)
+{
+    // Every length through several 8-byte slices, so each tail length
+    // (0..7) follows each number of sliced blocks.
+    const std::vector<uint8_t> data = crcPattern(300);
+    for (size_t len = 0; len <= data.size(); len++)
+    {
+        EXPECT_EQ(crc16Bitwise(data.data(), len), AstrOsBulkTransport::crc16_ccitt_false(data.data(), len))
+            << "len=" << len;
+    }
+}
+
+TEST(BulkTransport, Crc16IncrementalMatchesOneShot)
+{
+    // Scattered buffers: any split, including empty pieces, must equal the
+    // one-shot CRC of the concatenation.
+    const std::vector<uint8_t> data = crcPattern(257);
+    const uint16_t oneShot = AstrOsBulkTransport::crc16_ccitt_false(data.data(), data.size());
+    for (size_t split : {size_t(0), size_t(1), size_t(7), size_t(8), size_t(9), size_t(128), size_t(257)})
+    {
+        AstrOsBulkTransport::Crc16CcittFalse c;
+        c.update(data.data(), split);
+        c.update(data.data() + split, 0);
+        c.update(data.data() + split, data.size() - split);
+        EXPECT_EQ(oneShot, c.final()) << "split=" << split;
+        EXPECT_EQ(oneShot, AstrOsBulkTransport::crc16_ccitt_false_update(
+                               AstrOsBulkTransport::crc16_ccitt_false(data.data(), split), data.data() + split,
+                               data.size() - split));
+    }
+
+    AstrOsBulkTransport::Crc16CcittFalse c;
+    c.update(reinterpret_cast<const uint8_t *>("1234"), 4);
+    c.update(reinterpret_cast<const uint8_t *>("56789"), 5);
+    EXPECT_EQ(0x29B1u, c.final());
+    c.reset();
+    EXPECT_EQ(AstrOsBulkTransport::kCrc16Init, c.final());
+}
+
+// Throughput against the bitwise loop. Disabled by default (timing, not
+// correctness); run with
+//   --gtest_also_run_disabled_tests --gtest_filter=BulkTransport.DISABLED_Crc16Throughput*
+TEST(BulkTransport, DISABLED_Crc16ThroughputVsBitwise)
+{
+    using Clock = std::chrono::steady_clock;
+    // OTA_DATA payloads (128 B) and FW_CHUNK payloads (4 KB), 1.5 MB each.
+    const std::vector<uint8_t> data = crcPattern(1536 * 1024);
+    for (size_t chunk : {size_t(128), size_t(4096)})
+    {
+        uint32_t sinkBit = 0;
+        uint32_t sinkTable = 0;
+        auto t0 = Clock::now();
+        for (size_t off = 0; off < data.size(); off += chunk)
+            sinkBit += crc16Bitwise(data.data() + off, std::min(chunk, data.size() - off));
+        const double bitMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        t0 = Clock::now();
+        for (size_t off = 0; off < data.size(); off += chunk)
+            sinkTable += AstrOsBulkTransport::crc16_ccitt_false(data.data() + off, std::min(chunk, data.size() - off));
+        const double tableMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        EXPECT_EQ(sinkBit, sinkTable);
+        std::printf("[ CRC-16   ] chunk=%4zu  bitwise %7.2f ms  slicing-by-8 %7.2f ms  x%.1f\n", chunk, bitMs,
+                    tableMs, bitMs / tableMs);
+    }
+}
+
 //=================================================================================================
 // BulkReceiver::begin + reset + minimal onChunk happy path
 //=================================================================================================
@@ -90,6 +181,66 @@ TEST(BulkTransport, BeginThenSingleChunkInOrderAcks)
     EXPECT_EQ(sizeof(payload), result.payloadLen);
 }
 
+TEST(BulkTransport, BeginWithResumeSeqExpectsThatSeqNext)
+{
+    // Resume: seqs 0..1 were restored from a checkpoint. Seq 0 is now a
+    // duplicate (OUT_OF_ORDER), seq 2 is the next one accepted, and the
+    // final-chunk SIZE math still uses the real offset of seq 2.
+    AstrOsBulkTransport::BulkReceiver r;
+    ASSERT_TRUE(r.begin(/*xferId=*/9, /*totalSize=*/10, /*totalChunks=*/3, /*chunkSize=*/4, /*windowSize=*/16,
+                        /*resumeSeq=*/2)
+                    .valid);
+
+    const uint8_t early[] = {0x01, 0x02, 0x03, 0x04};
+    auto dup = r.onChunk(9, 0, 4, AstrOsBulkTransport::crc16_ccitt_false(early, 4), early);
+    EXPECT_EQ(AstrOsBulkTransport::Decision::NAK, dup.decision);
+    EXPECT_EQ(AstrOsBulkTransport::NakReason::OUT_OF_ORDER, dup.reason);
+    EXPECT_EQ(2u, dup.nextExpectedSeq);
+
+    const uint8_t tail[] = {0xAA, 0xBB};
+    auto ok = r.onChunk(9, 2, 2, AstrOsBulkTransport::crc16_ccitt_false(tail, 2), tail);
+    EXPECT_EQ(AstrOsBulkTransport::Decision::ACK, ok.decision);
+    EXPECT_EQ(2u, ok.highestContiguousSeq);
+    EXPECT_EQ(3u, ok.nextExpectedSeq);
+    EXPECT_EQ(AstrOsBulkTransport::EndResult::Status::OK, r.onEnd(9, 3).status);
+}
+
+TEST(BulkTransport, BeginWithResumeSeqAtTotalChunksLeavesReceiverInactive)
+{
+    // Nothing would be left to receive; the caller must restart from 0.
+    AstrOsBulkTransport::BulkReceiver r;
+    auto br = r.begin(/*xferId=*/9, /*totalSize=*/10, /*totalChunks=*/3, /*chunkSize=*/4, /*windowSize=*/16,
+                      /*resumeSeq=*/3);
+
+    EXPECT_FALSE(br.valid);
+    EXPECT_EQ(AstrOsBulkTransport::BeginResult::Reason::RESUME_OUT_OF_RANGE, br.reason);
+}
+
+TEST(BulkTransport, RewindReacceptsCommittedSeqs)
+{
+    // BLOCK_REJECTED path: seqs 0..2 committed, then the caller rejects the
+    // block they formed and rewinds to 1. Seq 1 is accepted again; seq 3
+    // is now a skip-forward.
+    AstrOsBulkTransport::BulkReceiver r;
+    ASSERT_TRUE(r.begin(/*xferId=*/9, /*totalSize=*/16, /*totalChunks=*/4, /*chunkSize=*/4, /*windowSize=*/16).valid);
+    const uint8_t p[] = {0x01, 0x02, 0x03, 0x04};
+    const uint16_t crc = AstrOsBulkTransport::crc16_ccitt_false(p, 4);
+    for (uint32_t seq = 0; seq < 3; seq++)
+    {
+        ASSERT_EQ(AstrOsBulkTransport::Decision::ACK, r.onChunk(9, seq, 4, crc, p).decision);
+    }
+
+    EXPECT_FALSE(r.rewind(4)); // past nextSeq
+    ASSERT_TRUE(r.rewind(1));
+    EXPECT_EQ(AstrOsBulkTransport::Decision::NAK, r.onChunk(9, 3, 4, crc, p).decision);
+    auto again = r.onChunk(9, 1, 4, crc, p);
+    EXPECT_EQ(AstrOsBulkTransport::Decision::ACK, again.decision);
+    EXPECT_EQ(2u, again.nextExpectedSeq);
+
+    r.reset();
+    EXPECT_FALSE(r.rewind(0)); // inactive
+}
+
 TEST(BulkTransport, OnChunkBeforeBeginNaksOutOfOrder)
 {
     AstrOsBulkTransport::BulkReceiver r;
@@ -851,6 +1002,43 @@ namespace
     }
 } // namespace
 
+TEST(BulkTransport, BulkSenderOnBeginAckWithResumeSeqSkipsRestoredChunks)
+{
+    AstrOsBulkTransport::BulkSender s;
+    ASSERT_TRUE(s.begin(7, /*totalChunks=*/100, 128, /*windowSize=*/4, 400, 3).valid);
+    ASSERT_EQ(AstrOsBulkTransport::BeginAckResult::Decision::OK, s.onBeginAck(7, /*resumeSeq=*/40).decision);
+
+    auto first = s.nextChunkToSend(/*nowMs=*/1000);
+    ASSERT_EQ(AstrOsBulkTransport::SendResult::Decision::SEND, first.decision);
+    EXPECT_EQ(40u, first.seq);
+}
+
+TEST(BulkTransport, BulkSenderOnBeginAckWithResumeSeqTreatsPrefixAsConfirmed)
+{
+    // The restored prefix behaves like a cumulative ACK through seq 39: a
+    // late ACK inside it is STALE, and a NAK may not rewind into it past
+    // what the sender has launched.
+    AstrOsBulkTransport::BulkSender s;
+    ASSERT_TRUE(s.begin(7, /*totalChunks=*/100, 128, /*windowSize=*/4, 400, 3).valid);
+    ASSERT_EQ(AstrOsBulkTransport::BeginAckResult::Decision::OK, s.onBeginAck(7, /*resumeSeq=*/40).decision);
+    std::vector<uint32_t> sent;
+    ASSERT_EQ(AstrOsBulkTransport::SendResult::Decision::WINDOW_FULL, drainSends(s, 1000, sent));
+
+    EXPECT_EQ(AstrOsBulkTransport::AckResult::Decision::STALE, s.onDataAck(7, 39).decision);
+    auto ack = s.onDataAck(7, 41);
+    ASSERT_EQ(AstrOsBulkTransport::AckResult::Decision::OK, ack.decision);
+    EXPECT_EQ(2u, ack.newlyConfirmedCount);
+}
+
+TEST(BulkTransport, BulkSenderOnBeginAckRejectsResumeSeqPastEnd)
+{
+    AstrOsBulkTransport::BulkSender s;
+    ASSERT_TRUE(s.begin(7, /*totalChunks=*/10, 128, 4, 400, 3).valid);
+    auto r = s.onBeginAck(7, /*resumeSeq=*/10);
+    EXPECT_EQ(AstrOsBulkTransport::BeginAckResult::Decision::RESUME_OUT_OF_RANGE, r.decision);
+    EXPECT_EQ(AstrOsBulkTransport::BulkSender::Status::AWAITING_BEGIN_ACK, s.status());
+}
+
 TEST(BulkTransport, BulkSenderNextChunkRejectedBeforeStreaming)
 {
     AstrOsBulkTransport::BulkSender s;
@@ -1037,6 +1225,50 @@ TEST(BulkTransport, BulkSenderOnDataNakWithZeroNextExpectedDoesNotAdvanceConfirm
     EXPECT_EQ(AstrOsBulkTransport::AckResult::Decision::OK, ackR.decision);
 }
 
+TEST(BulkTransport, BulkSenderAckOvertakenByNakMovesCursorPastIt)
+{
+    // Reordered reply path: the NAK for seq 1 rewinds the cursor, then the
+    // ACK the receiver sent later (covering the whole 4-chunk transfer)
+    // arrives. The sender must not resend 1..3, and onEndAck must not see
+    // a cursor left behind the confirmed range (found by the link
+    // simulator as premature_end_ack under reordering).
+    AstrOsBulkTransport::BulkSender s;
+    ASSERT_TRUE(s.begin(7, 4, 128, 4, 400, 3).valid);
+    ASSERT_EQ(AstrOsBulkTransport::BeginAckResult::Decision::OK, s.onBeginAck(7).decision);
+
+    std::vector<uint32_t> sent;
+    drainSends(s, 1000, sent);
+    ASSERT_EQ(4u, sent.size());
+
+    ASSERT_EQ(AstrOsBulkTransport::NakResult::Decision::OK,
+              s.onDataNak(7, /*nextExpectedSeq=*/1, AstrOsBulkTransport::NakReason::CRC).decision);
+    ASSERT_EQ(AstrOsBulkTransport::AckResult::Decision::OK, s.onDataAck(7, 3).decision);
+
+    EXPECT_EQ(AstrOsBulkTransport::SendResult::Decision::ALL_SENT, s.nextChunkToSend(1100).decision);
+    EXPECT_EQ(AstrOsBulkTransport::EndAckResult::Decision::DONE_OK, s.onEndAck(7, OtaEndStatus::OK).decision);
+}
+
+TEST(BulkTransport, BulkSenderBlockRejectedNakLowersConfirmedWatermark)
+{
+    // Seqs 0..5 ACKed, then the receiver rejects the block spanning 2..5.
+    // The resent seqs' ACKs are progress again, not STALE.
+    AstrOsBulkTransport::BulkSender s;
+    ASSERT_TRUE(s.begin(7, 100, 128, 8, 400, 3).valid);
+    ASSERT_EQ(AstrOsBulkTransport::BeginAckResult::Decision::OK, s.onBeginAck(7).decision);
+
+    std::vector<uint32_t> sent;
+    drainSends(s, 1000, sent);
+    ASSERT_EQ(AstrOsBulkTransport::AckResult::Decision::OK, s.onDataAck(7, 5).decision);
+
+    auto r = s.onDataNak(7, /*nextExpectedSeq=*/2, AstrOsBulkTransport::NakReason::BLOCK_REJECTED);
+    ASSERT_EQ(AstrOsBulkTransport::NakResult::Decision::OK, r.decision);
+    EXPECT_EQ(2u, s.nextChunkToSend(1100).seq);
+
+    auto ackR = s.onDataAck(7, 3);
+    EXPECT_EQ(AstrOsBulkTransport::AckResult::Decision::OK, ackR.decision);
+    EXPECT_EQ(2u, ackR.newlyConfirmedCount);
+}
+
 TEST(BulkTransport, BulkSenderTickReturnsNothingWhenNoTimeoutsFired)
 {
     AstrOsBulkTransport::BulkSender s;